@@ -37,7 +37,11 @@ void board_init(void)
 #ifdef MODULE_MTD
 static mtd_native_dev_t mtd0_dev = {
     .dev = {
+#ifdef MODULE_MTD_NATIVE_MMAP
+        .driver = &native_flash_mmap_driver,
+#else
         .driver = &native_flash_driver,
+#endif
         .sector_count = MTD_SECTOR_NUM,
         .pages_per_sector = MTD_SECTOR_SIZE / MTD_PAGE_SIZE,
         .page_size = MTD_PAGE_SIZE,
@@ -12,6 +12,17 @@
  * @{
  * @brief       mtd flash emulation for native
  *
+ * Two drivers are available, both emulate NOR flash semantics (programming
+ * can only clear bits, erasing sets a whole sector to 0xff) on an image file
+ * on the host:
+ *
+ * - @ref native_flash_driver opens the image file for every access.
+ * - @ref native_flash_mmap_driver maps the image into memory once on
+ *   initialization and keeps it mapped for the lifetime of the process. It
+ *   can optionally simulate program and erase times and count erase cycles
+ *   per sector. Select it for the board's MTD device with
+ *   `USEMODULE += mtd_native_mmap`.
+ *
  * @file
  *
  * @author      Vincent Dupont <vincent@otakeys.com>
@@ -30,6 +41,20 @@ extern "C" {
 typedef struct mtd_native_dev {
     mtd_dev_t dev;      /**< mtd generic device */
     const char *fname;  /**< filename to use for memory emulation */
+    uint8_t *mem;       /**< mapped image, only used by
+                         *   @ref native_flash_mmap_driver */
+    uint32_t page_program_us;   /**< simulated time to program a page in us,
+                                 *   only used by @ref native_flash_mmap_driver */
+    uint32_t sector_erase_us;   /**< simulated time to erase a sector in us,
+                                 *   only used by @ref native_flash_mmap_driver */
+    uint32_t *erase_count;  /**< erase cycles per sector, array of
+                             *   mtd_dev_t::sector_count elements. May be
+                             *   NULL. Only used by
+                             *   @ref native_flash_mmap_driver */
+    uint32_t busy_until;    /**< end of the simulated program or erase
+                             *   started by mtd_desc_t::write_start or
+                             *   mtd_desc_t::erase_sector_start, only used by
+                             *   @ref native_flash_mmap_driver */
 } mtd_native_dev_t;
 
 /**
@@ -37,6 +62,13 @@ typedef struct mtd_native_dev {
  */
 extern const mtd_desc_t native_flash_driver;
 
+/**
+ * @brief Native mtd flash driver keeping the image memory mapped
+ *
+ * @note  Simulating program and erase times requires the `xtimer` module.
+ */
+extern const mtd_desc_t native_flash_mmap_driver;
+
 #ifdef __cplusplus
 }
 #endif
@@ -133,6 +133,8 @@ extern int (*real_fclose)(FILE *stream);
 extern int (*real_fseek)(FILE *stream, long offset, int whence);
 extern int (*real_fputc)(int c, FILE *stream);
 extern int (*real_fgetc)(FILE *stream);
+extern off_t (*real_lseek)(int fd, off_t offset, int whence);
+extern int (*real_ftruncate)(int fd, off_t length);
 extern mode_t (*real_umask)(mode_t cmask);
 extern ssize_t (*real_writev)(int fildes, const struct iovec *iov, int iovcnt);
 
@@ -0,0 +1,246 @@
+/*
+ * Copyright (C) 2020 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @{
+ * @brief       memory mapped mtd flash emulation for native
+ *
+ * @file
+ */
+
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#include "mtd.h"
+#include "mtd_native.h"
+#ifdef MODULE_XTIMER
+#include "xtimer.h"
+#endif
+
+#include "native_internal.h"
+
+#define ENABLE_DEBUG (0)
+#include "debug.h"
+
+static inline size_t _mtd_size(const mtd_dev_t *dev)
+{
+    return (size_t)dev->sector_count * dev->pages_per_sector * dev->page_size;
+}
+
+static void _delay(uint32_t us)
+{
+#ifdef MODULE_XTIMER
+    if (us > 0) {
+        xtimer_usleep(us);
+    }
+#else
+    (void)us;
+#endif
+}
+
+static int _init(mtd_dev_t *dev)
+{
+    mtd_native_dev_t *_dev = (mtd_native_dev_t *)dev;
+    size_t size = _mtd_size(dev);
+    off_t len;
+    int fd;
+
+    if (_dev->mem != NULL) {
+        /* image stays mapped once it was mapped */
+        return 0;
+    }
+    DEBUG("mtd_native_mmap: init, filename=%s\n", _dev->fname);
+    fd = real_open(_dev->fname, O_RDWR | O_CREAT, 0644);
+    if (fd < 0) {
+        return -EIO;
+    }
+    len = real_lseek(fd, 0, SEEK_END);
+    if ((len < 0) ||
+        (((size_t)len < size) && (real_ftruncate(fd, size) < 0))) {
+        real_close(fd);
+        return -EIO;
+    }
+    _dev->mem = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    /* the mapping stays valid without the file descriptor */
+    real_close(fd);
+    if (_dev->mem == MAP_FAILED) {
+        _dev->mem = NULL;
+        return -EIO;
+    }
+    if ((size_t)len < size) {
+        DEBUG("mtd_native_mmap: init: erasing %" PRIu32 " new bytes\n",
+              (uint32_t)(size - len));
+        memset(&_dev->mem[len], 0xff, size - len);
+    }
+    return 0;
+}
+
+static int _read(mtd_dev_t *dev, void *buff, uint32_t addr, uint32_t size)
+{
+    mtd_native_dev_t *_dev = (mtd_native_dev_t *)dev;
+
+    DEBUG("mtd_native_mmap: read from 0x%" PRIx32 " count %" PRIu32 "\n",
+          addr, size);
+
+    if (_dev->mem == NULL) {
+        return -EIO;
+    }
+    if (((size_t)addr + size) > _mtd_size(dev)) {
+        return -EOVERFLOW;
+    }
+    memcpy(buff, &_dev->mem[addr], size);
+    return 0;
+}
+
+/* NOR flash can only clear bits: AND the data into the image, word-wise where
+ * the image is word-aligned */
+static void _program(uint8_t *dst, const uint8_t *src, size_t size)
+{
+    while ((size > 0) && (((uintptr_t)dst % sizeof(uintptr_t)) != 0)) {
+        *(dst++) &= *(src++);
+        size--;
+    }
+    for (; size >= sizeof(uintptr_t); size -= sizeof(uintptr_t)) {
+        uintptr_t word;
+
+        /* src may be unaligned */
+        memcpy(&word, src, sizeof(word));
+        *((uintptr_t *)dst) &= word;
+        dst += sizeof(word);
+        src += sizeof(word);
+    }
+    while (size--) {
+        *(dst++) &= *(src++);
+    }
+}
+
+static int _write(mtd_dev_t *dev, const void *buff, uint32_t addr,
+                  uint32_t size)
+{
+    mtd_native_dev_t *_dev = (mtd_native_dev_t *)dev;
+
+    DEBUG("mtd_native_mmap: write from 0x%" PRIx32 " count %" PRIu32 "\n",
+          addr, size);
+
+    if (_dev->mem == NULL) {
+        return -EIO;
+    }
+    if (((size_t)addr + size) > _mtd_size(dev)) {
+        return -EOVERFLOW;
+    }
+    if (((addr % dev->page_size) + size) > dev->page_size) {
+        return -EOVERFLOW;
+    }
+    _program(&_dev->mem[addr], buff, size);
+    _delay(_dev->page_program_us);
+    return 0;
+}
+
+static int _erase(mtd_dev_t *dev, uint32_t addr, uint32_t size)
+{
+    mtd_native_dev_t *_dev = (mtd_native_dev_t *)dev;
+    uint32_t sector_size = dev->pages_per_sector * dev->page_size;
+
+    DEBUG("mtd_native_mmap: erase from 0x%" PRIx32 " count %" PRIu32 "\n",
+          addr, size);
+
+    if (_dev->mem == NULL) {
+        return -EIO;
+    }
+    if (((size_t)addr + size) > _mtd_size(dev)) {
+        return -EOVERFLOW;
+    }
+    if (((addr % sector_size) != 0) || ((size % sector_size) != 0)) {
+        return -EOVERFLOW;
+    }
+    memset(&_dev->mem[addr], 0xff, size);
+    if (_dev->erase_count != NULL) {
+        for (uint32_t i = 0; i < (size / sector_size); i++) {
+            _dev->erase_count[(addr / sector_size) + i]++;
+        }
+    }
+    _delay((size / sector_size) * _dev->sector_erase_us);
+    return 0;
+}
+
+/* the split phase operations take effect immediately, only the device stays
+ * busy for the simulated time, so it can be read meanwhile */
+static int _start(mtd_native_dev_t *dev, uint32_t us)
+{
+#ifdef MODULE_XTIMER
+    dev->busy_until = xtimer_now_usec() + us;
+    return us;
+#else
+    (void)dev;
+    (void)us;
+    return 0;
+#endif
+}
+
+static int _write_start(mtd_dev_t *dev, const void *buff, uint32_t addr,
+                        uint32_t size)
+{
+    mtd_native_dev_t *_dev = (mtd_native_dev_t *)dev;
+    uint32_t us = _dev->page_program_us;
+    int res;
+
+    _dev->page_program_us = 0;
+    res = _write(dev, buff, addr, size);
+    _dev->page_program_us = us;
+    return (res < 0) ? res : _start(_dev, us);
+}
+
+static int _erase_sector_start(mtd_dev_t *dev, uint32_t addr)
+{
+    mtd_native_dev_t *_dev = (mtd_native_dev_t *)dev;
+    uint32_t us = _dev->sector_erase_us;
+    int res;
+
+    _dev->sector_erase_us = 0;
+    res = _erase(dev, addr, dev->pages_per_sector * dev->page_size);
+    _dev->sector_erase_us = us;
+    return (res < 0) ? res : _start(_dev, us);
+}
+
+static int _busy(mtd_dev_t *dev)
+{
+#ifdef MODULE_XTIMER
+    mtd_native_dev_t *_dev = (mtd_native_dev_t *)dev;
+
+    return (int32_t)(_dev->busy_until - xtimer_now_usec()) > 0;
+#else
+    (void)dev;
+    return 0;
+#endif
+}
+
+static int _power(mtd_dev_t *dev, enum mtd_power_state power)
+{
+    (void)dev;
+    (void)power;
+
+    return -ENOTSUP;
+}
+
+const mtd_desc_t native_flash_mmap_driver = {
+    .read = _read,
+    .power = _power,
+    .write = _write,
+    .erase = _erase,
+    .init = _init,
+    .write_start = _write_start,
+    .erase_sector_start = _erase_sector_start,
+    .busy = _busy,
+    .flags = MTD_DRIVER_FLAG_READ_WHILE_BUSY,
+};
+
+/** @} */
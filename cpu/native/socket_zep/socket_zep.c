@@ -115,7 +115,7 @@ static int _send(netdev_t *netdev, const iolist_t *iolist)
         netdev_trigger_event_isr(netdev);
         thread_yield();
     }
-    res = writev(dev->sock_fd, v, n + 2);
+    res = _native_writev(dev->sock_fd, v, n + 2);
     if (res < 0) {
         DEBUG("socket_zep::send: error writing packet: %s\n", strerror(errno));
         return res;
@@ -0,0 +1,217 @@
+#!/usr/bin/env python3
+
+# Copyright (C) 2020 Freie Universität Berlin
+#
+# This file is subject to the terms and conditions of the GNU Lesser
+# General Public License v2.1. See the file LICENSE in the top level
+# directory for more details.
+
+"""Pack a directory into a compressed read-only image for the hsfs file system
+
+The image is big endian and consists of
+
+- a 16 byte header: magic "HSFS", version, heatshrink window and lookahead
+  bits, log2 of the block size, number of files, reserved, image size
+- the file index, one 16 byte entry (path hash, path offset, size, block table
+  offset) per file, sorted by hash and path
+- the zero terminated paths
+- per file a table of (number of blocks + 1) block offsets
+- the blocks, each compressed on its own with heatshrink. Blocks that do not
+  shrink are stored as they are, which is recognized by their length.
+"""
+
+import argparse
+import pathlib
+import struct
+import sys
+
+MAGIC = b"HSFS"
+VERSION = 1
+HEADER_FMT = ">4sBBBBHHI"
+ENTRY_FMT = ">IIII"
+
+
+def fnv1a(data):
+    """32 bit FNV-1a hash, as used by sys/fs/hsfs"""
+    h = 2166136261
+    for b in data:
+        h = ((h ^ b) * 16777619) & 0xffffffff
+    return h
+
+
+class BitWriter:
+    def __init__(self):
+        self.out = bytearray()
+        self.cur = 0
+        self.nbits = 0
+
+    def put(self, value, count):
+        for i in reversed(range(count)):
+            self.cur = (self.cur << 1) | ((value >> i) & 1)
+            self.nbits += 1
+            if self.nbits == 8:
+                self.out.append(self.cur)
+                self.cur = 0
+                self.nbits = 0
+
+    def finish(self):
+        if self.nbits:
+            self.out.append(self.cur << (8 - self.nbits))
+        return bytes(self.out)
+
+
+def heatshrink_compress(data, window_bits, lookahead_bits):
+    """Compress data into the heatshrink bit stream format
+
+    A set tag bit is followed by a literal byte, a cleared one by the
+    distance - 1 (window_bits) and the length - 1 (lookahead_bits) of a
+    back reference. The stream is padded with zero bits.
+    """
+    window = 1 << window_bits
+    max_len = 1 << lookahead_bits
+    # a back reference only pays off if it is shorter than the literals
+    min_len = (1 + window_bits + lookahead_bits) // 9 + 1
+    chains = {}
+    bits = BitWriter()
+    pos = 0
+
+    def insert(i):
+        if i + 1 < len(data):
+            chains.setdefault(data[i:i + 2], []).append(i)
+
+    while pos < len(data):
+        best_len = 0
+        best_dist = 0
+        for cand in reversed(chains.get(data[pos:pos + 2], [])):
+            dist = pos - cand
+            if dist > window:
+                break
+            n = 0
+            while (n < max_len and pos + n < len(data) and
+                   data[cand + n] == data[pos + n]):
+                n += 1
+            if n > best_len:
+                best_len = n
+                best_dist = dist
+                if n == max_len:
+                    break
+        if best_len >= min_len:
+            bits.put(0, 1)
+            bits.put(best_dist - 1, window_bits)
+            bits.put(best_len - 1, lookahead_bits)
+            for i in range(pos, pos + best_len):
+                insert(i)
+            pos += best_len
+        else:
+            bits.put(1, 1)
+            bits.put(data[pos], 8)
+            insert(pos)
+            pos += 1
+    return bits.finish()
+
+
+def collect(root):
+    files = []
+    for path in sorted(pathlib.Path(root).rglob("*")):
+        if path.is_file():
+            name = "/" + path.relative_to(root).as_posix()
+            files.append((name.encode("utf-8"), path.read_bytes()))
+    return files
+
+
+def mkhsfs(files, block_shift, window_bits, lookahead_bits):
+    block_size = 1 << block_shift
+    files = sorted(files, key=lambda f: (fnv1a(f[0]), f[0]))
+
+    index_off = struct.calcsize(HEADER_FMT)
+    names_off = index_off + len(files) * struct.calcsize(ENTRY_FMT)
+    names = bytearray()
+    name_offs = []
+    for name, _ in files:
+        name_offs.append(names_off + len(names))
+        names += name + b"\0"
+    tables_off = (names_off + len(names) + 3) & ~3
+
+    nblocks = [(len(data) + block_size - 1) // block_size for _, data in files]
+    data_off = tables_off + sum(4 * (n + 1) for n in nblocks)
+
+    tables = bytearray()
+    blocks = bytearray()
+    entries = bytearray()
+    stats = []
+    for (name, data), name_off, n in zip(files, name_offs, nblocks):
+        table_off = tables_off + len(tables)
+        packed = 0
+        for i in range(n):
+            raw = data[i * block_size:(i + 1) * block_size]
+            block = heatshrink_compress(raw, window_bits, lookahead_bits)
+            if len(block) >= len(raw):
+                block = raw
+            tables += struct.pack(">I", data_off + len(blocks))
+            blocks += block
+            packed += len(block)
+        tables += struct.pack(">I", data_off + len(blocks))
+        entries += struct.pack(ENTRY_FMT, fnv1a(name), name_off, len(data),
+                               table_off)
+        stats.append((name.decode("utf-8"), len(data), packed))
+
+    size = data_off + len(blocks)
+    header = struct.pack(HEADER_FMT, MAGIC, VERSION, window_bits,
+                         lookahead_bits, block_shift, len(files), 0, size)
+    padding = bytes(tables_off - names_off - len(names))
+    image = header + entries + names + padding + tables + blocks
+    assert len(image) == size
+    return image, stats
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description="Pack a directory into an hsfs image")
+    parser.add_argument("root", type=pathlib.Path,
+                        help="directory to pack, it becomes the root of the "
+                             "file system")
+    parser.add_argument("-o", "--output", required=True,
+                        help="image file to write")
+    parser.add_argument("-b", "--block-size", type=int, default=1024,
+                        help="uncompressed size of a block, a power of two, "
+                             "at most CONFIG_HSFS_BLOCK_SIZE_MAX "
+                             "(default: %(default)s)")
+    parser.add_argument("-w", "--window-bits", type=int, default=8,
+                        help="heatshrink window size, must match "
+                             "HEATSHRINK_STATIC_WINDOW_BITS "
+                             "(default: %(default)s)")
+    parser.add_argument("-l", "--lookahead-bits", type=int, default=4,
+                        help="heatshrink lookahead size, must match "
+                             "HEATSHRINK_STATIC_LOOKAHEAD_BITS "
+                             "(default: %(default)s)")
+    parser.add_argument("-v", "--verbose", action="store_true",
+                        help="print the compression ratio of every file")
+    args = parser.parse_args()
+
+    block_shift = args.block_size.bit_length() - 1
+    if args.block_size != (1 << block_shift) or block_shift > 15:
+        parser.error("block size must be a power of two up to 32 KiB")
+    if not 4 <= args.window_bits <= 15 or \
+       not 3 <= args.lookahead_bits < args.window_bits:
+        parser.error("invalid heatshrink parameters")
+
+    files = collect(args.root)
+    if len(files) > 0xffff:
+        parser.error("too many files")
+    image, stats = mkhsfs(files, block_shift, args.window_bits,
+                          args.lookahead_bits)
+
+    if args.verbose:
+        for name, size, packed in stats:
+            print("{}: {} -> {} bytes".format(name, size, packed))
+    total = sum(s[1] for s in stats)
+    print("{} files, {} bytes packed into a {} bytes image"
+          .format(len(stats), total, len(image)), file=sys.stderr)
+
+    with open(args.output, "wb") as f:
+        f.write(image)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
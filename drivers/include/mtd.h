@@ -62,6 +62,22 @@ typedef struct {
     uint32_t page_size;        /**< Size of the pages in the MTD */
 } mtd_dev_t;
 
+/**
+ * @name    MTD driver flags
+ * @{
+ */
+/**
+ * @brief   mtd_desc_t::read may be called while an operation started with
+ *          mtd_desc_t::write_start or mtd_desc_t::erase_sector_start is in
+ *          progress
+ */
+#define MTD_DRIVER_FLAG_READ_WHILE_BUSY     (0x1)
+/**
+ * @brief   mtd_desc_t::write accepts data spanning multiple pages
+ */
+#define MTD_DRIVER_FLAG_MULTI_PAGE_WRITE    (0x2)
+/** @} */
+
 /**
  * @brief   MTD driver interface
  *
@@ -146,6 +162,66 @@ struct mtd_desc {
      * @return < 0 value on error
      */
     int (*power)(mtd_dev_t *dev, enum mtd_power_state power);
+
+    /**
+     * @brief   Start writing to the Memory Technology Device (MTD) without
+     *          waiting for completion (optional)
+     *
+     * Same constraints as mtd_desc_t::write. Completion is polled with
+     * mtd_desc_t::busy.
+     *
+     * @param[in] dev       Pointer to the selected driver
+     * @param[in] buff      Pointer to the data to be written, may be reused
+     *                      when the function returns
+     * @param[in] addr      Starting address
+     * @param[in] size      Number of bytes
+     *
+     * @return expected duration of the operation in us (0 if unknown)
+     * @return < 0 value on error
+     */
+    int (*write_start)(mtd_dev_t *dev,
+                       const void *buff,
+                       uint32_t addr,
+                       uint32_t size);
+
+    /**
+     * @brief   Start erasing a single sector of the Memory Technology Device
+     *          (MTD) without waiting for completion (optional)
+     *
+     * Completion is polled with mtd_desc_t::busy.
+     *
+     * @param[in] dev       Pointer to the selected driver
+     * @param[in] addr      Address of the sector
+     *
+     * @return expected duration of the operation in us (0 if unknown)
+     * @return < 0 value on error
+     */
+    int (*erase_sector_start)(mtd_dev_t *dev, uint32_t addr);
+
+    /**
+     * @brief   Check if an operation started with mtd_desc_t::write_start or
+     *          mtd_desc_t::erase_sector_start is still in progress (optional,
+     *          required if one of them is provided)
+     *
+     * @param[in] dev       Pointer to the selected driver
+     *
+     * @return 1 if the operation is still in progress
+     * @return 0 if the device is idle
+     * @return < 0 value on error
+     */
+    int (*busy)(mtd_dev_t *dev);
+
+    /**
+     * @brief   Write data buffered by the driver to the device (optional)
+     *
+     * @param[in] dev       Pointer to the selected driver
+     *
+     * @return 0 on success
+     * @return < 0 value on error
+     */
+    int (*flush)(mtd_dev_t *dev);
+
+    uint8_t flags;  /**< MTD driver flags, see @ref MTD_DRIVER_FLAG_READ_WHILE_BUSY */
 };
 
 /**
@@ -231,6 +307,20 @@ int mtd_erase(mtd_dev_t *mtd, uint32_t addr, uint32_t count);
  */
 int mtd_power(mtd_dev_t *mtd, enum mtd_power_state power);
 
+/**
+ * @brief   Write data buffered by the driver of an MTD device to the device
+ *
+ * Drivers that do not buffer data write it within mtd_write(), for them this
+ * is a no-op.
+ *
+ * @param      mtd   the device to flush
+ *
+ * @return 0 on success
+ * @return -ENODEV if @p mtd is not a valid device
+ * @return -EIO on I/O error
+ */
+int mtd_flush(mtd_dev_t *mtd);
+
 #if defined(MODULE_VFS) || defined(DOXYGEN)
 /**
  * @brief   MTD driver for VFS
@@ -0,0 +1,238 @@
+/*
+ * Copyright (C) 2020 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @defgroup    drivers_mtd_async Asynchronous MTD access
+ * @ingroup     drivers_mtd
+ * @brief       Queued, asynchronous access to a Memory Technology Device
+ *
+ * To activate, use `USEMODULE += mtd_async` in your applications Makefile.
+ *
+ * Requests are submitted to a per-device queue and executed in order by a
+ * worker thread of the device, so the submitting thread can continue with
+ * other work. The completion callback of a request is called from the worker
+ * thread; it may e.g. post an event to the submitting thread.
+ *
+ * If the MTD driver provides mtd_desc_t::write_start,
+ * mtd_desc_t::erase_sector_start and mtd_desc_t::busy, the worker thread
+ * sleeps instead of busy waiting while the device programs or erases, and
+ * erases spanning multiple sectors are split into single sectors. Queued
+ * reads that do not touch sectors still to be erased are served between
+ * these sectors or, if the driver sets
+ * @ref MTD_DRIVER_FLAG_READ_WHILE_BUSY, even while a sector is erased.
+ *
+ * If a staging buffer is given, writes queued back to back that continue each
+ * other are merged into a single write, up to the end of a page (or of the
+ * buffer, if the driver sets @ref MTD_DRIVER_FLAG_MULTI_PAGE_WRITE).
+ *
+ * @{
+ *
+ * @file
+ * @brief   Asynchronous MTD access definitions
+ */
+#ifndef MTD_ASYNC_H
+#define MTD_ASYNC_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "mtd.h"
+#include "sched.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @defgroup    drivers_mtd_async_conf  Asynchronous MTD access compile configurations
+ * @ingroup     config
+ * @{
+ */
+/**
+ * @brief   Interval in us to poll the device for completion, once the
+ *          expected duration of an operation passed
+ */
+#ifndef CONFIG_MTD_ASYNC_POLL_US
+#define CONFIG_MTD_ASYNC_POLL_US    (100U)
+#endif
+/** @} */
+
+/**
+ * @brief   Operations of a request
+ */
+typedef enum {
+    MTD_ASYNC_OP_READ,              /**< read data */
+    MTD_ASYNC_OP_WRITE,             /**< write data */
+    MTD_ASYNC_OP_ERASE,             /**< erase sectors */
+} mtd_async_op_t;
+
+/**
+ * @brief   Forward declaration of a request
+ */
+typedef struct mtd_async_req mtd_async_req_t;
+
+/**
+ * @brief   Completion callback of a request
+ *
+ * @param[in] req   The completed request
+ * @param[in] res   Result of the request, as returned by mtd_read(),
+ *                  mtd_write() or mtd_erase()
+ */
+typedef void (*mtd_async_cb_t)(mtd_async_req_t *req, int res);
+
+/**
+ * @brief   A request
+ *
+ * Must not be touched from submission until its callback is called.
+ */
+struct mtd_async_req {
+    mtd_async_req_t *next;          /**< next request in the queue */
+    mtd_async_cb_t cb;              /**< completion callback, may be NULL */
+    void *arg;                      /**< argument for the callback */
+    void *buf;                      /**< data to read to or write from */
+    uint32_t addr;                  /**< address on the device */
+    uint32_t count;                 /**< number of bytes */
+    mtd_async_op_t op;              /**< operation */
+};
+
+/**
+ * @brief   Statistics of an asynchronous MTD device
+ */
+typedef struct {
+    uint32_t submitted;             /**< number of submitted requests */
+    uint32_t merged;                /**< number of writes merged into another */
+    uint32_t reads_while_erasing;   /**< number of reads served during an
+                                     *   erase */
+} mtd_async_stats_t;
+
+/**
+ * @brief   Asynchronous MTD device
+ */
+typedef struct {
+    mtd_dev_t *mtd;                 /**< the device */
+    mtd_async_req_t *head;          /**< first queued request */
+    mtd_async_req_t *tail;          /**< last queued request */
+    uint8_t *buf;                   /**< staging buffer to merge writes */
+    size_t buf_size;                /**< size of mtd_async_t::buf */
+    kernel_pid_t pid;               /**< worker thread */
+    mtd_async_stats_t stats;        /**< statistics */
+} mtd_async_t;
+
+/**
+ * @brief   Initializes an asynchronous MTD device and starts its worker
+ *          thread
+ *
+ * @param[out] dev      The asynchronous device
+ * @param[in] mtd       An initialized MTD device
+ * @param[in] buf       Staging buffer to merge writes. May be NULL to not
+ *                      merge writes. Should be at least one page.
+ * @param[in] buf_size  Size of @p buf
+ * @param[in] stack     Stack for the worker thread
+ * @param[in] stacksize Size of @p stack
+ * @param[in] priority  Priority of the worker thread
+ * @param[in] name      Name of the worker thread
+ *
+ * @return  0 on success
+ * @return  < 0 if the worker thread could not be created
+ */
+int mtd_async_init(mtd_async_t *dev, mtd_dev_t *mtd, uint8_t *buf,
+                   size_t buf_size, char *stack, int stacksize, char priority,
+                   const char *name);
+
+/**
+ * @brief   Submits a request
+ *
+ * May be called from interrupt context.
+ *
+ * @param[in] dev   The asynchronous device
+ * @param[in] req   A request with all fields but mtd_async_req_t::next set
+ */
+void mtd_async_submit(mtd_async_t *dev, mtd_async_req_t *req);
+
+/**
+ * @brief   Submits a read request
+ *
+ * @param[in] dev   The asynchronous device
+ * @param[out] req  The request to submit
+ * @param[out] dest The buffer to fill in
+ * @param[in] addr  The start address to read from
+ * @param[in] count The number of bytes to read
+ * @param[in] cb    Completion callback, may be NULL
+ * @param[in] arg   Argument for @p cb
+ */
+static inline void mtd_async_read(mtd_async_t *dev, mtd_async_req_t *req,
+                                  void *dest, uint32_t addr, uint32_t count,
+                                  mtd_async_cb_t cb, void *arg)
+{
+    req->op = MTD_ASYNC_OP_READ;
+    req->buf = dest;
+    req->addr = addr;
+    req->count = count;
+    req->cb = cb;
+    req->arg = arg;
+    mtd_async_submit(dev, req);
+}
+
+/**
+ * @brief   Submits a write request
+ *
+ * Same constraints as mtd_write().
+ *
+ * @param[in] dev   The asynchronous device
+ * @param[out] req  The request to submit
+ * @param[in] src   The buffer to write. Must stay valid until @p cb is called.
+ * @param[in] addr  The start address to write to
+ * @param[in] count The number of bytes to write
+ * @param[in] cb    Completion callback, may be NULL
+ * @param[in] arg   Argument for @p cb
+ */
+static inline void mtd_async_write(mtd_async_t *dev, mtd_async_req_t *req,
+                                   const void *src, uint32_t addr,
+                                   uint32_t count, mtd_async_cb_t cb,
+                                   void *arg)
+{
+    req->op = MTD_ASYNC_OP_WRITE;
+    req->buf = (void *)src;
+    req->addr = addr;
+    req->count = count;
+    req->cb = cb;
+    req->arg = arg;
+    mtd_async_submit(dev, req);
+}
+
+/**
+ * @brief   Submits an erase request
+ *
+ * Same constraints as mtd_erase().
+ *
+ * @param[in] dev   The asynchronous device
+ * @param[out] req  The request to submit
+ * @param[in] addr  The address of the first sector to erase
+ * @param[in] count The number of bytes to erase
+ * @param[in] cb    Completion callback, may be NULL
+ * @param[in] arg   Argument for @p cb
+ */
+static inline void mtd_async_erase(mtd_async_t *dev, mtd_async_req_t *req,
+                                   uint32_t addr, uint32_t count,
+                                   mtd_async_cb_t cb, void *arg)
+{
+    req->op = MTD_ASYNC_OP_ERASE;
+    req->buf = NULL;
+    req->addr = addr;
+    req->count = count;
+    req->cb = cb;
+    req->arg = arg;
+    mtd_async_submit(dev, req);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MTD_ASYNC_H */
+/** @} */
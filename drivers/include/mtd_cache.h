@@ -0,0 +1,135 @@
+/*
+ * Copyright (C) 2020 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @defgroup    drivers_mtd_cache   MTD block cache
+ * @ingroup     drivers_storage
+ * @brief       Write-back page cache for MTD devices
+ *
+ * This MTD module wraps another MTD device and keeps recently used pages of
+ * it in RAM, so repeated accesses to e.g. file system metadata do not hit the
+ * bus every time. It can be used below any file system that talks to an MTD
+ * device.
+ *
+ * - Pages are replaced in least recently used order.
+ * - Writes only modify the cached page. Writes to the same page are
+ *   coalesced, the dirty part of a page is programmed at once when the page
+ *   is evicted or the cache is flushed.
+ * - The cache is flushed by mtd_flush(), which the file systems call on
+ *   vfs_fsync() and when closing a file.
+ * - Erasing drops the affected pages from the cache.
+ *
+ * @warning Data written since the last flush is lost on power failure.
+ * @warning The dirty part of a page may include bytes that were not written
+ *          since the last flush, they are programmed again with their current
+ *          value. The backing device has to tolerate this, which NOR flash
+ *          and SD cards do.
+ *
+ * ## Usage
+ *
+ * ```
+ * USEMODULE += mtd_cache
+ * ```
+ *
+ * ```
+ * static mtd_cache_entry_t entries[4];
+ * static uint8_t buf[4 * PAGE_SIZE];
+ * static mtd_cache_t cache = MTD_CACHE_INIT(MTD_0, entries, buf);
+ *
+ * mtd_dev_t *dev = &cache.mtd;
+ * ```
+ *
+ * The geometry of the cache device is taken from the backing device on
+ * initialization.
+ *
+ * @{
+ *
+ * @file
+ * @brief       Interface definitions for the MTD block cache
+ */
+
+#ifndef MTD_CACHE_H
+#define MTD_CACHE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "kernel_defines.h"
+#include "mtd.h"
+#include "mutex.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief   Shortcut macro for initializing a @ref mtd_cache_t
+ *
+ * @param[in] _parent   The backing MTD device
+ * @param[in] _entries  Array of @ref mtd_cache_entry_t, one per cached page
+ * @param[in] _buf      Array of at least one page per entry
+ */
+#define MTD_CACHE_INIT(_parent, _entries, _buf) \
+{ \
+    .mtd = { .driver = &mtd_cache_driver }, \
+    .parent = _parent, \
+    .entries = _entries, \
+    .entries_numof = ARRAY_SIZE(_entries), \
+    .buf = _buf, \
+    .buf_size = sizeof(_buf), \
+    .lock = MUTEX_INIT, \
+}
+
+/**
+ * @brief   A cached page
+ */
+typedef struct {
+    uint32_t page;          /**< page number on the backing device */
+    uint32_t last_use;      /**< time of the last access, for LRU */
+    uint16_t dirty_start;   /**< start of the dirty part of the page */
+    uint16_t dirty_end;     /**< end of the dirty part, 0 if clean */
+    bool valid;             /**< entry holds a page */
+} mtd_cache_entry_t;
+
+/**
+ * @brief   Cache statistics
+ */
+typedef struct {
+    uint32_t hits;          /**< page accesses served from the cache */
+    uint32_t misses;        /**< page accesses that read the backing device */
+    uint32_t writebacks;    /**< pages programmed to the backing device */
+    uint32_t evictions;     /**< valid pages replaced by another page */
+} mtd_cache_stats_t;
+
+/**
+ * @brief   MTD block cache
+ */
+typedef struct {
+    mtd_dev_t mtd;                  /**< MTD context */
+    mtd_dev_t *parent;              /**< backing MTD device */
+    mtd_cache_entry_t *entries;     /**< cached pages */
+    unsigned entries_numof;         /**< number of mtd_cache_t::entries */
+    uint8_t *buf;                   /**< page data, one page per entry */
+    size_t buf_size;                /**< size of mtd_cache_t::buf */
+    uint32_t clock;                 /**< access counter for LRU */
+    mutex_t lock;                   /**< lock for the cache */
+    mtd_cache_stats_t stats;        /**< statistics */
+} mtd_cache_t;
+
+/**
+ * @brief   Block cache MTD device operations table
+ */
+extern const mtd_desc_t mtd_cache_driver;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MTD_CACHE_H */
+/** @} */
@@ -25,10 +25,27 @@
 extern "C" {
 #endif
 
+#include "kernel_defines.h"
 #include "periph/spi.h"
 #include "periph/gpio.h"
 #include "stdbool.h"
 
+/**
+ * @defgroup drivers_sdcard_spi_config     SPI SD-Card driver compile configuration
+ * @ingroup config_drivers_storage
+ * @{
+ */
+/**
+ * @brief   Send a pre-erase hint (ACMD23) before multi-block writes
+ *
+ * The card is told how many blocks the following CMD25 writes, so it can
+ * erase them at once instead of block by block. Set to 0 to disable.
+ */
+#ifndef CONFIG_SDCARD_SPI_PRE_ERASE
+#define CONFIG_SDCARD_SPI_PRE_ERASE     1
+#endif
+/** @} */
+
 #define SD_HC_BLOCK_SIZE      (512)  /**< size of a single block on SDHC cards */
 #define SDCARD_SPI_INIT_ERROR (-1)   /**< returned on failed init */
 #define SDCARD_SPI_OK         (0)    /**< returned on successful init */
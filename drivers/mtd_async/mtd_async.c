@@ -0,0 +1,288 @@
+/*
+ * Copyright (C) 2020 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     drivers_mtd_async
+ * @{
+ *
+ * @file
+ * @brief       Asynchronous MTD access implementation
+ *
+ * @}
+ */
+
+#include <assert.h>
+#include <errno.h>
+#include <string.h>
+
+#include "irq.h"
+#include "msg.h"
+#include "mtd_async.h"
+#include "thread.h"
+#include "xtimer.h"
+
+#define ENABLE_DEBUG    (0)
+#include "debug.h"
+
+#define _MSG_TYPE_KICK      (0x4d41)
+#define _MSG_QUEUE_SIZE     (2U)
+
+static mtd_async_req_t *_pop(mtd_async_t *dev)
+{
+    unsigned state = irq_disable();
+    mtd_async_req_t *req = dev->head;
+
+    if (req != NULL) {
+        dev->head = req->next;
+        if (dev->head == NULL) {
+            dev->tail = NULL;
+        }
+        req->next = NULL;
+    }
+    irq_restore(state);
+    return req;
+}
+
+static inline void _complete(mtd_async_req_t *req, int res)
+{
+    if (req->cb != NULL) {
+        req->cb(req, res);
+    }
+}
+
+static inline bool _overlaps(const mtd_async_req_t *req, uint32_t from,
+                             uint32_t to)
+{
+    return (req->addr < to) && ((req->addr + req->count) > from);
+}
+
+/* serves the reads at the head of the queue that do not touch [from, to), so
+ * the order of requests is kept */
+static void _serve_reads(mtd_async_t *dev, uint32_t from, uint32_t to)
+{
+    while (1) {
+        unsigned state = irq_disable();
+        mtd_async_req_t *req = dev->head;
+
+        if ((req == NULL) || (req->op != MTD_ASYNC_OP_READ) ||
+            _overlaps(req, from, to)) {
+            irq_restore(state);
+            return;
+        }
+        irq_restore(state);
+        req = _pop(dev);
+        dev->stats.reads_while_erasing++;
+        _complete(req, mtd_read(dev->mtd, req->buf, req->addr, req->count));
+    }
+}
+
+static int _wait(mtd_async_t *dev, uint32_t us, uint32_t from, uint32_t to)
+{
+    const mtd_desc_t *driver = dev->mtd->driver;
+    int res;
+
+    if (us == 0) {
+        us = CONFIG_MTD_ASYNC_POLL_US;
+    }
+    while ((res = driver->busy(dev->mtd)) > 0) {
+        if (driver->flags & MTD_DRIVER_FLAG_READ_WHILE_BUSY) {
+            _serve_reads(dev, from, to);
+        }
+        xtimer_usleep(us);
+        us = CONFIG_MTD_ASYNC_POLL_US;
+    }
+    return res;
+}
+
+static inline bool _split_phase(const mtd_desc_t *driver)
+{
+    return (driver->busy != NULL);
+}
+
+static int _program(mtd_async_t *dev, const void *data, uint32_t addr,
+                    uint32_t count)
+{
+    const mtd_desc_t *driver = dev->mtd->driver;
+    int res;
+
+    if (!_split_phase(driver) || (driver->write_start == NULL)) {
+        return mtd_write(dev->mtd, data, addr, count);
+    }
+    res = driver->write_start(dev->mtd, data, addr, count);
+    if (res < 0) {
+        return res;
+    }
+    res = _wait(dev, res, addr, addr + count);
+    return (res < 0) ? res : 0;
+}
+
+static uint32_t _merge_limit(const mtd_async_t *dev, uint32_t addr)
+{
+    const mtd_dev_t *mtd = dev->mtd;
+    uint32_t limit = addr + dev->buf_size;
+
+    if (!(mtd->driver->flags & MTD_DRIVER_FLAG_MULTI_PAGE_WRITE)) {
+        uint32_t page_end = ((addr / mtd->page_size) + 1) * mtd->page_size;
+
+        if (page_end < limit) {
+            limit = page_end;
+        }
+    }
+    return limit;
+}
+
+static void _write(mtd_async_t *dev, mtd_async_req_t *req)
+{
+    mtd_async_req_t *last = req;
+    const void *data = req->buf;
+    uint32_t end = req->addr + req->count;
+    int res;
+
+    if ((dev->buf != NULL) && (req->count <= dev->buf_size)) {
+        uint32_t limit = _merge_limit(dev, req->addr);
+        unsigned state = irq_disable();
+
+        /* take all writes from the head of the queue that continue this one */
+        while ((dev->head != NULL) && (dev->head->op == MTD_ASYNC_OP_WRITE) &&
+               (dev->head->addr == end) &&
+               ((dev->head->addr + dev->head->count) <= limit)) {
+            last->next = dev->head;
+            last = dev->head;
+            end += last->count;
+            dev->head = last->next;
+        }
+        if (dev->head == NULL) {
+            dev->tail = NULL;
+        }
+        last->next = NULL;
+        irq_restore(state);
+    }
+    if (last != req) {
+        uint8_t *ptr = dev->buf;
+
+        for (mtd_async_req_t *r = req; r != NULL; r = r->next) {
+            memcpy(ptr, r->buf, r->count);
+            ptr += r->count;
+            if (r != req) {
+                dev->stats.merged++;
+            }
+        }
+        data = dev->buf;
+    }
+    DEBUG("mtd_async: write 0x%lx, %lu bytes\n", (unsigned long)req->addr,
+          (unsigned long)(end - req->addr));
+    res = _program(dev, data, req->addr, end - req->addr);
+    while (req != NULL) {
+        /* the callback may submit the request again */
+        mtd_async_req_t *next = req->next;
+
+        _complete(req, res);
+        req = next;
+    }
+}
+
+static void _erase(mtd_async_t *dev, mtd_async_req_t *req)
+{
+    mtd_dev_t *mtd = dev->mtd;
+    const mtd_desc_t *driver = mtd->driver;
+    uint32_t sector_size = mtd->pages_per_sector * mtd->page_size;
+    uint32_t end = req->addr + req->count;
+    int res = 0;
+
+    if (!_split_phase(driver) || (driver->erase_sector_start == NULL) ||
+        ((req->addr % sector_size) != 0) || ((req->count % sector_size) != 0)) {
+        _complete(req, mtd_erase(mtd, req->addr, req->count));
+        return;
+    }
+    for (uint32_t addr = req->addr; (res >= 0) && (addr < end);
+         addr += sector_size) {
+        DEBUG("mtd_async: erase sector 0x%lx\n", (unsigned long)addr);
+        res = driver->erase_sector_start(mtd, addr);
+        if (res >= 0) {
+            res = _wait(dev, res, addr, end);
+        }
+        if (res >= 0) {
+            /* the device is idle, serve the reads that queued up */
+            _serve_reads(dev, addr + sector_size, end);
+        }
+    }
+    _complete(req, (res < 0) ? res : 0);
+}
+
+static void *_worker(void *arg)
+{
+    mtd_async_t *dev = arg;
+    msg_t queue[_MSG_QUEUE_SIZE];
+
+    msg_init_queue(queue, _MSG_QUEUE_SIZE);
+    while (1) {
+        mtd_async_req_t *req;
+        msg_t msg;
+
+        msg_receive(&msg);
+        while ((req = _pop(dev)) != NULL) {
+            switch (req->op) {
+                case MTD_ASYNC_OP_READ:
+                    _complete(req, mtd_read(dev->mtd, req->buf, req->addr,
+                                            req->count));
+                    break;
+                case MTD_ASYNC_OP_WRITE:
+                    _write(dev, req);
+                    break;
+                case MTD_ASYNC_OP_ERASE:
+                    _erase(dev, req);
+                    break;
+                default:
+                    _complete(req, -ENOTSUP);
+                    break;
+            }
+        }
+    }
+    return NULL;
+}
+
+int mtd_async_init(mtd_async_t *dev, mtd_dev_t *mtd, uint8_t *buf,
+                   size_t buf_size, char *stack, int stacksize, char priority,
+                   const char *name)
+{
+    kernel_pid_t pid;
+
+    assert((dev != NULL) && (mtd != NULL) && (mtd->driver != NULL));
+    memset(dev, 0, sizeof(*dev));
+    dev->mtd = mtd;
+    dev->buf = buf;
+    dev->buf_size = (buf != NULL) ? buf_size : 0;
+    pid = thread_create(stack, stacksize, priority, THREAD_CREATE_STACKTEST,
+                        _worker, dev, name);
+    if (pid < 0) {
+        return pid;
+    }
+    dev->pid = pid;
+    return 0;
+}
+
+void mtd_async_submit(mtd_async_t *dev, mtd_async_req_t *req)
+{
+    msg_t msg = { .type = _MSG_TYPE_KICK };
+    unsigned state;
+
+    assert((dev != NULL) && (req != NULL));
+    req->next = NULL;
+    state = irq_disable();
+    if (dev->tail == NULL) {
+        dev->head = req;
+    }
+    else {
+        dev->tail->next = req;
+    }
+    dev->tail = req;
+    dev->stats.submitted++;
+    irq_restore(state);
+    /* if the worker's queue is full, it was already kicked */
+    msg_try_send(&msg, dev->pid);
+}
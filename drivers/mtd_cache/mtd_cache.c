@@ -0,0 +1,324 @@
+/*
+ * Copyright (C) 2020 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     drivers_mtd_cache
+ * @{
+ *
+ * @file
+ * @brief       Write-back page cache for MTD devices
+ *
+ * @}
+ */
+
+#include <assert.h>
+#include <errno.h>
+#include <inttypes.h>
+#include <string.h>
+
+#include "kernel_defines.h"
+#include "mtd.h"
+#include "mtd_cache.h"
+#include "mutex.h"
+
+#define ENABLE_DEBUG    (0)
+#include "debug.h"
+
+static inline uint8_t *_data(const mtd_cache_t *cache,
+                             const mtd_cache_entry_t *entry)
+{
+    return &cache->buf[(entry - cache->entries) * cache->mtd.page_size];
+}
+
+static inline uint32_t _size(const mtd_dev_t *mtd)
+{
+    return mtd->page_size * mtd->pages_per_sector * mtd->sector_count;
+}
+
+/* bytes of an access of count bytes at offset in a page within the page */
+static inline uint32_t _chunk(const mtd_dev_t *mtd, uint32_t offset,
+                              uint32_t count)
+{
+    uint32_t len = mtd->page_size - offset;
+
+    return (count < len) ? count : len;
+}
+
+static int _writeback(mtd_cache_t *cache, mtd_cache_entry_t *entry)
+{
+    uint32_t addr = entry->page * cache->mtd.page_size;
+    int res;
+
+    if (entry->dirty_end == 0) {
+        return 0;
+    }
+    DEBUG("mtd_cache: write back page %" PRIu32 " [%u, %u)\n", entry->page,
+          entry->dirty_start, entry->dirty_end);
+    res = mtd_write(cache->parent, _data(cache, entry) + entry->dirty_start,
+                    addr + entry->dirty_start,
+                    entry->dirty_end - entry->dirty_start);
+    if (res < 0) {
+        return res;
+    }
+    entry->dirty_end = 0;
+    cache->stats.writebacks++;
+    return 0;
+}
+
+static mtd_cache_entry_t *_find(mtd_cache_t *cache, uint32_t page)
+{
+    for (unsigned i = 0; i < cache->entries_numof; i++) {
+        mtd_cache_entry_t *entry = &cache->entries[i];
+
+        if (entry->valid && (entry->page == page)) {
+            return entry;
+        }
+    }
+    return NULL;
+}
+
+/* returns the least recently used entry, written back and invalidated */
+static int _alloc(mtd_cache_t *cache, mtd_cache_entry_t **out)
+{
+    mtd_cache_entry_t *victim = &cache->entries[0];
+    int res;
+
+    for (unsigned i = 0; i < cache->entries_numof; i++) {
+        mtd_cache_entry_t *entry = &cache->entries[i];
+
+        if (!entry->valid) {
+            victim = entry;
+            break;
+        }
+        if ((int32_t)(entry->last_use - victim->last_use) < 0) {
+            victim = entry;
+        }
+    }
+    if (victim->valid) {
+        res = _writeback(cache, victim);
+        if (res < 0) {
+            return res;
+        }
+        victim->valid = false;
+        cache->stats.evictions++;
+    }
+    *out = victim;
+    return 0;
+}
+
+/* returns the entry of page, loading it from the backing device unless
+ * it is going to be overwritten completely */
+static int _get(mtd_cache_t *cache, uint32_t page, bool load,
+                mtd_cache_entry_t **out)
+{
+    mtd_cache_entry_t *entry = _find(cache, page);
+    int res;
+
+    if (entry != NULL) {
+        cache->stats.hits++;
+    }
+    else {
+        cache->stats.misses++;
+        res = _alloc(cache, &entry);
+        if (res < 0) {
+            return res;
+        }
+        if (load) {
+            res = mtd_read(cache->parent, _data(cache, entry),
+                           page * cache->mtd.page_size, cache->mtd.page_size);
+            if (res < 0) {
+                return res;
+            }
+        }
+        entry->page = page;
+        entry->dirty_end = 0;
+        entry->valid = true;
+    }
+    entry->last_use = cache->clock++;
+    *out = entry;
+    return 0;
+}
+
+static int _flush(mtd_cache_t *cache)
+{
+    /* write back in ascending address order, this is what the backing device
+     * handles best */
+    while (1) {
+        mtd_cache_entry_t *next = NULL;
+
+        for (unsigned i = 0; i < cache->entries_numof; i++) {
+            mtd_cache_entry_t *entry = &cache->entries[i];
+
+            if (entry->valid && (entry->dirty_end != 0) &&
+                ((next == NULL) || (entry->page < next->page))) {
+                next = entry;
+            }
+        }
+        if (next == NULL) {
+            return 0;
+        }
+        int res = _writeback(cache, next);
+        if (res < 0) {
+            return res;
+        }
+    }
+}
+
+static int _init(mtd_dev_t *mtd)
+{
+    mtd_cache_t *cache = container_of(mtd, mtd_cache_t, mtd);
+    int res;
+
+    mutex_lock(&cache->lock);
+    res = mtd_init(cache->parent);
+    if ((res == 0) && (mtd->page_size == 0)) {
+        /* first initialization, cached data survives later ones */
+        if ((cache->parent->page_size > UINT16_MAX) ||
+            (cache->buf_size <
+             (cache->entries_numof * cache->parent->page_size))) {
+            res = -ENOMEM;
+        }
+        else {
+            mtd->sector_count = cache->parent->sector_count;
+            mtd->pages_per_sector = cache->parent->pages_per_sector;
+            mtd->page_size = cache->parent->page_size;
+            memset(cache->entries, 0,
+                   cache->entries_numof * sizeof(*cache->entries));
+        }
+    }
+    mutex_unlock(&cache->lock);
+    return res;
+}
+
+static int _read(mtd_dev_t *mtd, void *dest, uint32_t addr, uint32_t count)
+{
+    mtd_cache_t *cache = container_of(mtd, mtd_cache_t, mtd);
+    uint8_t *ptr = dest;
+    int res = 0;
+
+    if ((addr + count) > _size(mtd)) {
+        return -EOVERFLOW;
+    }
+    mutex_lock(&cache->lock);
+    while (count > 0) {
+        uint32_t offset = addr % mtd->page_size;
+        uint32_t len = _chunk(mtd, offset, count);
+        mtd_cache_entry_t *entry;
+
+        res = _get(cache, addr / mtd->page_size, true, &entry);
+        if (res < 0) {
+            break;
+        }
+        memcpy(ptr, _data(cache, entry) + offset, len);
+        ptr += len;
+        addr += len;
+        count -= len;
+    }
+    mutex_unlock(&cache->lock);
+    return res;
+}
+
+static int _write(mtd_dev_t *mtd, const void *src, uint32_t addr,
+                  uint32_t count)
+{
+    mtd_cache_t *cache = container_of(mtd, mtd_cache_t, mtd);
+    const uint8_t *ptr = src;
+    int res = 0;
+
+    if ((addr + count) > _size(mtd)) {
+        return -EOVERFLOW;
+    }
+    mutex_lock(&cache->lock);
+    while (count > 0) {
+        uint32_t offset = addr % mtd->page_size;
+        uint32_t len = _chunk(mtd, offset, count);
+        mtd_cache_entry_t *entry;
+
+        res = _get(cache, addr / mtd->page_size, len < mtd->page_size, &entry);
+        if (res < 0) {
+            break;
+        }
+        memcpy(_data(cache, entry) + offset, ptr, len);
+        if (entry->dirty_end == 0) {
+            entry->dirty_start = offset;
+            entry->dirty_end = offset + len;
+        }
+        else {
+            if (offset < entry->dirty_start) {
+                entry->dirty_start = offset;
+            }
+            if ((offset + len) > entry->dirty_end) {
+                entry->dirty_end = offset + len;
+            }
+        }
+        ptr += len;
+        addr += len;
+        count -= len;
+    }
+    mutex_unlock(&cache->lock);
+    return res;
+}
+
+static int _erase(mtd_dev_t *mtd, uint32_t addr, uint32_t count)
+{
+    mtd_cache_t *cache = container_of(mtd, mtd_cache_t, mtd);
+    uint32_t first = addr / mtd->page_size;
+    uint32_t last = (addr + count) / mtd->page_size;
+    int res;
+
+    mutex_lock(&cache->lock);
+    /* pending writes to the erased pages are obsolete */
+    for (unsigned i = 0; i < cache->entries_numof; i++) {
+        mtd_cache_entry_t *entry = &cache->entries[i];
+
+        if (entry->valid && (entry->page >= first) && (entry->page < last)) {
+            entry->valid = false;
+        }
+    }
+    res = mtd_erase(cache->parent, addr, count);
+    mutex_unlock(&cache->lock);
+    return res;
+}
+
+static int _flush_dev(mtd_dev_t *mtd)
+{
+    mtd_cache_t *cache = container_of(mtd, mtd_cache_t, mtd);
+    int res;
+
+    mutex_lock(&cache->lock);
+    res = _flush(cache);
+    if (res == 0) {
+        res = mtd_flush(cache->parent);
+    }
+    mutex_unlock(&cache->lock);
+    return res;
+}
+
+static int _power(mtd_dev_t *mtd, enum mtd_power_state power)
+{
+    mtd_cache_t *cache = container_of(mtd, mtd_cache_t, mtd);
+    int res = 0;
+
+    if (power == MTD_POWER_DOWN) {
+        res = _flush_dev(mtd);
+    }
+    if (res == 0) {
+        res = mtd_power(cache->parent, power);
+    }
+    return res;
+}
+
+const mtd_desc_t mtd_cache_driver = {
+    .init = _init,
+    .read = _read,
+    .write = _write,
+    .erase = _erase,
+    .power = _power,
+    .flush = _flush_dev,
+    .flags = MTD_DRIVER_FLAG_MULTI_PAGE_WRITE,
+};
@@ -43,6 +43,8 @@ const mtd_desc_t mtd_sdcard_driver = {
     .write = mtd_sdcard_write,
     .erase = mtd_sdcard_erase,
     .power = mtd_sdcard_power,
+    /* mtd_sdcard_write() writes multiple blocks at once */
+    .flags = MTD_DRIVER_FLAG_MULTI_PAGE_WRITE,
 };
 
 static int mtd_sdcard_init(mtd_dev_t *dev)
@@ -74,6 +74,9 @@ static int mtd_spi_nor_read(mtd_dev_t *mtd, void *dest, uint32_t addr, uint32_t
 static int mtd_spi_nor_write(mtd_dev_t *mtd, const void *src, uint32_t addr, uint32_t size);
 static int mtd_spi_nor_erase(mtd_dev_t *mtd, uint32_t addr, uint32_t size);
 static int mtd_spi_nor_power(mtd_dev_t *mtd, enum mtd_power_state power);
+static int mtd_spi_nor_write_start(mtd_dev_t *mtd, const void *src, uint32_t addr, uint32_t size);
+static int mtd_spi_nor_erase_sector_start(mtd_dev_t *mtd, uint32_t addr);
+static int mtd_spi_nor_busy(mtd_dev_t *mtd);
 
 const mtd_desc_t mtd_spi_nor_driver = {
     .init = mtd_spi_nor_init,
@@ -81,6 +84,9 @@ const mtd_desc_t mtd_spi_nor_driver = {
     .write = mtd_spi_nor_write,
     .erase = mtd_spi_nor_erase,
     .power = mtd_spi_nor_power,
+    .write_start = mtd_spi_nor_write_start,
+    .erase_sector_start = mtd_spi_nor_erase_sector_start,
+    .busy = mtd_spi_nor_busy,
 };
 
 static void mtd_spi_acquire(const mtd_spi_nor_t *dev)
@@ -483,16 +489,11 @@ static int mtd_spi_nor_read(mtd_dev_t *mtd, void *dest, uint32_t addr, uint32_t
     return 0;
 }
 
-static int mtd_spi_nor_write(mtd_dev_t *mtd, const void *src, uint32_t addr, uint32_t size)
+static int mtd_spi_nor_check_write(const mtd_dev_t *mtd, uint32_t addr, uint32_t size)
 {
+    const mtd_spi_nor_t *dev = (const mtd_spi_nor_t *)mtd;
     uint32_t total_size = mtd->page_size * mtd->pages_per_sector * mtd->sector_count;
 
-    DEBUG("mtd_spi_nor_write: %p, %p, 0x%" PRIx32 ", 0x%" PRIx32 "\n",
-          (void *)mtd, src, addr, size);
-    if (size == 0) {
-        return 0;
-    }
-    const mtd_spi_nor_t *dev = (mtd_spi_nor_t *)mtd;
     if (size > mtd->page_size) {
         DEBUG("mtd_spi_nor_write: ERR: page program >1 page (%" PRIu32 ")!\n", mtd->page_size);
         return -EOVERFLOW;
@@ -505,14 +506,36 @@ static int mtd_spi_nor_write(mtd_dev_t *mtd, const void *src, uint32_t addr, uin
     if (addr + size > total_size) {
         return -EOVERFLOW;
     }
+    return 0;
+}
+
+static void mtd_spi_nor_page_program(const mtd_spi_nor_t *dev, const void *src,
+                                     uint32_t addr, uint32_t size)
+{
     be_uint32_t addr_be = byteorder_htonl(addr);
 
-    mtd_spi_acquire(dev);
     /* write enable */
     mtd_spi_cmd(dev, dev->params->opcode->wren);
 
     /* Page program */
     mtd_spi_cmd_addr_write(dev, dev->params->opcode->page_program, addr_be, src, size);
+}
+
+static int mtd_spi_nor_write(mtd_dev_t *mtd, const void *src, uint32_t addr, uint32_t size)
+{
+    DEBUG("mtd_spi_nor_write: %p, %p, 0x%" PRIx32 ", 0x%" PRIx32 "\n",
+          (void *)mtd, src, addr, size);
+    if (size == 0) {
+        return 0;
+    }
+    const mtd_spi_nor_t *dev = (mtd_spi_nor_t *)mtd;
+    int res = mtd_spi_nor_check_write(mtd, addr, size);
+    if (res < 0) {
+        return res;
+    }
+
+    mtd_spi_acquire(dev);
+    mtd_spi_nor_page_program(dev, src, addr, size);
 
     /* waiting for the command to complete before returning */
     wait_for_write_complete(dev, 0);
@@ -521,6 +544,27 @@ static int mtd_spi_nor_write(mtd_dev_t *mtd, const void *src, uint32_t addr, uin
     return 0;
 }
 
+static int mtd_spi_nor_write_start(mtd_dev_t *mtd, const void *src, uint32_t addr, uint32_t size)
+{
+    DEBUG("mtd_spi_nor_write_start: %p, %p, 0x%" PRIx32 ", 0x%" PRIx32 "\n",
+          (void *)mtd, src, addr, size);
+    if (size == 0) {
+        return 0;
+    }
+    const mtd_spi_nor_t *dev = (mtd_spi_nor_t *)mtd;
+    int res = mtd_spi_nor_check_write(mtd, addr, size);
+    if (res < 0) {
+        return res;
+    }
+
+    mtd_spi_acquire(dev);
+    mtd_spi_nor_page_program(dev, src, addr, size);
+    mtd_spi_release(dev);
+
+    /* the page program time is not part of the parameters */
+    return 0;
+}
+
 static int mtd_spi_nor_erase(mtd_dev_t *mtd, uint32_t addr, uint32_t size)
 {
     DEBUG("mtd_spi_nor_erase: %p, 0x%" PRIx32 ", 0x%" PRIx32 "\n",
@@ -588,6 +632,56 @@ static int mtd_spi_nor_erase(mtd_dev_t *mtd, uint32_t addr, uint32_t size)
     return 0;
 }
 
+static int mtd_spi_nor_erase_sector_start(mtd_dev_t *mtd, uint32_t addr)
+{
+    DEBUG("mtd_spi_nor_erase_sector_start: %p, 0x%" PRIx32 "\n", (void *)mtd, addr);
+    mtd_spi_nor_t *dev = (mtd_spi_nor_t *)mtd;
+    uint32_t sector_size = mtd->page_size * mtd->pages_per_sector;
+    be_uint32_t addr_be = byteorder_htonl(addr);
+    uint8_t opcode;
+    uint32_t us;
+
+    if ((addr % sector_size) != 0) {
+        return -EOVERFLOW;
+    }
+    if (addr + sector_size > sector_size * mtd->sector_count) {
+        return -EOVERFLOW;
+    }
+
+    if ((dev->params->flag & SPI_NOR_F_SECT_32K) && (sector_size == MTD_32K)) {
+        opcode = dev->params->opcode->block_erase_32k;
+        us = dev->params->wait_32k_erase;
+    }
+    else if ((dev->params->flag & SPI_NOR_F_SECT_4K) && (sector_size == MTD_4K)) {
+        opcode = dev->params->opcode->sector_erase;
+        us = dev->params->wait_4k_erase;
+    }
+    else {
+        opcode = dev->params->opcode->block_erase;
+        us = dev->params->wait_sector_erase;
+    }
+
+    mtd_spi_acquire(dev);
+    /* write enable */
+    mtd_spi_cmd(dev, dev->params->opcode->wren);
+    mtd_spi_cmd_addr_write(dev, opcode, addr_be, NULL, 0);
+    mtd_spi_release(dev);
+
+    return us;
+}
+
+static int mtd_spi_nor_busy(mtd_dev_t *mtd)
+{
+    mtd_spi_nor_t *dev = (mtd_spi_nor_t *)mtd;
+    uint8_t status;
+
+    mtd_spi_acquire(dev);
+    mtd_spi_cmd_read(dev, dev->params->opcode->rdsr, &status, sizeof(status));
+    mtd_spi_release(dev);
+
+    return status & 1;
+}
+
 static int mtd_spi_nor_power(mtd_dev_t *mtd, enum mtd_power_state power)
 {
     mtd_spi_nor_t *dev = (mtd_spi_nor_t *)mtd;
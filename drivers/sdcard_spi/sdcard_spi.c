@@ -571,6 +571,18 @@ static inline int _transfer_bytes(sdcard_spi_t *card, const uint8_t *out, uint8_
     unsigned trans_bytes = 0;
     uint8_t in_temp;
 
+    if (_dyn_spi_rxtx_byte == &_hw_spi_rxtx_byte) {
+        /* hand the whole buffer to the SPI driver at once, it may use DMA */
+        if (out == NULL) {
+            /* the dummy bytes are sent from the receive buffer, every byte is
+               shifted out before the byte received in its place is stored */
+            memset(in, SD_CARD_DUMMY_BYTE, length);
+            out = in;
+        }
+        spi_transfer_bytes(card->params.spi_dev, GPIO_UNDEF, true, out, in, length);
+        return length;
+    }
+
     for (trans_bytes = 0; trans_bytes < length; trans_bytes++) {
         if (out != NULL) {
             trans_ret = _dyn_spi_rxtx_byte(card, out[trans_bytes], &in_temp);
@@ -752,6 +764,15 @@ static inline int _write_blocks(sdcard_spi_t *card, uint8_t cmd_idx, int bladdr,
     _select_card_spi(card);
     int written = 0;
 
+    if (IS_ACTIVE(CONFIG_SDCARD_SPI_PRE_ERASE) && (cmd_idx == SD_CMD_25)) {
+        /* let the card erase all blocks of the write in one go, this is only a
+           hint so a card that rejects it is written anyway */
+        uint8_t acmd_r1_resu = sdcard_spi_send_acmd(card, SD_CMD_23, nbl, 0);
+        if (!R1_VALID(acmd_r1_resu) || R1_ERROR(acmd_r1_resu)) {
+            DEBUG("_write_blocks: send ACMD23: [FAILED]\n");
+        }
+    }
+
     uint32_t addr = card->use_block_addr ? bladdr : (bladdr * SD_HC_BLOCK_SIZE);
     uint8_t cmd_r1_resu = sdcard_spi_send_cmd(card, cmd_idx, addr, SD_BLOCK_WRITE_CMD_RETRY_US);
 
@@ -0,0 +1,188 @@
+/*
+ * Copyright (C) 2020 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     examples
+ * @{
+ *
+ * @file
+ * @brief       gcoap file server example
+ *
+ * @}
+ */
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include "board.h"
+#include "fs/constfs.h"
+#include "msg.h"
+#include "net/gcoap.h"
+#include "shell.h"
+#include "vfs.h"
+
+#define MAIN_QUEUE_SIZE     (4)
+
+/* prefix of the resource paths, the remainder is the VFS path */
+#define FILE_URI_PREFIX     "/vfs"
+#define BLOB_SIZE           (16U * 1024U)
+
+#if defined(MTD_0) && defined(MODULE_LITTLEFS2)
+#include "fs/littlefs2_fs.h"
+
+#define NVM_AVAILABLE       1
+
+static littlefs2_desc_t _nvm_desc = {
+    .lock = MUTEX_INIT,
+};
+
+static vfs_mount_t _nvm_mount = {
+    .fs = &littlefs2_file_system,
+    .mount_point = "/nvm",
+    .private_data = &_nvm_desc,
+};
+#else
+#define NVM_AVAILABLE       0
+#endif
+
+#define HELLO_CONTENT       "Hello from the RIOT gcoap file server!\n"
+
+static const uint8_t _blob[BLOB_SIZE];
+
+static constfs_file_t _const_files[] = {
+    {
+        .path = "/blob",
+        .size = sizeof(_blob),
+        .data = _blob,
+    },
+    {
+        .path = "/hello",
+        .size = sizeof(HELLO_CONTENT) - 1,
+        .data = (const uint8_t *)HELLO_CONTENT,
+    },
+};
+
+static constfs_t _const_desc = {
+    .nfiles = ARRAY_SIZE(_const_files),
+    .files = _const_files,
+};
+
+static vfs_mount_t _const_mount = {
+    .fs = &constfs_file_system,
+    .mount_point = "/const",
+    .private_data = &_const_desc,
+};
+
+static msg_t _main_msg_queue[MAIN_QUEUE_SIZE];
+
+static ssize_t _file_handler(coap_pkt_t *pdu, uint8_t *buf, size_t len,
+                             void *ctx);
+
+/* CoAP resources. Must be sorted by path (ASCII order). */
+static const coap_resource_t _resources[] = {
+    { FILE_URI_PREFIX, COAP_GET | COAP_MATCH_SUBTREE, _file_handler, NULL },
+};
+
+static gcoap_listener_t _listener = {
+    &_resources[0],
+    ARRAY_SIZE(_resources),
+    NULL,
+    NULL
+};
+
+static ssize_t _file_handler(coap_pkt_t *pdu, uint8_t *buf, size_t len,
+                             void *ctx)
+{
+    (void)ctx;
+
+    char uri[CONFIG_NANOCOAP_URI_MAX];
+    coap_block_slicer_t slicer;
+    struct stat st;
+    size_t blk_len = 0;
+    ssize_t plen;
+    int fd;
+
+    /* read the request completely, the response reuses its buffer */
+    if (coap_get_uri_path(pdu, (uint8_t *)uri) <= 0) {
+        return gcoap_response(pdu, buf, len, COAP_CODE_BAD_REQUEST);
+    }
+    coap_block2_init(pdu, &slicer);
+
+    fd = vfs_open(uri + strlen(FILE_URI_PREFIX), O_RDONLY, 0);
+    if (fd < 0) {
+        return gcoap_response(pdu, buf, len, COAP_CODE_PATH_NOT_FOUND);
+    }
+    if ((vfs_fstat(fd, &st) < 0) ||
+        (vfs_lseek(fd, slicer.start, SEEK_SET) < 0)) {
+        vfs_close(fd);
+        return -1;
+    }
+    if ((size_t)st.st_size > slicer.start) {
+        blk_len = st.st_size - slicer.start;
+        if (blk_len > (slicer.end - slicer.start)) {
+            blk_len = slicer.end - slicer.start;
+        }
+    }
+
+    gcoap_resp_init(pdu, buf, len, COAP_CODE_CONTENT);
+    coap_opt_add_format(pdu, COAP_FORMAT_OCTET);
+    coap_opt_add_block2(pdu, &slicer, (size_t)st.st_size > slicer.end);
+    plen = coap_opt_finish(pdu, (blk_len > 0) ? COAP_OPT_FINISH_PAYLOAD
+                                              : COAP_OPT_FINISH_NONE);
+    if ((plen < 0) || (blk_len == 0)) {
+        vfs_close(fd);
+        return plen;
+    }
+
+#ifdef MODULE_GCOAP_SENDFILE
+    /* gcoap reads the block into the packet buffer and closes the file */
+    gcoap_resp_sendfile(fd, blk_len);
+#else
+    if (blk_len > pdu->payload_len) {
+        vfs_close(fd);
+        return -1;
+    }
+    ssize_t res = vfs_read(fd, pdu->payload, blk_len);
+    vfs_close(fd);
+    if (res < 0) {
+        return -1;
+    }
+    plen += res;
+#endif
+    return plen;
+}
+
+int main(void)
+{
+    /* for the thread running the shell */
+    msg_init_queue(_main_msg_queue, MAIN_QUEUE_SIZE);
+
+    if (vfs_mount(&_const_mount) < 0) {
+        puts("Error while mounting constfs");
+    }
+#if NVM_AVAILABLE
+    _nvm_desc.dev = MTD_0;
+    if ((vfs_mount(&_nvm_mount) < 0) &&
+        ((vfs_format(&_nvm_mount) < 0) || (vfs_mount(&_nvm_mount) < 0))) {
+        puts("Error while mounting littlefs2");
+    }
+#endif
+
+    gcoap_register_listener(&_listener);
+    puts("gcoap file server example app");
+
+    /* start shell */
+    puts("All up, running the shell now");
+    char line_buf[SHELL_DEFAULT_BUFSIZE];
+    shell_run(NULL, line_buf, SHELL_DEFAULT_BUFSIZE);
+
+    /* should never be reached */
+    return 0;
+}
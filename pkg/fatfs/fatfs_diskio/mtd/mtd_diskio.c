@@ -167,7 +167,10 @@ DRESULT disk_ioctl(BYTE pdrv, BYTE cmd, void *buff)
     switch (cmd) {
 #if (FF_FS_READONLY == 0)
         case CTRL_SYNC:
-            /* r/w is always finished within r/w-functions of mtd */
+            /* write data buffered by the mtd driver, if any */
+            if (mtd_flush(fatfs_mtd_devs[pdrv]) != 0) {
+                return RES_ERROR;
+            }
             return RES_OK;
 #endif
 
@@ -196,6 +196,15 @@ static int _close(vfs_file_t *filp)
     return fatfs_err_to_errno(res);
 }
 
+static int _fsync(vfs_file_t *filp)
+{
+    fatfs_file_desc_t *fd = (fatfs_file_desc_t *)filp->private_data.buffer;
+
+    DEBUG("fatfs_vfs.c: _fsync: private_data = %p\n", filp->mp->private_data);
+
+    return fatfs_err_to_errno(f_sync(&fd->file));
+}
+
 static ssize_t _write(vfs_file_t *filp, const void *src, size_t nbytes)
 {
     fatfs_file_desc_t *fd = (fatfs_file_desc_t *)filp->private_data.buffer;
@@ -450,6 +459,7 @@ static const vfs_file_system_ops_t fatfs_fs_ops = {
 static const vfs_file_ops_t fatfs_file_ops = {
     .open = _open,
     .close = _close,
+    .fsync = _fsync,
     .read = _read,
     .write = _write,
     .lseek = _lseek,
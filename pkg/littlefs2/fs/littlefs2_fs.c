@@ -114,9 +114,11 @@ static int _dev_erase(const struct lfs_config *c, lfs_block_t block)
 
 static int _dev_sync(const struct lfs_config *c)
 {
-    (void)c;
+    littlefs2_desc_t *fs = c->context;
 
-    return 0;
+    DEBUG("lfs_sync: c=%p\n", (void *)c);
+
+    return mtd_flush(fs->dev);
 }
 
 static int prepare(littlefs2_desc_t *fs)
@@ -339,6 +341,21 @@ static int _close(vfs_file_t *filp)
     return littlefs_err_to_errno(ret);
 }
 
+static int _fsync(vfs_file_t *filp)
+{
+    littlefs2_desc_t *fs = filp->mp->private_data;
+    lfs_file_t *fp = (lfs_file_t *)&filp->private_data.buffer;
+
+    mutex_lock(&fs->lock);
+
+    DEBUG("littlefs: fsync: filp=%p, fp=%p\n", (void *)filp, (void *)fp);
+
+    int ret = lfs_file_sync(&fs->fs, fp);
+    mutex_unlock(&fs->lock);
+
+    return littlefs_err_to_errno(ret);
+}
+
 static ssize_t _write(vfs_file_t *filp, const void *src, size_t nbytes)
 {
     littlefs2_desc_t *fs = filp->mp->private_data;
@@ -371,6 +388,62 @@ static ssize_t _read(vfs_file_t *filp, void *dest, size_t nbytes)
     return littlefs_err_to_errno(ret);
 }
 
+static ssize_t _writev(vfs_file_t *filp, const struct iovec *iov, int iovcnt)
+{
+    littlefs2_desc_t *fs = filp->mp->private_data;
+    lfs_file_t *fp = (lfs_file_t *)&filp->private_data.buffer;
+    ssize_t total = 0;
+
+    mutex_lock(&fs->lock);
+
+    DEBUG("littlefs: writev: filp=%p, fp=%p, iov=%p, iovcnt=%d\n",
+          (void *)filp, (void *)fp, (void *)iov, iovcnt);
+
+    /* the buffers are collected in the file cache, which is programmed when
+     * it is full, not once per buffer */
+    for (int i = 0; i < iovcnt; i++) {
+        ssize_t ret = lfs_file_write(&fs->fs, fp, iov[i].iov_base,
+                                     iov[i].iov_len);
+        if (ret < 0) {
+            mutex_unlock(&fs->lock);
+            return (total > 0) ? total : littlefs_err_to_errno(ret);
+        }
+        total += ret;
+    }
+    mutex_unlock(&fs->lock);
+
+    return total;
+}
+
+static ssize_t _readv(vfs_file_t *filp, const struct iovec *iov, int iovcnt)
+{
+    littlefs2_desc_t *fs = filp->mp->private_data;
+    lfs_file_t *fp = (lfs_file_t *)&filp->private_data.buffer;
+    ssize_t total = 0;
+
+    mutex_lock(&fs->lock);
+
+    DEBUG("littlefs: readv: filp=%p, fp=%p, iov=%p, iovcnt=%d\n",
+          (void *)filp, (void *)fp, (void *)iov, iovcnt);
+
+    for (int i = 0; i < iovcnt; i++) {
+        ssize_t ret = lfs_file_read(&fs->fs, fp, iov[i].iov_base,
+                                    iov[i].iov_len);
+        if (ret < 0) {
+            mutex_unlock(&fs->lock);
+            return (total > 0) ? total : littlefs_err_to_errno(ret);
+        }
+        total += ret;
+        if ((size_t)ret < iov[i].iov_len) {
+            /* end of file */
+            break;
+        }
+    }
+    mutex_unlock(&fs->lock);
+
+    return total;
+}
+
 static off_t _lseek(vfs_file_t *filp, off_t off, int whence)
 {
     littlefs2_desc_t *fs = filp->mp->private_data;
@@ -517,8 +590,11 @@ static const vfs_file_system_ops_t littlefs_fs_ops = {
 static const vfs_file_ops_t littlefs_file_ops = {
     .open = _open,
     .close = _close,
+    .fsync = _fsync,
     .read = _read,
     .write = _write,
+    .readv = _readv,
+    .writev = _writev,
     .lseek = _lseek,
 };
 
@@ -297,7 +297,22 @@ static int _close(vfs_file_t *filp)
 {
     spiffs_desc_t *fs_desc = filp->mp->private_data;
 
-    return spiffs_err_to_errno(SPIFFS_close(&fs_desc->fs, filp->private_data.value));
+    int ret = spiffs_err_to_errno(SPIFFS_close(&fs_desc->fs, filp->private_data.value));
+    if (ret == 0) {
+        ret = mtd_flush(fs_desc->dev);
+    }
+    return ret;
+}
+
+static int _fsync(vfs_file_t *filp)
+{
+    spiffs_desc_t *fs_desc = filp->mp->private_data;
+
+    int ret = spiffs_err_to_errno(SPIFFS_fflush(&fs_desc->fs, filp->private_data.value));
+    if (ret == 0) {
+        ret = mtd_flush(fs_desc->dev);
+    }
+    return ret;
 }
 
 static ssize_t _write(vfs_file_t *filp, const void *src, size_t nbytes)
@@ -503,6 +518,7 @@ static const vfs_file_system_ops_t spiffs_fs_ops = {
 static const vfs_file_ops_t spiffs_file_ops = {
     .open = _open,
     .close = _close,
+    .fsync = _fsync,
     .read = _read,
     .write = _write,
     .lseek = _lseek,
@@ -48,7 +48,9 @@ static const cipher_interface_t aes_interface = {
     AES_KEY_SIZE,
     aes_init,
     aes_encrypt,
-    aes_decrypt
+    aes_decrypt,
+    aes_encrypt_blocks,
+    aes_decrypt_blocks
 };
 const cipher_id_t CIPHER_AES_128 = &aes_interface;
 
@@ -796,9 +798,15 @@ static const u32 rcon[] = {
 };
 
 
+static int aes_set_encrypt_key(const unsigned char *userKey, const int bits,
+                               AES_KEY *key);
+static int aes_set_decrypt_key(const unsigned char *userKey, const int bits,
+                               AES_KEY *key);
+
 int aes_init(cipher_context_t *context, const uint8_t *key, uint8_t keySize)
 {
-    uint8_t i;
+    aes_context_t *ctx = (aes_context_t *)context->context;
+    AES_KEY aeskey;
 
     /* This implementation only supports a single key size (defined in AES_KEY_SIZE) */
     if (keySize != AES_KEY_SIZE) {
@@ -807,22 +815,19 @@ int aes_init(cipher_context_t *context, const uint8_t *key, uint8_t keySize)
 
     /* Make sure that context is large enough. If this is not the case,
        you should build with -DAES */
-    if (CIPHER_MAX_CONTEXT_SIZE < AES_KEY_SIZE) {
+    if (CIPHER_MAX_CONTEXT_SIZE < sizeof(aes_context_t)) {
         return CIPHER_ERR_BAD_CONTEXT_SIZE;
     }
 
-    /* key must be at least CIPHERS_MAX_KEY_SIZE Bytes long */
-    if (keySize < CIPHERS_MAX_KEY_SIZE) {
-        /* fill up by concatenating key to as long as needed */
-        for (i = 0; i < CIPHERS_MAX_KEY_SIZE; i++) {
-            context->context[i] = key[(i % keySize)];
-        }
+    /* expand both key schedules once, instead of for every block */
+    if (aes_set_encrypt_key(key, AES_KEY_SIZE * 8, &aeskey) < 0) {
+        return CIPHER_ERR_INVALID_KEY_SIZE;
     }
-    else {
-        for (i = 0; i < CIPHERS_MAX_KEY_SIZE; i++) {
-            context->context[i] = key[i];
-        }
+    memcpy(ctx->enc_key, aeskey.rd_key, sizeof(ctx->enc_key));
+    if (aes_set_decrypt_key(key, AES_KEY_SIZE * 8, &aeskey) < 0) {
+        return CIPHER_ERR_INVALID_KEY_SIZE;
     }
+    memcpy(ctx->dec_key, aeskey.rd_key, sizeof(ctx->dec_key));
 
     return CIPHER_INIT_SUCCESS;
 }
@@ -1025,31 +1030,17 @@ static int aes_set_decrypt_key(const unsigned char *userKey, const int bits,
 
 #ifndef AES_ASM
 /*
- * Encrypt a single block
+ * Encrypt a single block with the expanded key schedule rk
  * in and out can overlap
  */
-int aes_encrypt(const cipher_context_t *context, const uint8_t *plainBlock,
-                uint8_t *cipherBlock)
+static void aes_encrypt_block(const u32 *rk, const uint8_t *plainBlock,
+                              uint8_t *cipherBlock)
 {
-    /* setup AES_KEY */
-    int res;
-    AES_KEY aeskey;
-    const AES_KEY *key = &aeskey;
-
-    res = aes_set_encrypt_key((unsigned char *)context->context,
-                              AES_KEY_SIZE * 8, &aeskey);
-    if (res < 0) {
-        return res;
-    }
-
-    const u32 *rk;
     u32 s0, s1, s2, s3, t0, t1, t2, t3;
 #ifndef MODULE_CRYPTO_AES_UNROLL
     int r;
 #endif /* ?MODULE_CRYPTO_AES_UNROLL */
 
-    rk = key->rd_key;
-
     /*
      * map byte array block to cipher state
      * and add initial round key:
@@ -1141,7 +1132,7 @@ int aes_encrypt(const cipher_context_t *context, const uint8_t *plainBlock,
     t3 = Te0(s3 >> 24) ^ Te1((s0 >> 16) & 0xff) ^ Te2((s1 >>  8) & 0xff) ^
          Te3(s2 & 0xff) ^ rk[39];
 
-    if (key->rounds > 10) {
+    if (AES_ROUNDS > 10) {
         /* round 10: */
         s0 = Te0(t0 >> 24) ^ Te1((t1 >> 16) & 0xff) ^ Te2((t2 >>  8) & 0xff) ^
              Te3(t3 & 0xff) ^ rk[40];
@@ -1161,7 +1152,7 @@ int aes_encrypt(const cipher_context_t *context, const uint8_t *plainBlock,
         t3 = Te0(s3 >> 24) ^ Te1((s0 >> 16) & 0xff) ^ Te2((s1 >>  8) & 0xff) ^
              Te3(s2 & 0xff) ^ rk[47];
 
-        if (key->rounds > 12) {
+        if (AES_ROUNDS > 12) {
             /* round 12: */
             s0 = Te0(t0 >> 24) ^ Te1((t1 >> 16) & 0xff) ^ Te2((t2 >>  8) &
                                                               0xff) ^ Te3(
@@ -1191,12 +1182,12 @@ int aes_encrypt(const cipher_context_t *context, const uint8_t *plainBlock,
         }
     }
 
-    rk += key->rounds << 2;
+    rk += AES_ROUNDS << 2;
 #else  /* !MODULE_CRYPTO_AES_UNROLL */
     /*
      * Nr - 1 full rounds:
      */
-    r = key->rounds >> 1;
+    r = AES_ROUNDS >> 1;
 
     while (1) {
         t0 =
@@ -1289,36 +1280,20 @@ int aes_encrypt(const cipher_context_t *context, const uint8_t *plainBlock,
         (Te4((t2) & 0xff)       & 0x000000ff) ^
         rk[3];
     PUTU32(cipherBlock + 12, s3);
-    return 1;
 }
 
 /*
- * Decrypt a single block
+ * Decrypt a single block with the expanded key schedule rk
  * in and out can overlap
  */
-int aes_decrypt(const cipher_context_t *context, const uint8_t *cipherBlock,
-                uint8_t *plainBlock)
+static void aes_decrypt_block(const u32 *rk, const uint8_t *cipherBlock,
+                              uint8_t *plainBlock)
 {
-    /* setup AES_KEY */
-    int res;
-    AES_KEY aeskey;
-    const AES_KEY *key = &aeskey;
-
-    res = aes_set_decrypt_key((unsigned char *)context->context,
-                              AES_KEY_SIZE * 8, &aeskey);
-
-    if (res < 0) {
-        return res;
-    }
-
-    const u32 *rk;
     u32 s0, s1, s2, s3, t0, t1, t2, t3;
 #ifndef MODULE_CRYPTO_AES_UNROLL
     int r;
 #endif /* ?MODULE_CRYPTO_AES_UNROLL */
 
-    rk = key->rd_key;
-
     /*
      * map byte array block to cipher state
      * and add initial round key:
@@ -1410,7 +1385,7 @@ int aes_decrypt(const cipher_context_t *context, const uint8_t *cipherBlock,
     t3 = Td0(s3 >> 24) ^ Td1((s2 >> 16) & 0xff) ^ Td2((s1 >>  8) & 0xff) ^
          Td3(s0 & 0xff) ^ rk[39];
 
-    if (key->rounds > 10) {
+    if (AES_ROUNDS > 10) {
         /* round 10: */
         s0 = Td0(t0 >> 24) ^ Td1((t3 >> 16) & 0xff) ^ Td2((t2 >>  8) & 0xff) ^
              Td3(t1 & 0xff) ^ rk[40];
@@ -1430,7 +1405,7 @@ int aes_decrypt(const cipher_context_t *context, const uint8_t *cipherBlock,
         t3 = Td0(s3 >> 24) ^ Td1((s2 >> 16) & 0xff) ^ Td2((s1 >>  8) & 0xff) ^
              Td3(s0 & 0xff) ^ rk[47];
 
-        if (key->rounds > 12) {
+        if (AES_ROUNDS > 12) {
             /* round 12: */
             s0 = Td0(t0 >> 24) ^ Td1((t3 >> 16) & 0xff) ^ Td2((t2 >>  8) & 0xff)
                  ^ Td3(t1 & 0xff) ^ rk[48];
@@ -1452,12 +1427,12 @@ int aes_decrypt(const cipher_context_t *context, const uint8_t *cipherBlock,
         }
     }
 
-    rk += key->rounds << 2;
+    rk += AES_ROUNDS << 2;
 #else  /* !MODULE_CRYPTO_AES_UNROLL */
     /*
      * Nr - 1 full rounds:
      */
-    r = key->rounds >> 1;
+    r = AES_ROUNDS >> 1;
 
     while (1) {
         t0 =
@@ -1550,6 +1525,49 @@ int aes_decrypt(const cipher_context_t *context, const uint8_t *cipherBlock,
         (Td4((t0) & 0xff)       & 0x000000ff) ^
         rk[3];
     PUTU32(plainBlock + 12, s3);
+}
+
+int aes_encrypt(const cipher_context_t *context, const uint8_t *plainBlock,
+                uint8_t *cipherBlock)
+{
+    const aes_context_t *ctx = (const aes_context_t *)context->context;
+
+    aes_encrypt_block(ctx->enc_key, plainBlock, cipherBlock);
+    return 1;
+}
+
+int aes_decrypt(const cipher_context_t *context, const uint8_t *cipherBlock,
+                uint8_t *plainBlock)
+{
+    const aes_context_t *ctx = (const aes_context_t *)context->context;
+
+    aes_decrypt_block(ctx->dec_key, cipherBlock, plainBlock);
+    return 1;
+}
+
+int aes_encrypt_blocks(const cipher_context_t *context, const uint8_t *input,
+                       uint8_t *output, size_t blocks)
+{
+    const aes_context_t *ctx = (const aes_context_t *)context->context;
+
+    for (size_t i = 0; i < blocks; i++) {
+        aes_encrypt_block(ctx->enc_key, input, output);
+        input += AES_BLOCK_SIZE;
+        output += AES_BLOCK_SIZE;
+    }
+    return 1;
+}
+
+int aes_decrypt_blocks(const cipher_context_t *context, const uint8_t *input,
+                       uint8_t *output, size_t blocks)
+{
+    const aes_context_t *ctx = (const aes_context_t *)context->context;
+
+    for (size_t i = 0; i < blocks; i++) {
+        aes_decrypt_block(ctx->dec_key, input, output);
+        input += AES_BLOCK_SIZE;
+        output += AES_BLOCK_SIZE;
+    }
     return 1;
 }
 
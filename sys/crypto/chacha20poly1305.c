@@ -33,6 +33,8 @@
 #   error "This code is implementented in a way that it will only work for little-endian systems!"
 #endif
 
+#define CHACHA_BLOCK_SIZE   (64U)
+
 /* Nothing to hide here, Literally "expand 32-byte k" */
 static const uint32_t constant[] = {0x61707865,
                                     0x3320646e,
@@ -51,98 +53,148 @@ static uint32_t u8to32(const uint8_t *p)
         ((uint32_t)p[3] << 24));
 }
 
-/* Single round */
-void _r(uint32_t *a, uint32_t *b, uint32_t *d, unsigned c)
+static inline uint32_t _rotl(uint32_t x, unsigned c)
 {
-    *a += *b;
-    uint32_t tmp = *a ^ *d;
-    *d = (tmp << c) | (tmp >> (32 - c));
+    return (x << c) | (x >> (32 - c));
 }
 
-void _add_initial(chacha20poly1305_ctx_t *ctx, const uint8_t *key,
-                  const uint8_t *nonce, uint32_t blk)
+/* Quarter round on the same four words of @p n interleaved blocks. The lanes
+ * of the inner loop are independent, which allows the compiler to map them
+ * onto SIMD registers if the target has them. */
+static inline void _qr(uint32_t *a, uint32_t *b, uint32_t *c, uint32_t *d,
+                       unsigned n)
 {
-    for (unsigned i = 0; i < 4; i++) {
-        ctx->state[i] += constant[i];
+    for (unsigned j = 0; j < n; j++) {
+        a[j] += b[j]; d[j] = _rotl(d[j] ^ a[j], 16);
+        c[j] += d[j]; b[j] = _rotl(b[j] ^ c[j], 12);
+        a[j] += b[j]; d[j] = _rotl(d[j] ^ a[j], 8);
+        c[j] += d[j]; b[j] = _rotl(b[j] ^ c[j], 7);
     }
-    for (unsigned i = 0; i < 8; i++) {
-        ctx->state[i+4] += u8to32(key + 4*i);
+}
+
+/* Generate @p n consecutive key stream blocks and advance the block counter */
+static void _keystream(chacha20poly1305_ctx_t *ctx, unsigned n)
+{
+    uint32_t x[16][CHACHA20POLY1305_BLOCKS];
+
+    for (unsigned i = 0; i < 16; i++) {
+        for (unsigned j = 0; j < n; j++) {
+            x[i][j] = ctx->state[i];
+        }
     }
-    ctx->state[12] += u8to32((uint8_t*)&blk);
-    ctx->state[13] += u8to32(nonce);
-    ctx->state[14] += u8to32(nonce+4);
-    ctx->state[15] += u8to32(nonce+8);
+    for (unsigned j = 0; j < n; j++) {
+        x[12][j] += j;
+    }
+
+    for (unsigned i = 0; i < 10; i++) {
+        _qr(x[0], x[4], x[8],  x[12], n);
+        _qr(x[1], x[5], x[9],  x[13], n);
+        _qr(x[2], x[6], x[10], x[14], n);
+        _qr(x[3], x[7], x[11], x[15], n);
+        _qr(x[0], x[5], x[10], x[15], n);
+        _qr(x[1], x[6], x[11], x[12], n);
+        _qr(x[2], x[7], x[8],  x[13], n);
+        _qr(x[3], x[4], x[9],  x[14], n);
+    }
+
+    for (unsigned j = 0; j < n; j++) {
+        for (unsigned i = 0; i < 16; i++) {
+            ctx->stream[16 * j + i] = x[i][j] + ctx->state[i];
+        }
+        ctx->stream[16 * j + 12] += j;
+    }
+    ctx->state[12] += n;
+    ctx->pos = 0;
+    ctx->len = n * CHACHA_BLOCK_SIZE;
+    crypto_secure_wipe(x, sizeof(x));
+}
+
+/* Number of blocks to generate to cover @p len bytes, at most the number that
+ * fits into the key stream buffer */
+static unsigned _blocks(size_t len)
+{
+    size_t n = (len + CHACHA_BLOCK_SIZE - 1) / CHACHA_BLOCK_SIZE;
+
+    return (n < CHACHA20POLY1305_BLOCKS) ? n : CHACHA20POLY1305_BLOCKS;
 }
 
-void _keystream(chacha20poly1305_ctx_t *ctx, const uint8_t *key,
-                const uint8_t *nonce, uint32_t blk)
+/* Set up the state, derive the poly1305 key from block 0 and keep the rest
+ * of the generated blocks for the first @p len bytes of the message */
+static void _init(chacha20poly1305_ctx_t *ctx, const uint8_t *key,
+                  const uint8_t *nonce, size_t len)
 {
-    /* Initialize block state */
-    memset(ctx->state, 0, sizeof(ctx->state));
-    _add_initial(ctx, key, nonce, blk);
-
-    /* perform rounds */
-    for (unsigned i = 0; i < 80; ++i) {
-        uint32_t *a = &ctx->state[((i                    ) & 3)          ];
-        uint32_t *b = &ctx->state[((i + ((i & 4) ? 1 : 0)) & 3) + (4 * 1)];
-        uint32_t *c = &ctx->state[((i + ((i & 4) ? 2 : 0)) & 3) + (4 * 2)];
-        uint32_t *d = &ctx->state[((i + ((i & 4) ? 3 : 0)) & 3) + (4 * 3)];
-        _r(a, b, d, 16);
-        _r(c, d, b, 12);
-        _r(a, b, d, 8);
-        _r(c, d, b, 7);
+    for (unsigned i = 0; i < 4; i++) {
+        ctx->state[i] = constant[i];
+    }
+    for (unsigned i = 0; i < 8; i++) {
+        ctx->state[i + 4] = u8to32(key + 4 * i);
+    }
+    ctx->state[12] = 0;
+    for (unsigned i = 0; i < 3; i++) {
+        ctx->state[i + 13] = u8to32(nonce + 4 * i);
     }
-    /* add initial state */
-    _add_initial(ctx, key, nonce, blk);
+
+    _keystream(ctx, _blocks(len + CHACHA_BLOCK_SIZE));
+    poly1305_init(&ctx->poly, (uint8_t *)ctx->stream);
+    ctx->pos = CHACHA_BLOCK_SIZE;
 }
 
-void _xcrypt(chacha20poly1305_ctx_t *ctx, const uint8_t *key,
-              const uint8_t *nonce, const uint8_t *in, uint8_t *out, size_t len)
+/* XOR the key stream onto @p in. If @p mac is set, the output is added to the
+ * MAC right away, while it is still in cache. */
+static void _xcrypt(chacha20poly1305_ctx_t *ctx, const uint8_t *in,
+                    uint8_t *out, size_t len, poly1305_ctx_t *mac)
 {
-    /* Number of full 64 byte blocks */
-    const size_t num_blocks = len >> 6;
-    size_t pos = 0;
-    /* xcrypt full blocks */
-    for (size_t i = 0; i < num_blocks; i++, pos += 64) {
-        _keystream(ctx, key, nonce, i+1);
-        for (size_t j = 0; j < 64; j++) {
-            out[pos+j] = in[pos+j] ^ ((uint8_t*)ctx->state)[j];
+    while (len) {
+        if (ctx->pos == ctx->len) {
+            _keystream(ctx, _blocks(len));
         }
-    }
-    /* xcrypt remaining bytes */
-    if (len - pos) {
-        _keystream(ctx, key, nonce, num_blocks+1);
-        for (size_t j = 0; j < len - pos; j++) {
-            out[pos+j] = in[pos+j] ^ ((uint8_t*)ctx->state)[j];
+        const uint8_t *stream = (uint8_t *)ctx->stream + ctx->pos;
+        size_t chunk = ctx->len - ctx->pos;
+        if (chunk > len) {
+            chunk = len;
         }
+        size_t i = 0;
+        for (; i + sizeof(uint32_t) <= chunk; i += sizeof(uint32_t)) {
+            uint32_t a, b;
+            memcpy(&a, in + i, sizeof(a));
+            memcpy(&b, stream + i, sizeof(b));
+            a ^= b;
+            memcpy(out + i, &a, sizeof(a));
+        }
+        for (; i < chunk; i++) {
+            out[i] = in[i] ^ stream[i];
+        }
+        if (mac) {
+            poly1305_update(mac, out, chunk);
+        }
+        ctx->pos += chunk;
+        in += chunk;
+        out += chunk;
+        len -= chunk;
     }
 }
 
-void _poly1305_padded(poly1305_ctx_t *pctx, const uint8_t *data, size_t len)
+static void _poly1305_pad(poly1305_ctx_t *pctx, size_t len)
 {
-    poly1305_update(pctx, data, len);
     const size_t padlen = (16 - len) & 0xF;
     poly1305_update(pctx, padding, padlen);
 }
 
-/* Generate a poly1305 tag */
-void _poly1305_gentag(uint8_t *mac, const uint8_t *key, const uint8_t *nonce,
-                      const uint8_t *cipher, size_t cipherlen,
-                      const uint8_t *aad, size_t aadlen)
+static void _poly1305_padded(poly1305_ctx_t *pctx, const uint8_t *data,
+                             size_t len)
 {
-    chacha20poly1305_ctx_t ctx;
-    /* generate one time key */
-    _keystream(&ctx, key, nonce, 0);
-    poly1305_init(&ctx.poly, (uint8_t*)ctx.state);
-    /* Add aad */
-    _poly1305_padded(&ctx.poly, aad, aadlen);
-    /* Add ciphertext */
-    _poly1305_padded(&ctx.poly, cipher, cipherlen);
-    /* Add aad length */
+    poly1305_update(pctx, data, len);
+    _poly1305_pad(pctx, len);
+}
+
+/* Add the lengths and generate the poly1305 tag */
+static void _poly1305_finish(poly1305_ctx_t *pctx, uint8_t *mac,
+                             size_t aadlen, size_t cipherlen)
+{
+    _poly1305_pad(pctx, cipherlen);
     const uint64_t lengths[2] = {aadlen, cipherlen};
-    poly1305_update(&ctx.poly, (uint8_t*)lengths, sizeof(lengths));
-    poly1305_finish(&ctx.poly, mac);
-    crypto_secure_wipe(&ctx, sizeof(ctx));
+    poly1305_update(pctx, (uint8_t*)lengths, sizeof(lengths));
+    poly1305_finish(pctx, mac);
 }
 
 void chacha20poly1305_encrypt(uint8_t *cipher, const uint8_t *msg,
@@ -150,12 +202,14 @@ void chacha20poly1305_encrypt(uint8_t *cipher, const uint8_t *msg,
                               const uint8_t *key, const uint8_t *nonce)
 {
     chacha20poly1305_ctx_t ctx;
-    _xcrypt(&ctx, key, nonce, msg, cipher, msglen);
-    crypto_secure_wipe(&ctx, sizeof(ctx));
-    /* Generate tag */
-    _poly1305_gentag(&cipher[msglen], key, nonce,
-                    cipher, msglen, aad, aadlen);
+
+    _init(&ctx, key, nonce, msglen);
+    _poly1305_padded(&ctx.poly, aad, aadlen);
+    /* encrypt and authenticate in one pass */
+    _xcrypt(&ctx, msg, cipher, msglen, &ctx.poly);
+    _poly1305_finish(&ctx.poly, &cipher[msglen], aadlen, msglen);
     /* Wipe structures */
+    crypto_secure_wipe(&ctx, sizeof(ctx));
 }
 
 int chacha20poly1305_decrypt(const uint8_t *cipher, size_t cipherlen,
@@ -163,15 +217,70 @@ int chacha20poly1305_decrypt(const uint8_t *cipher, size_t cipherlen,
                              const uint8_t *aad, size_t aadlen,
                              const uint8_t *key, const uint8_t *nonce)
 {
+    chacha20poly1305_ctx_t ctx;
+    uint8_t mac[CHACHA20POLY1305_TAG_BYTES];
+    int res = 0;
+
     *msglen = cipherlen - CHACHA20POLY1305_TAG_BYTES;
-    uint8_t mac[16];
-    _poly1305_gentag(mac, key, nonce, cipher,
-                     cipherlen - CHACHA20POLY1305_TAG_BYTES, aad, aadlen);
-    if (crypto_equals(cipher+*msglen, mac, CHACHA20POLY1305_TAG_BYTES) == 0) {
-        return 0;
+    _init(&ctx, key, nonce, *msglen);
+    _poly1305_padded(&ctx.poly, aad, aadlen);
+    poly1305_update(&ctx.poly, cipher, *msglen);
+    _poly1305_finish(&ctx.poly, mac, aadlen, *msglen);
+    /* only decrypt if the tag matches, the key stream generated for the
+     * poly1305 key is used for the first blocks */
+    if (crypto_equals(cipher + *msglen, mac, CHACHA20POLY1305_TAG_BYTES)) {
+        _xcrypt(&ctx, cipher, msg, *msglen, NULL);
+        res = 1;
+    }
+    crypto_secure_wipe(&ctx, sizeof(ctx));
+    return res;
+}
+
+void chacha20poly1305_encrypt_iol(const iolist_t *iolist, uint8_t *tag,
+                                  const uint8_t *aad, size_t aadlen,
+                                  const uint8_t *key, const uint8_t *nonce)
+{
+    chacha20poly1305_ctx_t ctx;
+    size_t len = 0;
+
+    for (const iolist_t *iol = iolist; iol; iol = iol->iol_next) {
+        len += iol->iol_len;
+    }
+
+    _init(&ctx, key, nonce, len);
+    _poly1305_padded(&ctx.poly, aad, aadlen);
+    for (const iolist_t *iol = iolist; iol; iol = iol->iol_next) {
+        _xcrypt(&ctx, iol->iol_base, iol->iol_base, iol->iol_len, &ctx.poly);
     }
+    _poly1305_finish(&ctx.poly, tag, aadlen, len);
+    crypto_secure_wipe(&ctx, sizeof(ctx));
+}
+
+int chacha20poly1305_decrypt_iol(const iolist_t *iolist, const uint8_t *tag,
+                                 const uint8_t *aad, size_t aadlen,
+                                 const uint8_t *key, const uint8_t *nonce)
+{
     chacha20poly1305_ctx_t ctx;
-    /* Number of full blocks */
-    _xcrypt(&ctx, key, nonce, cipher, msg, *msglen);
-    return 1;
+    uint8_t mac[CHACHA20POLY1305_TAG_BYTES];
+    size_t len = 0;
+    int res = 0;
+
+    for (const iolist_t *iol = iolist; iol; iol = iol->iol_next) {
+        len += iol->iol_len;
+    }
+
+    _init(&ctx, key, nonce, len);
+    _poly1305_padded(&ctx.poly, aad, aadlen);
+    for (const iolist_t *iol = iolist; iol; iol = iol->iol_next) {
+        poly1305_update(&ctx.poly, iol->iol_base, iol->iol_len);
+    }
+    _poly1305_finish(&ctx.poly, mac, aadlen, len);
+    if (crypto_equals(tag, mac, CHACHA20POLY1305_TAG_BYTES)) {
+        for (const iolist_t *iol = iolist; iol; iol = iol->iol_next) {
+            _xcrypt(&ctx, iol->iol_base, iol->iol_base, iol->iol_len, NULL);
+        }
+        res = 1;
+    }
+    crypto_secure_wipe(&ctx, sizeof(ctx));
+    return res;
 }
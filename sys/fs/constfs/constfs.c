@@ -38,12 +38,15 @@ static int constfs_umount(vfs_mount_t *mountp);
 static int constfs_unlink(vfs_mount_t *mountp, const char *name);
 static int constfs_stat(vfs_mount_t *mountp, const char *restrict name, struct stat *restrict buf);
 static int constfs_statvfs(vfs_mount_t *mountp, const char *restrict path, struct statvfs *restrict buf);
+static int constfs_lookup(vfs_mount_t *mountp, const char *path, uintptr_t *handle);
+static int constfs_stat_handle(vfs_mount_t *mountp, uintptr_t handle, struct stat *buf);
 
 /* File operations */
 static int constfs_close(vfs_file_t *filp);
 static int constfs_fstat(vfs_file_t *filp, struct stat *buf);
 static off_t constfs_lseek(vfs_file_t *filp, off_t off, int whence);
 static int constfs_open(vfs_file_t *filp, const char *name, int flags, mode_t mode, const char *abs_path);
+static int constfs_open_handle(vfs_file_t *filp, uintptr_t handle, int flags, mode_t mode);
 static ssize_t constfs_read(vfs_file_t *filp, void *dest, size_t nbytes);
 static ssize_t constfs_write(vfs_file_t *filp, const void *src, size_t nbytes);
 
@@ -58,6 +61,8 @@ static const vfs_file_system_ops_t constfs_fs_ops = {
     .unlink = constfs_unlink,
     .statvfs = constfs_statvfs,
     .stat = constfs_stat,
+    .lookup = constfs_lookup,
+    .stat_handle = constfs_stat_handle,
 };
 
 static const vfs_file_ops_t constfs_file_ops = {
@@ -65,6 +70,7 @@ static const vfs_file_ops_t constfs_file_ops = {
     .fstat = constfs_fstat,
     .lseek = constfs_lseek,
     .open  = constfs_open,
+    .open_handle = constfs_open_handle,
     .read  = constfs_read,
     .write = constfs_write,
 };
@@ -136,6 +142,33 @@ static int constfs_stat(vfs_mount_t *mountp, const char *restrict name, struct s
     return -ENOENT;
 }
 
+static int constfs_lookup(vfs_mount_t *mountp, const char *path, uintptr_t *handle)
+{
+    constfs_t *fs = mountp->private_data;
+    /* the handle is the index into the files array */
+    for (size_t i = 0; i < fs->nfiles; ++i) {
+        if (strcmp(fs->files[i].path, path) == 0) {
+            *handle = i;
+            return 0;
+        }
+    }
+    return -ENOENT;
+}
+
+static int constfs_stat_handle(vfs_mount_t *mountp, uintptr_t handle, struct stat *buf)
+{
+    constfs_t *fs = mountp->private_data;
+    if (buf == NULL) {
+        return -EFAULT;
+    }
+    if (handle >= fs->nfiles) {
+        return -ENOENT;
+    }
+    _constfs_write_stat(&fs->files[handle], buf);
+    buf->st_ino = handle;
+    return 0;
+}
+
 static int constfs_statvfs(vfs_mount_t *mountp, const char *restrict path, struct statvfs *restrict buf)
 {
     (void) path;
@@ -228,6 +261,22 @@ static int constfs_open(vfs_file_t *filp, const char *name, int flags, mode_t mo
     return -ENOENT;
 }
 
+static int constfs_open_handle(vfs_file_t *filp, uintptr_t handle, int flags, mode_t mode)
+{
+    (void) mode;
+    constfs_t *fs = filp->mp->private_data;
+    DEBUG("constfs_open_handle: %p, %lu, 0x%x\n", (void *)filp, (unsigned long)handle, flags);
+    /* We only support read access */
+    if ((flags & O_ACCMODE) != O_RDONLY) {
+        return -EROFS;
+    }
+    if (handle >= fs->nfiles) {
+        return -ENOENT;
+    }
+    filp->private_data.ptr = (void *)&fs->files[handle];
+    return 0;
+}
+
 static ssize_t constfs_read(vfs_file_t *filp, void *dest, size_t nbytes)
 {
     constfs_file_t *fp = filp->private_data.ptr;
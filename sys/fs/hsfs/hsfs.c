@@ -0,0 +1,558 @@
+/*
+ * Copyright (C) 2020 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     sys_fs_hsfs
+ * @{
+ *
+ * @file
+ * @brief       HSFS implementation
+ *
+ * @}
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "byteorder.h"
+#include "fs/hsfs.h"
+#include "vfs.h"
+
+#define ENABLE_DEBUG (0)
+#include "debug.h"
+
+#define HSFS_MAGIC          "HSFS"
+#define HSFS_VERSION        (1U)
+#define HSFS_HEADER_SIZE    (16U)
+#define HSFS_ENTRY_SIZE     (16U)
+
+/* chunk size for comparing paths stored on MTD */
+#define HSFS_NAME_CHUNK     (16U)
+
+static int _img_read(hsfs_t *fs, uint32_t addr, void *dest, uint32_t len)
+{
+    if ((addr > fs->size) || (len > (fs->size - addr))) {
+        return -EIO;
+    }
+    if (fs->image != NULL) {
+        memcpy(dest, fs->image + addr, len);
+        return 0;
+    }
+#if IS_USED(MODULE_HSFS_MTD)
+    return mtd_read(fs->mtd, dest, fs->mtd_offset + addr, len);
+#else
+    return -ENODEV;
+#endif
+}
+
+static uint32_t _hash(const char *path)
+{
+    /* FNV-1a, as used by mkhsfs.py */
+    uint32_t hash = 2166136261U;
+
+    for (; *path != '\0'; path++) {
+        hash = (hash ^ (uint8_t)*path) * 16777619U;
+    }
+    return hash;
+}
+
+static int _entry(hsfs_t *fs, unsigned idx, hsfs_entry_t *entry)
+{
+    uint8_t buf[HSFS_ENTRY_SIZE];
+    int res = _img_read(fs, HSFS_HEADER_SIZE + idx * HSFS_ENTRY_SIZE,
+                        buf, sizeof(buf));
+
+    if (res < 0) {
+        return res;
+    }
+    entry->hash = byteorder_bebuftohl(&buf[0]);
+    entry->name = byteorder_bebuftohl(&buf[4]);
+    entry->size = byteorder_bebuftohl(&buf[8]);
+    entry->table = byteorder_bebuftohl(&buf[12]);
+    return 0;
+}
+
+/* returns 0 if the path stored at addr equals path */
+static int _name_cmp(hsfs_t *fs, uint32_t addr, const char *path)
+{
+    size_t len = strlen(path) + 1;
+
+    if (fs->image != NULL) {
+        if ((addr > fs->size) || (len > (fs->size - addr))) {
+            return 1;
+        }
+        return memcmp(fs->image + addr, path, len);
+    }
+    while (len > 0) {
+        char buf[HSFS_NAME_CHUNK];
+        size_t n = (len < sizeof(buf)) ? len : sizeof(buf);
+
+        if ((_img_read(fs, addr, buf, n) < 0) || (memcmp(buf, path, n) != 0)) {
+            return 1;
+        }
+        addr += n;
+        path += n;
+        len -= n;
+    }
+    return 0;
+}
+
+static int _find(hsfs_t *fs, const char *path, hsfs_entry_t *entry)
+{
+    uint32_t hash = _hash(path);
+    unsigned lo = 0;
+    unsigned hi = fs->nfiles;
+    int res;
+
+    /* the index is sorted by hash, find the first entry with this hash */
+    while (lo < hi) {
+        unsigned mid = lo + (hi - lo) / 2;
+
+        res = _entry(fs, mid, entry);
+        if (res < 0) {
+            return res;
+        }
+        if (entry->hash < hash) {
+            lo = mid + 1;
+        }
+        else {
+            hi = mid;
+        }
+    }
+    for (; lo < fs->nfiles; lo++) {
+        res = _entry(fs, lo, entry);
+        if (res < 0) {
+            return res;
+        }
+        if (entry->hash != hash) {
+            break;
+        }
+        if (_name_cmp(fs, entry->name, path) == 0) {
+            DEBUG("hsfs: found \"%s\" at %u\n", path, lo);
+            return lo;
+        }
+    }
+    DEBUG("hsfs: \"%s\" not found\n", path);
+    return -ENOENT;
+}
+
+static int _inflate(hsfs_t *fs, uint32_t addr, uint32_t clen, uint16_t len)
+{
+    size_t done = 0;
+    uint8_t *in = NULL;
+    size_t avail = 0;
+
+    heatshrink_decoder_reset(&fs->dec);
+    while (done < len) {
+        size_t n;
+
+        if ((avail == 0) && (clen > 0)) {
+            if (fs->image != NULL) {
+                /* the decoder only copies from the input */
+                in = (uint8_t *)fs->image + addr;
+                avail = clen;
+            }
+#if IS_USED(MODULE_HSFS_MTD)
+            else {
+                avail = (clen < sizeof(fs->in)) ? clen : sizeof(fs->in);
+                int res = _img_read(fs, addr, fs->in, avail);
+                if (res < 0) {
+                    return res;
+                }
+                in = fs->in;
+            }
+#endif
+            addr += avail;
+            clen -= avail;
+        }
+        if (avail > 0) {
+            if (heatshrink_decoder_sink(&fs->dec, in, avail, &n) < 0) {
+                return -EIO;
+            }
+            in += n;
+            avail -= n;
+        }
+
+        size_t polled = 0;
+        HSD_poll_res pres;
+        do {
+            pres = heatshrink_decoder_poll(&fs->dec, &fs->block[done],
+                                           len - done, &n);
+            if (pres < 0) {
+                return -EIO;
+            }
+            done += n;
+            polled += n;
+        } while ((pres == HSDR_POLL_MORE) && (done < len));
+
+        if ((polled == 0) && (avail == 0) && (clen == 0) && (done < len)) {
+            /* input exhausted, but the block is incomplete */
+            DEBUG("hsfs: truncated block\n");
+            return -EIO;
+        }
+    }
+    return 0;
+}
+
+/* makes block blk of the file at idx the cached block */
+static int _load_block(hsfs_t *fs, int idx, const hsfs_entry_t *entry,
+                       uint32_t blk)
+{
+    uint8_t buf[8];
+    uint32_t block_size = 1UL << fs->block_shift;
+    uint32_t offset = blk << fs->block_shift;
+    uint32_t len = entry->size - offset;
+    int res;
+
+    if ((fs->entry_idx == idx) && (fs->block_len > 0) &&
+        (fs->block_idx == blk)) {
+        return 0;
+    }
+    if (len > block_size) {
+        len = block_size;
+    }
+    res = _img_read(fs, entry->table + blk * 4, buf, sizeof(buf));
+    if (res < 0) {
+        return res;
+    }
+    uint32_t start = byteorder_bebuftohl(&buf[0]);
+    uint32_t end = byteorder_bebuftohl(&buf[4]);
+    if ((end < start) || ((end - start) > len) || (end > fs->size)) {
+        return -EIO;
+    }
+
+    fs->block_len = 0;
+    if ((end - start) == len) {
+        /* block did not shrink and is stored as it is */
+        res = _img_read(fs, start, fs->block, len);
+    }
+    else {
+        res = _inflate(fs, start, end - start, len);
+    }
+    if (res < 0) {
+        fs->entry_idx = -1;
+        return res;
+    }
+    fs->entry_idx = idx;
+    fs->entry = *entry;
+    fs->block_idx = blk;
+    fs->block_len = len;
+    return 0;
+}
+
+static void _write_stat(const hsfs_t *fs, unsigned idx,
+                        const hsfs_entry_t *entry, struct stat *buf)
+{
+    memset(buf, 0, sizeof(*buf));
+    buf->st_ino = idx;
+    buf->st_nlink = 1;
+    buf->st_mode = S_IFREG | S_IRUSR | S_IRGRP | S_IROTH;
+    buf->st_size = entry->size;
+    buf->st_blksize = 1UL << fs->block_shift;
+    buf->st_blocks = (entry->size + buf->st_blksize - 1) >> fs->block_shift;
+}
+
+static int _mount(vfs_mount_t *mountp)
+{
+    hsfs_t *fs = mountp->private_data;
+    uint8_t hdr[HSFS_HEADER_SIZE];
+    int res;
+
+    mutex_init(&fs->lock);
+    fs->entry_idx = -1;
+    fs->block_len = 0;
+    fs->size = sizeof(hdr);
+#if IS_USED(MODULE_HSFS_MTD)
+    if ((fs->image == NULL) && (fs->mtd == NULL)) {
+        return -EINVAL;
+    }
+#else
+    if (fs->image == NULL) {
+        return -EINVAL;
+    }
+#endif
+    res = _img_read(fs, 0, hdr, sizeof(hdr));
+    if (res < 0) {
+        return res;
+    }
+    if ((memcmp(hdr, HSFS_MAGIC, 4) != 0) || (hdr[4] != HSFS_VERSION)) {
+        DEBUG("hsfs: no image\n");
+        return -EINVAL;
+    }
+    if ((hdr[5] != HEATSHRINK_STATIC_WINDOW_BITS) ||
+        (hdr[6] != HEATSHRINK_STATIC_LOOKAHEAD_BITS) ||
+        ((1UL << hdr[7]) > CONFIG_HSFS_BLOCK_SIZE_MAX)) {
+        DEBUG("hsfs: unsupported parameters %u %u %u\n", hdr[5], hdr[6],
+              hdr[7]);
+        return -ENOTSUP;
+    }
+    fs->block_shift = hdr[7];
+    fs->nfiles = byteorder_bebuftohs(&hdr[8]);
+    fs->size = byteorder_bebuftohl(&hdr[12]);
+    if (fs->size < (HSFS_HEADER_SIZE + fs->nfiles * HSFS_ENTRY_SIZE)) {
+        return -EINVAL;
+    }
+    DEBUG("hsfs: %u files, %lu bytes\n", fs->nfiles, (unsigned long)fs->size);
+    return 0;
+}
+
+static int _stat(vfs_mount_t *mountp, const char *restrict name,
+                 struct stat *restrict buf)
+{
+    hsfs_t *fs = mountp->private_data;
+    hsfs_entry_t entry;
+    int idx = _find(fs, name, &entry);
+
+    if (idx < 0) {
+        return idx;
+    }
+    _write_stat(fs, idx, &entry, buf);
+    return 0;
+}
+
+static int _statvfs(vfs_mount_t *mountp, const char *restrict path,
+                    struct statvfs *restrict buf)
+{
+    (void)path;
+    hsfs_t *fs = mountp->private_data;
+
+    memset(buf, 0, sizeof(*buf));
+    buf->f_bsize = sizeof(uint8_t);
+    buf->f_frsize = sizeof(uint8_t);
+    buf->f_blocks = fs->size;
+    buf->f_files = fs->nfiles;
+    buf->f_flag = (ST_RDONLY | ST_NOSUID);
+    buf->f_namemax = VFS_NAME_MAX;
+    return 0;
+}
+
+static int _lookup(vfs_mount_t *mountp, const char *path, uintptr_t *handle)
+{
+    hsfs_entry_t entry;
+    int idx = _find(mountp->private_data, path, &entry);
+
+    if (idx < 0) {
+        return idx;
+    }
+    *handle = idx;
+    return 0;
+}
+
+static int _stat_handle(vfs_mount_t *mountp, uintptr_t handle,
+                        struct stat *buf)
+{
+    hsfs_t *fs = mountp->private_data;
+    hsfs_entry_t entry;
+    int res;
+
+    if (handle >= fs->nfiles) {
+        return -ENOENT;
+    }
+    res = _entry(fs, handle, &entry);
+    if (res < 0) {
+        return res;
+    }
+    _write_stat(fs, handle, &entry, buf);
+    return 0;
+}
+
+static int _open(vfs_file_t *filp, const char *name, int flags, mode_t mode,
+                 const char *abs_path)
+{
+    (void)mode;
+    (void)abs_path;
+    hsfs_entry_t entry;
+
+    if ((flags & O_ACCMODE) != O_RDONLY) {
+        return -EROFS;
+    }
+    int idx = _find(filp->mp->private_data, name, &entry);
+    if (idx < 0) {
+        return idx;
+    }
+    filp->private_data.value = idx;
+    return 0;
+}
+
+static int _open_handle(vfs_file_t *filp, uintptr_t handle, int flags,
+                        mode_t mode)
+{
+    (void)mode;
+    hsfs_t *fs = filp->mp->private_data;
+
+    if ((flags & O_ACCMODE) != O_RDONLY) {
+        return -EROFS;
+    }
+    if (handle >= fs->nfiles) {
+        return -ENOENT;
+    }
+    filp->private_data.value = handle;
+    return 0;
+}
+
+static int _fstat(vfs_file_t *filp, struct stat *buf)
+{
+    return _stat_handle(filp->mp, filp->private_data.value, buf);
+}
+
+static off_t _lseek(vfs_file_t *filp, off_t off, int whence)
+{
+    hsfs_entry_t entry;
+    int res;
+
+    switch (whence) {
+        case SEEK_SET:
+            break;
+        case SEEK_CUR:
+            off += filp->pos;
+            break;
+        case SEEK_END:
+            res = _entry(filp->mp->private_data, filp->private_data.value,
+                         &entry);
+            if (res < 0) {
+                return res;
+            }
+            off += entry.size;
+            break;
+        default:
+            return -EINVAL;
+    }
+    if (off < 0) {
+        return -EINVAL;
+    }
+    /* nothing is decompressed before the next read */
+    filp->pos = off;
+    return off;
+}
+
+static ssize_t _read(vfs_file_t *filp, void *dest, size_t nbytes)
+{
+    hsfs_t *fs = filp->mp->private_data;
+    int idx = filp->private_data.value;
+    uint8_t *ptr = dest;
+    hsfs_entry_t entry;
+    int res = 0;
+
+    mutex_lock(&fs->lock);
+    if (fs->entry_idx == idx) {
+        entry = fs->entry;
+    }
+    else {
+        res = _entry(fs, idx, &entry);
+    }
+    if ((res < 0) || ((uint32_t)filp->pos >= entry.size)) {
+        mutex_unlock(&fs->lock);
+        return res;
+    }
+    if (nbytes > (size_t)(entry.size - filp->pos)) {
+        nbytes = entry.size - filp->pos;
+    }
+    while (nbytes > 0) {
+        uint32_t blk = filp->pos >> fs->block_shift;
+        uint32_t offset = filp->pos - (blk << fs->block_shift);
+
+        res = _load_block(fs, idx, &entry, blk);
+        if (res < 0) {
+            break;
+        }
+        size_t n = fs->block_len - offset;
+        if (n > nbytes) {
+            n = nbytes;
+        }
+        memcpy(ptr, &fs->block[offset], n);
+        ptr += n;
+        nbytes -= n;
+        filp->pos += n;
+    }
+    mutex_unlock(&fs->lock);
+    if ((res < 0) && (ptr == dest)) {
+        return res;
+    }
+    return ptr - (uint8_t *)dest;
+}
+
+static ssize_t _write(vfs_file_t *filp, const void *src, size_t nbytes)
+{
+    (void)filp;
+    (void)src;
+    (void)nbytes;
+    return -EBADF;
+}
+
+static int _opendir(vfs_DIR *dirp, const char *dirname, const char *abs_path)
+{
+    (void)abs_path;
+    if (strncmp(dirname, "/", 2) != 0) {
+        /* flat file system, only the root directory exists */
+        return -ENOENT;
+    }
+    dirp->private_data.value = 0;
+    return 0;
+}
+
+static int _readdir(vfs_DIR *dirp, vfs_dirent_t *entry)
+{
+    hsfs_t *fs = dirp->mp->private_data;
+    unsigned idx = dirp->private_data.value;
+    hsfs_entry_t e;
+    int res;
+
+    if (idx >= fs->nfiles) {
+        /* End of stream */
+        return 0;
+    }
+    dirp->private_data.value = idx + 1;
+    res = _entry(fs, idx, &e);
+    if (res < 0) {
+        return res;
+    }
+    uint32_t len = sizeof(entry->d_name);
+    if ((e.name < fs->size) && (len > (fs->size - e.name))) {
+        len = fs->size - e.name;
+    }
+    res = _img_read(fs, e.name, entry->d_name, len);
+    if (res < 0) {
+        return res;
+    }
+    if (memchr(entry->d_name, '\0', len) == NULL) {
+        /* name does not fit in vfs_dirent_t buffer, skip it */
+        return -EAGAIN;
+    }
+    entry->d_ino = idx;
+    return 1;
+}
+
+static const vfs_file_system_ops_t hsfs_fs_ops = {
+    .mount = _mount,
+    .stat = _stat,
+    .statvfs = _statvfs,
+    .lookup = _lookup,
+    .stat_handle = _stat_handle,
+};
+
+static const vfs_file_ops_t hsfs_file_ops = {
+    .fstat = _fstat,
+    .lseek = _lseek,
+    .open = _open,
+    .open_handle = _open_handle,
+    .read = _read,
+    .write = _write,
+};
+
+static const vfs_dir_ops_t hsfs_dir_ops = {
+    .opendir = _opendir,
+    .readdir = _readdir,
+};
+
+const vfs_file_system_t hsfs_file_system = {
+    .f_op = &hsfs_file_ops,
+    .fs_op = &hsfs_fs_ops,
+    .d_op = &hsfs_dir_ops,
+};
@@ -97,43 +97,252 @@ static void be32enc_vect(void *dst_, const void *src_, size_t len)
 
 #endif /* __BYTE_ORDER__ != __ORDER_BIG_ENDIAN__ */
 
+#if defined(__SHA__) && defined(__SSE4_1__)
+/* the compiler targets an x86 CPU with the SHA extensions */
+#define SHA2XX_SHANI
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(__ARM_NEON)
+/* lock-step hashing of several messages only pays off with SIMD
+ * instructions, otherwise the working variables do not fit in registers */
+#define SHA2XX_SIMD_LANES
+#endif
+
+#ifdef SHA2XX_SHANI
+/*
+ * Four rounds using the message words in msg. After the first two rounds,
+ * optionally perform a step of the schedule.
+ */
+#define SHANI_ROUNDS(msg, k, sched)  do { \
+        __m128i m = _mm_add_epi32(msg, _mm_loadu_si128((const __m128i *)(k))); \
+        state1 = _mm_sha256rnds2_epu32(state1, state0, m); \
+        sched; \
+        m = _mm_shuffle_epi32(m, 0x0E); \
+        state0 = _mm_sha256rnds2_epu32(state0, state1, m); \
+} while (0)
+
+/* add W[t-7] and finish W[t..t+3] */
+#define SHANI_MSG2(next, cur, prev)  do { \
+        next = _mm_add_epi32(next, _mm_alignr_epi8(cur, prev, 4)); \
+        next = _mm_sha256msg2_epu32(next, cur); \
+} while (0)
+
+/*
+ * SHA256 block compression function using the x86 SHA extensions.
+ */
+static void sha2xx_transform(uint32_t *state, const unsigned char *block,
+                             size_t blocks)
+{
+    const __m128i mask = _mm_set_epi64x(0x0c0d0e0f08090a0bULL,
+                                        0x0405060700010203ULL);
+    __m128i state0, state1, tmp;
+    __m128i msg0, msg1, msg2, msg3;
+
+    /* the instructions expect the state as ABEF and CDGH */
+    tmp = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)&state[0]), 0xB1);
+    state1 = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)&state[4]),
+                               0x1B);
+    state0 = _mm_alignr_epi8(tmp, state1, 8);
+    state1 = _mm_blend_epi16(state1, tmp, 0xF0);
+
+    while (blocks--) {
+        __m128i abef = state0, cdgh = state1;
+
+        msg0 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)block), mask);
+        msg1 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(block + 16)),
+                                mask);
+        msg2 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(block + 32)),
+                                mask);
+        msg3 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(block + 48)),
+                                mask);
+
+        SHANI_ROUNDS(msg0, &K[0], (void)0);
+        SHANI_ROUNDS(msg1, &K[4], (void)0);
+        msg0 = _mm_sha256msg1_epu32(msg0, msg1);
+        SHANI_ROUNDS(msg2, &K[8], (void)0);
+        msg1 = _mm_sha256msg1_epu32(msg1, msg2);
+        SHANI_ROUNDS(msg3, &K[12], SHANI_MSG2(msg0, msg3, msg2));
+        msg2 = _mm_sha256msg1_epu32(msg2, msg3);
+        for (unsigned i = 16; i < 48; i += 16) {
+            SHANI_ROUNDS(msg0, &K[i], SHANI_MSG2(msg1, msg0, msg3));
+            msg3 = _mm_sha256msg1_epu32(msg3, msg0);
+            SHANI_ROUNDS(msg1, &K[i + 4], SHANI_MSG2(msg2, msg1, msg0));
+            msg0 = _mm_sha256msg1_epu32(msg0, msg1);
+            SHANI_ROUNDS(msg2, &K[i + 8], SHANI_MSG2(msg3, msg2, msg1));
+            msg1 = _mm_sha256msg1_epu32(msg1, msg2);
+            SHANI_ROUNDS(msg3, &K[i + 12], SHANI_MSG2(msg0, msg3, msg2));
+            msg2 = _mm_sha256msg1_epu32(msg2, msg3);
+        }
+        SHANI_ROUNDS(msg0, &K[48], SHANI_MSG2(msg1, msg0, msg3));
+        msg3 = _mm_sha256msg1_epu32(msg3, msg0);
+        SHANI_ROUNDS(msg1, &K[52], SHANI_MSG2(msg2, msg1, msg0));
+        SHANI_ROUNDS(msg2, &K[56], SHANI_MSG2(msg3, msg2, msg1));
+        SHANI_ROUNDS(msg3, &K[60], (void)0);
+
+        state0 = _mm_add_epi32(state0, abef);
+        state1 = _mm_add_epi32(state1, cdgh);
+        block += 64;
+    }
+
+    /* back to ABCD and EFGH */
+    tmp = _mm_shuffle_epi32(state0, 0x1B);
+    state1 = _mm_shuffle_epi32(state1, 0xB1);
+    state0 = _mm_blend_epi16(tmp, state1, 0xF0);
+    state1 = _mm_alignr_epi8(state1, tmp, 8);
+    _mm_storeu_si128((__m128i *)&state[0], state0);
+    _mm_storeu_si128((__m128i *)&state[4], state1);
+}
+
+#else /* SHA2XX_SHANI */
+
+/*
+ * One round, the caller rotates the roles of the working variables instead
+ * of moving their values.
+ */
+#define SHA2XX_ROUND(a, b, c, d, e, f, g, h, i, w)  do { \
+        uint32_t t0 = h + S1(e) + Ch(e, f, g) + K[i] + (w); \
+        uint32_t t1 = S0(a) + Maj(a, b, c); \
+        d += t0; \
+        h = t0 + t1; \
+} while (0)
+
+/* message word j of the first 16 rounds */
+#define SHA2XX_W(j)     (W[j])
+
+/* message word 16 rounds after word j, computed in place of word j */
+#define SHA2XX_WS(j)    (W[j] += s1(W[((j) + 14) & 15]) + W[((j) + 9) & 15] + \
+                                 s0(W[((j) + 1) & 15]))
+
+#define SHA2XX_16ROUNDS(i, WX) \
+    SHA2XX_ROUND(a, b, c, d, e, f, g, h, (i) + 0, WX(0)); \
+    SHA2XX_ROUND(h, a, b, c, d, e, f, g, (i) + 1, WX(1)); \
+    SHA2XX_ROUND(g, h, a, b, c, d, e, f, (i) + 2, WX(2)); \
+    SHA2XX_ROUND(f, g, h, a, b, c, d, e, (i) + 3, WX(3)); \
+    SHA2XX_ROUND(e, f, g, h, a, b, c, d, (i) + 4, WX(4)); \
+    SHA2XX_ROUND(d, e, f, g, h, a, b, c, (i) + 5, WX(5)); \
+    SHA2XX_ROUND(c, d, e, f, g, h, a, b, (i) + 6, WX(6)); \
+    SHA2XX_ROUND(b, c, d, e, f, g, h, a, (i) + 7, WX(7)); \
+    SHA2XX_ROUND(a, b, c, d, e, f, g, h, (i) + 8, WX(8)); \
+    SHA2XX_ROUND(h, a, b, c, d, e, f, g, (i) + 9, WX(9)); \
+    SHA2XX_ROUND(g, h, a, b, c, d, e, f, (i) + 10, WX(10)); \
+    SHA2XX_ROUND(f, g, h, a, b, c, d, e, (i) + 11, WX(11)); \
+    SHA2XX_ROUND(e, f, g, h, a, b, c, d, (i) + 12, WX(12)); \
+    SHA2XX_ROUND(d, e, f, g, h, a, b, c, (i) + 13, WX(13)); \
+    SHA2XX_ROUND(c, d, e, f, g, h, a, b, (i) + 14, WX(14)); \
+    SHA2XX_ROUND(b, c, d, e, f, g, h, a, (i) + 15, WX(15))
+
 /*
  * SHA256 block compression function.  The 256-bit state is transformed via
- * the 512-bit input block to produce a new state.
+ * the 512-bit input blocks to produce a new state. Only the last 16 words of
+ * the message schedule are kept.
  */
-static void sha2xx_transform(uint32_t *state, const unsigned char block[64])
+static void sha2xx_transform(uint32_t *state, const unsigned char *block,
+                             size_t blocks)
 {
-    uint32_t W[64];
-    uint32_t S[8];
+    uint32_t W[16];
+
+    while (blocks--) {
+        uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+        uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+
+        be32dec_vect(W, block, 64);
+
+        SHA2XX_16ROUNDS(0, SHA2XX_W);
+#ifdef MODULE_HASHES_SHA2XX_UNROLL
+        SHA2XX_16ROUNDS(16, SHA2XX_WS);
+        SHA2XX_16ROUNDS(32, SHA2XX_WS);
+        SHA2XX_16ROUNDS(48, SHA2XX_WS);
+#else
+        for (unsigned i = 16; i < 64; i += 16) {
+            SHA2XX_16ROUNDS(i, SHA2XX_WS);
+        }
+#endif
+
+        state[0] += a;
+        state[1] += b;
+        state[2] += c;
+        state[3] += d;
+        state[4] += e;
+        state[5] += f;
+        state[6] += g;
+        state[7] += h;
+        block += 64;
+    }
+}
+
+#ifdef SHA2XX_SIMD_LANES
+/*
+ * The same words of SHA2XX_LANES messages, processed in lock-step by
+ * sha2xx_transform_lanes(). The compiler maps the operations to SIMD
+ * instructions where available.
+ */
+typedef uint32_t sha2xx_lanes_t
+    __attribute__((vector_size(SHA2XX_LANES * sizeof(uint32_t))));
+
+/*
+ * Compression function for SHA2XX_LANES independent messages of which
+ * blocks blocks each are available.
+ */
+static void sha2xx_transform_lanes(uint32_t *state[SHA2XX_LANES],
+                                   const unsigned char *block[SHA2XX_LANES],
+                                   size_t blocks)
+{
+    sha2xx_lanes_t S[8], W[16];
 
-    /* 1. Prepare message schedule W. */
-    be32dec_vect(W, block, 64);
-    for (int i = 16; i < 64; i++) {
-        W[i] = s1(W[i - 2]) + W[i - 7] + s0(W[i - 15]) + W[i - 16];
+    for (unsigned j = 0; j < 8; j++) {
+        for (unsigned l = 0; l < SHA2XX_LANES; l++) {
+            S[j][l] = state[l][j];
+        }
     }
 
-    /* 2. Initialize working variables. */
-    memcpy(S, state, 32);
+    for (size_t n = 0; n < blocks; n++) {
+        sha2xx_lanes_t a = S[0], b = S[1], c = S[2], d = S[3];
+        sha2xx_lanes_t e = S[4], f = S[5], g = S[6], h = S[7];
 
-    /* 3. Mix. */
-    for (int i = 0; i < 64; ++i) {
-        uint32_t e = S[(68 - i) % 8], f = S[(69 - i) % 8];
-        uint32_t g = S[(70 - i) % 8], h = S[(71 - i) % 8];
-        uint32_t t0 = h + S1(e) + Ch(e, f, g) + W[i] + K[i];
+        for (unsigned j = 0; j < 16; j++) {
+            for (unsigned l = 0; l < SHA2XX_LANES; l++) {
+                const unsigned char *p = block[l] + 64 * n + 4 * j;
+                W[j][l] = ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) |
+                          ((uint32_t)p[2] << 8) | p[3];
+            }
+        }
 
-        uint32_t a = S[(64 - i) % 8], b = S[(65 - i) % 8];
-        uint32_t c = S[(66 - i) % 8], d = S[(67 - i) % 8];
-        uint32_t t1 = S0(a) + Maj(a, b, c);
+        for (unsigned i = 0; i < 64; i++) {
+            sha2xx_lanes_t w = W[i & 15];
+            if (i >= 16) {
+                w += s1(W[(i + 14) & 15]) + W[(i + 9) & 15] +
+                     s0(W[(i + 1) & 15]);
+                W[i & 15] = w;
+            }
+            sha2xx_lanes_t t0 = h + S1(e) + Ch(e, f, g) + K[i] + w;
+            sha2xx_lanes_t t1 = S0(a) + Maj(a, b, c);
+            h = g;
+            g = f;
+            f = e;
+            e = d + t0;
+            d = c;
+            c = b;
+            b = a;
+            a = t0 + t1;
+        }
 
-        S[(67 - i) % 8] = d + t0;
-        S[(71 - i) % 8] = t0 + t1;
+        S[0] += a;
+        S[1] += b;
+        S[2] += c;
+        S[3] += d;
+        S[4] += e;
+        S[5] += f;
+        S[6] += g;
+        S[7] += h;
     }
 
-    /* 4. Mix local working variables into global state */
-    for (int i = 0; i < 8; i++) {
-        state[i] += S[i];
+    for (unsigned j = 0; j < 8; j++) {
+        for (unsigned l = 0; l < SHA2XX_LANES; l++) {
+            state[l][j] = S[j][l];
+        }
     }
 }
+#endif /* SHA2XX_SIMD_LANES */
+#endif /* SHA2XX_SHANI */
 
 static unsigned char PAD[64] = {
     0x80, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
@@ -162,12 +371,9 @@ void sha2xx_pad(sha2xx_context_t *ctx)
     sha2xx_update(ctx, len, 8);
 }
 
-/* Add bytes into the hash */
-void sha2xx_update(sha2xx_context_t *ctx, const void *data, size_t len)
+/* Add the length of len bytes to the bit count */
+static void sha2xx_count(sha2xx_context_t *ctx, size_t len)
 {
-    /* Number of bytes left in the buffer from previous updates */
-    uint32_t r = (ctx->count[1] >> 3) & 0x3f;
-
     /* Convert the length into a number of bits */
     uint32_t bitlen1 = ((uint32_t) len) << 3;
     uint32_t bitlen0 = ((uint32_t) len) >> 29;
@@ -178,6 +384,15 @@ void sha2xx_update(sha2xx_context_t *ctx, const void *data, size_t len)
     }
 
     ctx->count[0] += bitlen0;
+}
+
+/* Add bytes into the hash */
+void sha2xx_update(sha2xx_context_t *ctx, const void *data, size_t len)
+{
+    /* Number of bytes left in the buffer from previous updates */
+    uint32_t r = (ctx->count[1] >> 3) & 0x3f;
+
+    sha2xx_count(ctx, len);
 
     /* Handle the case where we don't need to perform any transforms */
     if (len < 64 - r) {
@@ -191,21 +406,87 @@ void sha2xx_update(sha2xx_context_t *ctx, const void *data, size_t len)
     const unsigned char *src = data;
 
     memcpy(&ctx->buf[r], src, 64 - r);
-    sha2xx_transform(ctx->state, ctx->buf);
+    sha2xx_transform(ctx->state, ctx->buf, 1);
     src += 64 - r;
     len -= 64 - r;
 
     /* Perform complete blocks */
-    while (len >= 64) {
-        sha2xx_transform(ctx->state, src);
-        src += 64;
-        len -= 64;
+    if (len >= 64) {
+        sha2xx_transform(ctx->state, src, len / 64);
+        src += len & ~(size_t)0x3f;
+        len &= 0x3f;
     }
 
     /* Copy left over data into buffer */
     memcpy(ctx->buf, src, len);
 }
 
+void sha2xx_update_multi(sha2xx_context_t *const ctx[],
+                         const void *const data[], size_t len, unsigned count)
+{
+#ifndef SHA2XX_SIMD_LANES
+    for (unsigned i = 0; i < count; i++) {
+        sha2xx_update(ctx[i], data[i], len);
+    }
+#else
+    for (unsigned first = 0; first < count; first += SHA2XX_LANES) {
+        unsigned lanes = count - first;
+        uint32_t r = (ctx[first]->count[1] >> 3) & 0x3f;
+        size_t done = 0;
+
+        if (lanes > SHA2XX_LANES) {
+            lanes = SHA2XX_LANES;
+        }
+
+        /* lock-step is only possible if the buffers of all messages are
+         * filled equally, which is the case if they were always updated
+         * together */
+        for (unsigned l = 1; l < lanes; l++) {
+            if (((ctx[first + l]->count[1] >> 3) & 0x3f) != r) {
+                lanes = 1;
+            }
+        }
+
+        /* complete the buffered block of each message first */
+        if ((lanes > 1) && (r > 0)) {
+            done = (len < 64 - r) ? len : 64 - r;
+            for (unsigned l = 0; l < lanes; l++) {
+                sha2xx_update(ctx[first + l], data[first + l], done);
+            }
+        }
+
+        if ((lanes > 1) && (len - done >= 64)) {
+            uint32_t *state[SHA2XX_LANES];
+            const unsigned char *src[SHA2XX_LANES];
+            size_t blocks = (len - done) / 64;
+
+            /* unused lanes hash the first message once more, writing back
+             * the same state */
+            for (unsigned l = 0; l < SHA2XX_LANES; l++) {
+                unsigned i = first + ((l < lanes) ? l : 0);
+                state[l] = ctx[i]->state;
+                src[l] = (const unsigned char *)data[i] + done;
+            }
+            sha2xx_transform_lanes(state, src, blocks);
+            for (unsigned l = 0; l < lanes; l++) {
+                sha2xx_count(ctx[first + l], blocks * 64);
+            }
+            done += blocks * 64;
+        }
+
+        for (unsigned i = first; i < first + lanes; i++) {
+            sha2xx_update(ctx[i], (const unsigned char *)data[i] + done,
+                          len - done);
+        }
+        /* messages that could not be processed in lock-step */
+        for (unsigned i = first + lanes;
+             i < first + SHA2XX_LANES && i < count; i++) {
+            sha2xx_update(ctx[i], data[i], len);
+        }
+    }
+#endif
+}
+
 /*
  * SHA-224 finalization.  Pads the input data, exports the hash value,
  * and clears the context state.
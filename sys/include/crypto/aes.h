@@ -47,6 +47,7 @@ typedef uint8_t u8;
 #define AES_MAXNR         14
 #define AES_BLOCK_SIZE    16
 #define AES_KEY_SIZE      16
+#define AES_ROUNDS        10    /**< number of rounds of AES-128 */
 
 /**
  * @brief AES key
@@ -63,12 +64,27 @@ typedef struct aes_key_st AES_KEY;
 
 /**
  * @brief the cipher_context_t-struct adapted for AES
+ *
+ * The key schedules are expanded once by aes_init(), so that encryption and
+ * decryption of a block only consist of the cipher rounds.
  */
 typedef struct {
-    /** context data buffer */
-    uint32_t context[(4 * (AES_MAXNR + 1)) + 1];
+    /** round keys used for encryption */
+    uint32_t enc_key[4 * (AES_ROUNDS + 1)];
+    /** round keys used for decryption */
+    uint32_t dec_key[4 * (AES_ROUNDS + 1)];
 } aes_context_t;
 
+/**
+ * @brief the cipher_context_t-struct adapted for the constant-time AES
+ *
+ * Holds the bitsliced round keys, which are expanded once by aes_ct_init().
+ */
+typedef struct {
+    /** bitsliced round keys, eight words per round */
+    uint32_t skey[8 * (AES_ROUNDS + 1)];
+} aes_ct_context_t;
+
 /**
  * @brief   initializes the AES Cipher-algorithm with the passed parameters
  *
@@ -126,6 +142,112 @@ int aes_encrypt(const cipher_context_t *context, const uint8_t *plain_block,
 int aes_decrypt(const cipher_context_t *context, const uint8_t *cipher_block,
                 uint8_t *plain_block);
 
+/**
+ * @brief   encrypts @p blocks consecutive blocks with the key schedule
+ *          stored in @p context
+ *
+ * @param       context       the cipher_context_t-struct to use for this
+ *                            encryption
+ * @param       input         the plaintext blocks
+ * @param       output        where the ciphertext blocks will be stored, may
+ *                            be the same as @p input
+ * @param       blocks        number of blocks
+ *
+ * @return  1 on success
+ */
+int aes_encrypt_blocks(const cipher_context_t *context, const uint8_t *input,
+                       uint8_t *output, size_t blocks);
+
+/**
+ * @brief   decrypts @p blocks consecutive blocks with the key schedule
+ *          stored in @p context
+ *
+ * @param       context       the cipher_context_t-struct to use for this
+ *                            decryption
+ * @param       input         the ciphertext blocks
+ * @param       output        where the plaintext blocks will be stored, may
+ *                            be the same as @p input
+ * @param       blocks        number of blocks
+ *
+ * @return  1 on success
+ */
+int aes_decrypt_blocks(const cipher_context_t *context, const uint8_t *input,
+                       uint8_t *output, size_t blocks);
+
+/**
+ * @brief   initializes the constant-time AES implementation
+ *
+ * The constant-time implementation does not use any lookup tables. It
+ * computes the S-box with a boolean circuit on bitsliced data, so its timing
+ * is independent of key and data.
+ *
+ * @param       context   the cipher_context_t-struct to save the
+ *                        bitsliced round keys in
+ * @param       key       a pointer to the key
+ * @param       keySize   the size of the key, must be 16
+ *
+ * @return  CIPHER_INIT_SUCCESS if the initialization was successful.
+ * @return  CIPHER_ERR_INVALID_KEY_SIZE if @p keySize is not supported
+ * @return  CIPHER_ERR_BAD_CONTEXT_SIZE if CIPHER_MAX_CONTEXT_SIZE is too small
+ */
+int aes_ct_init(cipher_context_t *context, const uint8_t *key, uint8_t keySize);
+
+/**
+ * @brief   encrypts one block in constant time
+ *
+ * @param       context       context initialized by aes_ct_init()
+ * @param       plain_block   the plaintext block
+ * @param       cipher_block  where the ciphertext block will be stored
+ *
+ * @return  1 on success
+ */
+int aes_ct_encrypt(const cipher_context_t *context, const uint8_t *plain_block,
+                   uint8_t *cipher_block);
+
+/**
+ * @brief   decrypts one block in constant time
+ *
+ * @param       context       context initialized by aes_ct_init()
+ * @param       cipher_block  the ciphertext block
+ * @param       plain_block   where the plaintext block will be stored
+ *
+ * @return  1 on success
+ */
+int aes_ct_decrypt(const cipher_context_t *context, const uint8_t *cipher_block,
+                   uint8_t *plain_block);
+
+/**
+ * @brief   encrypts @p blocks consecutive blocks in constant time, two
+ *          blocks at a time
+ *
+ * @param       context       context initialized by aes_ct_init()
+ * @param       input         the plaintext blocks
+ * @param       output        where the ciphertext blocks will be stored, may
+ *                            be the same as @p input
+ * @param       blocks        number of blocks
+ *
+ * @return  1 on success
+ */
+int aes_ct_encrypt_blocks(const cipher_context_t *context,
+                          const uint8_t *input, uint8_t *output,
+                          size_t blocks);
+
+/**
+ * @brief   decrypts @p blocks consecutive blocks in constant time, two
+ *          blocks at a time
+ *
+ * @param       context       context initialized by aes_ct_init()
+ * @param       input         the ciphertext blocks
+ * @param       output        where the plaintext blocks will be stored, may
+ *                            be the same as @p input
+ * @param       blocks        number of blocks
+ *
+ * @return  1 on success
+ */
+int aes_ct_decrypt_blocks(const cipher_context_t *context,
+                          const uint8_t *input, uint8_t *output,
+                          size_t blocks);
+
 #ifdef __cplusplus
 }
 #endif
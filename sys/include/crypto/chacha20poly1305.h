@@ -29,6 +29,7 @@
 #define CRYPTO_CHACHA20POLY1305_H
 
 #include "crypto/poly1305.h"
+#include "iolist.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -38,16 +39,26 @@ extern "C" {
 #define CHACHA20POLY1305_NONCE_BYTES    (12U)   /**< Nonce length in bytes */
 #define CHACHA20POLY1305_TAG_BYTES      (16U)   /**< Tag length in bytes */
 
+/**
+ * @brief Number of key stream blocks generated at once
+ *
+ * The blocks are computed interleaved, which allows the compiler to use SIMD
+ * instructions on targets that have them.
+ */
+#ifndef CHACHA20POLY1305_BLOCKS
+#define CHACHA20POLY1305_BLOCKS         (4U)
+#endif
+
 /**
  * @brief Chacha20poly1305 state struct
  */
-typedef union {
-    /* We need both the state matrix and the poly1305 state, but nearly not at
-     * the same time. This works as long as the first 8 members of state
-     * overlap fully or completely not with the first and second key parts
-     * from the @ref poly1305_ctx_t struct */
-    uint32_t state[16];     /**< The current state of the key stream. */
+typedef struct {
+    uint32_t state[16];     /**< Input block of the next key stream block */
+    /** Generated key stream */
+    uint32_t stream[16 * CHACHA20POLY1305_BLOCKS];
     poly1305_ctx_t poly;    /**< Poly1305 state for the MAC */
+    uint16_t pos;           /**< Bytes of @p stream already used */
+    uint16_t len;           /**< Bytes of @p stream generated */
 } chacha20poly1305_ctx_t;
 
 /**
@@ -96,6 +107,49 @@ int chacha20poly1305_decrypt(const uint8_t *cipher, size_t cipherlen,
                              const uint8_t *aad, size_t aadlen,
                              const uint8_t *key, const uint8_t *nonce);
 
+/**
+ * @brief Encrypt a message spread over an iolist in place and compute the
+ * tag protecting it and additional data.
+ *
+ * This allows to seal e.g. a packet payload consisting of several snips
+ * without copying it into a single buffer first.
+ *
+ * @param[in,out] iolist    message to encrypt, replaced by the ciphertext
+ * @param[out]  tag         resulting tag, must be CHACHA20POLY1305_TAG_BYTES
+ *                          long
+ * @param[in]   aad         additional authenticated data to protect
+ * @param[in]   aadlen      length of the additional authenticated data
+ * @param[in]   key         key to encrypt with, must be
+ *                          CHACHA20POLY1305_KEY_BYTES long
+ * @param[in]   nonce       Nonce to use. Must be CHACHA20POLY1305_NONCE_BYTES
+ *                          long
+ */
+void chacha20poly1305_encrypt_iol(const iolist_t *iolist, uint8_t *tag,
+                                  const uint8_t *aad, size_t aadlen,
+                                  const uint8_t *key, const uint8_t *nonce);
+
+/**
+ * @brief Verify the tag and decrypt a ciphertext spread over an iolist in
+ * place.
+ *
+ * The ciphertext is left untouched if the tag does not match.
+ *
+ * @param[in,out] iolist    ciphertext, replaced by the message on success
+ * @param[in]   tag         tag to verify, CHACHA20POLY1305_TAG_BYTES long
+ * @param[in]   aad         additional authenticated data to verify
+ * @param[in]   aadlen      length of the additional authenticated data
+ * @param[in]   key         key to decrypt with, must be
+ *                          CHACHA20POLY1305_KEY_BYTES long
+ * @param[in]   nonce       Nonce to use. Must be CHACHA20POLY1305_NONCE_BYTES
+ *                          long
+ *
+ * @return      1 if the tag matches and the ciphertext was decrypted
+ * @return      0 if the tag does not match
+ */
+int chacha20poly1305_decrypt_iol(const iolist_t *iolist, const uint8_t *tag,
+                                 const uint8_t *aad, size_t aadlen,
+                                 const uint8_t *key, const uint8_t *nonce);
+
 #ifdef __cplusplus
 }
 #endif
@@ -22,6 +22,7 @@
 #ifndef CRYPTO_CIPHERS_H
 #define CRYPTO_CIPHERS_H
 
+#include <stddef.h>
 #include <stdint.h>
 
 #ifdef __cplusplus
@@ -38,13 +39,14 @@ extern "C" {
  * Context sizes needed for the different ciphers.
  * Always order by number of bytes descending!!! <br><br>
  *
+ * aes          needs 352 bytes (expanded encryption and decryption
+ *              key schedules)                            <br>
  * threedes     needs 24  bytes                           <br>
- * aes          needs CIPHERS_MAX_KEY_SIZE bytes          <br>
  */
-#if defined(MODULE_CRYPTO_3DES)
+#if defined(MODULE_CRYPTO_AES)
+    #define CIPHER_MAX_CONTEXT_SIZE 352
+#elif defined(MODULE_CRYPTO_3DES)
     #define CIPHER_MAX_CONTEXT_SIZE 24
-#elif defined(MODULE_CRYPTO_AES)
-    #define CIPHER_MAX_CONTEXT_SIZE CIPHERS_MAX_KEY_SIZE
 #else
 /* 0 is not a possibility because 0-sized arrays are not allowed in ISO C */
     #define CIPHER_MAX_CONTEXT_SIZE 1
@@ -65,7 +67,8 @@ extern "C" {
  * @brief   the context for cipher-operations
  */
 typedef struct {
-    uint8_t context[CIPHER_MAX_CONTEXT_SIZE];  /**< buffer for cipher operations */
+    /** buffer for cipher operations, word aligned to hold round keys */
+    uint8_t context[CIPHER_MAX_CONTEXT_SIZE] __attribute__((aligned(4)));
 } cipher_context_t;
 
 
@@ -89,6 +92,14 @@ typedef struct cipher_interface_st {
     /** the decrypt function */
     int (*decrypt)(const cipher_context_t *ctx, const uint8_t *cipher_block,
                    uint8_t *plain_block);
+
+    /** encrypt multiple consecutive blocks, may be NULL */
+    int (*encrypt_blocks)(const cipher_context_t *ctx, const uint8_t *input,
+                          uint8_t *output, size_t blocks);
+
+    /** decrypt multiple consecutive blocks, may be NULL */
+    int (*decrypt_blocks)(const cipher_context_t *ctx, const uint8_t *input,
+                          uint8_t *output, size_t blocks);
 } cipher_interface_t;
 
 
@@ -96,6 +107,15 @@ typedef const cipher_interface_t *cipher_id_t;
 
 extern const cipher_id_t CIPHER_AES_128;
 
+/**
+ * @brief   Table-free, constant-time (bitsliced) implementation of AES-128
+ *
+ * Slower than @ref CIPHER_AES_128 for single blocks, but its timing does not
+ * depend on key or data. Two blocks are processed in parallel by
+ * @ref cipher_encrypt_blocks and @ref cipher_decrypt_blocks.
+ */
+extern const cipher_id_t CIPHER_AES_128_CT;
+
 
 /**
  * @brief basic struct for using block ciphers
@@ -162,6 +182,46 @@ int cipher_decrypt(const cipher_t *cipher, const uint8_t *input,
                    uint8_t *output);
 
 
+/**
+ * @brief Encrypt multiple consecutive blocks of BLOCK_SIZE length
+ *
+ * The key schedule stored in the cipher struct is used for all blocks. If the
+ * cipher provides no dedicated multi-block operation, the blocks are
+ * encrypted one by one.
+ *
+ * @param cipher     Already initialized cipher struct
+ * @param input      pointer to input data to encrypt, @p blocks * BLOCK_SIZE
+ *                   bytes
+ * @param output     pointer to allocated memory for encrypted data. It has to
+ *                   be of size @p blocks * BLOCK_SIZE and may be the same as
+ *                   @p input
+ * @param blocks     number of blocks to encrypt
+ *
+ * @return           1 in case of success
+ * @return           A negative value for an error
+ */
+int cipher_encrypt_blocks(const cipher_t *cipher, const uint8_t *input,
+                          uint8_t *output, size_t blocks);
+
+
+/**
+ * @brief Decrypt multiple consecutive blocks of BLOCK_SIZE length
+ *
+ * @param cipher     Already initialized cipher struct
+ * @param input      pointer to input data to decrypt, @p blocks * BLOCK_SIZE
+ *                   bytes
+ * @param output     pointer to allocated memory for decrypted data. It has to
+ *                   be of size @p blocks * BLOCK_SIZE and may be the same as
+ *                   @p input
+ * @param blocks     number of blocks to decrypt
+ *
+ * @return           1 in case of success
+ * @return           A negative value for an error
+ */
+int cipher_decrypt_blocks(const cipher_t *cipher, const uint8_t *input,
+                          uint8_t *output, size_t blocks);
+
+
 /**
  * @brief Get block size of cipher
  * *
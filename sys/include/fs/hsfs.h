@@ -0,0 +1,141 @@
+/*
+ * Copyright (C) 2020 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @defgroup    sys_fs_hsfs HSFS compressed image file system
+ * @ingroup     sys_fs
+ * @brief       Read-only file system for heatshrink compressed images
+ *
+ * Like @ref sys_fs_constfs, this file system serves static files, e.g. the
+ * assets of a web or CoAP server. The files are packed into a single image by
+ * `dist/tools/mkhsfs/mkhsfs.py`, which compresses them with heatshrink:
+ *
+ *     mkhsfs.py -o assets.hsfs path/to/assets
+ *
+ * The files are split into blocks that are compressed independently, so
+ * `lseek()` only has to decompress the block it lands in. The directory
+ * index is sorted by the hash of the paths, a lookup is a binary search.
+ * The directory is flat: all files are listed by opendir("/"), with their full
+ * paths as names.
+ *
+ * The image is either linked into the firmware, e.g. with the `BLOBS`
+ * mechanism of the build system, or stored on an MTD device (module
+ * `hsfs_mtd`):
+ *
+ * ```
+ * #include "blob/assets.hsfs.h"
+ *
+ * static hsfs_t _fs = { .image = assets_hsfs };
+ * static vfs_mount_t _mount = {
+ *     .fs = &hsfs_file_system,
+ *     .mount_point = "/www",
+ *     .private_data = &_fs,
+ * };
+ * ```
+ *
+ * Every mount keeps one decompressed block, accesses to it are served
+ * without decompressing it again. Sequential reads of a file decompress
+ * every block once.
+ *
+ * The heatshrink parameters of the image must match
+ * `HEATSHRINK_STATIC_WINDOW_BITS` and `HEATSHRINK_STATIC_LOOKAHEAD_BITS` of
+ * the build, the block size must not exceed @ref CONFIG_HSFS_BLOCK_SIZE_MAX.
+ *
+ * @{
+ * @file
+ * @brief   HSFS public API
+ */
+
+#ifndef FS_HSFS_H
+#define FS_HSFS_H
+
+#include <stdint.h>
+
+#include "heatshrink_decoder.h"
+#include "kernel_defines.h"
+#include "mutex.h"
+#include "vfs.h"
+#if IS_USED(MODULE_HSFS_MTD)
+#include "mtd.h"
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @name    HSFS configuration
+ * @ingroup config
+ * @{
+ */
+#ifndef CONFIG_HSFS_BLOCK_SIZE_MAX
+/**
+ * @brief   Largest supported block size, this much RAM is used per mount
+ */
+#define CONFIG_HSFS_BLOCK_SIZE_MAX      (1024U)
+#endif
+
+#ifndef CONFIG_HSFS_MTD_READ_SIZE
+/**
+ * @brief   Size of the buffer for compressed data read from an MTD device
+ */
+#define CONFIG_HSFS_MTD_READ_SIZE       (64U)
+#endif
+/** @} */
+
+/**
+ * @brief   Entry of the file index of an image
+ */
+typedef struct {
+    uint32_t hash;          /**< FNV-1a hash of the path */
+    uint32_t name;          /**< offset of the path in the image */
+    uint32_t size;          /**< size of the file */
+    uint32_t table;         /**< offset of the block table in the image */
+} hsfs_entry_t;
+
+/**
+ * @brief   HSFS file system superblock
+ *
+ * Only hsfs_t::image resp. hsfs_t::mtd and hsfs_t::mtd_offset are set by the
+ * user, the rest is initialized by vfs_mount().
+ */
+typedef struct {
+    const uint8_t *image;       /**< image in memory, NULL if on MTD */
+#if IS_USED(MODULE_HSFS_MTD) || DOXYGEN
+    mtd_dev_t *mtd;             /**< MTD device holding the image */
+    uint32_t mtd_offset;        /**< address of the image on hsfs_t::mtd */
+#endif
+    mutex_t lock;               /**< lock for the block cache and decoder */
+    uint32_t size;              /**< size of the image */
+    uint16_t nfiles;            /**< number of files */
+    uint8_t block_shift;        /**< log2 of the block size */
+    int entry_idx;              /**< index of hsfs_t::entry, -1 if none */
+    hsfs_entry_t entry;         /**< file of the cached block */
+    uint32_t block_idx;         /**< number of the cached block */
+    uint16_t block_len;         /**< length of the cached block, 0 if none */
+    heatshrink_decoder dec;     /**< decompressor */
+#if IS_USED(MODULE_HSFS_MTD) || DOXYGEN
+    uint8_t in[CONFIG_HSFS_MTD_READ_SIZE];  /**< compressed data buffer */
+#endif
+    uint8_t block[CONFIG_HSFS_BLOCK_SIZE_MAX];  /**< cached block */
+} hsfs_t;
+
+/**
+ * @brief   HSFS file system driver
+ *
+ * For use with vfs_mount
+ */
+extern const vfs_file_system_t hsfs_file_system;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FS_HSFS_H */
+
+/** @} */
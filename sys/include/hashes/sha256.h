@@ -111,6 +111,24 @@ static inline void sha256_update(sha256_context_t *ctx, const void *data, size_t
     sha2xx_update(ctx, data, len);
 }
 
+/**
+ * @brief Add the same number of bytes into several hashes, e.g. to hash
+ *        several firmware slots at once
+ *
+ * @see sha2xx_update_multi()
+ *
+ * @param ctx      sha256_context_t handles to use
+ * @param[in] data Input data, one buffer per handle
+ * @param[in] len  Length of each buffer in @p data
+ * @param[in] count Number of handles and buffers
+ */
+static inline void sha256_update_multi(sha256_context_t *const ctx[],
+                                       const void *const data[], size_t len,
+                                       unsigned count)
+{
+    sha2xx_update_multi(ctx, data, len, count);
+}
+
 /**
  * @brief SHA-256 finalization.  Pads the input data, exports the hash value,
  * and clears the context state.
@@ -35,6 +35,12 @@
  * @defgroup    sys_hashes_sha2xx_common SHA-2xx common
  * @ingroup     sys_hashes_unkeyed
  * @brief       Implementation of common functionality for SHA-224/256 hashing functions
+ *
+ * The compression function is selected at build time: if the compiler targets
+ * the x86 SHA extensions (e.g. `CFLAGS += -msha -msse4.1` on native), these
+ * are used. Otherwise a portable implementation is used, which can be fully
+ * unrolled with the `hashes_sha2xx_unroll` pseudomodule at the cost of flash.
+ *
  * @{
  *
  * @file
@@ -57,6 +63,13 @@
 extern "C" {
 #endif
 
+/**
+ * @brief    Number of messages sha2xx_update_multi() processes in lock-step
+ */
+#ifndef SHA2XX_LANES
+#define SHA2XX_LANES    (4U)
+#endif
+
 /**
  * @brief    Structure to hold the SHA-2XX context.
  */
@@ -119,6 +132,23 @@ void sha2xx_pad(sha2xx_context_t *ctx);
  */
 void sha2xx_update(sha2xx_context_t *ctx, const void *data, size_t len);
 
+/**
+ * @brief Add the same number of bytes into several hashes
+ *
+ * If the compiler targets SIMD instructions (SSE2 or NEON) and no SHA
+ * instructions, up to @ref SHA2XX_LANES messages are processed in lock-step.
+ * This works best if the contexts were always updated together, so that
+ * their internal buffers are filled equally. Otherwise, the messages are
+ * hashed one after the other.
+ *
+ * @param ctx      sha2xx_context_t handles to use
+ * @param[in] data Input data, one buffer per handle
+ * @param[in] len  Length of each buffer in @p data
+ * @param[in] count Number of handles and buffers
+ */
+void sha2xx_update_multi(sha2xx_context_t *const ctx[],
+                         const void *const data[], size_t len, unsigned count);
+
 /**
  * @brief SHA-2XX finalization.  Pads the input data, exports the hash value,
  * and clears the context state.
@@ -0,0 +1,361 @@
+/*
+ * Copyright (C) 2020 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @defgroup    sys_kvstore Key-value store
+ * @ingroup     sys
+ * @brief       Log-structured key-value store for configuration data on MTD
+ *
+ * kvstore keeps small values, e.g. configuration data, under string keys on
+ * a range of sectors of an MTD device.
+ *
+ * - Every update appends a record to the current sector, nothing is
+ *   overwritten in place.
+ * - An index in RAM maps the hash of every key to its newest record, a
+ *   lookup costs a single read of the record.
+ * - When a sector is full, a summary of its records is written to its end.
+ *   kvstore_init() rebuilds the index from the summaries and only reads the
+ *   records of the sector that was not full yet.
+ * - Updates of several keys are applied atomically with a transaction
+ *   (@ref kvstore_txn_t): its records are ignored unless the record
+ *   committing it was written completely.
+ * - One sector is kept free. When no other sector is free, the sector with
+ *   the fewest live records is compacted into it and erased. New sectors are
+ *   taken in the order of their erase counts. If the erase counts differ by
+ *   more than @ref CONFIG_KVSTORE_WEAR_THRESHOLD, the least erased sector is
+ *   compacted instead, so sectors holding rarely updated data are reused.
+ *   kvstore_init() finishes a compaction that was interrupted by a power
+ *   loss, or drops the copies it made if they cannot be completed.
+ *
+ * Keys are identified by their 32 bit hash: setting a key whose hash
+ * collides with the hash of a different stored key fails with `-EEXIST`.
+ *
+ * ## Usage
+ *
+ * ```
+ * USEMODULE += kvstore
+ * ```
+ *
+ * ```
+ * static kvstore_sector_t sectors[8];
+ * static kvstore_entry_t entries[32];
+ * static kvstore_t kvs = KVSTORE_INIT(MTD_0, 0, sectors, entries);
+ *
+ * kvstore_init(&kvs);
+ * kvstore_set(&kvs, "channel", &channel, sizeof(channel));
+ * ```
+ *
+ * The shell command `kv` (module `kvstore_cmd`) operates on the store
+ * initialized last.
+ *
+ * @{
+ *
+ * @file
+ * @brief       Key-value store interface
+ */
+
+#ifndef KVSTORE_H
+#define KVSTORE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#include "kernel_defines.h"
+#include "mtd.h"
+#include "mutex.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @defgroup    sys_kvstore_config  Key-value store compile configurations
+ * @ingroup     config
+ * @{
+ */
+/**
+ * @brief   Maximum length of a key
+ */
+#ifndef CONFIG_KVSTORE_KEY_MAX
+#define CONFIG_KVSTORE_KEY_MAX          (32U)
+#endif
+
+/**
+ * @brief   Size of the buffers for reading and writing the device
+ *
+ * Must be a multiple of @ref CONFIG_KVSTORE_ALIGN, this much RAM is used
+ * twice per store.
+ */
+#ifndef CONFIG_KVSTORE_BUF_SIZE
+#define CONFIG_KVSTORE_BUF_SIZE         (64U)
+#endif
+
+/**
+ * @brief   Alignment of writes to the device
+ */
+#ifndef CONFIG_KVSTORE_ALIGN
+#define CONFIG_KVSTORE_ALIGN            (4U)
+#endif
+
+/**
+ * @brief   Difference of the erase counts of the sectors above which a
+ *          sector with rarely updated data is compacted
+ */
+#ifndef CONFIG_KVSTORE_WEAR_THRESHOLD
+#define CONFIG_KVSTORE_WEAR_THRESHOLD   (32U)
+#endif
+/** @} */
+
+/**
+ * @brief   Shortcut macro for initializing a @ref kvstore_t
+ *
+ * @param[in] _mtd      The MTD device
+ * @param[in] _first    First sector of the store on the device
+ * @param[in] _sectors  Array of @ref kvstore_sector_t, one per sector
+ * @param[in] _entries  Array of @ref kvstore_entry_t, one more than keys
+ */
+#define KVSTORE_INIT(_mtd, _first, _sectors, _entries) \
+{ \
+    .mtd = _mtd, \
+    .first_sector = _first, \
+    .sectors = _sectors, \
+    .sector_count = ARRAY_SIZE(_sectors), \
+    .entries = _entries, \
+    .entries_numof = ARRAY_SIZE(_entries), \
+    .lock = MUTEX_INIT, \
+}
+
+/**
+ * @brief   State of a sector of the store
+ */
+typedef struct {
+    uint32_t seq;           /**< sequence number of the sector */
+    uint32_t erase_count;   /**< number of times the sector was erased */
+    uint32_t live;          /**< bytes in use by current records */
+    uint8_t state;          /**< free, erased, active or full */
+} kvstore_sector_t;
+
+/**
+ * @brief   Entry of the index of a store
+ */
+typedef struct {
+    uint32_t hash;          /**< hash of the key */
+    uint32_t addr;          /**< address of the newest record, 0 if unused */
+    uint16_t len;           /**< length of the record, flag for deleted keys */
+} kvstore_entry_t;
+
+/**
+ * @brief   Statistics of a store
+ */
+typedef struct {
+    uint32_t writes;        /**< calls of mtd_write() */
+    uint32_t erases;        /**< sectors erased */
+    uint32_t compactions;   /**< sectors compacted */
+    uint32_t moved;         /**< records moved by compaction */
+} kvstore_stats_t;
+
+/**
+ * @brief   Key-value store
+ *
+ * Use @ref KVSTORE_INIT to initialize it.
+ */
+typedef struct {
+    mtd_dev_t *mtd;                 /**< backing device */
+    uint32_t first_sector;          /**< first sector of the store */
+    kvstore_sector_t *sectors;      /**< state of the sectors */
+    uint32_t sector_count;          /**< number of sectors of the store */
+    kvstore_entry_t *entries;       /**< index */
+    unsigned entries_numof;         /**< number of kvstore_t::entries */
+    mutex_t lock;                   /**< lock for the store */
+    unsigned keys;                  /**< number of used index entries */
+    uint32_t seq;                   /**< newest sector sequence number */
+    uint32_t txn;                   /**< next transaction number */
+    uint32_t active;                /**< sector appended to */
+    uint32_t pos;                   /**< offset of the next record */
+    uint32_t nrec;                  /**< records in the active sector */
+    uint32_t ws_addr;               /**< address of kvstore_t::wbuf */
+    uint32_t ws_len;                /**< bytes in kvstore_t::wbuf */
+    kvstore_stats_t stats;          /**< statistics */
+    uint8_t wbuf[CONFIG_KVSTORE_BUF_SIZE];  /**< write buffer */
+    uint8_t rbuf[CONFIG_KVSTORE_BUF_SIZE];  /**< read buffer */
+} kvstore_t;
+
+/**
+ * @brief   Transaction, a set of updates applied atomically
+ *
+ * The updates are collected in a buffer provided by the user and written on
+ * kvstore_txn_commit(). A transaction must fit into a sector.
+ */
+typedef struct {
+    kvstore_t *kvs;         /**< store to update */
+    uint8_t *buf;           /**< buffer for the updates */
+    size_t size;            /**< size of kvstore_txn_t::buf */
+    size_t len;             /**< bytes used in kvstore_txn_t::buf */
+} kvstore_txn_t;
+
+/**
+ * @brief   Callback for the keys listed by kvstore_foreach()
+ *
+ * @param[in] key   the key
+ * @param[in] len   length of its value
+ * @param[in] arg   argument passed to kvstore_foreach()
+ */
+typedef void (*kvstore_cb_t)(const char *key, size_t len, void *arg);
+
+/**
+ * @brief   Initialize a store and rebuild its index from the device
+ *
+ * Sectors that do not belong to the store are erased before they are used,
+ * the device does not need to be formatted.
+ *
+ * @param[in,out] kvs   store to initialize
+ *
+ * @return  0 on success
+ * @return  -EINVAL if the geometry of the device does not fit the store
+ * @return  -ENOMEM if kvstore_t::entries is too small for the stored keys
+ * @return  <0 on errors of the device
+ */
+int kvstore_init(kvstore_t *kvs);
+
+/**
+ * @brief   Erase all keys of a store
+ *
+ * @param[in,out] kvs   store to erase, initialized by kvstore_init()
+ *
+ * @return  0 on success
+ * @return  <0 on errors of the device
+ */
+int kvstore_format(kvstore_t *kvs);
+
+/**
+ * @brief   Read the value of a key
+ *
+ * @param[in] kvs       store to read from
+ * @param[in] key       key to read
+ * @param[out] buf      buffer for the value
+ * @param[in] len       size of @p buf
+ *
+ * @return  length of the value
+ * @return  -ENOENT if @p key is not stored
+ * @return  -ENOBUFS if @p buf is too small
+ * @return  -EIO if the record of @p key is damaged
+ * @return  <0 on errors of the device
+ */
+ssize_t kvstore_get(kvstore_t *kvs, const char *key, void *buf, size_t len);
+
+/**
+ * @brief   Set the value of a key
+ *
+ * @param[in,out] kvs   store to write to
+ * @param[in] key       key to set
+ * @param[in] val       value
+ * @param[in] len       length of @p val
+ *
+ * @return  0 on success
+ * @return  -EINVAL if @p key is too long
+ * @return  -EEXIST if the hash of @p key collides with a different key
+ * @return  -ENOMEM if kvstore_t::entries is full
+ * @return  -ENOSPC if the store is full
+ * @return  <0 on errors of the device
+ */
+int kvstore_set(kvstore_t *kvs, const char *key, const void *val, size_t len);
+
+/**
+ * @brief   Delete a key
+ *
+ * @param[in,out] kvs   store to delete from
+ * @param[in] key       key to delete
+ *
+ * @return  0 on success
+ * @return  -ENOENT if @p key is not stored
+ * @return  -ENOSPC if the store is full
+ * @return  <0 on errors of the device
+ */
+int kvstore_delete(kvstore_t *kvs, const char *key);
+
+/**
+ * @brief   List all keys of a store
+ *
+ * @p cb must not call functions of the store.
+ *
+ * @param[in] kvs       store to list
+ * @param[in] cb        callback for every key
+ * @param[in] arg       argument for @p cb
+ *
+ * @return  number of keys
+ * @return  <0 on errors of the device
+ */
+int kvstore_foreach(kvstore_t *kvs, kvstore_cb_t cb, void *arg);
+
+/**
+ * @brief   Get the store initialized last, e.g. for the shell command
+ *
+ * @return  the store, NULL if there is none
+ */
+kvstore_t *kvstore_default(void);
+
+/**
+ * @brief   Start a transaction
+ *
+ * @param[out] txn      transaction to start
+ * @param[in] kvs       store to update
+ * @param[in] buf       buffer for the updates
+ * @param[in] size      size of @p buf
+ */
+void kvstore_txn_init(kvstore_txn_t *txn, kvstore_t *kvs, void *buf,
+                      size_t size);
+
+/**
+ * @brief   Add setting a key to a transaction
+ *
+ * @param[in,out] txn   transaction
+ * @param[in] key       key to set
+ * @param[in] val       value
+ * @param[in] len       length of @p val
+ *
+ * @return  0 on success
+ * @return  -EINVAL if @p key is too long
+ * @return  -ENOBUFS if kvstore_txn_t::buf is full
+ */
+int kvstore_txn_set(kvstore_txn_t *txn, const char *key, const void *val,
+                    size_t len);
+
+/**
+ * @brief   Add deleting a key to a transaction
+ *
+ * @param[in,out] txn   transaction
+ * @param[in] key       key to delete
+ *
+ * @return  0 on success
+ * @return  -EINVAL if @p key is too long
+ * @return  -ENOBUFS if kvstore_txn_t::buf is full
+ */
+int kvstore_txn_delete(kvstore_txn_t *txn, const char *key);
+
+/**
+ * @brief   Apply all updates of a transaction
+ *
+ * The transaction is empty afterwards, regardless of the result.
+ *
+ * @param[in,out] txn   transaction
+ *
+ * @return  0 on success, all updates were applied
+ * @return  -EEXIST if the hash of a key collides with a different key
+ * @return  -ENOMEM if kvstore_t::entries is full
+ * @return  -ENOSPC if the transaction does not fit into the store
+ * @return  <0 on errors of the device
+ */
+int kvstore_txn_commit(kvstore_txn_t *txn);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* KVSTORE_H */
+/** @} */
@@ -36,10 +36,13 @@ extern "C" {
  * @{
  */
 #define COAP_OPT_URI_HOST       (3)
+#define COAP_OPT_ETAG           (4)
 #define COAP_OPT_OBSERVE        (6)
+#define COAP_OPT_URI_PORT       (7)
 #define COAP_OPT_LOCATION_PATH  (8)
 #define COAP_OPT_URI_PATH       (11)
 #define COAP_OPT_CONTENT_FORMAT (12)
+#define COAP_OPT_MAX_AGE        (14)
 #define COAP_OPT_URI_QUERY      (15)
 #define COAP_OPT_ACCEPT         (17)
 #define COAP_OPT_LOCATION_QUERY (20)
@@ -47,6 +50,7 @@ extern "C" {
 #define COAP_OPT_BLOCK1         (27)
 #define COAP_OPT_PROXY_URI      (35)
 #define COAP_OPT_PROXY_SCHEME   (39)
+#define COAP_OPT_SIZE1          (60)
 /** @} */
 
 /**
@@ -130,6 +134,29 @@ extern "C" {
 #define COAP_CODE_PROXYING_NOT_SUPPORTED     ((5 << 5) | 5)
 /** @} */
 
+/**
+ * @name    Signaling message codes (RFC 8323, reliable transports only)
+ * @{
+ */
+#define COAP_CLASS_SIGNAL       (7)
+#define COAP_CODE_CSM          ((7 << 5) | 1)
+#define COAP_CODE_PING         ((7 << 5) | 2)
+#define COAP_CODE_PONG         ((7 << 5) | 3)
+#define COAP_CODE_RELEASE      ((7 << 5) | 4)
+#define COAP_CODE_ABORT        ((7 << 5) | 5)
+/** @} */
+
+/**
+ * @name    Signaling option numbers
+ *
+ * The numbers are specific to the signaling code.
+ * @{
+ */
+#define COAP_SIGNAL_OPT_MAX_MESSAGE_SIZE    (2) /**< CSM */
+#define COAP_SIGNAL_OPT_BLOCK_WISE_TRANSFER (4) /**< CSM */
+#define COAP_SIGNAL_OPT_CUSTODY             (2) /**< Ping and Pong */
+/** @} */
+
 /**
  * @name    Content-Format option codes
  * @anchor  net_coap_format
@@ -221,6 +248,7 @@ extern "C" {
  */
 #define COAP_NSTART             (1)
 #define COAP_DEFAULT_LEISURE    (5)
+#define COAP_DEFAULT_MAX_AGE    (60)
 /** @} */
 
 /**
@@ -231,6 +259,15 @@ extern "C" {
 #define COAP_BLOCKWISE_MORE_OFF (3)
 #define COAP_BLOCKWISE_SZX_MASK (0x07)
 #define COAP_BLOCKWISE_SZX_MAX  (7)
+/**
+ * @brief   SZX of a BERT block (RFC 8323, section 6), a multiple of 1024
+ *          bytes; only used over reliable transports
+ */
+#define COAP_BLOCKWISE_SZX_BERT (7)
+/**
+ * @brief   Unit of the block number of a BERT block, in bytes
+ */
+#define COAP_BLOCKWISE_BERT_UNIT (1024U)
 /** @} */
 
 #ifdef __cplusplus
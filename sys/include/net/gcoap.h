@@ -90,6 +90,12 @@
  * If no payload, call only gcoap_response() to write the full response. If you
  * need to add Options, follow the first three steps in the list above instead.
  *
+ * With module `gcoap_sendfile`, the payload can be sent from a file instead.
+ * Position the file at the start of the payload, call
+ * gcoap_resp_sendfile() instead of writing the payload and return only the
+ * metadata length. gcoap reads the payload directly into the packet buffer of
+ * the network stack when sending the response, see sock_udp_sendfile().
+ *
  * ### Resource list creation ###
  *
  * gcoap allows customization of the function that provides the list of registered
@@ -153,8 +159,10 @@
  *
  * A CoAP client may register for Observe notifications for any resource that
  * an application has registered with gcoap. An application does not need to
- * take any action to support Observe client registration. However, gcoap
- * limits registration for a given resource to a _single_ observer.
+ * take any action to support Observe client registration. Up to
+ * CONFIG_GCOAP_OBS_REGISTRATIONS_MAX registrations from
+ * CONFIG_GCOAP_OBS_CLIENTS_MAX clients are kept, for at most
+ * CONFIG_GCOAP_OBS_RESOURCES_MAX resources at a time.
  *
  * It is [suggested](https://tools.ietf.org/html/rfc7641#section-6) that a
  * server adds the 'obs' attribute to resources that are useful for observation
@@ -190,6 +198,18 @@
  * Finally, call gcoap_obs_send() for the resource, with the sum of the
  * metadata length and payload length for the representation.
  *
+ * The notification is prepared once for all observers of the resource.
+ * gcoap_obs_send() copies it once, then only writes the message ID and the
+ * token of each observer in front of the options and payload of the copy.
+ *
+ * ### Rate limiting ###
+ *
+ * Notifications for a resource that changes quickly may be limited to one
+ * every CONFIG_GCOAP_OBS_MIN_INTERVAL milliseconds. A notification sent
+ * earlier is kept and sent once the interval is over. If another one is sent
+ * meanwhile, it replaces the one kept: observers only receive the latest
+ * state.
+ *
  * ### Other considerations ###
  *
  * By default, the value for the Observe option in a notification is three
@@ -336,7 +356,8 @@
  *
  * ### Proxy Server Handling
  *
- * Not implemented yet.
+ * With module `gcoap_forward_proxy`, gcoap acts as a forward proxy and
+ * caches responses; see @ref net_gcoap_forward_proxy.
  *
  * ## Implementation Notes ##
  *
@@ -346,7 +367,18 @@
  * for a response, so the gcoap thread does not block while waiting. The user is
  * notified via the same callback, whether the message is received or the wait
  * times out. We track the response with an entry in the
- * `_coap_state.open_reqs` array.
+ * `_coap_state.open_reqs` array, found by its token via a hash index.
+ *
+ * ### Congestion control ###
+ *
+ * By default, confirmable requests are retransmitted with the fixed binary
+ * exponential backoff of RFC 7252. With module `gcoap_cocoa`, gcoap keeps
+ * state for up to @ref CONFIG_GCOAP_PEERS_MAX endpoints and follows CoCoA
+ * (draft-ietf-core-cocoa): the retransmission timeout is estimated from the
+ * round-trip times of earlier requests, and at most @ref CONFIG_GCOAP_NSTART
+ * confirmable requests to an endpoint are open at once. Further requests are
+ * queued; gcoap_req_send() reports them as sent. gcoap_get_stats() counts
+ * retransmissions and timeouts.
  *
  * ## Implementation Status ##
  * gcoap includes server and client capability. Available features include:
@@ -417,6 +449,16 @@ extern "C" {
 #ifndef CONFIG_GCOAP_REQ_WAITING_MAX
 #define CONFIG_GCOAP_REQ_WAITING_MAX   (2)
 #endif
+
+/**
+ * @brief   Number of buckets of the index to find open requests by token
+ *
+ * A response is matched to its request by looking up the token in this hash
+ * index, so the lookup stays short even with many open requests.
+ */
+#ifndef CONFIG_GCOAP_REQ_INDEX_SIZE
+#define CONFIG_GCOAP_REQ_INDEX_SIZE    (CONFIG_GCOAP_REQ_WAITING_MAX)
+#endif
 /** @} */
 
 /**
@@ -509,6 +551,39 @@ extern "C" {
 #define CONFIG_GCOAP_OBS_REGISTRATIONS_MAX     (2)
 #endif
 
+/**
+ * @ingroup net_gcoap_conf
+ * @brief   Maximum number of resources observed at a time
+ */
+#ifndef CONFIG_GCOAP_OBS_RESOURCES_MAX
+#define CONFIG_GCOAP_OBS_RESOURCES_MAX  (2)
+#endif
+
+/**
+ * @ingroup net_gcoap_conf
+ * @brief   Number of buckets in the index of Observe registrations
+ *
+ * A registration is looked up by its token in this hash index when a client
+ * registers again or cancels it.
+ */
+#ifndef CONFIG_GCOAP_OBS_INDEX_SIZE
+#define CONFIG_GCOAP_OBS_INDEX_SIZE     (CONFIG_GCOAP_OBS_REGISTRATIONS_MAX)
+#endif
+
+/**
+ * @ingroup net_gcoap_conf
+ * @brief   Minimum interval between two notifications for a resource [in ms]
+ *
+ * A notification sent within the interval is delayed until it is over, and
+ * replaced by a newer one sent meanwhile. Each observed resource then keeps
+ * a buffer of CONFIG_GCOAP_PDU_BUF_SIZE bytes for the delayed notification.
+ *
+ * Set to 0 to send every notification at once.
+ */
+#ifndef CONFIG_GCOAP_OBS_MIN_INTERVAL
+#define CONFIG_GCOAP_OBS_MIN_INTERVAL   (0U)
+#endif
+
 /**
  * @name    States for the memo used to track Observe registrations
  * @{
@@ -578,6 +653,40 @@ extern "C" {
 #define CONFIG_GCOAP_RESEND_BUFS_MAX      (1)
 #endif
 
+/**
+ * @ingroup net_gcoap_conf
+ * @brief   Size of a buffer for resending a confirmable message
+ *
+ * Confirmable requests longer than this are not sent.
+ */
+#ifndef CONFIG_GCOAP_RESEND_BUF_SIZE
+#define CONFIG_GCOAP_RESEND_BUF_SIZE      (CONFIG_GCOAP_PDU_BUF_SIZE)
+#endif
+
+/**
+ * @ingroup net_gcoap_conf
+ * @brief   Maximum number of open confirmable requests to an endpoint
+ *
+ * This is NSTART of RFC 7252, section 4.7. Further confirmable requests to
+ * the endpoint are queued and sent once an open request is answered or times
+ * out. Only used with module `gcoap_cocoa`.
+ */
+#ifndef CONFIG_GCOAP_NSTART
+#define CONFIG_GCOAP_NSTART               (COAP_NSTART)
+#endif
+
+/**
+ * @ingroup net_gcoap_conf
+ * @brief   Number of endpoints to keep congestion control state for
+ *
+ * Requests to further endpoints use the default retransmission timeout and
+ * are not limited by @ref CONFIG_GCOAP_NSTART. Only used with module
+ * `gcoap_cocoa`.
+ */
+#ifndef CONFIG_GCOAP_PEERS_MAX
+#define CONFIG_GCOAP_PEERS_MAX            (4)
+#endif
+
 /**
  * @name Bitwise positional flags for encoding resource links
  * @{
@@ -626,6 +735,11 @@ typedef struct gcoap_listener {
  */
 typedef struct gcoap_request_memo gcoap_request_memo_t;
 
+/**
+ * @brief   Forward declaration of the observe memo type
+ */
+typedef struct gcoap_observe_memo gcoap_observe_memo_t;
+
 /**
  * @brief   Handler function for a server response, including the state for the
  *          originating request
@@ -644,11 +758,17 @@ typedef struct {
     size_t pdu_len;                     /**< Length of pdu_buf */
 } gcoap_resend_t;
 
+/**
+ * @brief   Forward declaration of the congestion control state of an endpoint
+ */
+typedef struct gcoap_peer gcoap_peer_t;
+
 /**
  * @brief   Memo to handle a response for a request
  */
 struct gcoap_request_memo {
     unsigned state;                     /**< State of this memo, a GCOAP_MEMO... */
+    gcoap_request_memo_t *next;         /**< Next memo with the same token hash */
     int send_limit;                     /**< Remaining resends, 0 if none;
                                              GCOAP_SEND_LIMIT_NON if non-confirmable */
     union {
@@ -662,17 +782,46 @@ struct gcoap_request_memo {
     void *context;                      /**< ptr to user defined context data */
     event_timeout_t resp_evt_tmout;     /**< Limits wait for response */
     event_callback_t resp_tmout_cb;     /**< Callback for response timeout */
+#if defined(MODULE_GCOAP_COCOA) || defined(DOXYGEN)
+    gcoap_peer_t *peer;                 /**< Congestion control state of
+                                             remote_ep, if confirmable */
+    gcoap_request_memo_t *queue_next;   /**< Next request queued for peer */
+    uint32_t sent;                      /**< Time of first transmission [ms] */
+    uint32_t timeout;                   /**< Current timeout [ms] */
+#endif
 };
 
 /**
- * @brief   Memo for Observe registration and notifications
+ * @brief   Statistics on requests and notifications sent by gcoap
  */
 typedef struct {
+    uint32_t requests;                  /**< Requests sent for the first time */
+    uint32_t retransmissions;           /**< Retransmissions of confirmable
+                                             requests */
+    uint32_t responses;                 /**< Responses matched to a request */
+    uint32_t timeouts;                  /**< Requests without a response */
+    uint32_t queued;                    /**< Requests queued because of
+                                             @ref CONFIG_GCOAP_NSTART */
+    uint32_t notifications;             /**< Observe notifications sent, one
+                                             per observer */
+    uint32_t conflated;                 /**< Notifications replaced by a newer
+                                             one before they were sent, see
+                                             @ref CONFIG_GCOAP_OBS_MIN_INTERVAL */
+} gcoap_stats_t;
+
+/**
+ * @brief   Memo for Observe registration and notifications
+ */
+struct gcoap_observe_memo {
+    gcoap_observe_memo_t *next;         /**< Next registration for the same
+                                             resource */
+    gcoap_observe_memo_t *index_next;   /**< Next memo with the same token
+                                             hash */
     sock_udp_ep_t *observer;            /**< Client endpoint; unused if null */
     const coap_resource_t *resource;    /**< Entity being observed */
     uint8_t token[GCOAP_TOKENLEN_MAX];  /**< Client token for notifications */
     unsigned token_len;                 /**< Actual length of token attribute */
-} gcoap_observe_memo_t;
+};
 
 /**
  * @brief   Initializes the gcoap thread and device
@@ -783,11 +932,30 @@ static inline ssize_t gcoap_response(coap_pkt_t *pdu, uint8_t *buf,
                 : -1;
 }
 
+/**
+ * @brief   Sends the payload of the response to the current request from a
+ *          file
+ *
+ * May only be called from a resource handler, after the response metadata was
+ * completed with coap_opt_finish() and COAP_OPT_FINISH_PAYLOAD. The handler
+ * then returns the metadata length only. gcoap sends @p len bytes from the
+ * current position of @p fd as payload and closes @p fd afterwards, also if
+ * sending fails. No response is sent if fewer than @p len bytes can be read.
+ *
+ * Only available with module `gcoap_sendfile`.
+ *
+ * @param[in] fd        Open file to read the payload from
+ * @param[in] len       Length of the payload, must be greater than 0
+ */
+void gcoap_resp_sendfile(int fd, size_t len);
+
 /**
  * @brief   Initializes a CoAP Observe notification packet on a buffer, for the
- *          observer registered for a resource
+ *          observers registered for a resource
  *
- * First verifies that an observer has been registered for the resource.
+ * First verifies that an observer has been registered for the resource. The
+ * header carries the longest token of the observers, so that the header of
+ * each observer fits in front of the options.
  *
  * @param[out] pdu      Notification metadata
  * @param[out] buf      Buffer containing the PDU
@@ -803,13 +971,20 @@ int gcoap_obs_init(coap_pkt_t *pdu, uint8_t *buf, size_t len,
 
 /**
  * @brief   Sends a buffer containing a CoAP Observe notification to the
- *          observer registered for a resource
+ *          observers registered for a resource
  *
- * Assumes a single observer for a resource.
+ * The notification is sent to each observer with its token and a new message
+ * ID, which are written over the header of a copy of @p buf. Observers
+ * registered with a longer token than the one in @p buf since
+ * gcoap_obs_init() are skipped. A notification longer than
+ * CONFIG_GCOAP_PDU_BUF_SIZE is not sent.
  *
- * @param[in] buf Buffer containing the PDU
- * @param[in] len Length of the buffer
- * @param[in] resource Resource to send
+ * With @ref CONFIG_GCOAP_OBS_MIN_INTERVAL, the notification may be kept and
+ * sent later, unless it is replaced by a newer one.
+ *
+ * @param[in] buf       Buffer containing the PDU
+ * @param[in] len       Length of the buffer
+ * @param[in] resource  Resource to send
  *
  * @return  length of the packet
  * @return  0 if cannot send
@@ -817,15 +992,43 @@ int gcoap_obs_init(coap_pkt_t *pdu, uint8_t *buf, size_t len,
 size_t gcoap_obs_send(const uint8_t *buf, size_t len,
                       const coap_resource_t *resource);
 
+/**
+ * @brief   Gets a new message ID
+ *
+ * For messages built without gcoap_req_init(), like separate responses.
+ *
+ * @return  message ID, increasing with each call
+ */
+uint16_t gcoap_next_msg_id(void);
+
 /**
  * @brief   Provides important operational statistics
  *
  * Useful for monitoring.
  *
- * @return  count of unanswered requests
+ * @return  count of unanswered requests, at most UINT8_MAX
  */
 uint8_t gcoap_op_state(void);
 
+/**
+ * @brief   Provides statistics on sent requests and notifications
+ *
+ * @param[out] stats    statistics since gcoap_init()
+ */
+void gcoap_get_stats(gcoap_stats_t *stats);
+
+/**
+ * @brief   Provides the retransmission timeout currently used for an endpoint
+ *
+ * With module `gcoap_cocoa`, the timeout is estimated from the round-trip
+ * times of earlier requests, following CoCoA (draft-ietf-core-cocoa).
+ *
+ * @param[in] remote    endpoint
+ *
+ * @return  initial retransmission timeout in milliseconds, before dithering
+ */
+uint32_t gcoap_get_rto(const sock_udp_ep_t *remote);
+
 /**
  * @brief   Get the resource list, currently only `CoRE Link Format`
  *          (COAP_FORMAT_LINK) supported
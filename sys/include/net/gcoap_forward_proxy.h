@@ -0,0 +1,99 @@
+/*
+ * Copyright (C) 2020 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @defgroup    net_gcoap_forward_proxy Gcoap forward proxy
+ * @ingroup     net_gcoap
+ * @brief       Forward proxy for gcoap (RFC 7252, section 5.7) with a
+ *              response cache
+ *
+ * With this module, gcoap forwards requests with a Proxy-Uri or a
+ * Proxy-Scheme option to the origin server instead of passing them to a
+ * listener. The origin server is addressed by an IPv6 literal, as in
+ * `coap://[2001:db8::1]:5683/sensors/temp`. With Proxy-Scheme, the
+ * request carries the address in its Uri-Host option. Only the `coap`
+ * scheme is supported.
+ *
+ * Responses to GET requests are kept in the @ref net_nanocoap_cache. A
+ * request finding a fresh response is answered from the cache without
+ * contacting the origin server. A stale response is validated with its
+ * ETag; if the origin server answers 2.03 Valid, the stored response is
+ * sent to the client.
+ *
+ * A confirmable request that is forwarded is acknowledged at once. The
+ * response of the origin server is then sent to the client as a
+ * non-confirmable separate response. If the origin server does not answer,
+ * the client receives 5.04 Gateway Timeout. Observe registrations are not
+ * proxied.
+ *
+ * The hit rate of the cache is available from nanocoap_cache_get_stats().
+ *
+ * @{
+ *
+ * @file
+ * @brief       Forward proxy for gcoap
+ */
+
+#ifndef NET_GCOAP_FORWARD_PROXY_H
+#define NET_GCOAP_FORWARD_PROXY_H
+
+#include "net/gcoap.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @ingroup net_gcoap_conf
+ * @brief   Number of requests the proxy forwards at once
+ *
+ * Further requests are answered with 5.03 Service Unavailable. Only used
+ * with module `gcoap_forward_proxy`.
+ */
+#ifndef CONFIG_GCOAP_FORWARD_PROXY_CLIENTS_MAX
+#define CONFIG_GCOAP_FORWARD_PROXY_CLIENTS_MAX  (2)
+#endif
+
+/**
+ * @brief   Handles a request with a Proxy-Uri or Proxy-Scheme option
+ *
+ * @note    Called by gcoap.
+ *
+ * @param[in]  pdu      Request
+ * @param[out] buf      Buffer for the response, holds @p pdu
+ * @param[in]  len      Size of @p buf
+ * @param[in]  client   Endpoint of the client
+ *
+ * @return  Length of the response to send now
+ * @return  0 if nothing is sent now
+ */
+size_t gcoap_forward_proxy_request_process(coap_pkt_t *pdu, uint8_t *buf,
+                                           size_t len,
+                                           const sock_udp_ep_t *client);
+
+/**
+ * @brief   Sends a message to a client from the gcoap socket
+ *
+ * @note    Provided by gcoap for the proxy.
+ *
+ * @param[in] buf       Message
+ * @param[in] len       Length of @p buf
+ * @param[in] remote    Client
+ *
+ * @return  Number of bytes sent
+ * @return  <0 on error
+ */
+ssize_t gcoap_forward_proxy_dispatch(const uint8_t *buf, size_t len,
+                                     const sock_udp_ep_t *remote);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* NET_GCOAP_FORWARD_PROXY_H */
+/** @} */
@@ -86,6 +86,20 @@
  *
  * `GNRC_NETAPI_MSG_TYPE_GET` is not supported.
  *
+ * # Receive workers
+ *
+ * With the `gnrc_ipv6_workers` module, received packets are not handled by the
+ * IPv6 thread, but by @ref CONFIG_GNRC_IPV6_WORKERS_NUMOF worker threads, so
+ * a burst of packets on one interface does not delay packets from another.
+ * Packets are assigned to a worker by their receiving interface (or, with
+ * @ref CONFIG_GNRC_IPV6_WORKERS_SHARD_BY_FLOW, by their addresses and flow
+ * label), so packets of the same flow are never reordered. Sending, timers,
+ * and fragmentation are still handled by the IPv6 thread.
+ *
+ * @note    Only packets sent via @ref net_gnrc_netreg reach the workers.
+ *          Packets sent directly to @ref gnrc_ipv6_pid are still handled by
+ *          the IPv6 thread.
+ *
  * @{
  *
  * @file
@@ -149,6 +163,39 @@ extern "C" {
 #define CONFIG_GNRC_IPV6_MSG_QUEUE_SIZE_EXP    (3U)
 #endif
 
+/**
+ * @brief   Number of receive worker threads
+ *
+ * @note    Only applicable with module `gnrc_ipv6_workers`
+ */
+#ifndef CONFIG_GNRC_IPV6_WORKERS_NUMOF
+#define CONFIG_GNRC_IPV6_WORKERS_NUMOF          (2U)
+#endif
+
+/**
+ * @brief   Assign received packets to workers by flow instead of by
+ *          receiving interface
+ *
+ * A flow is identified by source address, destination address, and flow
+ * label of the IPv6 header. Set to 0 to assign packets by the position of
+ * the receiving interface in the interface list instead, which uses at most
+ * one worker per interface.
+ *
+ * @note    Only applicable with module `gnrc_ipv6_workers`
+ */
+#ifndef CONFIG_GNRC_IPV6_WORKERS_SHARD_BY_FLOW
+#define CONFIG_GNRC_IPV6_WORKERS_SHARD_BY_FLOW  1
+#endif
+
+/**
+ * @brief   Default stack size to use for the receive worker threads
+ *
+ * @note    Only applicable with module `gnrc_ipv6_workers`
+ */
+#ifndef GNRC_IPV6_WORKERS_STACK_SIZE
+#define GNRC_IPV6_WORKERS_STACK_SIZE            (THREAD_STACKSIZE_DEFAULT)
+#endif
+
 #ifdef DOXYGEN
 /**
  * @brief   Add a static IPv6 link local address to any network interface
@@ -67,6 +67,35 @@ extern "C" {
 #define CONFIG_GNRC_IPV6_EXT_FRAG_RBUF_SIZE        (1U)
 #endif
 
+/**
+ * @brief   Number of hash buckets of the IPv6 fragmentation reassembly buffer
+ *
+ * Entries of the reassembly buffer are looked up by hashing the identification
+ * and the addresses of a fragment into one of these buckets.
+ *
+ * @note    Only applicable with [gnrc_ipv6_ext_frag](@ref net_gnrc_ipv6_ext_frag) module
+ * @note    Must be less than 256
+ */
+#ifndef CONFIG_GNRC_IPV6_EXT_FRAG_RBUF_BUCKETS
+#define CONFIG_GNRC_IPV6_EXT_FRAG_RBUF_BUCKETS     (CONFIG_GNRC_IPV6_EXT_FRAG_RBUF_SIZE)
+#endif
+
+/**
+ * @brief   Maximum number of bytes fragments from a single source may occupy
+ *          in the IPv6 fragmentation reassembly buffer
+ *
+ * Fragments that would exceed this limit are dropped, so a single source
+ * flooding fragments can not occupy the reassembly buffer (and the packet
+ * buffer) for other sources. Atomic fragments are not counted. By default
+ * (0) there is no limit and only the size of the packet buffer limits the
+ * datagrams reassembled.
+ *
+ * @note    Only applicable with [gnrc_ipv6_ext_frag](@ref net_gnrc_ipv6_ext_frag) module
+ */
+#ifndef CONFIG_GNRC_IPV6_EXT_FRAG_RBUF_SRC_MAX
+#define CONFIG_GNRC_IPV6_EXT_FRAG_RBUF_SRC_MAX     (0U)
+#endif
+
 /**
  * @brief   The number of total allocatable @ref gnrc_ipv6_ext_frag_limits_t objects
  *
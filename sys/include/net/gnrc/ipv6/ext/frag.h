@@ -58,6 +58,7 @@ extern "C" {
  */
 typedef struct gnrc_ipv6_ext_frag_limits {
     struct gnrc_ipv6_ext_frag_limits *next; /**< limits of next fragment */
+    gnrc_pktsnip_t *pkt;                    /**< payload of the fragment */
     uint16_t start;                         /**< the start (= offset) of the fragment */
     uint16_t end;                           /**< the exclusive end (= offset + length) of the
                                              *   fragment */
@@ -77,9 +78,17 @@ typedef struct {
 
 /**
  * @brief   A reassembly buffer entry
+ *
+ * The payloads of the received fragments are not copied on arrival but kept
+ * in their own snips, referenced by the entries of
+ * gnrc_ipv6_ext_frag_rbuf_t::limits. They are gathered into a single snip
+ * only once the datagram is complete.
  */
-typedef struct {
-    gnrc_pktsnip_t *pkt;    /**< the (partly) reassembled packet */
+typedef struct gnrc_ipv6_ext_frag_rbuf {
+    struct gnrc_ipv6_ext_frag_rbuf *next;   /**< next entry in the same hash
+                                             *   bucket or the free list */
+    gnrc_pktsnip_t *pkt;    /**< the headers of the reassembled packet in
+                             *   receive order (without payload) */
     ipv6_hdr_t *ipv6;       /**< the IPv6 header of gnrc_ipv6_ext_frag_rbuf_t::pkt */
     /**
      * @brief   The limits of the fragments in the reassembled packet
@@ -89,7 +98,9 @@ typedef struct {
     clist_node_t limits;
     uint32_t id;            /**< the identification from the fragment headers */
     uint32_t arrival;       /**< arrival time of last received fragment */
-    uint16_t pkt_len;       /**< length of gnrc_ipv6_ext_frag_rbuf_t::pkt */
+    uint16_t pkt_len;       /**< length of the reassembled IPv6 payload */
+    uint16_t held;          /**< number of payload bytes held by the fragments */
+    uint8_t bucket;         /**< hash bucket of the entry */
     uint8_t last;           /**< received last fragment */
 } gnrc_ipv6_ext_frag_rbuf_t;
 
@@ -103,6 +114,11 @@ typedef struct {
                              *   no @ref gnrc_sixlowpan_frag_fb_t available */
     unsigned datagrams;     /**< reassembled datagrams */
     unsigned fragments;     /**< total fragments of reassembled fragments */
+    unsigned src_full;      /**< counts the number of fragments dropped
+                             *   because their source exceeded
+                             *   @ref CONFIG_GNRC_IPV6_EXT_FRAG_RBUF_SRC_MAX */
+    unsigned overlaps;      /**< counts the number of datagrams dropped due to
+                             *   overlapping fragments */
 } gnrc_ipv6_ext_frag_stats_t;
 
 /**
@@ -169,6 +185,8 @@ gnrc_ipv6_ext_frag_rbuf_t *gnrc_ipv6_ext_frag_rbuf_get(ipv6_hdr_t *ipv6,
  * @brief   Frees a reassembly buffer entry (but does not release its
  *          gnrc_ipv6_ext_frag_rbuf_t::pkt)
  *
+ * Payloads of fragments still stored in the entry are released.
+ *
  * @param[in] rbuf  A reassembly buffer entry.
  */
 void gnrc_ipv6_ext_frag_rbuf_free(gnrc_ipv6_ext_frag_rbuf_t *rbuf);
@@ -53,6 +53,9 @@
 #include "net/gnrc/netif/dedup.h"
 #endif
 #include "net/gnrc/netif/flags.h"
+#if IS_USED(MODULE_GNRC_NETIF_FQ)
+#include "net/gnrc/netif/fq.h"
+#endif
 #if IS_USED(MODULE_GNRC_NETIF_IPV6)
 #include "net/gnrc/netif/ipv6.h"
 #endif
@@ -171,6 +174,14 @@ typedef struct {
 #endif
 #if IS_USED(MODULE_GNRC_NETIF_6LO) || defined(DOXYGEN)
     gnrc_netif_6lo_t sixlo;                 /**< 6Lo component */
+#endif
+#if IS_USED(MODULE_GNRC_NETIF_FQ) || defined(DOXYGEN)
+    /**
+     * @brief   Flow-fair send queue
+     *
+     * @note    Only available with @ref net_gnrc_netif_fq.
+     */
+    gnrc_netif_fq_t fq;
 #endif
     uint8_t cur_hl;                         /**< Current hop-limit for out-going packets */
     uint8_t device_type;                    /**< Device type */
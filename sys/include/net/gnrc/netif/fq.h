@@ -0,0 +1,199 @@
+/*
+ * Copyright (C) 2020 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @defgroup    net_gnrc_netif_fq   Flow-fair send queue
+ * @ingroup     net_gnrc_netif
+ * @brief       Deficit round robin queueing of outgoing packets per flow
+ *
+ * To activate, use `USEMODULE += gnrc_netif_fq` in your applications
+ * Makefile.
+ *
+ * Without this module a network interface sends packets in the order they
+ * arrive in its message queue, so a single bulk sender can fill that queue and
+ * delay everything else sent over the interface. With this module, the
+ * interface first moves all pending packets into a per-interface queue and
+ * then sends them using deficit round robin (DRR) between flows.
+ *
+ * Packets are classified as follows:
+ *
+ * - Network control traffic, i.e. NDP and RPL messages and IPv6 packets
+ *   with a DSCP of CS6 or CS7, is put into a dedicated flow that is always
+ *   served first.
+ * - Other IPv6 packets, including other ICMPv6 messages such as echo
+ *   requests, are assigned to one of the remaining
+ *   @ref CONFIG_GNRC_NETIF_FQ_FLOWS_NUMOF - 1 flows by a hash over source
+ *   address, destination address, flow label and next header.
+ * - On 6LoWPAN interfaces the same rules apply to the IPHC header, or to
+ *   the IPv6 header of uncompressed packets. Addresses elided by IPHC are
+ *   hashed through the link-layer destination. All fragments of a datagram
+ *   are put into the same flow, by datagram tag.
+ * - Packets without an IPv6 header share a single flow.
+ *
+ * If the queue is full, the oldest packet of the longest flow is dropped.
+ * When the link goes down, all queued packets are dropped.
+ *
+ * @{
+ *
+ * @file
+ * @brief   Flow-fair send queue definitions
+ */
+#ifndef NET_GNRC_NETIF_FQ_H
+#define NET_GNRC_NETIF_FQ_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "net/gnrc/pkt.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @defgroup    net_gnrc_netif_fq_conf  Flow-fair send queue compile configurations
+ * @ingroup     net_gnrc_netif_conf
+ * @{
+ */
+/**
+ * @brief   Maximum number of packets in the send queue of an interface
+ *
+ * @note    Must be less than 255
+ */
+#ifndef CONFIG_GNRC_NETIF_FQ_SIZE
+#define CONFIG_GNRC_NETIF_FQ_SIZE           (16U)
+#endif
+
+/**
+ * @brief   Number of flows per interface, including the network control flow
+ *
+ * @note    Must be at least 2 and less than 255
+ */
+#ifndef CONFIG_GNRC_NETIF_FQ_FLOWS_NUMOF
+#define CONFIG_GNRC_NETIF_FQ_FLOWS_NUMOF    (8U)
+#endif
+
+/**
+ * @brief   Number of bytes a flow may send per round
+ */
+#ifndef CONFIG_GNRC_NETIF_FQ_QUANTUM
+#define CONFIG_GNRC_NETIF_FQ_QUANTUM        (256U)
+#endif
+/** @} */
+
+/**
+ * @brief   Index of the network control flow
+ */
+#define GNRC_NETIF_FQ_FLOW_CTRL             (0U)
+
+/**
+ * @brief   Statistics of a send queue
+ */
+typedef struct {
+    uint32_t enqueued;      /**< number of packets enqueued */
+    uint32_t dropped;       /**< number of packets dropped due to a full queue */
+    uint32_t delay_avg;     /**< moving average of the queueing delay in us */
+    uint32_t delay_max;     /**< maximum queueing delay in us */
+} gnrc_netif_fq_stats_t;
+
+/**
+ * @brief   A queued packet
+ */
+typedef struct {
+    gnrc_pktsnip_t *pkt;    /**< the packet */
+    uint32_t arrival;       /**< time the packet was enqueued in us */
+    uint8_t next;           /**< index of the next entry of the same flow */
+} gnrc_netif_fq_entry_t;
+
+/**
+ * @brief   A flow
+ */
+typedef struct {
+    int32_t deficit;        /**< bytes the flow may still send this round */
+    uint8_t head;           /**< index of the first entry of the flow */
+    uint8_t tail;           /**< index of the last entry of the flow */
+    uint8_t len;            /**< number of packets of the flow */
+    uint8_t next;           /**< next flow in round robin order */
+} gnrc_netif_fq_flow_t;
+
+/**
+ * @brief   Flow-fair send queue of an interface
+ */
+typedef struct {
+    gnrc_netif_fq_entry_t entries[CONFIG_GNRC_NETIF_FQ_SIZE];   /**< packets */
+    gnrc_netif_fq_flow_t flows[CONFIG_GNRC_NETIF_FQ_FLOWS_NUMOF]; /**< flows */
+    gnrc_netif_fq_stats_t stats;    /**< statistics */
+    uint8_t free;           /**< first unused entry */
+    uint8_t active;         /**< first flow in round robin order */
+    uint8_t active_tail;    /**< last flow in round robin order */
+    uint8_t len;            /**< number of packets in the queue */
+} gnrc_netif_fq_t;
+
+/**
+ * @brief   Initializes a send queue
+ *
+ * @param[out] fq   The send queue
+ */
+void gnrc_netif_fq_init(gnrc_netif_fq_t *fq);
+
+/**
+ * @brief   Checks if a send queue is empty
+ *
+ * @param[in] fq    The send queue
+ *
+ * @return  true, if @p fq contains no packets
+ */
+static inline bool gnrc_netif_fq_empty(const gnrc_netif_fq_t *fq)
+{
+    return (fq->len == 0);
+}
+
+/**
+ * @brief   Gets the flow a packet is assigned to
+ *
+ * @param[in] pkt   A packet in send order
+ *
+ * @return  Index of the flow, @ref GNRC_NETIF_FQ_FLOW_CTRL for network
+ *          control traffic
+ */
+unsigned gnrc_netif_fq_classify(gnrc_pktsnip_t *pkt);
+
+/**
+ * @brief   Adds a packet to a send queue
+ *
+ * If the queue is full, the oldest packet of the longest flow is released
+ * first.
+ *
+ * @param[in] fq    The send queue
+ * @param[in] pkt   A packet in send order
+ */
+void gnrc_netif_fq_enqueue(gnrc_netif_fq_t *fq, gnrc_pktsnip_t *pkt);
+
+/**
+ * @brief   Removes the next packet to send from a send queue
+ *
+ * @param[in] fq    The send queue
+ *
+ * @return  The next packet to send
+ * @return  NULL, if @p fq is empty
+ */
+gnrc_pktsnip_t *gnrc_netif_fq_dequeue(gnrc_netif_fq_t *fq);
+
+/**
+ * @brief   Releases all packets in a send queue
+ *
+ * @param[in] fq    The send queue
+ */
+void gnrc_netif_fq_flush(gnrc_netif_fq_t *fq);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* NET_GNRC_NETIF_FQ_H */
+/** @} */
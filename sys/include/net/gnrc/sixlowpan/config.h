@@ -158,6 +158,19 @@ extern "C" {
 #define CONFIG_GNRC_SIXLOWPAN_ND_AR_LTIME          (15U)
 #endif
 
+/**
+ * @brief   Number of flows the IPHC compression cache can hold
+ *
+ * Each entry memoizes the compressed source and destination address of one
+ * (source, destination, interface) tuple, so subsequent packets of that flow
+ * skip the context lookups and link-layer address derivation.
+ *
+ * @note    Only applicable with gnrc_sixlowpan_iphc_cache module
+ */
+#ifndef CONFIG_GNRC_SIXLOWPAN_IPHC_CACHE_SIZE
+#define CONFIG_GNRC_SIXLOWPAN_IPHC_CACHE_SIZE      (4U)
+#endif  /* CONFIG_GNRC_SIXLOWPAN_IPHC_CACHE_SIZE */
+
 /**
  * @brief   Size of the virtual reassembly buffer
  *
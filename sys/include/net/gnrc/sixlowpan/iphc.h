@@ -10,6 +10,13 @@
  * @defgroup    net_gnrc_sixlowpan_iphc   IPv6 header compression (IPHC)
  * @ingroup     net_gnrc_sixlowpan
  * @brief       IPv6 header compression for 6LoWPAN.
+ *
+ * With the `gnrc_sixlowpan_iphc_cache` module the compressed form of the
+ * source and destination address is memoized per (source, destination,
+ * interface) tuple, so for subsequent packets of a flow only the variable
+ * fields (traffic class, flow label, hop limit, and the next headers) need to
+ * be compressed. The number of cached flows can be configured with
+ * @ref CONFIG_GNRC_SIXLOWPAN_IPHC_CACHE_SIZE.
  * @{
  *
  * @file
@@ -57,6 +64,22 @@ void gnrc_sixlowpan_iphc_recv(gnrc_pktsnip_t *pkt, void *ctx, unsigned page);
  */
 void gnrc_sixlowpan_iphc_send(gnrc_pktsnip_t *pkt, void *ctx, unsigned page);
 
+#if defined(MODULE_GNRC_SIXLOWPAN_IPHC_CACHE) || defined(DOXYGEN)
+/**
+ * @brief   Removes all entries from the compression cache.
+ *
+ * Entries are invalidated automatically when the context buffer changes or
+ * the link-layer address of an interface changes, so this is only needed
+ * when the cache needs to be cold, e.g. for benchmarking.
+ *
+ * May be called from any thread: the cache is only accessed by the 6LoWPAN
+ * thread, which flushes it before it compresses the next packet.
+ *
+ * @note    Only available with the `gnrc_sixlowpan_iphc_cache` module.
+ */
+void gnrc_sixlowpan_iphc_cache_flush(void);
+#endif  /* defined(MODULE_GNRC_SIXLOWPAN_IPHC_CACHE) || defined(DOXYGEN) */
+
 #ifdef __cplusplus
 }
 #endif
@@ -173,6 +173,9 @@ typedef struct __attribute__((packed)) {
 
 /**
  * @brief   CoAP option array entry
+ *
+ * In coap_pkt_t::options, an entry locates the first option with the option
+ * number. Repeated options follow it in the packet.
  */
 typedef struct {
     uint16_t opt_num;           /**< full CoAP option number    */
@@ -188,7 +191,12 @@ typedef struct {
     uint8_t *payload;                                 /**< pointer to payload      */
     uint16_t payload_len;                             /**< length of payload       */
     uint16_t options_len;                             /**< length of options array */
-    coap_optpos_t options[CONFIG_NANOCOAP_NOPTS_MAX]; /**< option offset array     */
+    uint32_t options_map;                             /**< bit n set if option
+                                                           number n < 32 is in
+                                                           options array     */
+    coap_optpos_t options[CONFIG_NANOCOAP_NOPTS_MAX]; /**< option offset array,
+                                                           ascending by option
+                                                           number            */
 #ifdef MODULE_GCOAP
     uint32_t observe_value;                           /**< observe value           */
 #endif
@@ -1693,6 +1701,24 @@ extern ssize_t coap_well_known_core_default_handler(coap_pkt_t *pkt, \
  */
 int coap_match_path(const coap_resource_t *resource, uint8_t *uri);
 
+/**
+ * @brief   Checks if a CoAP resource path matches the Uri-Path of a packet
+ *
+ * Same as coap_match_path() with the URI of coap_get_uri_path(), but compares
+ * the Uri-Path options in place, without copying them.
+ *
+ * @note This function is not intended for application use.
+ * @internal
+ *
+ * @param[in] resource CoAP resource to check
+ * @param[in] pkt      Parsed packet
+ *
+ * @return 0  if the resource path matches the URI
+ * @return <0 if the resource path sorts before the URI
+ * @return >0 if the resource path sorts after the URI
+ */
+int coap_match_path_pkt(const coap_resource_t *resource, const coap_pkt_t *pkt);
+
 #if defined(MODULE_GCOAP) || defined(DOXYGEN)
 /**
  * @name    Functions -- gcoap specific
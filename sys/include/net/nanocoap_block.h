@@ -0,0 +1,218 @@
+/*
+ * Copyright (C) 2020 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @defgroup    net_nanocoap_block Nanocoap block-wise server
+ * @ingroup     net_nanocoap
+ * @brief       Block-wise transfers (RFC 7959) for resource handlers
+ *
+ * With the slicer helpers of nanocoap, a handler regenerates its whole
+ * representation up to the requested block for every Block2 request. For
+ * large generated payloads, transferring all blocks thus takes time
+ * quadratic in the size of the representation.
+ *
+ * This module serves Block2 requests from a @ref coap_block_producer_t,
+ * which writes the representation as a stream. After each block, the state
+ * of the producer is kept in a small cache, together with the ETag of the
+ * representation and the offset at which the producer stopped. When the
+ * next block is requested, the producer resumes from the cached state.
+ * Without a matching cache entry, for instance after the entry was evicted
+ * by other transfers, the producer starts over and skips to the requested
+ * offset.
+ *
+ * The ETag identifies the representation. A handler must change it whenever
+ * the content changes, so that no state of an earlier version is resumed.
+ * Clients see it in the ETag option of each block.
+ *
+ * For Block1 requests, coap_block1_reply() passes each block to a
+ * @ref coap_block_sink_t at its offset and answers with 2.31 Continue until
+ * the last block. Sinks for a vfs file and for an MTD device are provided.
+ *
+ * Handlers using this module work with both gcoap and nanocoap_sock. gcoap
+ * serves `/.well-known/core` block-wise when this module is used.
+ *
+ * @{
+ *
+ * @file
+ * @brief       Block-wise server engine for nanocoap
+ */
+
+#ifndef NET_NANOCOAP_BLOCK_H
+#define NET_NANOCOAP_BLOCK_H
+
+#include <stdint.h>
+#include <sys/types.h>
+
+#include "net/nanocoap.h"
+
+#ifdef MODULE_MTD
+#include "mtd.h"
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @ingroup net_nanocoap_conf
+ * @{
+ */
+/**
+ * @brief   Number of producer states kept between Block2 requests
+ */
+#ifndef CONFIG_NANOCOAP_BLOCK_CACHE_SIZE
+#define CONFIG_NANOCOAP_BLOCK_CACHE_SIZE    (4)
+#endif
+
+/**
+ * @brief   Size of the state of a producer, in bytes
+ */
+#ifndef CONFIG_NANOCOAP_BLOCK_STATE_SIZE
+#define CONFIG_NANOCOAP_BLOCK_STATE_SIZE    (16)
+#endif
+/** @} */
+
+/**
+ * @brief   Writes the next bytes of a representation
+ *
+ * @param[in,out] state     State of the producer
+ * @param[out]    buf       Buffer to write to
+ * @param[in]     len       Number of bytes requested
+ * @param[in]     arg       Argument given to coap_block2_reply()
+ *
+ * @return  Number of bytes written; less than @p len only at the end of the
+ *          representation
+ * @return  <0 on error
+ */
+typedef ssize_t (*coap_block_read_t)(void *state, uint8_t *buf, size_t len,
+                                     void *arg);
+
+/**
+ * @brief   Streaming producer of a representation
+ */
+typedef struct {
+    /**
+     * @brief   Initializes @p state to the start of the representation
+     *
+     * The state is CONFIG_NANOCOAP_BLOCK_STATE_SIZE bytes, aligned like a
+     * pointer, and is copied between requests.
+     */
+    void (*init)(void *state, void *arg);
+    coap_block_read_t read;             /**< Writes the next bytes */
+} coap_block_producer_t;
+
+/**
+ * @brief   Writes a block of data received with a Block1 request
+ *
+ * Retransmitted blocks are written again at the same offset.
+ *
+ * @param[in] arg       Argument given to coap_block1_reply()
+ * @param[in] offset    Offset of @p data in the transferred representation
+ * @param[in] data      Data of the block
+ * @param[in] len       Length of @p data
+ *
+ * @return  0 on success
+ * @return  -ENOSPC if the representation does not fit
+ * @return  <0 on other errors
+ */
+typedef int (*coap_block_sink_t)(void *arg, size_t offset,
+                                 const uint8_t *data, size_t len);
+
+/**
+ * @brief   Builds the response to a Block2 request
+ *
+ * The response carries an ETag, a Content-Format and a Block2 option. The
+ * block size is the one requested, limited by
+ * CONFIG_NANOCOAP_BLOCK_SIZE_EXP_MAX and by the size of @p buf. A BERT
+ * request (SZX 7, over reliable transports) gets as many 1024 byte units as
+ * fit into @p buf.
+ *
+ * @param[in]  pkt          Request to answer
+ * @param[out] buf          Buffer for the response
+ * @param[in]  len          Size of @p buf
+ * @param[in]  ct           Content-Format of the representation
+ * @param[in]  producer     Producer of the representation
+ * @param[in]  etag         Version of the representation
+ * @param[in]  arg          Argument passed to the producer
+ *
+ * @return  Length of the response
+ * @return  <0 if @p buf is too small for a response
+ */
+ssize_t coap_block2_reply(coap_pkt_t *pkt, uint8_t *buf, size_t len,
+                          unsigned ct, const coap_block_producer_t *producer,
+                          uint32_t etag, void *arg);
+
+/**
+ * @brief   Passes the payload of a Block1 request to a sink and builds the
+ *          response
+ *
+ * A request without Block1 option is written as a single block at offset 0.
+ * While more blocks follow, the response is 2.31 Continue; the last block is
+ * answered with @p code. Both carry the Block1 option of the request. If the
+ * sink fails, the response is 4.13 Request Entity Too Large for -ENOSPC, and
+ * 5.00 Internal Server Error otherwise.
+ *
+ * @param[in]  pkt          Request to answer
+ * @param[out] buf          Buffer for the response
+ * @param[in]  len          Size of @p buf
+ * @param[in]  code         Response code after the last block
+ * @param[in]  sink         Sink for the received data
+ * @param[in]  arg          Argument passed to the sink
+ *
+ * @return  Length of the response
+ * @return  <0 if @p buf is too small for a response
+ */
+ssize_t coap_block1_reply(coap_pkt_t *pkt, uint8_t *buf, size_t len,
+                          unsigned code, coap_block_sink_t sink, void *arg);
+
+/**
+ * @brief   Drops all cached producer states
+ */
+void coap_block_cache_clear(void);
+
+#if defined(MODULE_VFS) || defined(DOXYGEN)
+/**
+ * @brief   Sink writing to a vfs file
+ *
+ * @p arg points to the `int` file descriptor, which must be open for
+ * writing.
+ */
+int coap_block_sink_vfs(void *arg, size_t offset, const uint8_t *data,
+                        size_t len);
+#endif
+
+#if defined(MODULE_MTD) || defined(DOXYGEN)
+/**
+ * @brief   Area of an MTD device written by coap_block_sink_mtd()
+ */
+typedef struct {
+    mtd_dev_t *mtd;                     /**< Device */
+    uint32_t addr;                      /**< Start of the area, aligned to a
+                                             sector */
+    uint32_t size;                      /**< Size of the area */
+    uint32_t erased;                    /**< Bytes from @p addr on erased for
+                                             the transfer; set to 0 before it
+                                             starts */
+} coap_block_mtd_t;
+
+/**
+ * @brief   Sink writing to an MTD device
+ *
+ * @p arg points to a @ref coap_block_mtd_t. Sectors are erased when a block
+ * reaches them.
+ */
+int coap_block_sink_mtd(void *arg, size_t offset, const uint8_t *data,
+                        size_t len);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* NET_NANOCOAP_BLOCK_H */
+/** @} */
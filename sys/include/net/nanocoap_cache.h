@@ -0,0 +1,210 @@
+/*
+ * Copyright (C) 2020 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @defgroup    net_nanocoap_cache Nanocoap response cache
+ * @ingroup     net_nanocoap
+ * @brief       RAM cache for CoAP responses (RFC 7252, section 5.6)
+ *
+ * The cache keeps up to @ref CONFIG_NANOCOAP_CACHE_ENTRIES responses in
+ * statically allocated entries. An entry is found by the cache key of the
+ * request: a hash over the method and all options of the request, except
+ * those marked NoCacheKey and the ETag option. When the cache is full, the
+ * least recently used entry is replaced.
+ *
+ * A stored response is fresh for the time given by its Max-Age option, or
+ * for @ref COAP_DEFAULT_MAX_AGE seconds without one. Responses built from an
+ * entry carry the remaining time in their Max-Age option. A stale entry may
+ * be validated with the ETag of the stored response: a 2.03 Valid response
+ * from the origin server makes it fresh again.
+ *
+ * The cache is not thread-safe. With gcoap, it is used from the gcoap thread
+ * only.
+ *
+ * @{
+ *
+ * @file
+ * @brief       Response cache for nanocoap
+ */
+
+#ifndef NET_NANOCOAP_CACHE_H
+#define NET_NANOCOAP_CACHE_H
+
+#include <stdint.h>
+#include <sys/types.h>
+
+#include "net/nanocoap.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @ingroup net_nanocoap_conf
+ * @{
+ */
+/**
+ * @brief   Number of responses in the cache
+ */
+#ifndef CONFIG_NANOCOAP_CACHE_ENTRIES
+#define CONFIG_NANOCOAP_CACHE_ENTRIES       (8)
+#endif
+
+/**
+ * @brief   Maximum length of a stored response, in bytes
+ *
+ * Longer responses are not stored.
+ */
+#ifndef CONFIG_NANOCOAP_CACHE_RESPONSE_SIZE
+#define CONFIG_NANOCOAP_CACHE_RESPONSE_SIZE (128)
+#endif
+
+/**
+ * @brief   Length of a cache key, in bytes
+ *
+ * The key is a truncated SHA-256 hash, at most 32 bytes.
+ */
+#ifndef CONFIG_NANOCOAP_CACHE_KEY_LENGTH
+#define CONFIG_NANOCOAP_CACHE_KEY_LENGTH    (8)
+#endif
+/** @} */
+
+/**
+ * @brief   Stored response
+ */
+typedef struct {
+    uint8_t key[CONFIG_NANOCOAP_CACHE_KEY_LENGTH];  /**< Cache key of the
+                                                         request */
+    uint8_t response[CONFIG_NANOCOAP_CACHE_RESPONSE_SIZE]; /**< Response */
+    uint16_t response_len;              /**< Length of the response, 0 if the
+                                             entry is unused */
+    uint32_t expires;                   /**< End of freshness [s] */
+    uint32_t used;                      /**< Time of last use, for eviction */
+} nanocoap_cache_entry_t;
+
+/**
+ * @brief   Statistics of the cache
+ */
+typedef struct {
+    uint32_t hits;                      /**< Lookups finding a fresh response */
+    uint32_t stale;                     /**< Lookups finding a stale response */
+    uint32_t misses;                    /**< Lookups finding no response */
+    uint32_t validations;               /**< Stale responses made fresh again
+                                             by 2.03 Valid */
+    uint32_t stored;                    /**< Responses stored */
+    uint32_t evictions;                 /**< Entries replaced while in use */
+} nanocoap_cache_stats_t;
+
+/**
+ * @brief   Generates the cache key of a request
+ *
+ * @param[in]  req      Request
+ * @param[out] key      Cache key, @ref CONFIG_NANOCOAP_CACHE_KEY_LENGTH bytes
+ */
+void nanocoap_cache_key_generate(coap_pkt_t *req, uint8_t *key);
+
+/**
+ * @brief   Looks up the response stored for a cache key
+ *
+ * Counts a hit, a stale entry or a miss in the statistics.
+ *
+ * @param[in] key       Cache key of the request
+ *
+ * @return  Entry, fresh or stale
+ * @return  NULL if no response is stored for @p key
+ */
+nanocoap_cache_entry_t *nanocoap_cache_lookup(const uint8_t *key);
+
+/**
+ * @brief   Stores a response
+ *
+ * Only 2.05 Content responses with a Max-Age other than 0 are stored. A
+ * response stored before for @p key is replaced.
+ *
+ * @param[in] key       Cache key of the request
+ * @param[in] resp      Response
+ * @param[in] resp_len  Length of @p resp
+ *
+ * @return  Entry of the response
+ * @return  NULL if the response was not stored
+ */
+nanocoap_cache_entry_t *nanocoap_cache_add(const uint8_t *key,
+                                           coap_pkt_t *resp,
+                                           size_t resp_len);
+
+/**
+ * @brief   Makes a stale entry fresh again after a 2.03 Valid response
+ *
+ * @param[in,out] ce    Entry validated by @p resp
+ * @param[in]     resp  2.03 Valid response, its Max-Age gives the new
+ *                      freshness
+ */
+void nanocoap_cache_validate(nanocoap_cache_entry_t *ce, coap_pkt_t *resp);
+
+/**
+ * @brief   Checks whether an entry is stale
+ */
+bool nanocoap_cache_entry_is_stale(const nanocoap_cache_entry_t *ce);
+
+/**
+ * @brief   Gets the ETag of a stored response
+ *
+ * @param[in]  ce       Entry
+ * @param[out] etag     ETag in the stored response
+ *
+ * @return  Length of the ETag
+ * @return  -ENOENT if the response has no ETag
+ */
+ssize_t nanocoap_cache_entry_etag(const nanocoap_cache_entry_t *ce,
+                                  uint8_t **etag);
+
+/**
+ * @brief   Builds a message from a stored response
+ *
+ * The code, options and payload are those of the stored response. Max-Age is
+ * set to the remaining freshness.
+ *
+ * @param[in]  ce       Entry
+ * @param[out] buf      Buffer for the message
+ * @param[in]  len      Size of @p buf
+ * @param[in]  type     Message type
+ * @param[in]  token    Token of the message
+ * @param[in]  token_len Length of @p token
+ * @param[in]  id       Message ID
+ *
+ * @return  Length of the message
+ * @return  -ENOSPC if @p buf is too small
+ */
+ssize_t nanocoap_cache_entry_build(const nanocoap_cache_entry_t *ce,
+                                   uint8_t *buf, size_t len, unsigned type,
+                                   const uint8_t *token, size_t token_len,
+                                   uint16_t id);
+
+/**
+ * @brief   Removes an entry
+ */
+void nanocoap_cache_del(nanocoap_cache_entry_t *ce);
+
+/**
+ * @brief   Removes all entries and resets the statistics
+ */
+void nanocoap_cache_clear(void);
+
+/**
+ * @brief   Gets the statistics of the cache
+ *
+ * @param[out] stats    Statistics
+ */
+void nanocoap_cache_get_stats(nanocoap_cache_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* NET_NANOCOAP_CACHE_H */
+/** @} */
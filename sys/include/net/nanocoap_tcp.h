@@ -0,0 +1,314 @@
+/*
+ * Copyright (C) 2020 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @defgroup    net_nanocoap_tcp Nanocoap over TCP
+ * @ingroup     net_nanocoap
+ * @brief       CoAP over TCP (RFC 8323) with sock_tcp
+ *
+ * Over TCP, CoAP messages have neither a type nor a message ID, and their
+ * header carries the length of the options and the payload. In memory,
+ * nanocoap keeps them in the format of RFC 7252: a received message is
+ * stored behind a 4 byte header of type CON and message ID 0, so that
+ * coap_parse(), resource handlers and coap_handle_req() work unchanged. When
+ * a message is sent, this header is replaced by the one of RFC 8323 in
+ * place.
+ *
+ * A @ref coap_tcp_parser_t reassembles messages from the byte stream in
+ * chunks of any size. The body of a message may be received in place,
+ * avoiding a copy.
+ *
+ * Both ends open a connection with a Capabilities and Settings Message
+ * (CSM), which announces the largest message they receive and their support
+ * of BERT, block-wise transfers with blocks of a multiple of 1024 bytes
+ * (RFC 8323, section 6). Block2 responses of @ref net_nanocoap_block carry
+ * as many 1024 byte units as fit into the buffer of the server when a
+ * client requests SZX 7. Ping signals are answered with Pong, Release and
+ * Abort close the connection.
+ *
+ * There is no retransmission and no congestion control in CoAP over TCP,
+ * the transport provides both. With BERT, a round trip carries as many KiB
+ * as the buffers of both ends hold, instead of at most 1024 bytes.
+ *
+ * A sock_tcp implementation is needed, such as `lwip_sock_tcp`.
+ *
+ * @{
+ *
+ * @file
+ * @brief       CoAP over TCP for nanocoap
+ */
+
+#ifndef NET_NANOCOAP_TCP_H
+#define NET_NANOCOAP_TCP_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#include "net/nanocoap.h"
+#include "net/sock/tcp.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @ingroup net_nanocoap_conf
+ * @{
+ */
+/**
+ * @brief   Time to wait for data from the peer, in milliseconds
+ */
+#ifndef CONFIG_NANOCOAP_TCP_TIMEOUT_MS
+#define CONFIG_NANOCOAP_TCP_TIMEOUT_MS      (5000U)
+#endif
+
+/**
+ * @brief   Size of the receive buffer of a connection, in bytes
+ *
+ * Message headers and short messages are read through this buffer. Longer
+ * bodies are received in place.
+ */
+#ifndef CONFIG_NANOCOAP_TCP_RX_BUF_SIZE
+#define CONFIG_NANOCOAP_TCP_RX_BUF_SIZE     (64U)
+#endif
+/** @} */
+
+/**
+ * @brief   Longest header of a message over TCP, without token
+ */
+#define COAP_TCP_HDR_MAX    (6)
+
+/**
+ * @brief   Max-Message-Size assumed until the CSM of the peer arrives
+ */
+#define COAP_TCP_MSG_SIZE_DEFAULT   (1152U)
+
+/**
+ * @brief   Reassembles messages from a byte stream
+ *
+ * @note    All fields are private.
+ */
+typedef struct {
+    size_t pos;                         /**< Bytes of the message in buffer */
+    uint32_t need;                      /**< Bytes of the body missing, or
+                                             extended length so far */
+    uint8_t state;                      /**< Part of the message being read */
+    uint8_t tkl;                        /**< Token length */
+    uint8_t ext_left;                   /**< Bytes of extended length
+                                             missing */
+    uint8_t ext_len;                    /**< Length of extended length */
+    bool discard;                       /**< Message skipped, does not fit */
+} coap_tcp_parser_t;
+
+/**
+ * @brief   CoAP over TCP connection
+ */
+typedef struct {
+    sock_tcp_t *sock;                   /**< TCP sock */
+    coap_tcp_parser_t parser;           /**< Parser of received messages */
+    uint32_t max_msg_size;              /**< Largest message the peer
+                                             receives */
+    bool bert;                          /**< Peer supports BERT */
+    bool csm;                           /**< CSM of the peer received */
+    uint16_t rx_pos;                    /**< Next unparsed byte in @p rx */
+    uint16_t rx_len;                    /**< Bytes in @p rx */
+    uint8_t rx[CONFIG_NANOCOAP_TCP_RX_BUF_SIZE];   /**< Receive buffer */
+} nanocoap_tcp_conn_t;
+
+/**
+ * @brief   Initializes a parser
+ */
+void coap_tcp_parser_init(coap_tcp_parser_t *parser);
+
+/**
+ * @brief   Parses the next bytes of a stream
+ *
+ * Stops after a complete message. Messages that do not fit into @p buf or
+ * that are invalid are skipped; the parser stays in sync with the stream.
+ *
+ * @param[in,out] parser    Parser
+ * @param[out]    pkt       Message, if complete
+ * @param[out]    buf       Buffer for the message, must stay the same while
+ *                          a message is incomplete
+ * @param[in]     len       Size of @p buf
+ * @param[in]     data      Bytes of the stream, may be the pointer returned
+ *                          by coap_tcp_parser_body()
+ * @param[in]     data_len  Number of bytes in @p data
+ * @param[out]    consumed  Number of bytes of @p data parsed
+ *
+ * @return  1 if @p pkt holds a message
+ * @return  0 if all of @p data is parsed and the message is incomplete
+ * @return  -EMSGSIZE if a message was skipped as it does not fit
+ * @return  -EBADMSG if a message was skipped as it is invalid
+ */
+int coap_tcp_parse(coap_tcp_parser_t *parser, coap_pkt_t *pkt, uint8_t *buf,
+                   size_t len, const uint8_t *data, size_t data_len,
+                   size_t *consumed);
+
+/**
+ * @brief   Gets the space for the rest of the body of the current message
+ *
+ * Received bytes written there are passed to coap_tcp_parse() in place.
+ *
+ * @param[in]  parser   Parser
+ * @param[in]  buf      Buffer for the message
+ * @param[out] body     Space for the rest of the body
+ *
+ * @return  Number of missing bytes of the body
+ * @return  0 outside of a body
+ */
+size_t coap_tcp_parser_body(const coap_tcp_parser_t *parser, uint8_t *buf,
+                            uint8_t **body);
+
+/**
+ * @brief   Writes the header of RFC 8323 for a message
+ *
+ * The message is sent as this header followed by @p msg from the token on.
+ *
+ * @param[out] hdr      Header, at least @ref COAP_TCP_HDR_MAX bytes
+ * @param[in]  msg      Message in the format of RFC 7252
+ * @param[in]  len      Length of @p msg
+ *
+ * @return  Length of the header
+ */
+size_t coap_tcp_hdr_build(uint8_t *hdr, const uint8_t *msg, size_t len);
+
+/**
+ * @brief   Sends a message
+ *
+ * The header of @p msg is overwritten.
+ *
+ * @param[in] conn      Connection
+ * @param[in] msg       Message in the format of RFC 7252
+ * @param[in] len       Length of @p msg
+ *
+ * @return  0 on success
+ * @return  -EMSGSIZE if the message exceeds the Max-Message-Size of the peer
+ * @return  <0 on errors of sock_tcp_write()
+ */
+int nanocoap_tcp_send(nanocoap_tcp_conn_t *conn, uint8_t *msg, size_t len);
+
+/**
+ * @brief   Receives the next request or response
+ *
+ * Signals are handled: a CSM updates the settings of the peer, a Ping is
+ * answered.
+ *
+ * @param[in]  conn     Connection
+ * @param[out] pkt      Message
+ * @param[out] buf      Buffer for the message
+ * @param[in]  len      Size of @p buf
+ *
+ * @return  Length of the message
+ * @return  -ECONNRESET if the peer closed the connection
+ * @return  -ETIMEDOUT if nothing was received for
+ *          @ref CONFIG_NANOCOAP_TCP_TIMEOUT_MS
+ * @return  <0 on other errors
+ */
+ssize_t nanocoap_tcp_recv(nanocoap_tcp_conn_t *conn, coap_pkt_t *pkt,
+                          uint8_t *buf, size_t len);
+
+/**
+ * @brief   Opens a connection to a server
+ *
+ * Sends a CSM and waits for the one of the server.
+ *
+ * @param[out] conn     Connection
+ * @param[out] sock     TCP sock for the connection
+ * @param[in]  remote   Server
+ * @param[in]  buf      Buffer for the messages of the connection
+ * @param[in]  len      Size of @p buf, determines the Max-Message-Size
+ *                      announced
+ *
+ * @return  0 on success
+ * @return  <0 on error
+ */
+int nanocoap_tcp_connect(nanocoap_tcp_conn_t *conn, sock_tcp_t *sock,
+                         const sock_tcp_ep_t *remote, uint8_t *buf,
+                         size_t len);
+
+/**
+ * @brief   Closes a connection, with a Release signal
+ */
+void nanocoap_tcp_close(nanocoap_tcp_conn_t *conn);
+
+/**
+ * @brief   Sends a request and receives its response
+ *
+ * @param[in]     conn  Connection
+ * @param[in,out] pkt   Request, reused for the response
+ * @param[in]     len   Size of the buffer of @p pkt
+ *
+ * @return  Length of the response
+ * @return  <0 on error
+ */
+ssize_t nanocoap_tcp_request(nanocoap_tcp_conn_t *conn, coap_pkt_t *pkt,
+                             size_t len);
+
+/**
+ * @brief   Callback for the blocks received by nanocoap_tcp_get_blockwise()
+ *
+ * @param[in] arg       Argument given to nanocoap_tcp_get_blockwise()
+ * @param[in] offset    Offset of @p data in the representation
+ * @param[in] data      Payload of the block
+ * @param[in] len       Length of @p data
+ * @param[in] more      True if more blocks follow
+ *
+ * @return  0 to continue
+ * @return  <0 to stop the transfer
+ */
+typedef int (*nanocoap_tcp_block_cb_t)(void *arg, size_t offset,
+                                       const uint8_t *data, size_t len,
+                                       bool more);
+
+/**
+ * @brief   Gets a resource with Block2
+ *
+ * BERT blocks are requested if the server supports them.
+ *
+ * @param[in] conn      Connection
+ * @param[in] path      Path of the resource
+ * @param[in] buf       Buffer for requests and responses
+ * @param[in] len       Size of @p buf
+ * @param[in] cb        Callback for each block
+ * @param[in] arg       Argument of @p cb
+ *
+ * @return  Length of the representation
+ * @return  -ENOENT if the server answered 4.04
+ * @return  -EACCES if the server answered 4.01 or 4.03
+ * @return  -EAGAIN if the server answered 5.03
+ * @return  -EIO if the server answered with another 5.xx code
+ * @return  -EBADMSG if the server answered with another code than 2.05
+ * @return  <0 on other errors
+ */
+ssize_t nanocoap_tcp_get_blockwise(nanocoap_tcp_conn_t *conn,
+                                   const char *path, uint8_t *buf, size_t len,
+                                   nanocoap_tcp_block_cb_t cb, void *arg);
+
+/**
+ * @brief   Starts a nanocoap server over TCP
+ *
+ * Serves one connection at a time with coap_handle_req(). A connection is
+ * closed when it is idle for @ref CONFIG_NANOCOAP_TCP_TIMEOUT_MS. Only
+ * returns if listening on @p local fails.
+ *
+ * @param[in] local     Local endpoint to listen on
+ * @param[in] buf       Buffer for the messages of a connection
+ * @param[in] bufsize   Size of @p buf
+ *
+ * @return  <0 on error
+ */
+int nanocoap_tcp_server(sock_tcp_ep_t *local, uint8_t *buf, size_t bufsize);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* NET_NANOCOAP_TCP_H */
+/** @} */
@@ -296,6 +296,17 @@ typedef struct _sock_tl_ep sock_udp_ep_t;   /**< An end point for a UDP sock obj
  */
 typedef struct sock_udp sock_udp_t;
 
+/**
+ * @brief   A UDP message for sock_udp_recv_mmsg() and sock_udp_send_mmsg()
+ */
+typedef struct {
+    void *data;             /**< payload of the message */
+    size_t len;             /**< length of sock_udp_mmsg_t::data */
+    void *buf_ctx;          /**< stack-internal buffer context of a received
+                             *   message */
+    sock_udp_ep_t remote;   /**< remote end point of the message */
+} sock_udp_mmsg_t;
+
 #if defined (__clang__)
 # pragma clang diagnostic pop
 #endif
@@ -458,6 +469,65 @@ ssize_t sock_udp_recv(sock_udp_t *sock, void *data, size_t max_len,
 ssize_t sock_udp_recv_buf(sock_udp_t *sock, void **data, void **buf_ctx,
                           uint32_t timeout, sock_udp_ep_t *remote);
 
+/**
+ * @brief   Receives multiple UDP messages from remote end points at once
+ *
+ * @pre `(sock != NULL) && (msgs != NULL) && (num > 0)`
+ *
+ * Waits up to @p timeout for the first message and then takes up to
+ * @p num - 1 further messages that are already queued for @p sock, without
+ * waiting again. Messages are not copied: sock_udp_mmsg_t::data points to a
+ * stack-internal buffer space, so every received message must be handed back
+ * with sock_udp_mmsg_release() after use.
+ *
+ * @param[in] sock      A UDP sock object.
+ * @param[out] msgs     Array of at least @p num messages. The first n
+ *                      entries are filled, where n is the return value.
+ * @param[in] num       Maximum number of messages to receive.
+ * @param[in] timeout   Timeout for receiving the first message in
+ *                      microseconds.
+ *                      If 0 and no data is available, the function returns
+ *                      immediately.
+ *                      May be @ref SOCK_NO_TIMEOUT for no timeout (wait until
+ *                      data is available).
+ *
+ * @experimental    This function is quite new, not implemented for all stacks
+ *                  yet, and may be subject to sudden API changes. Do not use in
+ *                  production if this is unacceptable.
+ *
+ * @note    Messages from a remote other than the remote of @p sock are
+ *          dropped. Only if this happens for the first message -EPROTO is
+ *          returned.
+ *
+ * @return  The number of messages received on success.
+ * @return  -EADDRNOTAVAIL, if local of @p sock is not given.
+ * @return  -EAGAIN, if @p timeout is `0` and no data is available.
+ * @return  -EINVAL, if @p sock is not properly initialized (or closed while
+ *          sock_udp_recv_mmsg() blocks).
+ * @return  -ENOMEM, if no memory was available to receive a message.
+ * @return  -EPROTO, if source address of the first received packet did not
+ *          equal the remote of @p sock.
+ * @return  -ETIMEDOUT, if @p timeout expired.
+ */
+int sock_udp_recv_mmsg(sock_udp_t *sock, sock_udp_mmsg_t *msgs, unsigned num,
+                       uint32_t timeout);
+
+/**
+ * @brief   Releases the buffer space of messages received with
+ *          sock_udp_recv_mmsg()
+ *
+ * @param[in] sock      The UDP sock object the messages were received with.
+ * @param[in,out] msgs  The received messages.
+ * @param[in] num       Number of messages in @p msgs, i.e. the return value of
+ *                      sock_udp_recv_mmsg().
+ *
+ * @experimental    This function is quite new, not implemented for all stacks
+ *                  yet, and may be subject to sudden API changes. Do not use in
+ *                  production if this is unacceptable.
+ */
+void sock_udp_mmsg_release(sock_udp_t *sock, sock_udp_mmsg_t *msgs,
+                           unsigned num);
+
 /**
  * @brief   Sends a UDP message to remote end point
  *
@@ -494,6 +564,72 @@ ssize_t sock_udp_recv_buf(sock_udp_t *sock, void **data, void **buf_ctx,
 ssize_t sock_udp_send(sock_udp_t *sock, const void *data, size_t len,
                       const sock_udp_ep_t *remote);
 
+/**
+ * @brief   Sends multiple UDP messages at once
+ *
+ * @pre `(sock != NULL) && (msgs != NULL) && (num > 0)`
+ *
+ * Like sock_udp_send(), but @p sock is checked and implicitly bound only once
+ * for all messages. Sending stops at the first message that fails.
+ *
+ * @param[in] sock      A UDP sock object.
+ * @param[in] msgs      Array of @p num messages to send. If
+ *                      sock_udp_ep_t::port of sock_udp_mmsg_t::remote is 0,
+ *                      the message is sent to the remote end point of
+ *                      @p sock. sock_udp_mmsg_t::buf_ctx is ignored.
+ * @param[in] num       Number of messages in @p msgs.
+ *
+ * @experimental    This function is quite new, not implemented for all stacks
+ *                  yet, and may be subject to sudden API changes. Do not use in
+ *                  production if this is unacceptable.
+ *
+ * @return  The number of messages sent, if at least the first message was
+ *          sent.
+ * @return  The same errors as sock_udp_send(), if the first message could not
+ *          be sent.
+ */
+int sock_udp_send_mmsg(sock_udp_t *sock, const sock_udp_mmsg_t *msgs,
+                       unsigned num);
+
+/**
+ * @brief   Sends a UDP message with its payload read from a file
+ *
+ * @pre `((sock != NULL) || (remote != NULL)) && (fd >= 0)`
+ * @pre `(hdr_len == 0) || (hdr != NULL)`
+ *
+ * Like sock_udp_send(), but the message consists of @p hdr followed by
+ * @p len bytes read from @p fd at its current position. The file content is
+ * read directly into the packet buffer of the stack, no intermediate buffer is
+ * needed. The position of @p fd is advanced by the bytes read. If fewer than
+ * @p len bytes can be read, nothing is sent, as @p hdr may already describe
+ * the payload.
+ *
+ * This function is only available with module `vfs`.
+ *
+ * @param[in] sock      A UDP sock object. May be `NULL`.
+ * @param[in] hdr       Data to send before the file content, e.g. the header
+ *                      of an application protocol. May be `NULL` if
+ *                      `hdr_len == 0`.
+ * @param[in] hdr_len   Length of @p hdr.
+ * @param[in] fd        File descriptor to read the payload from.
+ * @param[in] len       Number of bytes to read from @p fd. Must be greater
+ *                      than 0.
+ * @param[in] remote    Remote end point for the sent data.
+ *                      May be `NULL`, if @p sock has a remote end point.
+ *
+ * @experimental    This function is quite new, not implemented for all stacks
+ *                  yet, and may be subject to sudden API changes. Do not use in
+ *                  production if this is unacceptable.
+ *
+ * @return  The number of bytes sent (including @p hdr) on success.
+ * @return  The same errors as sock_udp_send().
+ * @return  The same errors as vfs_read(), if @p fd could not be read.
+ * @return  -EIO, if the end of the file was reached before @p len bytes
+ *          were read.
+ */
+ssize_t sock_udp_sendfile(sock_udp_t *sock, const void *hdr, size_t hdr_len,
+                          int fd, size_t len, const sock_udp_ep_t *remote);
+
 #include "sock_types.h"
 
 #ifdef __cplusplus
@@ -0,0 +1,117 @@
+/*
+ * Copyright (C) 2020 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @defgroup    test_utils_mtd_ram RAM-based MTD device for tests
+ * @ingroup     sys
+ * @brief       MTD device backed by a RAM buffer, for tests of modules
+ *              using an MTD device
+ *
+ * The device counts the accesses to it and can behave like NOR flash, where
+ * programming only clears bits. It can also simulate a power loss after a
+ * given number of writes and erases.
+ *
+ * Tests that need more driver functions, e.g. to simulate an asynchronous
+ * device, can use the functions of this module in their own @ref mtd_desc_t.
+ * The device has no power states.
+ *
+ * @{
+ * @file
+ * @brief       RAM-based MTD device for tests
+ */
+
+#ifndef TEST_UTILS_MTD_RAM_H
+#define TEST_UTILS_MTD_RAM_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "mtd.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief   RAM-based MTD device
+ */
+typedef struct {
+    mtd_dev_t mtd;          /**< MTD device, must be the first member */
+    uint8_t *memory;        /**< contents of the device */
+    bool nor;               /**< programming can only clear bits */
+    bool reprogrammed;      /**< set if a programmed byte was programmed
+                                 again, only with test_utils_mtd_ram_t::nor */
+    int ops_left;           /**< writes and erases left before the power is
+                                 lost, -1 for no limit */
+    unsigned reads;         /**< number of reads */
+    unsigned writes;        /**< number of writes */
+    unsigned erases;        /**< number of sectors erased */
+} test_utils_mtd_ram_t;
+
+/**
+ * @brief   Driver of the RAM-based MTD device
+ */
+extern const mtd_desc_t test_utils_mtd_ram_driver;
+
+/**
+ * @brief   Static initializer of a RAM-based MTD device
+ *
+ * @param[in] drv       Driver, usually @ref test_utils_mtd_ram_driver
+ * @param[in] mem       Buffer for the contents, of
+ *                      @p sectors * @p pages * @p size bytes
+ * @param[in] sectors   Number of sectors
+ * @param[in] pages     Number of pages per sector
+ * @param[in] size      Size of a page in bytes
+ * @param[in] is_nor    true, if programming can only clear bits
+ */
+#define TEST_UTILS_MTD_RAM_INIT(drv, mem, sectors, pages, size, is_nor) \
+    {                                                                   \
+        .mtd = {                                                        \
+            .driver = (drv),                                            \
+            .sector_count = (sectors),                                  \
+            .pages_per_sector = (pages),                                \
+            .page_size = (size),                                        \
+        },                                                              \
+        .memory = (mem),                                                \
+        .nor = (is_nor),                                                \
+        .ops_left = -1,                                                 \
+    }
+
+/**
+ * @brief   Initializes a RAM-based MTD device, see mtd_desc_t::init
+ *
+ * The contents of the device are kept.
+ */
+int test_utils_mtd_ram_init(mtd_dev_t *dev);
+
+/**
+ * @brief   Reads from a RAM-based MTD device, see mtd_desc_t::read
+ */
+int test_utils_mtd_ram_read(mtd_dev_t *dev, void *buff, uint32_t addr,
+                            uint32_t size);
+
+/**
+ * @brief   Writes to a RAM-based MTD device, see mtd_desc_t::write
+ *
+ * A write interrupted by a power loss only programs the first half of
+ * @p buff and returns -EIO.
+ */
+int test_utils_mtd_ram_write(mtd_dev_t *dev, const void *buff, uint32_t addr,
+                             uint32_t size);
+
+/**
+ * @brief   Erases sectors of a RAM-based MTD device, see mtd_desc_t::erase
+ */
+int test_utils_mtd_ram_erase(mtd_dev_t *dev, uint32_t addr, uint32_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TEST_UTILS_MTD_RAM_H */
+/** @} */
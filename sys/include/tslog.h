@@ -0,0 +1,218 @@
+/*
+ * Copyright (C) 2020 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @defgroup    sys_tslog Time-series log
+ * @ingroup     sys
+ * @brief       Append-only log of time stamped records on an MTD device
+ *
+ * tslog stores fixed-size records, e.g. sensor samples, together with a
+ * 32 bit time stamp directly on a range of sectors of an MTD device. Compared
+ * to appending to a file, no file system metadata has to be updated and no
+ * data is copied.
+ *
+ * - Records are collected in a RAM buffer and written as one batch of
+ *   @ref CONFIG_TSLOG_BATCH_SIZE bytes once it is full, or on tslog_flush().
+ * - Every batch carries a CRC16-CCITT of its header and records. Batches
+ *   that were not written completely, e.g. because of a power failure, are
+ *   detected and skipped.
+ * - The sectors are used as a ring buffer: when the last sector is full, the
+ *   oldest sector is erased and reused. Every sector is erased equally often.
+ * - tslog_init() finds the newest sector and the end of its data by scanning
+ *   the sectors, no additional metadata is written.
+ * - The time stamp of the first record of every sector is kept in RAM
+ *   (tslog_t::index). A range query does a binary search over it and only
+ *   reads the batches of the matching sectors.
+ *
+ * Time stamps must not decrease, their unit is up to the application.
+ *
+ * @warning Records that are still in the RAM buffer are lost on power
+ *          failure.
+ *
+ * ## Usage
+ *
+ * ```
+ * USEMODULE += tslog
+ * ```
+ *
+ * ```
+ * static uint32_t index[16];
+ * static tslog_t log = {
+ *     .mtd = MTD_0,
+ *     .first_sector = 0,
+ *     .sector_count = ARRAY_SIZE(index),
+ *     .record_size = sizeof(phydat_t),
+ *     .index = index,
+ * };
+ *
+ * tslog_init(&log);
+ * tslog_append(&log, xtimer_now_usec() / US_PER_SEC, &sample);
+ * ```
+ *
+ * @{
+ *
+ * @file
+ * @brief       Time-series log interface
+ */
+
+#ifndef TSLOG_H
+#define TSLOG_H
+
+#include <stdint.h>
+
+#include "mtd.h"
+#include "mutex.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @defgroup    sys_tslog_config    Time-series log compile configurations
+ * @ingroup     config
+ * @{
+ */
+/**
+ * @brief   Size of a batch of records
+ *
+ * A batch is the unit written to the device. It has to be a multiple or a
+ * divisor of the page size of the device and a divisor of its sector size.
+ * This much RAM is used twice per log.
+ */
+#ifndef CONFIG_TSLOG_BATCH_SIZE
+#define CONFIG_TSLOG_BATCH_SIZE     (256U)
+#endif
+/** @} */
+
+/**
+ * @brief   Size of the header of a batch
+ */
+#define TSLOG_BATCH_HDR_SIZE        (10U)
+
+/**
+ * @brief   Statistics of a log
+ */
+typedef struct {
+    uint32_t appends;       /**< records appended */
+    uint32_t batches;       /**< batches written */
+    uint32_t writes;        /**< calls of mtd_write() */
+    uint32_t erases;        /**< sectors erased */
+} tslog_stats_t;
+
+/**
+ * @brief   Time-series log
+ *
+ * tslog_t::mtd, tslog_t::first_sector, tslog_t::sector_count,
+ * tslog_t::record_size and tslog_t::index are set by the user, the other
+ * members are initialized by tslog_init().
+ */
+typedef struct {
+    mtd_dev_t *mtd;             /**< backing device */
+    uint32_t first_sector;      /**< first sector of the log on tslog_t::mtd */
+    uint32_t sector_count;      /**< number of sectors of the log */
+    uint16_t record_size;       /**< size of the data of a record */
+    uint32_t *index;            /**< first time stamp of each sector,
+                                     tslog_t::sector_count entries */
+    mutex_t lock;               /**< lock for the log */
+    uint32_t seq;               /**< sequence number of the newest sector */
+    uint32_t head;              /**< newest sector */
+    uint32_t used;              /**< number of sectors holding records */
+    uint16_t slot;              /**< next free batch slot in tslog_t::head */
+    uint16_t pending;           /**< number of records in tslog_t::batch */
+    uint32_t last;              /**< time stamp of the newest record */
+    tslog_stats_t stats;        /**< statistics */
+    uint8_t batch[CONFIG_TSLOG_BATCH_SIZE]; /**< batch being filled */
+    uint8_t buf[CONFIG_TSLOG_BATCH_SIZE];   /**< buffer for reading batches */
+} tslog_t;
+
+/**
+ * @brief   Callback for records found by tslog_query()
+ *
+ * @param[in] timestamp     time stamp of the record
+ * @param[in] data          data of the record, tslog_t::record_size bytes
+ * @param[in] arg           argument passed to tslog_query()
+ *
+ * @return  0 to continue the query, anything else to stop it
+ */
+typedef int (*tslog_cb_t)(uint32_t timestamp, const void *data, void *arg);
+
+/**
+ * @brief   Initialize a log and recover its state from the device
+ *
+ * Sectors that do not hold valid batches of the log are erased before they
+ * are used, the device does not need to be formatted.
+ *
+ * @param[in,out] log   log to initialize
+ *
+ * @return  0 on success
+ * @return  -EINVAL if the geometry of the device does not fit the log
+ * @return  <0 on errors of the device
+ */
+int tslog_init(tslog_t *log);
+
+/**
+ * @brief   Erase all records of a log
+ *
+ * @param[in,out] log   log to erase, initialized by tslog_init()
+ *
+ * @return  0 on success
+ * @return  <0 on errors of the device
+ */
+int tslog_format(tslog_t *log);
+
+/**
+ * @brief   Append a record to a log
+ *
+ * The record is written to the device when its batch is full.
+ *
+ * @param[in,out] log       log to append to
+ * @param[in] timestamp     time stamp, not older than the newest record
+ * @param[in] data          tslog_t::record_size bytes of data
+ *
+ * @return  0 on success
+ * @return  -EINVAL if @p timestamp is older than the newest record
+ * @return  <0 on errors of the device
+ */
+int tslog_append(tslog_t *log, uint32_t timestamp, const void *data);
+
+/**
+ * @brief   Write the records appended since the last batch to the device
+ *
+ * The remainder of the current batch stays unused.
+ *
+ * @param[in,out] log   log to flush
+ *
+ * @return  0 on success
+ * @return  <0 on errors of the device
+ */
+int tslog_flush(tslog_t *log);
+
+/**
+ * @brief   Find all records with a time stamp in [@p start, @p end]
+ *
+ * The records are passed to @p cb oldest first, including the records not
+ * yet written to the device. @p cb must not call functions of the log.
+ *
+ * @param[in] log       log to search
+ * @param[in] start     oldest time stamp to find
+ * @param[in] end       newest time stamp to find
+ * @param[in] cb        callback for every record found
+ * @param[in] arg       argument for @p cb
+ *
+ * @return  number of records passed to @p cb
+ * @return  <0 on errors of the device
+ */
+int tslog_query(tslog_t *log, uint32_t start, uint32_t end,
+                tslog_cb_t cb, void *arg);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TSLOG_H */
+/** @} */
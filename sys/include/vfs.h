@@ -65,6 +65,7 @@
 #include <sys/stat.h> /* for struct stat */
 #include <sys/types.h> /* for off_t etc. */
 #include <sys/statvfs.h> /* for struct statvfs */
+#include <sys/uio.h> /* for struct iovec */
 
 #include "kernel_types.h"
 #include "clist.h"
@@ -223,6 +224,39 @@ extern "C" {
 #define VFS_NAME_MAX (31)
 #endif
 
+/**
+ * @defgroup    sys_vfs_dcache_config   VFS path lookup cache configuration
+ * @ingroup     config
+ * @brief       Configuration of the path lookup cache (module `vfs_dcache`)
+ *
+ * With `USEMODULE += vfs_dcache`, vfs_open() and vfs_stat() remember which
+ * mount a path resolved to and, if the file system implements
+ * vfs_file_system_ops::lookup, the file system specific handle of the file.
+ * Repeated accesses to the same path skip the search of the mount table and
+ * the path resolution in the file system driver.
+ *
+ * Entries of a mount are dropped when a file on it is renamed or removed and
+ * when it is unmounted, all entries are dropped when a file system is mounted.
+ * @{
+ */
+#ifndef CONFIG_VFS_DCACHE_NUMOF
+/**
+ * @brief   Number of cached paths
+ */
+#define CONFIG_VFS_DCACHE_NUMOF         (8)
+#endif
+
+#ifndef CONFIG_VFS_DCACHE_PATH_MAX
+/**
+ * @brief   Size of the path buffer of a cache entry, including the
+ *          terminating null
+ *
+ * Longer paths are not cached.
+ */
+#define CONFIG_VFS_DCACHE_PATH_MAX      (32)
+#endif
+/** @} */
+
 /**
  * @brief Used with vfs_bind to bind to any available fd number
  */
@@ -369,6 +403,18 @@ struct vfs_file_ops {
      */
     int (*fstat) (vfs_file_t *filp, struct stat *buf);
 
+    /**
+     * @brief Write buffered data of an open file to the storage device
+     *
+     * May be NULL if the file system does not buffer data.
+     *
+     * @param[in]  filp     pointer to open file
+     *
+     * @return 0 on success
+     * @return <0 on error
+     */
+    int (*fsync) (vfs_file_t *filp);
+
     /**
      * @brief Seek to position in file
      *
@@ -417,6 +463,23 @@ struct vfs_file_ops {
      */
     int (*open) (vfs_file_t *filp, const char *name, int flags, mode_t mode, const char *abs_path);
 
+    /**
+     * @brief Open a file by a handle returned by vfs_file_system_ops::lookup
+     *
+     * Used instead of vfs_file_ops::open by the `vfs_dcache` module when the
+     * handle of the file is known. It has to check @p flags the same way
+     * vfs_file_ops::open does. May be NULL.
+     *
+     * @param[in]  filp     pointer to open file
+     * @param[in]  handle   handle of the file
+     * @param[in]  flags    flags for opening, see man 2 open, man 3p open
+     * @param[in]  mode     mode for creating a new file, see man 2 open, man 3p open
+     *
+     * @return 0 on success
+     * @return <0 on error
+     */
+    int (*open_handle) (vfs_file_t *filp, uintptr_t handle, int flags, mode_t mode);
+
     /**
      * @brief Read bytes from an open file
      *
@@ -440,6 +503,39 @@ struct vfs_file_ops {
      * @return <0 on error
      */
     ssize_t (*write) (vfs_file_t *filp, const void *src, size_t nbytes);
+
+    /**
+     * @brief Read bytes from an open file into several buffers
+     *
+     * Fills the buffers in order, as if vfs_file_ops::read was called with a
+     * single buffer of the combined size. May be NULL, vfs_readv() calls
+     * vfs_file_ops::read for every buffer then.
+     *
+     * @param[in]  filp     pointer to open file
+     * @param[in]  iov      buffers to fill
+     * @param[in]  iovcnt   number of buffers in @p iov
+     *
+     * @return number of bytes read on success
+     * @return <0 on error
+     */
+    ssize_t (*readv) (vfs_file_t *filp, const struct iovec *iov, int iovcnt);
+
+    /**
+     * @brief Write bytes from several buffers to an open file
+     *
+     * Writes the buffers in order, as if vfs_file_ops::write was called with
+     * a single buffer holding all of them, so file systems can program them
+     * at once. May be NULL, vfs_writev() calls vfs_file_ops::write for every
+     * buffer then.
+     *
+     * @param[in]  filp     pointer to open file
+     * @param[in]  iov      buffers to write
+     * @param[in]  iovcnt   number of buffers in @p iov
+     *
+     * @return number of bytes written on success
+     * @return <0 on error
+     */
+    ssize_t (*writev) (vfs_file_t *filp, const struct iovec *iov, int iovcnt);
 };
 
 /**
@@ -629,8 +725,49 @@ struct vfs_file_system_ops {
      * @return <0 on error
      */
     int (*fstatvfs) (vfs_mount_t *mountp, vfs_file_t *filp, struct statvfs *buf);
+
+    /**
+     * @brief Resolve a path to a file system specific handle
+     *
+     * The handle is kept by the `vfs_dcache` module and passed to
+     * vfs_file_ops::open_handle and vfs_file_system_ops::stat_handle on later
+     * accesses to the same path. It has to stay valid until the file is
+     * renamed or removed or the file system is unmounted. This is called with
+     * the mount table locked, it must not call any vfs function. May be NULL.
+     *
+     * @param[in]  mountp  file system mount to operate on
+     * @param[in]  path    path to the file, relative to the file system root
+     * @param[out] handle  handle of the file
+     *
+     * @return 0 on success
+     * @return <0 on error
+     */
+    int (*lookup) (vfs_mount_t *mountp, const char *path, uintptr_t *handle);
+
+    /**
+     * @brief Get status of a file by a handle returned by
+     *        vfs_file_system_ops::lookup
+     *
+     * May be NULL.
+     *
+     * @param[in]  mountp  file system mount to operate on
+     * @param[in]  handle  handle of the file
+     * @param[out] buf     pointer to stat struct to fill
+     *
+     * @return 0 on success
+     * @return <0 on error
+     */
+    int (*stat_handle) (vfs_mount_t *mountp, uintptr_t handle, struct stat *buf);
 };
 
+/**
+ * @brief   Statistics of the path lookup cache
+ */
+typedef struct {
+    uint32_t hits;          /**< lookups served from the cache */
+    uint32_t misses;        /**< lookups that searched the mount table */
+} vfs_dcache_stats_t;
+
 /**
  * @brief   Allocate and bind file descriptors for  STDIN, STDERR, and STDOUT
  *
@@ -684,6 +821,16 @@ int vfs_fstat(int fd, struct stat *buf);
  */
 int vfs_fstatvfs(int fd, struct statvfs *buf);
 
+/**
+ * @brief Write buffered data of an open file to the storage device
+ *
+ * @param[in]  fd       fd number obtained from vfs_open
+ *
+ * @return 0 on success
+ * @return <0 on error
+ */
+int vfs_fsync(int fd);
+
 /**
  * @brief Seek to position in file
  *
@@ -739,6 +886,40 @@ ssize_t vfs_read(int fd, void *dest, size_t count);
  */
 ssize_t vfs_write(int fd, const void *src, size_t count);
 
+/**
+ * @brief Read bytes from an open file into several buffers
+ *
+ * The buffers are filled in order. Fewer bytes than requested are read if
+ * the end of the file is reached.
+ *
+ * @param[in]  fd       fd number obtained from vfs_open
+ * @param[in]  iov      buffers to fill
+ * @param[in]  iovcnt   number of buffers in @p iov
+ *
+ * @return number of bytes read on success
+ * @return -EINVAL if @p iovcnt is negative or the sizes of the buffers add
+ *         up to more than SSIZE_MAX
+ * @return <0 on other errors
+ */
+ssize_t vfs_readv(int fd, const struct iovec *iov, int iovcnt);
+
+/**
+ * @brief Write bytes from several buffers to an open file
+ *
+ * The buffers are written in order, file systems implementing
+ * vfs_file_ops::writev write them like a single buffer.
+ *
+ * @param[in]  fd       fd number obtained from vfs_open
+ * @param[in]  iov      buffers to write
+ * @param[in]  iovcnt   number of buffers in @p iov
+ *
+ * @return number of bytes written on success
+ * @return -EINVAL if @p iovcnt is negative or the sizes of the buffers add
+ *         up to more than SSIZE_MAX
+ * @return <0 on other errors
+ */
+ssize_t vfs_writev(int fd, const struct iovec *iov, int iovcnt);
+
 /**
  * @brief Open a directory for reading with readdir
  *
@@ -969,6 +1150,23 @@ const vfs_mount_t *vfs_iterate_mounts(const vfs_mount_t *cur);
  */
 const vfs_file_t *vfs_file_get(int fd);
 
+/**
+ * @brief   Drop all entries of the path lookup cache
+ *
+ * Needs module `vfs_dcache`. File systems that are modified behind the back
+ * of the VFS layer must call this.
+ */
+void vfs_dcache_clear(void);
+
+/**
+ * @brief   Get the statistics of the path lookup cache
+ *
+ * Needs module `vfs_dcache`.
+ *
+ * @param[out] stats    statistics since boot
+ */
+void vfs_dcache_stats(vfs_dcache_stats_t *stats);
+
 #ifdef __cplusplus
 }
 #endif
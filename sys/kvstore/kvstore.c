@@ -0,0 +1,1419 @@
+/*
+ * Copyright (C) 2020 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     sys_kvstore
+ * @{
+ *
+ * @file
+ * @brief       Key-value store implementation
+ *
+ * Layout of a sector, all fields are big-endian:
+ *
+ *     | header (16) | records ... | summary entries ... | free | footer (8) |
+ *
+ * - header: magic "KVS1" (4), sequence number (4), erase count (4),
+ *   CRC (2), unused (2)
+ * - record: type (1), flags (1), key length (1), unused (1),
+ *   value length (2), CRC (2), transaction (4), key, value, padded to
+ *   CONFIG_KVSTORE_ALIGN. The CRC covers type, key length, unused byte,
+ *   value length, key and value, so a record can be moved without the
+ *   flags and transaction number.
+ * - summary entry, written when the sector is full: key hash (4),
+ *   record offset (2), record length (2), the MSB marks deletions
+ * - footer: magic "SM" (2), number of summary entries (2), offset of the
+ *   first entry (2), CRC of the entries (2)
+ *
+ * @}
+ */
+
+#include <errno.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "byteorder.h"
+#include "checksum/crc16_ccitt.h"
+#include "kvstore.h"
+#include "mtd.h"
+#include "mutex.h"
+
+#define ENABLE_DEBUG    (0)
+#include "debug.h"
+
+#if CONFIG_KVSTORE_BUF_SIZE < CONFIG_KVSTORE_KEY_MAX
+#error "CONFIG_KVSTORE_BUF_SIZE must hold a key"
+#endif
+
+#define SECTOR_MAGIC        (0x4b565331)    /* "KVS1" */
+#define SUMMARY_MAGIC       (0x534d)        /* "SM" */
+#define SECTOR_HDR_SIZE     (16U)
+#define REC_HDR_SIZE        (12U)
+#define SUM_ENTRY_SIZE      (8U)
+#define FOOTER_SIZE         (8U)
+
+#define TYPE_PUT            ('P')
+#define TYPE_DEL            ('D')
+#define TYPE_COMMIT         ('C')
+#define TYPE_ERASED         (0xff)
+#define FLAG_TXN            (0x01)
+#define NO_TXN              (0xffffffff)
+#define LEN_DELETED         (0x8000)
+#define NONE                (UINT32_MAX)
+
+enum {
+    SECTOR_FREE,        /* unknown content, erased before use */
+    SECTOR_ERASED,
+    SECTOR_ACTIVE,
+    SECTOR_FULL,
+};
+
+typedef struct {
+    uint8_t type;
+    uint8_t flags;
+    uint8_t klen;
+    uint16_t vlen;
+    uint16_t crc;
+    uint32_t txn;
+} _rec_t;
+
+/* called for the records of a sector by _foreach_record() */
+typedef int (*_record_cb_t)(kvstore_t *kvs, uint32_t addr, uint32_t hash,
+                            uint16_t len, bool deleted, void *arg);
+
+static kvstore_t *_default;
+
+static inline uint32_t _sector_size(const kvstore_t *kvs)
+{
+    return kvs->mtd->page_size * kvs->mtd->pages_per_sector;
+}
+
+static inline uint32_t _sector_addr(const kvstore_t *kvs, uint32_t sector)
+{
+    return (kvs->first_sector + sector) * _sector_size(kvs);
+}
+
+static inline uint32_t _sector_of(const kvstore_t *kvs, uint32_t addr)
+{
+    return addr / _sector_size(kvs) - kvs->first_sector;
+}
+
+static inline uint32_t _align(uint32_t len)
+{
+    return (len + CONFIG_KVSTORE_ALIGN - 1) & ~(CONFIG_KVSTORE_ALIGN - 1);
+}
+
+static inline uint32_t _rec_len(size_t klen, size_t vlen)
+{
+    return _align(REC_HDR_SIZE + klen + vlen);
+}
+
+/* space used by a record of an entry and its summary entry */
+static inline uint32_t _entry_size(const kvstore_entry_t *entry)
+{
+    return (entry->len & ~LEN_DELETED) + SUM_ENTRY_SIZE;
+}
+
+static uint32_t _hash_update(uint32_t hash, const uint8_t *buf, size_t len)
+{
+    /* FNV-1a */
+    while (len--) {
+        hash = (hash ^ *buf++) * 16777619U;
+    }
+    return hash;
+}
+
+static inline uint32_t _hash(const char *key, size_t len)
+{
+    return _hash_update(2166136261U, (const uint8_t *)key, len);
+}
+
+/* write stream: collects data in kvs->wbuf, writes never cross pages */
+
+static void _ws_start(kvstore_t *kvs, uint32_t addr)
+{
+    kvs->ws_addr = addr;
+    kvs->ws_len = 0;
+}
+
+static int _ws_flush(kvstore_t *kvs)
+{
+    int res = 0;
+
+    if (kvs->ws_len > 0) {
+        res = mtd_write(kvs->mtd, kvs->wbuf, kvs->ws_addr, kvs->ws_len);
+        kvs->stats.writes++;
+        kvs->ws_addr += kvs->ws_len;
+        kvs->ws_len = 0;
+    }
+    return res;
+}
+
+static int _ws_put(kvstore_t *kvs, const void *data, size_t len)
+{
+    const uint8_t *ptr = data;
+    uint32_t page_size = kvs->mtd->page_size;
+
+    while (len > 0) {
+        uint32_t chunk = sizeof(kvs->wbuf) - kvs->ws_len;
+        uint32_t page_left = page_size -
+                             ((kvs->ws_addr + kvs->ws_len) % page_size);
+
+        if (chunk > page_left) {
+            chunk = page_left;
+        }
+        if (chunk > len) {
+            chunk = len;
+        }
+        memcpy(kvs->wbuf + kvs->ws_len, ptr, chunk);
+        kvs->ws_len += chunk;
+        ptr += chunk;
+        len -= chunk;
+        if ((kvs->ws_len == sizeof(kvs->wbuf)) ||
+            ((kvs->ws_addr + kvs->ws_len) % page_size == 0)) {
+            int res = _ws_flush(kvs);
+            if (res < 0) {
+                return res;
+            }
+        }
+    }
+    return 0;
+}
+
+static int _ws_end(kvstore_t *kvs)
+{
+    /* the stream starts aligned, so padding never crosses a page */
+    while (kvs->ws_len % CONFIG_KVSTORE_ALIGN) {
+        kvs->wbuf[kvs->ws_len++] = 0xff;
+    }
+    return _ws_flush(kvs);
+}
+
+/* records */
+
+static void _rec_parse(_rec_t *rec, const uint8_t *buf)
+{
+    rec->type = buf[0];
+    rec->flags = buf[1];
+    rec->klen = buf[2];
+    rec->vlen = byteorder_bebuftohs(buf + 4);
+    rec->crc = byteorder_bebuftohs(buf + 6);
+    rec->txn = byteorder_bebuftohl(buf + 8);
+}
+
+static void _rec_format(uint8_t *buf, const _rec_t *rec)
+{
+    buf[0] = rec->type;
+    buf[1] = rec->flags;
+    buf[2] = rec->klen;
+    buf[3] = 0xff;
+    byteorder_htobebufs(buf + 4, rec->vlen);
+    byteorder_htobebufs(buf + 6, rec->crc);
+    byteorder_htobebufl(buf + 8, rec->txn);
+}
+
+static uint16_t _rec_crc_hdr(const uint8_t *buf)
+{
+    uint16_t crc = crc16_ccitt_calc(buf, 1);
+
+    return crc16_ccitt_update(crc, buf + 2, 4);
+}
+
+static int _rec_read(kvstore_t *kvs, uint32_t addr, _rec_t *rec,
+                     uint8_t *hdr)
+{
+    int res = mtd_read(kvs->mtd, hdr, addr, REC_HDR_SIZE);
+
+    if (res == 0) {
+        _rec_parse(rec, hdr);
+    }
+    return res;
+}
+
+/* checks the header fields of a record at offset off of a sector */
+static bool _rec_sane(const kvstore_t *kvs, const _rec_t *rec, uint32_t off)
+{
+    switch (rec->type) {
+    case TYPE_PUT:
+    case TYPE_DEL:
+    case TYPE_COMMIT:
+        break;
+    default:
+        return false;
+    }
+    return (rec->klen <= CONFIG_KVSTORE_KEY_MAX) &&
+           ((off + _rec_len(rec->klen, rec->vlen)) <=
+            (_sector_size(kvs) - FOOTER_SIZE));
+}
+
+/* checks the CRC of a record and returns the hash of its key */
+static int _rec_check(kvstore_t *kvs, uint32_t addr, const _rec_t *rec,
+                      const uint8_t *hdr, uint32_t *hash)
+{
+    uint16_t crc = _rec_crc_hdr(hdr);
+    uint32_t len = rec->klen + rec->vlen;
+    uint32_t pos = 0;
+
+    *hash = 2166136261U;
+    addr += REC_HDR_SIZE;
+    while (pos < len) {
+        uint32_t chunk = len - pos;
+        if (chunk > sizeof(kvs->rbuf)) {
+            chunk = sizeof(kvs->rbuf);
+        }
+        int res = mtd_read(kvs->mtd, kvs->rbuf, addr + pos, chunk);
+        if (res < 0) {
+            return res;
+        }
+        crc = crc16_ccitt_update(crc, kvs->rbuf, chunk);
+        if (pos < rec->klen) {
+            uint32_t klen = rec->klen - pos;
+            *hash = _hash_update(*hash, kvs->rbuf,
+                                 (klen < chunk) ? klen : chunk);
+        }
+        pos += chunk;
+    }
+    return (crc == rec->crc) ? 0 : -EBADMSG;
+}
+
+/* checks if the record committing transaction txn follows offset off */
+static bool _committed(kvstore_t *kvs, uint32_t sector, uint32_t off,
+                       uint32_t limit, uint32_t txn)
+{
+    uint32_t base = _sector_addr(kvs, sector);
+    uint8_t hdr[REC_HDR_SIZE];
+    _rec_t rec;
+
+    while (((off + REC_HDR_SIZE) <= limit) &&
+           (_rec_read(kvs, base + off, &rec, hdr) == 0) &&
+           _rec_sane(kvs, &rec, off)) {
+        if ((rec.type == TYPE_COMMIT) && (rec.txn == txn)) {
+            return rec.crc == _rec_crc_hdr(hdr);
+        }
+        off += _rec_len(rec.klen, rec.vlen);
+    }
+    return false;
+}
+
+/* returns the aligned end of the programmed part of a sector after off */
+static int _programmed_end(kvstore_t *kvs, uint32_t sector, uint32_t off,
+                           uint32_t *end)
+{
+    uint32_t base = _sector_addr(kvs, sector);
+    uint32_t pos = _sector_size(kvs) - FOOTER_SIZE;
+
+    while (pos > off) {
+        uint32_t chunk = pos - off;
+        if (chunk > sizeof(kvs->rbuf)) {
+            chunk = sizeof(kvs->rbuf);
+        }
+        pos -= chunk;
+        int res = mtd_read(kvs->mtd, kvs->rbuf, base + pos, chunk);
+        if (res < 0) {
+            return res;
+        }
+        for (uint32_t i = chunk; i > 0; i--) {
+            if (kvs->rbuf[i - 1] != 0xff) {
+                *end = _align(pos + i);
+                return 0;
+            }
+        }
+    }
+    *end = off;
+    return 0;
+}
+
+/* walks the records of a sector before offset limit, passes the committed
+ * ones to cb and returns the end of the records and their number, returns 1
+ * if a damaged record ends them */
+static int _scan(kvstore_t *kvs, uint32_t sector, uint32_t limit,
+                 _record_cb_t cb, void *arg, uint32_t *end, uint32_t *count)
+{
+    uint32_t base = _sector_addr(kvs, sector);
+    uint32_t off = SECTOR_HDR_SIZE;
+    uint32_t checked = NO_TXN;
+    bool committed = false;
+    uint8_t hdr[REC_HDR_SIZE];
+    _rec_t rec;
+    int res;
+
+    *count = 0;
+    while ((off + REC_HDR_SIZE) <= limit) {
+        uint32_t hash;
+
+        res = _rec_read(kvs, base + off, &rec, hdr);
+        if (res < 0) {
+            return res;
+        }
+        if (rec.type == TYPE_ERASED) {
+            break;
+        }
+        if (!_rec_sane(kvs, &rec, off) ||
+            ((res = _rec_check(kvs, base + off, &rec, hdr, &hash)) != 0)) {
+            if ((res < 0) && (res != -EBADMSG)) {
+                return res;
+            }
+            /* interrupted write, nothing valid follows */
+            DEBUG("kvstore: damaged record in sector %u at %u\n",
+                  (unsigned)sector, (unsigned)off);
+            res = _programmed_end(kvs, sector, off, end);
+            return (res < 0) ? res : 1;
+        }
+        (*count)++;
+        if ((rec.flags & FLAG_TXN) && ((int32_t)(rec.txn - kvs->txn) >= 0)) {
+            kvs->txn = rec.txn + 1;
+        }
+        if ((rec.flags & FLAG_TXN) && (rec.txn != checked)) {
+            checked = rec.txn;
+            committed = _committed(kvs, sector, off, limit, rec.txn);
+        }
+        uint16_t len = _rec_len(rec.klen, rec.vlen);
+        if ((rec.type != TYPE_COMMIT) &&
+            (!(rec.flags & FLAG_TXN) || committed) && (cb != NULL)) {
+            res = cb(kvs, base + off, hash, len, rec.type == TYPE_DEL, arg);
+            if (res < 0) {
+                return res;
+            }
+        }
+        off += len;
+    }
+    *end = off;
+    return 0;
+}
+
+static int _read_footer(kvstore_t *kvs, uint32_t sector, uint16_t *count,
+                        uint16_t *start)
+{
+    uint32_t addr = _sector_addr(kvs, sector) + _sector_size(kvs) - FOOTER_SIZE;
+    uint8_t footer[FOOTER_SIZE];
+    int res = mtd_read(kvs->mtd, footer, addr, sizeof(footer));
+
+    if (res < 0) {
+        return res;
+    }
+    *count = byteorder_bebuftohs(footer + 2);
+    *start = byteorder_bebuftohs(footer + 4);
+    if ((byteorder_bebuftohs(footer) != SUMMARY_MAGIC) ||
+        (*start < SECTOR_HDR_SIZE) ||
+        ((*start + *count * SUM_ENTRY_SIZE) >
+         (_sector_size(kvs) - FOOTER_SIZE))) {
+        return 0;
+    }
+
+    /* the entries are only used if they are complete */
+    uint16_t crc = 0xffff;
+    uint32_t len = *count * SUM_ENTRY_SIZE;
+    addr = _sector_addr(kvs, sector) + *start;
+    for (uint32_t pos = 0; pos < len; pos += sizeof(kvs->rbuf)) {
+        uint32_t chunk = len - pos;
+        if (chunk > sizeof(kvs->rbuf)) {
+            chunk = sizeof(kvs->rbuf);
+        }
+        res = mtd_read(kvs->mtd, kvs->rbuf, addr + pos, chunk);
+        if (res < 0) {
+            return res;
+        }
+        crc = crc16_ccitt_update(crc, kvs->rbuf, chunk);
+    }
+    return (crc == byteorder_bebuftohs(footer + 6)) ? 1 : 0;
+}
+
+/* returns 1 if the footer of a sector was never programmed */
+static int _footer_erased(kvstore_t *kvs, uint32_t sector)
+{
+    uint32_t addr = _sector_addr(kvs, sector) + _sector_size(kvs) - FOOTER_SIZE;
+    uint8_t footer[FOOTER_SIZE];
+    int res = mtd_read(kvs->mtd, footer, addr, sizeof(footer));
+
+    if (res < 0) {
+        return res;
+    }
+    for (unsigned i = 0; i < sizeof(footer); i++) {
+        if (footer[i] != 0xff) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/* passes the committed records of a sector to cb, using the summary if the
+ * sector has one */
+static int _foreach_record(kvstore_t *kvs, uint32_t sector, _record_cb_t cb,
+                           void *arg)
+{
+    /* cb may use kvs->rbuf */
+    uint8_t entries[8 * SUM_ENTRY_SIZE];
+    const unsigned per_read = sizeof(entries) / SUM_ENTRY_SIZE;
+    uint32_t base = _sector_addr(kvs, sector);
+    uint16_t count, start;
+    int res = _read_footer(kvs, sector, &count, &start);
+
+    if (res < 0) {
+        return res;
+    }
+    if (res == 0) {
+        uint32_t end, nrec;
+        res = _scan(kvs, sector, _sector_size(kvs) - FOOTER_SIZE, cb, arg,
+                    &end, &nrec);
+        return (res < 0) ? res : 0;
+    }
+    for (unsigned i = 0; i < count; i++) {
+        if (i % per_read == 0) {
+            unsigned n = count - i;
+            if (n > per_read) {
+                n = per_read;
+            }
+            res = mtd_read(kvs->mtd, entries,
+                           base + start + i * SUM_ENTRY_SIZE,
+                           n * SUM_ENTRY_SIZE);
+            if (res < 0) {
+                return res;
+            }
+        }
+        const uint8_t *entry = &entries[(i % per_read) * SUM_ENTRY_SIZE];
+        uint16_t len = byteorder_bebuftohs(entry + 6);
+        res = cb(kvs, base + byteorder_bebuftohs(entry + 4),
+                 byteorder_bebuftohl(entry), len & ~LEN_DELETED,
+                 len & LEN_DELETED, arg);
+        if (res < 0) {
+            return res;
+        }
+    }
+    return 0;
+}
+
+/* index */
+
+static int _index_find(const kvstore_t *kvs, uint32_t hash)
+{
+    unsigned i = hash % kvs->entries_numof;
+
+    while (kvs->entries[i].addr != 0) {
+        if (kvs->entries[i].hash == hash) {
+            return i;
+        }
+        i = (i + 1) % kvs->entries_numof;
+    }
+    return -1;
+}
+
+static int _index_slot(const kvstore_t *kvs, uint32_t hash)
+{
+    unsigned i = hash % kvs->entries_numof;
+
+    while (kvs->entries[i].addr != 0) {
+        if (kvs->entries[i].hash == hash) {
+            return i;
+        }
+        i = (i + 1) % kvs->entries_numof;
+    }
+    /* one entry stays unused, so lookups terminate */
+    return ((kvs->keys + 1) < kvs->entries_numof) ? (int)i : -ENOMEM;
+}
+
+static void _index_remove(kvstore_t *kvs, unsigned i)
+{
+    kvstore_entry_t *entries = kvs->entries;
+    unsigned j = i;
+
+    kvs->sectors[_sector_of(kvs, entries[i].addr)].live -=
+        _entry_size(&entries[i]);
+    entries[i].addr = 0;
+    kvs->keys--;
+
+    /* move following entries of the probe sequence into the gap */
+    while (1) {
+        j = (j + 1) % kvs->entries_numof;
+        if (entries[j].addr == 0) {
+            return;
+        }
+        unsigned home = entries[j].hash % kvs->entries_numof;
+        if ((i <= j) ? ((i < home) && (home <= j))
+                     : ((i < home) || (home <= j))) {
+            continue;
+        }
+        entries[i] = entries[j];
+        entries[j].addr = 0;
+        i = j;
+    }
+}
+
+static int _apply(kvstore_t *kvs, uint32_t addr, uint32_t hash, uint16_t len,
+                  bool deleted, void *arg)
+{
+    (void)arg;
+    int i = _index_slot(kvs, hash);
+
+    if (i < 0) {
+        return i;
+    }
+    kvstore_entry_t *entry = &kvs->entries[i];
+    if (entry->addr != 0) {
+        kvs->sectors[_sector_of(kvs, entry->addr)].live -= _entry_size(entry);
+    }
+    else {
+        kvs->keys++;
+    }
+    entry->hash = hash;
+    entry->addr = addr;
+    entry->len = len | (deleted ? LEN_DELETED : 0);
+    kvs->sectors[_sector_of(kvs, addr)].live += _entry_size(entry);
+    return 0;
+}
+
+/* compares the key of the record at addr */
+static int _key_matches(kvstore_t *kvs, uint32_t addr, const char *key,
+                        size_t klen)
+{
+    uint8_t hdr[REC_HDR_SIZE];
+    _rec_t rec;
+    int res = _rec_read(kvs, addr, &rec, hdr);
+
+    if (res < 0) {
+        return res;
+    }
+    if (rec.klen != klen) {
+        return 0;
+    }
+    res = mtd_read(kvs->mtd, kvs->rbuf, addr + REC_HDR_SIZE, klen);
+    if (res < 0) {
+        return res;
+    }
+    return memcmp(kvs->rbuf, key, klen) == 0;
+}
+
+/* returns 0 if key can be stored, -EEXIST if its hash is taken by another
+ * key */
+static int _check_key(kvstore_t *kvs, const char *key, size_t klen,
+                      uint32_t hash, bool *known)
+{
+    int i = _index_find(kvs, hash);
+
+    *known = (i >= 0);
+    if (i < 0) {
+        return 0;
+    }
+    int res = _key_matches(kvs, kvs->entries[i].addr, key, klen);
+    if (res < 0) {
+        return res;
+    }
+    return res ? 0 : -EEXIST;
+}
+
+/* sectors */
+
+static int _erase(kvstore_t *kvs, uint32_t sector)
+{
+    kvstore_sector_t *s = &kvs->sectors[sector];
+    int res = mtd_erase(kvs->mtd, _sector_addr(kvs, sector), _sector_size(kvs));
+
+    if (res < 0) {
+        return res;
+    }
+    kvs->stats.erases++;
+    s->erase_count++;
+    s->state = SECTOR_ERASED;
+    s->live = 0;
+    s->seq = 0;
+    return 0;
+}
+
+static int _open(kvstore_t *kvs, uint32_t sector)
+{
+    kvstore_sector_t *s = &kvs->sectors[sector];
+    uint8_t hdr[SECTOR_HDR_SIZE];
+    int res;
+
+    if (s->state != SECTOR_ERASED) {
+        res = _erase(kvs, sector);
+        if (res < 0) {
+            return res;
+        }
+    }
+    s->seq = ++kvs->seq;
+    byteorder_htobebufl(hdr, SECTOR_MAGIC);
+    byteorder_htobebufl(hdr + 4, s->seq);
+    byteorder_htobebufl(hdr + 8, s->erase_count);
+    byteorder_htobebufs(hdr + 12, crc16_ccitt_calc(hdr, 12));
+    byteorder_htobebufs(hdr + 14, 0xffff);
+    _ws_start(kvs, _sector_addr(kvs, sector));
+    res = _ws_put(kvs, hdr, sizeof(hdr));
+    if (res == 0) {
+        res = _ws_end(kvs);
+    }
+    /* the sector is used even if writing failed, it is not erased */
+    s->state = SECTOR_ACTIVE;
+    kvs->active = sector;
+    kvs->pos = SECTOR_HDR_SIZE;
+    kvs->nrec = 0;
+    DEBUG("kvstore: open sector %u, seq %u\n", (unsigned)sector,
+          (unsigned)s->seq);
+    return res;
+}
+
+typedef struct {
+    uint16_t count;
+    uint16_t crc;
+} _seal_ctx_t;
+
+static int _seal_entry(kvstore_t *kvs, uint32_t addr, uint32_t hash,
+                       uint16_t len, bool deleted, void *arg)
+{
+    _seal_ctx_t *ctx = arg;
+    uint8_t entry[SUM_ENTRY_SIZE];
+
+    byteorder_htobebufl(entry, hash);
+    byteorder_htobebufs(entry + 4, addr % _sector_size(kvs));
+    byteorder_htobebufs(entry + 6, len | (deleted ? LEN_DELETED : 0));
+    ctx->crc = crc16_ccitt_update(ctx->crc, entry, sizeof(entry));
+    ctx->count++;
+    return _ws_put(kvs, entry, sizeof(entry));
+}
+
+static int _seal(kvstore_t *kvs)
+{
+    uint32_t sector = kvs->active;
+    uint32_t base = _sector_addr(kvs, sector);
+    _seal_ctx_t ctx = { .crc = 0xffff };
+    uint8_t footer[FOOTER_SIZE];
+    uint32_t end, count;
+    int res;
+
+    kvs->sectors[sector].state = SECTOR_FULL;
+    kvs->active = NONE;
+
+    _ws_start(kvs, base + kvs->pos);
+    /* the summary is written behind the records while they are read */
+    res = _scan(kvs, sector, kvs->pos, _seal_entry, &ctx, &end, &count);
+    if (res >= 0) {
+        res = _ws_end(kvs);
+    }
+    if (res < 0) {
+        return res;
+    }
+    byteorder_htobebufs(footer, SUMMARY_MAGIC);
+    byteorder_htobebufs(footer + 2, ctx.count);
+    byteorder_htobebufs(footer + 4, kvs->pos);
+    byteorder_htobebufs(footer + 6, ctx.crc);
+    _ws_start(kvs, base + _sector_size(kvs) - FOOTER_SIZE);
+    res = _ws_put(kvs, footer, sizeof(footer));
+    if (res == 0) {
+        res = _ws_end(kvs);
+    }
+    return res;
+}
+
+static bool _fits(const kvstore_t *kvs, uint32_t len, uint32_t nrec)
+{
+    return (kvs->active != NONE) &&
+           ((kvs->pos + len + (kvs->nrec + nrec) * SUM_ENTRY_SIZE) <=
+            (_sector_size(kvs) - FOOTER_SIZE));
+}
+
+/* copies a record to the active sector */
+static int _move(kvstore_t *kvs, uint32_t addr, uint16_t len)
+{
+    uint8_t hdr[REC_HDR_SIZE];
+    _rec_t rec;
+    int res = _rec_read(kvs, addr, &rec, hdr);
+
+    if (res < 0) {
+        return res;
+    }
+    /* it is committed, the CRC does not cover these */
+    rec.flags = 0;
+    rec.txn = NO_TXN;
+    _rec_format(hdr, &rec);
+    _ws_start(kvs, _sector_addr(kvs, kvs->active) + kvs->pos);
+    res = _ws_put(kvs, hdr, sizeof(hdr));
+    for (uint32_t pos = REC_HDR_SIZE; (res == 0) && (pos < len);
+         pos += sizeof(kvs->rbuf)) {
+        uint32_t chunk = len - pos;
+        if (chunk > sizeof(kvs->rbuf)) {
+            chunk = sizeof(kvs->rbuf);
+        }
+        res = mtd_read(kvs->mtd, kvs->rbuf, addr + pos, chunk);
+        if (res == 0) {
+            res = _ws_put(kvs, kvs->rbuf, chunk);
+        }
+    }
+    if (res == 0) {
+        res = _ws_end(kvs);
+    }
+    kvs->pos += len;
+    kvs->nrec++;
+    return res;
+}
+
+static int _compact_record(kvstore_t *kvs, uint32_t addr, uint32_t hash,
+                           uint16_t len, bool deleted, void *arg)
+{
+    bool oldest = *(bool *)arg;
+    int i = _index_find(kvs, hash);
+
+    if ((i < 0) || (kvs->entries[i].addr != addr)) {
+        /* superseded */
+        return 0;
+    }
+    if (deleted && oldest) {
+        /* no older record of the key is left that it has to hide */
+        _index_remove(kvs, i);
+        return 0;
+    }
+
+    uint32_t to = _sector_addr(kvs, kvs->active) + kvs->pos;
+    int res = _move(kvs, addr, len);
+    if (res < 0) {
+        return res;
+    }
+    kvs->sectors[_sector_of(kvs, addr)].live -= _entry_size(&kvs->entries[i]);
+    kvs->sectors[kvs->active].live += _entry_size(&kvs->entries[i]);
+    kvs->entries[i].addr = to;
+    kvs->stats.moved++;
+    return 0;
+}
+
+/* returns the full sector to compact, NONE if there is none
+ *
+ * With wear set, a sector with rarely updated data is returned if the erase
+ * counts differ too much. Otherwise the sector with the fewest live records is
+ * returned if they fit into room bytes. */
+static uint32_t _victim(const kvstore_t *kvs, uint32_t room, bool wear)
+{
+    uint32_t least_live = NONE;
+    uint32_t least_erased = NONE;
+    uint32_t max_erase = 0;
+
+    for (uint32_t i = 0; i < kvs->sector_count; i++) {
+        const kvstore_sector_t *s = &kvs->sectors[i];
+
+        if (s->erase_count > max_erase) {
+            max_erase = s->erase_count;
+        }
+        if (s->state != SECTOR_FULL) {
+            continue;
+        }
+        if ((least_live == NONE) || (s->live < kvs->sectors[least_live].live)) {
+            least_live = i;
+        }
+        if ((least_erased == NONE) ||
+            (s->erase_count < kvs->sectors[least_erased].erase_count)) {
+            least_erased = i;
+        }
+    }
+    if (wear && (least_erased != NONE) &&
+        ((max_erase - kvs->sectors[least_erased].erase_count) >
+         CONFIG_KVSTORE_WEAR_THRESHOLD)) {
+        return least_erased;
+    }
+    if ((least_live != NONE) && (kvs->sectors[least_live].live <= room)) {
+        return least_live;
+    }
+    return NONE;
+}
+
+static int _compact(kvstore_t *kvs, uint32_t victim)
+{
+    bool oldest = true;
+    int res;
+
+    for (uint32_t i = 0; i < kvs->sector_count; i++) {
+        const kvstore_sector_t *s = &kvs->sectors[i];
+        if (((s->state == SECTOR_FULL) || (s->state == SECTOR_ACTIVE)) &&
+            ((int32_t)(s->seq - kvs->sectors[victim].seq) < 0)) {
+            oldest = false;
+        }
+    }
+    DEBUG("kvstore: compact sector %u, %u bytes live\n", (unsigned)victim,
+          (unsigned)kvs->sectors[victim].live);
+    res = _foreach_record(kvs, victim, _compact_record, &oldest);
+    if (res < 0) {
+        return res;
+    }
+    kvs->stats.compactions++;
+    return _erase(kvs, victim);
+}
+
+static unsigned _free_sectors(const kvstore_t *kvs, uint32_t *least_erased)
+{
+    unsigned count = 0;
+
+    *least_erased = NONE;
+    for (uint32_t i = 0; i < kvs->sector_count; i++) {
+        const kvstore_sector_t *s = &kvs->sectors[i];
+
+        if ((s->state != SECTOR_FREE) && (s->state != SECTOR_ERASED)) {
+            continue;
+        }
+        count++;
+        if ((*least_erased == NONE) ||
+            (s->erase_count < kvs->sectors[*least_erased].erase_count)) {
+            *least_erased = i;
+        }
+    }
+    return count;
+}
+
+static int _rebuild(kvstore_t *kvs);
+
+/* makes a sector free again after a compaction was interrupted
+ *
+ * The last free sector only receives the records of the sector compacted into
+ * it, which is erased after all of them were copied. If they do not fit, the
+ * newest sector holds nothing but copies and is dropped. */
+static int _recover(kvstore_t *kvs)
+{
+    uint32_t sector, victim = NONE;
+    int res;
+
+    if (_free_sectors(kvs, &sector) > 0) {
+        return 0;
+    }
+    if (kvs->active != NONE) {
+        victim = _victim(kvs, _sector_size(kvs) - FOOTER_SIZE - kvs->pos -
+                              kvs->nrec * SUM_ENTRY_SIZE, false);
+    }
+    if (victim != NONE) {
+        return _compact(kvs, victim);
+    }
+    for (sector = 0; sector < kvs->sector_count; sector++) {
+        if (kvs->sectors[sector].seq == kvs->seq) {
+            break;
+        }
+    }
+    DEBUG("kvstore: drop sector %u\n", (unsigned)sector);
+    res = _erase(kvs, sector);
+    if (res < 0) {
+        return res;
+    }
+    return _rebuild(kvs);
+}
+
+/* makes room for nrec records of len bytes in the active sector */
+static int _reserve(kvstore_t *kvs, uint32_t len, uint32_t nrec)
+{
+    uint32_t capacity = _sector_size(kvs) - SECTOR_HDR_SIZE - FOOTER_SIZE;
+    bool wear = true;
+    int res;
+
+    if ((len + nrec * SUM_ENTRY_SIZE) > capacity) {
+        return -ENOSPC;
+    }
+    for (uint32_t round = 0; round <= kvs->sector_count; round++) {
+        uint32_t sector, victim = NONE;
+        unsigned free = _free_sectors(kvs, &sector);
+
+        if (free == 0) {
+            /* nothing is written before the compaction is finished */
+            res = _recover(kvs);
+            if (res < 0) {
+                return res;
+            }
+            continue;
+        }
+        if (_fits(kvs, len, nrec)) {
+            return 0;
+        }
+        if (kvs->active != NONE) {
+            res = _seal(kvs);
+            if (res < 0) {
+                return res;
+            }
+        }
+        if (free == 1) {
+            /* the last free sector is only used to compact another one into
+             * it, moving rarely updated data at most once per call */
+            victim = _victim(kvs, capacity - len - nrec * SUM_ENTRY_SIZE,
+                             wear);
+            if (victim == NONE) {
+                return -ENOSPC;
+            }
+        }
+        res = _open(kvs, sector);
+        if (res < 0) {
+            return res;
+        }
+        if (victim != NONE) {
+            res = _compact(kvs, victim);
+            if (res < 0) {
+                return res;
+            }
+            wear = false;
+        }
+    }
+    return -ENOSPC;
+}
+
+/* writes a record to the active sector, space must be reserved */
+static int _write(kvstore_t *kvs, const _rec_t *tmpl, const char *key,
+                  const void *val, uint32_t *addr)
+{
+    uint8_t hdr[REC_HDR_SIZE];
+    _rec_t rec = *tmpl;
+    int res;
+
+    _rec_format(hdr, &rec);
+    rec.crc = crc16_ccitt_update(_rec_crc_hdr(hdr), (const uint8_t *)key,
+                                 rec.klen);
+    rec.crc = crc16_ccitt_update(rec.crc, val, rec.vlen);
+    _rec_format(hdr, &rec);
+
+    *addr = _sector_addr(kvs, kvs->active) + kvs->pos;
+    _ws_start(kvs, *addr);
+    res = _ws_put(kvs, hdr, sizeof(hdr));
+    if (res == 0) {
+        res = _ws_put(kvs, key, rec.klen);
+    }
+    if (res == 0) {
+        res = _ws_put(kvs, val, rec.vlen);
+    }
+    if (res == 0) {
+        res = _ws_end(kvs);
+    }
+    /* the space is used even if writing failed */
+    kvs->pos += _rec_len(rec.klen, rec.vlen);
+    kvs->nrec++;
+    return res;
+}
+
+static void _reset(kvstore_t *kvs)
+{
+    memset(kvs->entries, 0, kvs->entries_numof * sizeof(*kvs->entries));
+    kvs->keys = 0;
+    kvs->active = NONE;
+    kvs->seq = 0;
+    kvs->txn = 0;
+}
+
+static int _rebuild(kvstore_t *kvs)
+{
+    uint32_t prev_age = UINT32_MAX;
+    bool first = true;
+    int res;
+
+    _reset(kvs);
+    for (uint32_t i = 0; i < kvs->sector_count; i++) {
+        kvstore_sector_t *s = &kvs->sectors[i];
+        uint8_t hdr[SECTOR_HDR_SIZE];
+
+        res = mtd_read(kvs->mtd, hdr, _sector_addr(kvs, i), sizeof(hdr));
+        if (res < 0) {
+            return res;
+        }
+        s->live = 0;
+        if ((byteorder_bebuftohl(hdr) == SECTOR_MAGIC) &&
+            (byteorder_bebuftohs(hdr + 12) == crc16_ccitt_calc(hdr, 12))) {
+            s->seq = byteorder_bebuftohl(hdr + 4);
+            s->erase_count = byteorder_bebuftohl(hdr + 8);
+            s->state = SECTOR_FULL;
+            if (first || ((int32_t)(s->seq - kvs->seq) > 0)) {
+                kvs->seq = s->seq;
+                kvs->active = i;
+                first = false;
+            }
+        }
+        else {
+            s->seq = 0;
+            s->erase_count = 0;
+            s->state = SECTOR_FREE;
+        }
+    }
+    if (first) {
+        kvs->active = NONE;
+        return 0;
+    }
+
+    /* the erase count of sectors without header is lost, assume the
+     * average of the others */
+    uint64_t erases = 0;
+    unsigned used = 0;
+    for (uint32_t i = 0; i < kvs->sector_count; i++) {
+        if (kvs->sectors[i].state != SECTOR_FREE) {
+            erases += kvs->sectors[i].erase_count;
+            used++;
+        }
+    }
+    for (uint32_t i = 0; i < kvs->sector_count; i++) {
+        if (kvs->sectors[i].state == SECTOR_FREE) {
+            kvs->sectors[i].erase_count = erases / used;
+        }
+    }
+
+    /* apply the sectors oldest first, the age is the distance of the
+     * sequence number to the newest one */
+    while (1) {
+        uint32_t next = NONE;
+        uint32_t next_age = 0;
+
+        for (uint32_t i = 0; i < kvs->sector_count; i++) {
+            const kvstore_sector_t *s = &kvs->sectors[i];
+            uint32_t age = kvs->seq - s->seq;
+            if ((s->state == SECTOR_FULL) && (age < prev_age) &&
+                ((next == NONE) || (age > next_age))) {
+                next = i;
+                next_age = age;
+            }
+        }
+        if (next == NONE) {
+            break;
+        }
+        prev_age = next_age;
+        if (next == kvs->active) {
+            /* the newest sector, keep appending to it if it has no
+             * summary yet */
+            uint16_t count, start;
+            res = _read_footer(kvs, next, &count, &start);
+            if (res == 0) {
+                uint32_t end, nrec;
+                res = _scan(kvs, next, _sector_size(kvs) - FOOTER_SIZE,
+                            _apply, NULL, &end, &nrec);
+                kvs->pos = end;
+                kvs->nrec = nrec;
+                kvs->sectors[next].state = SECTOR_ACTIVE;
+                if ((res >= 0) && !_fits(kvs, 0, 0)) {
+                    /* no room for a summary, it is scanned on every boot */
+                    kvs->sectors[next].state = SECTOR_FULL;
+                }
+                else if (res > 0) {
+                    /* records appended behind a damaged one are not found,
+                     * a summary is only added if the footer is unused */
+                    res = _footer_erased(kvs, next);
+                    if (res > 0) {
+                        res = _seal(kvs);
+                    }
+                    else if (res == 0) {
+                        kvs->sectors[next].state = SECTOR_FULL;
+                    }
+                }
+                if (res < 0) {
+                    return res;
+                }
+                continue;
+            }
+            if (res < 0) {
+                return res;
+            }
+        }
+        res = _foreach_record(kvs, next, _apply, NULL);
+        if (res < 0) {
+            return res;
+        }
+    }
+    if ((kvs->active != NONE) &&
+        (kvs->sectors[kvs->active].state != SECTOR_ACTIVE)) {
+        kvs->active = NONE;
+    }
+    return 0;
+}
+
+int kvstore_init(kvstore_t *kvs)
+{
+    int res;
+
+    res = mtd_init(kvs->mtd);
+    if (res < 0) {
+        return res;
+    }
+    if ((kvs->sector_count < 2) || (kvs->entries_numof < 2) ||
+        ((kvs->first_sector + kvs->sector_count) > kvs->mtd->sector_count) ||
+        (_sector_size(kvs) > (UINT16_MAX + 1)) ||
+        (kvs->mtd->page_size % CONFIG_KVSTORE_ALIGN != 0) ||
+        (sizeof(kvs->wbuf) % CONFIG_KVSTORE_ALIGN != 0)) {
+        return -EINVAL;
+    }
+    memset(&kvs->stats, 0, sizeof(kvs->stats));
+
+    mutex_lock(&kvs->lock);
+    res = _rebuild(kvs);
+    if (res == 0) {
+        res = _recover(kvs);
+    }
+    if (res == 0) {
+        _default = kvs;
+    }
+    mutex_unlock(&kvs->lock);
+    return res;
+}
+
+int kvstore_format(kvstore_t *kvs)
+{
+    int res = 0;
+
+    mutex_lock(&kvs->lock);
+    for (uint32_t i = 0; (res == 0) && (i < kvs->sector_count); i++) {
+        res = _erase(kvs, i);
+    }
+    _reset(kvs);
+    mutex_unlock(&kvs->lock);
+    return res;
+}
+
+ssize_t kvstore_get(kvstore_t *kvs, const char *key, void *buf, size_t len)
+{
+    size_t klen = strlen(key);
+    uint8_t hdr[REC_HDR_SIZE];
+    _rec_t rec;
+    int res;
+    int i;
+
+    mutex_lock(&kvs->lock);
+    i = _index_find(kvs, _hash(key, klen));
+    if ((i < 0) || (kvs->entries[i].len & LEN_DELETED)) {
+        res = -ENOENT;
+        goto out;
+    }
+
+    uint32_t addr = kvs->entries[i].addr;
+    res = _rec_read(kvs, addr, &rec, hdr);
+    if (res < 0) {
+        goto out;
+    }
+    if ((rec.klen != klen) ||
+        (mtd_read(kvs->mtd, kvs->rbuf, addr + REC_HDR_SIZE, klen) != 0) ||
+        (memcmp(kvs->rbuf, key, klen) != 0)) {
+        res = -ENOENT;
+        goto out;
+    }
+    if (rec.vlen > len) {
+        res = -ENOBUFS;
+        goto out;
+    }
+    res = mtd_read(kvs->mtd, buf, addr + REC_HDR_SIZE + klen, rec.vlen);
+    if (res < 0) {
+        goto out;
+    }
+    uint16_t crc = crc16_ccitt_update(_rec_crc_hdr(hdr), (const uint8_t *)key,
+                                      klen);
+    if (crc16_ccitt_update(crc, buf, rec.vlen) != rec.crc) {
+        res = -EIO;
+        goto out;
+    }
+    res = rec.vlen;
+out:
+    mutex_unlock(&kvs->lock);
+    return res;
+}
+
+static int _update(kvstore_t *kvs, uint8_t type, const char *key,
+                   const void *val, size_t len)
+{
+    size_t klen = strlen(key);
+    uint32_t hash = _hash(key, klen);
+    _rec_t rec = {
+        .type = type, .flags = 0, .klen = klen, .vlen = len, .txn = NO_TXN,
+    };
+    uint32_t rec_len = _rec_len(klen, len);
+    uint32_t addr;
+    bool known;
+    int res;
+
+    if ((klen > CONFIG_KVSTORE_KEY_MAX) || (rec_len >= LEN_DELETED)) {
+        return -EINVAL;
+    }
+    mutex_lock(&kvs->lock);
+    res = _check_key(kvs, key, klen, hash, &known);
+    if ((type == TYPE_DEL) && ((res == -EEXIST) || ((res == 0) &&
+        (!known || (kvs->entries[_index_find(kvs, hash)].len & LEN_DELETED))))) {
+        res = -ENOENT;
+    }
+    if ((res == 0) && !known && (_index_slot(kvs, hash) < 0)) {
+        res = -ENOMEM;
+    }
+    if (res == 0) {
+        res = _reserve(kvs, rec_len, 1);
+    }
+    if (res == 0) {
+        res = _write(kvs, &rec, key, val, &addr);
+    }
+    if (res == 0) {
+        res = _apply(kvs, addr, hash, rec_len, type == TYPE_DEL, NULL);
+    }
+    mutex_unlock(&kvs->lock);
+    return res;
+}
+
+int kvstore_set(kvstore_t *kvs, const char *key, const void *val, size_t len)
+{
+    return _update(kvs, TYPE_PUT, key, val, len);
+}
+
+int kvstore_delete(kvstore_t *kvs, const char *key)
+{
+    return _update(kvs, TYPE_DEL, key, NULL, 0);
+}
+
+int kvstore_foreach(kvstore_t *kvs, kvstore_cb_t cb, void *arg)
+{
+    char key[CONFIG_KVSTORE_KEY_MAX + 1];
+    int count = 0;
+
+    mutex_lock(&kvs->lock);
+    for (unsigned i = 0; i < kvs->entries_numof; i++) {
+        const kvstore_entry_t *entry = &kvs->entries[i];
+        uint8_t hdr[REC_HDR_SIZE];
+        _rec_t rec;
+        int res;
+
+        if ((entry->addr == 0) || (entry->len & LEN_DELETED)) {
+            continue;
+        }
+        res = _rec_read(kvs, entry->addr, &rec, hdr);
+        if (res == 0) {
+            res = mtd_read(kvs->mtd, key, entry->addr + REC_HDR_SIZE, rec.klen);
+        }
+        if (res < 0) {
+            count = res;
+            break;
+        }
+        key[rec.klen] = '\0';
+        cb(key, rec.vlen, arg);
+        count++;
+    }
+    mutex_unlock(&kvs->lock);
+    return count;
+}
+
+kvstore_t *kvstore_default(void)
+{
+    return _default;
+}
+
+/* transactions, the buffer holds type (1), key length (1), value length (2,
+ * host byte order), key and value of every update */
+
+#define TXN_OP_SIZE     (4U)
+
+void kvstore_txn_init(kvstore_txn_t *txn, kvstore_t *kvs, void *buf,
+                      size_t size)
+{
+    txn->kvs = kvs;
+    txn->buf = buf;
+    txn->size = size;
+    txn->len = 0;
+}
+
+static int _txn_add(kvstore_txn_t *txn, uint8_t type, const char *key,
+                    const void *val, size_t len)
+{
+    size_t klen = strlen(key);
+    uint16_t vlen = len;
+    uint8_t *op = txn->buf + txn->len;
+
+    if ((klen > CONFIG_KVSTORE_KEY_MAX) ||
+        (_rec_len(klen, len) >= LEN_DELETED)) {
+        return -EINVAL;
+    }
+    if ((txn->len + TXN_OP_SIZE + klen + len) > txn->size) {
+        return -ENOBUFS;
+    }
+    op[0] = type;
+    op[1] = klen;
+    memcpy(op + 2, &vlen, sizeof(vlen));
+    memcpy(op + TXN_OP_SIZE, key, klen);
+    if (len > 0) {
+        memcpy(op + TXN_OP_SIZE + klen, val, len);
+    }
+    txn->len += TXN_OP_SIZE + klen + len;
+    return 0;
+}
+
+int kvstore_txn_set(kvstore_txn_t *txn, const char *key, const void *val,
+                    size_t len)
+{
+    return _txn_add(txn, TYPE_PUT, key, val, len);
+}
+
+int kvstore_txn_delete(kvstore_txn_t *txn, const char *key)
+{
+    return _txn_add(txn, TYPE_DEL, key, NULL, 0);
+}
+
+/* iterates the updates of a transaction */
+static const uint8_t *_txn_next(const kvstore_txn_t *txn, const uint8_t *op,
+                                _rec_t *rec, const char **key,
+                                const uint8_t **val)
+{
+    if (op == NULL) {
+        op = txn->buf;
+    }
+    else {
+        op += TXN_OP_SIZE + rec->klen + rec->vlen;
+    }
+    if (op >= (txn->buf + txn->len)) {
+        return NULL;
+    }
+    rec->type = op[0];
+    rec->klen = op[1];
+    memcpy(&rec->vlen, op + 2, sizeof(rec->vlen));
+    *key = (const char *)op + TXN_OP_SIZE;
+    *val = op + TXN_OP_SIZE + rec->klen;
+    return op;
+}
+
+int kvstore_txn_commit(kvstore_txn_t *txn)
+{
+    kvstore_t *kvs = txn->kvs;
+    const uint8_t *op = NULL;
+    const uint8_t *val;
+    const char *key;
+    uint32_t len = _rec_len(0, 0);
+    uint32_t nrec = 1;
+    unsigned added = 0;
+    uint32_t addr;
+    _rec_t rec = { .flags = FLAG_TXN };
+    int res = 0;
+
+    if (txn->len == 0) {
+        return 0;
+    }
+    mutex_lock(&kvs->lock);
+    while ((res == 0) && (op = _txn_next(txn, op, &rec, &key, &val))) {
+        bool known;
+
+        res = _check_key(kvs, key, rec.klen, _hash(key, rec.klen), &known);
+        added += !known;
+        len += _rec_len(rec.klen, rec.vlen);
+        nrec++;
+    }
+    if ((res == 0) && ((kvs->keys + added + 1) > kvs->entries_numof)) {
+        res = -ENOMEM;
+    }
+    if (res == 0) {
+        res = _reserve(kvs, len, nrec);
+    }
+    if (res < 0) {
+        goto out;
+    }
+
+    /* the records, then the record committing them */
+    rec.txn = kvs->txn++;
+    while ((res == 0) && (op = _txn_next(txn, op, &rec, &key, &val))) {
+        res = _write(kvs, &rec, key, val, &addr);
+    }
+    if (res == 0) {
+        _rec_t commit = {
+            .type = TYPE_COMMIT, .flags = FLAG_TXN, .txn = rec.txn,
+        };
+        res = _write(kvs, &commit, NULL, NULL, &addr);
+    }
+    if (res < 0) {
+        goto out;
+    }
+
+    /* the records follow each other, their addresses are known */
+    addr = _sector_addr(kvs, kvs->active) + kvs->pos - len;
+    while ((res == 0) && (op = _txn_next(txn, op, &rec, &key, &val))) {
+        uint32_t rec_len = _rec_len(rec.klen, rec.vlen);
+        res = _apply(kvs, addr, _hash(key, rec.klen), rec_len,
+                     rec.type == TYPE_DEL, NULL);
+        addr += rec_len;
+    }
+out:
+    txn->len = 0;
+    mutex_unlock(&kvs->lock);
+    return res;
+}
@@ -35,6 +35,34 @@ struct iovec {
     size_t iov_len;     /**< Length of data.    */
 };
 
+/**
+ * @brief   Read from a file into several buffers
+ *
+ * Provided by the `vfs` module.
+ *
+ * @param[in]  fd       file descriptor
+ * @param[in]  iov      buffers to fill in order
+ * @param[in]  iovcnt   number of buffers in @p iov
+ *
+ * @return  number of bytes read on success
+ * @return  -1 on error, errno is set
+ */
+ssize_t readv(int fd, const struct iovec *iov, int iovcnt);
+
+/**
+ * @brief   Write to a file from several buffers
+ *
+ * Provided by the `vfs` module.
+ *
+ * @param[in]  fd       file descriptor
+ * @param[in]  iov      buffers to write in order
+ * @param[in]  iovcnt   number of buffers in @p iov
+ *
+ * @return  number of bytes written on success
+ * @return  -1 on error, errno is set
+ */
+ssize_t writev(int fd, const struct iovec *iov, int iovcnt);
+
 #ifdef __cplusplus
 }
 #endif
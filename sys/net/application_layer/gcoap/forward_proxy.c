@@ -0,0 +1,402 @@
+/*
+ * Copyright (C) 2020 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     net_gcoap_forward_proxy
+ * @{
+ *
+ * @file
+ * @brief       Forward proxy for gcoap
+ *
+ * @}
+ */
+
+#include <errno.h>
+#include <string.h>
+
+#include "net/gcoap_forward_proxy.h"
+#include "net/ipv6/addr.h"
+#include "net/nanocoap_cache.h"
+#include "uri_parser.h"
+
+#define ENABLE_DEBUG (0)
+#include "debug.h"
+
+/* A client waiting for the response of an origin server */
+typedef struct {
+    bool in_use;
+    bool cacheable;                     /* GET request, response is stored */
+    bool client_etag;                   /* request carries an ETag of the
+                                           client */
+    uint8_t token_len;
+    uint8_t token[COAP_TOKEN_LENGTH_MAX];
+    uint8_t key[CONFIG_NANOCOAP_CACHE_KEY_LENGTH];
+    nanocoap_cache_entry_t *stale;      /* stored response being validated */
+    sock_udp_ep_t ep;
+} _client_t;
+
+/* Origin server and the options to forward in place of the proxy options */
+typedef struct {
+    sock_udp_ep_t ep;
+    bool proxy_uri;                     /* Uri-Path and Uri-Query are taken
+                                           from Proxy-Uri */
+    const char *path;
+    size_t path_len;
+    const char *query;
+    size_t query_len;
+} _origin_t;
+
+static _client_t _clients[CONFIG_GCOAP_FORWARD_PROXY_CLIENTS_MAX];
+/* forwarded request, or response to a client */
+static uint8_t _buf[CONFIG_GCOAP_PDU_BUF_SIZE];
+
+static int _parse_host(_origin_t *origin, const char *host, size_t host_len,
+                       const char *port, size_t port_len)
+{
+    char addr[IPV6_ADDR_MAX_STR_LEN];
+
+    /* only IPv6 literals, name resolution is not available */
+    if ((host_len < 3) || (host[0] != '[') || (host[host_len - 1] != ']')
+            || (host_len - 2 >= sizeof(addr))) {
+        return -EINVAL;
+    }
+    memcpy(addr, host + 1, host_len - 2);
+    addr[host_len - 2] = '\0';
+    if (!ipv6_addr_from_str((ipv6_addr_t *)&origin->ep.addr.ipv6, addr)) {
+        return -EINVAL;
+    }
+
+    origin->ep.family = AF_INET6;
+    origin->ep.netif = SOCK_ADDR_ANY_NETIF;
+    origin->ep.port = COAP_PORT;
+    if (port_len) {
+        uint32_t value = 0;
+        for (size_t i = 0; i < port_len; i++) {
+            if ((port[i] < '0') || (port[i] > '9')) {
+                return -EINVAL;
+            }
+            value = value * 10 + (port[i] - '0');
+            if (value > UINT16_MAX) {
+                return -EINVAL;
+            }
+        }
+        origin->ep.port = value;
+    }
+    return 0;
+}
+
+/* Finds the origin server of a request */
+static int _parse_origin(_origin_t *origin, coap_pkt_t *pdu)
+{
+    uint8_t *value;
+    ssize_t len;
+
+    memset(origin, 0, sizeof(*origin));
+
+    len = coap_opt_get_opaque(pdu, COAP_OPT_PROXY_URI, &value);
+    if (len > 0) {
+        uri_parser_result_t uri;
+        if ((uri_parser_process(&uri, (char *)value, len) < 0)
+                || (uri.scheme_len != 4) || strncmp(uri.scheme, "coap", 4)) {
+            return -ENOTSUP;
+        }
+        origin->proxy_uri = true;
+        origin->path = uri.path;
+        origin->path_len = uri.path_len;
+        origin->query = uri.query;
+        origin->query_len = uri.query_len;
+        return _parse_host(origin, uri.host, uri.host_len, uri.port,
+                           uri.port_len);
+    }
+
+    len = coap_opt_get_opaque(pdu, COAP_OPT_PROXY_SCHEME, &value);
+    if ((len != 4) || strncmp((char *)value, "coap", 4)) {
+        return -ENOTSUP;
+    }
+    uint8_t *host;
+    len = coap_opt_get_opaque(pdu, COAP_OPT_URI_HOST, &host);
+    if (len <= 0) {
+        return -EINVAL;
+    }
+    int res = _parse_host(origin, (char *)host, len, NULL, 0);
+    uint32_t port;
+    if (coap_opt_get_uint(pdu, COAP_OPT_URI_PORT, &port) == 0) {
+        origin->ep.port = port;
+    }
+    return res;
+}
+
+/* Adds the options of the request to forward, in ascending order */
+static int _add_options(coap_pkt_t *fwd, coap_pkt_t *pdu,
+                        const _origin_t *origin, const uint8_t *etag,
+                        size_t etag_len)
+{
+    bool etag_added = (etag == NULL);
+    bool path_added = (origin->path == NULL);
+    bool query_added = (origin->query == NULL);
+    coap_optpos_t opt;
+    uint8_t *value;
+
+    ssize_t len = coap_opt_get_next(pdu, &opt, &value, true);
+    while (1) {
+        /* the number of the next option of the request, or beyond all */
+        unsigned opt_num = (len >= 0) ? opt.opt_num : UINT16_MAX;
+        ssize_t res = 0;
+
+        if (!etag_added && (opt_num > COAP_OPT_ETAG)) {
+            res = coap_opt_add_opaque(fwd, COAP_OPT_ETAG, etag, etag_len);
+            etag_added = true;
+        }
+        else if (!path_added && (opt_num > COAP_OPT_URI_PATH)) {
+            res = coap_opt_add_chars(fwd, COAP_OPT_URI_PATH, origin->path,
+                                     origin->path_len, '/');
+            path_added = true;
+        }
+        else if (!query_added && (opt_num > COAP_OPT_URI_QUERY)) {
+            res = coap_opt_add_chars(fwd, COAP_OPT_URI_QUERY, origin->query,
+                                     origin->query_len, '&');
+            query_added = true;
+        }
+        else if (len < 0) {
+            break;
+        }
+        else {
+            switch (opt_num) {
+            case COAP_OPT_URI_HOST:
+            case COAP_OPT_URI_PORT:
+            case COAP_OPT_PROXY_URI:
+            case COAP_OPT_PROXY_SCHEME:
+                /* consumed by the proxy */
+                break;
+            case COAP_OPT_URI_PATH:
+            case COAP_OPT_URI_QUERY:
+                if (!origin->proxy_uri) {
+                    res = coap_opt_add_opaque(fwd, opt_num, value, len);
+                }
+                break;
+            default:
+                res = coap_opt_add_opaque(fwd, opt_num, value, len);
+            }
+            len = coap_opt_get_next(pdu, &opt, &value, false);
+        }
+        if (res < 0) {
+            return res;
+        }
+    }
+    return 0;
+}
+
+/* Builds the request to forward in _buf */
+static ssize_t _build_request(coap_pkt_t *pdu, const _origin_t *origin,
+                              const uint8_t *etag, size_t etag_len)
+{
+    coap_pkt_t fwd;
+
+    int res = gcoap_req_init(&fwd, _buf, sizeof(_buf),
+                             coap_get_code_raw(pdu), NULL);
+    if (res < 0) {
+        return res;
+    }
+    coap_hdr_set_type(fwd.hdr, coap_get_type(pdu));
+
+    res = _add_options(&fwd, pdu, origin, etag, etag_len);
+    if (res < 0) {
+        return res;
+    }
+    ssize_t len = coap_opt_finish(&fwd, pdu->payload_len
+                                        ? COAP_OPT_FINISH_PAYLOAD
+                                        : COAP_OPT_FINISH_NONE);
+    if (pdu->payload_len > fwd.payload_len) {
+        return -ENOSPC;
+    }
+    memcpy(fwd.payload, pdu->payload, pdu->payload_len);
+    return len + pdu->payload_len;
+}
+
+/* Builds the response to a client in _buf from the response of the origin
+ * server */
+static ssize_t _build_response(const _client_t *client, coap_pkt_t *pdu)
+{
+    uint8_t *body = coap_hdr_data_ptr(pdu->hdr) + coap_get_token_len(pdu);
+    size_t body_len = pdu->payload + pdu->payload_len - body;
+
+    if (sizeof(coap_hdr_t) + client->token_len + body_len > sizeof(_buf)) {
+        return -ENOSPC;
+    }
+    size_t len = coap_build_hdr((coap_hdr_t *)_buf, COAP_TYPE_NON,
+                                (uint8_t *)client->token, client->token_len,
+                                coap_get_code_raw(pdu), gcoap_next_msg_id());
+    memcpy(_buf + len, body, body_len);
+    return len + body_len;
+}
+
+static ssize_t _build_error(const _client_t *client, unsigned code)
+{
+    return coap_build_hdr((coap_hdr_t *)_buf, COAP_TYPE_NON,
+                          (uint8_t *)client->token, client->token_len, code,
+                          gcoap_next_msg_id());
+}
+
+/* Checks whether a 2.03 Valid response validates the stale response */
+static bool _validates(const _client_t *client, coap_pkt_t *pdu)
+{
+    nanocoap_cache_entry_t *ce = client->stale;
+    uint8_t *stored;
+    uint8_t *etag;
+
+    /* the entry may have been replaced while the request was open */
+    if (!ce || !ce->response_len
+            || memcmp(ce->key, client->key, sizeof(client->key))) {
+        return false;
+    }
+    ssize_t stored_len = nanocoap_cache_entry_etag(ce, &stored);
+    ssize_t etag_len = coap_opt_get_opaque(pdu, COAP_OPT_ETAG, &etag);
+    return (stored_len >= 0) && (stored_len == etag_len)
+           && !memcmp(stored, etag, etag_len);
+}
+
+static void _forward_resp_handler(const gcoap_request_memo_t *memo,
+                                  coap_pkt_t *pdu,
+                                  const sock_udp_ep_t *remote)
+{
+    (void)remote;
+    _client_t *client = memo->context;
+    ssize_t len;
+
+    if (memo->state != GCOAP_MEMO_RESP) {
+        len = _build_error(client, COAP_CODE_GATEWAY_TIMEOUT);
+    }
+    else if ((coap_get_code_raw(pdu) == COAP_CODE_VALID) && client->cacheable
+             && _validates(client, pdu)) {
+        nanocoap_cache_validate(client->stale, pdu);
+        if (client->client_etag) {
+            /* the client validates the same representation */
+            len = _build_response(client, pdu);
+        }
+        else {
+            len = nanocoap_cache_entry_build(client->stale, _buf, sizeof(_buf),
+                                             COAP_TYPE_NON, client->token,
+                                             client->token_len,
+                                             gcoap_next_msg_id());
+        }
+    }
+    else {
+        if (client->cacheable) {
+            size_t resp_len = pdu->payload + pdu->payload_len
+                              - (uint8_t *)pdu->hdr;
+            nanocoap_cache_add(client->key, pdu, resp_len);
+        }
+        len = _build_response(client, pdu);
+    }
+
+    if (len < 0) {
+        DEBUG("gcoap_forward_proxy: response too long\n");
+        len = _build_error(client, COAP_CODE_BAD_GATEWAY);
+    }
+    if (gcoap_forward_proxy_dispatch(_buf, len, &client->ep) <= 0) {
+        DEBUG("gcoap_forward_proxy: send to client failed\n");
+    }
+    client->in_use = false;
+}
+
+static _client_t *_client_alloc(coap_pkt_t *pdu,
+                                const sock_udp_ep_t *ep)
+{
+    for (unsigned i = 0; i < CONFIG_GCOAP_FORWARD_PROXY_CLIENTS_MAX; i++) {
+        _client_t *client = &_clients[i];
+        if (!client->in_use) {
+            memset(client, 0, sizeof(*client));
+            client->in_use = true;
+            client->token_len = coap_get_token_len(pdu);
+            memcpy(client->token, pdu->token, client->token_len);
+            client->ep = *ep;
+            return client;
+        }
+    }
+    return NULL;
+}
+
+size_t gcoap_forward_proxy_request_process(coap_pkt_t *pdu, uint8_t *buf,
+                                           size_t len,
+                                           const sock_udp_ep_t *client_ep)
+{
+    uint8_t key[CONFIG_NANOCOAP_CACHE_KEY_LENGTH];
+    nanocoap_cache_entry_t *ce = NULL;
+    uint8_t *etag = NULL;
+    ssize_t etag_len = 0;
+    _origin_t origin;
+
+    int res = _parse_origin(&origin, pdu);
+    if (res < 0) {
+        DEBUG("gcoap_forward_proxy: unsupported origin: %d\n", res);
+        return gcoap_response(pdu, buf, len,
+                              (res == -ENOTSUP)
+                              ? COAP_CODE_PROXYING_NOT_SUPPORTED
+                              : COAP_CODE_BAD_OPTION);
+    }
+
+    bool cacheable = (coap_get_code_raw(pdu) == COAP_METHOD_GET);
+    bool client_etag = (coap_opt_get_opaque(pdu, COAP_OPT_ETAG, &etag) >= 0);
+    if (cacheable) {
+        nanocoap_cache_key_generate(pdu, key);
+        ce = nanocoap_cache_lookup(key);
+    }
+    if (ce && !nanocoap_cache_entry_is_stale(ce)) {
+        uint8_t token[COAP_TOKEN_LENGTH_MAX];
+        unsigned token_len = coap_get_token_len(pdu);
+        unsigned type = (coap_get_type(pdu) == COAP_TYPE_CON)
+                        ? COAP_TYPE_ACK : COAP_TYPE_NON;
+        /* the token is overwritten with the response */
+        memcpy(token, pdu->token, token_len);
+        ssize_t resp_len = nanocoap_cache_entry_build(ce, buf, len, type, token,
+                                                      token_len,
+                                                      coap_get_id(pdu));
+        if (resp_len > 0) {
+            return resp_len;
+        }
+        return gcoap_response(pdu, buf, len, COAP_CODE_INTERNAL_SERVER_ERROR);
+    }
+
+    /* validate a stale response with its ETag, unless the client validates
+     * its own representations */
+    etag = NULL;
+    if (ce && !client_etag) {
+        etag_len = nanocoap_cache_entry_etag(ce, &etag);
+        if (etag_len < 0) {
+            etag = NULL;
+        }
+    }
+
+    _client_t *client = _client_alloc(pdu, client_ep);
+    if (!client) {
+        DEBUG("gcoap_forward_proxy: no space for client\n");
+        return gcoap_response(pdu, buf, len, COAP_CODE_SERVICE_UNAVAILABLE);
+    }
+    client->cacheable = cacheable;
+    client->client_etag = client_etag;
+    client->stale = ce;
+    if (cacheable) {
+        memcpy(client->key, key, sizeof(key));
+    }
+
+    ssize_t fwd_len = _build_request(pdu, &origin, etag, etag_len);
+    if ((fwd_len <= 0)
+            || !gcoap_req_send(_buf, fwd_len, &origin.ep,
+                               _forward_resp_handler, client)) {
+        DEBUG("gcoap_forward_proxy: forwarding failed\n");
+        client->in_use = false;
+        return gcoap_response(pdu, buf, len, COAP_CODE_BAD_GATEWAY);
+    }
+
+    /* the response of the origin server follows separately */
+    if (coap_get_type(pdu) == COAP_TYPE_CON) {
+        return coap_build_hdr(pdu->hdr, COAP_TYPE_ACK, NULL, 0,
+                              COAP_CODE_EMPTY, coap_get_id(pdu));
+    }
+    return 0;
+}
@@ -26,12 +26,22 @@
 #include <string.h>
 
 #include "assert.h"
+#include "memarray.h"
 #include "net/gcoap.h"
+#ifdef MODULE_GCOAP_FORWARD_PROXY
+#include "net/gcoap_forward_proxy.h"
+#endif
+#ifdef MODULE_NANOCOAP_BLOCK
+#include "net/nanocoap_block.h"
+#endif
 #include "net/sock/async/event.h"
 #include "net/sock/util.h"
 #include "mutex.h"
 #include "random.h"
 #include "thread.h"
+#ifdef MODULE_GCOAP_SENDFILE
+#include "vfs.h"
+#endif
 
 #define ENABLE_DEBUG (0)
 #include "debug.h"
@@ -44,6 +54,10 @@
 /* End of the range to pick a random timeout */
 #define TIMEOUT_RANGE_END (CONFIG_COAP_ACK_TIMEOUT * CONFIG_COAP_RANDOM_FACTOR_1000 / 1000)
 
+/* Resend buffers in words, so that they are suitably aligned for memarray */
+#define RESEND_BUF_WORDS  ((CONFIG_GCOAP_RESEND_BUF_SIZE + sizeof(uintptr_t) - 1) \
+                           / sizeof(uintptr_t))
+
 /* Internal functions */
 static void *_event_loop(void *arg);
 static void _on_sock_evt(sock_udp_t *sock, sock_async_flags_t type, void *arg);
@@ -53,13 +67,19 @@ static size_t _handle_req(coap_pkt_t *pdu, uint8_t *buf, size_t len,
 static void _expire_request(gcoap_request_memo_t *memo);
 static void _find_req_memo(gcoap_request_memo_t **memo_ptr, coap_pkt_t *pdu,
                            const sock_udp_ep_t *remote);
+static void _free_req_memo(gcoap_request_memo_t *memo);
+#ifdef MODULE_GCOAP_COCOA
+static void _cocoa_update(gcoap_request_memo_t *memo);
+static uint32_t _cocoa_backoff(gcoap_request_memo_t *memo);
+#endif
 static int _find_resource(coap_pkt_t *pdu, const coap_resource_t **resource_ptr,
                                             gcoap_listener_t **listener_ptr);
-static int _find_observer(sock_udp_ep_t **observer, sock_udp_ep_t *remote);
-static int _find_obs_memo(gcoap_observe_memo_t **memo, sock_udp_ep_t *remote,
-                                                       coap_pkt_t *pdu);
-static void _find_obs_memo_resource(gcoap_observe_memo_t **memo,
-                                   const coap_resource_t *resource);
+static bool _obs_register(coap_pkt_t *pdu, const coap_resource_t *resource,
+                          const sock_udp_ep_t *remote);
+static void _obs_deregister(coap_pkt_t *pdu, const sock_udp_ep_t *remote);
+#if CONFIG_GCOAP_OBS_MIN_INTERVAL
+static void _on_obs_flush(void *arg);
+#endif
 
 /* Internal variables */
 const coap_resource_t _default_resources[] = {
@@ -73,24 +93,97 @@ static gcoap_listener_t _default_listener = {
     NULL
 };
 
+#ifdef MODULE_GCOAP_COCOA
+/* Initial and maximum retransmission timeout [ms] */
+#define COCOA_RTO_INIT  (CONFIG_COAP_ACK_TIMEOUT * MS_PER_SEC)
+#define COCOA_RTO_MAX   (32U * MS_PER_SEC)
+
+/* Round-trip time estimator as in RFC 6298 */
+typedef struct {
+    uint32_t srtt;                      /* Smoothed RTT [ms]; 0 if no sample */
+    uint32_t rttvar;                    /* RTT variation [ms] */
+} cocoa_est_t;
+
+/* Congestion control state of an endpoint */
+struct gcoap_peer {
+    sock_udp_ep_t remote;               /* Endpoint; entry unused if family
+                                           is AF_UNSPEC */
+    cocoa_est_t strong;                 /* Estimator for RTTs of requests
+                                           answered without retransmission */
+    cocoa_est_t weak;                   /* Estimator for RTTs of retransmitted
+                                           requests */
+    uint32_t rto;                       /* Overall RTO [ms] */
+    uint32_t updated;                   /* Time of last RTO update [ms] */
+    unsigned open;                      /* Confirmable requests sent and not
+                                           answered */
+    gcoap_request_memo_t *queue;        /* First request waiting for NSTART */
+    gcoap_request_memo_t *queue_last;   /* Last request waiting for NSTART */
+};
+#endif
+
+/* Observed resource with its registrations */
+typedef struct {
+    const coap_resource_t *resource;    /* Resource; entry unused if NULL */
+    gcoap_observe_memo_t *memos;        /* Registrations for the resource */
+#if CONFIG_GCOAP_OBS_MIN_INTERVAL
+    uint32_t last;                      /* Time of last notification [us] */
+    event_timeout_t flush_tmout;        /* Ends the interval of a pending
+                                           notification */
+    event_callback_t flush_cb;          /* Sends the pending notification */
+    size_t pending_len;                 /* Length of pending; 0 if none */
+    uint8_t pending[CONFIG_GCOAP_PDU_BUF_SIZE];
+                                        /* Notification delayed until the
+                                           interval is over */
+#endif
+} gcoap_obs_resource_t;
+
+/* Observer a notification is sent to, copied from its registration */
+typedef struct {
+    sock_udp_ep_t remote;               /* Endpoint of the observer */
+    uint8_t token[GCOAP_TOKENLEN_MAX];  /* Token of the registration */
+    uint8_t token_len;                  /* Length of token */
+} gcoap_obs_target_t;
+
 /* Container for the state of gcoap itself */
 typedef struct {
     mutex_t lock;                       /* Shares state attributes safely */
     gcoap_listener_t *listeners;        /* List of registered listeners */
     gcoap_request_memo_t open_reqs[CONFIG_GCOAP_REQ_WAITING_MAX];
-                                        /* Storage for open requests; if first
-                                           byte of an entry is zero, the entry
-                                           is available */
+                                        /* Storage for open requests */
+    memarray_t req_pool;                /* Unused entries of open_reqs */
+    gcoap_request_memo_t *req_index[CONFIG_GCOAP_REQ_INDEX_SIZE];
+                                        /* Open requests, by hash of token */
+    unsigned open_reqs_num;             /* Number of open requests */
     atomic_uint next_message_id;        /* Next message ID to use */
     sock_udp_ep_t observers[CONFIG_GCOAP_OBS_CLIENTS_MAX];
                                         /* Observe clients; allows reuse for
                                            observe memos */
+    unsigned observer_refs[CONFIG_GCOAP_OBS_CLIENTS_MAX];
+                                        /* Observe memos of each client */
     gcoap_observe_memo_t observe_memos[CONFIG_GCOAP_OBS_REGISTRATIONS_MAX];
                                         /* Observed resource registrations */
-    uint8_t resend_bufs[CONFIG_GCOAP_RESEND_BUFS_MAX][CONFIG_GCOAP_PDU_BUF_SIZE];
-                                        /* Buffers for PDU for request resends;
-                                           if first byte of an entry is zero,
-                                           the entry is available */
+    memarray_t obs_pool;                /* Unused entries of observe_memos */
+    gcoap_observe_memo_t *obs_index[CONFIG_GCOAP_OBS_INDEX_SIZE];
+                                        /* Registrations, by hash of token */
+    gcoap_obs_resource_t obs_resources[CONFIG_GCOAP_OBS_RESOURCES_MAX];
+                                        /* Observed resources */
+    mutex_t obs_send_lock;              /* Serializes sending notifications;
+                                           taken before lock */
+    gcoap_obs_target_t obs_targets[CONFIG_GCOAP_OBS_REGISTRATIONS_MAX];
+                                        /* Observers of the notification
+                                           being sent */
+    uint8_t obs_buf[CONFIG_GCOAP_PDU_BUF_SIZE];
+                                        /* Copy of the notification being
+                                           sent */
+    uintptr_t resend_bufs[CONFIG_GCOAP_RESEND_BUFS_MAX][RESEND_BUF_WORDS];
+                                        /* Buffers for PDU for request resends */
+    memarray_t resend_pool;             /* Unused entries of resend_bufs */
+    gcoap_stats_t stats;                /* Statistics on sent requests */
+#ifdef MODULE_GCOAP_COCOA
+    gcoap_peer_t peers[CONFIG_GCOAP_PEERS_MAX];
+                                        /* Congestion control state of
+                                           endpoints */
+#endif
 } gcoap_state_t;
 
 static gcoap_state_t _coap_state = {
@@ -102,6 +195,14 @@ static char _msg_stack[GCOAP_STACK_SIZE];
 static event_queue_t _queue;
 static uint8_t _listen_buf[CONFIG_GCOAP_PDU_BUF_SIZE];
 static sock_udp_t _sock;
+#ifdef MODULE_GCOAP_SENDFILE
+/* payload of the response to the current request, set by a resource handler
+ * with gcoap_resp_sendfile() */
+static struct {
+    int fd;
+    size_t len;
+} _resp_file = { .fd = -1 };
+#endif
 
 /* Event loop for gcoap _pid thread. */
 static void *_event_loop(void *arg)
@@ -177,12 +278,29 @@ static void _on_sock_evt(sock_udp_t *sock, sock_async_flags_t type, void *arg)
                 size_t pdu_len = _handle_req(&pdu, _listen_buf, sizeof(_listen_buf),
                                              &remote);
                 if (pdu_len > 0) {
-                    ssize_t bytes = sock_udp_send(sock, _listen_buf, pdu_len,
+                    ssize_t bytes;
+#ifdef MODULE_GCOAP_SENDFILE
+                    if (_resp_file.fd >= 0) {
+                        bytes = sock_udp_sendfile(sock, _listen_buf, pdu_len,
+                                                  _resp_file.fd, _resp_file.len,
                                                   &remote);
+                    }
+                    else
+#endif
+                    {
+                        bytes = sock_udp_send(sock, _listen_buf, pdu_len,
+                                              &remote);
+                    }
                     if (bytes <= 0) {
                         DEBUG("gcoap: send response failed: %d\n", (int)bytes);
                     }
                 }
+#ifdef MODULE_GCOAP_SENDFILE
+                if (_resp_file.fd >= 0) {
+                    vfs_close(_resp_file.fd);
+                    _resp_file.fd = -1;
+                }
+#endif
             }
             else {
                 DEBUG("gcoap: illegal request type: %u\n", coap_get_type(&pdu));
@@ -202,18 +320,17 @@ empty_as_response:
                 switch (coap_get_type(&pdu)) {
                 case COAP_TYPE_NON:
                 case COAP_TYPE_ACK:
-                    if (memo->resp_evt_tmout.queue) {
-                        event_timeout_clear(&memo->resp_evt_tmout);
-                    }
+                    mutex_lock(&_coap_state.lock);
+                    _coap_state.stats.responses++;
+                    mutex_unlock(&_coap_state.lock);
+#ifdef MODULE_GCOAP_COCOA
+                    _cocoa_update(memo);
+#endif
                     memo->state = GCOAP_MEMO_RESP;
                     if (memo->resp_handler) {
                         memo->resp_handler(memo, &pdu, &remote);
                     }
-
-                    if (memo->send_limit >= 0) {        /* if confirmable */
-                        *memo->msg.data.pdu_buf = 0;    /* clear resend PDU buffer */
-                    }
-                    memo->state = GCOAP_MEMO_UNUSED;
+                    _free_req_memo(memo);
                     break;
                 case COAP_TYPE_CON:
                     DEBUG("gcoap: separate CON response not handled yet\n");
@@ -244,6 +361,9 @@ static void _on_resp_timeout(void *arg) {
     /* reduce retries remaining, double timeout and resend */
     else {
         memo->send_limit--;
+#ifdef MODULE_GCOAP_COCOA
+        uint32_t timeout  = _cocoa_backoff(memo) * US_PER_MS;
+#else
 #ifdef CONFIG_GCOAP_NO_RETRANS_BACKOFF
         unsigned i        = 0;
 #else
@@ -253,8 +373,12 @@ static void _on_resp_timeout(void *arg) {
 #if CONFIG_COAP_RANDOM_FACTOR_1000 > 1000
         uint32_t end = ((uint32_t)TIMEOUT_RANGE_END << i) * US_PER_SEC;
         timeout = random_uint32_range(timeout, end);
+#endif
 #endif
         event_timeout_set(&memo->resp_evt_tmout, timeout);
+        mutex_lock(&_coap_state.lock);
+        _coap_state.stats.retransmissions++;
+        mutex_unlock(&_coap_state.lock);
 
         ssize_t bytes = sock_udp_send(&_sock, memo->msg.data.pdu_buf,
                                       memo->msg.data.pdu_len, &memo->remote_ep);
@@ -277,9 +401,14 @@ static size_t _handle_req(coap_pkt_t *pdu, uint8_t *buf, size_t len,
 {
     const coap_resource_t *resource     = NULL;
     gcoap_listener_t *listener          = NULL;
-    sock_udp_ep_t *observer             = NULL;
-    gcoap_observe_memo_t *memo          = NULL;
-    gcoap_observe_memo_t *resource_memo = NULL;
+
+#ifdef MODULE_GCOAP_FORWARD_PROXY
+    uint8_t *proxy_opt;
+    if ((coap_opt_get_opaque(pdu, COAP_OPT_PROXY_URI, &proxy_opt) >= 0)
+            || (coap_opt_get_opaque(pdu, COAP_OPT_PROXY_SCHEME, &proxy_opt) >= 0)) {
+        return gcoap_forward_proxy_request_process(pdu, buf, len, remote);
+    }
+#endif
 
     switch (_find_resource(pdu, &resource, &listener)) {
         case GCOAP_RESOURCE_WRONG_METHOD:
@@ -287,80 +416,17 @@ static size_t _handle_req(coap_pkt_t *pdu, uint8_t *buf, size_t len,
         case GCOAP_RESOURCE_NO_PATH:
             return gcoap_response(pdu, buf, len, COAP_CODE_PATH_NOT_FOUND);
         case GCOAP_RESOURCE_FOUND:
-            /* find observe registration for resource */
-            _find_obs_memo_resource(&resource_memo, resource);
             break;
     }
 
     if (coap_get_observe(pdu) == COAP_OBS_REGISTER) {
-        /* lookup remote+token */
-        int empty_slot = _find_obs_memo(&memo, remote, pdu);
-        /* validate re-registration request */
-        if (resource_memo != NULL) {
-            if (memo != NULL) {
-                if (memo != resource_memo) {
-                    /* reject token already used for a different resource */
-                    memo = NULL;
-                    coap_clear_observe(pdu);
-                    DEBUG("gcoap: can't change resource for token\n");
-                }
-                /* otherwise OK to re-register resource with the same token */
-            }
-            else if (sock_udp_ep_equal(remote, resource_memo->observer)) {
-                /* accept new token for resource */
-                memo = resource_memo;
-            }
-        }
-        /* initialize new registration request */
-        if ((memo == NULL) && coap_has_observe(pdu)) {
-            /* verify resource not already registered (for another endpoint) */
-            if ((empty_slot >= 0) && (resource_memo == NULL)) {
-                int obs_slot = _find_observer(&observer, remote);
-                /* cache new observer */
-                if (observer == NULL) {
-                    if (obs_slot >= 0) {
-                        observer = &_coap_state.observers[obs_slot];
-                        memcpy(observer, remote, sizeof(sock_udp_ep_t));
-                    } else {
-                        DEBUG("gcoap: can't register observer\n");
-                    }
-                }
-                if (observer != NULL) {
-                    memo = &_coap_state.observe_memos[empty_slot];
-                    memo->observer = observer;
-                }
-            }
-            if (memo == NULL) {
-                coap_clear_observe(pdu);
-                DEBUG("gcoap: can't register observe memo\n");
-            }
-        }
-        /* finish registration */
-        if (memo != NULL) {
-            /* resource may be assigned here if it is not already registered */
-            memo->resource = resource;
-            memo->token_len = coap_get_token_len(pdu);
-            if (memo->token_len) {
-                memcpy(&memo->token[0], pdu->token, memo->token_len);
-            }
-            DEBUG("gcoap: Registered observer for: %s\n", memo->resource->path);
+        if (!_obs_register(pdu, resource, remote)) {
+            /* response without Observe option tells client it failed */
+            coap_clear_observe(pdu);
         }
 
     } else if (coap_get_observe(pdu) == COAP_OBS_DEREGISTER) {
-        _find_obs_memo(&memo, remote, pdu);
-        /* clear memo, and clear observer if no other memos */
-        if (memo != NULL) {
-            DEBUG("gcoap: Deregistering observer for: %s\n", memo->resource->path);
-            memo->observer = NULL;
-            memo           = NULL;
-            _find_obs_memo(&memo, remote, NULL);
-            if (memo == NULL) {
-                _find_observer(&observer, remote);
-                if (observer != NULL) {
-                    observer->family = AF_UNSPEC;
-                }
-            }
-        }
+        _obs_deregister(pdu, remote);
         coap_clear_observe(pdu);
 
     } else if (coap_has_observe(pdu)) {
@@ -371,6 +437,13 @@ static size_t _handle_req(coap_pkt_t *pdu, uint8_t *buf, size_t len,
 
     ssize_t pdu_len = resource->handler(pdu, buf, len, resource->context);
     if (pdu_len < 0) {
+#ifdef MODULE_GCOAP_SENDFILE
+        /* the error response must not carry the file as payload */
+        if (_resp_file.fd >= 0) {
+            vfs_close(_resp_file.fd);
+            _resp_file.fd = -1;
+        }
+#endif
         pdu_len = gcoap_response(pdu, buf, len,
                                  COAP_CODE_INTERNAL_SERVER_ERROR);
     }
@@ -396,11 +469,6 @@ static int _find_resource(coap_pkt_t *pdu, const coap_resource_t **resource_ptr,
     /* Find path for CoAP msg among listener resources and execute callback. */
     gcoap_listener_t *listener = _coap_state.listeners;
 
-    uint8_t uri[CONFIG_NANOCOAP_URI_MAX];
-    if (coap_get_uri_path(pdu, uri) <= 0) {
-        return GCOAP_RESOURCE_NO_PATH;
-    }
-
     while (listener) {
         const coap_resource_t *resource = listener->resources;
         for (size_t i = 0; i < listener->resources_len; i++) {
@@ -408,7 +476,7 @@ static int _find_resource(coap_pkt_t *pdu, const coap_resource_t **resource_ptr,
                 resource++;
             }
 
-            int res = coap_match_path(resource, uri);
+            int res = coap_match_path_pkt(resource, pdu);
             if (res > 0) {
                 continue;
             }
@@ -433,9 +501,41 @@ static int _find_resource(coap_pkt_t *pdu, const coap_resource_t **resource_ptr,
     return ret;
 }
 
+/* Hash of a token, for the indexes of open requests and of observe
+ * registrations */
+static uint32_t _token_hash(const uint8_t *token, unsigned len)
+{
+    /* FNV-1a */
+    uint32_t hash = 2166136261U;
+
+    for (unsigned i = 0; i < len; i++) {
+        hash = (hash ^ token[i]) * 16777619U;
+    }
+    return hash;
+}
+
+/* Header of the request PDU stored in a memo */
+static coap_hdr_t *_memo_hdr(const gcoap_request_memo_t *memo)
+{
+    if (memo->send_limit == GCOAP_SEND_LIMIT_NON) {
+        return (coap_hdr_t *)&memo->msg.hdr_buf[0];
+    }
+    return (coap_hdr_t *)memo->msg.data.pdu_buf;
+}
+
+/* Returns the token length of a memo, and the token in @p token */
+static unsigned _memo_token(const gcoap_request_memo_t *memo,
+                            const uint8_t **token)
+{
+    coap_hdr_t *hdr = _memo_hdr(memo);
+
+    *token = coap_hdr_data_ptr(hdr);
+    return hdr->ver_t_tkl & 0xf;
+}
+
 /*
- * Finds the memo for an outstanding request within the _coap_state.open_reqs
- * array. Matches on remote endpoint and token.
+ * Finds the memo for an outstanding request within the index of open
+ * requests. Matches on remote endpoint and token.
  *
  * memo_ptr[out] -- Registered request memo, or NULL if not found
  * src_pdu[in] -- PDU for token to match
@@ -444,64 +544,404 @@ static int _find_resource(coap_pkt_t *pdu, const coap_resource_t **resource_ptr,
 static void _find_req_memo(gcoap_request_memo_t **memo_ptr, coap_pkt_t *src_pdu,
                            const sock_udp_ep_t *remote)
 {
-    *memo_ptr = NULL;
-    /* no need to initialize struct; we only care about buffer contents below */
-    coap_pkt_t memo_pdu_data;
-    coap_pkt_t *memo_pdu = &memo_pdu_data;
-    unsigned cmplen      = coap_get_token_len(src_pdu);
+    unsigned cmplen = coap_get_token_len(src_pdu);
+    gcoap_request_memo_t *memo;
+
+    mutex_lock(&_coap_state.lock);
+    memo = _coap_state.req_index[_token_hash(src_pdu->token, cmplen)
+                                         % CONFIG_GCOAP_REQ_INDEX_SIZE];
+    for (; memo; memo = memo->next) {
+        const uint8_t *token;
+        if ((_memo_token(memo, &token) == cmplen)
+                && (memcmp(src_pdu->token, token, cmplen) == 0)
+                && sock_udp_ep_equal(&memo->remote_ep, remote)) {
+            break;
+        }
+    }
+    mutex_unlock(&_coap_state.lock);
+    *memo_ptr = memo;
+}
 
-    for (int i = 0; i < CONFIG_GCOAP_REQ_WAITING_MAX; i++) {
-        if (_coap_state.open_reqs[i].state == GCOAP_MEMO_UNUSED) {
-            continue;
+/* Adds a memo to the index of open requests; lock must be held */
+static void _add_req_memo(gcoap_request_memo_t *memo)
+{
+    const uint8_t *token;
+    unsigned len = _memo_token(memo, &token);
+    gcoap_request_memo_t **bucket =
+        &_coap_state.req_index[_token_hash(token, len) % CONFIG_GCOAP_REQ_INDEX_SIZE];
+
+    memo->next = *bucket;
+    *bucket = memo;
+    _coap_state.open_reqs_num++;
+}
+
+/* Removes a memo from the index of open requests; lock must be held */
+static void _remove_req_memo(gcoap_request_memo_t *memo)
+{
+    const uint8_t *token;
+    unsigned len = _memo_token(memo, &token);
+    gcoap_request_memo_t **prev =
+        &_coap_state.req_index[_token_hash(token, len) % CONFIG_GCOAP_REQ_INDEX_SIZE];
+
+    while (*prev) {
+        if (*prev == memo) {
+            *prev = memo->next;
+            _coap_state.open_reqs_num--;
+            break;
+        }
+        prev = &(*prev)->next;
+    }
+}
+
+/* Stops the response timeout of a memo, also if it already expired and the
+ * event is waiting in the queue */
+static void _clear_req_timeout(gcoap_request_memo_t *memo)
+{
+    if (memo->resp_evt_tmout.queue) {
+        event_timeout_clear(&memo->resp_evt_tmout);
+        event_cancel(&_queue, &memo->resp_tmout_cb.super);
+    }
+}
+
+#ifdef MODULE_GCOAP_COCOA
+static uint32_t _now_ms(void)
+{
+    return xtimer_now_usec() / US_PER_MS;
+}
+
+/* Finds the congestion control state of an endpoint; lock must be held */
+static gcoap_peer_t *_find_peer(const sock_udp_ep_t *remote)
+{
+    for (unsigned i = 0; i < CONFIG_GCOAP_PEERS_MAX; i++) {
+        gcoap_peer_t *peer = &_coap_state.peers[i];
+        if ((peer->remote.family != AF_UNSPEC)
+                && sock_udp_ep_equal(&peer->remote, remote)) {
+            return peer;
         }
+    }
+    return NULL;
+}
 
-        gcoap_request_memo_t *memo = &_coap_state.open_reqs[i];
-        if (memo->send_limit == GCOAP_SEND_LIMIT_NON) {
-            memo_pdu->hdr = (coap_hdr_t *) &memo->msg.hdr_buf[0];
+/*
+ * Finds the congestion control state of an endpoint, and ages its RTO if it
+ * was not updated for a while. If the endpoint is unknown, an unused entry or
+ * the least recently updated entry without open requests is taken over.
+ * Returns NULL if all entries are busy; lock must be held.
+ */
+static gcoap_peer_t *_get_peer(const sock_udp_ep_t *remote)
+{
+    uint32_t now = _now_ms();
+    gcoap_peer_t *peer = _find_peer(remote);
+
+    if (peer) {
+        uint32_t idle = now - peer->updated;
+        if ((peer->rto < MS_PER_SEC) && (idle > 16 * peer->rto)) {
+            peer->rto *= 2;
+            peer->updated = now;
         }
-        else {
-            memo_pdu->hdr = (coap_hdr_t *) memo->msg.data.pdu_buf;
+        else if ((peer->rto > 3 * MS_PER_SEC) && (idle > 4 * peer->rto)) {
+            peer->rto = (COCOA_RTO_INIT + peer->rto) / 2;
+            peer->updated = now;
         }
+        return peer;
+    }
 
-        if (coap_get_token_len(memo_pdu) == cmplen) {
-            memo_pdu->token = coap_hdr_data_ptr(memo_pdu->hdr);
-            if ((memcmp(src_pdu->token, memo_pdu->token, cmplen) == 0)
-                    && sock_udp_ep_equal(&memo->remote_ep, remote)) {
-                *memo_ptr = memo;
-                break;
-            }
+    for (unsigned i = 0; i < CONFIG_GCOAP_PEERS_MAX; i++) {
+        gcoap_peer_t *entry = &_coap_state.peers[i];
+        if (entry->remote.family == AF_UNSPEC) {
+            peer = entry;
+            break;
+        }
+        if (!entry->open && !entry->queue
+                && (!peer || ((now - entry->updated) > (now - peer->updated)))) {
+            peer = entry;
+        }
+    }
+    if (peer) {
+        memset(peer, 0, sizeof(*peer));
+        memcpy(&peer->remote, remote, sizeof(peer->remote));
+        peer->rto = COCOA_RTO_INIT;
+        peer->updated = now;
+    }
+    return peer;
+}
+
+/* Updates an RTT estimator and returns its RTO estimate with factor k */
+static uint32_t _cocoa_estimate(cocoa_est_t *est, uint32_t rtt, unsigned k)
+{
+    /* srtt of zero marks an estimator without samples */
+    if (rtt == 0) {
+        rtt = 1;
+    }
+    if (est->srtt == 0) {
+        est->srtt = rtt;
+        est->rttvar = rtt / 2;
+    }
+    else {
+        uint32_t delta = (est->srtt > rtt) ? est->srtt - rtt : rtt - est->srtt;
+        est->rttvar = (3 * est->rttvar + delta) / 4;
+        est->srtt = (7 * est->srtt + rtt) / 8;
+    }
+    return est->srtt + k * est->rttvar;
+}
+
+/*
+ * Updates the RTO of the endpoint of an answered confirmable request. The
+ * strong estimator takes RTTs of requests answered without retransmission,
+ * the weak one RTTs of requests retransmitted at most twice.
+ */
+static void _cocoa_update(gcoap_request_memo_t *memo)
+{
+    gcoap_peer_t *peer = memo->peer;
+
+    if (!peer) {
+        return;
+    }
+
+    mutex_lock(&_coap_state.lock);
+    uint32_t now = _now_ms();
+    uint32_t rtt = now - memo->sent;
+    unsigned retransmissions = CONFIG_COAP_MAX_RETRANSMIT - memo->send_limit;
+    if (retransmissions == 0) {
+        peer->rto = (peer->rto + _cocoa_estimate(&peer->strong, rtt, 4)) / 2;
+        peer->updated = now;
+    }
+    else if (retransmissions <= 2) {
+        peer->rto = (3 * peer->rto + _cocoa_estimate(&peer->weak, rtt, 1)) / 4;
+        peer->updated = now;
+    }
+    if (peer->rto > COCOA_RTO_MAX) {
+        peer->rto = COCOA_RTO_MAX;
+    }
+    mutex_unlock(&_coap_state.lock);
+}
+
+/* Backs off the timeout [ms] of a request for its next retransmission */
+static uint32_t _cocoa_backoff(gcoap_request_memo_t *memo)
+{
+#ifndef CONFIG_GCOAP_NO_RETRANS_BACKOFF
+    /* variable backoff factor: long RTOs back off slower, short ones faster */
+    uint32_t rto = memo->peer ? memo->peer->rto : COCOA_RTO_INIT;
+    uint32_t timeout;
+    if (rto < MS_PER_SEC) {
+        timeout = memo->timeout * 3;
+    }
+    else if (rto > 3 * MS_PER_SEC) {
+        timeout = memo->timeout + memo->timeout / 2;
+    }
+    else {
+        timeout = memo->timeout * 2;
+    }
+    memo->timeout = (timeout < COCOA_RTO_MAX) ? timeout : COCOA_RTO_MAX;
+#endif
+    return memo->timeout;
+}
+
+/*
+ * Starts the first transmission of a confirmable request: counts it as open
+ * for its endpoint and sets its initial timeout [ms]. Lock must be held.
+ */
+static void _cocoa_start(gcoap_request_memo_t *memo)
+{
+    uint32_t rto = memo->peer ? memo->peer->rto : COCOA_RTO_INIT;
+
+    if (memo->peer) {
+        memo->peer->open++;
+    }
+    memo->sent = _now_ms();
+    memo->timeout = rto;
+#if CONFIG_COAP_RANDOM_FACTOR_1000 > 1000
+    memo->timeout = random_uint32_range(rto,
+                        rto * CONFIG_COAP_RANDOM_FACTOR_1000 / 1000);
+#endif
+    _coap_state.stats.requests++;
+}
+
+/* Appends a request to the NSTART queue of its endpoint; lock must be held */
+static void _cocoa_enqueue(gcoap_request_memo_t *memo)
+{
+    gcoap_peer_t *peer = memo->peer;
+
+    memo->queue_next = NULL;
+    if (peer->queue_last) {
+        peer->queue_last->queue_next = memo;
+    }
+    else {
+        peer->queue = memo;
+    }
+    peer->queue_last = memo;
+    _coap_state.stats.queued++;
+}
+
+/*
+ * Closes a confirmable request for its endpoint. Returns the next request
+ * waiting for the endpoint, which is started already; lock must be held.
+ */
+static gcoap_request_memo_t *_cocoa_close(gcoap_request_memo_t *memo)
+{
+    gcoap_peer_t *peer = memo->peer;
+
+    if (!peer) {
+        return NULL;
+    }
+    peer->open--;
+
+    gcoap_request_memo_t *next = peer->queue;
+    if (next) {
+        peer->queue = next->queue_next;
+        if (!peer->queue) {
+            peer->queue_last = NULL;
         }
+        _cocoa_start(next);
     }
+    return next;
 }
 
-/* Calls handler callback on receipt of a timeout message. */
+/* Sends a request released from the NSTART queue */
+static void _cocoa_send(gcoap_request_memo_t *memo)
+{
+    event_timeout_set(&memo->resp_evt_tmout, memo->timeout * US_PER_MS);
+    /* on failure the request is retransmitted after the timeout */
+    if (sock_udp_send(&_sock, memo->msg.data.pdu_buf, memo->msg.data.pdu_len,
+                      &memo->remote_ep) <= 0) {
+        DEBUG("gcoap: sock send of queued request failed\n");
+    }
+}
+#endif /* MODULE_GCOAP_COCOA */
+
+/* Releases a memo and its resend buffer once the request is done */
+static void _free_req_memo(gcoap_request_memo_t *memo)
+{
+    _clear_req_timeout(memo);
+    mutex_lock(&_coap_state.lock);
+    _remove_req_memo(memo);
+#ifdef MODULE_GCOAP_COCOA
+    gcoap_request_memo_t *next = _cocoa_close(memo);
+#endif
+    if (memo->send_limit != GCOAP_SEND_LIMIT_NON) {
+        memarray_free(&_coap_state.resend_pool, memo->msg.data.pdu_buf);
+    }
+    memarray_free(&_coap_state.req_pool, memo);
+    mutex_unlock(&_coap_state.lock);
+#ifdef MODULE_GCOAP_COCOA
+    if (next) {
+        _cocoa_send(next);
+    }
+#endif
+}
+
+/*
+ * Calls handler callback on receipt of a timeout message.
+ *
+ * The memo is still waiting: _free_req_memo() cancels a pending timeout
+ * event before the memo goes back to the pool.
+ */
 static void _expire_request(gcoap_request_memo_t *memo)
 {
     DEBUG("coap: received timeout message\n");
-    if (memo->state == GCOAP_MEMO_WAIT) {
-        memo->state = GCOAP_MEMO_TIMEOUT;
-        /* Pass response to handler */
-        if (memo->resp_handler) {
-            coap_pkt_t req;
-            if (memo->send_limit == GCOAP_SEND_LIMIT_NON) {
-                req.hdr = (coap_hdr_t *)&memo->msg.hdr_buf[0];   /* for reference */
+    memo->state = GCOAP_MEMO_TIMEOUT;
+    mutex_lock(&_coap_state.lock);
+    _coap_state.stats.timeouts++;
+    mutex_unlock(&_coap_state.lock);
+    /* Pass response to handler */
+    if (memo->resp_handler) {
+        coap_pkt_t req;
+        req.hdr = _memo_hdr(memo);      /* for reference */
+        memo->resp_handler(memo, &req, NULL);
+    }
+    _free_req_memo(memo);
+}
+
+#ifdef MODULE_NANOCOAP_BLOCK
+/* Position in the resource list, for block-wise transfer of it */
+typedef struct {
+    gcoap_listener_t *listener;         /* Listener of the next link */
+    uint16_t link_pos;                  /* Resource of the next link */
+    uint16_t pos;                       /* Bytes of the link already read */
+    uint16_t flags;                     /* Link encoder flags */
+} _reslist_state_t;
+
+static void _reslist_init(void *state, void *arg)
+{
+    (void)arg;
+    _reslist_state_t *reslist = state;
+
+    /* skip the first listener, gcoap itself (we skip /.well-known/core) */
+    reslist->listener = _coap_state.listeners->next;
+    reslist->link_pos = 0;
+    reslist->pos = 0;
+    reslist->flags = COAP_LINK_FLAG_INIT_RESLIST;
+}
+
+static ssize_t _reslist_read(void *state, uint8_t *buf, size_t len, void *arg)
+{
+    (void)arg;
+    _reslist_state_t *reslist = state;
+    char link[CONFIG_NANOCOAP_URI_MAX + 3];
+    size_t total = 0;
+
+    while (reslist->listener && (total < len)) {
+        gcoap_listener_t *listener = reslist->listener;
+        if (reslist->link_pos >= listener->resources_len) {
+            reslist->listener = listener->next;
+            reslist->link_pos = 0;
+            continue;
+        }
+
+        const coap_resource_t *resource = &listener->resources[reslist->link_pos];
+        coap_link_encoder_ctx_t ctx = {
+            .content_format = COAP_FORMAT_LINK,
+            .link_pos = reslist->link_pos,
+            .flags = reslist->flags,
+        };
+        ssize_t link_len = listener->link_encoder(resource, NULL, 0, &ctx);
+        if ((link_len < 0) || ((size_t)link_len > sizeof(link))) {
+            /* could not be split across blocks, left out of every block */
+            DEBUG("gcoap: link to %s too long\n", resource->path);
+            link_len = 0;
+        }
+        /* a link that fits as a whole is written in place */
+        else if ((reslist->pos == 0) && ((size_t)link_len <= len - total)) {
+            link_len = listener->link_encoder(resource, (char *)buf + total,
+                                              len - total, &ctx);
+            if (link_len < 0) {
+                return -ENOBUFS;
             }
-            else {
-                req.hdr = (coap_hdr_t *)memo->msg.data.pdu_buf;
+            total += link_len;
+        }
+        else {
+            link_len = listener->link_encoder(resource, link, sizeof(link),
+                                              &ctx);
+            if (link_len < 0) {
+                return -ENOBUFS;
+            }
+            size_t part = link_len - reslist->pos;
+            if (part > len - total) {
+                part = len - total;
+            }
+            memcpy(buf + total, link + reslist->pos, part);
+            total += part;
+            reslist->pos += part;
+            if (reslist->pos < link_len) {
+                break;
             }
-            memo->resp_handler(memo, &req, NULL);
         }
-        if (memo->send_limit != GCOAP_SEND_LIMIT_NON) {
-            *memo->msg.data.pdu_buf = 0;    /* clear resend buffer */
+        reslist->link_pos++;
+        reslist->pos = 0;
+        /* the first link written has no separator */
+        if (link_len > 0) {
+            reslist->flags &= ~COAP_LINK_FLAG_INIT_RESLIST;
         }
-        memo->state = GCOAP_MEMO_UNUSED;
-    }
-    else {
-        /* Response already handled; timeout must have fired while response */
-        /* was in queue. */
     }
+    return total;
 }
 
+static const coap_block_producer_t _reslist_producer = {
+    .init = _reslist_init,
+    .read = _reslist_read,
+};
+#endif /* MODULE_NANOCOAP_BLOCK */
+
 /*
  * Handler for /.well-known/core. Lists registered handlers, except for
  * /.well-known/core itself.
@@ -511,6 +951,15 @@ static ssize_t _well_known_core_handler(coap_pkt_t* pdu, uint8_t *buf, size_t le
 {
     (void)ctx;
 
+#ifdef MODULE_NANOCOAP_BLOCK
+    /* listeners are only added, so their number versions the list */
+    uint32_t etag = 0;
+    for (gcoap_listener_t *l = _coap_state.listeners; l; l = l->next) {
+        etag++;
+    }
+    return coap_block2_reply(pdu, buf, len, COAP_FORMAT_LINK,
+                             &_reslist_producer, etag, NULL);
+#else
     gcoap_resp_init(pdu, buf, len, COAP_CODE_CONTENT);
     coap_opt_add_format(pdu, COAP_FORMAT_LINK);
     ssize_t plen = coap_opt_finish(pdu, COAP_OPT_FINISH_PAYLOAD);
@@ -518,98 +967,321 @@ static ssize_t _well_known_core_handler(coap_pkt_t* pdu, uint8_t *buf, size_t le
     plen += gcoap_get_resource_list(pdu->payload, (size_t)pdu->payload_len,
                                     COAP_FORMAT_LINK);
     return plen;
+#endif
 }
 
 /*
- * Find registered observer for a remote address and port.
+ * Finds the endpoint of an observer. If add is true and the endpoint is not
+ * known, it is taken into an unused entry. Lock must be held.
  *
- * observer[out] -- Registered observer, or NULL if not found
- * remote[in] -- Endpoint to match
- *
- * return Index of empty slot, suitable for registering new observer; or -1
- *        if no empty slots. Undefined if observer found.
+ * return Endpoint in the list of observers, or NULL
  */
-static int _find_observer(sock_udp_ep_t **observer, sock_udp_ep_t *remote)
+static sock_udp_ep_t *_get_observer(const sock_udp_ep_t *remote, bool add)
 {
-    int empty_slot = -1;
-    *observer      = NULL;
+    sock_udp_ep_t *empty = NULL;
+
     for (unsigned i = 0; i < CONFIG_GCOAP_OBS_CLIENTS_MAX; i++) {
+        sock_udp_ep_t *observer = &_coap_state.observers[i];
+        if (observer->family == AF_UNSPEC) {
+            empty = empty ? empty : observer;
+        }
+        else if (sock_udp_ep_equal(observer, remote)) {
+            return observer;
+        }
+    }
+    if (add && empty) {
+        memcpy(empty, remote, sizeof(sock_udp_ep_t));
+        return empty;
+    }
+    return NULL;
+}
+
+/*
+ * Finds the entry of an observed resource. If add is true and the resource is
+ * not observed yet, it is taken into an unused entry. Lock must be held.
+ */
+static gcoap_obs_resource_t *_get_obs_resource(const coap_resource_t *resource,
+                                               bool add)
+{
+    gcoap_obs_resource_t *empty = NULL;
 
-        if (_coap_state.observers[i].family == AF_UNSPEC) {
-            empty_slot = i;
+    for (unsigned i = 0; i < CONFIG_GCOAP_OBS_RESOURCES_MAX; i++) {
+        gcoap_obs_resource_t *entry = &_coap_state.obs_resources[i];
+        if (entry->resource == resource) {
+            return entry;
         }
-        else if (sock_udp_ep_equal(&_coap_state.observers[i], remote)) {
-            *observer = &_coap_state.observers[i];
-            break;
+        if (!entry->resource && !empty) {
+            empty = entry;
         }
     }
-    return empty_slot;
+    if (add && empty) {
+        empty->resource = resource;
+        empty->memos = NULL;
+#if CONFIG_GCOAP_OBS_MIN_INTERVAL
+        /* the first notification is not delayed */
+        empty->last = xtimer_now_usec() - CONFIG_GCOAP_OBS_MIN_INTERVAL * US_PER_MS;
+        empty->pending_len = 0;
+        event_callback_init(&empty->flush_cb, _on_obs_flush, empty);
+        event_timeout_init(&empty->flush_tmout, &_queue, &empty->flush_cb.super);
+#endif
+        return empty;
+    }
+    return NULL;
+}
+
+/* Bucket in the index of observe registrations for a token */
+static gcoap_observe_memo_t **_obs_bucket(const uint8_t *token, unsigned len)
+{
+    return &_coap_state.obs_index[_token_hash(token, len)
+                                  % CONFIG_GCOAP_OBS_INDEX_SIZE];
 }
 
 /*
- * Find registered observe memo for a remote address and token.
- *
- * memo[out] -- Registered observe memo, or NULL if not found
- * remote[in] -- Endpoint for address to match
- * pdu[in] -- PDU for token to match, or NULL to match only on remote address
- *
- * return Index of empty slot, suitable for registering new memo; or -1 if no
- *        empty slots. Undefined if memo found.
+ * Finds the observe registration of an observer for the token in a PDU,
+ * within the index of registrations. Lock must be held.
  */
-static int _find_obs_memo(gcoap_observe_memo_t **memo, sock_udp_ep_t *remote,
-                                                       coap_pkt_t *pdu)
+static gcoap_observe_memo_t *_find_obs_memo(coap_pkt_t *pdu,
+                                            const sock_udp_ep_t *observer)
 {
-    int empty_slot = -1;
-    *memo          = NULL;
+    unsigned token_len = coap_get_token_len(pdu);
+    gcoap_observe_memo_t *memo = *_obs_bucket(pdu->token, token_len);
+
+    for (; memo; memo = memo->index_next) {
+        if ((memo->observer == observer) && (memo->token_len == token_len)
+                && (!token_len || (memcmp(memo->token, pdu->token, token_len) == 0))) {
+            break;
+        }
+    }
+    return memo;
+}
 
-    sock_udp_ep_t *remote_observer = NULL;
-    _find_observer(&remote_observer, remote);
+/* Removes a memo from the index of registrations; lock must be held */
+static void _remove_obs_index(gcoap_observe_memo_t *memo)
+{
+    gcoap_observe_memo_t **prev = _obs_bucket(memo->token, memo->token_len);
 
-    for (unsigned i = 0; i < CONFIG_GCOAP_OBS_REGISTRATIONS_MAX; i++) {
-        if (_coap_state.observe_memos[i].observer == NULL) {
-            empty_slot = i;
-            continue;
+    while (*prev) {
+        if (*prev == memo) {
+            *prev = memo->index_next;
+            break;
         }
+        prev = &(*prev)->index_next;
+    }
+}
 
-        if (_coap_state.observe_memos[i].observer == remote_observer) {
-            if (pdu == NULL) {
-                *memo = &_coap_state.observe_memos[i];
-                break;
+/* Sets the token of a memo from a PDU and adds the memo to the index of
+ * registrations; lock must be held */
+static void _add_obs_index(gcoap_observe_memo_t *memo, coap_pkt_t *pdu)
+{
+    memo->token_len = coap_get_token_len(pdu);
+    if (memo->token_len) {
+        memcpy(memo->token, pdu->token, memo->token_len);
+    }
+
+    gcoap_observe_memo_t **bucket = _obs_bucket(memo->token, memo->token_len);
+    memo->index_next = *bucket;
+    *bucket = memo;
+}
+
+/*
+ * Registers the observer of a request for a resource, or updates the token of
+ * its registration for the resource.
+ *
+ * return true if the observer is registered
+ */
+static bool _obs_register(coap_pkt_t *pdu, const coap_resource_t *resource,
+                          const sock_udp_ep_t *remote)
+{
+    gcoap_observe_memo_t *memo = NULL;
+    bool registered = false;
+
+    mutex_lock(&_coap_state.lock);
+    sock_udp_ep_t *observer = _get_observer(remote, false);
+    gcoap_obs_resource_t *entry = _get_obs_resource(resource, false);
+
+    if (observer) {
+        memo = _find_obs_memo(pdu, observer);
+        if (memo) {
+            /* re-registration with the same token, only for the same
+             * resource */
+            registered = (memo->resource == resource);
+            if (!registered) {
+                DEBUG("gcoap: can't change resource for token\n");
             }
+            goto out;
+        }
+        for (memo = entry ? entry->memos : NULL; memo; memo = memo->next) {
+            if (memo->observer == observer) {
+                /* accept new token for resource */
+                _remove_obs_index(memo);
+                _add_obs_index(memo, pdu);
+                registered = true;
+                goto out;
+            }
+        }
+    }
 
-            if (_coap_state.observe_memos[i].token_len == coap_get_token_len(pdu)) {
-                unsigned cmplen = _coap_state.observe_memos[i].token_len;
-                if (cmplen &&
-                        memcmp(&_coap_state.observe_memos[i].token[0], &pdu->token[0],
-                                                                       cmplen) == 0) {
-                    *memo = &_coap_state.observe_memos[i];
-                    break;
-                }
+    /* new registration */
+    if (!entry) {
+        entry = _get_obs_resource(resource, true);
+    }
+    if (!observer) {
+        observer = _get_observer(remote, true);
+    }
+    memo = memarray_alloc(&_coap_state.obs_pool);
+    if (!entry || !observer || !memo) {
+        DEBUG("gcoap: can't register observe memo\n");
+        if (memo) {
+            memarray_free(&_coap_state.obs_pool, memo);
+        }
+        /* release entries taken for this registration only */
+        if (entry && !entry->memos) {
+            entry->resource = NULL;
+        }
+        if (observer && !_coap_state.observer_refs[observer - _coap_state.observers]) {
+            observer->family = AF_UNSPEC;
+        }
+        goto out;
+    }
+    memo->observer = observer;
+    memo->resource = resource;
+    memo->next = entry->memos;
+    entry->memos = memo;
+    _coap_state.observer_refs[observer - _coap_state.observers]++;
+    _add_obs_index(memo, pdu);
+    registered = true;
+    DEBUG("gcoap: Registered observer for: %s\n", resource->path);
+
+out:
+    mutex_unlock(&_coap_state.lock);
+    return registered;
+}
+
+/*
+ * Cancels the registration of the observer of a request for the token in the
+ * request. Clears the observer if it has no other registrations, and the
+ * resource if it has no other observers.
+ */
+static void _obs_deregister(coap_pkt_t *pdu, const sock_udp_ep_t *remote)
+{
+    mutex_lock(&_coap_state.lock);
+    sock_udp_ep_t *observer = _get_observer(remote, false);
+    gcoap_observe_memo_t *memo = observer ? _find_obs_memo(pdu, observer) : NULL;
+
+    if (memo) {
+        DEBUG("gcoap: Deregistering observer for: %s\n", memo->resource->path);
+        gcoap_obs_resource_t *entry = _get_obs_resource(memo->resource, false);
+        gcoap_observe_memo_t **prev = &entry->memos;
+        while (*prev != memo) {
+            prev = &(*prev)->next;
+        }
+        *prev = memo->next;
+        if (!entry->memos) {
+#if CONFIG_GCOAP_OBS_MIN_INTERVAL
+            if (entry->pending_len) {
+                event_timeout_clear(&entry->flush_tmout);
+                event_cancel(&_queue, &entry->flush_cb.super);
             }
+#endif
+            entry->resource = NULL;
+        }
+        if (--_coap_state.observer_refs[observer - _coap_state.observers] == 0) {
+            observer->family = AF_UNSPEC;
         }
+        _remove_obs_index(memo);
+        memarray_free(&_coap_state.obs_pool, memo);
     }
-    return empty_slot;
+    mutex_unlock(&_coap_state.lock);
 }
 
 /*
- * Find registered observe memo for a resource.
+ * Copies a notification and the observers of its resource, to send it with
+ * _obs_fanout(). Lock and obs_send_lock must be held.
  *
- * memo[out] -- Registered observe memo, or NULL if not found
- * resource[in] -- Resource to match
+ * return number of observers copied
  */
-static void _find_obs_memo_resource(gcoap_observe_memo_t **memo,
-                                   const coap_resource_t *resource)
-{
-    *memo = NULL;
-    for (int i = 0; i < CONFIG_GCOAP_OBS_REGISTRATIONS_MAX; i++) {
-        if (_coap_state.observe_memos[i].observer != NULL
-                && _coap_state.observe_memos[i].resource == resource) {
-            *memo = &_coap_state.observe_memos[i];
-            break;
+static unsigned _obs_snapshot(gcoap_obs_resource_t *entry, const uint8_t *buf,
+                              size_t len)
+{
+    unsigned count = 0;
+
+    memcpy(_coap_state.obs_buf, buf, len);
+    for (gcoap_observe_memo_t *memo = entry->memos; memo; memo = memo->next) {
+        gcoap_obs_target_t *target = &_coap_state.obs_targets[count++];
+        target->remote = *memo->observer;
+        memcpy(target->token, memo->token, memo->token_len);
+        target->token_len = memo->token_len;
+    }
+    return count;
+}
+
+/*
+ * Sends the notification copied by _obs_snapshot() to the observers copied
+ * with it. The header with the token of each observer is written in front of
+ * the options and payload, which stay in place. Only obs_send_lock must be
+ * held, so that registrations are not blocked while sending.
+ *
+ * return number of observers the notification was sent to
+ */
+static unsigned _obs_fanout(unsigned count, size_t len)
+{
+    uint8_t *buf = _coap_state.obs_buf;
+    coap_hdr_t *hdr = (coap_hdr_t *)buf;
+    unsigned type = (hdr->ver_t_tkl & 0x30) >> 4;
+    unsigned code = hdr->code;
+    uint8_t *body = coap_hdr_data_ptr(hdr) + (hdr->ver_t_tkl & 0xf);
+    unsigned sent = 0;
+
+    if (!count || ((size_t)(body - buf) > len)) {
+        return 0;
+    }
+    for (unsigned i = 0; i < count; i++) {
+        gcoap_obs_target_t *target = &_coap_state.obs_targets[i];
+        size_t hdr_len = sizeof(coap_hdr_t) + target->token_len;
+        if (hdr_len > (size_t)(body - buf)) {
+            DEBUG("gcoap: token too long for notification\n");
+            continue;
+        }
+        uint8_t *start = body - hdr_len;
+        coap_build_hdr((coap_hdr_t *)start, type, target->token,
+                       target->token_len, code, gcoap_next_msg_id());
+        ssize_t bytes = sock_udp_send(&_sock, start, len - (start - buf),
+                                      &target->remote);
+        if (bytes > 0) {
+            sent++;
+        }
+        else {
+            DEBUG("gcoap: send notification failed: %d\n", (int)bytes);
         }
     }
+    mutex_lock(&_coap_state.lock);
+    _coap_state.stats.notifications += sent;
+    mutex_unlock(&_coap_state.lock);
+    return sent;
 }
 
+#if CONFIG_GCOAP_OBS_MIN_INTERVAL
+/* Sends the notification delayed for a resource, at the end of the interval */
+static void _on_obs_flush(void *arg)
+{
+    gcoap_obs_resource_t *entry = arg;
+    unsigned count = 0;
+    size_t len;
+
+    mutex_lock(&_coap_state.obs_send_lock);
+    mutex_lock(&_coap_state.lock);
+    len = entry->pending_len;
+    if (len) {
+        entry->last = xtimer_now_usec();
+        count = _obs_snapshot(entry, entry->pending, len);
+        entry->pending_len = 0;
+    }
+    mutex_unlock(&_coap_state.lock);
+    _obs_fanout(count, len);
+    mutex_unlock(&_coap_state.obs_send_lock);
+}
+#endif
+
 /*
  * gcoap interface functions
  */
@@ -623,11 +1295,23 @@ kernel_pid_t gcoap_init(void)
                             THREAD_CREATE_STACKTEST, _event_loop, NULL, "coap");
 
     mutex_init(&_coap_state.lock);
+    mutex_init(&_coap_state.obs_send_lock);
     /* Blank lists so we know if an entry is available. */
     memset(&_coap_state.open_reqs[0], 0, sizeof(_coap_state.open_reqs));
+    memset(&_coap_state.req_index[0], 0, sizeof(_coap_state.req_index));
+    _coap_state.open_reqs_num = 0;
+    memarray_init(&_coap_state.req_pool, _coap_state.open_reqs,
+                  sizeof(_coap_state.open_reqs[0]), CONFIG_GCOAP_REQ_WAITING_MAX);
+    memarray_init(&_coap_state.resend_pool, _coap_state.resend_bufs,
+                  sizeof(_coap_state.resend_bufs[0]), CONFIG_GCOAP_RESEND_BUFS_MAX);
     memset(&_coap_state.observers[0], 0, sizeof(_coap_state.observers));
+    memset(&_coap_state.observer_refs[0], 0, sizeof(_coap_state.observer_refs));
     memset(&_coap_state.observe_memos[0], 0, sizeof(_coap_state.observe_memos));
-    memset(&_coap_state.resend_bufs[0], 0, sizeof(_coap_state.resend_bufs));
+    memset(&_coap_state.obs_index[0], 0, sizeof(_coap_state.obs_index));
+    memset(&_coap_state.obs_resources[0], 0, sizeof(_coap_state.obs_resources));
+    memarray_init(&_coap_state.obs_pool, _coap_state.observe_memos,
+                  sizeof(_coap_state.observe_memos[0]),
+                  CONFIG_GCOAP_OBS_REGISTRATIONS_MAX);
     /* randomize initial value */
     atomic_init(&_coap_state.next_message_id, (unsigned)random_uint32());
 
@@ -657,7 +1341,7 @@ int gcoap_req_init(coap_pkt_t *pdu, uint8_t *buf, size_t len,
     pdu->hdr = (coap_hdr_t *)buf;
 
     /* generate token */
-    uint16_t msgid = (uint16_t)atomic_fetch_add(&_coap_state.next_message_id, 1);
+    uint16_t msgid = gcoap_next_msg_id();
     ssize_t res;
     if (code) {
 #if CONFIG_GCOAP_TOKENLEN
@@ -699,44 +1383,52 @@ size_t gcoap_req_send(const uint8_t *buf, size_t len,
 
     /* Only allocate memory if necessary (i.e. if user is interested in the
      * response or request is confirmable) */
+    bool queued = false;
+
     if ((resp_handler != NULL) || (msg_type == COAP_TYPE_CON)) {
         mutex_lock(&_coap_state.lock);
-        /* Find empty slot in list of open requests. */
-        for (int i = 0; i < CONFIG_GCOAP_REQ_WAITING_MAX; i++) {
-            if (_coap_state.open_reqs[i].state == GCOAP_MEMO_UNUSED) {
-                memo = &_coap_state.open_reqs[i];
-                memo->state = GCOAP_MEMO_WAIT;
-                break;
-            }
-        }
+        memo = memarray_alloc(&_coap_state.req_pool);
         if (!memo) {
             mutex_unlock(&_coap_state.lock);
             DEBUG("gcoap: dropping request; no space for response tracking\n");
             return 0;
         }
-
+        memo->state = GCOAP_MEMO_WAIT;
         memo->resp_handler = resp_handler;
         memo->context = context;
         memcpy(&memo->remote_ep, remote, sizeof(sock_udp_ep_t));
+#ifdef MODULE_GCOAP_COCOA
+        memo->peer = NULL;
+#endif
 
         switch (msg_type) {
         case COAP_TYPE_CON:
-            /* copy buf to resend_bufs record */
+            /* copy buf to a resend buffer */
             memo->msg.data.pdu_buf = NULL;
-            for (int i = 0; i < CONFIG_GCOAP_RESEND_BUFS_MAX; i++) {
-                if (!_coap_state.resend_bufs[i][0]) {
-                    memo->msg.data.pdu_buf = &_coap_state.resend_bufs[i][0];
-                    memcpy(memo->msg.data.pdu_buf, buf,
-                           CONFIG_GCOAP_PDU_BUF_SIZE);
-                    memo->msg.data.pdu_len = len;
-                    break;
-                }
+            if (len <= CONFIG_GCOAP_RESEND_BUF_SIZE) {
+                memo->msg.data.pdu_buf = memarray_alloc(&_coap_state.resend_pool);
             }
             if (memo->msg.data.pdu_buf) {
+                memcpy(memo->msg.data.pdu_buf, buf, len);
+                memo->msg.data.pdu_len = len;
                 memo->send_limit  = CONFIG_COAP_MAX_RETRANSMIT;
+#ifdef MODULE_GCOAP_COCOA
+                memo->peer = _get_peer(remote);
+                if (memo->peer && (memo->peer->open >= CONFIG_GCOAP_NSTART)) {
+                    /* sent once an open request to the endpoint is done */
+                    _cocoa_enqueue(memo);
+                    queued = true;
+                }
+                else {
+                    _cocoa_start(memo);
+                    timeout = memo->timeout * US_PER_MS;
+                }
+#else
                 timeout           = (uint32_t)CONFIG_COAP_ACK_TIMEOUT * US_PER_SEC;
 #if CONFIG_COAP_RANDOM_FACTOR_1000 > 1000
                 timeout = random_uint32_range(timeout, TIMEOUT_RANGE_END * US_PER_SEC);
+#endif
+                _coap_state.stats.requests++;
 #endif
             }
             else {
@@ -749,41 +1441,49 @@ size_t gcoap_req_send(const uint8_t *buf, size_t len,
             memo->send_limit = GCOAP_SEND_LIMIT_NON;
             memcpy(&memo->msg.hdr_buf[0], buf, GCOAP_HEADER_MAXLEN);
             timeout = CONFIG_GCOAP_NON_TIMEOUT;
+            _coap_state.stats.requests++;
             break;
         default:
             memo->state = GCOAP_MEMO_UNUSED;
             DEBUG("gcoap: illegal msg type %u\n", msg_type);
             break;
         }
-        mutex_unlock(&_coap_state.lock);
         if (memo->state == GCOAP_MEMO_UNUSED) {
+            memarray_free(&_coap_state.req_pool, memo);
+            mutex_unlock(&_coap_state.lock);
             return 0;
         }
-    }
 
-    /* set response timeout; may be zero for non-confirmable */
-    if (memo != NULL) {
-        if (timeout > 0) {
+        /* set response timeout; may be zero for non-confirmable, and is
+         * set once a queued request is sent */
+        if ((timeout > 0) || queued) {
             event_callback_init(&memo->resp_tmout_cb, _on_resp_timeout, memo);
             event_timeout_init(&memo->resp_evt_tmout, &_queue,
                                &memo->resp_tmout_cb.super);
-            event_timeout_set(&memo->resp_evt_tmout, timeout);
+            if (timeout > 0) {
+                event_timeout_set(&memo->resp_evt_tmout, timeout);
+            }
         }
         else {
             memset(&memo->resp_evt_tmout, 0, sizeof(event_timeout_t));
         }
+        _add_req_memo(memo);
+        mutex_unlock(&_coap_state.lock);
+    }
+    else {
+        mutex_lock(&_coap_state.lock);
+        _coap_state.stats.requests++;
+        mutex_unlock(&_coap_state.lock);
+    }
+
+    if (queued) {
+        return len;
     }
 
     ssize_t res = sock_udp_send(&_sock, buf, len, remote);
     if (res <= 0) {
         if (memo != NULL) {
-            if (msg_type == COAP_TYPE_CON) {
-                *memo->msg.data.pdu_buf = 0;    /* clear resend buffer */
-            }
-            if (timeout > 0) {
-                event_timeout_clear(&memo->resp_evt_tmout);
-            }
-            memo->state = GCOAP_MEMO_UNUSED;
+            _free_req_memo(memo);
         }
         DEBUG("gcoap: sock send failed: %d\n", (int)res);
     }
@@ -800,6 +1500,7 @@ int gcoap_resp_init(coap_pkt_t *pdu, uint8_t *buf, size_t len, unsigned code)
     unsigned header_len  = coap_get_total_hdr_len(pdu);
 
     pdu->options_len = 0;
+    pdu->options_map = 0;
     pdu->payload     = buf + header_len;
     pdu->payload_len = len - header_len;
 
@@ -813,21 +1514,40 @@ int gcoap_resp_init(coap_pkt_t *pdu, uint8_t *buf, size_t len, unsigned code)
     return 0;
 }
 
+#ifdef MODULE_GCOAP_SENDFILE
+void gcoap_resp_sendfile(int fd, size_t len)
+{
+    assert((fd >= 0) && (len > 0) && (_resp_file.fd < 0));
+
+    _resp_file.fd = fd;
+    _resp_file.len = len;
+}
+#endif
+
 int gcoap_obs_init(coap_pkt_t *pdu, uint8_t *buf, size_t len,
                                                   const coap_resource_t *resource)
 {
     gcoap_observe_memo_t *memo = NULL;
 
-    _find_obs_memo_resource(&memo, resource);
+    /* the header takes the longest token of the observers */
+    mutex_lock(&_coap_state.lock);
+    gcoap_obs_resource_t *entry = _get_obs_resource(resource, false);
+    for (gcoap_observe_memo_t *m = entry ? entry->memos : NULL; m; m = m->next) {
+        if (!memo || (m->token_len > memo->token_len)) {
+            memo = m;
+        }
+    }
     if (memo == NULL) {
+        mutex_unlock(&_coap_state.lock);
         /* Unique return value to specify there is not an observer */
         return GCOAP_OBS_INIT_UNUSED;
     }
 
     pdu->hdr       = (coap_hdr_t *)buf;
-    uint16_t msgid = (uint16_t)atomic_fetch_add(&_coap_state.next_message_id, 1);
+    uint16_t msgid = gcoap_next_msg_id();
     ssize_t hdrlen = coap_build_hdr(pdu->hdr, COAP_TYPE_NON, &memo->token[0],
                                     memo->token_len, COAP_CODE_CONTENT, msgid);
+    mutex_unlock(&_coap_state.lock);
 
     if (hdrlen > 0) {
         coap_pkt_init(pdu, buf, len, hdrlen);
@@ -847,28 +1567,93 @@ int gcoap_obs_init(coap_pkt_t *pdu, uint8_t *buf, size_t len,
 size_t gcoap_obs_send(const uint8_t *buf, size_t len,
                       const coap_resource_t *resource)
 {
-    gcoap_observe_memo_t *memo = NULL;
-
-    _find_obs_memo_resource(&memo, resource);
+    unsigned count, sent;
 
-    if (memo) {
-        ssize_t bytes = sock_udp_send(&_sock, buf, len, memo->observer);
-        return (size_t)((bytes > 0) ? bytes : 0);
+    if (len > sizeof(_coap_state.obs_buf)) {
+        DEBUG("gcoap: notification too long\n");
+        return 0;
     }
-    else {
+    mutex_lock(&_coap_state.obs_send_lock);
+    mutex_lock(&_coap_state.lock);
+    gcoap_obs_resource_t *entry = _get_obs_resource(resource, false);
+    if (!entry) {
+        mutex_unlock(&_coap_state.lock);
+        mutex_unlock(&_coap_state.obs_send_lock);
         return 0;
     }
+
+#if CONFIG_GCOAP_OBS_MIN_INTERVAL
+    uint32_t now = xtimer_now_usec();
+    uint32_t elapsed = now - entry->last;
+    if (entry->pending_len
+            || (elapsed < CONFIG_GCOAP_OBS_MIN_INTERVAL * US_PER_MS)) {
+        if (entry->pending_len) {
+            /* the newer notification replaces the one not sent yet */
+            _coap_state.stats.conflated++;
+        }
+        else {
+            event_timeout_set(&entry->flush_tmout,
+                              CONFIG_GCOAP_OBS_MIN_INTERVAL * US_PER_MS - elapsed);
+        }
+        memcpy(entry->pending, buf, len);
+        entry->pending_len = len;
+        mutex_unlock(&_coap_state.lock);
+        mutex_unlock(&_coap_state.obs_send_lock);
+        return len;
+    }
+    entry->last = now;
+#endif
+    count = _obs_snapshot(entry, buf, len);
+    mutex_unlock(&_coap_state.lock);
+    sent = _obs_fanout(count, len);
+    mutex_unlock(&_coap_state.obs_send_lock);
+
+    return sent ? len : 0;
+}
+
+uint16_t gcoap_next_msg_id(void)
+{
+    return (uint16_t)atomic_fetch_add(&_coap_state.next_message_id, 1);
 }
 
+#ifdef MODULE_GCOAP_FORWARD_PROXY
+ssize_t gcoap_forward_proxy_dispatch(const uint8_t *buf, size_t len,
+                                     const sock_udp_ep_t *remote)
+{
+    return sock_udp_send(&_sock, buf, len, remote);
+}
+#endif
+
 uint8_t gcoap_op_state(void)
 {
-    uint8_t count = 0;
-    for (int i = 0; i < CONFIG_GCOAP_REQ_WAITING_MAX; i++) {
-        if (_coap_state.open_reqs[i].state != GCOAP_MEMO_UNUSED) {
-            count++;
-        }
+    unsigned count = _coap_state.open_reqs_num;
+
+    return (count > UINT8_MAX) ? UINT8_MAX : count;
+}
+
+void gcoap_get_stats(gcoap_stats_t *stats)
+{
+    mutex_lock(&_coap_state.lock);
+    memcpy(stats, &_coap_state.stats, sizeof(*stats));
+    mutex_unlock(&_coap_state.lock);
+}
+
+uint32_t gcoap_get_rto(const sock_udp_ep_t *remote)
+{
+#ifdef MODULE_GCOAP_COCOA
+    uint32_t rto = COCOA_RTO_INIT;
+
+    mutex_lock(&_coap_state.lock);
+    gcoap_peer_t *peer = _find_peer(remote);
+    if (peer) {
+        rto = peer->rto;
     }
-    return count;
+    mutex_unlock(&_coap_state.lock);
+    return rto;
+#else
+    (void)remote;
+    return CONFIG_COAP_ACK_TIMEOUT * MS_PER_SEC;
+#endif
 }
 
 int gcoap_get_resource_list(void *buf, size_t maxlen, uint8_t cf)
@@ -0,0 +1,368 @@
+/*
+ * Copyright (C) 2020 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     net_nanocoap_block
+ * @{
+ *
+ * @file
+ * @brief       Block-wise server engine for nanocoap
+ *
+ * @}
+ */
+
+#include <errno.h>
+#include <string.h>
+
+#include "byteorder.h"
+#include "mutex.h"
+#include "net/nanocoap_block.h"
+
+#ifdef MODULE_VFS
+#include "vfs.h"
+#endif
+
+#define ENABLE_DEBUG (0)
+#include "debug.h"
+
+/* Longest ETag, Content-Format and Block2 options of a response */
+#define BLOCK2_OPTS_MAX     (5 + 3 + 4)
+/* Smallest block size */
+#define BLOCK_SIZE_MIN      (16U)
+
+/* Producer state kept between two Block2 requests */
+typedef struct {
+    const coap_block_producer_t *producer;  /* NULL if entry unused */
+    void *arg;                          /* Argument of the producer */
+    uint32_t etag;                      /* Version of the representation */
+    size_t offset;                      /* Offset of next, in the
+                                           representation */
+    uint32_t used;                      /* Time of last use, for eviction */
+    uint8_t next;                       /* Byte read ahead of offset */
+    uintptr_t state[(CONFIG_NANOCOAP_BLOCK_STATE_SIZE + sizeof(uintptr_t) - 1)
+                    / sizeof(uintptr_t)];
+} _cache_entry_t;
+
+static _cache_entry_t _cache[CONFIG_NANOCOAP_BLOCK_CACHE_SIZE];
+static uint32_t _cache_time;
+static mutex_t _cache_lock = MUTEX_INIT;
+
+/* Takes the producer state for the block at offset from the cache */
+static bool _cache_take(const coap_block_producer_t *producer, void *arg,
+                        uint32_t etag, size_t offset, void *state,
+                        uint8_t *next)
+{
+    bool found = false;
+
+    mutex_lock(&_cache_lock);
+    for (unsigned i = 0; i < CONFIG_NANOCOAP_BLOCK_CACHE_SIZE; i++) {
+        _cache_entry_t *entry = &_cache[i];
+        if ((entry->producer == producer) && (entry->arg == arg)
+                && (entry->etag == etag) && (entry->offset == offset)) {
+            memcpy(state, entry->state, sizeof(entry->state));
+            *next = entry->next;
+            entry->producer = NULL;
+            found = true;
+            break;
+        }
+    }
+    mutex_unlock(&_cache_lock);
+    return found;
+}
+
+/* Keeps the producer state for the next block, replacing the least recently
+ * used entry if the cache is full */
+static void _cache_put(const coap_block_producer_t *producer, void *arg,
+                       uint32_t etag, size_t offset, const void *state,
+                       uint8_t next)
+{
+    _cache_entry_t *entry = NULL;
+
+    mutex_lock(&_cache_lock);
+    for (unsigned i = 0; i < CONFIG_NANOCOAP_BLOCK_CACHE_SIZE; i++) {
+        _cache_entry_t *e = &_cache[i];
+        if (!e->producer) {
+            entry = e;
+            break;
+        }
+        if (!entry || ((_cache_time - e->used) > (_cache_time - entry->used))) {
+            entry = e;
+        }
+    }
+    if (entry) {
+        entry->producer = producer;
+        entry->arg = arg;
+        entry->etag = etag;
+        entry->offset = offset;
+        entry->used = _cache_time++;
+        entry->next = next;
+        memcpy(entry->state, state, sizeof(entry->state));
+    }
+    mutex_unlock(&_cache_lock);
+}
+
+void coap_block_cache_clear(void)
+{
+    mutex_lock(&_cache_lock);
+    memset(_cache, 0, sizeof(_cache));
+    mutex_unlock(&_cache_lock);
+}
+
+/* Reads up to len bytes, less only at the end of the representation */
+static ssize_t _read(const coap_block_producer_t *producer, void *state,
+                     uint8_t *buf, size_t len, void *arg)
+{
+    size_t total = 0;
+
+    while (total < len) {
+        ssize_t res = producer->read(state, buf + total, len - total, arg);
+        if (res < 0) {
+            return res;
+        }
+        if (res == 0) {
+            break;
+        }
+        total += res;
+    }
+    return total;
+}
+
+/* Gets the requested block, returns true for a BERT request */
+static bool _block2_init(coap_pkt_t *pkt, coap_block_slicer_t *slicer)
+{
+    uint32_t blknum;
+    unsigned szx;
+
+    if ((coap_get_blockopt(pkt, COAP_OPT_BLOCK2, &blknum, &szx) >= 0)
+            && (szx == COAP_BLOCKWISE_SZX_BERT)) {
+        coap_block_slicer_init(slicer, blknum, COAP_BLOCKWISE_BERT_UNIT);
+        return true;
+    }
+    coap_block2_init(pkt, slicer);
+    return false;
+}
+
+static size_t _put_block2_opts(uint8_t *buf, uint32_t etag, unsigned ct,
+                               coap_block_slicer_t *slicer, bool bert,
+                               bool more)
+{
+    uint8_t *pos = buf;
+
+    etag = htonl(etag);
+    pos += coap_put_option(pos, 0, COAP_OPT_ETAG, (uint8_t *)&etag,
+                           sizeof(etag));
+    pos += coap_put_option_ct(pos, COAP_OPT_ETAG, ct);
+    if (bert) {
+        uint32_t blkopt = (slicer->start / COAP_BLOCKWISE_BERT_UNIT)
+                          << COAP_BLOCKWISE_NUM_OFF;
+        blkopt |= COAP_BLOCKWISE_SZX_BERT;
+        blkopt |= more ? (1 << COAP_BLOCKWISE_MORE_OFF) : 0;
+        pos += coap_opt_put_uint(pos, COAP_OPT_CONTENT_FORMAT,
+                                 COAP_OPT_BLOCK2, blkopt);
+    }
+    else {
+        pos += coap_opt_put_block2(pos, COAP_OPT_CONTENT_FORMAT, slicer, more);
+    }
+    return pos - buf;
+}
+
+ssize_t coap_block2_reply(coap_pkt_t *pkt, uint8_t *buf, size_t len,
+                          unsigned ct, const coap_block_producer_t *producer,
+                          uint32_t etag, void *arg)
+{
+    uintptr_t state[ARRAY_SIZE(_cache[0].state)];
+    uint8_t opts[BLOCK2_OPTS_MAX];
+    coap_block_slicer_t slicer;
+    size_t hdr_len = coap_get_total_hdr_len(pkt);
+    uint8_t next;
+
+    bool bert = _block2_init(pkt, &slicer);
+    if (len < hdr_len + BLOCK2_OPTS_MAX + 1 + BLOCK_SIZE_MIN) {
+        return -ENOSPC;
+    }
+    /* a BERT block takes as many units as fit; a smaller block keeps its
+     * offset, which is a multiple of any smaller block size */
+    size_t space = len - (hdr_len + BLOCK2_OPTS_MAX + 1);
+    size_t blksize = slicer.end - slicer.start;
+    if (bert && (space >= COAP_BLOCKWISE_BERT_UNIT)) {
+        blksize = space - (space % COAP_BLOCKWISE_BERT_UNIT);
+    }
+    else {
+        bert = false;
+        while (blksize > space) {
+            blksize /= 2;
+        }
+    }
+    slicer.end = slicer.start + blksize;
+
+    /* the payload is produced first, as the Block2 option depends on it */
+    size_t opts_len = _put_block2_opts(opts, etag, ct, &slicer, bert, true);
+    uint8_t *payload = buf + hdr_len;
+    uint8_t *data = payload + opts_len + 1;
+    size_t data_len = 0;
+    ssize_t res;
+
+    if (_cache_take(producer, arg, etag, slicer.start, state, &next)) {
+        data[data_len++] = next;
+    }
+    else {
+        size_t offset = 0;
+        producer->init(state, arg);
+        /* skip to the requested block, using its space as scratch */
+        while (offset < slicer.start) {
+            size_t chunk = slicer.start - offset;
+            if (chunk > blksize) {
+                chunk = blksize;
+            }
+            res = _read(producer, state, data, chunk, arg);
+            if (res < 0) {
+                goto error;
+            }
+            offset += res;
+            if ((size_t)res < chunk) {
+                DEBUG("nanocoap_block: block beyond end\n");
+                return coap_build_reply(pkt, COAP_CODE_BAD_OPTION, buf, len, 0);
+            }
+        }
+    }
+
+    res = _read(producer, state, data + data_len, blksize - data_len, arg);
+    if (res < 0) {
+        goto error;
+    }
+    data_len += res;
+    if ((data_len == 0) && (slicer.start > 0)) {
+        return coap_build_reply(pkt, COAP_CODE_BAD_OPTION, buf, len, 0);
+    }
+
+    /* read a byte ahead to know whether more blocks follow */
+    bool more = false;
+    if (data_len == blksize) {
+        res = _read(producer, state, &next, 1, arg);
+        if (res < 0) {
+            goto error;
+        }
+        if (res == 1) {
+            more = true;
+            _cache_put(producer, arg, etag, slicer.end, state, next);
+        }
+    }
+    if (!more) {
+        size_t last_len = _put_block2_opts(opts, etag, ct, &slicer, bert,
+                                           false);
+        if (last_len != opts_len) {
+            memmove(payload + last_len + 1, data, data_len);
+            opts_len = last_len;
+        }
+    }
+
+    memcpy(payload, opts, opts_len);
+    size_t payload_len = opts_len;
+    if (data_len) {
+        payload[payload_len++] = 0xff;
+        payload_len += data_len;
+    }
+    return coap_build_reply(pkt, COAP_CODE_CONTENT, buf, len, payload_len);
+
+error:
+    DEBUG("nanocoap_block: producer failed: %d\n", (int)res);
+    return coap_build_reply(pkt, COAP_CODE_INTERNAL_SERVER_ERROR, buf, len, 0);
+}
+
+ssize_t coap_block1_reply(coap_pkt_t *pkt, uint8_t *buf, size_t len,
+                          unsigned code, coap_block_sink_t sink, void *arg)
+{
+    coap_block1_t block1;
+    int res = 0;
+
+    bool blockwise = coap_get_block1(pkt, &block1);
+    if (pkt->payload_len) {
+        res = sink(arg, block1.offset, pkt->payload, pkt->payload_len);
+    }
+
+    /* the request payload is consumed; the response may overwrite it */
+    uint8_t *payload = buf + coap_get_total_hdr_len(pkt);
+    size_t payload_len = 0;
+    if (res < 0) {
+        DEBUG("nanocoap_block: sink failed: %d\n", res);
+        code = (res == -ENOSPC) ? COAP_CODE_REQUEST_ENTITY_TOO_LARGE
+                                : COAP_CODE_INTERNAL_SERVER_ERROR;
+    }
+    else if (blockwise) {
+        if (block1.more) {
+            code = COAP_CODE_CONTINUE;
+        }
+        if (len < coap_get_total_hdr_len(pkt) + 4) {
+            return -ENOSPC;
+        }
+        payload_len = coap_opt_put_block1_control(payload, 0, &block1);
+    }
+    return coap_build_reply(pkt, code, buf, len, payload_len);
+}
+
+#ifdef MODULE_VFS
+int coap_block_sink_vfs(void *arg, size_t offset, const uint8_t *data,
+                        size_t len)
+{
+    int fd = *(int *)arg;
+
+    if (vfs_lseek(fd, offset, SEEK_SET) < 0) {
+        return -EIO;
+    }
+    while (len) {
+        ssize_t res = vfs_write(fd, data, len);
+        if (res < 0) {
+            return res;
+        }
+        if (res == 0) {
+            return -ENOSPC;
+        }
+        data += res;
+        len -= res;
+    }
+    return 0;
+}
+#endif
+
+#ifdef MODULE_MTD
+int coap_block_sink_mtd(void *arg, size_t offset, const uint8_t *data,
+                        size_t len)
+{
+    coap_block_mtd_t *area = arg;
+    mtd_dev_t *mtd = area->mtd;
+    uint32_t sector_size = mtd->pages_per_sector * mtd->page_size;
+
+    if (offset + len > area->size) {
+        return -ENOSPC;
+    }
+    /* erase the sectors the block reaches first */
+    while (area->erased < offset + len) {
+        int res = mtd_erase(mtd, area->addr + area->erased, sector_size);
+        if (res < 0) {
+            return res;
+        }
+        area->erased += sector_size;
+    }
+    /* a write must not cross a page */
+    while (len) {
+        uint32_t addr = area->addr + offset;
+        size_t chunk = mtd->page_size - (addr % mtd->page_size);
+        if (chunk > len) {
+            chunk = len;
+        }
+        int res = mtd_write(mtd, data, addr, chunk);
+        if (res < 0) {
+            return res;
+        }
+        data += chunk;
+        offset += chunk;
+        len -= chunk;
+    }
+    return 0;
+}
+#endif
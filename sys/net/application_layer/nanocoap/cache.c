@@ -0,0 +1,261 @@
+/*
+ * Copyright (C) 2020 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     net_nanocoap_cache
+ * @{
+ *
+ * @file
+ * @brief       Response cache for nanocoap
+ *
+ * @}
+ */
+
+#include <errno.h>
+#include <string.h>
+
+#include "assert.h"
+#include "hashes/sha256.h"
+#include "net/nanocoap_cache.h"
+#include "xtimer.h"
+
+#define ENABLE_DEBUG (0)
+#include "debug.h"
+
+/* Longest Max-Age option: header, extended delta and a 4 byte value */
+#define MAX_AGE_OPT_MAX     (6)
+
+static nanocoap_cache_entry_t _cache[CONFIG_NANOCOAP_CACHE_ENTRIES];
+static nanocoap_cache_stats_t _stats;
+static uint32_t _cache_time;
+
+static uint32_t _now(void)
+{
+    return xtimer_now_usec64() / US_PER_SEC;
+}
+
+/* Parses a stored response; it was parsed when it was stored */
+static void _parse(const nanocoap_cache_entry_t *ce, coap_pkt_t *pkt)
+{
+    int res = coap_parse(pkt, (uint8_t *)ce->response, ce->response_len);
+    assert(res == 0);
+    (void)res;
+}
+
+/* Options marked NoCacheKey (RFC 7252, section 5.4.6) and the ETag, which
+ * validates a stored response, are not part of the cache key */
+static bool _is_cache_key(unsigned opt_num)
+{
+    return ((opt_num & 0x1e) != 0x1c) && (opt_num != COAP_OPT_ETAG);
+}
+
+void nanocoap_cache_key_generate(coap_pkt_t *req, uint8_t *key)
+{
+    uint8_t digest[SHA256_DIGEST_LENGTH];
+    sha256_context_t ctx;
+    coap_optpos_t opt;
+    uint8_t *value;
+    uint8_t code = coap_get_code_raw(req);
+
+    sha256_init(&ctx);
+    sha256_update(&ctx, &code, sizeof(code));
+
+    ssize_t len = coap_opt_get_next(req, &opt, &value, true);
+    while (len >= 0) {
+        if (_is_cache_key(opt.opt_num)) {
+            /* number and length separate the values of adjacent options */
+            uint8_t head[4] = {
+                opt.opt_num >> 8, opt.opt_num & 0xff, len >> 8, len & 0xff
+            };
+            sha256_update(&ctx, head, sizeof(head));
+            sha256_update(&ctx, value, len);
+        }
+        len = coap_opt_get_next(req, &opt, &value, false);
+    }
+
+    sha256_final(&ctx, digest);
+    memcpy(key, digest, CONFIG_NANOCOAP_CACHE_KEY_LENGTH);
+}
+
+static nanocoap_cache_entry_t *_find(const uint8_t *key)
+{
+    for (unsigned i = 0; i < CONFIG_NANOCOAP_CACHE_ENTRIES; i++) {
+        nanocoap_cache_entry_t *ce = &_cache[i];
+        if (ce->response_len
+                && !memcmp(ce->key, key, CONFIG_NANOCOAP_CACHE_KEY_LENGTH)) {
+            return ce;
+        }
+    }
+    return NULL;
+}
+
+nanocoap_cache_entry_t *nanocoap_cache_lookup(const uint8_t *key)
+{
+    nanocoap_cache_entry_t *ce = _find(key);
+
+    if (!ce) {
+        _stats.misses++;
+        return NULL;
+    }
+    if (nanocoap_cache_entry_is_stale(ce)) {
+        _stats.stale++;
+    }
+    else {
+        _stats.hits++;
+    }
+    ce->used = _cache_time++;
+    return ce;
+}
+
+/* Gets the end of freshness of a response from its Max-Age */
+static uint32_t _expires(coap_pkt_t *resp)
+{
+    uint32_t max_age = COAP_DEFAULT_MAX_AGE;
+    uint32_t now = _now();
+
+    coap_opt_get_uint(resp, COAP_OPT_MAX_AGE, &max_age);
+    if (max_age > UINT32_MAX - now) {
+        max_age = UINT32_MAX - now;
+    }
+    return now + max_age;
+}
+
+nanocoap_cache_entry_t *nanocoap_cache_add(const uint8_t *key,
+                                           coap_pkt_t *resp,
+                                           size_t resp_len)
+{
+    uint32_t max_age = COAP_DEFAULT_MAX_AGE;
+
+    coap_opt_get_uint(resp, COAP_OPT_MAX_AGE, &max_age);
+    if ((coap_get_code_raw(resp) != COAP_CODE_CONTENT) || (max_age == 0)) {
+        return NULL;
+    }
+    if (resp_len > CONFIG_NANOCOAP_CACHE_RESPONSE_SIZE) {
+        DEBUG("nanocoap_cache: response too long: %u\n", (unsigned)resp_len);
+        return NULL;
+    }
+
+    /* replace the response stored for the key, an unused entry, or the least
+     * recently used one */
+    nanocoap_cache_entry_t *ce = _find(key);
+    if (!ce) {
+        for (unsigned i = 0; i < CONFIG_NANOCOAP_CACHE_ENTRIES; i++) {
+            nanocoap_cache_entry_t *e = &_cache[i];
+            if (!e->response_len) {
+                ce = e;
+                break;
+            }
+            if (!ce || ((_cache_time - e->used) > (_cache_time - ce->used))) {
+                ce = e;
+            }
+        }
+        if (ce->response_len) {
+            _stats.evictions++;
+        }
+    }
+
+    memcpy(ce->key, key, CONFIG_NANOCOAP_CACHE_KEY_LENGTH);
+    memcpy(ce->response, resp->hdr, resp_len);
+    ce->response_len = resp_len;
+    ce->expires = _expires(resp);
+    ce->used = _cache_time++;
+    _stats.stored++;
+    return ce;
+}
+
+void nanocoap_cache_validate(nanocoap_cache_entry_t *ce, coap_pkt_t *resp)
+{
+    assert(coap_get_code_raw(resp) == COAP_CODE_VALID);
+
+    ce->expires = _expires(resp);
+    _stats.validations++;
+}
+
+bool nanocoap_cache_entry_is_stale(const nanocoap_cache_entry_t *ce)
+{
+    return (int32_t)(ce->expires - _now()) <= 0;
+}
+
+ssize_t nanocoap_cache_entry_etag(const nanocoap_cache_entry_t *ce,
+                                  uint8_t **etag)
+{
+    coap_pkt_t pkt;
+
+    _parse(ce, &pkt);
+    return coap_opt_get_opaque(&pkt, COAP_OPT_ETAG, etag);
+}
+
+ssize_t nanocoap_cache_entry_build(const nanocoap_cache_entry_t *ce,
+                                   uint8_t *buf, size_t len, unsigned type,
+                                   const uint8_t *token, size_t token_len,
+                                   uint16_t id)
+{
+    coap_pkt_t pkt;
+
+    _parse(ce, &pkt);
+    /* the stored Max-Age option is replaced, which takes at most
+     * MAX_AGE_OPT_MAX bytes */
+    size_t body_len = ce->response_len - coap_get_total_hdr_len(&pkt);
+    if (len < sizeof(coap_hdr_t) + token_len + body_len + MAX_AGE_OPT_MAX) {
+        return -ENOSPC;
+    }
+
+    uint32_t max_age = 0;
+    if (!nanocoap_cache_entry_is_stale(ce)) {
+        max_age = ce->expires - _now();
+    }
+
+    uint8_t *pos = buf;
+    pos += coap_build_hdr((coap_hdr_t *)buf, type, (uint8_t *)token,
+                          token_len, coap_get_code_raw(&pkt), id);
+
+    /* copy the options, replacing Max-Age */
+    uint16_t lastonum = 0;
+    bool max_age_put = false;
+    coap_optpos_t opt;
+    uint8_t *value;
+    ssize_t optlen = coap_opt_get_next(&pkt, &opt, &value, true);
+    while (optlen >= 0) {
+        if (!max_age_put && (opt.opt_num >= COAP_OPT_MAX_AGE)) {
+            pos += coap_opt_put_uint(pos, lastonum, COAP_OPT_MAX_AGE, max_age);
+            lastonum = COAP_OPT_MAX_AGE;
+            max_age_put = true;
+        }
+        if (opt.opt_num != COAP_OPT_MAX_AGE) {
+            pos += coap_put_option(pos, lastonum, opt.opt_num, value, optlen);
+            lastonum = opt.opt_num;
+        }
+        optlen = coap_opt_get_next(&pkt, &opt, &value, false);
+    }
+    if (!max_age_put) {
+        pos += coap_opt_put_uint(pos, lastonum, COAP_OPT_MAX_AGE, max_age);
+    }
+
+    if (pkt.payload_len) {
+        *pos++ = 0xff;
+        memcpy(pos, pkt.payload, pkt.payload_len);
+        pos += pkt.payload_len;
+    }
+    return pos - buf;
+}
+
+void nanocoap_cache_del(nanocoap_cache_entry_t *ce)
+{
+    ce->response_len = 0;
+}
+
+void nanocoap_cache_clear(void)
+{
+    memset(_cache, 0, sizeof(_cache));
+    memset(&_stats, 0, sizeof(_stats));
+}
+
+void nanocoap_cache_get_stats(nanocoap_cache_stats_t *stats)
+{
+    *stats = _stats;
+}
@@ -96,6 +96,8 @@ int coap_parse(coap_pkt_t *pkt, uint8_t *buf, size_t len)
     unsigned option_count = 0;
     unsigned option_nr = 0;
 
+    pkt->options_map = 0;
+
     /* parse options */
     while (pkt_pos < pkt_end) {
         uint8_t *option_start = pkt_pos;
@@ -128,6 +130,9 @@ int coap_parse(coap_pkt_t *pkt, uint8_t *buf, size_t len)
 
                 optpos->opt_num = option_nr;
                 optpos->offset = (uintptr_t)option_start - (uintptr_t)hdr;
+                if (option_nr < 32) {
+                    pkt->options_map |= 1UL << option_nr;
+                }
                 DEBUG("optpos option_nr=%u %u\n", (unsigned)option_nr, (unsigned)optpos->offset);
                 optpos++;
                 option_count++;
@@ -178,14 +183,27 @@ int coap_match_path(const coap_resource_t *resource, uint8_t *uri)
 
 uint8_t *coap_find_option(const coap_pkt_t *pkt, unsigned opt_num)
 {
-    const coap_optpos_t *optpos = pkt->options;
-    unsigned opt_count = pkt->options_len;
+    /* the options array is sorted; the bit map gives the position of option
+     * numbers below 32, others follow them */
+    unsigned pos = bitarithm_bits_set_u32(pkt->options_map);
+
+    if (opt_num < 32) {
+        uint32_t bit = 1UL << opt_num;
+        if (!(pkt->options_map & bit)) {
+            return NULL;
+        }
+        pos = bitarithm_bits_set_u32(pkt->options_map & (bit - 1));
+        return (uint8_t *)pkt->hdr + pkt->options[pos].offset;
+    }
 
-    while (opt_count--) {
+    for (; pos < pkt->options_len; pos++) {
+        const coap_optpos_t *optpos = &pkt->options[pos];
         if (optpos->opt_num == opt_num) {
-            return (uint8_t*)pkt->hdr + optpos->offset;
+            return (uint8_t *)pkt->hdr + optpos->offset;
+        }
+        if (optpos->opt_num > opt_num) {
+            break;
         }
-        optpos++;
     }
     return NULL;
 }
@@ -279,6 +297,44 @@ uint8_t *coap_iterate_option(const coap_pkt_t *pkt, uint8_t **optpos,
     }
 }
 
+int coap_match_path_pkt(const coap_resource_t *resource, const coap_pkt_t *pkt)
+{
+    assert(resource && pkt);
+    const char *path = resource->path;
+    bool subtree = resource->methods & COAP_MATCH_SUBTREE;
+    uint8_t *opt_pos = coap_find_option(pkt, COAP_OPT_URI_PATH);
+    uint8_t *part = NULL;
+    int part_len = 0;
+
+    /* compare '/' and value of each Uri-Path option; without any, the URI
+     * is "/" */
+    do {
+        if (opt_pos) {
+            part = coap_iterate_option(pkt, &opt_pos, &part_len, (part == NULL));
+            if (!part) {
+                break;
+            }
+        }
+        if (*path != '/') {
+            return ((*path == '\0') && subtree) ? 0 : '/' - (uint8_t)*path;
+        }
+        path++;
+
+        size_t n = strnlen(path, part_len);
+        int res = memcmp(part, path, n);
+        if (res) {
+            return res;
+        }
+        if (n < (size_t)part_len) {
+            /* resource path ends within the option */
+            return subtree ? 0 : part[n];
+        }
+        path += n;
+    } while (opt_pos);
+
+    return -(int)(uint8_t)*path;
+}
+
 unsigned coap_get_content_type(coap_pkt_t *pkt)
 {
     uint8_t *opt_pos = coap_find_option(pkt, COAP_OPT_CONTENT_FORMAT);
@@ -408,19 +464,13 @@ ssize_t coap_tree_handler(coap_pkt_t *pkt, uint8_t *resp_buf,
 {
     coap_method_flags_t method_flag = coap_method2flag(coap_get_code_detail(pkt));
 
-    uint8_t uri[CONFIG_NANOCOAP_URI_MAX];
-    if (coap_get_uri_path(pkt, uri) <= 0) {
-        return -EBADMSG;
-    }
-    DEBUG("nanocoap: URI path: \"%s\"\n", uri);
-
     for (unsigned i = 0; i < resources_numof; i++) {
         const coap_resource_t *resource = &resources[i];
         if (!(resource->methods & method_flag)) {
             continue;
         }
 
-        int res = coap_match_path(resource, uri);
+        int res = coap_match_path_pkt(resource, pkt);
         if (res > 0) {
             continue;
         }
@@ -700,13 +750,7 @@ static unsigned _size2szx(size_t size)
 static unsigned _slicer2blkopt(coap_block_slicer_t *slicer, bool more)
 {
     size_t blksize = slicer->end - slicer->start;
-    size_t start = slicer->start;
-    unsigned blknum = 0;
-
-    while (start > 0) {
-        start -= blksize;
-        blknum++;
-    }
+    unsigned blknum = slicer->start / blksize;
 
     return (blknum << 4) | _size2szx(blksize) | (more ? 0x8 : 0);
 }
@@ -715,7 +759,12 @@ int coap_get_block(coap_pkt_t *pkt, coap_block1_t *block, uint16_t option)
 {
     block->more = coap_get_blockopt(pkt, option, &block->blknum, &block->szx);
     if (block->more >= 0) {
-        block->offset = block->blknum << (block->szx + 4);
+        /* BERT blocks are numbered in units of 1024 bytes */
+        unsigned szx = block->szx;
+        if (szx == COAP_BLOCKWISE_SZX_BERT) {
+            szx = COAP_BLOCKWISE_SZX_BERT - 1;
+        }
+        block->offset = block->blknum << (szx + 4);
     }
     else {
         block->offset = 0;
@@ -796,14 +845,16 @@ size_t coap_opt_put_uint(uint8_t *buf, uint16_t lastonum, uint16_t onum,
 static ssize_t _add_opt_pkt(coap_pkt_t *pkt, uint16_t optnum, const uint8_t *val,
                             size_t val_len)
 {
-    if (pkt->options_len >= CONFIG_NANOCOAP_NOPTS_MAX) {
-        return -ENOSPC;
-    }
-
     uint16_t lastonum = (pkt->options_len)
             ? pkt->options[pkt->options_len - 1].opt_num : 0;
     assert(optnum >= lastonum);
 
+    /* a repeated option is found via the first one */
+    bool repeated = pkt->options_len && (optnum == lastonum);
+    if (!repeated && (pkt->options_len >= CONFIG_NANOCOAP_NOPTS_MAX)) {
+        return -ENOSPC;
+    }
+
     /* calculate option length */
     uint8_t dummy[3] = { 0 };
     size_t optlen = _put_delta_optlen(dummy, 1, 4, optnum - lastonum);
@@ -815,9 +866,14 @@ static ssize_t _add_opt_pkt(coap_pkt_t *pkt, uint16_t optnum, const uint8_t *val
 
     coap_put_option(pkt->payload, lastonum, optnum, val, val_len);
 
-    pkt->options[pkt->options_len].opt_num = optnum;
-    pkt->options[pkt->options_len].offset = pkt->payload - (uint8_t *)pkt->hdr;
-    pkt->options_len++;
+    if (!repeated) {
+        pkt->options[pkt->options_len].opt_num = optnum;
+        pkt->options[pkt->options_len].offset = pkt->payload - (uint8_t *)pkt->hdr;
+        pkt->options_len++;
+        if (optnum < 32) {
+            pkt->options_map |= 1UL << optnum;
+        }
+    }
     pkt->payload += optlen;
     pkt->payload_len -= optlen;
 
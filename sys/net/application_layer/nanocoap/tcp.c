@@ -0,0 +1,569 @@
+/*
+ * Copyright (C) 2020 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     net_nanocoap_tcp
+ * @{
+ *
+ * @file
+ * @brief       CoAP over TCP for nanocoap
+ *
+ * @}
+ */
+
+#include <errno.h>
+#include <string.h>
+
+#include "kernel_defines.h"
+#include "net/nanocoap_tcp.h"
+#include "timex.h"
+
+#define ENABLE_DEBUG (0)
+#include "debug.h"
+
+/* Parts of a message, in the order they are received */
+enum {
+    STATE_LEN,                          /* Len and TKL */
+    STATE_EXT,                          /* Extended length */
+    STATE_CODE,                         /* Code */
+    STATE_BODY,                         /* Token, options and payload */
+};
+
+/* Largest signal sent: header, token and two options */
+#define SIGNAL_SIZE_MAX     (4 + 8 + 5 + 1)
+/* Offsets of the extended lengths of 1, 2 and 4 bytes */
+#define EXT_OFFSET_1        (13U)
+#define EXT_OFFSET_2        (269U)
+#define EXT_OFFSET_4        (65805UL)
+
+void coap_tcp_parser_init(coap_tcp_parser_t *parser)
+{
+    memset(parser, 0, sizeof(*parser));
+}
+
+/* Ends the header; the message is stored behind a header of RFC 7252 */
+static void _body_start(coap_tcp_parser_t *parser, uint8_t *buf, size_t len,
+                        uint8_t code)
+{
+    parser->need += parser->tkl;
+    parser->discard = (parser->tkl > COAP_TOKEN_LENGTH_MAX)
+                      || (sizeof(coap_hdr_t) + parser->need > len);
+    if (!parser->discard) {
+        coap_build_hdr((coap_hdr_t *)buf, COAP_TYPE_CON, NULL, 0, code, 0);
+        ((coap_hdr_t *)buf)->ver_t_tkl |= parser->tkl;
+    }
+    parser->pos = sizeof(coap_hdr_t);
+    parser->state = STATE_BODY;
+}
+
+int coap_tcp_parse(coap_tcp_parser_t *parser, coap_pkt_t *pkt, uint8_t *buf,
+                   size_t len, const uint8_t *data, size_t data_len,
+                   size_t *consumed)
+{
+    const uint8_t *pos = data;
+    const uint8_t *end = data + data_len;
+
+    while (pos < end || ((parser->state == STATE_BODY) && !parser->need)) {
+        switch (parser->state) {
+        case STATE_LEN: {
+            unsigned len_nibble = *pos >> 4;
+            parser->tkl = *pos & 0xf;
+            pos++;
+            parser->need = 0;
+            if (len_nibble < EXT_OFFSET_1) {
+                parser->need = len_nibble;
+                parser->ext_len = 0;
+                parser->state = STATE_CODE;
+            }
+            else {
+                /* 13, 14 and 15 announce 1, 2 and 4 bytes */
+                parser->ext_len = 1 << (len_nibble - EXT_OFFSET_1);
+                parser->ext_left = parser->ext_len;
+                parser->state = STATE_EXT;
+            }
+            break;
+        }
+        case STATE_EXT:
+            parser->need = (parser->need << 8) | *pos++;
+            if (--parser->ext_left == 0) {
+                static const uint32_t offsets[] = {
+                    EXT_OFFSET_1, EXT_OFFSET_2, 0, EXT_OFFSET_4
+                };
+                uint32_t offset = offsets[parser->ext_len - 1];
+                /* such a message is skipped anyway */
+                if (parser->need > UINT32_MAX - offset - parser->tkl) {
+                    parser->need = UINT32_MAX - offset - parser->tkl;
+                }
+                parser->need += offset;
+                parser->state = STATE_CODE;
+            }
+            break;
+        case STATE_CODE:
+            _body_start(parser, buf, len, *pos++);
+            break;
+        case STATE_BODY: {
+            size_t chunk = end - pos;
+            if (chunk > parser->need) {
+                chunk = parser->need;
+            }
+            if (!parser->discard) {
+                if (pos != buf + parser->pos) {
+                    memcpy(buf + parser->pos, pos, chunk);
+                }
+                parser->pos += chunk;
+            }
+            pos += chunk;
+            parser->need -= chunk;
+            if (parser->need) {
+                break;
+            }
+
+            parser->state = STATE_LEN;
+            *consumed = pos - data;
+            if (parser->tkl > COAP_TOKEN_LENGTH_MAX) {
+                DEBUG("nanocoap_tcp: invalid token length\n");
+                return -EBADMSG;
+            }
+            if (parser->discard) {
+                DEBUG("nanocoap_tcp: message too long, skipped\n");
+                return -EMSGSIZE;
+            }
+            if (coap_parse(pkt, buf, parser->pos) < 0) {
+                DEBUG("nanocoap_tcp: invalid message\n");
+                return -EBADMSG;
+            }
+            return 1;
+        }
+        }
+    }
+
+    *consumed = data_len;
+    return 0;
+}
+
+size_t coap_tcp_parser_body(const coap_tcp_parser_t *parser, uint8_t *buf,
+                            uint8_t **body)
+{
+    if ((parser->state != STATE_BODY) || parser->discard) {
+        return 0;
+    }
+    *body = buf + parser->pos;
+    return parser->need;
+}
+
+size_t coap_tcp_hdr_build(uint8_t *hdr, const uint8_t *msg, size_t len)
+{
+    const coap_hdr_t *udp_hdr = (const coap_hdr_t *)msg;
+    unsigned tkl = udp_hdr->ver_t_tkl & 0xf;
+    uint32_t body_len = len - sizeof(coap_hdr_t) - tkl;
+    uint8_t *pos = hdr + 1;
+
+    if (body_len < EXT_OFFSET_1) {
+        hdr[0] = body_len << 4;
+    }
+    else if (body_len < EXT_OFFSET_2) {
+        hdr[0] = 13 << 4;
+        *pos++ = body_len - EXT_OFFSET_1;
+    }
+    else if (body_len < EXT_OFFSET_4) {
+        body_len -= EXT_OFFSET_2;
+        hdr[0] = 14 << 4;
+        *pos++ = body_len >> 8;
+        *pos++ = body_len & 0xff;
+    }
+    else {
+        body_len -= EXT_OFFSET_4;
+        hdr[0] = 15 << 4;
+        for (int shift = 24; shift >= 0; shift -= 8) {
+            *pos++ = (body_len >> shift) & 0xff;
+        }
+    }
+    hdr[0] |= tkl;
+    *pos++ = udp_hdr->code;
+    return pos - hdr;
+}
+
+static int _write(sock_tcp_t *sock, const uint8_t *data, size_t len)
+{
+    while (len) {
+        ssize_t res = sock_tcp_write(sock, data, len);
+        if (res < 0) {
+            DEBUG("nanocoap_tcp: write failed: %d\n", (int)res);
+            return res;
+        }
+        data += res;
+        len -= res;
+    }
+    return 0;
+}
+
+int nanocoap_tcp_send(nanocoap_tcp_conn_t *conn, uint8_t *msg, size_t len)
+{
+    uint8_t hdr[COAP_TCP_HDR_MAX];
+    size_t hdr_len = coap_tcp_hdr_build(hdr, msg, len);
+    size_t rest = len - sizeof(coap_hdr_t);
+
+    if (hdr_len + rest > conn->max_msg_size) {
+        return -EMSGSIZE;
+    }
+    /* the header of RFC 8323 takes the place of the one of RFC 7252, unless
+     * it is longer */
+    if (hdr_len <= sizeof(coap_hdr_t)) {
+        uint8_t *start = msg + sizeof(coap_hdr_t) - hdr_len;
+        memcpy(start, hdr, hdr_len);
+        return _write(conn->sock, start, hdr_len + rest);
+    }
+    int res = _write(conn->sock, hdr, hdr_len);
+    if (res < 0) {
+        return res;
+    }
+    return _write(conn->sock, msg + sizeof(coap_hdr_t), rest);
+}
+
+static int _send_signal(nanocoap_tcp_conn_t *conn, unsigned code,
+                        const uint8_t *token, size_t token_len,
+                        uint32_t max_msg_size)
+{
+    uint8_t buf[SIGNAL_SIZE_MAX];
+    uint8_t *pos = buf;
+
+    pos += coap_build_hdr((coap_hdr_t *)buf, COAP_TYPE_CON, (uint8_t *)token,
+                          token_len, code, 0);
+    if (code == COAP_CODE_CSM) {
+        pos += coap_opt_put_uint(pos, 0, COAP_SIGNAL_OPT_MAX_MESSAGE_SIZE,
+                                 max_msg_size);
+        pos += coap_put_option(pos, COAP_SIGNAL_OPT_MAX_MESSAGE_SIZE,
+                               COAP_SIGNAL_OPT_BLOCK_WISE_TRANSFER, NULL, 0);
+    }
+    return nanocoap_tcp_send(conn, buf, pos - buf);
+}
+
+/* Announces the largest message that fits into a buffer of len bytes, with
+ * a header of RFC 7252 instead of the shortest one of RFC 8323 */
+static int _send_csm(nanocoap_tcp_conn_t *conn, size_t len)
+{
+    return _send_signal(conn, COAP_CODE_CSM, NULL, 0, len - 2);
+}
+
+static void _conn_init(nanocoap_tcp_conn_t *conn, sock_tcp_t *sock)
+{
+    memset(conn, 0, sizeof(*conn));
+    conn->sock = sock;
+    conn->max_msg_size = COAP_TCP_MSG_SIZE_DEFAULT;
+}
+
+static int _handle_signal(nanocoap_tcp_conn_t *conn, coap_pkt_t *pkt)
+{
+    uint8_t *value;
+    uint32_t max_msg_size;
+
+    switch (coap_get_code_raw(pkt)) {
+    case COAP_CODE_CSM:
+        /* options not repeated keep their value */
+        if (coap_opt_get_uint(pkt, COAP_SIGNAL_OPT_MAX_MESSAGE_SIZE,
+                              &max_msg_size) == 0) {
+            conn->max_msg_size = max_msg_size;
+        }
+        if (coap_opt_get_opaque(pkt, COAP_SIGNAL_OPT_BLOCK_WISE_TRANSFER,
+                                &value) >= 0) {
+            conn->bert = true;
+        }
+        conn->csm = true;
+        return 0;
+    case COAP_CODE_PING:
+        return _send_signal(conn, COAP_CODE_PONG, pkt->token,
+                            coap_get_token_len(pkt), 0);
+    case COAP_CODE_RELEASE:
+    case COAP_CODE_ABORT:
+        DEBUG("nanocoap_tcp: connection closed by peer\n");
+        return -ECONNRESET;
+    default:
+        return 0;
+    }
+}
+
+/* Receives the next message, handling signals */
+static ssize_t _recv_msg(nanocoap_tcp_conn_t *conn, coap_pkt_t *pkt,
+                         uint8_t *buf, size_t len)
+{
+    while (1) {
+        const uint8_t *data = conn->rx + conn->rx_pos;
+        size_t data_len = conn->rx_len - conn->rx_pos;
+        bool in_place = false;
+
+        if (!data_len) {
+            /* a long body is received in place */
+            uint8_t *body;
+            size_t want = coap_tcp_parser_body(&conn->parser, buf, &body);
+            in_place = (want > sizeof(conn->rx));
+            if (!in_place) {
+                body = conn->rx;
+                want = sizeof(conn->rx);
+            }
+            ssize_t res = sock_tcp_read(conn->sock, body, want,
+                                        CONFIG_NANOCOAP_TCP_TIMEOUT_MS
+                                        * US_PER_MS);
+            if (res < 0) {
+                return res;
+            }
+            if (res == 0) {
+                continue;
+            }
+            if (!in_place) {
+                conn->rx_pos = 0;
+                conn->rx_len = res;
+            }
+            data = body;
+            data_len = res;
+        }
+
+        size_t consumed;
+        int res = coap_tcp_parse(&conn->parser, pkt, buf, len, data, data_len,
+                                 &consumed);
+        if (!in_place) {
+            conn->rx_pos += consumed;
+        }
+        /* invalid messages are skipped, the stream stays in sync */
+        if (res <= 0) {
+            continue;
+        }
+
+        if (coap_get_code_class(pkt) == COAP_CLASS_SIGNAL) {
+            res = _handle_signal(conn, pkt);
+            if (res < 0) {
+                return res;
+            }
+        }
+        return (pkt->payload - buf) + pkt->payload_len;
+    }
+}
+
+ssize_t nanocoap_tcp_recv(nanocoap_tcp_conn_t *conn, coap_pkt_t *pkt,
+                          uint8_t *buf, size_t len)
+{
+    while (1) {
+        ssize_t res = _recv_msg(conn, pkt, buf, len);
+        if ((res < 0) || (coap_get_code_class(pkt) != COAP_CLASS_SIGNAL)) {
+            return res;
+        }
+    }
+}
+
+int nanocoap_tcp_connect(nanocoap_tcp_conn_t *conn, sock_tcp_t *sock,
+                         const sock_tcp_ep_t *remote, uint8_t *buf,
+                         size_t len)
+{
+    coap_pkt_t pkt;
+
+    int res = sock_tcp_connect(sock, remote, 0, 0);
+    if (res < 0) {
+        return res;
+    }
+    _conn_init(conn, sock);
+
+    /* the CSM is the first message in both directions */
+    res = _send_csm(conn, len);
+    if (res == 0) {
+        res = _recv_msg(conn, &pkt, buf, len);
+    }
+    if ((res >= 0) && !conn->csm) {
+        DEBUG("nanocoap_tcp: no CSM from server\n");
+        res = -EBADMSG;
+    }
+    if (res < 0) {
+        sock_tcp_disconnect(sock);
+        return res;
+    }
+    return 0;
+}
+
+void nanocoap_tcp_close(nanocoap_tcp_conn_t *conn)
+{
+    _send_signal(conn, COAP_CODE_RELEASE, NULL, 0, 0);
+    sock_tcp_disconnect(conn->sock);
+}
+
+ssize_t nanocoap_tcp_request(nanocoap_tcp_conn_t *conn, coap_pkt_t *pkt,
+                             size_t len)
+{
+    uint8_t *buf = (uint8_t *)pkt->hdr;
+    size_t pdu_len = (pkt->payload - buf) + pkt->payload_len;
+    uint8_t token[COAP_TOKEN_LENGTH_MAX];
+    size_t token_len = coap_get_token_len(pkt);
+
+    memcpy(token, pkt->token, token_len);
+    ssize_t res = nanocoap_tcp_send(conn, buf, pdu_len);
+    if (res < 0) {
+        return res;
+    }
+
+    /* responses are matched by their token only */
+    while (1) {
+        res = nanocoap_tcp_recv(conn, pkt, buf, len);
+        if (res < 0) {
+            return res;
+        }
+        if ((coap_get_code_class(pkt) != COAP_CLASS_REQ)
+                && (coap_get_token_len(pkt) == token_len)
+                && !memcmp(pkt->token, token, token_len)) {
+            return res;
+        }
+        DEBUG("nanocoap_tcp: unexpected message\n");
+    }
+}
+
+/* Maps a response other than 2.05 to an errno */
+static int _code2errno(coap_pkt_t *pkt)
+{
+    switch (coap_get_code_raw(pkt)) {
+    case COAP_CODE_PATH_NOT_FOUND:
+        return -ENOENT;
+    case COAP_CODE_UNAUTHORIZED:
+    case COAP_CODE_FORBIDDEN:
+        return -EACCES;
+    case COAP_CODE_SERVICE_UNAVAILABLE:
+        return -EAGAIN;
+    default:
+        return (coap_get_code_class(pkt) == COAP_CLASS_SERVER_FAILURE)
+               ? -EIO : -EBADMSG;
+    }
+}
+
+ssize_t nanocoap_tcp_get_blockwise(nanocoap_tcp_conn_t *conn,
+                                   const char *path, uint8_t *buf, size_t len,
+                                   nanocoap_tcp_block_cb_t cb, void *arg)
+{
+    unsigned szx = COAP_BLOCKWISE_SZX_BERT;
+    size_t offset = 0;
+    uint16_t id = 0;
+    bool more = true;
+
+    if (!conn->bert) {
+        /* the largest block that fits, with room for the header */
+        szx = COAP_BLOCKWISE_SZX_BERT - 1;
+        while ((szx > 0) && (coap_szx2size(szx) + 64 > len)) {
+            szx--;
+        }
+    }
+
+    while (more) {
+        coap_pkt_t pkt;
+        coap_block1_t block2;
+        uint32_t blknum = (szx == COAP_BLOCKWISE_SZX_BERT)
+                          ? offset / COAP_BLOCKWISE_BERT_UNIT
+                          : offset / coap_szx2size(szx);
+        uint8_t token[2] = { id >> 8, id & 0xff };
+
+        ssize_t res = coap_build_hdr((coap_hdr_t *)buf, COAP_TYPE_CON, token,
+                                     sizeof(token), COAP_METHOD_GET, id++);
+        coap_pkt_init(&pkt, buf, len, res);
+        coap_opt_add_uri_path(&pkt, path);
+        coap_opt_add_uint(&pkt, COAP_OPT_BLOCK2,
+                          (blknum << COAP_BLOCKWISE_NUM_OFF) | szx);
+        res = coap_opt_finish(&pkt, COAP_OPT_FINISH_NONE);
+        if (res < 0) {
+            return res;
+        }
+
+        res = nanocoap_tcp_request(conn, &pkt, len);
+        if (res < 0) {
+            return res;
+        }
+        if (coap_get_code_raw(&pkt) != COAP_CODE_CONTENT) {
+            return _code2errno(&pkt);
+        }
+
+        /* a response without Block2 holds the whole representation */
+        if (!coap_get_block2(&pkt, &block2)) {
+            block2.offset = offset;
+            block2.szx = szx;
+            block2.more = 0;
+        }
+        if (block2.offset != offset) {
+            DEBUG("nanocoap_tcp: unexpected block\n");
+            return -EBADMSG;
+        }
+        more = block2.more;
+        res = cb(arg, offset, pkt.payload, pkt.payload_len, more);
+        if (res < 0) {
+            return res;
+        }
+        offset += pkt.payload_len;
+        /* continue with the block size of the server */
+        szx = block2.szx;
+    }
+    return offset;
+}
+
+static void _serve(sock_tcp_t *sock, uint8_t *buf, size_t bufsize)
+{
+    nanocoap_tcp_conn_t conn;
+
+    _conn_init(&conn, sock);
+    if (_send_csm(&conn, bufsize) < 0) {
+        return;
+    }
+
+    while (1) {
+        coap_pkt_t pkt;
+        ssize_t res = nanocoap_tcp_recv(&conn, &pkt, buf, bufsize);
+        if (res < 0) {
+            DEBUG("nanocoap_tcp: connection closed: %d\n", (int)res);
+            return;
+        }
+        if ((coap_get_code_class(&pkt) != COAP_CLASS_REQ)
+                || (coap_get_code_raw(&pkt) == COAP_CODE_EMPTY)) {
+            continue;
+        }
+
+        /* the response must fit into the buffer of the client, with a
+         * header of RFC 8323 that is up to 2 bytes longer than the one of
+         * RFC 7252 written by the handler */
+        size_t len = bufsize;
+        size_t grow = COAP_TCP_HDR_MAX - sizeof(coap_hdr_t);
+        if (len + grow > conn.max_msg_size) {
+            len = (conn.max_msg_size > grow) ? conn.max_msg_size - grow : 0;
+        }
+        res = coap_handle_req(&pkt, buf, len);
+        if (res <= 0) {
+            DEBUG("nanocoap_tcp: error handling request %d\n", (int)res);
+            continue;
+        }
+        if (nanocoap_tcp_send(&conn, buf, res) < 0) {
+            return;
+        }
+    }
+}
+
+int nanocoap_tcp_server(sock_tcp_ep_t *local, uint8_t *buf, size_t bufsize)
+{
+    sock_tcp_queue_t queue;
+    sock_tcp_t socks[1];
+
+    if (!local->port) {
+        local->port = COAP_PORT;
+    }
+
+    int res = sock_tcp_listen(&queue, local, socks, ARRAY_SIZE(socks), 0);
+    if (res < 0) {
+        return res;
+    }
+
+    while (1) {
+        sock_tcp_t *sock;
+        res = sock_tcp_accept(&queue, &sock, SOCK_NO_TIMEOUT);
+        if (res < 0) {
+            DEBUG("nanocoap_tcp: accept failed: %d\n", res);
+            continue;
+        }
+        _serve(sock, buf, bufsize);
+        sock_tcp_disconnect(sock);
+    }
+
+    return 0;
+}
@@ -0,0 +1,424 @@
+/*
+ * Copyright (C) 2020 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @{
+ *
+ * @file
+ */
+
+#include <assert.h>
+#include <errno.h>
+#include <string.h>
+
+#include "kernel_defines.h"
+
+#include "net/gnrc/pktbuf.h"
+#include "net/gnrc/netif/fq.h"
+#include "net/gnrc/netif/hdr.h"
+#include "net/icmpv6.h"
+#include "net/ipv6/hdr.h"
+#include "net/protnum.h"
+#include "net/sixlowpan.h"
+#include "xtimer.h"
+
+#define ENABLE_DEBUG    (0)
+#include "debug.h"
+
+/* end of a list */
+#define _NONE           (UINT8_MAX)
+/* flow is not in the round robin list */
+#define _INACTIVE       (UINT8_MAX - 1)
+/* flow for packets that do not carry an IPv6 header */
+#define _FLOW_OTHER     (GNRC_NETIF_FQ_FLOW_CTRL + 1)
+/* DSCP class selector 6 (network control) */
+#define _DSCP_CS6       (48U)
+
+static_assert(CONFIG_GNRC_NETIF_FQ_SIZE < _INACTIVE,
+              "CONFIG_GNRC_NETIF_FQ_SIZE must be less than 254");
+static_assert((CONFIG_GNRC_NETIF_FQ_FLOWS_NUMOF > 1) &&
+              (CONFIG_GNRC_NETIF_FQ_FLOWS_NUMOF < _INACTIVE),
+              "CONFIG_GNRC_NETIF_FQ_FLOWS_NUMOF must be in [2, 253]");
+
+void gnrc_netif_fq_init(gnrc_netif_fq_t *fq)
+{
+    memset(fq, 0, sizeof(*fq));
+    for (unsigned i = 0; i < CONFIG_GNRC_NETIF_FQ_SIZE; i++) {
+        fq->entries[i].next = i + 1;
+    }
+    fq->entries[CONFIG_GNRC_NETIF_FQ_SIZE - 1].next = _NONE;
+    for (unsigned i = 0; i < CONFIG_GNRC_NETIF_FQ_FLOWS_NUMOF; i++) {
+        fq->flows[i].head = _NONE;
+        fq->flows[i].tail = _NONE;
+        fq->flows[i].next = _INACTIVE;
+    }
+    fq->active = _NONE;
+    fq->active_tail = _NONE;
+}
+
+/* Maps a hash to one of the flows other than the control flow */
+static unsigned _flow(uint32_t hash)
+{
+    hash ^= (hash >> 16);
+    hash ^= (hash >> 8);
+    return _FLOW_OTHER +
+           (hash % (CONFIG_GNRC_NETIF_FQ_FLOWS_NUMOF - _FLOW_OTHER));
+}
+
+/* Checks if the ICMPv6 message at offset in snip, or at the start of the
+ * next snip if it ends there, is an NDP or RPL message. Other ICMPv6
+ * messages, e.g. echo requests, are fair-queued, so they can not starve the
+ * other flows. */
+static bool _is_ctrl_icmpv6(const gnrc_pktsnip_t *snip, size_t offset)
+{
+    const uint8_t *type;
+
+    if (offset < snip->size) {
+        type = (const uint8_t *)snip->data + offset;
+    }
+    else if ((offset == snip->size) && (snip->next != NULL) &&
+             (snip->next->size > 0)) {
+        type = snip->next->data;
+    }
+    else {
+        return false;
+    }
+    switch (*type) {
+        case ICMPV6_RTR_SOL:
+        case ICMPV6_RTR_ADV:
+        case ICMPV6_NBR_SOL:
+        case ICMPV6_NBR_ADV:
+        case ICMPV6_REDIRECT:
+        case ICMPV6_RPL_CTRL:
+            return true;
+        default:
+            return false;
+    }
+}
+
+/* Classifies by the IPv6 header at offset in snip */
+static unsigned _classify_ipv6(const gnrc_pktsnip_t *snip, size_t offset,
+                               uint32_t hash)
+{
+    const ipv6_hdr_t *hdr = (const ipv6_hdr_t *)((uint8_t *)snip->data +
+                                                 offset);
+
+    if (((hdr->nh == PROTNUM_ICMPV6) &&
+         _is_ctrl_icmpv6(snip, offset + sizeof(ipv6_hdr_t))) ||
+        (ipv6_hdr_get_tc_dscp(hdr) >= _DSCP_CS6)) {
+        return GNRC_NETIF_FQ_FLOW_CTRL;
+    }
+    hash ^= ipv6_hdr_get_fl(hdr) ^ hdr->nh;
+    for (unsigned i = 0; i < ARRAY_SIZE(hdr->src.u32); i++) {
+        hash ^= hdr->src.u32[i].u32 ^ hdr->dst.u32[i].u32;
+    }
+    return _flow(hash);
+}
+
+#if IS_USED(MODULE_GNRC_NETTYPE_SIXLOWPAN)
+static uint32_t _hash_bytes(uint32_t hash, const uint8_t *data, size_t len)
+{
+    while (len--) {
+        hash = ((hash << 5) + hash) ^ *(data++);
+    }
+    return hash;
+}
+
+/* Length of an inline address, indexed by SAM or DAM (for DAC = 0 and
+ * M = 0) */
+static const uint8_t _iphc_addr_len[] = { 16, 8, 2, 0 };
+/* Length of an inline multicast address, indexed by DAM (for DAC = 0) */
+static const uint8_t _iphc_mc_addr_len[] = { 16, 6, 4, 1 };
+
+/* Classifies by the inline fields of an IPHC header (RFC 6282). Elided
+ * addresses are derived from the link-layer addresses, which are already
+ * part of hash. */
+static unsigned _classify_iphc(const gnrc_pktsnip_t *snip, uint32_t hash)
+{
+    const uint8_t *iphc = snip->data;
+    unsigned offset = SIXLOWPAN_IPHC_HDR_LEN, tf_offset, nh_offset = 0;
+    unsigned sam = (iphc[1] & SIXLOWPAN_IPHC2_SAM) >> 4;
+    unsigned dam = iphc[1] & SIXLOWPAN_IPHC2_DAM;
+    unsigned src_len, dst_len;
+    uint8_t dscp = 0;
+
+    if (iphc[1] & SIXLOWPAN_IPHC2_CID_EXT) {
+        offset += SIXLOWPAN_IPHC_CID_EXT_LEN;
+    }
+    tf_offset = offset;
+    switch (iphc[0] & SIXLOWPAN_IPHC1_TF) {
+        case 0x00:      /* ECN, DSCP and flow label inline */
+            offset += 4;
+            break;
+        case 0x08:      /* ECN and flow label inline */
+            offset += 3;
+            break;
+        case 0x10:      /* ECN and DSCP inline */
+            offset += 1;
+            break;
+        default:
+            break;
+    }
+    if (!(iphc[0] & SIXLOWPAN_IPHC1_NH)) {
+        nh_offset = offset++;
+    }
+    if (!(iphc[0] & SIXLOWPAN_IPHC1_HL)) {
+        offset++;
+    }
+    src_len = _iphc_addr_len[sam];
+    if ((iphc[1] & SIXLOWPAN_IPHC2_SAC) && (sam == 0)) {
+        /* unspecified address */
+        src_len = 0;
+    }
+    if (iphc[1] & SIXLOWPAN_IPHC2_M) {
+        dst_len = (iphc[1] & SIXLOWPAN_IPHC2_DAC) ? ((dam == 0) ? 6 : 0)
+                                                  : _iphc_mc_addr_len[dam];
+    }
+    else {
+        dst_len = ((iphc[1] & SIXLOWPAN_IPHC2_DAC) && (dam == 0))
+                ? 0 : _iphc_addr_len[dam];
+    }
+    if ((offset + src_len + dst_len) > snip->size) {
+        return _FLOW_OTHER;
+    }
+    if (((iphc[0] & SIXLOWPAN_IPHC1_TF) & 0x08) == 0) {
+        /* DSCP is in the lower six bits after ECN */
+        dscp = iphc[tf_offset] & 0x3f;
+    }
+    if ((nh_offset && (iphc[nh_offset] == PROTNUM_ICMPV6) &&
+         _is_ctrl_icmpv6(snip, offset + src_len + dst_len)) ||
+        (dscp >= _DSCP_CS6)) {
+        return GNRC_NETIF_FQ_FLOW_CTRL;
+    }
+    /* context IDs, address modes, flow label and next header */
+    hash = _hash_bytes(hash, &iphc[1], 1);
+    if (iphc[1] & SIXLOWPAN_IPHC2_CID_EXT) {
+        hash = _hash_bytes(hash, &iphc[SIXLOWPAN_IPHC_HDR_LEN], 1);
+    }
+    switch (iphc[0] & SIXLOWPAN_IPHC1_TF) {
+        case 0x00:
+            hash = _hash_bytes(hash, &iphc[tf_offset + 1], 3);
+            break;
+        case 0x08:
+            hash = _hash_bytes(hash, &iphc[tf_offset], 3);
+            break;
+        default:
+            break;
+    }
+    if (nh_offset) {
+        hash = _hash_bytes(hash, &iphc[nh_offset], 1);
+    }
+    /* inline addresses follow the hop limit */
+    hash = _hash_bytes(hash, &iphc[offset], src_len + dst_len);
+    return _flow(hash);
+}
+
+static unsigned _classify_sixlowpan(gnrc_pktsnip_t *sixlowpan, uint32_t hash)
+{
+    uint8_t *data = sixlowpan->data;
+
+    if ((sixlowpan->size >= sizeof(sixlowpan_frag_t)) &&
+        sixlowpan_frag_is(sixlowpan->data)) {
+        /* all fragments of a datagram are sent in order by one flow, so only
+         * the first fragment would carry the IPHC header anyway */
+        sixlowpan_frag_t *frag = sixlowpan->data;
+
+        return _flow(_hash_bytes(hash, frag->tag.u8, sizeof(frag->tag)));
+    }
+    if ((sixlowpan->size > sizeof(ipv6_hdr_t)) &&
+        (data[0] == SIXLOWPAN_UNCOMP)) {
+        return _classify_ipv6(sixlowpan, 1, hash);
+    }
+    if ((sixlowpan->size >= SIXLOWPAN_IPHC_HDR_LEN) &&
+        sixlowpan_iphc_is(data)) {
+        return _classify_iphc(sixlowpan, hash);
+    }
+    return _FLOW_OTHER;
+}
+#endif  /* MODULE_GNRC_NETTYPE_SIXLOWPAN */
+
+unsigned gnrc_netif_fq_classify(gnrc_pktsnip_t *pkt)
+{
+#if IS_USED(MODULE_GNRC_NETTYPE_IPV6)
+    gnrc_pktsnip_t *ipv6 = gnrc_pktsnip_search_type(pkt, GNRC_NETTYPE_IPV6);
+
+    if ((ipv6 != NULL) && (ipv6->size >= sizeof(ipv6_hdr_t))) {
+        return _classify_ipv6(ipv6, 0, 0);
+    }
+#endif
+#if IS_USED(MODULE_GNRC_NETTYPE_SIXLOWPAN)
+    /* on 6LoWPAN interfaces the IPv6 header was already compressed, or the
+     * packet is a fragment */
+    gnrc_pktsnip_t *sixlowpan = gnrc_pktsnip_search_type(pkt,
+                                                         GNRC_NETTYPE_SIXLOWPAN);
+
+    if (sixlowpan != NULL) {
+        gnrc_pktsnip_t *netif = gnrc_pktsnip_search_type(pkt,
+                                                         GNRC_NETTYPE_NETIF);
+        uint32_t hash = 5381;
+
+        if (netif != NULL) {
+            gnrc_netif_hdr_t *hdr = netif->data;
+
+            hash = _hash_bytes(hash, gnrc_netif_hdr_get_dst_addr(hdr),
+                               hdr->dst_l2addr_len);
+        }
+        return _classify_sixlowpan(sixlowpan, hash);
+    }
+#endif
+    (void)pkt;
+    return _FLOW_OTHER;
+}
+
+static void _active_push(gnrc_netif_fq_t *fq, unsigned idx)
+{
+    fq->flows[idx].next = _NONE;
+    if (fq->active_tail == _NONE) {
+        fq->active = idx;
+    }
+    else {
+        fq->flows[fq->active_tail].next = idx;
+    }
+    fq->active_tail = idx;
+}
+
+static unsigned _active_pop(gnrc_netif_fq_t *fq)
+{
+    unsigned idx = fq->active;
+
+    assert(idx != _NONE);
+    fq->active = fq->flows[idx].next;
+    if (fq->active == _NONE) {
+        fq->active_tail = _NONE;
+    }
+    fq->flows[idx].next = _INACTIVE;
+    return idx;
+}
+
+static gnrc_pktsnip_t *_pop(gnrc_netif_fq_t *fq, unsigned idx,
+                            uint32_t *arrival)
+{
+    gnrc_netif_fq_flow_t *flow = &fq->flows[idx];
+    unsigned e = flow->head;
+    gnrc_pktsnip_t *pkt;
+
+    assert(e != _NONE);
+    pkt = fq->entries[e].pkt;
+    *arrival = fq->entries[e].arrival;
+    flow->head = fq->entries[e].next;
+    if (flow->head == _NONE) {
+        flow->tail = _NONE;
+    }
+    flow->len--;
+    fq->entries[e].pkt = NULL;
+    fq->entries[e].next = fq->free;
+    fq->free = e;
+    fq->len--;
+    return pkt;
+}
+
+void gnrc_netif_fq_enqueue(gnrc_netif_fq_t *fq, gnrc_pktsnip_t *pkt)
+{
+    unsigned idx = gnrc_netif_fq_classify(pkt);
+    gnrc_netif_fq_flow_t *flow = &fq->flows[idx];
+    unsigned e;
+
+    if (fq->free == _NONE) {
+        unsigned longest = idx;
+        uint32_t arrival;
+
+        for (unsigned i = 0; i < CONFIG_GNRC_NETIF_FQ_FLOWS_NUMOF; i++) {
+            if (fq->flows[i].len > fq->flows[longest].len) {
+                longest = i;
+            }
+        }
+        DEBUG("gnrc_netif_fq: queue full, dropping from flow %u\n", longest);
+        gnrc_pktbuf_release_error(_pop(fq, longest, &arrival), ENOBUFS);
+        fq->stats.dropped++;
+    }
+    e = fq->free;
+    fq->free = fq->entries[e].next;
+    fq->entries[e].pkt = pkt;
+    fq->entries[e].arrival = xtimer_now_usec();
+    fq->entries[e].next = _NONE;
+    if (flow->tail == _NONE) {
+        flow->head = e;
+    }
+    else {
+        fq->entries[flow->tail].next = e;
+    }
+    flow->tail = e;
+    flow->len++;
+    fq->len++;
+    fq->stats.enqueued++;
+    /* the control flow is served before the round robin */
+    if ((idx != GNRC_NETIF_FQ_FLOW_CTRL) && (flow->next == _INACTIVE)) {
+        flow->deficit = 0;
+        _active_push(fq, idx);
+    }
+}
+
+gnrc_pktsnip_t *gnrc_netif_fq_dequeue(gnrc_netif_fq_t *fq)
+{
+    gnrc_pktsnip_t *pkt = NULL;
+    uint32_t arrival, delay;
+
+    if (fq->len == 0) {
+        return NULL;
+    }
+    if (fq->flows[GNRC_NETIF_FQ_FLOW_CTRL].len > 0) {
+        pkt = _pop(fq, GNRC_NETIF_FQ_FLOW_CTRL, &arrival);
+    }
+    while (pkt == NULL) {
+        unsigned idx = fq->active;
+        gnrc_netif_fq_flow_t *flow = &fq->flows[idx];
+        int32_t len;
+
+        if (flow->len == 0) {
+            /* emptied by a drop */
+            _active_pop(fq);
+            continue;
+        }
+        len = gnrc_pkt_len(fq->entries[flow->head].pkt);
+        if (flow->deficit < len) {
+            /* flow used up its share of this round */
+            flow->deficit += CONFIG_GNRC_NETIF_FQ_QUANTUM;
+            _active_push(fq, _active_pop(fq));
+            continue;
+        }
+        flow->deficit -= len;
+        pkt = _pop(fq, idx, &arrival);
+        if (flow->len == 0) {
+            _active_pop(fq);
+        }
+    }
+    delay = xtimer_now_usec() - arrival;
+    if (delay > fq->stats.delay_max) {
+        fq->stats.delay_max = delay;
+    }
+    /* exponentially weighted moving average with weight 1/8 */
+    fq->stats.delay_avg = fq->stats.delay_avg - (fq->stats.delay_avg >> 3) +
+                          (delay >> 3);
+    return pkt;
+}
+
+void gnrc_netif_fq_flush(gnrc_netif_fq_t *fq)
+{
+    for (unsigned i = 0; i < CONFIG_GNRC_NETIF_FQ_FLOWS_NUMOF; i++) {
+        uint32_t arrival;
+
+        while (fq->flows[i].len > 0) {
+            gnrc_pktbuf_release(_pop(fq, i, &arrival));
+        }
+        fq->flows[i].next = _INACTIVE;
+    }
+    fq->active = _NONE;
+    fq->active_tail = _NONE;
+}
+
+/** @} */
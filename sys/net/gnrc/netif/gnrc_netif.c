@@ -1412,6 +1412,28 @@ static inline event_queue_t *_get_evq(gnrc_netif_t *netif)
 #endif
 }
 
+/**
+ * @brief   Process any pending events
+ *
+ * @param[in]   netif   gnrc_netif instance to operate on
+ */
+static void _process_events(gnrc_netif_t *netif)
+{
+    if (IS_USED(MODULE_GNRC_NETIF_EVENTS)) {
+        DEBUG("gnrc_netif: handling events\n");
+        event_t *evp;
+        /* We can not use event_loop() or event_wait() because then we would not
+         * wake up when a message arrives */
+        event_queue_t *evq = _get_evq(netif);
+        while ((evp = event_get(evq))) {
+            DEBUG("gnrc_netif: event %p\n", (void *)evp);
+            if (evp->handler) {
+                evp->handler(evp);
+            }
+        }
+    }
+}
+
 /**
  * @brief   Process any pending events and wait for IPC messages
  *
@@ -1431,17 +1453,7 @@ static void _process_events_await_msg(gnrc_netif_t *netif, msg_t *msg)
 
             /* First drain the queues before blocking the thread */
             /* Events will be handled before messages */
-            DEBUG("gnrc_netif: handling events\n");
-            event_t *evp;
-            /* We can not use event_loop() or event_wait() because then we would not
-             * wake up when a message arrives */
-            event_queue_t *evq = _get_evq(netif);
-            while ((evp = event_get(evq))) {
-                DEBUG("gnrc_netif: event %p\n", (void *)evp);
-                if (evp->handler) {
-                    evp->handler(evp);
-                }
-            }
+            _process_events(netif);
             /* non-blocking msg check */
             int msg_waiting = msg_try_receive(msg);
             if (msg_waiting > 0) {
@@ -1504,6 +1516,9 @@ static void *_gnrc_netif_thread(void *args)
 #endif
 #ifdef MODULE_NETSTATS_L2
     memset(&netif->stats, 0, sizeof(netstats_t));
+#endif
+#if IS_USED(MODULE_GNRC_NETIF_FQ)
+    gnrc_netif_fq_init(&netif->fq);
 #endif
     /* now let rest of GNRC use the interface */
     gnrc_netif_release(netif);
@@ -1513,9 +1528,24 @@ static void *_gnrc_netif_thread(void *args)
 
     while (1) {
         msg_t msg;
-        /* msg will be filled by _process_events_await_msg.
-         * The function will not return until a message has been received. */
-        _process_events_await_msg(netif, &msg);
+#if IS_USED(MODULE_GNRC_NETIF_FQ)
+        bool dequeued = false;
+
+        /* only send from the queue once all pending messages were handled,
+         * so every waiting packet was classified into its flow */
+        if (!gnrc_netif_fq_empty(&netif->fq) && (msg_avail() == 0)) {
+            _process_events(netif);
+            msg.type = GNRC_NETAPI_MSG_TYPE_SND;
+            msg.content.ptr = gnrc_netif_fq_dequeue(&netif->fq);
+            dequeued = true;
+        }
+        else
+#endif
+        {
+            /* msg will be filled by _process_events_await_msg.
+             * The function will not return until a message has been received. */
+            _process_events_await_msg(netif, &msg);
+        }
 
         /* dispatch netdev, MAC and gnrc_netapi messages */
         DEBUG("gnrc_netif: message %u\n", (unsigned)msg.type);
@@ -1526,6 +1556,12 @@ static void *_gnrc_netif_thread(void *args)
                 break;
             case GNRC_NETAPI_MSG_TYPE_SND:
                 DEBUG("gnrc_netif: GNRC_NETDEV_MSG_TYPE_SND received\n");
+#if IS_USED(MODULE_GNRC_NETIF_FQ)
+                if (!dequeued) {
+                    gnrc_netif_fq_enqueue(&netif->fq, msg.content.ptr);
+                    break;
+                }
+#endif
                 res = netif->ops->send(netif, msg.content.ptr);
                 if (res < 0) {
                     DEBUG("gnrc_netif: error sending packet %p (code: %i)\n",
@@ -1631,6 +1667,12 @@ static void _event_cb(netdev_t *dev, netdev_event_t event)
                     _pass_on_packet(pkt);
                 }
                 break;
+#if IS_USED(MODULE_GNRC_NETIF_FQ)
+            case NETDEV_EVENT_LINK_DOWN:
+                /* queued packets could only be sent late, if at all */
+                gnrc_netif_fq_flush(&netif->fq);
+                break;
+#endif
 #ifdef MODULE_NETSTATS_L2
             case NETDEV_EVENT_TX_MEDIUM_BUSY:
                 /* we are the only ones supposed to touch this variable,
@@ -17,6 +17,7 @@
 #include <stdbool.h>
 
 #include "byteorder.h"
+#include "mutex.h"
 #include "net/ipv6/ext/frag.h"
 #include "net/ipv6/addr.h"
 #include "net/ipv6/hdr.h"
@@ -36,11 +37,17 @@
 
 static gnrc_ipv6_ext_frag_send_t _snd_bufs[CONFIG_GNRC_IPV6_EXT_FRAG_SEND_SIZE];
 static gnrc_ipv6_ext_frag_rbuf_t _rbuf[CONFIG_GNRC_IPV6_EXT_FRAG_RBUF_SIZE];
+static gnrc_ipv6_ext_frag_rbuf_t *_rbuf_buckets[CONFIG_GNRC_IPV6_EXT_FRAG_RBUF_BUCKETS];
+static gnrc_ipv6_ext_frag_rbuf_t *_rbuf_free;
+/* payload bytes held by all reassembly buffer entries */
+static size_t _rbuf_held;
 static gnrc_ipv6_ext_frag_limits_t _limits_pool[CONFIG_GNRC_IPV6_EXT_FRAG_LIMITS_POOL_SIZE];
 static clist_node_t _free_limits;
 static xtimer_t _gc_xtimer;
 static msg_t _gc_msg = { .type = GNRC_IPV6_EXT_FRAG_RBUF_GC };
 static gnrc_ipv6_ext_frag_stats_t _stats;
+/* reassembly may happen in several threads with gnrc_ipv6_workers */
+static mutex_t _rbuf_mutex = MUTEX_INIT;
 
 /**
  * @todo    Implement better mechanism as described in
@@ -56,12 +63,23 @@ typedef enum {
     FRAG_LIMITS_FULL,           /**< no free gnrc_ipv6_ext_frag_limits_t object */
 } _limits_res_t;
 
+static_assert(CONFIG_GNRC_IPV6_EXT_FRAG_RBUF_BUCKETS <= (UINT8_MAX + 1),
+              "CONFIG_GNRC_IPV6_EXT_FRAG_RBUF_BUCKETS must be at most 256");
+
 void gnrc_ipv6_ext_frag_init(void)
 {
 #ifdef TEST_SUITES
     memset(_rbuf, 0, sizeof(_rbuf));
+    memset(_rbuf_buckets, 0, sizeof(_rbuf_buckets));
+    _free_limits.next = NULL;
+    _rbuf_held = 0;
 #endif
     _last_id = random_uint32();
+    _rbuf_free = NULL;
+    for (unsigned i = 0; i < CONFIG_GNRC_IPV6_EXT_FRAG_RBUF_SIZE; i++) {
+        _rbuf[i].next = _rbuf_free;
+        _rbuf_free = &_rbuf[i];
+    }
     for (unsigned i = 0; i < CONFIG_GNRC_IPV6_EXT_FRAG_LIMITS_POOL_SIZE; i++) {
         clist_rpush(&_free_limits, (clist_node_t *)&_limits_pool[i]);
     }
@@ -372,11 +390,26 @@ static inline void _init_rbuf(gnrc_ipv6_ext_frag_rbuf_t *rbuf, ipv6_hdr_t *ipv6,
  * @param[in, out] rbuf A reassembly buffer entry.
  * @param[in] offset    A fragment offset.
  * @param[in] pkt_len   The length of the packet.
+ * @param[out] limits_out   The new limits on FRAG_LIMITS_NEW.
  *
  * @return  see _limits_res_t.
  */
 static _limits_res_t _overlaps(gnrc_ipv6_ext_frag_rbuf_t *rbuf,
-                               unsigned offset, unsigned pkt_len);
+                               unsigned offset, unsigned pkt_len,
+                               gnrc_ipv6_ext_frag_limits_t **limits_out);
+
+/**
+ * @brief   Checks if the fragments from the source of a given IPv6 header
+ *          may occupy more bytes in the reassembly buffer
+ *
+ * @param[in] ipv6  The IPv6 header of a fragment.
+ * @param[in] size  The payload length of the fragment.
+ *
+ * @return  true, if the fragment does not exceed
+ *          @ref CONFIG_GNRC_IPV6_EXT_FRAG_RBUF_SRC_MAX.
+ * @return  false, otherwise.
+ */
+static bool _src_admit(const ipv6_hdr_t *ipv6, size_t size);
 
 /**
  * @brief   Sets the next header field of a header.
@@ -388,6 +421,17 @@ static _limits_res_t _overlaps(gnrc_ipv6_ext_frag_rbuf_t *rbuf,
  */
 static inline void _set_nh(gnrc_pktsnip_t *hdr_snip, uint8_t nh);
 
+/**
+ * @brief   Gathers the payloads of all fragments of a complete datagram
+ *
+ * @param[in] rbuf      A reassembly buffer entry with all fragments.
+ *
+ * @return  The payload of the datagram, followed by
+ *          gnrc_ipv6_ext_frag_rbuf_t::pkt of @p rbuf.
+ * @return  NULL, if the packet buffer is full.
+ */
+static gnrc_pktsnip_t *_gather(gnrc_ipv6_ext_frag_rbuf_t *rbuf);
+
 /**
  * @brief   Checks if a fragmented packet is completely reassembled.
  *
@@ -398,10 +442,21 @@ static inline void _set_nh(gnrc_pktsnip_t *hdr_snip, uint8_t nh);
  */
 static gnrc_pktsnip_t *_completed(gnrc_ipv6_ext_frag_rbuf_t *rbuf);
 
+static gnrc_pktsnip_t *_reass(gnrc_pktsnip_t *pkt);
+
 gnrc_pktsnip_t *gnrc_ipv6_ext_frag_reass(gnrc_pktsnip_t *pkt)
+{
+    mutex_lock(&_rbuf_mutex);
+    pkt = _reass(pkt);
+    mutex_unlock(&_rbuf_mutex);
+    return pkt;
+}
+
+static gnrc_pktsnip_t *_reass(gnrc_pktsnip_t *pkt)
 {
     gnrc_ipv6_ext_frag_rbuf_t *rbuf;
-    gnrc_pktsnip_t *fh_snip, *ipv6_snip;
+    gnrc_ipv6_ext_frag_limits_t *limits = NULL;
+    gnrc_pktsnip_t *fh_snip, *ipv6_snip, *hdrs;
     ipv6_hdr_t *ipv6;
     ipv6_ext_frag_t *fh;
     unsigned offset;
@@ -418,6 +473,31 @@ gnrc_pktsnip_t *gnrc_ipv6_ext_frag_reass(gnrc_pktsnip_t *pkt)
     ipv6_snip = gnrc_pktsnip_search_type(pkt, GNRC_NETTYPE_IPV6);
     assert(ipv6_snip != NULL);
     ipv6 = ipv6_snip->data;
+    nh = fh->nh;
+    offset = ipv6_ext_frag_get_offset(fh);
+    if ((offset == 0) && !ipv6_ext_frag_more(fh)) {
+        /* first fragment but actually not fragmented: processed in isolation
+         * of any other fragments (RFC 6946), so it does not use the
+         * reassembly buffer */
+        _set_nh(fh_snip->next, nh);
+        gnrc_pktbuf_remove_snip(pkt, fh_snip);
+        ipv6->len = byteorder_htons(byteorder_ntohs(ipv6->len) -
+                                    sizeof(ipv6_ext_frag_t));
+        if (IS_USED(MODULE_GNRC_IPV6_EXT_FRAG_STATS)) {
+            _stats.fragments++;
+            _stats.datagrams++;
+        }
+        return pkt;
+    }
+    /* check before getting an entry, so a flooding source can not cause other
+     * entries to be overridden */
+    if (!_src_admit(ipv6, pkt->size)) {
+        DEBUG("ipv6_ext_frag: source exceeds its share of reassembly buffer\n");
+        if (IS_USED(MODULE_GNRC_IPV6_EXT_FRAG_STATS)) {
+            _stats.src_full++;
+        }
+        goto error_release;
+    }
     rbuf = gnrc_ipv6_ext_frag_rbuf_get(ipv6, byteorder_ntohl(fh->id));
     if (rbuf == NULL) {
         DEBUG("ipv6_ext_frag: reassembly buffer full\n");
@@ -426,115 +506,64 @@ gnrc_pktsnip_t *gnrc_ipv6_ext_frag_reass(gnrc_pktsnip_t *pkt)
     rbuf->arrival = xtimer_now_usec();
     xtimer_set_msg(&_gc_xtimer, CONFIG_GNRC_IPV6_EXT_FRAG_RBUF_TIMEOUT_US, &_gc_msg,
                    sched_active_pid);
-    nh = fh->nh;
-    offset = ipv6_ext_frag_get_offset(fh);
-    switch (_overlaps(rbuf, offset, pkt->size)) {
+    switch (_overlaps(rbuf, offset, pkt->size, &limits)) {
         case FRAG_LIMITS_NEW:
             break;
         case FRAG_LIMITS_DUPLICATE:
             gnrc_pktbuf_release(pkt);
             return NULL;
         case FRAG_LIMITS_OVERLAP:
+            /* RFC 8200, section 4.5: reassembly of the datagram must be
+             * abandoned */
             DEBUG("ipv6_ext_frag: fragment overlaps with existing fragments\n");
-            /* intentionally falls through */
+            if (IS_USED(MODULE_GNRC_IPV6_EXT_FRAG_STATS)) {
+                _stats.overlaps++;
+            }
+            goto error_exit;
         case FRAG_LIMITS_FULL:
         default:
             DEBUG("ipv6_ext_frag: can't store fragment limits\n");
             goto error_exit;
     }
-    if (offset > 0) {
-        size_t size_until = offset + pkt->size;
-
-        /* use IPv6 header in reassembly buffer from here on */
-        ipv6 = rbuf->ipv6;
-        /* subsequent fragment */
-        if (!ipv6_ext_frag_more(fh)) {
-            /* last fragment; add to rbuf->pkt_len */
-            rbuf->last++;
-            rbuf->pkt_len += size_until;
-        }
+    if (ipv6_ext_frag_more(fh) && (pkt->size & 0x7)) {
         /* not divisible by 8 */
-        else if ((pkt->size & 0x7)) {
-            DEBUG("ipv6_ext_frag: fragment length not divisible by 8");
-            goto error_exit;
-        }
-        if (rbuf->pkt == NULL) {
-            /* entry did not exist yet */
-            rbuf->pkt = gnrc_pktbuf_add(fh_snip->next, NULL, size_until,
-                                        GNRC_NETTYPE_UNDEF);
-            if (rbuf->pkt == NULL) {
-                DEBUG("ipv6_ext_frag: unable to create space for reassembled "
-                      "packet\n");
-                goto error_exit;
-            }
-        }
-        else if (rbuf->pkt->size < size_until) {
-            /* entry exists already but doesn't fit full datagram yet */
-            if (gnrc_pktbuf_realloc_data(rbuf->pkt, size_until) != 0) {
-                DEBUG("ipv6_ext_frag: unable to allocate space for reassembled "
-                      "packet\n");
-                goto error_exit;
-            }
-        }
-        /* copy payload of fragment into reassembled datagram */
-        memcpy(((uint8_t *)rbuf->pkt->data) + offset, pkt->data, pkt->size);
-        /* if entry was newly created above */
-        if (rbuf->pkt->next == fh_snip->next) {
-            /* we don't need the payload and fragment header anymore, the
-             * remaining headers are still kept to be reused when assembled, so
-             * just remove the payload. */
-            gnrc_pktbuf_remove_snip(pkt, fh_snip);
-            gnrc_pktbuf_remove_snip(pkt, pkt);
-        }
-        else {
-            /* we don't need the rest anymore */
-            gnrc_pktbuf_release(pkt);
-        }
-        return _completed(rbuf);
-    }
-    else if (!ipv6_ext_frag_more(fh)) {
-        /* first fragment but actually not fragmented */
-        _set_nh(fh_snip->next, nh);
-        gnrc_pktbuf_remove_snip(pkt, fh_snip);
-        gnrc_ipv6_ext_frag_rbuf_del(rbuf);
-        ipv6->len = byteorder_htons(byteorder_ntohs(ipv6->len) -
-                                    sizeof(ipv6_ext_frag_t));
-        if (IS_USED(MODULE_GNRC_IPV6_EXT_FRAG_STATS)) {
-            _stats.fragments++;
-            _stats.datagrams++;
-        }
-        return pkt;
+        DEBUG("ipv6_ext_frag: fragment length not divisible by 8");
+        goto error_exit;
     }
-    else {
+    if (offset == 0) {
         /* first fragment */
         uint16_t ipv6_len = byteorder_ntohs(ipv6->len);
 
-        /* not divisible by 8*/
-        if ((pkt->size & 0x7)) {
-            DEBUG("ipv6_ext_frag: fragment length not divisible by 8");
-            goto error_exit;
-        }
         _set_nh(fh_snip->next, nh);
-        gnrc_pktbuf_remove_snip(pkt, fh_snip);
         /* TODO: RFC 8200 says "- 8"; determine if `sizeof(ipv6_ext_frag_t)` is
          * really needed*/
         rbuf->pkt_len += ipv6_len - pkt->size - sizeof(ipv6_ext_frag_t);
-        if (rbuf->pkt != NULL) {
-            /* first fragment but not first arriving */
-            memcpy(rbuf->pkt->data, pkt->data, pkt->size);
-            rbuf->pkt->next = pkt->next;
-            rbuf->pkt->type = pkt->type;
-            /* payload was copied to reassembly buffer so remove it */
-            gnrc_pktbuf_remove_snip(pkt, pkt);
-            rbuf->ipv6 = ipv6;
-            return _completed(rbuf);
-        }
-        else {
-            /* first fragment but first arriving */
-            rbuf->pkt = pkt;
-        }
     }
-    return NULL;
+    else if (!ipv6_ext_frag_more(fh)) {
+        /* last fragment; add to rbuf->pkt_len */
+        rbuf->last++;
+        rbuf->pkt_len += offset + pkt->size;
+    }
+    /* split fragment into payload and headers and drop the fragment header */
+    hdrs = fh_snip->next;
+    pkt->next = NULL;
+    fh_snip->next = NULL;
+    gnrc_pktbuf_release(fh_snip);
+    if ((offset == 0) || (rbuf->pkt == NULL)) {
+        /* headers of the first fragment are used for the reassembled
+         * datagram; until it arrives use the ones of the first arriving */
+        gnrc_pktbuf_release(rbuf->pkt);
+        rbuf->pkt = hdrs;
+        rbuf->ipv6 = ipv6;
+    }
+    else {
+        gnrc_pktbuf_release(hdrs);
+    }
+    /* keep payload in place until all fragments arrived */
+    limits->pkt = pkt;
+    rbuf->held += pkt->size;
+    _rbuf_held += pkt->size;
+    return _completed(rbuf);
 error_exit:
     gnrc_ipv6_ext_frag_rbuf_del(rbuf);
 error_release:
@@ -542,65 +571,102 @@ error_release:
     return NULL;
 }
 
+static unsigned _rbuf_bucket(const ipv6_hdr_t *ipv6, uint32_t id)
+{
+    uint32_t hash = id;
+
+    for (unsigned i = 0; i < ARRAY_SIZE(ipv6->src.u32); i++) {
+        hash ^= ipv6->src.u32[i].u32 ^ ipv6->dst.u32[i].u32;
+    }
+    hash ^= (hash >> 16);
+    hash ^= (hash >> 8);
+    return hash % CONFIG_GNRC_IPV6_EXT_FRAG_RBUF_BUCKETS;
+}
+
 gnrc_ipv6_ext_frag_rbuf_t *gnrc_ipv6_ext_frag_rbuf_get(ipv6_hdr_t *ipv6,
                                                        uint32_t id)
 {
-    gnrc_ipv6_ext_frag_rbuf_t *res = NULL, *oldest = NULL;
-    for (unsigned i = 0; i < CONFIG_GNRC_IPV6_EXT_FRAG_RBUF_SIZE; i++) {
-        gnrc_ipv6_ext_frag_rbuf_t *tmp = &_rbuf[i];
-        if (tmp->ipv6 != NULL) {
-            if ((tmp->id == id) &&
-                ipv6_addr_equal(&tmp->ipv6->src, &ipv6->src) &&
-                ipv6_addr_equal(&tmp->ipv6->dst, &ipv6->dst)) {
-                return tmp;
-            }
-        }
-        else if (res == NULL) {
-            res = tmp;
-            _init_rbuf(res, ipv6, id);
-        }
-        if ((oldest == NULL) ||
-            /* xtimer_now_usec() overflows every ~1.2 hours */
-            ((tmp->arrival - oldest->arrival) < (UINT32_MAX / 2))) {
-            oldest = tmp;
+    gnrc_ipv6_ext_frag_rbuf_t *res;
+    unsigned bucket = _rbuf_bucket(ipv6, id);
+
+    for (res = _rbuf_buckets[bucket]; res != NULL; res = res->next) {
+        if ((res->id == id) &&
+            ipv6_addr_equal(&res->ipv6->src, &ipv6->src) &&
+            ipv6_addr_equal(&res->ipv6->dst, &ipv6->dst)) {
+            return res;
         }
     }
-    if ((res == NULL) &&
+    if ((_rbuf_free == NULL) &&
         !IS_ACTIVE(CONFIG_GNRC_IPV6_EXT_FRAG_RBUF_DO_NOT_OVERRIDE)) {
-        assert(oldest != NULL); /* reassembly buffer is full, so there needs
-                                 * to be an oldest entry */
+        gnrc_ipv6_ext_frag_rbuf_t *oldest = &_rbuf[0];
+
+        /* reassembly buffer is full, so all entries are in use */
+        for (unsigned i = 1; i < CONFIG_GNRC_IPV6_EXT_FRAG_RBUF_SIZE; i++) {
+            /* xtimer_now_usec() overflows every ~1.2 hours */
+            if ((_rbuf[i].arrival - oldest->arrival) > (UINT32_MAX / 2)) {
+                oldest = &_rbuf[i];
+            }
+        }
         DEBUG("ipv6_ext_frag: dropping oldest entry\n");
         if (IS_USED(MODULE_GNRC_IPV6_EXT_FRAG_STATS)) {
             _stats.rbuf_full++;
         }
         gnrc_ipv6_ext_frag_rbuf_del(oldest);
-        res = oldest;
-        _init_rbuf(res, ipv6, id);
     }
-    else if (IS_USED(MODULE_GNRC_IPV6_EXT_FRAG_STATS) && (res == NULL)) {
-        _stats.rbuf_full++;
+    res = _rbuf_free;
+    if (res == NULL) {
+        if (IS_USED(MODULE_GNRC_IPV6_EXT_FRAG_STATS)) {
+            _stats.rbuf_full++;
+        }
+        return NULL;
     }
+    _rbuf_free = res->next;
+    _init_rbuf(res, ipv6, id);
+    res->bucket = bucket;
+    res->next = _rbuf_buckets[bucket];
+    _rbuf_buckets[bucket] = res;
     return res;
 }
 
 void gnrc_ipv6_ext_frag_rbuf_free(gnrc_ipv6_ext_frag_rbuf_t *rbuf)
 {
+    if (rbuf->ipv6 != NULL) {
+        gnrc_ipv6_ext_frag_rbuf_t **ptr = &_rbuf_buckets[rbuf->bucket];
+
+        while (*ptr != rbuf) {
+            assert(*ptr != NULL);
+            ptr = &(*ptr)->next;
+        }
+        *ptr = rbuf->next;
+        rbuf->next = _rbuf_free;
+        _rbuf_free = rbuf;
+    }
     rbuf->ipv6 = NULL;
+    _rbuf_held -= rbuf->held;
+    rbuf->held = 0;
     while (rbuf->limits.next != NULL) {
-        clist_node_t *tmp = clist_lpop(&rbuf->limits);
-        clist_rpush(&_free_limits, tmp);
+        gnrc_ipv6_ext_frag_limits_t *tmp =
+            (gnrc_ipv6_ext_frag_limits_t *)clist_lpop(&rbuf->limits);
+
+        gnrc_pktbuf_release(tmp->pkt);
+        tmp->pkt = NULL;
+        clist_rpush(&_free_limits, (clist_node_t *)tmp);
     }
 }
 
 void gnrc_ipv6_ext_frag_rbuf_gc(void)
 {
     uint32_t now = xtimer_now_usec();
+
+    mutex_lock(&_rbuf_mutex);
     for (unsigned i = 0; i < CONFIG_GNRC_IPV6_EXT_FRAG_RBUF_SIZE; i++) {
         gnrc_ipv6_ext_frag_rbuf_t *rbuf = &_rbuf[i];
-        if ((now - rbuf->arrival) > CONFIG_GNRC_IPV6_EXT_FRAG_RBUF_TIMEOUT_US) {
+        if ((rbuf->ipv6 != NULL) &&
+            ((now - rbuf->arrival) > CONFIG_GNRC_IPV6_EXT_FRAG_RBUF_TIMEOUT_US)) {
             gnrc_ipv6_ext_frag_rbuf_del(rbuf);
         }
     }
+    mutex_unlock(&_rbuf_mutex);
 }
 
 gnrc_ipv6_ext_frag_stats_t *gnrc_ipv6_ext_frag_stats(void)
@@ -619,9 +685,28 @@ static inline void _init_rbuf(gnrc_ipv6_ext_frag_rbuf_t *rbuf, ipv6_hdr_t *ipv6,
     rbuf->ipv6 = ipv6;
     rbuf->id = id;
     rbuf->pkt_len = 0;
+    rbuf->held = 0;
     rbuf->last = 0;
 }
 
+static bool _src_admit(const ipv6_hdr_t *ipv6, size_t size)
+{
+    size_t held = 0;
+
+    if ((CONFIG_GNRC_IPV6_EXT_FRAG_RBUF_SRC_MAX == 0) ||
+        ((_rbuf_held + size) <= CONFIG_GNRC_IPV6_EXT_FRAG_RBUF_SRC_MAX)) {
+        /* fast path: even all sources together stay below the limit */
+        return true;
+    }
+    for (unsigned i = 0; i < CONFIG_GNRC_IPV6_EXT_FRAG_RBUF_SIZE; i++) {
+        if ((_rbuf[i].ipv6 != NULL) &&
+            ipv6_addr_equal(&_rbuf[i].ipv6->src, &ipv6->src)) {
+            held += _rbuf[i].held;
+        }
+    }
+    return ((held + size) <= CONFIG_GNRC_IPV6_EXT_FRAG_RBUF_SRC_MAX);
+}
+
 static int _check_overlap(clist_node_t *node, void *arg)
 {
     _check_limits_t *limits = arg;
@@ -639,7 +724,8 @@ static int _limits_cmp(clist_node_t *a, clist_node_t *b)
 }
 
 static _limits_res_t _overlaps(gnrc_ipv6_ext_frag_rbuf_t *rbuf,
-                               unsigned offset, unsigned pkt_len)
+                               unsigned offset, unsigned pkt_len,
+                               gnrc_ipv6_ext_frag_limits_t **limits_out)
 {
     _check_limits_t limits = { .start = offset >> 3U,
                                .end = (offset + pkt_len) >> 3U };
@@ -655,10 +741,12 @@ static _limits_res_t _overlaps(gnrc_ipv6_ext_frag_rbuf_t *rbuf,
     if (res == NULL) {
         res = (gnrc_ipv6_ext_frag_limits_t *)clist_lpop(&_free_limits);
         if (res != NULL) {
+            res->pkt = NULL;
             res->start = limits.start;
             res->end = limits.end;
             clist_rpush(&rbuf->limits, (clist_node_t *)res);
             clist_sort(&rbuf->limits, _limits_cmp);
+            *limits_out = res;
             return FRAG_LIMITS_NEW;
         }
         else {
@@ -669,7 +757,7 @@ static _limits_res_t _overlaps(gnrc_ipv6_ext_frag_rbuf_t *rbuf,
         return FRAG_LIMITS_DUPLICATE;
     }
     else {
-        return FRAG_LIMITS_NEW;
+        return FRAG_LIMITS_OVERLAP;
     }
 }
 
@@ -693,6 +781,33 @@ static inline void _set_nh(gnrc_pktsnip_t *hdr_snip, uint8_t nh)
     }
 }
 
+static gnrc_pktsnip_t *_gather(gnrc_ipv6_ext_frag_rbuf_t *rbuf)
+{
+    gnrc_ipv6_ext_frag_limits_t *first =
+            (gnrc_ipv6_ext_frag_limits_t *)rbuf->limits.next->next;
+    gnrc_ipv6_ext_frag_limits_t *ptr = first;
+    gnrc_pktsnip_t *payload = first->pkt;
+
+    /* chain the payloads in offset order, so they form an iolist, and take
+     * them over from the limits */
+    do {
+        gnrc_ipv6_ext_frag_limits_t *next = ptr->next;
+
+        ptr->pkt->next = (next != first) ? next->pkt : NULL;
+        ptr->pkt = NULL;
+        ptr = next;
+    } while (ptr != first);
+    _rbuf_held -= rbuf->held;
+    rbuf->held = 0;
+    /* copy payloads into one snip (in place if the first one can grow) */
+    if (gnrc_pktbuf_merge(payload) != 0) {
+        gnrc_pktbuf_release(payload);
+        return NULL;
+    }
+    payload->next = rbuf->pkt;
+    return payload;
+}
+
 static gnrc_pktsnip_t *_completed(gnrc_ipv6_ext_frag_rbuf_t *rbuf)
 {
     assert(rbuf->limits.next != NULL);    /* this function is only called when
@@ -713,7 +828,13 @@ static gnrc_pktsnip_t *_completed(gnrc_ipv6_ext_frag_rbuf_t *rbuf)
             }
             ptr = next;
         } while (((clist_node_t *)ptr) != rbuf->limits.next);
-        res = rbuf->pkt;
+        res = _gather(rbuf);
+        if (res == NULL) {
+            DEBUG("ipv6_ext_frag: unable to allocate space for reassembled "
+                  "packet\n");
+            gnrc_ipv6_ext_frag_rbuf_del(rbuf);
+            return NULL;
+        }
         /* rewrite length */
         rbuf->ipv6->len = byteorder_htons(rbuf->pkt_len);
         rbuf->pkt = NULL;
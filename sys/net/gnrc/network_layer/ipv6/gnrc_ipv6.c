@@ -68,6 +68,22 @@ static char addr_str[IPV6_ADDR_MAX_STR_LEN];
 
 kernel_pid_t gnrc_ipv6_pid = KERNEL_PID_UNDEF;
 
+#ifdef MODULE_GNRC_IPV6_WORKERS
+static char _worker_stacks[CONFIG_GNRC_IPV6_WORKERS_NUMOF]
+                          [GNRC_IPV6_WORKERS_STACK_SIZE];
+static kernel_pid_t _worker_pids[CONFIG_GNRC_IPV6_WORKERS_NUMOF];
+
+/* Message type for packets the workers hand to the IPv6 thread for
+ * forwarding. Unlike GNRC_NETAPI_MSG_TYPE_SND, their IPv6 header is already
+ * complete and must not be filled in again. */
+#define GNRC_IPV6_WORKERS_FWD       (0xfe10U)
+
+/* Event loop of the receive workers */
+static void *_worker_loop(void *args);
+/* Hands packets registered for IPv6 to the worker or the IPv6 thread */
+static void _dispatch_to_worker(uint16_t cmd, gnrc_pktsnip_t *pkt, void *ctx);
+#endif  /* MODULE_GNRC_IPV6_WORKERS */
+
 /* handles GNRC_NETAPI_MSG_TYPE_RCV commands */
 static void _receive(gnrc_pktsnip_t *pkt);
 /* Sends packet over the appropriate interface(s).
@@ -87,6 +103,15 @@ kernel_pid_t gnrc_ipv6_init(void)
         gnrc_ipv6_pid = thread_create(_stack, sizeof(_stack), GNRC_IPV6_PRIO,
                                       THREAD_CREATE_STACKTEST,
                                       _event_loop, NULL, "ipv6");
+#ifdef MODULE_GNRC_IPV6_WORKERS
+        for (unsigned i = 0; i < CONFIG_GNRC_IPV6_WORKERS_NUMOF; i++) {
+            _worker_pids[i] = thread_create(_worker_stacks[i],
+                                            sizeof(_worker_stacks[i]),
+                                            GNRC_IPV6_PRIO,
+                                            THREAD_CREATE_STACKTEST,
+                                            _worker_loop, NULL, "ipv6_worker");
+        }
+#endif  /* MODULE_GNRC_IPV6_WORKERS */
     }
 
 #ifdef MODULE_FIB
@@ -171,11 +196,116 @@ static void _dispatch_next_header(gnrc_pktsnip_t *pkt, unsigned nh,
     }
 }
 
+#ifdef MODULE_GNRC_IPV6_WORKERS
+static unsigned _worker_shard(gnrc_pktsnip_t *pkt)
+{
+    gnrc_pktsnip_t *netif_hdr;
+
+    if (IS_ACTIVE(CONFIG_GNRC_IPV6_WORKERS_SHARD_BY_FLOW) &&
+        (pkt->size >= sizeof(ipv6_hdr_t)) && ipv6_hdr_is(pkt->data)) {
+        const ipv6_hdr_t *hdr = pkt->data;
+        uint32_t hash = ipv6_hdr_get_fl(hdr);
+
+        for (unsigned i = 0; i < (sizeof(ipv6_addr_t) / sizeof(uint32_t)); i++) {
+            hash ^= hdr->src.u32[i].u32 ^ hdr->dst.u32[i].u32;
+        }
+        hash ^= (hash >> 16);
+        hash ^= (hash >> 8);
+        return hash % CONFIG_GNRC_IPV6_WORKERS_NUMOF;
+    }
+    netif_hdr = gnrc_pktsnip_search_type(pkt, GNRC_NETTYPE_NETIF);
+    if (netif_hdr != NULL) {
+        gnrc_netif_hdr_t *hdr = netif_hdr->data;
+        gnrc_netif_t *netif = NULL;
+        unsigned idx = 0;
+
+        /* shard by position in the interface list, not by PID: PIDs are
+         * arbitrary, so two interfaces might map to the same worker */
+        while ((netif = gnrc_netif_iter(netif)) != NULL) {
+            if (netif->pid == hdr->if_pid) {
+                return idx % CONFIG_GNRC_IPV6_WORKERS_NUMOF;
+            }
+            idx++;
+        }
+    }
+    return 0;
+}
+
+static void _dispatch_to_worker(uint16_t cmd, gnrc_pktsnip_t *pkt, void *ctx)
+{
+    kernel_pid_t target;
+    msg_t msg;
+
+    (void)ctx;
+    switch (cmd) {
+        case GNRC_NETAPI_MSG_TYPE_RCV:
+            /* same flow (or interface) => same worker, so packets of a flow
+             * are never reordered */
+            target = _worker_pids[_worker_shard(pkt)];
+            break;
+        case GNRC_NETAPI_MSG_TYPE_SND:
+            target = gnrc_ipv6_pid;
+            break;
+        default:
+            gnrc_pktbuf_release_error(pkt, ECANCELED);
+            return;
+    }
+    msg.type = cmd;
+    msg.content.ptr = pkt;
+    if (msg_try_send(&msg, target) < 1) {
+        DEBUG("ipv6: dropping packet, queue of %" PRIkernel_pid " is full\n",
+              target);
+        gnrc_pktbuf_release_error(pkt, EIO);
+    }
+}
+
+static void *_worker_loop(void *args)
+{
+    msg_t msg, msg_q[GNRC_IPV6_MSG_QUEUE_SIZE];
+
+    (void)args;
+    msg_init_queue(msg_q, GNRC_IPV6_MSG_QUEUE_SIZE);
+
+    while (1) {
+        msg_receive(&msg);
+
+        switch (msg.type) {
+            case GNRC_NETAPI_MSG_TYPE_RCV:
+                DEBUG("ipv6 worker: GNRC_NETAPI_MSG_TYPE_RCV received\n");
+                _receive(msg.content.ptr);
+                /* let the other workers run, so a burst on one interface
+                 * does not delay the packets of another */
+                thread_yield();
+                break;
+#ifdef MODULE_GNRC_IPV6_EXT_FRAG
+            /* garbage collection timer is set by the thread that reassembles */
+            case GNRC_IPV6_EXT_FRAG_RBUF_GC:
+                gnrc_ipv6_ext_frag_rbuf_gc();
+                break;
+#endif  /* MODULE_GNRC_IPV6_EXT_FRAG */
+            default:
+                break;
+        }
+    }
+
+    return NULL;
+}
+#endif  /* MODULE_GNRC_IPV6_WORKERS */
+
 static void *_event_loop(void *args)
 {
     msg_t msg, reply, msg_q[GNRC_IPV6_MSG_QUEUE_SIZE];
+#ifdef MODULE_GNRC_IPV6_WORKERS
+    static gnrc_netreg_entry_cbd_t me_cbd = {
+        .cb = _dispatch_to_worker,
+        .ctx = NULL,
+    };
+    gnrc_netreg_entry_t me_reg = GNRC_NETREG_ENTRY_INIT_CB(GNRC_NETREG_DEMUX_CTX_ALL,
+                                                           &me_cbd);
+#else   /* MODULE_GNRC_IPV6_WORKERS */
     gnrc_netreg_entry_t me_reg = GNRC_NETREG_ENTRY_INIT_PID(GNRC_NETREG_DEMUX_CTX_ALL,
                                                             sched_active_pid);
+#endif  /* MODULE_GNRC_IPV6_WORKERS */
 
     (void)args;
     msg_init_queue(msg_q, GNRC_IPV6_MSG_QUEUE_SIZE);
@@ -206,6 +336,13 @@ static void *_event_loop(void *args)
                 _send(msg.content.ptr, true);
                 break;
 
+#ifdef MODULE_GNRC_IPV6_WORKERS
+            case GNRC_IPV6_WORKERS_FWD:
+                DEBUG("ipv6: forward packet received by worker\n");
+                _send(msg.content.ptr, false);
+                break;
+#endif  /* MODULE_GNRC_IPV6_WORKERS */
+
             case GNRC_NETAPI_MSG_TYPE_GET:
             case GNRC_NETAPI_MSG_TYPE_SET:
                 DEBUG("ipv6: reply to unsupported get/set\n");
@@ -872,6 +1009,21 @@ static void _receive(gnrc_pktsnip_t *pkt)
             }
             pkt = gnrc_pktbuf_reverse_snips(pkt);
             if (pkt != NULL) {
+#ifdef MODULE_GNRC_IPV6_WORKERS
+                /* only the IPv6 thread sends, so interface statistics, NIB
+                 * and fragmentation state are not touched by the workers */
+                if (thread_getpid() != gnrc_ipv6_pid) {
+                    msg_t msg = { .type = GNRC_IPV6_WORKERS_FWD,
+                                  .content = { .ptr = pkt } };
+
+                    if (msg_try_send(&msg, gnrc_ipv6_pid) < 1) {
+                        DEBUG("ipv6: dropping forwarded packet, queue of "
+                              "IPv6 thread is full\n");
+                        gnrc_pktbuf_release_error(pkt, EIO);
+                    }
+                    return;
+                }
+#endif  /* MODULE_GNRC_IPV6_WORKERS */
                 _send(pkt, false);
             }
             else {
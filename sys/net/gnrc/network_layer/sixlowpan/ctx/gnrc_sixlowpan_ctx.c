@@ -12,6 +12,7 @@
  * @file
  */
 
+#include <stdatomic.h>
 #include <stdbool.h>
 #include <inttypes.h>
 
@@ -25,6 +26,8 @@
 static gnrc_sixlowpan_ctx_t _ctxs[GNRC_SIXLOWPAN_CTX_SIZE];
 static uint32_t _ctx_inval_times[GNRC_SIXLOWPAN_CTX_SIZE];
 static mutex_t _ctx_mutex = MUTEX_INIT;
+/* also changed from interrupt context by gnrc_sixlowpan_ctx_remove() */
+static atomic_uint _ctx_gen;
 
 static uint32_t _current_minute(void);
 static void _update_lifetime(uint8_t id);
@@ -124,11 +127,27 @@ gnrc_sixlowpan_ctx_t *gnrc_sixlowpan_ctx_update(uint8_t id, const ipv6_addr_t *p
           id, ipv6_addr_to_str(ipv6str, &_ctxs[id].prefix, sizeof(ipv6str)),
           _ctxs[id].prefix_len, _ctxs[id].ltime);
     _ctx_inval_times[id] = ltime + _current_minute();
+    atomic_fetch_add(&_ctx_gen, 1);
 
     mutex_unlock(&_ctx_mutex);
     return &(_ctxs[id]);
 }
 
+void gnrc_sixlowpan_ctx_remove(uint8_t id)
+{
+    if (id >= GNRC_SIXLOWPAN_CTX_SIZE) {
+        return;
+    }
+    /* don't lock _ctx_mutex, this might be called from interrupt context */
+    _ctxs[id].prefix_len = 0;
+    atomic_fetch_add(&_ctx_gen, 1);
+}
+
+unsigned gnrc_sixlowpan_ctx_generation(void)
+{
+    return atomic_load(&_ctx_gen);
+}
+
 static uint32_t _current_minute(void)
 {
     return xtimer_now_usec() / (US_PER_SEC * 60);
@@ -161,6 +180,7 @@ static void _update_lifetime(uint8_t id)
 void gnrc_sixlowpan_ctx_reset(void)
 {
     memset(_ctxs, 0, sizeof(_ctxs));
+    atomic_fetch_add(&_ctx_gen, 1);
 }
 #endif
 
@@ -35,6 +35,11 @@
 #include "net/gnrc/nettype.h"
 #include "net/gnrc/udp.h"
 #include "od.h"
+#ifdef MODULE_GNRC_SIXLOWPAN_IPHC_CACHE
+#include <stdatomic.h>
+
+#include "xtimer.h"
+#endif  /* MODULE_GNRC_SIXLOWPAN_IPHC_CACHE */
 
 #include "net/gnrc/sixlowpan/iphc.h"
 
@@ -115,9 +120,9 @@
 static char addr_str[IPV6_ADDR_MAX_STR_LEN];
 #endif  /* MODULE_GNRC_SIXLOWPAN_FRAG_VRB */
 
-static inline bool _context_overlaps_iid(gnrc_sixlowpan_ctx_t *ctx,
-                                         ipv6_addr_t *addr,
-                                         eui64_t *iid)
+static inline bool _context_overlaps_iid(const gnrc_sixlowpan_ctx_t *ctx,
+                                         const ipv6_addr_t *addr,
+                                         const eui64_t *iid)
 {
     uint8_t byte_mask[] = {0xff, 0x7f, 0x3f, 0x1f, 0x0f, 0x07, 0x03, 0x01};
 
@@ -958,21 +963,150 @@ static inline bool _compressible_nh(uint8_t nh)
     }
 }
 
-static size_t _iphc_ipv6_encode(gnrc_pktsnip_t *pkt,
-                                const gnrc_netif_hdr_t *netif_hdr,
-                                gnrc_netif_t *iface,
-                                uint8_t *iphc_hdr)
+/**
+ * @brief   Compressed form of the source and destination address of an IPv6
+ *          header
+ *
+ * This only depends on the addresses, the link-layer addresses, and the
+ * context buffer, but not on any other field of the IPv6 header, so it can
+ * be reused for all packets of a flow.
+ */
+typedef struct {
+    uint8_t iphc2;      /**< SAC, SAM, M, DAC, and DAM bits of 2nd IPHC byte */
+    uint8_t cid_ext;    /**< Context identifier extension (0 if not needed) */
+    uint8_t inline_len; /**< Number of bytes in _iphc_addrs_t::inline_addrs */
+    /**
+     * @brief   Inline parts of source and destination address
+     */
+    uint8_t inline_addrs[2 * sizeof(ipv6_addr_t)];
+} _iphc_addrs_t;
+
+#ifdef MODULE_GNRC_SIXLOWPAN_IPHC_CACHE
+/**
+ * @brief   Entry in the compression cache
+ */
+typedef struct {
+    gnrc_netif_t *netif;        /**< interface the flow is sent over */
+    ipv6_addr_t src;            /**< source address of the flow */
+    ipv6_addr_t dst;            /**< destination address of the flow */
+    /**
+     * @brief   Link-layer address of @ref _iphc_cache_entry_t::netif the
+     *          entry was created with
+     */
+    uint8_t src_l2addr[GNRC_NETIF_L2ADDR_MAXLEN];
+    uint8_t dst_l2addr[GNRC_NETIF_L2ADDR_MAXLEN];   /**< destination link-layer address */
+    uint8_t dst_l2addr_len;     /**< length of _iphc_cache_entry_t::dst_l2addr */
+    unsigned ctx_gen;           /**< context buffer generation of the entry */
+    uint32_t ctx_minute;        /**< minute the used contexts were valid in */
+    _iphc_addrs_t addrs;        /**< the cached compressed addresses */
+} _iphc_cache_entry_t;
+
+/* The cache is only accessed by the 6LoWPAN thread, so no locking is needed.
+ * Other threads request a flush by incrementing _iphc_cache_flushes, the
+ * 6LoWPAN thread flushes the cache on its next lookup. */
+static _iphc_cache_entry_t _iphc_cache[CONFIG_GNRC_SIXLOWPAN_IPHC_CACHE_SIZE];
+static unsigned _iphc_cache_next;
+static atomic_uint _iphc_cache_flushes;
+static unsigned _iphc_cache_flushed;
+
+static inline uint32_t _current_minute(void)
+{
+    /* contexts are invalidated with minute granularity by the context buffer,
+     * so an entry using a context is valid for the rest of the minute it was
+     * created in */
+    return xtimer_now_usec() / (US_PER_SEC * 60);
+}
+
+static inline bool _iphc_addrs_use_ctx(const _iphc_addrs_t *addrs)
+{
+    return (addrs->iphc2 & (SIXLOWPAN_IPHC2_SAC | SIXLOWPAN_IPHC2_DAC));
+}
+
+static const _iphc_addrs_t *_iphc_cache_get(const ipv6_hdr_t *ipv6_hdr,
+                                            const gnrc_netif_hdr_t *netif_hdr,
+                                            const gnrc_netif_t *iface)
+{
+    const uint8_t *dst_l2addr = gnrc_netif_hdr_get_dst_addr(netif_hdr);
+    unsigned flushes = atomic_load(&_iphc_cache_flushes);
+
+    if (flushes != _iphc_cache_flushed) {
+        DEBUG("6lo iphc: flushing cache\n");
+        for (unsigned i = 0; i < CONFIG_GNRC_SIXLOWPAN_IPHC_CACHE_SIZE; i++) {
+            _iphc_cache[i].netif = NULL;
+        }
+        _iphc_cache_flushed = flushes;
+        return NULL;
+    }
+    for (unsigned i = 0; i < CONFIG_GNRC_SIXLOWPAN_IPHC_CACHE_SIZE; i++) {
+        _iphc_cache_entry_t *entry = &_iphc_cache[i];
+
+        if ((entry->netif == iface) &&
+            ipv6_addr_equal(&entry->src, &ipv6_hdr->src) &&
+            ipv6_addr_equal(&entry->dst, &ipv6_hdr->dst) &&
+            (entry->dst_l2addr_len == netif_hdr->dst_l2addr_len) &&
+            (memcmp(entry->dst_l2addr, dst_l2addr,
+                    netif_hdr->dst_l2addr_len) == 0) &&
+            (memcmp(entry->src_l2addr, iface->l2addr,
+                    iface->l2addr_len) == 0)) {
+            if ((entry->ctx_gen != gnrc_sixlowpan_ctx_generation()) ||
+                (_iphc_addrs_use_ctx(&entry->addrs) &&
+                 (entry->ctx_minute != _current_minute()))) {
+                DEBUG("6lo iphc: cache entry %u is stale\n", i);
+                entry->netif = NULL;
+                return NULL;
+            }
+            return &entry->addrs;
+        }
+    }
+    return NULL;
+}
+
+static void _iphc_cache_add(const ipv6_hdr_t *ipv6_hdr,
+                            const gnrc_netif_hdr_t *netif_hdr,
+                            gnrc_netif_t *iface,
+                            const _iphc_addrs_t *addrs, unsigned ctx_gen)
+{
+    _iphc_cache_entry_t *entry = &_iphc_cache[_iphc_cache_next];
+
+    if ((netif_hdr->dst_l2addr_len > sizeof(entry->dst_l2addr)) ||
+        (iface->l2addr_len > sizeof(entry->src_l2addr))) {
+        return;
+    }
+    /* replace entries round-robin */
+    _iphc_cache_next = (_iphc_cache_next + 1) %
+                       CONFIG_GNRC_SIXLOWPAN_IPHC_CACHE_SIZE;
+    entry->netif = iface;
+    entry->src = ipv6_hdr->src;
+    entry->dst = ipv6_hdr->dst;
+    memcpy(entry->src_l2addr, iface->l2addr, iface->l2addr_len);
+    memcpy(entry->dst_l2addr, gnrc_netif_hdr_get_dst_addr(netif_hdr),
+           netif_hdr->dst_l2addr_len);
+    entry->dst_l2addr_len = netif_hdr->dst_l2addr_len;
+    entry->ctx_gen = ctx_gen;
+    if (_iphc_addrs_use_ctx(addrs)) {
+        entry->ctx_minute = _current_minute();
+    }
+    entry->addrs = *addrs;
+}
+
+void gnrc_sixlowpan_iphc_cache_flush(void)
+{
+    atomic_fetch_add(&_iphc_cache_flushes, 1);
+}
+#endif  /* MODULE_GNRC_SIXLOWPAN_IPHC_CACHE */
+
+static bool _iphc_addrs_encode(const ipv6_hdr_t *ipv6_hdr,
+                               const gnrc_netif_hdr_t *netif_hdr,
+                               gnrc_netif_t *iface,
+                               _iphc_addrs_t *addrs)
 {
     gnrc_sixlowpan_ctx_t *src_ctx = NULL, *dst_ctx = NULL;
-    ipv6_hdr_t *ipv6_hdr = pkt->next->data;
+    uint8_t *inline_addrs = addrs->inline_addrs;
     bool addr_comp = false;
-    uint16_t inline_pos = SIXLOWPAN_IPHC_HDR_LEN;
-
-    assert(iface != NULL);
+    uint16_t inline_pos = 0;
 
-    /* set initial dispatch value*/
-    iphc_hdr[IPHC1_IDX] = SIXLOWPAN_IPHC1_DISP;
-    iphc_hdr[IPHC2_IDX] = 0;
+    addrs->iphc2 = 0;
+    addrs->cid_ext = 0;
 
     /* check for available contexts */
     if (!ipv6_addr_is_unspecified(&(ipv6_hdr->src))) {
@@ -993,89 +1127,16 @@ static size_t _iphc_ipv6_encode(gnrc_pktsnip_t *pkt,
         }
     }
 
-    /* if contexts available and both != 0 */
-    /* since this moves inline_pos we have to do this ahead*/
-    if (((src_ctx != NULL) &&
-            ((src_ctx->flags_id & GNRC_SIXLOWPAN_CTX_FLAGS_CID_MASK) != 0)) ||
-        ((dst_ctx != NULL) &&
-            ((dst_ctx->flags_id & GNRC_SIXLOWPAN_CTX_FLAGS_CID_MASK) != 0))) {
-        /* add context identifier extension */
-        iphc_hdr[IPHC2_IDX] |= SIXLOWPAN_IPHC2_CID_EXT;
-        iphc_hdr[CID_EXT_IDX] = 0;
-
-        /* move position to behind CID extension */
-        inline_pos += SIXLOWPAN_IPHC_CID_EXT_LEN;
-    }
-
-    /* compress flow label and traffic class */
-    if (ipv6_hdr_get_fl(ipv6_hdr) == 0) {
-        if (ipv6_hdr_get_tc(ipv6_hdr) == 0) {
-            /* elide both traffic class and flow label */
-            iphc_hdr[IPHC1_IDX] |= IPHC_TF_ECN_ELIDE;
-        }
-        else {
-            /* elide flow label, traffic class (ECN + DSCP) inline (1 byte) */
-            iphc_hdr[IPHC1_IDX] |= IPHC_TF_ECN_DSCP;
-            iphc_hdr[inline_pos++] = ipv6_hdr_get_tc(ipv6_hdr);
-        }
-    }
-    else {
-        if (ipv6_hdr_get_tc_dscp(ipv6_hdr) == 0) {
-            /* elide DSCP, ECN + 2-bit pad + flow label inline (3 byte) */
-            iphc_hdr[IPHC1_IDX] |= IPHC_TF_ECN_FL;
-            iphc_hdr[inline_pos++] = (uint8_t)((ipv6_hdr_get_tc_ecn(ipv6_hdr) << 6) |
-                                               ((ipv6_hdr_get_fl(ipv6_hdr) & 0x000f0000) >> 16));
-        }
-        else {
-            /* ECN + DSCP + 4-bit pad + flow label (4 bytes) */
-            iphc_hdr[IPHC1_IDX] |= IPHC_TF_ECN_DSCP_FL;
-            iphc_hdr[inline_pos++] = ipv6_hdr_get_tc(ipv6_hdr);
-            iphc_hdr[inline_pos++] = (uint8_t)((ipv6_hdr_get_fl(ipv6_hdr) & 0x000f0000) >> 16);
-        }
-
-        /* copy remaining byteos of flow label */
-        iphc_hdr[inline_pos++] = (uint8_t)((ipv6_hdr_get_fl(ipv6_hdr) & 0x0000ff00) >> 8);
-        iphc_hdr[inline_pos++] = (uint8_t)((ipv6_hdr_get_fl(ipv6_hdr) & 0x000000ff) >> 8);
-    }
-
-    /* check for compressible next header */
-    if (_compressible_nh(ipv6_hdr->nh)) {
-        iphc_hdr[IPHC1_IDX] |= SIXLOWPAN_IPHC1_NH;
-    }
-    else {
-        iphc_hdr[inline_pos++] = ipv6_hdr->nh;
-    }
-
-    /* compress hop limit */
-    switch (ipv6_hdr->hl) {
-        case 1:
-            iphc_hdr[IPHC1_IDX] |= IPHC_HL_1;
-            break;
-
-        case 64:
-            iphc_hdr[IPHC1_IDX] |= IPHC_HL_64;
-            break;
-
-        case 255:
-            iphc_hdr[IPHC1_IDX] |= IPHC_HL_255;
-            break;
-
-        default:
-            iphc_hdr[IPHC1_IDX] |= IPHC_HL_INLINE;
-            iphc_hdr[inline_pos++] = ipv6_hdr->hl;
-            break;
-    }
-
     if (ipv6_addr_is_unspecified(&(ipv6_hdr->src))) {
-        iphc_hdr[IPHC2_IDX] |= IPHC_SAC_SAM_UNSPEC;
+        addrs->iphc2 |= IPHC_SAC_SAM_UNSPEC;
     }
     else {
         if (src_ctx != NULL) {
             /* stateful source address compression */
-            iphc_hdr[IPHC2_IDX] |= SIXLOWPAN_IPHC2_SAC;
+            addrs->iphc2 |= SIXLOWPAN_IPHC2_SAC;
 
             if (((src_ctx->flags_id & GNRC_SIXLOWPAN_CTX_FLAGS_CID_MASK) != 0)) {
-                iphc_hdr[CID_EXT_IDX] |= ((src_ctx->flags_id & GNRC_SIXLOWPAN_CTX_FLAGS_CID_MASK) << 4);
+                addrs->cid_ext |= ((src_ctx->flags_id & GNRC_SIXLOWPAN_CTX_FLAGS_CID_MASK) << 4);
             }
         }
 
@@ -1087,28 +1148,28 @@ static size_t _iphc_ipv6_encode(gnrc_pktsnip_t *pkt,
             if (gnrc_netif_ipv6_get_iid(iface, &iid) < 0) {
                 DEBUG("6lo iphc: could not get interface's IID\n");
                 gnrc_netif_release(iface);
-                return 0;
+                return false;
             }
             gnrc_netif_release(iface);
 
             if ((ipv6_hdr->src.u64[1].u64 == iid.uint64.u64) ||
                 _context_overlaps_iid(src_ctx, &ipv6_hdr->src, &iid)) {
                 /* 0 bits. The address is derived from link-layer address */
-                iphc_hdr[IPHC2_IDX] |= IPHC_SAC_SAM_L2;
+                addrs->iphc2 |= IPHC_SAC_SAM_L2;
                 addr_comp = true;
             }
             else if ((byteorder_ntohl(ipv6_hdr->src.u32[2]) == 0x000000ff) &&
                      (byteorder_ntohs(ipv6_hdr->src.u16[6]) == 0xfe00)) {
                 /* 16 bits. The address is derived using 16 bits carried inline */
-                iphc_hdr[IPHC2_IDX] |= IPHC_SAC_SAM_16;
-                memcpy(iphc_hdr + inline_pos, ipv6_hdr->src.u16 + 7, 2);
+                addrs->iphc2 |= IPHC_SAC_SAM_16;
+                memcpy(inline_addrs + inline_pos, ipv6_hdr->src.u16 + 7, 2);
                 inline_pos += 2;
                 addr_comp = true;
             }
             else {
                 /* 64 bits. The address is derived using 64 bits carried inline */
-                iphc_hdr[IPHC2_IDX] |= IPHC_SAC_SAM_64;
-                memcpy(iphc_hdr + inline_pos, ipv6_hdr->src.u64 + 1, 8);
+                addrs->iphc2 |= IPHC_SAC_SAM_64;
+                memcpy(inline_addrs + inline_pos, ipv6_hdr->src.u64 + 1, 8);
                 inline_pos += 8;
                 addr_comp = true;
             }
@@ -1116,8 +1177,8 @@ static size_t _iphc_ipv6_encode(gnrc_pktsnip_t *pkt,
 
         if (!addr_comp) {
             /* full address is carried inline */
-            iphc_hdr[IPHC2_IDX] |= IPHC_SAC_SAM_FULL;
-            memcpy(iphc_hdr + inline_pos, &ipv6_hdr->src, 16);
+            addrs->iphc2 |= IPHC_SAC_SAM_FULL;
+            memcpy(inline_addrs + inline_pos, &ipv6_hdr->src, 16);
             inline_pos += 16;
         }
     }
@@ -1126,7 +1187,7 @@ static size_t _iphc_ipv6_encode(gnrc_pktsnip_t *pkt,
 
     /* M: Multicast compression */
     if (ipv6_addr_is_multicast(&(ipv6_hdr->dst))) {
-        iphc_hdr[IPHC2_IDX] |= SIXLOWPAN_IPHC2_M;
+        addrs->iphc2 |= SIXLOWPAN_IPHC2_M;
 
         /* if multicast address is of format ffXX::XXXX:XXXX:XXXX */
         if ((ipv6_hdr->dst.u16[1].u16 == 0) &&
@@ -1138,26 +1199,26 @@ static size_t _iphc_ipv6_encode(gnrc_pktsnip_t *pkt,
                 (ipv6_hdr->dst.u16[6].u16 == 0) &&
                 (ipv6_hdr->dst.u8[14] == 0)) {
                 /* 8 bits. The address is derived using 8 bits carried inline */
-                iphc_hdr[IPHC2_IDX] |= IPHC_M_DAC_DAM_M_8;
-                iphc_hdr[inline_pos++] = ipv6_hdr->dst.u8[15];
+                addrs->iphc2 |= IPHC_M_DAC_DAM_M_8;
+                inline_addrs[inline_pos++] = ipv6_hdr->dst.u8[15];
                 addr_comp = true;
             }
             /* if multicast address is of format ffXX::XX:XXXX */
             else if ((ipv6_hdr->dst.u16[5].u16 == 0) &&
                      (ipv6_hdr->dst.u8[12] == 0)) {
                 /* 32 bits. The address is derived using 32 bits carried inline */
-                iphc_hdr[IPHC2_IDX] |= IPHC_M_DAC_DAM_M_32;
-                iphc_hdr[inline_pos++] = ipv6_hdr->dst.u8[1];
-                memcpy(iphc_hdr + inline_pos, ipv6_hdr->dst.u8 + 13, 3);
+                addrs->iphc2 |= IPHC_M_DAC_DAM_M_32;
+                inline_addrs[inline_pos++] = ipv6_hdr->dst.u8[1];
+                memcpy(inline_addrs + inline_pos, ipv6_hdr->dst.u8 + 13, 3);
                 inline_pos += 3;
                 addr_comp = true;
             }
             /* if multicast address is of format ffXX::XX:XXXX:XXXX */
             else if (ipv6_hdr->dst.u8[10] == 0) {
                 /* 48 bits. The address is derived using 48 bits carried inline */
-                iphc_hdr[IPHC2_IDX] |= IPHC_M_DAC_DAM_M_48;
-                iphc_hdr[inline_pos++] = ipv6_hdr->dst.u8[1];
-                memcpy(iphc_hdr + inline_pos, ipv6_hdr->dst.u8 + 11, 5);
+                addrs->iphc2 |= IPHC_M_DAC_DAM_M_48;
+                inline_addrs[inline_pos++] = ipv6_hdr->dst.u8[1];
+                memcpy(inline_addrs + inline_pos, ipv6_hdr->dst.u8 + 11, 5);
                 inline_pos += 5;
                 addr_comp = true;
             }
@@ -1178,13 +1239,13 @@ static size_t _iphc_ipv6_encode(gnrc_pktsnip_t *pkt,
                 /* Unicast prefix based IPv6 multicast address
                  * (https://tools.ietf.org/html/rfc3306) with given context
                  * for unicast prefix -> context based compression */
-                iphc_hdr[IPHC2_IDX] |= SIXLOWPAN_IPHC2_DAC;
+                addrs->iphc2 |= SIXLOWPAN_IPHC2_DAC;
                 if ((ctx->flags_id & GNRC_SIXLOWPAN_CTX_FLAGS_CID_MASK) != 0) {
-                    iphc_hdr[CID_EXT_IDX] |= (ctx->flags_id & GNRC_SIXLOWPAN_CTX_FLAGS_CID_MASK);
+                    addrs->cid_ext |= (ctx->flags_id & GNRC_SIXLOWPAN_CTX_FLAGS_CID_MASK);
                 }
-                iphc_hdr[inline_pos++] = ipv6_hdr->dst.u8[1];
-                iphc_hdr[inline_pos++] = ipv6_hdr->dst.u8[2];
-                memcpy(iphc_hdr + inline_pos, ipv6_hdr->dst.u16 + 6, 4);
+                inline_addrs[inline_pos++] = ipv6_hdr->dst.u8[1];
+                inline_addrs[inline_pos++] = ipv6_hdr->dst.u8[2];
+                memcpy(inline_addrs + inline_pos, ipv6_hdr->dst.u16 + 6, 4);
                 inline_pos += 4;
                 addr_comp = true;
             }
@@ -1196,36 +1257,36 @@ static size_t _iphc_ipv6_encode(gnrc_pktsnip_t *pkt,
 
         if (dst_ctx != NULL) {
             /* stateful destination address compression */
-            iphc_hdr[IPHC2_IDX] |= SIXLOWPAN_IPHC2_DAC;
+            addrs->iphc2 |= SIXLOWPAN_IPHC2_DAC;
 
             if (((dst_ctx->flags_id & GNRC_SIXLOWPAN_CTX_FLAGS_CID_MASK) != 0)) {
-                iphc_hdr[CID_EXT_IDX] |= (dst_ctx->flags_id & GNRC_SIXLOWPAN_CTX_FLAGS_CID_MASK);
+                addrs->cid_ext |= (dst_ctx->flags_id & GNRC_SIXLOWPAN_CTX_FLAGS_CID_MASK);
             }
         }
 
         if (gnrc_netif_hdr_ipv6_iid_from_dst(iface, netif_hdr, &iid) < 0) {
             DEBUG("6lo iphc: could not get destination's IID\n");
-            return 0;
+            return false;
         }
 
         if ((ipv6_hdr->dst.u64[1].u64 == iid.uint64.u64) ||
             _context_overlaps_iid(dst_ctx, &(ipv6_hdr->dst), &iid)) {
             /* 0 bits. The address is derived using the link-layer address */
-            iphc_hdr[IPHC2_IDX] |= IPHC_M_DAC_DAM_U_L2;
+            addrs->iphc2 |= IPHC_M_DAC_DAM_U_L2;
             addr_comp = true;
         }
         else if ((byteorder_ntohl(ipv6_hdr->dst.u32[2]) == 0x000000ff) &&
                  (byteorder_ntohs(ipv6_hdr->dst.u16[6]) == 0xfe00)) {
             /* 16 bits. The address is derived using 16 bits carried inline */
-            iphc_hdr[IPHC2_IDX] |= IPHC_M_DAC_DAM_U_16;
-            memcpy(&(iphc_hdr[inline_pos]), &(ipv6_hdr->dst.u16[7]), 2);
+            addrs->iphc2 |= IPHC_M_DAC_DAM_U_16;
+            memcpy(&(inline_addrs[inline_pos]), &(ipv6_hdr->dst.u16[7]), 2);
             inline_pos += 2;
             addr_comp = true;
         }
         else {
             /* 64 bits. The address is derived using 64 bits carried inline */
-            iphc_hdr[IPHC2_IDX] |= IPHC_M_DAC_DAM_U_64;
-            memcpy(&(iphc_hdr[inline_pos]), &(ipv6_hdr->dst.u8[8]), 8);
+            addrs->iphc2 |= IPHC_M_DAC_DAM_U_64;
+            memcpy(&(inline_addrs[inline_pos]), &(ipv6_hdr->dst.u8[8]), 8);
             inline_pos += 8;
             addr_comp = true;
         }
@@ -1233,11 +1294,137 @@ static size_t _iphc_ipv6_encode(gnrc_pktsnip_t *pkt,
 
     if (!addr_comp) {
         /* full destination address is carried inline */
-        iphc_hdr[IPHC2_IDX] |= IPHC_SAC_SAM_FULL;
-        memcpy(iphc_hdr + inline_pos, &ipv6_hdr->dst, 16);
+        addrs->iphc2 |= IPHC_SAC_SAM_FULL;
+        memcpy(inline_addrs + inline_pos, &ipv6_hdr->dst, 16);
         inline_pos += 16;
     }
 
+    if (addrs->cid_ext != 0) {
+        /* context identifier extension needed */
+        addrs->iphc2 |= SIXLOWPAN_IPHC2_CID_EXT;
+    }
+    addrs->inline_len = inline_pos;
+    return true;
+}
+
+static const _iphc_addrs_t *_iphc_addrs_get(const ipv6_hdr_t *ipv6_hdr,
+                                            const gnrc_netif_hdr_t *netif_hdr,
+                                            gnrc_netif_t *iface,
+                                            _iphc_addrs_t *addrs)
+{
+#ifdef MODULE_GNRC_SIXLOWPAN_IPHC_CACHE
+    const _iphc_addrs_t *cached = _iphc_cache_get(ipv6_hdr, netif_hdr, iface);
+    /* get the generation before the lookups, so a concurrent context update
+     * can't sneak by */
+    unsigned ctx_gen = gnrc_sixlowpan_ctx_generation();
+
+    if (cached != NULL) {
+        DEBUG("6lo iphc: using cached address compression\n");
+        return cached;
+    }
+#endif  /* MODULE_GNRC_SIXLOWPAN_IPHC_CACHE */
+    if (!_iphc_addrs_encode(ipv6_hdr, netif_hdr, iface, addrs)) {
+        return NULL;
+    }
+#ifdef MODULE_GNRC_SIXLOWPAN_IPHC_CACHE
+    _iphc_cache_add(ipv6_hdr, netif_hdr, iface, addrs, ctx_gen);
+#endif  /* MODULE_GNRC_SIXLOWPAN_IPHC_CACHE */
+    return addrs;
+}
+
+static size_t _iphc_ipv6_encode(const ipv6_hdr_t *ipv6_hdr,
+                                const gnrc_netif_hdr_t *netif_hdr,
+                                gnrc_netif_t *iface,
+                                uint8_t *iphc_hdr)
+{
+    _iphc_addrs_t addrs_buf;
+    const _iphc_addrs_t *addrs;
+    uint16_t inline_pos = SIXLOWPAN_IPHC_HDR_LEN;
+
+    assert(iface != NULL);
+
+    /* compress addresses first, as this determines the context identifier
+     * extension which moves inline_pos */
+    addrs = _iphc_addrs_get(ipv6_hdr, netif_hdr, iface, &addrs_buf);
+    if (addrs == NULL) {
+        return 0;
+    }
+
+    /* set initial dispatch value*/
+    iphc_hdr[IPHC1_IDX] = SIXLOWPAN_IPHC1_DISP;
+    iphc_hdr[IPHC2_IDX] = addrs->iphc2;
+
+    if (addrs->iphc2 & SIXLOWPAN_IPHC2_CID_EXT) {
+        /* add context identifier extension */
+        iphc_hdr[CID_EXT_IDX] = addrs->cid_ext;
+
+        /* move position to behind CID extension */
+        inline_pos += SIXLOWPAN_IPHC_CID_EXT_LEN;
+    }
+
+    /* compress flow label and traffic class */
+    if (ipv6_hdr_get_fl(ipv6_hdr) == 0) {
+        if (ipv6_hdr_get_tc(ipv6_hdr) == 0) {
+            /* elide both traffic class and flow label */
+            iphc_hdr[IPHC1_IDX] |= IPHC_TF_ECN_ELIDE;
+        }
+        else {
+            /* elide flow label, traffic class (ECN + DSCP) inline (1 byte) */
+            iphc_hdr[IPHC1_IDX] |= IPHC_TF_ECN_DSCP;
+            iphc_hdr[inline_pos++] = ipv6_hdr_get_tc(ipv6_hdr);
+        }
+    }
+    else {
+        if (ipv6_hdr_get_tc_dscp(ipv6_hdr) == 0) {
+            /* elide DSCP, ECN + 2-bit pad + flow label inline (3 byte) */
+            iphc_hdr[IPHC1_IDX] |= IPHC_TF_ECN_FL;
+            iphc_hdr[inline_pos++] = (uint8_t)((ipv6_hdr_get_tc_ecn(ipv6_hdr) << 6) |
+                                               ((ipv6_hdr_get_fl(ipv6_hdr) & 0x000f0000) >> 16));
+        }
+        else {
+            /* ECN + DSCP + 4-bit pad + flow label (4 bytes) */
+            iphc_hdr[IPHC1_IDX] |= IPHC_TF_ECN_DSCP_FL;
+            iphc_hdr[inline_pos++] = ipv6_hdr_get_tc(ipv6_hdr);
+            iphc_hdr[inline_pos++] = (uint8_t)((ipv6_hdr_get_fl(ipv6_hdr) & 0x000f0000) >> 16);
+        }
+
+        /* copy remaining byteos of flow label */
+        iphc_hdr[inline_pos++] = (uint8_t)((ipv6_hdr_get_fl(ipv6_hdr) & 0x0000ff00) >> 8);
+        iphc_hdr[inline_pos++] = (uint8_t)((ipv6_hdr_get_fl(ipv6_hdr) & 0x000000ff) >> 8);
+    }
+
+    /* check for compressible next header */
+    if (_compressible_nh(ipv6_hdr->nh)) {
+        iphc_hdr[IPHC1_IDX] |= SIXLOWPAN_IPHC1_NH;
+    }
+    else {
+        iphc_hdr[inline_pos++] = ipv6_hdr->nh;
+    }
+
+    /* compress hop limit */
+    switch (ipv6_hdr->hl) {
+        case 1:
+            iphc_hdr[IPHC1_IDX] |= IPHC_HL_1;
+            break;
+
+        case 64:
+            iphc_hdr[IPHC1_IDX] |= IPHC_HL_64;
+            break;
+
+        case 255:
+            iphc_hdr[IPHC1_IDX] |= IPHC_HL_255;
+            break;
+
+        default:
+            iphc_hdr[IPHC1_IDX] |= IPHC_HL_INLINE;
+            iphc_hdr[inline_pos++] = ipv6_hdr->hl;
+            break;
+    }
+
+    /* append (compressed) addresses */
+    memcpy(&iphc_hdr[inline_pos], addrs->inline_addrs, addrs->inline_len);
+    inline_pos += addrs->inline_len;
+
     return inline_pos;
 }
 
@@ -1408,7 +1595,8 @@ static ssize_t _nhc_ipv6_encode_snip(gnrc_pktsnip_t *pkt,
         nhc_data[nhc_len++] = new_nh;
     }
     /* save to cast as result is max 40 */
-    tmp = (ssize_t)_iphc_ipv6_encode(hdr, netif_hdr, iface, &nhc_data[nhc_len]);
+    tmp = (ssize_t)_iphc_ipv6_encode(hdr->data, netif_hdr, iface,
+                                     &nhc_data[nhc_len]);
     if (tmp == 0) {
         DEBUG("6lo iphc: error encoding IPv6 header\n");
         return -1;
@@ -1538,7 +1726,8 @@ static gnrc_pktsnip_t *_iphc_encode(gnrc_pktsnip_t *pkt,
     }
 
     iphc_hdr = dispatch->data;
-    inline_pos = _iphc_ipv6_encode(pkt, netif_hdr, iface, iphc_hdr);
+    inline_pos = _iphc_ipv6_encode(pkt->next->data, netif_hdr, iface,
+                                   iphc_hdr);
 
     if (inline_pos == 0) {
         DEBUG("6lo iphc: error encoding IPv6 header\n");
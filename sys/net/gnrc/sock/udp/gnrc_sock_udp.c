@@ -26,6 +26,9 @@
 #include "net/sock/udp.h"
 #include "net/udp.h"
 #include "random.h"
+#ifdef MODULE_VFS
+#include "vfs.h"
+#endif
 
 #include "gnrc_sock_internal.h"
 
@@ -194,21 +197,14 @@ ssize_t sock_udp_recv(sock_udp_t *sock, void *data, size_t max_len,
     return (nobufs) ? -ENOBUFS : ((res < 0) ? res : ret);
 }
 
-ssize_t sock_udp_recv_buf(sock_udp_t *sock, void **data, void **buf_ctx,
-                          uint32_t timeout, sock_udp_ep_t *remote)
+static ssize_t _recv(sock_udp_t *sock, gnrc_pktsnip_t **pkt_out,
+                     uint32_t timeout, sock_udp_ep_t *remote)
 {
     gnrc_pktsnip_t *pkt, *udp;
     udp_hdr_t *hdr;
     sock_ip_ep_t tmp;
     int res;
 
-    assert((sock != NULL) && (data != NULL) && (buf_ctx != NULL));
-    if (*buf_ctx != NULL) {
-        *data = NULL;
-        gnrc_pktbuf_release(*buf_ctx);
-        *buf_ctx = NULL;
-        return 0;
-    }
     if (sock->local.family == AF_UNSPEC) {
         return -EADDRNOTAVAIL;
     }
@@ -235,25 +231,73 @@ ssize_t sock_udp_recv_buf(sock_udp_t *sock, void **data, void **buf_ctx,
         gnrc_pktbuf_release(pkt);
         return -EPROTO;
     }
+    *pkt_out = pkt;
+    return (ssize_t)pkt->size;
+}
+
+ssize_t sock_udp_recv_buf(sock_udp_t *sock, void **data, void **buf_ctx,
+                          uint32_t timeout, sock_udp_ep_t *remote)
+{
+    gnrc_pktsnip_t *pkt;
+    ssize_t res;
+
+    assert((sock != NULL) && (data != NULL) && (buf_ctx != NULL));
+    if (*buf_ctx != NULL) {
+        *data = NULL;
+        gnrc_pktbuf_release(*buf_ctx);
+        *buf_ctx = NULL;
+        return 0;
+    }
+    res = _recv(sock, &pkt, timeout, remote);
+    if (res < 0) {
+        return res;
+    }
     *data = pkt->data;
     *buf_ctx = pkt;
-    res = (int)pkt->size;
     return res;
 }
 
-ssize_t sock_udp_send(sock_udp_t *sock, const void *data, size_t len,
-                      const sock_udp_ep_t *remote)
+int sock_udp_recv_mmsg(sock_udp_t *sock, sock_udp_mmsg_t *msgs, unsigned num,
+                       uint32_t timeout)
 {
-    int res;
-    gnrc_pktsnip_t *payload, *pkt;
-    uint16_t src_port = 0, dst_port;
-    sock_ip_ep_t local;
-    sock_udp_ep_t remote_cpy;
-    sock_ip_ep_t *rem;
+    unsigned i = 0;
 
-    assert((sock != NULL) || (remote != NULL));
-    assert((len == 0) || (data != NULL)); /* (len != 0) => (data != NULL) */
+    assert((sock != NULL) && (msgs != NULL) && (num > 0));
+    while (i < num) {
+        gnrc_pktsnip_t *pkt;
+        /* only wait for the first message, then take what is already queued */
+        ssize_t res = _recv(sock, &pkt, (i == 0) ? timeout : 0,
+                            &msgs[i].remote);
+
+        if (res < 0) {
+            if ((i > 0) && (res == -EPROTO)) {
+                /* message from wrong remote was dropped, try next */
+                continue;
+            }
+            return (i > 0) ? (int)i : (int)res;
+        }
+        msgs[i].data = pkt->data;
+        msgs[i].len = res;
+        msgs[i].buf_ctx = pkt;
+        i++;
+    }
+    return i;
+}
 
+void sock_udp_mmsg_release(sock_udp_t *sock, sock_udp_mmsg_t *msgs,
+                           unsigned num)
+{
+    (void)sock;
+    assert((msgs != NULL) || (num == 0));
+    for (unsigned i = 0; i < num; i++) {
+        gnrc_pktbuf_release(msgs[i].buf_ctx);
+        msgs[i].data = NULL;
+        msgs[i].buf_ctx = NULL;
+    }
+}
+
+static int _check_remote(const sock_udp_t *sock, const sock_udp_ep_t *remote)
+{
     if (remote != NULL) {
         if (remote->port == 0) {
             return -EINVAL;
@@ -274,13 +318,23 @@ ssize_t sock_udp_send(sock_udp_t *sock, const void *data, size_t len,
     else if (sock->remote.family == AF_UNSPEC) {
         return -ENOTCONN;
     }
+    return 0;
+}
+
+/**
+ * @brief   Gets the local end point to send from, binds @p sock implicitly
+ *          if it is not bound yet
+ */
+static int _get_local(sock_udp_t *sock, const sock_udp_ep_t *remote,
+                      sock_ip_ep_t *local, uint16_t *src_port)
+{
     /* cppcheck-suppress nullPointerRedundantCheck
      * (reason: compiler evaluates lazily so this isn't a redundundant check and
      * cppcheck is being weird here anyways) */
     if ((sock == NULL) || (sock->local.family == AF_UNSPEC)) {
         /* no sock or sock currently unbound */
-        memset(&local, 0, sizeof(local));
-        if ((src_port = _get_dyn_port(sock)) == GNRC_SOCK_DYN_PORTRANGE_ERR) {
+        memset(local, 0, sizeof(*local));
+        if ((*src_port = _get_dyn_port(sock)) == GNRC_SOCK_DYN_PORTRANGE_ERR) {
             return -EADDRINUSE;
         }
         /* cppcheck-suppress nullPointer
@@ -288,14 +342,14 @@ ssize_t sock_udp_send(sock_udp_t *sock, const void *data, size_t len,
          * well, see above) */
         if (sock != NULL) {
             /* bind sock object implicitly */
-            sock->local.port = src_port;
+            sock->local.port = *src_port;
             if (remote == NULL) {
                 sock->local.family = sock->remote.family;
             }
             else {
                 sock->local.family = remote->family;
             }
-            gnrc_sock_create(&sock->reg, GNRC_NETTYPE_UDP, src_port);
+            gnrc_sock_create(&sock->reg, GNRC_NETTYPE_UDP, *src_port);
 #ifdef MODULE_GNRC_SOCK_CHECK_REUSE
             /* prepend to current socks */
             sock->reg.next = (gnrc_sock_reg_t *)_udp_socks;
@@ -304,9 +358,38 @@ ssize_t sock_udp_send(sock_udp_t *sock, const void *data, size_t len,
         }
     }
     else {
-        src_port = sock->local.port;
-        memcpy(&local, &sock->local, sizeof(local));
+        *src_port = sock->local.port;
+        memcpy(local, &sock->local, sizeof(*local));
     }
+    return 0;
+}
+
+static inline void _sent_cb(sock_udp_t *sock)
+{
+#ifdef SOCK_HAS_ASYNC
+    if ((sock != NULL) && (sock->reg.async_cb.udp)) {
+        sock->reg.async_cb.udp(sock, SOCK_ASYNC_MSG_SENT,
+                               sock->reg.async_cb_arg);
+    }
+#else
+    (void)sock;
+#endif  /* SOCK_HAS_ASYNC */
+}
+
+/**
+ * @brief   Sends @p payload, @p payload is released on error
+ */
+static ssize_t _send_snip(sock_udp_t *sock, gnrc_pktsnip_t *payload,
+                          const sock_udp_ep_t *remote, const sock_ip_ep_t *src,
+                          uint16_t src_port)
+{
+    int res;
+    gnrc_pktsnip_t *pkt;
+    uint16_t dst_port;
+    sock_ip_ep_t local = *src;
+    sock_udp_ep_t remote_cpy;
+    sock_ip_ep_t *rem;
+
     /* sock can't be NULL at this point */
     if (remote == NULL) {
         rem = (sock_ip_ep_t *)&sock->remote;
@@ -322,13 +405,10 @@ ssize_t sock_udp_send(sock_udp_t *sock, const void *data, size_t len,
         local.family = rem->family;
     }
     else if (local.family != rem->family) {
+        gnrc_pktbuf_release(payload);
         return -EINVAL;
     }
-    /* generate payload and header snips */
-    payload = gnrc_pktbuf_add(NULL, (void *)data, len, GNRC_NETTYPE_UNDEF);
-    if (payload == NULL) {
-        return -ENOMEM;
-    }
+    /* generate header snip */
     pkt = gnrc_udp_hdr_build(payload, src_port, dst_port);
     if (pkt == NULL) {
         gnrc_pktbuf_release(payload);
@@ -338,15 +418,113 @@ ssize_t sock_udp_send(sock_udp_t *sock, const void *data, size_t len,
     if (res > 0) {
         res -= sizeof(udp_hdr_t);
     }
-#ifdef SOCK_HAS_ASYNC
-    if ((sock != NULL) && (sock->reg.async_cb.udp)) {
-        sock->reg.async_cb.udp(sock, SOCK_ASYNC_MSG_SENT,
-                               sock->reg.async_cb_arg);
-    }
-#endif  /* SOCK_HAS_ASYNC */
+    _sent_cb(sock);
     return res;
 }
 
+static ssize_t _send(sock_udp_t *sock, const void *data, size_t len,
+                     const sock_udp_ep_t *remote, const sock_ip_ep_t *src,
+                     uint16_t src_port)
+{
+    gnrc_pktsnip_t *payload = gnrc_pktbuf_add(NULL, (void *)data, len,
+                                              GNRC_NETTYPE_UNDEF);
+
+    if (payload == NULL) {
+        return -ENOMEM;
+    }
+    return _send_snip(sock, payload, remote, src, src_port);
+}
+
+ssize_t sock_udp_send(sock_udp_t *sock, const void *data, size_t len,
+                      const sock_udp_ep_t *remote)
+{
+    ssize_t res;
+    uint16_t src_port = 0;
+    sock_ip_ep_t local;
+
+    assert((sock != NULL) || (remote != NULL));
+    assert((len == 0) || (data != NULL)); /* (len != 0) => (data != NULL) */
+
+    if (((res = _check_remote(sock, remote)) < 0) ||
+        ((res = _get_local(sock, remote, &local, &src_port)) < 0)) {
+        return res;
+    }
+    return _send(sock, data, len, remote, &local, src_port);
+}
+
+int sock_udp_send_mmsg(sock_udp_t *sock, const sock_udp_mmsg_t *msgs,
+                       unsigned num)
+{
+    uint16_t src_port = 0;
+    sock_ip_ep_t local;
+    unsigned i;
+
+    assert((sock != NULL) && (msgs != NULL) && (num > 0));
+    for (i = 0; i < num; i++) {
+        /* a port of 0 selects the remote of the sock */
+        const sock_udp_ep_t *remote = (msgs[i].remote.port != 0)
+                                    ? &msgs[i].remote : NULL;
+        ssize_t res;
+
+        assert((msgs[i].len == 0) || (msgs[i].data != NULL));
+        if (((res = _check_remote(sock, remote)) < 0) ||
+            /* bind only once for the whole batch */
+            ((i == 0) &&
+             ((res = _get_local(sock, remote, &local, &src_port)) < 0)) ||
+            ((res = _send(sock, msgs[i].data, msgs[i].len, remote, &local,
+                          src_port)) < 0)) {
+            if (i == 0) {
+                return res;
+            }
+            break;
+        }
+    }
+    return i;
+}
+
+#ifdef MODULE_VFS
+ssize_t sock_udp_sendfile(sock_udp_t *sock, const void *hdr, size_t hdr_len,
+                          int fd, size_t len, const sock_udp_ep_t *remote)
+{
+    ssize_t res;
+    uint16_t src_port = 0;
+    sock_ip_ep_t local;
+    gnrc_pktsnip_t *payload;
+
+    assert((sock != NULL) || (remote != NULL));
+    assert((hdr_len == 0) || (hdr != NULL));
+    assert(len > 0);
+
+    if (((res = _check_remote(sock, remote)) < 0) ||
+        ((res = _get_local(sock, remote, &local, &src_port)) < 0)) {
+        return res;
+    }
+    payload = gnrc_pktbuf_add(NULL, NULL, len, GNRC_NETTYPE_UNDEF);
+    if (payload == NULL) {
+        return -ENOMEM;
+    }
+    /* read the file content directly into the packet buffer */
+    for (size_t pos = 0; pos < len; pos += res) {
+        res = vfs_read(fd, (uint8_t *)payload->data + pos, len - pos);
+        if (res <= 0) {
+            gnrc_pktbuf_release(payload);
+            /* hdr may already describe the payload, so do not send less */
+            return (res < 0) ? res : -EIO;
+        }
+    }
+    if (hdr_len > 0) {
+        gnrc_pktsnip_t *snip = gnrc_pktbuf_add(payload, (void *)hdr, hdr_len,
+                                               GNRC_NETTYPE_UNDEF);
+        if (snip == NULL) {
+            gnrc_pktbuf_release(payload);
+            return -ENOMEM;
+        }
+        payload = snip;
+    }
+    return _send_snip(sock, payload, remote, &local, src_port);
+}
+#endif /* MODULE_VFS */
+
 #ifdef SOCK_HAS_ASYNC
 void sock_udp_set_cb(sock_udp_t *sock, sock_udp_cb_t cb, void *arg)
 {
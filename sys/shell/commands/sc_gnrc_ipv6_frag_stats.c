@@ -27,6 +27,8 @@ int _gnrc_ipv6_frag_stats(int argc, char **argv)
         printf("frag full: %u\n", stats->frag_full);
         printf("frags complete: %u\n", stats->fragments);
         printf("dgs complete: %u\n", stats->datagrams);
+        printf("src full: %u\n", stats->src_full);
+        printf("overlaps: %u\n", stats->overlaps);
     }
     return 0;
 }
@@ -520,6 +520,19 @@ static void _netif_list_groups(ipv6_addr_t *addr)
 }
 #endif
 
+#if IS_USED(MODULE_GNRC_NETIF_FQ)
+static void _netif_fq_stats(gnrc_netif_t *netif)
+{
+    const gnrc_netif_fq_stats_t *stats = &netif->fq.stats;
+
+    printf("          Send queue: %u packets\n"
+           "            enqueued %" PRIu32 "  dropped %" PRIu32 "\n"
+           "            delay avg %" PRIu32 " us  max %" PRIu32 " us\n",
+           (unsigned)netif->fq.len, stats->enqueued, stats->dropped,
+           stats->delay_avg, stats->delay_max);
+}
+#endif
+
 static void _netif_list(netif_t *iface)
 {
 #ifdef MODULE_GNRC_IPV6
@@ -804,6 +817,9 @@ static void _netif_list(netif_t *iface)
 #endif
 #ifdef MODULE_NETSTATS_IPV6
     _netif_stats(iface, NETSTATS_IPV6, false);
+#endif
+#if IS_USED(MODULE_GNRC_NETIF_FQ)
+    _netif_fq_stats((gnrc_netif_t *)iface);
 #endif
     puts("");
 }
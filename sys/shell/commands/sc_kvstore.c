@@ -0,0 +1,120 @@
+/*
+ * Copyright (C) 2020 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     sys_shell_commands
+ * @{
+ *
+ * @file
+ * @brief       Shell commands for the key-value store
+ *
+ * @}
+ */
+
+#include <ctype.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "kvstore.h"
+
+#define SHELL_KVSTORE_BUFSIZE   (64U)
+
+static void _usage(char **argv)
+{
+    printf("%s get <key>\n", argv[0]);
+    printf("%s set <key> <value>\n", argv[0]);
+    printf("%s del <key>\n", argv[0]);
+    printf("%s list\n", argv[0]);
+    printf("%s stat\n", argv[0]);
+}
+
+static void _print_value(const uint8_t *val, size_t len)
+{
+    bool printable = true;
+
+    for (size_t i = 0; i < len; i++) {
+        if (!isprint(val[i])) {
+            printable = false;
+        }
+    }
+    if (printable) {
+        printf("%.*s\n", (int)len, (const char *)val);
+        return;
+    }
+    for (size_t i = 0; i < len; i++) {
+        printf("%02x", val[i]);
+    }
+    puts("");
+}
+
+static void _list_cb(const char *key, size_t len, void *arg)
+{
+    (void)arg;
+    printf("%s (%u bytes)\n", key, (unsigned)len);
+}
+
+int _kvstore_handler(int argc, char **argv)
+{
+    kvstore_t *kvs = kvstore_default();
+    int res = 0;
+
+    if (argc < 2) {
+        _usage(argv);
+        return 1;
+    }
+    if (kvs == NULL) {
+        puts("kv: no store initialized");
+        return 1;
+    }
+
+    if ((strcmp(argv[1], "get") == 0) && (argc == 3)) {
+        uint8_t buf[SHELL_KVSTORE_BUFSIZE];
+        ssize_t len = kvstore_get(kvs, argv[2], buf, sizeof(buf));
+        if (len >= 0) {
+            _print_value(buf, len);
+        }
+        res = (len < 0) ? (int)len : 0;
+    }
+    else if ((strcmp(argv[1], "set") == 0) && (argc == 4)) {
+        res = kvstore_set(kvs, argv[2], argv[3], strlen(argv[3]));
+    }
+    else if ((strcmp(argv[1], "del") == 0) && (argc == 3)) {
+        res = kvstore_delete(kvs, argv[2]);
+    }
+    else if ((strcmp(argv[1], "list") == 0) && (argc == 2)) {
+        res = kvstore_foreach(kvs, _list_cb, NULL);
+        if (res >= 0) {
+            printf("%d keys\n", res);
+            res = 0;
+        }
+    }
+    else if ((strcmp(argv[1], "stat") == 0) && (argc == 2)) {
+        printf("keys: %u of %u\n", kvs->keys, kvs->entries_numof - 1);
+        printf("writes: %" PRIu32 ", erases: %" PRIu32 "\n",
+               kvs->stats.writes, kvs->stats.erases);
+        printf("compactions: %" PRIu32 ", records moved: %" PRIu32 "\n",
+               kvs->stats.compactions, kvs->stats.moved);
+        for (uint32_t i = 0; i < kvs->sector_count; i++) {
+            printf("sector %" PRIu32 ": %" PRIu32 " bytes live, erased %"
+                   PRIu32 " times\n", kvs->first_sector + i,
+                   kvs->sectors[i].live, kvs->sectors[i].erase_count);
+        }
+    }
+    else {
+        _usage(argv);
+        return 1;
+    }
+
+    if (res < 0) {
+        printf("kv: error %d\n", res);
+        return 1;
+    }
+    return 0;
+}
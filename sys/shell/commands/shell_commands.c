@@ -147,6 +147,10 @@ extern int _vfs_handler(int argc, char **argv);
 extern int _ls_handler(int argc, char **argv);
 #endif
 
+#ifdef MODULE_KVSTORE_CMD
+extern int _kvstore_handler(int argc, char **argv);
+#endif
+
 #ifdef MODULE_CONN_CAN
 extern int _can_handler(int argc, char **argv);
 #endif
@@ -286,6 +290,9 @@ const shell_command_t _shell_command_list[] = {
     {"vfs", "virtual file system operations", _vfs_handler},
     {"ls", "list files", _ls_handler},
 #endif
+#ifdef MODULE_KVSTORE_CMD
+    {"kv", "key-value store operations", _kvstore_handler},
+#endif
 #ifdef MODULE_CONN_CAN
     {"can", "CAN commands", _can_handler},
 #endif
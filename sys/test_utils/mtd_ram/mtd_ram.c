@@ -0,0 +1,134 @@
+/*
+ * Copyright (C) 2020 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     test_utils_mtd_ram
+ * @{
+ *
+ * @file
+ * @brief       RAM-based MTD device for tests
+ *
+ * @}
+ */
+
+#include <errno.h>
+#include <string.h>
+
+#include "test_utils/mtd_ram.h"
+
+static inline test_utils_mtd_ram_t *_ram(mtd_dev_t *dev)
+{
+    return (test_utils_mtd_ram_t *)dev;
+}
+
+static uint32_t _size(const mtd_dev_t *dev)
+{
+    return dev->sector_count * dev->pages_per_sector * dev->page_size;
+}
+
+/* returns true if the power is lost before this write or erase completes */
+static bool _power_lost(test_utils_mtd_ram_t *ram)
+{
+    if (ram->ops_left < 0) {
+        return false;
+    }
+    if (ram->ops_left > 0) {
+        ram->ops_left--;
+        return ram->ops_left == 0;
+    }
+    return true;
+}
+
+int test_utils_mtd_ram_init(mtd_dev_t *dev)
+{
+    (void)dev;
+
+    return 0;
+}
+
+int test_utils_mtd_ram_read(mtd_dev_t *dev, void *buff, uint32_t addr,
+                            uint32_t size)
+{
+    test_utils_mtd_ram_t *ram = _ram(dev);
+
+    if (addr + size > _size(dev)) {
+        return -EOVERFLOW;
+    }
+    memcpy(buff, ram->memory + addr, size);
+    ram->reads++;
+
+    return 0;
+}
+
+int test_utils_mtd_ram_write(mtd_dev_t *dev, const void *buff, uint32_t addr,
+                             uint32_t size)
+{
+    test_utils_mtd_ram_t *ram = _ram(dev);
+    const uint8_t *data = buff;
+
+    if (addr + size > _size(dev)) {
+        return -EOVERFLOW;
+    }
+    if (((addr % dev->page_size) + size) > dev->page_size) {
+        return -EOVERFLOW;
+    }
+    if (ram->ops_left == 0) {
+        return -EIO;
+    }
+    /* an interrupted write only programs the first half */
+    bool lost = _power_lost(ram);
+    if (lost) {
+        size /= 2;
+    }
+    if (ram->nor) {
+        /* programming can only clear bits, and NOR flash allows it only
+         * once */
+        for (unsigned i = 0; i < size; i++) {
+            if ((data[i] != 0xff) && (ram->memory[addr + i] != 0xff)) {
+                ram->reprogrammed = true;
+            }
+            ram->memory[addr + i] &= data[i];
+        }
+    }
+    else {
+        memcpy(ram->memory + addr, data, size);
+    }
+    ram->writes++;
+
+    return lost ? -EIO : 0;
+}
+
+int test_utils_mtd_ram_erase(mtd_dev_t *dev, uint32_t addr, uint32_t size)
+{
+    test_utils_mtd_ram_t *ram = _ram(dev);
+    uint32_t sector_size = dev->pages_per_sector * dev->page_size;
+
+    if (size % sector_size != 0) {
+        return -EOVERFLOW;
+    }
+    if (addr % sector_size != 0) {
+        return -EOVERFLOW;
+    }
+    if (addr + size > _size(dev)) {
+        return -EOVERFLOW;
+    }
+    if ((ram->ops_left == 0) || _power_lost(ram)) {
+        return -EIO;
+    }
+    memset(ram->memory + addr, 0xff, size);
+    ram->erases += size / sector_size;
+
+    return 0;
+}
+
+const mtd_desc_t test_utils_mtd_ram_driver = {
+    .init = test_utils_mtd_ram_init,
+    .read = test_utils_mtd_ram_read,
+    .write = test_utils_mtd_ram_write,
+    .erase = test_utils_mtd_ram_erase,
+};
@@ -0,0 +1,438 @@
+/*
+ * Copyright (C) 2020 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     sys_tslog
+ * @{
+ *
+ * @file
+ * @brief       Time-series log implementation
+ *
+ * A batch is stored in a slot of CONFIG_TSLOG_BATCH_SIZE bytes, all fields
+ * are big-endian:
+ *
+ *     | magic (2) | count (2) | sector seq (4) | CRC (2) | records ... |
+ *
+ * A record is a 4 byte time stamp followed by tslog_t::record_size bytes of
+ * data. The CRC covers the first 8 bytes of the header and the records.
+ *
+ * @}
+ */
+
+#include <errno.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "byteorder.h"
+#include "checksum/crc16_ccitt.h"
+#include "mtd.h"
+#include "mutex.h"
+#include "tslog.h"
+
+#define ENABLE_DEBUG    (0)
+#include "debug.h"
+
+#define BATCH_MAGIC     (0x544c)    /* "TL" */
+#define OFF_MAGIC       (0)
+#define OFF_COUNT       (2)
+#define OFF_SEQ         (4)
+#define OFF_CRC         (8)
+
+static inline uint32_t _sector_size(const tslog_t *log)
+{
+    return log->mtd->page_size * log->mtd->pages_per_sector;
+}
+
+static inline uint16_t _slots(const tslog_t *log)
+{
+    return _sector_size(log) / CONFIG_TSLOG_BATCH_SIZE;
+}
+
+static inline uint32_t _entry_size(const tslog_t *log)
+{
+    return sizeof(uint32_t) + log->record_size;
+}
+
+static inline uint16_t _per_batch(const tslog_t *log)
+{
+    return (CONFIG_TSLOG_BATCH_SIZE - TSLOG_BATCH_HDR_SIZE) / _entry_size(log);
+}
+
+static inline uint32_t _addr(const tslog_t *log, uint32_t sector, uint16_t slot)
+{
+    return (log->first_sector + sector) * _sector_size(log) +
+           slot * CONFIG_TSLOG_BATCH_SIZE;
+}
+
+static inline const uint8_t *_record(const tslog_t *log, const uint8_t *batch,
+                                     unsigned i)
+{
+    return batch + TSLOG_BATCH_HDR_SIZE + i * _entry_size(log);
+}
+
+static uint16_t _crc(const tslog_t *log, const uint8_t *batch, uint16_t count)
+{
+    uint16_t crc = crc16_ccitt_calc(batch, OFF_CRC);
+
+    return crc16_ccitt_update(crc, batch + TSLOG_BATCH_HDR_SIZE,
+                              count * _entry_size(log));
+}
+
+static bool _erased(const uint8_t *buf, size_t len)
+{
+    for (size_t i = 0; i < len; i++) {
+        if (buf[i] != 0xff) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/* reads a batch into log->buf, returns its number of records, 0 if the slot
+ * is erased or -EBADMSG if it holds anything else */
+static int _read_batch(tslog_t *log, uint32_t sector, uint16_t slot)
+{
+    uint8_t *buf = log->buf;
+    int res = mtd_read(log->mtd, buf, _addr(log, sector, slot),
+                       CONFIG_TSLOG_BATCH_SIZE);
+
+    if (res < 0) {
+        return res;
+    }
+    uint16_t count = byteorder_bebuftohs(buf + OFF_COUNT);
+    if ((byteorder_bebuftohs(buf + OFF_MAGIC) == BATCH_MAGIC) &&
+        (count > 0) && (count <= _per_batch(log)) &&
+        (byteorder_bebuftohs(buf + OFF_CRC) == _crc(log, buf, count))) {
+        return count;
+    }
+    if (_erased(buf, CONFIG_TSLOG_BATCH_SIZE)) {
+        return 0;
+    }
+    DEBUG("tslog: invalid batch in sector %" PRIu32 ", slot %u\n",
+          sector, slot);
+    return -EBADMSG;
+}
+
+static void _reset(tslog_t *log)
+{
+    /* the next batch starts the first sector */
+    log->head = log->sector_count - 1;
+    log->slot = _slots(log);
+    log->used = 0;
+    log->pending = 0;
+    log->last = 0;
+}
+
+static int _advance(tslog_t *log)
+{
+    uint32_t head = (log->head + 1) % log->sector_count;
+    int res;
+
+    /* this is either the oldest sector or it holds no valid data */
+    res = mtd_erase(log->mtd, _addr(log, head, 0), _sector_size(log));
+    if (res < 0) {
+        return res;
+    }
+    log->stats.erases++;
+    log->head = head;
+    log->slot = 0;
+    log->seq++;
+    if (log->used < log->sector_count) {
+        log->used++;
+    }
+    return 0;
+}
+
+static int _write_batch(tslog_t *log)
+{
+    uint8_t *batch = log->batch;
+    uint32_t page_size = log->mtd->page_size;
+    uint32_t len;
+    uint32_t addr;
+    int res;
+
+    if (log->pending == 0) {
+        return 0;
+    }
+    if (log->slot >= _slots(log)) {
+        res = _advance(log);
+        if (res < 0) {
+            return res;
+        }
+    }
+    if (log->slot == 0) {
+        log->index[log->head] = byteorder_bebuftohl(_record(log, batch, 0));
+    }
+    byteorder_htobebufs(batch + OFF_MAGIC, BATCH_MAGIC);
+    byteorder_htobebufs(batch + OFF_COUNT, log->pending);
+    byteorder_htobebufl(batch + OFF_SEQ, log->seq);
+    byteorder_htobebufs(batch + OFF_CRC, _crc(log, batch, log->pending));
+
+    /* the slot is consumed even if writing fails, it is not erased anymore */
+    addr = _addr(log, log->head, log->slot++);
+    len = TSLOG_BATCH_HDR_SIZE + log->pending * _entry_size(log);
+    while (len > 0) {
+        uint32_t chunk = page_size - (addr % page_size);
+        if (chunk > len) {
+            chunk = len;
+        }
+        res = mtd_write(log->mtd, batch, addr, chunk);
+        if (res < 0) {
+            return res;
+        }
+        log->stats.writes++;
+        batch += chunk;
+        addr += chunk;
+        len -= chunk;
+    }
+    log->stats.batches++;
+    log->pending = 0;
+    return 0;
+}
+
+/* returns 1 and the sequence number of a sector if it starts with a valid
+ * batch, the index entry of the sector is updated */
+static int _scan_sector(tslog_t *log, uint32_t sector, uint32_t *seq)
+{
+    int res = _read_batch(log, sector, 0);
+
+    if (res <= 0) {
+        return (res == -EBADMSG) ? 0 : res;
+    }
+    *seq = byteorder_bebuftohl(log->buf + OFF_SEQ);
+    log->index[sector] = byteorder_bebuftohl(_record(log, log->buf, 0));
+    return 1;
+}
+
+static int _recover(tslog_t *log)
+{
+    uint32_t seq = 0;
+    bool found = false;
+    int res;
+
+    _reset(log);
+
+    /* the newest sector has the highest sequence number */
+    for (uint32_t sector = 0; sector < log->sector_count; sector++) {
+        uint32_t tmp;
+
+        res = _scan_sector(log, sector, &tmp);
+        if (res < 0) {
+            return res;
+        }
+        if ((res > 0) && (!found || ((int32_t)(tmp - seq) > 0))) {
+            found = true;
+            seq = tmp;
+            log->head = sector;
+        }
+    }
+    log->seq = seq;
+    if (!found) {
+        return 0;
+    }
+
+    /* the sectors before it that continue the sequence hold older records */
+    log->used = 1;
+    while (log->used < log->sector_count) {
+        uint32_t sector = (log->head + log->sector_count - log->used) %
+                          log->sector_count;
+        uint32_t tmp;
+
+        res = _scan_sector(log, sector, &tmp);
+        if (res < 0) {
+            return res;
+        }
+        if ((res == 0) || (tmp != seq - log->used)) {
+            break;
+        }
+        log->used++;
+    }
+
+    /* the end of the data is the first erased slot of the head sector */
+    for (log->slot = 0; log->slot < _slots(log); log->slot++) {
+        res = _read_batch(log, log->head, log->slot);
+        if (res == 0) {
+            break;
+        }
+        if (res > 0) {
+            log->last = byteorder_bebuftohl(_record(log, log->buf, res - 1));
+        }
+        else if (res != -EBADMSG) {
+            return res;
+        }
+    }
+    DEBUG("tslog: head %" PRIu32 ", slot %u, %" PRIu32 " sectors used\n",
+          log->head, log->slot, log->used);
+    return 0;
+}
+
+int tslog_init(tslog_t *log)
+{
+    int res;
+
+    mutex_init(&log->lock);
+    res = mtd_init(log->mtd);
+    if (res < 0) {
+        return res;
+    }
+
+    uint32_t page_size = log->mtd->page_size;
+    uint32_t sector_size = _sector_size(log);
+    if ((log->sector_count == 0) ||
+        ((log->first_sector + log->sector_count) > log->mtd->sector_count) ||
+        ((CONFIG_TSLOG_BATCH_SIZE % page_size != 0) &&
+         (page_size % CONFIG_TSLOG_BATCH_SIZE != 0)) ||
+        (sector_size % CONFIG_TSLOG_BATCH_SIZE != 0) ||
+        ((sector_size / CONFIG_TSLOG_BATCH_SIZE) > UINT16_MAX) ||
+        (_per_batch(log) == 0)) {
+        return -EINVAL;
+    }
+    memset(&log->stats, 0, sizeof(log->stats));
+
+    mutex_lock(&log->lock);
+    res = _recover(log);
+    mutex_unlock(&log->lock);
+    return res;
+}
+
+int tslog_format(tslog_t *log)
+{
+    int res;
+
+    mutex_lock(&log->lock);
+    res = mtd_erase(log->mtd, _addr(log, 0, 0),
+                    log->sector_count * _sector_size(log));
+    if (res == 0) {
+        log->stats.erases += log->sector_count;
+        log->seq = 0;
+        _reset(log);
+    }
+    mutex_unlock(&log->lock);
+    return res;
+}
+
+int tslog_append(tslog_t *log, uint32_t timestamp, const void *data)
+{
+    int res = 0;
+
+    mutex_lock(&log->lock);
+    if (timestamp < log->last) {
+        res = -EINVAL;
+    }
+    else if (log->pending == _per_batch(log)) {
+        /* writing the full batch failed before */
+        res = _write_batch(log);
+    }
+    if (res == 0) {
+        uint8_t *record = log->batch + TSLOG_BATCH_HDR_SIZE +
+                          log->pending++ * _entry_size(log);
+
+        byteorder_htobebufl(record, timestamp);
+        memcpy(record + sizeof(uint32_t), data, log->record_size);
+        log->last = timestamp;
+        log->stats.appends++;
+        if (log->pending == _per_batch(log)) {
+            res = _write_batch(log);
+        }
+    }
+    mutex_unlock(&log->lock);
+    return res;
+}
+
+int tslog_flush(tslog_t *log)
+{
+    int res;
+
+    mutex_lock(&log->lock);
+    res = _write_batch(log);
+    mutex_unlock(&log->lock);
+    return res;
+}
+
+/* passes the matching records of a batch to cb, returns 1 when the query is
+ * done */
+static int _query_batch(tslog_t *log, const uint8_t *batch, unsigned count,
+                        uint32_t start, uint32_t end, tslog_cb_t cb, void *arg,
+                        int *found)
+{
+    for (unsigned i = 0; i < count; i++) {
+        const uint8_t *record = _record(log, batch, i);
+        uint32_t timestamp = byteorder_bebuftohl(record);
+
+        if (timestamp > end) {
+            return 1;
+        }
+        if (timestamp >= start) {
+            (*found)++;
+            if (cb(timestamp, record + sizeof(uint32_t), arg) != 0) {
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
+
+int tslog_query(tslog_t *log, uint32_t start, uint32_t end,
+                tslog_cb_t cb, void *arg)
+{
+    uint32_t tail;
+    uint32_t lo = 0;
+    uint32_t hi;
+    int found = 0;
+    int res = 0;
+
+    mutex_lock(&log->lock);
+
+    tail = (log->head + log->sector_count - log->used + 1) % log->sector_count;
+    /* the last sector starting before start, the older ones only contain
+     * older records. Records with the same time stamp may continue in the
+     * next sectors, so a sector starting at start may not be the first one
+     * holding records at start. */
+    hi = log->used;
+    while (hi - lo > 1) {
+        uint32_t mid = lo + (hi - lo) / 2;
+
+        if (log->index[(tail + mid) % log->sector_count] < start) {
+            lo = mid;
+        }
+        else {
+            hi = mid;
+        }
+    }
+
+    for (uint32_t i = lo; i < log->used; i++) {
+        uint32_t sector = (tail + i) % log->sector_count;
+        uint16_t slots = (sector == log->head) ? log->slot : _slots(log);
+
+        if (log->index[sector] > end) {
+            goto out;
+        }
+        for (uint16_t slot = 0; slot < slots; slot++) {
+            res = _read_batch(log, sector, slot);
+            if (res == 0) {
+                break;
+            }
+            if (res == -EBADMSG) {
+                res = 0;
+                continue;
+            }
+            if (res < 0) {
+                goto out;
+            }
+            if (_query_batch(log, log->buf, res, start, end, cb, arg, &found)) {
+                goto out;
+            }
+        }
+    }
+    _query_batch(log, log->batch, log->pending, start, end, cb, arg, &found);
+
+out:
+    mutex_unlock(&log->lock);
+    return (res < 0) ? res : found;
+}
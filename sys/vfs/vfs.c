@@ -15,12 +15,15 @@
  */
 
 #include <errno.h> /* for error codes */
+#include <stdbool.h> /* for bool */
+#include <stdint.h> /* for uintptr_t */
 #include <string.h> /* for strncmp */
 #include <stddef.h> /* for NULL */
 #include <sys/types.h> /* for off_t etc */
 #include <sys/stat.h> /* for struct stat */
 #include <sys/statvfs.h> /* for struct statvfs */
 #include <fcntl.h> /* for O_ACCMODE, ..., fcntl */
+#include <limits.h> /* for SSIZE_MAX */
 #include <unistd.h> /* for STDIN_FILENO, STDOUT_FILENO, STDERR_FILENO */
 
 #include "vfs.h"
@@ -31,6 +34,10 @@
 
 #define ENABLE_DEBUG (0)
 #include "debug.h"
+
+#ifndef SSIZE_MAX
+#define SSIZE_MAX ((ssize_t)(SIZE_MAX / 2))
+#endif
 #if ENABLE_DEBUG
 /* Since some of these functions are called by printf, we can't really call
  * printf from our functions or we end up in an infinite recursion. */
@@ -118,6 +125,43 @@ static inline int _init_fd(int fd, const vfs_file_ops_t *f_op, vfs_mount_t *moun
  */
 static inline int _find_mount(vfs_mount_t **mountpp, const char *name, const char **rel_path);
 
+/**
+ * @internal
+ * @brief Same as _find_mount, but with the mount table already locked
+ */
+static int _find_mount_locked(vfs_mount_t **mountpp, const char *name, const char **rel_path);
+
+/**
+ * @internal
+ * @brief Same as _find_mount, but served from the path lookup cache if
+ * possible
+ *
+ * @param[out] mountpp   write address of the found mount to this pointer
+ * @param[in]  name      absolute path to file
+ * @param[out] rel_path  output pointer for relative path
+ * @param[out] handle    file system handle of the file, valid if 1 is returned
+ *
+ * @return 1 on success, if @p handle was written
+ * @return 0 on success, if no handle is known
+ * @return <0 on error
+ */
+static inline int _find_mount_cached(vfs_mount_t **mountpp, const char *name,
+                                     const char **rel_path, uintptr_t *handle);
+
+/**
+ * @internal
+ * @brief Drop the cached paths of @p mountp, or all if @p mountp is NULL
+ *
+ * The mount table must be locked.
+ */
+static inline void _dcache_drop(const vfs_mount_t *mountp);
+
+/**
+ * @internal
+ * @brief Same as _dcache_drop, but with the mount table unlocked
+ */
+static inline void _dcache_invalidate(const vfs_mount_t *mountp);
+
 /**
  * @internal
  * @brief Check that a given fd number is valid
@@ -214,6 +258,21 @@ int vfs_fstatvfs(int fd, struct statvfs *buf)
     return filp->mp->fs->fs_op->fstatvfs(filp->mp, filp, buf);
 }
 
+int vfs_fsync(int fd)
+{
+    DEBUG_NOT_STDOUT(fd, "vfs_fsync: %d\n", fd);
+    int res = _fd_is_valid(fd);
+    if (res < 0) {
+        return res;
+    }
+    vfs_file_t *filp = &_vfs_open_files[fd];
+    if (filp->f_op->fsync == NULL) {
+        /* driver does not buffer data */
+        return 0;
+    }
+    return filp->f_op->fsync(filp);
+}
+
 off_t vfs_lseek(int fd, off_t off, int whence)
 {
     DEBUG("vfs_lseek: %d, %ld, %d\n", fd, (long)off, whence);
@@ -257,7 +316,8 @@ int vfs_open(const char *name, int flags, mode_t mode)
     }
     const char *rel_path;
     vfs_mount_t *mountp;
-    int res = _find_mount(&mountp, name, &rel_path);
+    uintptr_t handle;
+    int res = _find_mount_cached(&mountp, name, &rel_path, &handle);
     /* _find_mount implicitly increments the open_files count on success */
     if (res < 0) {
         /* No mount point maps to the requested file name */
@@ -274,15 +334,22 @@ int vfs_open(const char *name, int flags, mode_t mode)
         return fd;
     }
     vfs_file_t *filp = &_vfs_open_files[fd];
-    if (filp->f_op->open != NULL) {
+    if ((res > 0) && (filp->f_op->open_handle != NULL)) {
+        /* the file was resolved before, skip the path lookup */
+        res = filp->f_op->open_handle(filp, handle, flags, mode);
+    }
+    else if (filp->f_op->open != NULL) {
         res = filp->f_op->open(filp, rel_path, flags, mode, name);
-        if (res < 0) {
-            /* something went wrong during open */
-            DEBUG("vfs_open: open: ERR %d!\n", res);
-            /* clean up */
-            _free_fd(fd);
-            return res;
-        }
+    }
+    else {
+        res = 0;
+    }
+    if (res < 0) {
+        /* something went wrong during open */
+        DEBUG("vfs_open: open: ERR %d!\n", res);
+        /* clean up */
+        _free_fd(fd);
+        return res;
     }
     DEBUG("vfs_open: opened %d\n", fd);
     return fd;
@@ -333,6 +400,120 @@ ssize_t vfs_write(int fd, const void *src, size_t count)
     return filp->f_op->write(filp, src, count);
 }
 
+/**
+ * @internal
+ * @brief Check the arguments of vfs_readv and vfs_writev
+ *
+ * @return 0 if the sizes of the buffers add up to at most SSIZE_MAX
+ * @return <0 on error
+ */
+static inline int _iov_check(const struct iovec *iov, int iovcnt)
+{
+    size_t total = 0;
+
+    if (iovcnt < 0) {
+        return -EINVAL;
+    }
+    if ((iov == NULL) && (iovcnt > 0)) {
+        return -EFAULT;
+    }
+    for (int i = 0; i < iovcnt; i++) {
+        if ((iov[i].iov_base == NULL) && (iov[i].iov_len > 0)) {
+            return -EFAULT;
+        }
+        if (iov[i].iov_len > (size_t)SSIZE_MAX - total) {
+            return -EINVAL;
+        }
+        total += iov[i].iov_len;
+    }
+    return 0;
+}
+
+ssize_t vfs_readv(int fd, const struct iovec *iov, int iovcnt)
+{
+    DEBUG("vfs_readv: %d, %p, %d\n", fd, (void *)iov, iovcnt);
+    int res = _iov_check(iov, iovcnt);
+    if (res < 0) {
+        return res;
+    }
+    res = _fd_is_valid(fd);
+    if (res < 0) {
+        return res;
+    }
+    vfs_file_t *filp = &_vfs_open_files[fd];
+    if (((filp->flags & O_ACCMODE) != O_RDONLY) & ((filp->flags & O_ACCMODE) != O_RDWR)) {
+        /* File not open for reading */
+        return -EBADF;
+    }
+    if (filp->f_op->readv != NULL) {
+        return filp->f_op->readv(filp, iov, iovcnt);
+    }
+    if (filp->f_op->read == NULL) {
+        /* driver does not implement read() */
+        return -EINVAL;
+    }
+    /* read buffer by buffer, until one is not filled completely */
+    ssize_t total = 0;
+    for (int i = 0; i < iovcnt; i++) {
+        if (iov[i].iov_len == 0) {
+            continue;
+        }
+        ssize_t nbytes = filp->f_op->read(filp, iov[i].iov_base, iov[i].iov_len);
+        if (nbytes < 0) {
+            /* report the data read so far, the error shows on the next call */
+            return (total > 0) ? total : nbytes;
+        }
+        total += nbytes;
+        if ((size_t)nbytes < iov[i].iov_len) {
+            break;
+        }
+    }
+    return total;
+}
+
+ssize_t vfs_writev(int fd, const struct iovec *iov, int iovcnt)
+{
+    DEBUG_NOT_STDOUT(fd, "vfs_writev: %d, %p, %d\n", fd, (void *)iov, iovcnt);
+    int res = _iov_check(iov, iovcnt);
+    if (res < 0) {
+        return res;
+    }
+    res = _fd_is_valid(fd);
+    if (res < 0) {
+        return res;
+    }
+    vfs_file_t *filp = &_vfs_open_files[fd];
+    if (((filp->flags & O_ACCMODE) != O_WRONLY) & ((filp->flags & O_ACCMODE) != O_RDWR)) {
+        /* File not open for writing */
+        return -EBADF;
+    }
+    if (filp->f_op->writev != NULL) {
+        return filp->f_op->writev(filp, iov, iovcnt);
+    }
+    if (filp->f_op->write == NULL) {
+        /* driver does not implement write() */
+        return -EINVAL;
+    }
+    /* write buffer by buffer, until one is not written completely */
+    ssize_t total = 0;
+    for (int i = 0; i < iovcnt; i++) {
+        if (iov[i].iov_len == 0) {
+            continue;
+        }
+        ssize_t nbytes = filp->f_op->write(filp, iov[i].iov_base, iov[i].iov_len);
+        if (nbytes < 0) {
+            /* report the data written so far, the error shows on the next
+             * call */
+            return (total > 0) ? total : nbytes;
+        }
+        total += nbytes;
+        if ((size_t)nbytes < iov[i].iov_len) {
+            break;
+        }
+    }
+    return total;
+}
+
 int vfs_opendir(vfs_DIR *dirp, const char *dirname)
 {
     DEBUG("vfs_opendir: %p, \"%s\"\n", (void *)dirp, dirname);
@@ -483,6 +664,8 @@ int vfs_mount(vfs_mount_t *mountp)
     }
     /* insert last in list */
     clist_rpush(&_vfs_mounts_list, &mountp->list_entry);
+    /* cached paths below the new mount point now resolve to it */
+    _dcache_drop(NULL);
     mutex_unlock(&_mount_mutex);
     DEBUG("vfs_mount: mount done\n");
     return 0;
@@ -529,6 +712,7 @@ int vfs_umount(vfs_mount_t *mountp)
         mutex_unlock(&_mount_mutex);
         return -EINVAL;
     }
+    _dcache_drop(mountp);
     mutex_unlock(&_mount_mutex);
     return 0;
 }
@@ -575,6 +759,8 @@ int vfs_rename(const char *from_path, const char *to_path)
         return -EXDEV;
     }
     res = mountp->fs->fs_op->rename(mountp, rel_from, rel_to);
+    /* cached handles below the old path may be stale now */
+    _dcache_invalidate(mountp);
     DEBUG("vfs_rename: rename %p, \"%s\" -> \"%s\"", (void *)mountp, rel_from, rel_to);
     if (res < 0) {
         /* something went wrong during rename */
@@ -615,6 +801,8 @@ int vfs_unlink(const char *name)
         return -EPERM;
     }
     res = mountp->fs->fs_op->unlink(mountp, rel_path);
+    /* cached handles below the old path may be stale now */
+    _dcache_invalidate(mountp);
     DEBUG("vfs_unlink: unlink %p, \"%s\"", (void *)mountp, rel_path);
     if (res < 0) {
         /* something went wrong during unlink */
@@ -689,6 +877,8 @@ int vfs_rmdir(const char *name)
         return -EPERM;
     }
     res = mountp->fs->fs_op->rmdir(mountp, rel_path);
+    /* cached handles below the old path may be stale now */
+    _dcache_invalidate(mountp);
     DEBUG("vfs_rmdir: rmdir %p, \"%s\"", (void *)mountp, rel_path);
     if (res < 0) {
         /* something went wrong during rmdir */
@@ -710,14 +900,22 @@ int vfs_stat(const char *restrict path, struct stat *restrict buf)
     }
     const char *rel_path;
     vfs_mount_t *mountp;
+    uintptr_t handle;
     int res;
-    res = _find_mount(&mountp, path, &rel_path);
+    res = _find_mount_cached(&mountp, path, &rel_path, &handle);
     /* _find_mount implicitly increments the open_files count on success */
     if (res < 0) {
         /* No mount point maps to the requested file name */
         DEBUG("vfs_stat: no matching mount\n");
         return res;
     }
+    if ((res > 0) && (mountp->fs->fs_op->stat_handle != NULL)) {
+        /* the file was resolved before, skip the path lookup */
+        res = mountp->fs->fs_op->stat_handle(mountp, handle, buf);
+        /* remember to decrement the open_files count */
+        atomic_fetch_sub(&mountp->open_files, 1);
+        return res;
+    }
     if ((mountp->fs->fs_op == NULL) || (mountp->fs->fs_op->stat == NULL)) {
         /* stat not supported */
         DEBUG("vfs_stat: stat not supported by fs!\n");
@@ -932,16 +1130,14 @@ static inline int _init_fd(int fd, const vfs_file_ops_t *f_op, vfs_mount_t *moun
     return fd;
 }
 
-static inline int _find_mount(vfs_mount_t **mountpp, const char *name, const char **rel_path)
+static int _find_mount_locked(vfs_mount_t **mountpp, const char *name, const char **rel_path)
 {
     size_t longest_match = 0;
     size_t name_len = strlen(name);
-    mutex_lock(&_mount_mutex);
 
     clist_node_t *node = _vfs_mounts_list.next;
     if (node == NULL) {
         /* list empty */
-        mutex_unlock(&_mount_mutex);
         return -ENOENT;
     }
     vfs_mount_t *mountp = NULL;
@@ -972,12 +1168,10 @@ static inline int _find_mount(vfs_mount_t **mountpp, const char *name, const cha
     } while (node != _vfs_mounts_list.next);
     if (mountp == NULL) {
         /* not found */
-        mutex_unlock(&_mount_mutex);
         return -ENOENT;
     }
     /* Increment open files counter for this mount */
     atomic_fetch_add(&mountp->open_files, 1);
-    mutex_unlock(&_mount_mutex);
     *mountpp = mountp;
     if (rel_path != NULL) {
         *rel_path = name + longest_match;
@@ -985,6 +1179,172 @@ static inline int _find_mount(vfs_mount_t **mountpp, const char *name, const cha
     return 0;
 }
 
+static inline int _find_mount(vfs_mount_t **mountpp, const char *name, const char **rel_path)
+{
+    mutex_lock(&_mount_mutex);
+    int res = _find_mount_locked(mountpp, name, rel_path);
+    mutex_unlock(&_mount_mutex);
+    return res;
+}
+
+#ifdef MODULE_VFS_DCACHE
+/**
+ * @internal
+ * @brief Entry of the path lookup cache
+ */
+typedef struct {
+    vfs_mount_t *mp;        /**< mount the path resolves to, NULL if unused */
+    uint32_t hash;          /**< hash of vfs_dcache_entry_t::path */
+    uint32_t last_use;      /**< time of the last access, for LRU */
+    uintptr_t handle;       /**< file system handle of the file */
+    uint16_t rel;           /**< offset of the mount relative path */
+    bool has_handle;        /**< vfs_dcache_entry_t::handle is valid */
+    char path[CONFIG_VFS_DCACHE_PATH_MAX];  /**< absolute path */
+} vfs_dcache_entry_t;
+
+static vfs_dcache_entry_t _dcache[CONFIG_VFS_DCACHE_NUMOF];
+static uint32_t _dcache_clock;
+static vfs_dcache_stats_t _dcache_stats;
+
+/* FNV-1a, also returns the length of the path */
+static uint32_t _dcache_hash(const char *path, size_t *len)
+{
+    uint32_t hash = 2166136261U;
+    const char *c;
+
+    for (c = path; *c != '\0'; c++) {
+        hash = (hash ^ (uint8_t)*c) * 16777619U;
+    }
+    *len = c - path;
+    return hash;
+}
+
+static vfs_dcache_entry_t *_dcache_find(const char *path, uint32_t hash)
+{
+    for (unsigned i = 0; i < CONFIG_VFS_DCACHE_NUMOF; i++) {
+        vfs_dcache_entry_t *entry = &_dcache[i];
+
+        if ((entry->mp != NULL) && (entry->hash == hash) &&
+            (strcmp(entry->path, path) == 0)) {
+            return entry;
+        }
+    }
+    return NULL;
+}
+
+/* returns an unused or the least recently used entry */
+static vfs_dcache_entry_t *_dcache_alloc(void)
+{
+    vfs_dcache_entry_t *victim = &_dcache[0];
+
+    for (unsigned i = 0; i < CONFIG_VFS_DCACHE_NUMOF; i++) {
+        vfs_dcache_entry_t *entry = &_dcache[i];
+
+        if (entry->mp == NULL) {
+            return entry;
+        }
+        if ((int32_t)(entry->last_use - victim->last_use) < 0) {
+            victim = entry;
+        }
+    }
+    return victim;
+}
+
+static inline int _find_mount_cached(vfs_mount_t **mountpp, const char *name,
+                                     const char **rel_path, uintptr_t *handle)
+{
+    size_t len;
+    uint32_t hash = _dcache_hash(name, &len);
+
+    if (len >= CONFIG_VFS_DCACHE_PATH_MAX) {
+        /* path too long to be cached */
+        return _find_mount(mountpp, name, rel_path);
+    }
+    mutex_lock(&_mount_mutex);
+    vfs_dcache_entry_t *entry = _dcache_find(name, hash);
+    if (entry != NULL) {
+        _dcache_stats.hits++;
+        atomic_fetch_add(&entry->mp->open_files, 1);
+    }
+    else {
+        _dcache_stats.misses++;
+        vfs_mount_t *mountp;
+        const char *rel;
+        int res = _find_mount_locked(&mountp, name, &rel);
+        if (res < 0) {
+            mutex_unlock(&_mount_mutex);
+            return res;
+        }
+        entry = _dcache_alloc();
+        entry->mp = mountp;
+        entry->hash = hash;
+        entry->rel = rel - name;
+        entry->has_handle = false;
+        memcpy(entry->path, name, len + 1);
+    }
+    entry->last_use = _dcache_clock++;
+
+    vfs_mount_t *mountp = entry->mp;
+    if (!entry->has_handle && (mountp->fs->fs_op != NULL) &&
+        (mountp->fs->fs_op->lookup != NULL)) {
+        /* a failed lookup (e.g. of a file yet to be created) is retried */
+        entry->has_handle = (mountp->fs->fs_op->lookup(mountp, name + entry->rel,
+                                                       &entry->handle) == 0);
+    }
+    int res = entry->has_handle ? 1 : 0;
+    *handle = entry->handle;
+    *rel_path = name + entry->rel;
+    *mountpp = mountp;
+    mutex_unlock(&_mount_mutex);
+    return res;
+}
+
+static inline void _dcache_drop(const vfs_mount_t *mountp)
+{
+    for (unsigned i = 0; i < CONFIG_VFS_DCACHE_NUMOF; i++) {
+        if ((mountp == NULL) || (_dcache[i].mp == mountp)) {
+            _dcache[i].mp = NULL;
+        }
+    }
+}
+
+static inline void _dcache_invalidate(const vfs_mount_t *mountp)
+{
+    mutex_lock(&_mount_mutex);
+    _dcache_drop(mountp);
+    mutex_unlock(&_mount_mutex);
+}
+
+void vfs_dcache_clear(void)
+{
+    _dcache_invalidate(NULL);
+}
+
+void vfs_dcache_stats(vfs_dcache_stats_t *stats)
+{
+    mutex_lock(&_mount_mutex);
+    *stats = _dcache_stats;
+    mutex_unlock(&_mount_mutex);
+}
+#else
+static inline int _find_mount_cached(vfs_mount_t **mountpp, const char *name,
+                                     const char **rel_path, uintptr_t *handle)
+{
+    (void)handle;
+    return _find_mount(mountpp, name, rel_path);
+}
+
+static inline void _dcache_drop(const vfs_mount_t *mountp)
+{
+    (void)mountp;
+}
+
+static inline void _dcache_invalidate(const vfs_mount_t *mountp)
+{
+    (void)mountp;
+}
+#endif
+
 static inline int _fd_is_valid(int fd)
 {
     if ((unsigned int)fd >= VFS_MAX_OPEN_FILES) {
@@ -0,0 +1,119 @@
+/*
+ * Copyright (C) 2020 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     tests
+ * @{
+ *
+ * @file
+ * @brief       Throughput benchmark of AES in ECB, CTR and CCM mode
+ *
+ * The table based implementation and the constant-time implementation are
+ * measured with the same data. The time of the key expansion, which is done
+ * once in cipher_init(), is printed as well.
+ *
+ * @}
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "crypto/ciphers.h"
+#include "crypto/modes/ccm.h"
+#include "crypto/modes/ctr.h"
+#include "crypto/modes/ecb.h"
+#include "test_utils/expect.h"
+#include "xtimer.h"
+
+#define BENCH_SIZE              (1024U)
+#define BENCH_RUNS              (16U)
+#define BENCH_INITS             (256U)
+#define BENCH_MAC_LEN           (8U)
+#define BENCH_LEN_ENCODING      (2U)
+
+static const uint8_t _key[16] = {
+    0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6,
+    0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c
+};
+
+static const uint8_t _nonce[13] = {
+    0x00, 0x00, 0x00, 0x03, 0x02, 0x01, 0x00, 0xa0,
+    0xa1, 0xa2, 0xa3, 0xa4, 0xa5
+};
+
+static uint8_t _input[BENCH_SIZE];
+static uint8_t _output[BENCH_SIZE + BENCH_MAC_LEN];
+static uint8_t _reference[BENCH_SIZE + BENCH_MAC_LEN];
+static cipher_t _cipher;
+
+static void _print(const char *name, const char *mode, uint32_t time)
+{
+    printf("%s %s: %" PRIu32 " us per KiB\n", name, mode,
+           time / (BENCH_RUNS * (BENCH_SIZE / 1024)));
+}
+
+static void _bench(const char *name, cipher_id_t id)
+{
+    uint8_t counter[16];
+    uint32_t time;
+    int res = 0;
+
+    time = xtimer_now_usec();
+    for (unsigned i = 0; i < BENCH_INITS; i++) {
+        res = cipher_init(&_cipher, id, _key, sizeof(_key));
+    }
+    time = xtimer_now_usec() - time;
+    expect(res == CIPHER_INIT_SUCCESS);
+    printf("%s init: %" PRIu32 " us\n", name, time / BENCH_INITS);
+
+    time = xtimer_now_usec();
+    for (unsigned i = 0; i < BENCH_RUNS; i++) {
+        res = cipher_encrypt_ecb(&_cipher, _input, BENCH_SIZE, _output);
+    }
+    time = xtimer_now_usec() - time;
+    expect(res == BENCH_SIZE);
+    _print(name, "ecb", time);
+
+    time = xtimer_now_usec();
+    for (unsigned i = 0; i < BENCH_RUNS; i++) {
+        memset(counter, 0, sizeof(counter));
+        res = cipher_encrypt_ctr(&_cipher, counter, 0, _input, BENCH_SIZE,
+                                 _output);
+    }
+    time = xtimer_now_usec() - time;
+    expect(res == BENCH_SIZE);
+    _print(name, "ctr", time);
+
+    time = xtimer_now_usec();
+    for (unsigned i = 0; i < BENCH_RUNS; i++) {
+        res = cipher_encrypt_ccm(&_cipher, NULL, 0, BENCH_MAC_LEN,
+                                 BENCH_LEN_ENCODING, _nonce, sizeof(_nonce),
+                                 _input, BENCH_SIZE, _output);
+    }
+    time = xtimer_now_usec() - time;
+    expect(res == BENCH_SIZE + BENCH_MAC_LEN);
+    _print(name, "ccm", time);
+}
+
+int main(void)
+{
+    for (unsigned i = 0; i < BENCH_SIZE; i++) {
+        _input[i] = i;
+    }
+
+    _bench("aes", CIPHER_AES_128);
+    /* the last run was CCM, keep its output to compare both ciphers */
+    memcpy(_reference, _output, sizeof(_reference));
+
+    _bench("aes_ct", CIPHER_AES_128_CT);
+    expect(memcmp(_reference, _output, sizeof(_reference)) == 0);
+
+    puts("DONE");
+    return 0;
+}
@@ -0,0 +1,23 @@
+#!/usr/bin/env python3
+
+# Copyright (C) 2020 Freie Universität Berlin
+#
+# This file is subject to the terms and conditions of the GNU Lesser
+# General Public License v2.1. See the file LICENSE in the top level
+# directory for more details.
+
+import sys
+from testrunner import run
+
+
+def testfunc(child):
+    for name in ("aes", "aes_ct"):
+        child.expect(name + r" init: [0-9]+ us\r\n")
+        for mode in ("ecb", "ctr", "ccm"):
+            child.expect(name + " " + mode + r": [0-9]+ us per KiB\r\n")
+    child.expect_exact("DONE")
+
+
+if __name__ == "__main__":
+    # the constant-time variant is slow on small MCUs
+    sys.exit(run(testfunc, timeout=120))
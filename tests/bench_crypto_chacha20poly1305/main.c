@@ -0,0 +1,108 @@
+/*
+ * Copyright (C) 2020 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     tests
+ * @{
+ *
+ * @file
+ * @brief       Throughput benchmark of ChaCha20-Poly1305
+ *
+ * Messages from 64 B to 4 KiB are sealed and opened from a single buffer and
+ * sealed in place as an iolist of three parts, as a packet payload would be.
+ *
+ * @}
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+
+#include "crypto/chacha20poly1305.h"
+#include "test_utils/expect.h"
+#include "xtimer.h"
+
+#define BENCH_SIZE_MIN          (64U)
+#define BENCH_SIZE_MAX          (4096U)
+#define BENCH_BYTES             (16U * 1024U)
+
+static const uint8_t _key[CHACHA20POLY1305_KEY_BYTES] = {
+    0x80, 0x81, 0x82, 0x83, 0x84, 0x85, 0x86, 0x87,
+    0x88, 0x89, 0x8a, 0x8b, 0x8c, 0x8d, 0x8e, 0x8f,
+    0x90, 0x91, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97,
+    0x98, 0x99, 0x9a, 0x9b, 0x9c, 0x9d, 0x9e, 0x9f
+};
+
+static const uint8_t _nonce[CHACHA20POLY1305_NONCE_BYTES] = {
+    0x07, 0x00, 0x00, 0x00, 0x40, 0x41, 0x42, 0x43, 0x44, 0x45, 0x46, 0x47
+};
+
+static const uint8_t _aad[] = {
+    0x50, 0x51, 0x52, 0x53, 0xc0, 0xc1, 0xc2, 0xc3, 0xc4, 0xc5, 0xc6, 0xc7
+};
+
+static uint8_t _input[BENCH_SIZE_MAX];
+static uint8_t _output[BENCH_SIZE_MAX + CHACHA20POLY1305_TAG_BYTES];
+
+static void _print(const char *op, size_t size, uint32_t time, unsigned runs)
+{
+    printf("%s %u B: %" PRIu32 " us, %" PRIu32 " us per KiB\n", op,
+           (unsigned)size, time / runs, (uint32_t)((time * 1024ULL) /
+                                                  (runs * size)));
+}
+
+static void _bench(size_t size)
+{
+    const unsigned runs = BENCH_BYTES / size;
+    uint8_t tag[CHACHA20POLY1305_TAG_BYTES];
+    uint32_t time;
+    size_t len = 0;
+    int res = 0;
+
+    time = xtimer_now_usec();
+    for (unsigned i = 0; i < runs; i++) {
+        chacha20poly1305_encrypt(_output, _input, size, _aad, sizeof(_aad),
+                                 _key, _nonce);
+    }
+    time = xtimer_now_usec() - time;
+    _print("encrypt", size, time, runs);
+
+    time = xtimer_now_usec();
+    for (unsigned i = 0; i < runs; i++) {
+        res = chacha20poly1305_decrypt(_output,
+                                       size + CHACHA20POLY1305_TAG_BYTES,
+                                       _input, &len, _aad, sizeof(_aad),
+                                       _key, _nonce);
+    }
+    time = xtimer_now_usec() - time;
+    expect(res == 1 && len == size);
+    _print("decrypt", size, time, runs);
+
+    /* header, payload and trailer as they would be in a packet */
+    iolist_t iol[3] = {
+        { .iol_next = &iol[1], .iol_base = _input, .iol_len = 8 },
+        { .iol_next = &iol[2], .iol_base = _input + 8, .iol_len = size - 16 },
+        { .iol_next = NULL, .iol_base = _input + size - 8, .iol_len = 8 },
+    };
+    time = xtimer_now_usec();
+    for (unsigned i = 0; i < runs; i++) {
+        chacha20poly1305_encrypt_iol(iol, tag, _aad, sizeof(_aad), _key,
+                                     _nonce);
+    }
+    time = xtimer_now_usec() - time;
+    _print("encrypt_iol", size, time, runs);
+}
+
+int main(void)
+{
+    for (size_t size = BENCH_SIZE_MIN; size <= BENCH_SIZE_MAX; size *= 4) {
+        _bench(size);
+    }
+
+    puts("DONE");
+    return 0;
+}
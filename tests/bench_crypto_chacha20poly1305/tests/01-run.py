@@ -0,0 +1,22 @@
+#!/usr/bin/env python3
+
+# Copyright (C) 2020 Freie Universität Berlin
+#
+# This file is subject to the terms and conditions of the GNU Lesser
+# General Public License v2.1. See the file LICENSE in the top level
+# directory for more details.
+
+import sys
+from testrunner import run
+
+
+def testfunc(child):
+    for size in (64, 256, 1024, 4096):
+        for op in ("encrypt", "decrypt", "encrypt_iol"):
+            child.expect("{} {} B: [0-9]+ us, [0-9]+ us per KiB\r\n"
+                         .format(op, size))
+    child.expect_exact("DONE")
+
+
+if __name__ == "__main__":
+    sys.exit(run(testfunc, timeout=120))
@@ -0,0 +1,227 @@
+/*
+ * Copyright (C) 2020 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     tests
+ * @{
+ *
+ * @file
+ * @brief       Benchmark for head-of-line blocking in GNRC's IPv6 forwarding
+ *
+ * A burst of packets received on one interface is followed by a single
+ * control packet received on another interface. Both are forwarded via a
+ * third interface. The benchmark reports how many packets of the burst were
+ * forwarded and how long the control packet had to wait.
+ *
+ * @}
+ */
+
+#include <inttypes.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "net/ethernet.h"
+#include "net/gnrc.h"
+#include "net/gnrc/ipv6.h"
+#include "net/gnrc/ipv6/nib.h"
+#include "net/gnrc/netif/ethernet.h"
+#include "net/netdev_test.h"
+#include "test_utils/expect.h"
+#include "thread.h"
+#include "xtimer.h"
+
+#define BENCH_BULK_NUMOF        (4U * GNRC_IPV6_MSG_QUEUE_SIZE)
+#define BENCH_NETIF_NUMOF       (3U)
+#define BENCH_NETIF_BULK        (0U)
+#define BENCH_NETIF_CTRL        (1U)
+#define BENCH_NETIF_EGRESS      (2U)
+#define BENCH_SRC_BULK          (0x01)
+#define BENCH_SRC_CTRL          (0x02)
+/* offset of last byte of the source address in a forwarded frame */
+#define BENCH_SRC_OFFSET        (sizeof(ethernet_hdr_t) + \
+                                 offsetof(ipv6_hdr_t, src) + \
+                                 sizeof(ipv6_addr_t) - 1)
+
+#define NBR_MAC                 { 0x57, 0x44, 0x33, 0x22, 0x11, 0x00, }
+#define NBR_LINK_LOCAL          { 0xfe, 0x80, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, \
+                                  0x55, 0x44, 0x33, 0xff, 0xfe, 0x22, 0x11, 0x00, }
+#define DST                     { 0x20, 0x01, 0x0d, 0xb8, 0x00, 0x00, 0xab, 0xcd, \
+                                  0x55, 0x44, 0x33, 0xff, 0xfe, 0x22, 0x11, 0x00, }
+#define DST_PFX_LEN             (64U)
+/* IPv6 header + payload:     version+TC  FL: 0       plen: 16    NH:17 HL:64 */
+#define L2_PAYLOAD              { 0x60, 0x00, 0x00, 0x00, 0x00, 0x10, 0x11, 0x40, \
+                                  /* source: last byte set per packet */          \
+                                  0x20, 0x01, 0x0d, 0xb8, 0x00, 0x00, 0xef, 0x01, \
+                                  0x02, 0xca, 0x4b, 0xef, 0xf4, 0xc2, 0xde, 0x00, \
+                                  /* destination: DST */                          \
+                                  0x20, 0x01, 0x0d, 0xb8, 0x00, 0x00, 0xab, 0xcd, \
+                                  0x55, 0x44, 0x33, 0xff, 0xfe, 0x22, 0x11, 0x00, \
+                                  /* random payload of length 16 */               \
+                                  0x54, 0xb8, 0x59, 0xaf, 0x3a, 0xb4, 0x5c, 0x85, \
+                                  0x1e, 0xce, 0xe2, 0xeb, 0x05, 0x4e, 0xa3, 0x85, }
+
+static const uint8_t _nbr_mac[] = NBR_MAC;
+static const ipv6_addr_t _nbr_link_local = { .u8 = NBR_LINK_LOCAL };
+static const ipv6_addr_t _dst = { .u8 = DST };
+static uint8_t _l2_payload[] = L2_PAYLOAD;
+
+static gnrc_netif_t _netifs[BENCH_NETIF_NUMOF];
+static netdev_test_t _devs[BENCH_NETIF_NUMOF];
+static char _netif_stacks[BENCH_NETIF_NUMOF][THREAD_STACKSIZE_DEFAULT];
+
+static char _injector_stack[THREAD_STACKSIZE_DEFAULT];
+
+static uint32_t _ctrl_sent;
+static volatile uint32_t _ctrl_fwd;
+static volatile uint32_t _bulk_last;
+static volatile unsigned _bulk_fwd;
+
+static int _get_device_type(netdev_t *dev, void *value, size_t max_len)
+{
+    (void)dev;
+    expect(max_len == sizeof(uint16_t));
+    *((uint16_t *)value) = NETDEV_TYPE_ETHERNET;
+    return sizeof(uint16_t);
+}
+
+static int _get_max_packet_size(netdev_t *dev, void *value, size_t max_len)
+{
+    (void)dev;
+    expect(max_len == sizeof(uint16_t));
+    *((uint16_t *)value) = ETHERNET_DATA_LEN;
+    return sizeof(uint16_t);
+}
+
+static int _get_address(netdev_t *dev, void *value, size_t max_len)
+{
+    uint8_t addr[] = { 0xce, 0xab, 0xfe, 0xad, 0xf7, 0x00 };
+
+    expect(max_len >= sizeof(addr));
+    /* make address unique per interface */
+    addr[sizeof(addr) - 1] = (uint8_t)((netdev_test_t *)dev - _devs);
+    memcpy(value, addr, sizeof(addr));
+    return sizeof(addr);
+}
+
+static int _egress_send(netdev_t *dev, const iolist_t *iolist)
+{
+    uint8_t frame[BENCH_SRC_OFFSET + 1];
+    size_t frame_len = 0U;
+    int res = 0;
+
+    (void)dev;
+    for (; iolist != NULL; iolist = iolist->iol_next) {
+        size_t len = iolist->iol_len;
+
+        if ((frame_len + len) > sizeof(frame)) {
+            len = sizeof(frame) - frame_len;
+        }
+        memcpy(&frame[frame_len], iolist->iol_base, len);
+        frame_len += len;
+        res += iolist->iol_len;
+    }
+    if (frame_len < sizeof(frame)) {
+        return res;
+    }
+    if (frame[BENCH_SRC_OFFSET] == BENCH_SRC_CTRL) {
+        _ctrl_fwd = xtimer_now_usec();
+    }
+    else {
+        _bulk_last = xtimer_now_usec();
+        _bulk_fwd++;
+    }
+    return res;
+}
+
+static void _init_netifs(void)
+{
+    for (unsigned i = 0; i < BENCH_NETIF_NUMOF; i++) {
+        netdev_test_setup(&_devs[i], NULL);
+        netdev_test_set_get_cb(&_devs[i], NETOPT_DEVICE_TYPE,
+                               _get_device_type);
+        netdev_test_set_get_cb(&_devs[i], NETOPT_MAX_PDU_SIZE,
+                               _get_max_packet_size);
+        netdev_test_set_get_cb(&_devs[i], NETOPT_ADDRESS, _get_address);
+        expect(gnrc_netif_ethernet_create(&_netifs[i], _netif_stacks[i],
+                                          sizeof(_netif_stacks[i]),
+                                          GNRC_NETIF_PRIO, "bench_eth",
+                                          (netdev_t *)&_devs[i]) == 0);
+    }
+    netdev_test_set_send_cb(&_devs[BENCH_NETIF_EGRESS], _egress_send);
+    /* give interfaces time to initialize */
+    xtimer_usleep(100U * US_PER_MS);
+}
+
+static gnrc_pktsnip_t *_build_recvd_pkt(unsigned netif, uint8_t src)
+{
+    gnrc_pktsnip_t *netif_hdr;
+    gnrc_pktsnip_t *pkt;
+
+    netif_hdr = gnrc_netif_hdr_build(NULL, 0, NULL, 0);
+    expect(netif_hdr);
+    gnrc_netif_hdr_set_netif(netif_hdr->data, &_netifs[netif]);
+    _l2_payload[offsetof(ipv6_hdr_t, src) + sizeof(ipv6_addr_t) - 1] = src;
+    pkt = gnrc_pktbuf_add(netif_hdr, _l2_payload, sizeof(_l2_payload),
+                          GNRC_NETTYPE_IPV6);
+    expect(pkt);
+    return pkt;
+}
+
+static void _inject(unsigned netif, uint8_t src)
+{
+    gnrc_pktsnip_t *pkt = _build_recvd_pkt(netif, src);
+
+    /* if the packet could not be queued it is dropped by netapi */
+    gnrc_netapi_dispatch_receive(GNRC_NETTYPE_IPV6, GNRC_NETREG_DEMUX_CTX_ALL,
+                                 pkt);
+}
+
+static void *_injector(void *arg)
+{
+    (void)arg;
+    /* this thread has a higher priority than IPv6, so the whole burst is
+     * queued before the first packet is handled */
+    for (unsigned i = 0; i < BENCH_BULK_NUMOF; i++) {
+        _inject(BENCH_NETIF_BULK, BENCH_SRC_BULK);
+    }
+    _ctrl_sent = xtimer_now_usec();
+    _inject(BENCH_NETIF_CTRL, BENCH_SRC_CTRL);
+    return NULL;
+}
+
+int main(void)
+{
+    uint32_t start;
+
+    _init_netifs();
+    /* define neighbor to forward to */
+    expect(gnrc_ipv6_nib_nc_set(&_nbr_link_local,
+                                _netifs[BENCH_NETIF_EGRESS].pid,
+                                _nbr_mac, sizeof(_nbr_mac)) == 0);
+    /* set route to neighbor */
+    expect(gnrc_ipv6_nib_ft_add(&_dst, DST_PFX_LEN, &_nbr_link_local,
+                                _netifs[BENCH_NETIF_EGRESS].pid, 0) == 0);
+
+    start = xtimer_now_usec();
+    thread_create(_injector_stack, sizeof(_injector_stack), GNRC_IPV6_PRIO - 1,
+                  THREAD_CREATE_STACKTEST, _injector, NULL, "injector");
+    /* let IPv6 forward everything */
+    xtimer_usleep(100U * US_PER_MS);
+    printf("Forwarded %u of %u bulk packets: %" PRIu32 " us\n",
+           _bulk_fwd, BENCH_BULK_NUMOF, _bulk_last - start);
+    if (_ctrl_fwd != 0) {
+        printf("Control packet latency: %" PRIu32 " us\n",
+               _ctrl_fwd - _ctrl_sent);
+    }
+    else {
+        puts("Control packet dropped");
+    }
+    puts("DONE");
+    return 0;
+}
@@ -0,0 +1,248 @@
+/*
+ * Copyright (C) 2020 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     tests
+ * @{
+ *
+ * @file
+ * @brief       Benchmark for the per-packet cost of 6LoWPAN IPHC encoding
+ *
+ * @}
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "net/gnrc.h"
+#include "net/gnrc/ipv6/hdr.h"
+#include "net/gnrc/netif/ieee802154.h"
+#include "net/gnrc/netif/internal.h"
+#include "net/gnrc/sixlowpan.h"
+#include "net/gnrc/sixlowpan/ctx.h"
+#include "net/gnrc/sixlowpan/iphc.h"
+#include "net/gnrc/udp.h"
+#include "net/netdev_test.h"
+#include "test_utils/expect.h"
+#include "xtimer.h"
+
+#define BENCH_RUNS                  (1000U)
+#define BENCH_PORT                  (61616U)
+#define BENCH_MAX_FRAME_SIZE        (127U)
+#define BENCH_PREFIX                { { 0x20, 0x01, 0x0d, 0xb8 } }
+#define BENCH_PREFIX_LEN            (64U)
+#define BENCH_CID                   (0U)
+
+static const uint8_t _local_l2addr[] = {
+    0x02, 0x00, 0x00, 0xff, 0xfe, 0x00, 0x00, 0x01
+};
+static const uint8_t _remote_l2addr[] = {
+    0x02, 0x00, 0x00, 0xff, 0xfe, 0x00, 0x00, 0x02
+};
+static const uint8_t _payload[16];
+
+static gnrc_netif_t _netif;
+static char _netif_stack[THREAD_STACKSIZE_DEFAULT];
+static netdev_test_t _dev;
+
+static uint8_t _frame[BENCH_MAX_FRAME_SIZE];
+static size_t _frame_len;
+
+static int _get_device_type(netdev_t *netdev, void *value, size_t max_len)
+{
+    (void)netdev;
+    expect(max_len == sizeof(uint16_t));
+    *((uint16_t *)value) = NETDEV_TYPE_IEEE802154;
+    return sizeof(uint16_t);
+}
+
+static int _get_proto(netdev_t *netdev, void *value, size_t max_len)
+{
+    (void)netdev;
+    expect(max_len == sizeof(gnrc_nettype_t));
+    *((gnrc_nettype_t *)value) = GNRC_NETTYPE_SIXLOWPAN;
+    return sizeof(gnrc_nettype_t);
+}
+
+static int _get_max_pdu_size(netdev_t *netdev, void *value, size_t max_len)
+{
+    (void)netdev;
+    expect(max_len == sizeof(uint16_t));
+    *((uint16_t *)value) = BENCH_MAX_FRAME_SIZE;
+    return sizeof(uint16_t);
+}
+
+static int _get_src_len(netdev_t *netdev, void *value, size_t max_len)
+{
+    (void)netdev;
+    expect(max_len == sizeof(uint16_t));
+    *((uint16_t *)value) = sizeof(_local_l2addr);
+    return sizeof(uint16_t);
+}
+
+static int _get_addr_long(netdev_t *netdev, void *value, size_t max_len)
+{
+    (void)netdev;
+    expect(max_len >= sizeof(_local_l2addr));
+    memcpy(value, _local_l2addr, sizeof(_local_l2addr));
+    return sizeof(_local_l2addr);
+}
+
+static int _send(netdev_t *netdev, const iolist_t *iolist)
+{
+    (void)netdev;
+    _frame_len = 0;
+    for (; iolist != NULL; iolist = iolist->iol_next) {
+        if ((_frame_len + iolist->iol_len) > sizeof(_frame)) {
+            return -ENOBUFS;
+        }
+        memcpy(&_frame[_frame_len], iolist->iol_base, iolist->iol_len);
+        _frame_len += iolist->iol_len;
+    }
+    return _frame_len;
+}
+
+static void _init_netif(void)
+{
+    netdev_test_setup(&_dev, NULL);
+    netdev_test_set_get_cb(&_dev, NETOPT_DEVICE_TYPE, _get_device_type);
+    netdev_test_set_get_cb(&_dev, NETOPT_PROTO, _get_proto);
+    netdev_test_set_get_cb(&_dev, NETOPT_MAX_PDU_SIZE, _get_max_pdu_size);
+    netdev_test_set_get_cb(&_dev, NETOPT_SRC_LEN, _get_src_len);
+    netdev_test_set_get_cb(&_dev, NETOPT_ADDRESS_LONG, _get_addr_long);
+    netdev_test_set_send_cb(&_dev, _send);
+    /* run the interface with a lower priority than main, so it does not
+     * interfere with the measurements: packets are dropped once its queue is
+     * full */
+    gnrc_netif_ieee802154_create(&_netif, _netif_stack, sizeof(_netif_stack),
+                                 THREAD_PRIORITY_MAIN + 1, "bench_netif",
+                                 (netdev_t *)&_dev);
+    /* give interface time to initialize */
+    xtimer_usleep(100U * US_PER_MS);
+}
+
+static gnrc_pktsnip_t *_build_pkt(const ipv6_addr_t *src,
+                                  const ipv6_addr_t *dst)
+{
+    gnrc_pktsnip_t *pkt, *netif_hdr;
+
+    pkt = gnrc_pktbuf_add(NULL, _payload, sizeof(_payload),
+                          GNRC_NETTYPE_UNDEF);
+    expect(pkt != NULL);
+    pkt = gnrc_udp_hdr_build(pkt, BENCH_PORT, BENCH_PORT);
+    expect(pkt != NULL);
+    pkt = gnrc_ipv6_hdr_build(pkt, src, dst);
+    expect(pkt != NULL);
+    ((ipv6_hdr_t *)pkt->data)->hl = 64;
+    ((ipv6_hdr_t *)pkt->data)->nh = PROTNUM_UDP;
+    netif_hdr = gnrc_netif_hdr_build(NULL, 0, _remote_l2addr,
+                                     sizeof(_remote_l2addr));
+    expect(netif_hdr != NULL);
+    gnrc_netif_hdr_set_netif(netif_hdr->data, &_netif);
+    netif_hdr->next = pkt;
+    return netif_hdr;
+}
+
+static void _send_pkt(const ipv6_addr_t *src, const ipv6_addr_t *dst)
+{
+    gnrc_pktsnip_t *pkt = _build_pkt(src, dst);
+
+    /* the 6LoWPAN thread has a higher priority than main, so the packet is
+     * encoded before this returns */
+    if (!gnrc_netapi_dispatch_send(GNRC_NETTYPE_SIXLOWPAN,
+                                   GNRC_NETREG_DEMUX_CTX_ALL, pkt)) {
+        gnrc_pktbuf_release(pkt);
+    }
+}
+
+static void _flush_cache(void)
+{
+#ifdef MODULE_GNRC_SIXLOWPAN_IPHC_CACHE
+    gnrc_sixlowpan_iphc_cache_flush();
+#endif
+}
+
+static void _verify(const char *name, const ipv6_addr_t *src,
+                    const ipv6_addr_t *dst)
+{
+    uint8_t first[BENCH_MAX_FRAME_SIZE];
+    size_t first_len;
+
+    printf("Verifying that %s compression is stable: ", name);
+    _flush_cache();
+    _send_pkt(src, dst);
+    /* let interface send the frame */
+    xtimer_usleep(10U * US_PER_MS);
+    memcpy(first, _frame, _frame_len);
+    first_len = _frame_len;
+    _send_pkt(src, dst);
+    xtimer_usleep(10U * US_PER_MS);
+    if ((first_len == 0) || (first_len != _frame_len) ||
+        (memcmp(first, _frame, first_len) != 0)) {
+        puts("FAIL");
+    }
+    else {
+        puts("OK");
+    }
+}
+
+static void _bench(const char *name, const ipv6_addr_t *src,
+                   const ipv6_addr_t *dst, bool cold)
+{
+    uint32_t start, stop;
+
+    start = xtimer_now_usec();
+    for (unsigned i = 0; i < BENCH_RUNS; i++) {
+        if (cold) {
+            _flush_cache();
+        }
+        _send_pkt(src, dst);
+    }
+    stop = xtimer_now_usec();
+    printf("Compressing 1.000 x %s (%s): %" PRIu32 " us\n", name,
+           (cold) ? "cold" : "warm", stop - start);
+    /* let interface drain its queue */
+    xtimer_usleep(10U * US_PER_MS);
+}
+
+int main(void)
+{
+    ipv6_addr_t prefix = BENCH_PREFIX;
+    ipv6_addr_t ll_src = IPV6_ADDR_UNSPECIFIED;
+    ipv6_addr_t ll_dst = IPV6_ADDR_UNSPECIFIED;
+    ipv6_addr_t ctx_src, ctx_dst;
+    eui64_t iid;
+
+    _init_netif();
+    expect(gnrc_sixlowpan_ctx_update(BENCH_CID, &prefix, BENCH_PREFIX_LEN,
+                                     UINT16_MAX, true) != NULL);
+    expect(gnrc_netif_ipv6_get_iid(&_netif, &iid) == 0);
+    ipv6_addr_set_link_local_prefix(&ll_src);
+    ipv6_addr_set_aiid(&ll_src, iid.uint8);
+    expect(gnrc_netif_ipv6_iid_from_addr(&_netif, _remote_l2addr,
+                                         sizeof(_remote_l2addr), &iid) == 0);
+    ipv6_addr_set_link_local_prefix(&ll_dst);
+    ipv6_addr_set_aiid(&ll_dst, iid.uint8);
+    ctx_src = ll_src;
+    ctx_dst = ll_dst;
+    ipv6_addr_init_prefix(&ctx_src, &prefix, BENCH_PREFIX_LEN);
+    ipv6_addr_init_prefix(&ctx_dst, &prefix, BENCH_PREFIX_LEN);
+
+    _verify("link-local", &ll_src, &ll_dst);
+    _verify("context-based", &ctx_src, &ctx_dst);
+
+    if (IS_USED(MODULE_GNRC_SIXLOWPAN_IPHC_CACHE)) {
+        _bench("link-local", &ll_src, &ll_dst, true);
+        _bench("context-based", &ctx_src, &ctx_dst, true);
+    }
+    _bench("link-local", &ll_src, &ll_dst, false);
+    _bench("context-based", &ctx_src, &ctx_dst, false);
+    puts("DONE");
+    return 0;
+}
@@ -0,0 +1,21 @@
+#!/usr/bin/env python3
+
+# Copyright (C) 2020 Freie Universität Berlin
+#
+# This file is subject to the terms and conditions of the GNU Lesser
+# General Public License v2.1. See the file LICENSE in the top level
+# directory for more details.
+
+import sys
+from testrunner import run
+
+
+def testfunc(child):
+    child.expect_exact("Verifying that link-local compression is stable: OK\r\n")
+    child.expect_exact("Verifying that context-based compression is stable: OK\r\n")
+    child.expect(r"Compressing 1\.000 x link-local \((cold|warm)\): [0-9]+ us\r\n")
+    child.expect_exact("DONE")
+
+
+if __name__ == "__main__":
+    sys.exit(run(testfunc))
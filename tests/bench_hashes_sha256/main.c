@@ -0,0 +1,93 @@
+/*
+ * Copyright (C) 2020 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     tests
+ * @{
+ *
+ * @file
+ * @brief       Throughput benchmark of SHA-256
+ *
+ * A single message is hashed with sha256(), then @ref SHA2XX_LANES messages
+ * are hashed one after the other and with sha256_update_multi(), as done when
+ * verifying several firmware slots.
+ *
+ * @}
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "hashes/sha256.h"
+#include "test_utils/expect.h"
+#include "xtimer.h"
+
+#define BENCH_SIZE              (1024U)
+#define BENCH_RUNS              (64U)
+#define BENCH_MSGS              (SHA2XX_LANES)
+
+static uint8_t _input[BENCH_MSGS][BENCH_SIZE];
+static uint8_t _digest[BENCH_MSGS][SHA256_DIGEST_LENGTH];
+static uint8_t _reference[BENCH_MSGS][SHA256_DIGEST_LENGTH];
+static sha256_context_t _ctx[BENCH_MSGS];
+
+static void _print(const char *name, uint32_t time, unsigned msgs)
+{
+    printf("%s: %" PRIu32 " us per KiB\n", name,
+           time / (BENCH_RUNS * msgs * (BENCH_SIZE / 1024)));
+}
+
+int main(void)
+{
+    sha256_context_t *ctx[BENCH_MSGS];
+    const void *data[BENCH_MSGS];
+    uint32_t time;
+
+    for (unsigned i = 0; i < BENCH_MSGS; i++) {
+        for (unsigned j = 0; j < BENCH_SIZE; j++) {
+            _input[i][j] = i + j;
+        }
+        ctx[i] = &_ctx[i];
+        data[i] = _input[i];
+    }
+
+    time = xtimer_now_usec();
+    for (unsigned i = 0; i < BENCH_RUNS; i++) {
+        sha256(_input[0], BENCH_SIZE, _digest[0]);
+    }
+    time = xtimer_now_usec() - time;
+    _print("sha256", time, 1);
+
+    time = xtimer_now_usec();
+    for (unsigned i = 0; i < BENCH_RUNS; i++) {
+        for (unsigned j = 0; j < BENCH_MSGS; j++) {
+            sha256(_input[j], BENCH_SIZE, _reference[j]);
+        }
+    }
+    time = xtimer_now_usec() - time;
+    _print("sha256 sequential", time, BENCH_MSGS);
+
+    time = xtimer_now_usec();
+    for (unsigned i = 0; i < BENCH_RUNS; i++) {
+        for (unsigned j = 0; j < BENCH_MSGS; j++) {
+            sha256_init(ctx[j]);
+        }
+        sha256_update_multi(ctx, data, BENCH_SIZE, BENCH_MSGS);
+        for (unsigned j = 0; j < BENCH_MSGS; j++) {
+            sha256_final(ctx[j], _digest[j]);
+        }
+    }
+    time = xtimer_now_usec() - time;
+    _print("sha256 multi", time, BENCH_MSGS);
+
+    expect(memcmp(_reference, _digest, sizeof(_reference)) == 0);
+
+    puts("DONE");
+    return 0;
+}
@@ -0,0 +1,55 @@
+'use strict';
+
+const FIELDS = ['t', 'h', 'p'];
+const UNITS = { t: ' \u00b0C', h: ' %', p: ' hPa' };
+const STALE_AFTER_MS = 60 * 1000;
+
+let cache = {};
+
+function format(field, value) {
+    if (value === undefined || value === null) {
+        return '--';
+    }
+    return value.toFixed(1) + UNITS[field];
+}
+
+function show(node, reading) {
+    for (const field of FIELDS) {
+        const cell = document.getElementById(field + node);
+        if (!cell) {
+            continue;
+        }
+        cell.textContent = format(field, reading[field]);
+        cell.classList.toggle('stale', Date.now() - reading.time > STALE_AFTER_MS);
+        cell.classList.toggle('alert', field === 't' && reading[field] > 40);
+    }
+}
+
+async function load() {
+    const response = await fetch('data.json');
+    if (!response.ok) {
+        throw new Error('failed to load data: ' + response.status);
+    }
+    const data = await response.json();
+    for (const reading of data.readings) {
+        cache[reading.node] = reading;
+        show(reading.node, reading);
+    }
+}
+
+async function refresh(node) {
+    try {
+        await load();
+    }
+    catch (err) {
+        console.error(err);
+    }
+    if (cache[node]) {
+        show(node, cache[node]);
+    }
+}
+
+document.addEventListener('DOMContentLoaded', () => {
+    load().catch((err) => console.error(err));
+    setInterval(() => load().catch((err) => console.error(err)), 10 * 1000);
+});
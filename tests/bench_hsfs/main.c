@@ -0,0 +1,232 @@
+/*
+ * Copyright (C) 2020 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     tests
+ * @{
+ *
+ * @file
+ * @brief       Benchmark of the HSFS compressed image file system
+ *
+ * The files in `assets/` are served by constfs and by hsfs, from an image
+ * linked into the firmware and, with module `hsfs_mtd`, from an image copied
+ * to the first MTD device. For every file system, the files are stat'ed,
+ * read sequentially and read at random offsets. The content read from hsfs
+ * is checked against the constfs copy.
+ *
+ * @warning With module `hsfs_mtd`, the data on MTD_0 is destroyed.
+ *
+ * @}
+ */
+
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include "board.h"
+#include "fs/constfs.h"
+#include "fs/hsfs.h"
+#include "kernel_defines.h"
+#include "random.h"
+#include "test_utils/expect.h"
+#include "vfs.h"
+#include "xtimer.h"
+
+#include "blob/assets/app.js.h"
+#include "blob/assets/data.json.h"
+#include "blob/assets/index.html.h"
+#include "blob/assets/style.css.h"
+#include "blob/assets.hsfs.h"
+
+#define BENCH_STAT_ROUNDS       (100U)
+#define BENCH_READ_ROUNDS       (10U)
+#define BENCH_RANDOM_READS      (200U)
+#define BENCH_CHUNK_SIZE        (64U)
+#define BENCH_RANDOM_SIZE       (32U)
+
+#if defined(MTD_0) && IS_USED(MODULE_HSFS_MTD)
+#define BENCH_MTD               1
+#else
+#define BENCH_MTD               0
+#endif
+
+static const constfs_file_t _files[] = {
+    { .path = "/app.js", .data = app_js, .size = sizeof(app_js) },
+    { .path = "/data.json", .data = data_json, .size = sizeof(data_json) },
+    { .path = "/index.html", .data = index_html, .size = sizeof(index_html) },
+    { .path = "/style.css", .data = style_css, .size = sizeof(style_css) },
+};
+
+static const constfs_t _constfs = {
+    .files = _files,
+    .nfiles = ARRAY_SIZE(_files),
+};
+
+static hsfs_t _hsfs = {
+    .image = assets_hsfs,
+};
+
+#if BENCH_MTD
+static hsfs_t _hsfs_mtd;
+#endif
+
+static vfs_mount_t _mounts[] = {
+    {
+        .fs = &constfs_file_system,
+        .mount_point = "/constfs",
+        .private_data = (void *)&_constfs,
+    },
+    {
+        .fs = &hsfs_file_system,
+        .mount_point = "/hsfs",
+        .private_data = &_hsfs,
+    },
+#if BENCH_MTD
+    {
+        .fs = &hsfs_file_system,
+        .mount_point = "/hsfs_mtd",
+        .private_data = &_hsfs_mtd,
+    },
+#endif
+};
+
+static uint8_t _buf[BENCH_CHUNK_SIZE];
+
+static void _path(char *buf, size_t len, const vfs_mount_t *mount, unsigned i)
+{
+    snprintf(buf, len, "%s%s", mount->mount_point, _files[i].path);
+}
+
+static uint32_t _bench_stat(const vfs_mount_t *mount)
+{
+    char path[32];
+    struct stat st;
+    uint32_t time = 0;
+
+    for (unsigned i = 0; i < ARRAY_SIZE(_files); i++) {
+        _path(path, sizeof(path), mount, i);
+        uint32_t start = xtimer_now_usec();
+        for (unsigned round = 0; round < BENCH_STAT_ROUNDS; round++) {
+            expect(vfs_stat(path, &st) == 0);
+        }
+        time += xtimer_now_usec() - start;
+        expect((size_t)st.st_size == _files[i].size);
+    }
+    return time;
+}
+
+static uint32_t _bench_read(const vfs_mount_t *mount)
+{
+    char path[32];
+    uint32_t time = 0;
+
+    for (unsigned i = 0; i < ARRAY_SIZE(_files); i++) {
+        _path(path, sizeof(path), mount, i);
+        int fd = vfs_open(path, O_RDONLY, 0);
+        expect(fd >= 0);
+        for (unsigned round = 0; round < BENCH_READ_ROUNDS; round++) {
+            size_t pos = 0;
+            ssize_t n;
+
+            expect(vfs_lseek(fd, 0, SEEK_SET) == 0);
+            uint32_t start = xtimer_now_usec();
+            while ((n = vfs_read(fd, _buf, sizeof(_buf))) > 0) {
+                /* the time of the check is negligible */
+                expect(memcmp(_buf, &_files[i].data[pos], n) == 0);
+                pos += n;
+            }
+            time += xtimer_now_usec() - start;
+            expect(pos == _files[i].size);
+        }
+        expect(vfs_close(fd) == 0);
+    }
+    return time;
+}
+
+static uint32_t _bench_random(const vfs_mount_t *mount)
+{
+    char path[32];
+    uint32_t time = 0;
+
+    /* the same sequence of accesses for every file system */
+    random_init(0);
+    for (unsigned i = 0; i < ARRAY_SIZE(_files); i++) {
+        const constfs_file_t *file = &_files[i];
+
+        _path(path, sizeof(path), mount, i);
+        int fd = vfs_open(path, O_RDONLY, 0);
+        expect(fd >= 0);
+        for (unsigned j = 0; j < BENCH_RANDOM_READS / ARRAY_SIZE(_files); j++) {
+            uint32_t pos = random_uint32_range(0, file->size - BENCH_RANDOM_SIZE);
+
+            uint32_t start = xtimer_now_usec();
+            expect(vfs_lseek(fd, pos, SEEK_SET) == (off_t)pos);
+            expect(vfs_read(fd, _buf, BENCH_RANDOM_SIZE) == BENCH_RANDOM_SIZE);
+            time += xtimer_now_usec() - start;
+            expect(memcmp(_buf, &file->data[pos], BENCH_RANDOM_SIZE) == 0);
+        }
+        expect(vfs_close(fd) == 0);
+    }
+    return time;
+}
+
+#if BENCH_MTD
+static void _copy_image(mtd_dev_t *mtd)
+{
+    uint32_t sector_size = mtd->page_size * mtd->pages_per_sector;
+    uint32_t erase_size = (sizeof(assets_hsfs) + sector_size - 1) /
+                          sector_size * sector_size;
+
+    expect(mtd_init(mtd) == 0);
+    expect(mtd_erase(mtd, 0, erase_size) == 0);
+    for (uint32_t addr = 0; addr < sizeof(assets_hsfs); addr += mtd->page_size) {
+        uint32_t len = sizeof(assets_hsfs) - addr;
+        if (len > mtd->page_size) {
+            len = mtd->page_size;
+        }
+        expect(mtd_write(mtd, &assets_hsfs[addr], addr, len) == 0);
+    }
+    _hsfs_mtd.mtd = mtd;
+    _hsfs_mtd.mtd_offset = 0;
+}
+#endif
+
+int main(void)
+{
+    size_t files_size = 0;
+
+    for (unsigned i = 0; i < ARRAY_SIZE(_files); i++) {
+        files_size += _files[i].size;
+    }
+    printf("image: %u bytes, files: %u bytes\n",
+           (unsigned)sizeof(assets_hsfs), (unsigned)files_size);
+
+#if BENCH_MTD
+    _copy_image(MTD_0);
+#endif
+
+    for (unsigned i = 0; i < ARRAY_SIZE(_mounts); i++) {
+        const vfs_mount_t *mount = &_mounts[i];
+        uint32_t stat, read, random;
+
+        expect(vfs_mount(&_mounts[i]) == 0);
+        stat = _bench_stat(mount);
+        read = _bench_read(mount);
+        random = _bench_random(mount);
+        expect(vfs_umount(&_mounts[i]) == 0);
+        printf("%s: stat: %" PRIu32 " us, read: %" PRIu32 " KiB/s, "
+               "random read: %" PRIu32 " us\n", mount->mount_point + 1,
+               stat, (uint32_t)((uint64_t)files_size * BENCH_READ_ROUNDS *
+                                1000000 / 1024 / (read ? read : 1)),
+               random);
+    }
+    puts("DONE");
+    return 0;
+}
@@ -0,0 +1,22 @@
+#!/usr/bin/env python3
+
+# Copyright (C) 2020 Freie Universität Berlin
+#
+# This file is subject to the terms and conditions of the GNU Lesser
+# General Public License v2.1. See the file LICENSE in the top level
+# directory for more details.
+
+import sys
+from testrunner import run
+
+
+def testfunc(child):
+    child.expect(r"image: [0-9]+ bytes, files: [0-9]+ bytes\r\n")
+    for name in ("constfs", "hsfs"):
+        child.expect(r"{}: stat: [0-9]+ us, read: [0-9]+ KiB/s, "
+                     r"random read: [0-9]+ us\r\n".format(name))
+    child.expect_exact("DONE")
+
+
+if __name__ == "__main__":
+    sys.exit(run(testfunc, timeout=60))
@@ -0,0 +1,138 @@
+/*
+ * Copyright (C) 2020 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     tests
+ * @{
+ *
+ * @file
+ * @brief       Benchmark of the key-value store
+ *
+ * A set of configuration keys is stored on the first sectors of the board's
+ * MTD device (or of the first SD card). The time of setting, reading and
+ * repeatedly updating the keys is measured, as well as the time
+ * kvstore_init() takes to rebuild the index once all sectors were used.
+ *
+ * @warning The data on the device is destroyed.
+ *
+ * @}
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "board.h"
+#include "kernel_defines.h"
+#include "kvstore.h"
+#include "mtd.h"
+#include "test_utils/expect.h"
+#include "xtimer.h"
+
+/* Configure MTD device for SD card if none is provided */
+#if !defined(MTD_0) && MODULE_MTD_SDCARD
+#include "mtd_sdcard.h"
+#include "sdcard_spi.h"
+#include "sdcard_spi_params.h"
+
+#define SDCARD_SPI_NUM ARRAY_SIZE(sdcard_spi_params)
+
+/* SD card devices are provided by drivers/sdcard_spi/sdcard_spi.c */
+extern sdcard_spi_t sdcard_spi_devs[SDCARD_SPI_NUM];
+
+/* Configure MTD device for the first SD card */
+static mtd_sdcard_t mtd_sdcard_dev = {
+    .base = {
+        .driver = &mtd_sdcard_driver
+    },
+    .sd_card = &sdcard_spi_devs[0],
+    .params = &sdcard_spi_params[0],
+};
+static mtd_dev_t *mtd0 = (mtd_dev_t*)&mtd_sdcard_dev;
+#define MTD_0 mtd0
+#endif
+
+#define BENCH_SECTORS           (8U)
+#define BENCH_KEYS              (64U)
+#define BENCH_UPDATES           (2048U)
+#define BENCH_VALUE_SIZE        (16U)
+
+static kvstore_sector_t _sectors[BENCH_SECTORS];
+static kvstore_entry_t _entries[BENCH_KEYS + 1];
+static kvstore_t _kvs = KVSTORE_INIT(NULL, 0, _sectors, _entries);
+
+static void _key(char *key, size_t len, unsigned i)
+{
+    snprintf(key, len, "module%u/param%u", i / 8, i % 8);
+}
+
+static void _value(uint8_t *value, unsigned i)
+{
+    for (unsigned j = 0; j < BENCH_VALUE_SIZE; j++) {
+        value[j] = i + j;
+    }
+}
+
+int main(void)
+{
+    uint8_t value[BENCH_VALUE_SIZE];
+    char key[CONFIG_KVSTORE_KEY_MAX];
+    uint32_t time;
+
+    _kvs.mtd = MTD_0;
+    expect(kvstore_init(&_kvs) == 0);
+    expect(kvstore_format(&_kvs) == 0);
+
+    time = xtimer_now_usec();
+    for (unsigned i = 0; i < BENCH_KEYS; i++) {
+        _key(key, sizeof(key), i);
+        _value(value, i);
+        expect(kvstore_set(&_kvs, key, value, sizeof(value)) == 0);
+    }
+    time = xtimer_now_usec() - time;
+    printf("set: %" PRIu32 " us per key, %u keys\n", time / BENCH_KEYS,
+           BENCH_KEYS);
+
+    time = xtimer_now_usec();
+    for (unsigned i = 0; i < BENCH_KEYS; i++) {
+        _key(key, sizeof(key), i);
+        expect(kvstore_get(&_kvs, key, value, sizeof(value)) ==
+               sizeof(value));
+    }
+    time = xtimer_now_usec() - time;
+    printf("get: %" PRIu32 " us per key\n", time / BENCH_KEYS);
+
+    /* a few keys change often, the store is compacted a couple of times */
+    time = xtimer_now_usec();
+    for (unsigned i = 0; i < BENCH_UPDATES; i++) {
+        _key(key, sizeof(key), i % 8);
+        _value(value, i);
+        expect(kvstore_set(&_kvs, key, value, sizeof(value)) == 0);
+    }
+    time = xtimer_now_usec() - time;
+    printf("update: %" PRIu32 " us per key, %" PRIu32 " compactions, %"
+           PRIu32 " erases\n", time / BENCH_UPDATES, _kvs.stats.compactions,
+           _kvs.stats.erases);
+
+    /* every sector was used, the full ones have a summary */
+    time = xtimer_now_usec();
+    expect(kvstore_init(&_kvs) == 0);
+    time = xtimer_now_usec() - time;
+    printf("rebuild: %" PRIu32 " us, %u sectors\n", time, BENCH_SECTORS);
+
+    for (unsigned i = 0; i < BENCH_KEYS; i++) {
+        uint8_t expected[BENCH_VALUE_SIZE];
+        _key(key, sizeof(key), i);
+        _value(expected, (i < 8) ? BENCH_UPDATES - 8 + i : i);
+        expect(kvstore_get(&_kvs, key, value, sizeof(value)) ==
+               sizeof(value));
+        expect(memcmp(value, expected, sizeof(value)) == 0);
+    }
+    puts("DONE");
+    return 0;
+}
@@ -0,0 +1,24 @@
+#!/usr/bin/env python3
+
+# Copyright (C) 2020 Freie Universität Berlin
+#
+# This file is subject to the terms and conditions of the GNU Lesser
+# General Public License v2.1. See the file LICENSE in the top level
+# directory for more details.
+
+import sys
+from testrunner import run
+
+
+def testfunc(child):
+    child.expect(r"set: [0-9]+ us per key, [0-9]+ keys\r\n")
+    child.expect(r"get: [0-9]+ us per key\r\n")
+    child.expect(r"update: [0-9]+ us per key, [0-9]+ compactions, "
+                 r"[0-9]+ erases\r\n")
+    child.expect(r"rebuild: [0-9]+ us, [0-9]+ sectors\r\n")
+    child.expect_exact("DONE")
+
+
+if __name__ == "__main__":
+    # the file based MTD driver of native is slow
+    sys.exit(run(testfunc, timeout=120))
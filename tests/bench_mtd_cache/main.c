@@ -0,0 +1,171 @@
+/*
+ * Copyright (C) 2020 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     tests
+ * @{
+ *
+ * @file
+ * @brief       Benchmark for the MTD block cache
+ *
+ * A littlefs2 file system is formatted on the first sectors of the board's
+ * MTD device (or of the first SD card), once directly and once through
+ * mtd_cache. Files are created, their metadata is looked up repeatedly and a
+ * larger file is written with an fsync after every chunk.
+ *
+ * @warning The file system on the device is destroyed.
+ *
+ * @}
+ */
+
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include "board.h"
+#include "fs/littlefs2_fs.h"
+#include "kernel_defines.h"
+#include "mtd.h"
+#include "mtd_cache.h"
+#include "test_utils/expect.h"
+#include "vfs.h"
+#include "xtimer.h"
+
+/* Configure MTD device for SD card if none is provided */
+#if !defined(MTD_0) && MODULE_MTD_SDCARD
+#include "mtd_sdcard.h"
+#include "sdcard_spi.h"
+#include "sdcard_spi_params.h"
+
+#define SDCARD_SPI_NUM ARRAY_SIZE(sdcard_spi_params)
+
+/* SD card devices are provided by drivers/sdcard_spi/sdcard_spi.c */
+extern sdcard_spi_t sdcard_spi_devs[SDCARD_SPI_NUM];
+
+/* Configure MTD device for the first SD card */
+static mtd_sdcard_t mtd_sdcard_dev = {
+    .base = {
+        .driver = &mtd_sdcard_driver
+    },
+    .sd_card = &sdcard_spi_devs[0],
+    .params = &sdcard_spi_params[0],
+};
+static mtd_dev_t *mtd0 = (mtd_dev_t*)&mtd_sdcard_dev;
+#define MTD_0 mtd0
+#endif
+
+#define BENCH_BLOCKS            (64U)
+#define BENCH_FILES             (8U)
+#define BENCH_STAT_ROUNDS       (16U)
+#define BENCH_FILE_SIZE         (16U * 1024U)
+#define BENCH_CHUNK_SIZE        (256U)
+#define BENCH_CACHE_PAGES       (8U)
+/* largest page size of the supported devices (SD cards) */
+#define BENCH_PAGE_SIZE_MAX     (512U)
+#define BENCH_MOUNT_POINT       "/bench"
+
+static mtd_cache_entry_t _entries[BENCH_CACHE_PAGES];
+static uint8_t _cache_buf[BENCH_CACHE_PAGES * BENCH_PAGE_SIZE_MAX];
+static mtd_cache_t _cache = MTD_CACHE_INIT(NULL, _entries, _cache_buf);
+
+static littlefs2_desc_t _lfs;
+static vfs_mount_t _mount = {
+    .fs = &littlefs2_file_system,
+    .mount_point = BENCH_MOUNT_POINT,
+    .private_data = &_lfs,
+};
+static uint8_t _buf[BENCH_CHUNK_SIZE];
+
+static void _path(char *buf, size_t len, unsigned i)
+{
+    snprintf(buf, len, BENCH_MOUNT_POINT "/f%u", i);
+}
+
+static uint32_t _create_files(void)
+{
+    uint32_t start = xtimer_now_usec();
+    char path[16];
+
+    for (unsigned i = 0; i < BENCH_FILES; i++) {
+        _path(path, sizeof(path), i);
+        int fd = vfs_open(path, O_CREAT | O_TRUNC | O_WRONLY, 0);
+        expect(fd >= 0);
+        expect(vfs_write(fd, path, sizeof(path)) == sizeof(path));
+        expect(vfs_close(fd) == 0);
+    }
+    return xtimer_now_usec() - start;
+}
+
+static uint32_t _stat_files(void)
+{
+    uint32_t start = xtimer_now_usec();
+    char path[16];
+    struct stat st;
+
+    for (unsigned round = 0; round < BENCH_STAT_ROUNDS; round++) {
+        for (unsigned i = 0; i < BENCH_FILES; i++) {
+            _path(path, sizeof(path), i);
+            expect(vfs_stat(path, &st) == 0);
+            expect(st.st_size == sizeof(path));
+        }
+    }
+    return xtimer_now_usec() - start;
+}
+
+static uint32_t _write_file(void)
+{
+    uint32_t start = xtimer_now_usec();
+    int fd = vfs_open(BENCH_MOUNT_POINT "/big", O_CREAT | O_TRUNC | O_WRONLY, 0);
+
+    expect(fd >= 0);
+    for (unsigned i = 0; i < (BENCH_FILE_SIZE / sizeof(_buf)); i++) {
+        memset(_buf, i, sizeof(_buf));
+        expect(vfs_write(fd, _buf, sizeof(_buf)) == sizeof(_buf));
+        expect(vfs_fsync(fd) == 0);
+    }
+    expect(vfs_close(fd) == 0);
+    return xtimer_now_usec() - start;
+}
+
+static void _bench(const char *name, mtd_dev_t *dev)
+{
+    uint32_t format, create, stat, write;
+
+    memset(&_lfs, 0, sizeof(_lfs));
+    _lfs.dev = dev;
+    _lfs.config.block_count = BENCH_BLOCKS;
+    format = xtimer_now_usec();
+    expect(vfs_format(&_mount) == 0);
+    format = xtimer_now_usec() - format;
+    expect(vfs_mount(&_mount) == 0);
+    create = _create_files();
+    stat = _stat_files();
+    write = _write_file();
+    expect(vfs_umount(&_mount) == 0);
+    printf("%s: format: %" PRIu32 " us, create: %" PRIu32 " us, "
+           "stat: %" PRIu32 " us, write+fsync: %" PRIu32 " us\n",
+           name, format, create, stat, write);
+}
+
+int main(void)
+{
+    _cache.parent = MTD_0;
+
+    expect(mtd_init(MTD_0) == 0);
+    expect(MTD_0->page_size <= BENCH_PAGE_SIZE_MAX);
+    _bench("direct", MTD_0);
+    _bench("cached", &_cache.mtd);
+    printf("cache: %" PRIu32 " hits, %" PRIu32 " misses, "
+           "%" PRIu32 " writebacks, %" PRIu32 " evictions\n",
+           _cache.stats.hits, _cache.stats.misses, _cache.stats.writebacks,
+           _cache.stats.evictions);
+    puts("DONE");
+    return 0;
+}
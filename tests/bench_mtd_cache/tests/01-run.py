@@ -0,0 +1,25 @@
+#!/usr/bin/env python3
+
+# Copyright (C) 2020 Freie Universität Berlin
+#
+# This file is subject to the terms and conditions of the GNU Lesser
+# General Public License v2.1. See the file LICENSE in the top level
+# directory for more details.
+
+import sys
+from testrunner import run
+
+
+def testfunc(child):
+    for name in ("direct", "cached"):
+        child.expect(r"{}: format: [0-9]+ us, create: [0-9]+ us, "
+                     r"stat: [0-9]+ us, write\+fsync: [0-9]+ us\r\n"
+                     .format(name))
+    child.expect(r"cache: [0-9]+ hits, [0-9]+ misses, [0-9]+ writebacks, "
+                 r"[0-9]+ evictions\r\n")
+    child.expect_exact("DONE")
+
+
+if __name__ == "__main__":
+    # the file based MTD driver of native is slow
+    sys.exit(run(testfunc, timeout=120))
@@ -0,0 +1,129 @@
+/*
+ * Copyright (C) 2020 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     tests
+ * @{
+ *
+ * @file
+ * @brief       Benchmark for the file system throughput on native's MTD
+ *              emulation drivers
+ *
+ * A littlefs2 file system is formatted on an MTD device using either the
+ * file based or the memory mapped driver. A file is then written and read
+ * back through VFS.
+ *
+ * @}
+ */
+
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "fs/littlefs2_fs.h"
+#include "kernel_defines.h"
+#include "mtd_native.h"
+#include "test_utils/expect.h"
+#include "vfs.h"
+#include "xtimer.h"
+
+#define BENCH_PAGE_SIZE         (256U)
+#define BENCH_SECTOR_SIZE       (4096U)
+#define BENCH_SECTOR_NUM        (64U)
+#define BENCH_FILE_SIZE         (32U * 1024U)
+#define BENCH_CHUNK_SIZE        (256U)
+#define BENCH_FILE              "/bench/file"
+
+#define BENCH_DEV(drv, name)    { \
+        .dev = { \
+            .driver = &drv, \
+            .sector_count = BENCH_SECTOR_NUM, \
+            .pages_per_sector = BENCH_SECTOR_SIZE / BENCH_PAGE_SIZE, \
+            .page_size = BENCH_PAGE_SIZE, \
+        }, \
+        .fname = name, \
+    }
+
+static mtd_native_dev_t _devs[] = {
+    BENCH_DEV(native_flash_driver, "bench_mtd_stdio.bin"),
+    BENCH_DEV(native_flash_mmap_driver, "bench_mtd_mmap.bin"),
+};
+static const char *_names[] = { "stdio", "mmap" };
+
+static littlefs2_desc_t _lfs;
+static vfs_mount_t _mount = {
+    .fs = &littlefs2_file_system,
+    .mount_point = "/bench",
+    .private_data = &_lfs,
+};
+static uint8_t _buf[BENCH_CHUNK_SIZE];
+
+static uint32_t _kib_per_s(uint32_t us)
+{
+    return (us > 0) ? (uint32_t)(((uint64_t)BENCH_FILE_SIZE * US_PER_SEC) /
+                                 (1024U * (uint64_t)us))
+                    : 0;
+}
+
+static uint32_t _write_file(void)
+{
+    uint32_t start = xtimer_now_usec();
+    int fd = vfs_open(BENCH_FILE, O_CREAT | O_TRUNC | O_WRONLY, 0);
+
+    expect(fd >= 0);
+    for (unsigned i = 0; i < (BENCH_FILE_SIZE / sizeof(_buf)); i++) {
+        memset(_buf, i, sizeof(_buf));
+        expect(vfs_write(fd, _buf, sizeof(_buf)) == sizeof(_buf));
+    }
+    expect(vfs_close(fd) == 0);
+    return xtimer_now_usec() - start;
+}
+
+static uint32_t _read_file(void)
+{
+    uint32_t start = xtimer_now_usec();
+    int fd = vfs_open(BENCH_FILE, O_RDONLY, 0);
+
+    expect(fd >= 0);
+    for (unsigned i = 0; i < (BENCH_FILE_SIZE / sizeof(_buf)); i++) {
+        expect(vfs_read(fd, _buf, sizeof(_buf)) == sizeof(_buf));
+        expect(_buf[0] == (uint8_t)i);
+    }
+    expect(vfs_close(fd) == 0);
+    return xtimer_now_usec() - start;
+}
+
+static void _bench(unsigned idx)
+{
+    mtd_dev_t *dev = &_devs[idx].dev;
+    uint32_t format, write, read;
+
+    expect(mtd_init(dev) == 0);
+    _lfs.dev = dev;
+    format = xtimer_now_usec();
+    expect(vfs_format(&_mount) == 0);
+    format = xtimer_now_usec() - format;
+    expect(vfs_mount(&_mount) == 0);
+    write = _write_file();
+    read = _read_file();
+    expect(vfs_unlink(BENCH_FILE) == 0);
+    expect(vfs_umount(&_mount) == 0);
+    printf("%s: format: %" PRIu32 " us, write: %" PRIu32 " KiB/s, "
+           "read: %" PRIu32 " KiB/s\n", _names[idx], format,
+           _kib_per_s(write), _kib_per_s(read));
+}
+
+int main(void)
+{
+    for (unsigned i = 0; i < ARRAY_SIZE(_devs); i++) {
+        _bench(i);
+    }
+    puts("DONE");
+    return 0;
+}
@@ -0,0 +1,22 @@
+#!/usr/bin/env python3
+
+# Copyright (C) 2020 Freie Universität Berlin
+#
+# This file is subject to the terms and conditions of the GNU Lesser
+# General Public License v2.1. See the file LICENSE in the top level
+# directory for more details.
+
+import sys
+from testrunner import run
+
+
+def testfunc(child):
+    for driver in ("stdio", "mmap"):
+        child.expect(r"{}: format: [0-9]+ us, write: [0-9]+ KiB/s, "
+                     r"read: [0-9]+ KiB/s\r\n".format(driver))
+    child.expect_exact("DONE")
+
+
+if __name__ == "__main__":
+    # the file based driver is slow
+    sys.exit(run(testfunc, timeout=120))
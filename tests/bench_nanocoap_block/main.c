@@ -0,0 +1,261 @@
+/*
+ * Copyright (C) 2020 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     tests
+ * @{
+ *
+ * @file
+ * @brief       Benchmark of block-wise transfers with nanocoap
+ *
+ * A generated log of 64 KiB is transferred with Block2, once by a handler
+ * using the slicer helpers, which regenerates the log up to each block, and
+ * once by the block-wise engine of nanocoap_block. The engine is measured
+ * with the producer state cached between blocks and with the cache cleared
+ * before each block. Then the log is uploaded with Block1 to the first MTD
+ * device and read back.
+ *
+ * @}
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "board.h"
+#include "kernel_defines.h"
+#include "mtd.h"
+#include "net/nanocoap_block.h"
+#include "test_utils/expect.h"
+#include "xtimer.h"
+
+/* Configure MTD device for SD card if none is provided */
+#if !defined(MTD_0) && MODULE_MTD_SDCARD
+#include "mtd_sdcard.h"
+#include "sdcard_spi.h"
+#include "sdcard_spi_params.h"
+
+#define SDCARD_SPI_NUM ARRAY_SIZE(sdcard_spi_params)
+
+/* SD card devices are provided by drivers/sdcard_spi/sdcard_spi.c */
+extern sdcard_spi_t sdcard_spi_devs[SDCARD_SPI_NUM];
+
+/* Configure MTD device for the first SD card */
+static mtd_sdcard_t mtd_sdcard_dev = {
+    .base = {
+        .driver = &mtd_sdcard_driver
+    },
+    .sd_card = &sdcard_spi_devs[0],
+    .params = &sdcard_spi_params[0],
+};
+static mtd_dev_t *mtd0 = (mtd_dev_t*)&mtd_sdcard_dev;
+#define MTD_0 mtd0
+#endif
+
+#define BENCH_SIZE              (64U * 1024)
+#define BENCH_LINE_SIZE         (32U)
+#define BENCH_BLOCK_SIZE        (1U << CONFIG_NANOCOAP_BLOCK_SIZE_EXP_MAX)
+#define BENCH_BUF_SIZE          (BENCH_BLOCK_SIZE + 64)
+#define BENCH_ETAG              (1)
+
+static uint8_t _buf[BENCH_BUF_SIZE];
+
+/* Writes line i of the log: "entry 00000 value 0000000000 ok\n" */
+static void _line(char *line, unsigned i)
+{
+    uint32_t value = i * 2654435761U;
+
+    memcpy(line, "entry 00000 value 0000000000 ok\n", BENCH_LINE_SIZE);
+    for (unsigned pos = 10; pos >= 6; pos--) {
+        line[pos] = '0' + (i % 10);
+        i /= 10;
+    }
+    for (unsigned pos = 27; pos >= 18; pos--) {
+        line[pos] = '0' + (value % 10);
+        value /= 10;
+    }
+}
+
+static void _check(size_t offset, const uint8_t *data, size_t len)
+{
+    char line[BENCH_LINE_SIZE];
+
+    while (len) {
+        size_t pos = offset % BENCH_LINE_SIZE;
+        size_t chunk = BENCH_LINE_SIZE - pos;
+        if (chunk > len) {
+            chunk = len;
+        }
+        _line(line, offset / BENCH_LINE_SIZE);
+        expect(memcmp(data, line + pos, chunk) == 0);
+        data += chunk;
+        offset += chunk;
+        len -= chunk;
+    }
+}
+
+static ssize_t _slicer_handler(coap_pkt_t *pkt, uint8_t *buf, size_t len,
+                               void *context)
+{
+    (void)context;
+    coap_block_slicer_t slicer;
+    char line[BENCH_LINE_SIZE];
+
+    coap_block2_init(pkt, &slicer);
+    uint8_t *payload = buf + coap_get_total_hdr_len(pkt);
+    uint8_t *bufpos = payload;
+    bufpos += coap_put_option_ct(bufpos, 0, COAP_FORMAT_TEXT);
+    bufpos += coap_opt_put_block2(bufpos, COAP_OPT_CONTENT_FORMAT, &slicer, 1);
+    *bufpos++ = 0xff;
+
+    for (unsigned i = 0; i < BENCH_SIZE / BENCH_LINE_SIZE; i++) {
+        _line(line, i);
+        bufpos += coap_blockwise_put_bytes(&slicer, bufpos, (uint8_t *)line,
+                                           sizeof(line));
+    }
+
+    return coap_block2_build_reply(pkt, COAP_CODE_CONTENT, buf, len,
+                                   bufpos - payload, &slicer);
+}
+
+static void _log_init(void *state, void *arg)
+{
+    (void)arg;
+    *(uint32_t *)state = 0;
+}
+
+static ssize_t _log_read(void *state, uint8_t *buf, size_t len, void *arg)
+{
+    (void)arg;
+    uint32_t *offset = state;
+    char line[BENCH_LINE_SIZE];
+    size_t total = 0;
+
+    while ((total < len) && (*offset < BENCH_SIZE)) {
+        size_t pos = *offset % BENCH_LINE_SIZE;
+        size_t chunk = BENCH_LINE_SIZE - pos;
+        if (chunk > len - total) {
+            chunk = len - total;
+        }
+        _line(line, *offset / BENCH_LINE_SIZE);
+        memcpy(buf + total, line + pos, chunk);
+        *offset += chunk;
+        total += chunk;
+    }
+    return total;
+}
+
+static const coap_block_producer_t _log_producer = {
+    .init = _log_init,
+    .read = _log_read,
+};
+
+static ssize_t _engine_handler(coap_pkt_t *pkt, uint8_t *buf, size_t len,
+                               void *context)
+{
+    (void)context;
+    return coap_block2_reply(pkt, buf, len, COAP_FORMAT_TEXT, &_log_producer,
+                             BENCH_ETAG, NULL);
+}
+
+/* Requests all blocks of the log from handler and checks them */
+static void _fetch(const char *name, coap_handler_t handler, bool cold)
+{
+    uint32_t time = xtimer_now_usec();
+    size_t offset = 0;
+    unsigned blknum = 0;
+    bool more = true;
+
+    while (more) {
+        coap_pkt_t pkt;
+        coap_block1_t block2;
+        uint8_t *pos = _buf;
+
+        pos += coap_build_hdr((coap_hdr_t *)_buf, COAP_TYPE_CON, NULL, 0,
+                              COAP_METHOD_GET, blknum);
+        pos += coap_opt_put_uint(pos, 0, COAP_OPT_BLOCK2,
+                                 (blknum << 4)
+                                 | (CONFIG_NANOCOAP_BLOCK_SIZE_EXP_MAX - 4));
+        expect(coap_parse(&pkt, _buf, pos - _buf) == 0);
+
+        if (cold) {
+            coap_block_cache_clear();
+        }
+        ssize_t res = handler(&pkt, _buf, sizeof(_buf), NULL);
+        expect(res > 0);
+        expect(coap_parse(&pkt, _buf, res) == 0);
+        expect(coap_get_code_raw(&pkt) == COAP_CODE_205);
+        expect(coap_get_block2(&pkt, &block2));
+        expect(block2.offset == offset);
+
+        _check(offset, pkt.payload, pkt.payload_len);
+        offset += pkt.payload_len;
+        more = block2.more;
+        blknum++;
+    }
+    time = xtimer_now_usec() - time;
+    expect(offset == BENCH_SIZE);
+    printf("block2 %s: %" PRIu32 " us per KiB\n", name,
+           time / (BENCH_SIZE / 1024));
+}
+
+/* Uploads the log with Block1 to MTD_0 and reads it back */
+static void _upload(void)
+{
+    coap_block_mtd_t area = { .mtd = MTD_0, .size = BENCH_SIZE };
+    char line[BENCH_LINE_SIZE];
+    uint32_t time;
+
+    expect(mtd_init(MTD_0) == 0);
+
+    time = xtimer_now_usec();
+    for (unsigned blknum = 0; blknum < BENCH_SIZE / BENCH_BLOCK_SIZE;
+         blknum++) {
+        bool more = blknum < BENCH_SIZE / BENCH_BLOCK_SIZE - 1;
+        coap_pkt_t pkt;
+        uint8_t *pos = _buf;
+
+        pos += coap_build_hdr((coap_hdr_t *)_buf, COAP_TYPE_CON, NULL, 0,
+                              COAP_METHOD_PUT, blknum);
+        pos += coap_opt_put_uint(pos, 0, COAP_OPT_BLOCK1,
+                                 (blknum << 4) | (more ? 0x8 : 0)
+                                 | (CONFIG_NANOCOAP_BLOCK_SIZE_EXP_MAX - 4));
+        *pos++ = 0xff;
+        _log_read(&(uint32_t){ blknum * BENCH_BLOCK_SIZE }, pos,
+                  BENCH_BLOCK_SIZE, NULL);
+        pos += BENCH_BLOCK_SIZE;
+        expect(coap_parse(&pkt, _buf, pos - _buf) == 0);
+
+        ssize_t res = coap_block1_reply(&pkt, _buf, sizeof(_buf),
+                                        COAP_CODE_CHANGED,
+                                        coap_block_sink_mtd, &area);
+        expect(res > 0);
+        expect(coap_parse(&pkt, _buf, res) == 0);
+        expect(coap_get_code_raw(&pkt) == (more ? COAP_CODE_CONTINUE
+                                            : COAP_CODE_CHANGED));
+    }
+    time = xtimer_now_usec() - time;
+    printf("block1 mtd: %" PRIu32 " us per KiB\n",
+           time / (BENCH_SIZE / 1024));
+
+    for (uint32_t offset = 0; offset < BENCH_SIZE; offset += sizeof(line)) {
+        expect(mtd_read(MTD_0, line, offset, sizeof(line)) == 0);
+        _check(offset, (uint8_t *)line, sizeof(line));
+    }
+}
+
+int main(void)
+{
+    _fetch("slicer", _slicer_handler, false);
+    _fetch("engine", _engine_handler, false);
+    _fetch("engine, cold cache", _engine_handler, true);
+    _upload();
+
+    puts("DONE");
+    return 0;
+}
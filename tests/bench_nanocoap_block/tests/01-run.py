@@ -0,0 +1,23 @@
+#!/usr/bin/env python3
+
+# Copyright (C) 2020 Freie Universität Berlin
+#
+# This file is subject to the terms and conditions of the GNU Lesser
+# General Public License v2.1. See the file LICENSE in the top level
+# directory for more details.
+
+import sys
+from testrunner import run
+
+
+def testfunc(child):
+    child.expect(r"block2 slicer: [0-9]+ us per KiB\r\n")
+    child.expect(r"block2 engine: [0-9]+ us per KiB\r\n")
+    child.expect(r"block2 engine, cold cache: [0-9]+ us per KiB\r\n")
+    child.expect(r"block1 mtd: [0-9]+ us per KiB\r\n")
+    child.expect_exact("DONE")
+
+
+if __name__ == "__main__":
+    # the slicer regenerates the log for each block
+    sys.exit(run(testfunc, timeout=120))
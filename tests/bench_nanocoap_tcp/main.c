@@ -0,0 +1,203 @@
+/*
+ * Copyright (C) 2020 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     tests
+ * @{
+ *
+ * @file
+ * @brief       Throughput of block-wise transfers over UDP and over TCP
+ *
+ * A nanocoap server over UDP and one over TCP serve a generated
+ * representation of BENCH_SIZE_KIB KiB at /data on the loopback interface.
+ * The client fetches it with Block2, over UDP in blocks of 1024 bytes, one
+ * confirmable request per block, and over TCP in BERT blocks, which fill
+ * buffers of BENCH_TCP_BUF_SIZE bytes.
+ *
+ * @}
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "net/ipv6/addr.h"
+#include "net/nanocoap_block.h"
+#include "net/nanocoap_sock.h"
+#include "net/nanocoap_tcp.h"
+#include "test_utils/expect.h"
+#include "thread.h"
+#include "xtimer.h"
+
+#define BENCH_SIZE          (BENCH_SIZE_KIB * 1024UL)
+#define BENCH_ETAG          (1)
+/* Block2 SZX of 1024 bytes */
+#define BENCH_UDP_SZX       (6)
+#define BENCH_UDP_BUF_SIZE  (1024 + 64)
+
+static char _udp_server_stack[THREAD_STACKSIZE_DEFAULT];
+static char _tcp_server_stack[THREAD_STACKSIZE_DEFAULT];
+static uint8_t _udp_server_buf[BENCH_UDP_BUF_SIZE];
+static uint8_t _tcp_server_buf[BENCH_TCP_BUF_SIZE];
+static uint8_t _buf[BENCH_TCP_BUF_SIZE];
+
+static uint8_t _byte(size_t offset)
+{
+    return (offset * 7) + (offset >> 8);
+}
+
+static void _data_init(void *state, void *arg)
+{
+    (void)arg;
+    *(uint32_t *)state = 0;
+}
+
+static ssize_t _data_read(void *state, uint8_t *buf, size_t len, void *arg)
+{
+    (void)arg;
+    uint32_t *offset = state;
+    size_t total = 0;
+
+    while ((total < len) && (*offset < BENCH_SIZE)) {
+        buf[total++] = _byte((*offset)++);
+    }
+    return total;
+}
+
+static const coap_block_producer_t _data_producer = {
+    .init = _data_init,
+    .read = _data_read,
+};
+
+static ssize_t _data_handler(coap_pkt_t *pkt, uint8_t *buf, size_t len,
+                             void *context)
+{
+    (void)context;
+    return coap_block2_reply(pkt, buf, len, COAP_FORMAT_OCTET, &_data_producer,
+                             BENCH_ETAG, NULL);
+}
+
+const coap_resource_t coap_resources[] = {
+    { "/data", COAP_GET, _data_handler, NULL },
+};
+
+const unsigned coap_resources_numof = ARRAY_SIZE(coap_resources);
+
+static void *_udp_server(void *arg)
+{
+    (void)arg;
+    sock_udp_ep_t local = { .family = AF_INET6, .port = COAP_PORT };
+
+    nanocoap_server(&local, _udp_server_buf, sizeof(_udp_server_buf));
+    return NULL;
+}
+
+static void *_tcp_server(void *arg)
+{
+    (void)arg;
+    sock_tcp_ep_t local = { .family = AF_INET6, .port = COAP_PORT };
+
+    nanocoap_tcp_server(&local, _tcp_server_buf, sizeof(_tcp_server_buf));
+    return NULL;
+}
+
+static void _check(size_t offset, const uint8_t *data, size_t len)
+{
+    for (size_t i = 0; i < len; i++) {
+        expect(data[i] == _byte(offset + i));
+    }
+}
+
+static void _print(const char *name, unsigned blocks, uint32_t time)
+{
+    uint64_t rate = (uint64_t)BENCH_SIZE_KIB * US_PER_SEC / (time ? time : 1);
+
+    printf("%s: %u blocks, %" PRIu32 " KiB/s\n", name, blocks,
+           (uint32_t)rate);
+}
+
+static void _fetch_udp(void)
+{
+    sock_udp_ep_t remote = { .family = AF_INET6, .port = COAP_PORT };
+    uint32_t time = xtimer_now_usec();
+    size_t offset = 0;
+    unsigned blknum = 0;
+    bool more = true;
+
+    memcpy(remote.addr.ipv6, &ipv6_addr_loopback, sizeof(remote.addr.ipv6));
+    while (more) {
+        coap_pkt_t pkt;
+        coap_block1_t block2;
+
+        ssize_t len = coap_build_hdr((coap_hdr_t *)_buf, COAP_TYPE_CON, NULL,
+                                     0, COAP_METHOD_GET, blknum);
+        coap_pkt_init(&pkt, _buf, BENCH_UDP_BUF_SIZE, len);
+        coap_opt_add_uri_path(&pkt, "/data");
+        coap_opt_add_uint(&pkt, COAP_OPT_BLOCK2,
+                          (blknum << COAP_BLOCKWISE_NUM_OFF) | BENCH_UDP_SZX);
+        coap_opt_finish(&pkt, COAP_OPT_FINISH_NONE);
+
+        expect(nanocoap_request(&pkt, NULL, &remote, BENCH_UDP_BUF_SIZE) > 0);
+        expect(coap_get_code_raw(&pkt) == COAP_CODE_CONTENT);
+        expect(coap_get_block2(&pkt, &block2));
+        expect(block2.offset == offset);
+        _check(offset, pkt.payload, pkt.payload_len);
+        offset += pkt.payload_len;
+        more = block2.more;
+        blknum++;
+    }
+    time = xtimer_now_usec() - time;
+    expect(offset == BENCH_SIZE);
+    _print("udp block-wise", blknum, time);
+}
+
+static int _block_cb(void *arg, size_t offset, const uint8_t *data,
+                     size_t len, bool more)
+{
+    (void)more;
+    _check(offset, data, len);
+    (*(unsigned *)arg)++;
+    return 0;
+}
+
+static void _fetch_tcp(void)
+{
+    sock_tcp_ep_t remote = { .family = AF_INET6, .port = COAP_PORT };
+    nanocoap_tcp_conn_t conn;
+    sock_tcp_t sock;
+    unsigned blocks = 0;
+
+    memcpy(remote.addr.ipv6, &ipv6_addr_loopback, sizeof(remote.addr.ipv6));
+    /* the connection is opened before the clock starts */
+    expect(nanocoap_tcp_connect(&conn, &sock, &remote, _buf,
+                                sizeof(_buf)) == 0);
+    expect(conn.bert);
+
+    uint32_t time = xtimer_now_usec();
+    expect(nanocoap_tcp_get_blockwise(&conn, "/data", _buf, sizeof(_buf),
+                                      _block_cb, &blocks) == BENCH_SIZE);
+    time = xtimer_now_usec() - time;
+    nanocoap_tcp_close(&conn);
+    _print("tcp bert", blocks, time);
+}
+
+int main(void)
+{
+    thread_create(_udp_server_stack, sizeof(_udp_server_stack),
+                  THREAD_PRIORITY_MAIN - 1, THREAD_CREATE_STACKTEST,
+                  _udp_server, NULL, "udp server");
+    thread_create(_tcp_server_stack, sizeof(_tcp_server_stack),
+                  THREAD_PRIORITY_MAIN - 1, THREAD_CREATE_STACKTEST,
+                  _tcp_server, NULL, "tcp server");
+
+    _fetch_udp();
+    _fetch_tcp();
+
+    puts("DONE");
+    return 0;
+}
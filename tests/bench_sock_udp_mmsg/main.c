@@ -0,0 +1,209 @@
+/*
+ * Copyright (C) 2020 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     tests
+ * @{
+ *
+ * @file
+ * @brief       Benchmark for batched receiving and sending with sock_udp
+ *
+ * Bursts that fill the mailbox of a sock are drained with sock_udp_recv(),
+ * sock_udp_recv_buf() and sock_udp_recv_mmsg(). Bursts of the same size are
+ * sent with sock_udp_send() and sock_udp_send_mmsg(). Only the time spent in
+ * the sock calls is measured.
+ *
+ * @}
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "byteorder.h"
+#include "kernel_defines.h"
+#include "net/gnrc.h"
+#include "net/gnrc/ipv6/hdr.h"
+#include "net/sock/udp.h"
+#include "net/udp.h"
+#include "test_utils/expect.h"
+#include "xtimer.h"
+
+#define BENCH_ROUNDS            (1000U)
+#define BENCH_BURST             (GNRC_SOCK_MBOX_SIZE)
+#define BENCH_PORT_LOCAL        (61616U)
+#define BENCH_PORT_REMOTE       (61617U)
+#define BENCH_PAYLOAD_LEN       (32U)
+#define BENCH_ADDR_LOCAL        { 0x20, 0x01, 0x0d, 0xb8, 0x00, 0x00, 0x00, 0x00, \
+                                  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01 }
+#define BENCH_ADDR_REMOTE       { 0x20, 0x01, 0x0d, 0xb8, 0x00, 0x00, 0x00, 0x00, \
+                                  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02 }
+
+typedef unsigned (*_bench_fn_t)(void);
+
+static const ipv6_addr_t _local_addr = { .u8 = BENCH_ADDR_LOCAL };
+static const ipv6_addr_t _remote_addr = { .u8 = BENCH_ADDR_REMOTE };
+static const sock_udp_ep_t _remote = { .addr = { .ipv6 = BENCH_ADDR_REMOTE },
+                                       .family = AF_INET6,
+                                       .port = BENCH_PORT_REMOTE };
+static uint8_t _payload[BENCH_PAYLOAD_LEN];
+static sock_udp_t _sock;
+static sock_udp_mmsg_t _msgs[BENCH_BURST];
+
+/* builds a packet as the UDP layer hands it to the sock */
+static gnrc_pktsnip_t *_build_pkt(void)
+{
+    gnrc_pktsnip_t *payload, *udp, *ipv6;
+    udp_hdr_t *hdr;
+
+    payload = gnrc_pktbuf_add(NULL, _payload, sizeof(_payload),
+                              GNRC_NETTYPE_UNDEF);
+    expect(payload != NULL);
+    udp = gnrc_pktbuf_add(NULL, NULL, sizeof(udp_hdr_t), GNRC_NETTYPE_UDP);
+    expect(udp != NULL);
+    hdr = udp->data;
+    hdr->src_port = byteorder_htons(BENCH_PORT_REMOTE);
+    hdr->dst_port = byteorder_htons(BENCH_PORT_LOCAL);
+    hdr->length = byteorder_htons(sizeof(udp_hdr_t) + sizeof(_payload));
+    hdr->checksum.u16 = 0;
+    ipv6 = gnrc_ipv6_hdr_build(NULL, &_remote_addr, &_local_addr);
+    expect(ipv6 != NULL);
+    payload->next = udp;
+    udp->next = ipv6;
+    return payload;
+}
+
+static void _inject_burst(void)
+{
+    for (unsigned i = 0; i < BENCH_BURST; i++) {
+        expect(gnrc_netapi_dispatch_receive(GNRC_NETTYPE_UDP, BENCH_PORT_LOCAL,
+                                            _build_pkt()) == 1);
+    }
+}
+
+static unsigned _drain_recv(void)
+{
+    static uint8_t buf[BENCH_PAYLOAD_LEN];
+    sock_udp_ep_t remote;
+    unsigned n = 0;
+
+    while (sock_udp_recv(&_sock, buf, sizeof(buf), 0, &remote) > 0) {
+        n++;
+    }
+    return n;
+}
+
+static unsigned _drain_recv_buf(void)
+{
+    sock_udp_ep_t remote;
+    unsigned n = 0;
+
+    while (1) {
+        void *data = NULL, *ctx = NULL;
+
+        if (sock_udp_recv_buf(&_sock, &data, &ctx, 0, &remote) <= 0) {
+            break;
+        }
+        n++;
+        /* release the buffer */
+        sock_udp_recv_buf(&_sock, &data, &ctx, 0, &remote);
+    }
+    return n;
+}
+
+static unsigned _drain_recv_mmsg(void)
+{
+    unsigned n = 0;
+    int res;
+
+    while ((res = sock_udp_recv_mmsg(&_sock, _msgs, ARRAY_SIZE(_msgs),
+                                     0)) > 0) {
+        n += res;
+        sock_udp_mmsg_release(&_sock, _msgs, res);
+    }
+    return n;
+}
+
+static unsigned _send(void)
+{
+    unsigned n = 0;
+
+    for (unsigned i = 0; i < BENCH_BURST; i++) {
+        if (sock_udp_send(&_sock, _payload, sizeof(_payload), &_remote) > 0) {
+            n++;
+        }
+    }
+    return n;
+}
+
+static unsigned _send_mmsg(void)
+{
+    int res = sock_udp_send_mmsg(&_sock, _msgs, ARRAY_SIZE(_msgs));
+
+    return (res > 0) ? (unsigned)res : 0;
+}
+
+static void _print(const char *name, unsigned pkts, uint32_t us)
+{
+    printf("%s: %u packets in %" PRIu32 " us (%" PRIu32 " pps)\n", name, pkts,
+           us, (us > 0) ? (uint32_t)(((uint64_t)pkts * US_PER_SEC) / us) : 0);
+}
+
+static void _bench_recv(const char *name, _bench_fn_t drain)
+{
+    unsigned pkts = 0;
+    uint32_t us = 0;
+
+    for (unsigned i = 0; i < BENCH_ROUNDS; i++) {
+        uint32_t start;
+
+        _inject_burst();
+        start = xtimer_now_usec();
+        pkts += drain();
+        us += xtimer_now_usec() - start;
+    }
+    expect(gnrc_pktbuf_is_empty());
+    _print(name, pkts, us);
+}
+
+static void _bench_send(const char *name, _bench_fn_t send)
+{
+    unsigned pkts = 0;
+    uint32_t start = xtimer_now_usec();
+
+    for (unsigned i = 0; i < BENCH_ROUNDS; i++) {
+        pkts += send();
+    }
+    _print(name, pkts, xtimer_now_usec() - start);
+}
+
+int main(void)
+{
+    static const sock_udp_ep_t local = { .family = AF_INET6,
+                                         .port = BENCH_PORT_LOCAL };
+
+    expect(sock_udp_create(&_sock, &local, NULL, 0) == 0);
+    _bench_recv("sock_udp_recv", _drain_recv);
+    _bench_recv("sock_udp_recv_buf", _drain_recv_buf);
+    _bench_recv("sock_udp_recv_mmsg", _drain_recv_mmsg);
+
+    for (unsigned i = 0; i < ARRAY_SIZE(_msgs); i++) {
+        _msgs[i].data = _payload;
+        _msgs[i].len = sizeof(_payload);
+        _msgs[i].buf_ctx = NULL;
+        _msgs[i].remote = _remote;
+    }
+    /* the UDP and IPv6 threads run with a higher priority than main, so every
+     * packet is handed down (and dropped for lack of an interface) before the
+     * send call returns */
+    _bench_send("sock_udp_send", _send);
+    _bench_send("sock_udp_send_mmsg", _send_mmsg);
+    sock_udp_close(&_sock);
+    puts("DONE");
+    return 0;
+}
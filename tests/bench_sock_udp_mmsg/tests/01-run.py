@@ -0,0 +1,22 @@
+#!/usr/bin/env python3
+
+# Copyright (C) 2020 Freie Universität Berlin
+#
+# This file is subject to the terms and conditions of the GNU Lesser
+# General Public License v2.1. See the file LICENSE in the top level
+# directory for more details.
+
+import sys
+from testrunner import run
+
+
+def testfunc(child):
+    for method in ("sock_udp_recv", "sock_udp_recv_buf", "sock_udp_recv_mmsg",
+                   "sock_udp_send", "sock_udp_send_mmsg"):
+        child.expect(r"{}: [0-9]+ packets in [0-9]+ us \([0-9]+ pps\)\r\n"
+                     .format(method))
+    child.expect_exact("DONE")
+
+
+if __name__ == "__main__":
+    sys.exit(run(testfunc))
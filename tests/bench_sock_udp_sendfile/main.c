@@ -0,0 +1,129 @@
+/*
+ * Copyright (C) 2020 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     tests
+ * @{
+ *
+ * @file
+ * @brief       Benchmark for sending file content with sock_udp
+ *
+ * A file on a constfs is sent block by block, each block preceded by a small
+ * header, once read into a buffer with vfs_read() and sent with
+ * sock_udp_send() and once sent with sock_udp_sendfile().
+ *
+ * @}
+ */
+
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "fs/constfs.h"
+#include "kernel_defines.h"
+#include "net/gnrc/pktbuf.h"
+#include "net/sock/udp.h"
+#include "test_utils/expect.h"
+#include "vfs.h"
+#include "xtimer.h"
+
+#define BENCH_ROUNDS            (100U)
+#define BENCH_PORT_LOCAL        (61616U)
+#define BENCH_PORT_REMOTE       (61617U)
+#define BENCH_FILE_SIZE         (8U * 1024U)
+#define BENCH_HDR_LEN           (16U)
+#define BENCH_ADDR_REMOTE       { 0x20, 0x01, 0x0d, 0xb8, 0x00, 0x00, 0x00, 0x00, \
+                                  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02 }
+#define BENCH_PATH              "/const/file"
+
+typedef ssize_t (*_bench_fn_t)(int fd, size_t len);
+
+static const sock_udp_ep_t _remote = { .addr = { .ipv6 = BENCH_ADDR_REMOTE },
+                                       .family = AF_INET6,
+                                       .port = BENCH_PORT_REMOTE };
+static const uint8_t _file[BENCH_FILE_SIZE];
+static constfs_file_t _files[] = {
+    {
+        .path = "/file",
+        .size = sizeof(_file),
+        .data = _file,
+    },
+};
+static constfs_t _constfs = {
+    .nfiles = ARRAY_SIZE(_files),
+    .files = _files,
+};
+static vfs_mount_t _mount = {
+    .fs = &constfs_file_system,
+    .mount_point = "/const",
+    .private_data = &_constfs,
+};
+static sock_udp_t _sock;
+static uint8_t _buf[BENCH_HDR_LEN + 512U];
+
+static ssize_t _send(int fd, size_t len)
+{
+    ssize_t res = vfs_read(fd, &_buf[BENCH_HDR_LEN], len);
+
+    if (res < 0) {
+        return res;
+    }
+    return sock_udp_send(&_sock, _buf, BENCH_HDR_LEN + res, &_remote);
+}
+
+static ssize_t _sendfile(int fd, size_t len)
+{
+    return sock_udp_sendfile(&_sock, _buf, BENCH_HDR_LEN, fd, len, &_remote);
+}
+
+static void _bench(const char *name, _bench_fn_t send, size_t blk_len)
+{
+    uint64_t bytes = 0;
+    uint32_t start = xtimer_now_usec();
+    uint32_t us;
+
+    for (unsigned i = 0; i < BENCH_ROUNDS; i++) {
+        int fd = vfs_open(BENCH_PATH, O_RDONLY, 0);
+
+        expect(fd >= 0);
+        for (unsigned j = 0; j < (BENCH_FILE_SIZE / blk_len); j++) {
+            ssize_t res = send(fd, blk_len);
+
+            expect(res == (ssize_t)(BENCH_HDR_LEN + blk_len));
+            bytes += res - BENCH_HDR_LEN;
+        }
+        expect(vfs_close(fd) == 0);
+    }
+    us = xtimer_now_usec() - start;
+    expect(gnrc_pktbuf_is_empty());
+    printf("%s (%u byte blocks): %" PRIu32 " KiB in %" PRIu32 " us "
+           "(%" PRIu32 " KiB/s)\n", name, (unsigned)blk_len,
+           (uint32_t)(bytes / 1024), us,
+           (us > 0) ? (uint32_t)((bytes * US_PER_SEC) / (us * 1024ULL)) : 0);
+}
+
+int main(void)
+{
+    static const sock_udp_ep_t local = { .family = AF_INET6,
+                                         .port = BENCH_PORT_LOCAL };
+
+    expect(vfs_mount(&_mount) == 0);
+    expect(sock_udp_create(&_sock, &local, NULL, 0) == 0);
+    /* the UDP and IPv6 threads run with a higher priority than main, so every
+     * packet is handed down (and dropped for lack of an interface) before the
+     * send call returns */
+    for (size_t blk_len = 64; blk_len <= 512; blk_len *= 2) {
+        _bench("vfs_read+sock_udp_send", _send, blk_len);
+        _bench("sock_udp_sendfile", _sendfile, blk_len);
+    }
+    sock_udp_close(&_sock);
+    expect(vfs_umount(&_mount) == 0);
+    puts("DONE");
+    return 0;
+}
@@ -0,0 +1,22 @@
+#!/usr/bin/env python3
+
+# Copyright (C) 2020 Freie Universität Berlin
+#
+# This file is subject to the terms and conditions of the GNU Lesser
+# General Public License v2.1. See the file LICENSE in the top level
+# directory for more details.
+
+import sys
+from testrunner import run
+
+
+def testfunc(child):
+    for _ in range(4):
+        for method in ("vfs_read+sock_udp_send", "sock_udp_sendfile"):
+            child.expect(r"{} \([0-9]+ byte blocks\): [0-9]+ KiB in [0-9]+ us "
+                         r"\([0-9]+ KiB/s\)\r\n".format(method.replace("+", r"\+")))
+    child.expect_exact("DONE")
+
+
+if __name__ == "__main__":
+    sys.exit(run(testfunc))
@@ -0,0 +1,279 @@
+/*
+ * Copyright (C) 2020 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     tests
+ * @{
+ *
+ * @file
+ * @brief       Benchmark of the time-series log against littlefs2
+ *
+ * Time stamped sensor samples are appended to a tslog on the first sectors
+ * of the board's MTD device (or of the first SD card) and to a file on a
+ * littlefs2 file system on the same sectors. The file is synced whenever
+ * tslog writes a batch, so both persist the same records. The writes and
+ * erases reaching the device are counted, and a range of records is
+ * searched afterwards.
+ *
+ * @warning The data on the device is destroyed.
+ *
+ * @}
+ */
+
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "board.h"
+#include "byteorder.h"
+#include "fs/littlefs2_fs.h"
+#include "kernel_defines.h"
+#include "mtd.h"
+#include "phydat.h"
+#include "test_utils/expect.h"
+#include "tslog.h"
+#include "vfs.h"
+#include "xtimer.h"
+
+/* Configure MTD device for SD card if none is provided */
+#if !defined(MTD_0) && MODULE_MTD_SDCARD
+#include "mtd_sdcard.h"
+#include "sdcard_spi.h"
+#include "sdcard_spi_params.h"
+
+#define SDCARD_SPI_NUM ARRAY_SIZE(sdcard_spi_params)
+
+/* SD card devices are provided by drivers/sdcard_spi/sdcard_spi.c */
+extern sdcard_spi_t sdcard_spi_devs[SDCARD_SPI_NUM];
+
+/* Configure MTD device for the first SD card */
+static mtd_sdcard_t mtd_sdcard_dev = {
+    .base = {
+        .driver = &mtd_sdcard_driver
+    },
+    .sd_card = &sdcard_spi_devs[0],
+    .params = &sdcard_spi_params[0],
+};
+static mtd_dev_t *mtd0 = (mtd_dev_t*)&mtd_sdcard_dev;
+#define MTD_0 mtd0
+#endif
+
+#define BENCH_SECTORS           (128U)
+#define BENCH_RECORDS           (2048U)
+#define BENCH_QUERY_START       (BENCH_RECORDS / 2)
+#define BENCH_QUERY_LEN         (100U)
+/* records tslog writes at once */
+#define BENCH_BATCH             ((CONFIG_TSLOG_BATCH_SIZE - \
+                                  TSLOG_BATCH_HDR_SIZE) / \
+                                 (sizeof(uint32_t) + sizeof(phydat_t)))
+#define BENCH_MOUNT_POINT       "/bench"
+#define BENCH_FILE              BENCH_MOUNT_POINT "/log"
+
+/* MTD device counting the accesses to the device below */
+typedef struct {
+    mtd_dev_t mtd;
+    mtd_dev_t *parent;
+    uint32_t writes;
+    uint32_t erases;
+} _count_mtd_t;
+
+static int _count_init(mtd_dev_t *mtd)
+{
+    _count_mtd_t *dev = container_of(mtd, _count_mtd_t, mtd);
+    int res = mtd_init(dev->parent);
+
+    mtd->sector_count = dev->parent->sector_count;
+    mtd->pages_per_sector = dev->parent->pages_per_sector;
+    mtd->page_size = dev->parent->page_size;
+    return res;
+}
+
+static int _count_read(mtd_dev_t *mtd, void *dest, uint32_t addr,
+                       uint32_t count)
+{
+    _count_mtd_t *dev = container_of(mtd, _count_mtd_t, mtd);
+
+    return mtd_read(dev->parent, dest, addr, count);
+}
+
+static int _count_write(mtd_dev_t *mtd, const void *src, uint32_t addr,
+                        uint32_t count)
+{
+    _count_mtd_t *dev = container_of(mtd, _count_mtd_t, mtd);
+
+    dev->writes++;
+    return mtd_write(dev->parent, src, addr, count);
+}
+
+static int _count_erase(mtd_dev_t *mtd, uint32_t addr, uint32_t count)
+{
+    _count_mtd_t *dev = container_of(mtd, _count_mtd_t, mtd);
+
+    dev->erases += count / (mtd->page_size * mtd->pages_per_sector);
+    return mtd_erase(dev->parent, addr, count);
+}
+
+static int _count_power(mtd_dev_t *mtd, enum mtd_power_state power)
+{
+    _count_mtd_t *dev = container_of(mtd, _count_mtd_t, mtd);
+
+    return mtd_power(dev->parent, power);
+}
+
+static int _count_flush(mtd_dev_t *mtd)
+{
+    _count_mtd_t *dev = container_of(mtd, _count_mtd_t, mtd);
+
+    return mtd_flush(dev->parent);
+}
+
+static const mtd_desc_t _count_driver = {
+    .init = _count_init,
+    .read = _count_read,
+    .write = _count_write,
+    .erase = _count_erase,
+    .power = _count_power,
+    .flush = _count_flush,
+};
+
+static _count_mtd_t _dev = {
+    .mtd = { .driver = &_count_driver },
+};
+
+static uint32_t _index[BENCH_SECTORS];
+static tslog_t _log = {
+    .mtd = &_dev.mtd,
+    .first_sector = 0,
+    .sector_count = BENCH_SECTORS,
+    .record_size = sizeof(phydat_t),
+    .index = _index,
+};
+
+static littlefs2_desc_t _lfs;
+static vfs_mount_t _mount = {
+    .fs = &littlefs2_file_system,
+    .mount_point = BENCH_MOUNT_POINT,
+    .private_data = &_lfs,
+};
+
+/* a temperature sample */
+static void _sample(phydat_t *data, unsigned i)
+{
+    memset(data, 0, sizeof(*data));
+    data->val[0] = 2000 + (i % 500);
+    data->unit = UNIT_TEMP_C;
+    data->scale = -2;
+}
+
+static void _print(const char *name, uint32_t time, uint32_t query)
+{
+    printf("%s: %" PRIu32 " appends/s, %" PRIu32 " writes, %" PRIu32
+           " erases, %" PRIu32 " writes per 1000 records, query: %" PRIu32
+           " us\n", name,
+           (uint32_t)((uint64_t)BENCH_RECORDS * US_PER_SEC / (time ? time : 1)),
+           _dev.writes, _dev.erases, _dev.writes * 1000 / BENCH_RECORDS,
+           query);
+}
+
+static int _count_cb(uint32_t timestamp, const void *data, void *arg)
+{
+    (void)timestamp;
+    (void)data;
+    (*(unsigned *)arg)++;
+    return 0;
+}
+
+static void _bench_tslog(void)
+{
+    uint32_t time, query;
+    unsigned found = 0;
+    phydat_t data;
+
+    expect(tslog_init(&_log) == 0);
+    expect(tslog_format(&_log) == 0);
+    _dev.writes = 0;
+    _dev.erases = 0;
+
+    time = xtimer_now_usec();
+    for (unsigned i = 0; i < BENCH_RECORDS; i++) {
+        _sample(&data, i);
+        expect(tslog_append(&_log, i, &data) == 0);
+    }
+    expect(tslog_flush(&_log) == 0);
+    time = xtimer_now_usec() - time;
+
+    query = xtimer_now_usec();
+    expect(tslog_query(&_log, BENCH_QUERY_START,
+                       BENCH_QUERY_START + BENCH_QUERY_LEN - 1,
+                       _count_cb, &found) == BENCH_QUERY_LEN);
+    query = xtimer_now_usec() - query;
+    expect(found == BENCH_QUERY_LEN);
+    _print("tslog", time, query);
+}
+
+static void _bench_littlefs2(void)
+{
+    uint8_t record[sizeof(uint32_t) + sizeof(phydat_t)];
+    uint32_t time, query;
+    unsigned found = 0;
+    phydat_t data;
+    int fd;
+
+    memset(&_lfs, 0, sizeof(_lfs));
+    _lfs.dev = &_dev.mtd;
+    _lfs.config.block_count = BENCH_SECTORS;
+    expect(vfs_format(&_mount) == 0);
+    expect(vfs_mount(&_mount) == 0);
+    _dev.writes = 0;
+    _dev.erases = 0;
+
+    time = xtimer_now_usec();
+    fd = vfs_open(BENCH_FILE, O_CREAT | O_APPEND | O_WRONLY, 0);
+    expect(fd >= 0);
+    for (unsigned i = 0; i < BENCH_RECORDS; i++) {
+        byteorder_htobebufl(record, i);
+        _sample(&data, i);
+        memcpy(&record[sizeof(uint32_t)], &data, sizeof(data));
+        expect(vfs_write(fd, record, sizeof(record)) == sizeof(record));
+        if ((i + 1) % BENCH_BATCH == 0) {
+            expect(vfs_fsync(fd) == 0);
+        }
+    }
+    expect(vfs_close(fd) == 0);
+    time = xtimer_now_usec() - time;
+
+    /* the file has no index, the records are found by a linear scan */
+    query = xtimer_now_usec();
+    fd = vfs_open(BENCH_FILE, O_RDONLY, 0);
+    expect(fd >= 0);
+    while (vfs_read(fd, record, sizeof(record)) == sizeof(record)) {
+        uint32_t timestamp = byteorder_bebuftohl(record);
+        if (timestamp >= BENCH_QUERY_START + BENCH_QUERY_LEN) {
+            break;
+        }
+        if (timestamp >= BENCH_QUERY_START) {
+            found++;
+        }
+    }
+    expect(vfs_close(fd) == 0);
+    query = xtimer_now_usec() - query;
+    expect(found == BENCH_QUERY_LEN);
+    expect(vfs_umount(&_mount) == 0);
+    _print("littlefs2", time, query);
+}
+
+int main(void)
+{
+    _dev.parent = MTD_0;
+
+    _bench_tslog();
+    _bench_littlefs2();
+    puts("DONE");
+    return 0;
+}
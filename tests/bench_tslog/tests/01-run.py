@@ -0,0 +1,23 @@
+#!/usr/bin/env python3
+
+# Copyright (C) 2020 Freie Universität Berlin
+#
+# This file is subject to the terms and conditions of the GNU Lesser
+# General Public License v2.1. See the file LICENSE in the top level
+# directory for more details.
+
+import sys
+from testrunner import run
+
+
+def testfunc(child):
+    for name in ("tslog", "littlefs2"):
+        child.expect(r"{}: [0-9]+ appends/s, [0-9]+ writes, [0-9]+ erases, "
+                     r"[0-9]+ writes per 1000 records, query: [0-9]+ us\r\n"
+                     .format(name))
+    child.expect_exact("DONE")
+
+
+if __name__ == "__main__":
+    # the file based MTD driver of native is slow
+    sys.exit(run(testfunc, timeout=120))
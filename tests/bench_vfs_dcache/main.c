@@ -0,0 +1,134 @@
+/*
+ * Copyright (C) 2020 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     tests
+ * @{
+ *
+ * @file
+ * @brief       Benchmark for the VFS path lookup cache
+ *
+ * A number of constfs instances are mounted, then files on the last mount
+ * are opened and closed resp. stat'ed in a loop. With module `vfs_dcache`,
+ * the loop runs once with the cache cleared before every call and once with
+ * the cache warm. Build with `DCACHE=0` for the numbers without the module.
+ *
+ * @}
+ */
+
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <sys/stat.h>
+
+#include "fs/constfs.h"
+#include "kernel_defines.h"
+#include "test_utils/expect.h"
+#include "vfs.h"
+#include "xtimer.h"
+
+#define BENCH_MOUNTS        (4U)
+#define BENCH_ROUNDS        (1000U)
+
+static const uint8_t _data[] = "0123456789abcdef";
+
+static const constfs_file_t _files[] = {
+    { .path = "/a", .data = _data, .size = sizeof(_data) },
+    { .path = "/b", .data = _data, .size = sizeof(_data) },
+    { .path = "/c", .data = _data, .size = sizeof(_data) },
+    { .path = "/d", .data = _data, .size = sizeof(_data) },
+    { .path = "/e", .data = _data, .size = sizeof(_data) },
+    { .path = "/f", .data = _data, .size = sizeof(_data) },
+    { .path = "/g", .data = _data, .size = sizeof(_data) },
+    { .path = "/h", .data = _data, .size = sizeof(_data) },
+    { .path = "/i", .data = _data, .size = sizeof(_data) },
+    { .path = "/j", .data = _data, .size = sizeof(_data) },
+    { .path = "/k", .data = _data, .size = sizeof(_data) },
+    { .path = "/l", .data = _data, .size = sizeof(_data) },
+    { .path = "/m", .data = _data, .size = sizeof(_data) },
+    { .path = "/n", .data = _data, .size = sizeof(_data) },
+    { .path = "/o", .data = _data, .size = sizeof(_data) },
+    { .path = "/p", .data = _data, .size = sizeof(_data) },
+};
+
+static const constfs_t _fs = {
+    .files = _files,
+    .nfiles = ARRAY_SIZE(_files),
+};
+
+static vfs_mount_t _mounts[BENCH_MOUNTS] = {
+    { .fs = &constfs_file_system, .mount_point = "/c0", .private_data = (void *)&_fs },
+    { .fs = &constfs_file_system, .mount_point = "/c1", .private_data = (void *)&_fs },
+    { .fs = &constfs_file_system, .mount_point = "/c2", .private_data = (void *)&_fs },
+    { .fs = &constfs_file_system, .mount_point = "/c3", .private_data = (void *)&_fs },
+};
+
+/* the files accessed in the loop, the last ones of the last mount */
+static const char *_paths[] = {
+    "/c3/m", "/c3/n", "/c3/o", "/c3/p",
+};
+
+static void _open_close(unsigned i)
+{
+    int fd = vfs_open(_paths[i % ARRAY_SIZE(_paths)], O_RDONLY, 0);
+
+    expect(fd >= 0);
+    expect(vfs_close(fd) == 0);
+}
+
+static void _stat(unsigned i)
+{
+    struct stat st;
+
+    expect(vfs_stat(_paths[i % ARRAY_SIZE(_paths)], &st) == 0);
+    expect(st.st_size == sizeof(_data));
+}
+
+static uint32_t _run(void (*op)(unsigned), bool cold)
+{
+    uint32_t start = xtimer_now_usec();
+
+    for (unsigned i = 0; i < BENCH_ROUNDS; i++) {
+#ifdef MODULE_VFS_DCACHE
+        if (cold) {
+            vfs_dcache_clear();
+        }
+#else
+        (void)cold;
+#endif
+        op(i);
+    }
+    return xtimer_now_usec() - start;
+}
+
+static void _bench(const char *name, void (*op)(unsigned))
+{
+    printf("%s: uncached: %" PRIu32 " us", name, _run(op, true));
+#ifdef MODULE_VFS_DCACHE
+    printf(", cached: %" PRIu32 " us", _run(op, false));
+#endif
+    printf(" (%u calls)\n", BENCH_ROUNDS);
+}
+
+int main(void)
+{
+    for (unsigned i = 0; i < BENCH_MOUNTS; i++) {
+        expect(vfs_mount(&_mounts[i]) == 0);
+    }
+
+    _bench("open+close", _open_close);
+    _bench("stat", _stat);
+#ifdef MODULE_VFS_DCACHE
+    vfs_dcache_stats_t stats;
+    vfs_dcache_stats(&stats);
+    printf("dcache: %" PRIu32 " hits, %" PRIu32 " misses\n",
+           stats.hits, stats.misses);
+#endif
+    puts("DONE");
+    return 0;
+}
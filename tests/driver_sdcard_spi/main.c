@@ -22,6 +22,8 @@
 #include "sdcard_spi_internal.h"
 #include "sdcard_spi_params.h"
 #include "fmt.h"
+#include "random.h"
+#include "xtimer.h"
 #include <inttypes.h>
 #include <stdlib.h>
 #include <string.h>
@@ -359,6 +361,85 @@ static int _sector_count(int argc, char **argv)
     return 0;
 }
 
+typedef int (*_bench_op_t)(int blockaddr, int nblocks);
+
+static int _bench_read(int blockaddr, int nblocks)
+{
+    sd_rw_response_t state;
+    sdcard_spi_read_blocks(card, blockaddr, buffer, SD_HC_BLOCK_SIZE, nblocks, &state);
+    return (state == SD_RW_OK) ? 0 : -1;
+}
+
+static int _bench_write(int blockaddr, int nblocks)
+{
+    sd_rw_response_t state;
+    sdcard_spi_write_blocks(card, blockaddr, buffer, SD_HC_BLOCK_SIZE, nblocks, &state);
+    return (state == SD_RW_OK) ? 0 : -1;
+}
+
+/* runs op on total blocks beginning at bladdr, per_call blocks at once, at
+   random positions within the area if random is set */
+static int _bench_run(const char *name, _bench_op_t op, int bladdr, int total,
+                      int per_call, bool random)
+{
+    uint32_t start = xtimer_now_usec();
+
+    for (int i = 0; i < total; i += per_call) {
+        int addr = bladdr + i;
+        if (random) {
+            addr = bladdr + random_uint32_range(0, total - per_call + 1);
+        }
+        if (op(addr, per_call) != 0) {
+            printf("%s: error at block %d\n", name, addr);
+            return -1;
+        }
+    }
+
+    uint32_t usec = xtimer_now_usec() - start;
+    if (usec == 0) {
+        usec = 1;
+    }
+    printf("%-24s %6d blocks in %9" PRIu32 " us: %6" PRIu32 " KiB/s, %6" PRIu32
+           " blocks/s\n", name, total, usec,
+           (uint32_t)(((uint64_t)total * SD_HC_BLOCK_SIZE * US_PER_SEC) / (usec * 1024ULL)),
+           (uint32_t)(((uint64_t)total * US_PER_SEC) / usec));
+    return 0;
+}
+
+static int _bench(int argc, char **argv)
+{
+    int bladdr;
+    int total;
+
+    if (argc != 3) {
+        printf("usage: %s blockaddr blockcount\n", argv[0]);
+        return -1;
+    }
+
+    bladdr = atoi(argv[1]);
+    total = atoi(argv[2]);
+    if ((total < MAX_BLOCKS_IN_BUFFER) || (total % MAX_BLOCKS_IN_BUFFER)) {
+        printf("blockcount must be a multiple of %d\n", MAX_BLOCKS_IN_BUFFER);
+        return -1;
+    }
+
+    for (unsigned i = 0; i < sizeof(buffer); i++) {
+        buffer[i] = i;
+    }
+
+    if (_bench_run("seq write (1 block)", _bench_write, bladdr, total, 1, false) ||
+        _bench_run("seq write (multi block)", _bench_write, bladdr, total,
+                   MAX_BLOCKS_IN_BUFFER, false) ||
+        _bench_run("rand write (1 block)", _bench_write, bladdr, total, 1, true) ||
+        _bench_run("seq read (1 block)", _bench_read, bladdr, total, 1, false) ||
+        _bench_run("seq read (multi block)", _bench_read, bladdr, total,
+                   MAX_BLOCKS_IN_BUFFER, false) ||
+        _bench_run("rand read (1 block)", _bench_read, bladdr, total, 1, true)) {
+        return -1;
+    }
+    return 0;
+}
+
 static const shell_command_t shell_commands[] = {
     { "init", "initializes default card", _init },
     { "cid",  "print content of CID (Card IDentification) register", _cid },
@@ -371,6 +452,8 @@ static const shell_command_t shell_commands[] = {
     { "write", "'write n data' writes data to block n. Append -r option to "
                "repeatedly write data to complete block", _write },
     { "copy", "'copy src dst' copies block src to block dst", _copy },
+    { "bench", "'bench n m' measures sequential and random read/write throughput on "
+               "m blocks beginning at block address n", _bench },
     { NULL, NULL, NULL }
 };
 
@@ -381,7 +464,7 @@ int main(void)
     card->init_done = false;
 
     puts("insert SD-card and use 'init' command to set card to spi mode");
-    puts("WARNING: using 'write' or 'copy' commands WILL overwrite data on your sd-card and");
+    puts("WARNING: using 'write', 'copy' or 'bench' commands WILL overwrite data on your sd-card and");
     puts("almost for sure corrupt existing filesystems, partitions and contained data!");
     char line_buf[SHELL_DEFAULT_BUFSIZE];
     shell_run(shell_commands, line_buf, SHELL_DEFAULT_BUFSIZE);
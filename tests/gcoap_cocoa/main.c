@@ -0,0 +1,189 @@
+/*
+ * Copyright (C) 2020 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     tests
+ * @{
+ *
+ * @file
+ * @brief       Goodput of gcoap over a lossy link
+ *
+ * A server thread answers CoAP requests on a separate UDP port of the
+ * loopback interface. It drops COCOA_LOSS percent of the requests and of the
+ * responses, and delays each response by COCOA_DELAY ms. gcoap sends
+ * COCOA_REQS confirmable requests to it at once. With the gcoap_cocoa module
+ * only CONFIG_GCOAP_NSTART of them are in flight at a time, and the
+ * retransmission timeout follows the measured round-trip time.
+ *
+ * Another server thread never answers. It times SILENT_SENDS transmissions of
+ * a request sent to it, each retransmission must wait longer than the one
+ * before.
+ *
+ * @}
+ */
+
+#include <inttypes.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "net/gcoap.h"
+#include "net/ipv6/addr.h"
+#include "random.h"
+#include "test_utils/expect.h"
+#include "thread.h"
+#include "xtimer.h"
+
+#define SERVER_PORT         (CONFIG_GCOAP_PORT + 1)
+#define SILENT_PORT         (CONFIG_GCOAP_PORT + 2)
+/* Transmissions of the unanswered request that are timed */
+#define SILENT_SENDS        (4U)
+/* Time to wait for all responses */
+#define COCOA_WAIT_US       (300U * US_PER_SEC)
+
+static char _server_stack[THREAD_STACKSIZE_DEFAULT];
+static uint8_t _server_buf[CONFIG_GCOAP_PDU_BUF_SIZE];
+static atomic_uint _resps;
+static atomic_uint _timeouts;
+static char _silent_stack[THREAD_STACKSIZE_DEFAULT];
+static uint8_t _silent_buf[CONFIG_GCOAP_PDU_BUF_SIZE];
+static uint32_t _silent_times[SILENT_SENDS];
+static atomic_uint _silent_sends;
+
+static bool _lost(void)
+{
+    return random_uint32_range(0, 100) < COCOA_LOSS;
+}
+
+static void *_server(void *arg)
+{
+    (void)arg;
+    sock_udp_ep_t local = { .family = AF_INET6, .port = SERVER_PORT };
+    sock_udp_ep_t remote;
+    sock_udp_t sock;
+
+    expect(sock_udp_create(&sock, &local, NULL, 0) == 0);
+    while (1) {
+        ssize_t res = sock_udp_recv(&sock, _server_buf, sizeof(_server_buf),
+                                    SOCK_NO_TIMEOUT, &remote);
+        coap_pkt_t pdu;
+        if ((res <= 0) || _lost()
+                || (coap_parse(&pdu, _server_buf, res) < 0)) {
+            continue;
+        }
+        res = coap_reply_simple(&pdu, COAP_CODE_CONTENT, _server_buf,
+                                sizeof(_server_buf), COAP_FORMAT_TEXT,
+                                (uint8_t *)"ok", 2);
+        xtimer_usleep(COCOA_DELAY * US_PER_MS);
+        if ((res > 0) && !_lost()) {
+            sock_udp_send(&sock, _server_buf, res, &remote);
+        }
+    }
+    return NULL;
+}
+
+/* Records when the transmissions of a request arrive, never answers */
+static void *_silent(void *arg)
+{
+    (void)arg;
+    sock_udp_ep_t local = { .family = AF_INET6, .port = SILENT_PORT };
+    sock_udp_t sock;
+
+    expect(sock_udp_create(&sock, &local, NULL, 0) == 0);
+    while (atomic_load(&_silent_sends) < SILENT_SENDS) {
+        if (sock_udp_recv(&sock, _silent_buf, sizeof(_silent_buf),
+                          SOCK_NO_TIMEOUT, NULL) > 0) {
+            _silent_times[atomic_load(&_silent_sends)] =
+                xtimer_now_usec() / US_PER_MS;
+            atomic_fetch_add(&_silent_sends, 1);
+        }
+    }
+    sock_udp_close(&sock);
+    return NULL;
+}
+
+static void _resp_handler(const gcoap_request_memo_t *memo, coap_pkt_t *pdu,
+                          const sock_udp_ep_t *remote)
+{
+    (void)pdu;
+    (void)remote;
+    if (memo->state == GCOAP_MEMO_RESP) {
+        atomic_fetch_add(&_resps, 1);
+    }
+    else {
+        atomic_fetch_add(&_timeouts, 1);
+    }
+}
+
+int main(void)
+{
+    uint8_t buf[CONFIG_GCOAP_PDU_BUF_SIZE];
+    sock_udp_ep_t remote = { .family = AF_INET6, .port = SERVER_PORT };
+    sock_udp_ep_t silent = { .family = AF_INET6, .port = SILENT_PORT };
+    gcoap_stats_t stats;
+    coap_pkt_t pdu;
+    unsigned sent = 0;
+
+    memcpy(remote.addr.ipv6, &ipv6_addr_loopback, sizeof(remote.addr.ipv6));
+    thread_create(_server_stack, sizeof(_server_stack),
+                  THREAD_PRIORITY_MAIN - 1, THREAD_CREATE_STACKTEST,
+                  _server, NULL, "server");
+    memcpy(silent.addr.ipv6, &ipv6_addr_loopback, sizeof(silent.addr.ipv6));
+    thread_create(_silent_stack, sizeof(_silent_stack),
+                  THREAD_PRIORITY_MAIN - 1, THREAD_CREATE_STACKTEST,
+                  _silent, NULL, "silent");
+
+    uint32_t start = xtimer_now_usec();
+    gcoap_req_init(&pdu, buf, sizeof(buf), COAP_METHOD_GET, "/silent");
+    coap_hdr_set_type(pdu.hdr, COAP_TYPE_CON);
+    size_t len = coap_opt_finish(&pdu, COAP_OPT_FINISH_NONE);
+    expect(gcoap_req_send(buf, len, &silent, NULL, NULL) > 0);
+    for (unsigned i = 0; i < COCOA_REQS; i++) {
+        gcoap_req_init(&pdu, buf, sizeof(buf), COAP_METHOD_GET, "/cocoa");
+        coap_hdr_set_type(pdu.hdr, COAP_TYPE_CON);
+        len = coap_opt_finish(&pdu, COAP_OPT_FINISH_NONE);
+        if (gcoap_req_send(buf, len, &remote, _resp_handler, NULL) > 0) {
+            sent++;
+        }
+    }
+    printf("cocoa: %u requests, %u%% loss, %u ms delay\n", sent, COCOA_LOSS,
+           COCOA_DELAY);
+
+    while ((atomic_load(&_resps) + atomic_load(&_timeouts) < sent) &&
+           (xtimer_now_usec() - start < COCOA_WAIT_US)) {
+        xtimer_usleep(10 * US_PER_MS);
+    }
+    uint32_t time = (xtimer_now_usec() - start) / US_PER_MS;
+    unsigned resps = atomic_load(&_resps);
+
+    gcoap_get_stats(&stats);
+    printf("cocoa: %u responses, %u timeouts in %" PRIu32 " ms\n",
+           resps, atomic_load(&_timeouts), time);
+    printf("cocoa: goodput %" PRIu32 " responses/s, %" PRIu32
+           " retransmissions, RTO %" PRIu32 " ms\n",
+           (uint32_t)(resps * MS_PER_SEC / (time ? time : 1)),
+           stats.retransmissions, gcoap_get_rto(&remote));
+
+    while ((atomic_load(&_silent_sends) < SILENT_SENDS) &&
+           (xtimer_now_usec() - start < COCOA_WAIT_US)) {
+        xtimer_usleep(10 * US_PER_MS);
+    }
+    expect(atomic_load(&_silent_sends) == SILENT_SENDS);
+    printf("cocoa: retransmitted after");
+    uint32_t prev = 0;
+    for (unsigned i = 1; i < SILENT_SENDS; i++) {
+        uint32_t timeout = _silent_times[i] - _silent_times[i - 1];
+        printf(" %" PRIu32 " ms", timeout);
+        /* the backoff factor is at least 1.5, 4/3 without gcoap_cocoa */
+        expect(4 * timeout > 5 * prev);
+        prev = timeout;
+    }
+    puts("");
+    puts("DONE");
+    return 0;
+}
@@ -0,0 +1,28 @@
+#!/usr/bin/env python3
+
+# Copyright (C) 2020 Freie Universität Berlin
+#
+# This file is subject to the terms and conditions of the GNU Lesser
+# General Public License v2.1. See the file LICENSE in the top level
+# directory for more details.
+
+import sys
+from testrunner import run
+
+
+def testfunc(child):
+    child.expect(r"cocoa: (\d+) requests, \d+% loss, \d+ ms delay\r\n")
+    sent = int(child.match.group(1))
+    child.expect(r"cocoa: (\d+) responses, (\d+) timeouts in \d+ ms\r\n")
+    assert int(child.match.group(1)) + int(child.match.group(2)) == sent
+    child.expect(r"cocoa: goodput \d+ responses/s, \d+ retransmissions, "
+                 r"RTO \d+ ms\r\n")
+    child.expect(r"cocoa: retransmitted after (\d+) ms (\d+) ms (\d+) ms\r\n")
+    timeouts = [int(t) for t in child.match.groups()]
+    assert timeouts == sorted(timeouts)
+    child.expect_exact("DONE")
+
+
+if __name__ == "__main__":
+    # with the default timeouts, lost requests take up to a minute
+    sys.exit(run(testfunc, timeout=320))
@@ -0,0 +1,181 @@
+/*
+ * Copyright (C) 2020 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     tests
+ * @{
+ *
+ * @file
+ * @brief       Hit rate of the gcoap forward proxy
+ *
+ * An origin server thread answers requests for /temp on a separate UDP port
+ * of the loopback interface, with a Max-Age of PROXY_MAX_AGE s. Its value,
+ * and with it the ETag, changes every ORIGIN_PERIOD_US. A request with the
+ * current ETag is answered with 2.03 Valid.
+ *
+ * The client sends PROXY_REQS confirmable requests with a Proxy-Uri option
+ * to gcoap, one every PROXY_INTERVAL ms, from a third port. Requests are
+ * answered from the cache of the proxy while the response is fresh.
+ *
+ * @}
+ */
+
+#include <inttypes.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "net/gcoap.h"
+#include "net/ipv6/addr.h"
+#include "net/nanocoap_cache.h"
+#include "test_utils/expect.h"
+#include "thread.h"
+#include "xtimer.h"
+
+#define ORIGIN_PORT         (CONFIG_GCOAP_PORT + 1)
+#define CLIENT_PORT         (CONFIG_GCOAP_PORT + 2)
+#define ORIGIN_PERIOD_US    (3U * US_PER_SEC)
+/* Time to wait for a response */
+#define CLIENT_TIMEOUT_US   (1U * US_PER_SEC)
+
+static char _origin_stack[THREAD_STACKSIZE_DEFAULT];
+static uint8_t _origin_req[CONFIG_GCOAP_PDU_BUF_SIZE];
+static uint8_t _origin_resp[CONFIG_GCOAP_PDU_BUF_SIZE];
+static atomic_uint _origin_reqs;
+static atomic_uint _origin_valid;
+
+static ssize_t _origin_reply(coap_pkt_t *req)
+{
+    uint8_t etag = xtimer_now_usec() / ORIGIN_PERIOD_US;
+    unsigned code = COAP_CODE_CONTENT;
+    uint8_t *req_etag;
+    coap_pkt_t pdu;
+    char value[16];
+
+    if ((coap_opt_get_opaque(req, COAP_OPT_ETAG, &req_etag) == 1)
+            && (*req_etag == etag)) {
+        code = COAP_CODE_VALID;
+        atomic_fetch_add(&_origin_valid, 1);
+    }
+
+    size_t len = coap_build_hdr((coap_hdr_t *)_origin_resp, COAP_TYPE_ACK,
+                                req->token, coap_get_token_len(req), code,
+                                coap_get_id(req));
+    coap_pkt_init(&pdu, _origin_resp, sizeof(_origin_resp), len);
+    coap_opt_add_opaque(&pdu, COAP_OPT_ETAG, &etag, sizeof(etag));
+    if (code == COAP_CODE_VALID) {
+        coap_opt_add_uint(&pdu, COAP_OPT_MAX_AGE, PROXY_MAX_AGE);
+        return coap_opt_finish(&pdu, COAP_OPT_FINISH_NONE);
+    }
+
+    coap_opt_add_format(&pdu, COAP_FORMAT_TEXT);
+    coap_opt_add_uint(&pdu, COAP_OPT_MAX_AGE, PROXY_MAX_AGE);
+    len = coap_opt_finish(&pdu, COAP_OPT_FINISH_PAYLOAD);
+    int value_len = snprintf(value, sizeof(value), "%u", 200U + etag);
+    memcpy(pdu.payload, value, value_len);
+    return len + value_len;
+}
+
+static void *_origin(void *arg)
+{
+    (void)arg;
+    sock_udp_ep_t local = { .family = AF_INET6, .port = ORIGIN_PORT };
+    sock_udp_ep_t remote;
+    sock_udp_t sock;
+
+    expect(sock_udp_create(&sock, &local, NULL, 0) == 0);
+    while (1) {
+        ssize_t res = sock_udp_recv(&sock, _origin_req, sizeof(_origin_req),
+                                    SOCK_NO_TIMEOUT, &remote);
+        coap_pkt_t pdu;
+        char path[16];
+        if ((res <= 0) || (coap_parse(&pdu, _origin_req, res) < 0)
+                || (coap_get_type(&pdu) != COAP_TYPE_CON)) {
+            continue;
+        }
+        /* the proxy removes the Proxy-Uri option */
+        expect(coap_get_uri_path(&pdu, (uint8_t *)path) > 0);
+        expect(strcmp(path, "/temp") == 0);
+        atomic_fetch_add(&_origin_reqs, 1);
+
+        res = _origin_reply(&pdu);
+        if (res > 0) {
+            sock_udp_send(&sock, _origin_resp, res, &remote);
+        }
+    }
+    return NULL;
+}
+
+/* Sends a request to the proxy and waits for its response */
+static bool _request(sock_udp_t *sock, uint16_t id)
+{
+    sock_udp_ep_t proxy = { .family = AF_INET6, .port = CONFIG_GCOAP_PORT };
+    uint8_t buf[CONFIG_GCOAP_PDU_BUF_SIZE];
+    uint8_t token[2] = { id >> 8, id & 0xff };
+    char uri[40];
+    coap_pkt_t pdu;
+
+    memcpy(proxy.addr.ipv6, &ipv6_addr_loopback, sizeof(proxy.addr.ipv6));
+    snprintf(uri, sizeof(uri), "coap://[::1]:%u/temp", ORIGIN_PORT);
+
+    size_t len = coap_build_hdr((coap_hdr_t *)buf, COAP_TYPE_CON, token,
+                                sizeof(token), COAP_METHOD_GET, id);
+    coap_pkt_init(&pdu, buf, sizeof(buf), len);
+    coap_opt_add_proxy_uri(&pdu, uri);
+    len = coap_opt_finish(&pdu, COAP_OPT_FINISH_NONE);
+    expect(sock_udp_send(sock, buf, len, &proxy) > 0);
+
+    /* a forwarded request is acknowledged first, the response follows */
+    uint32_t start = xtimer_now_usec();
+    while (xtimer_now_usec() - start < CLIENT_TIMEOUT_US) {
+        ssize_t res = sock_udp_recv(sock, buf, sizeof(buf), CLIENT_TIMEOUT_US,
+                                    NULL);
+        if ((res <= 0) || (coap_parse(&pdu, buf, res) < 0)
+                || (coap_get_code_raw(&pdu) == COAP_CODE_EMPTY)) {
+            continue;
+        }
+        if ((coap_get_token_len(&pdu) == sizeof(token))
+                && (memcmp(pdu.token, token, sizeof(token)) == 0)) {
+            return coap_get_code_raw(&pdu) == COAP_CODE_CONTENT;
+        }
+    }
+    return false;
+}
+
+int main(void)
+{
+    sock_udp_ep_t local = { .family = AF_INET6, .port = CLIENT_PORT };
+    nanocoap_cache_stats_t stats;
+    unsigned resps = 0;
+    sock_udp_t sock;
+
+    thread_create(_origin_stack, sizeof(_origin_stack),
+                  THREAD_PRIORITY_MAIN - 1, THREAD_CREATE_STACKTEST,
+                  _origin, NULL, "origin");
+    expect(sock_udp_create(&sock, &local, NULL, 0) == 0);
+
+    for (unsigned i = 0; i < PROXY_REQS; i++) {
+        if (_request(&sock, i)) {
+            resps++;
+        }
+        xtimer_usleep(PROXY_INTERVAL * US_PER_MS);
+    }
+
+    nanocoap_cache_get_stats(&stats);
+    unsigned lookups = stats.hits + stats.stale + stats.misses;
+    printf("proxy: %u requests, %u responses\n", PROXY_REQS, resps);
+    printf("proxy: origin server: %u requests, %u validated\n",
+           atomic_load(&_origin_reqs), atomic_load(&_origin_valid));
+    printf("proxy: cache: %" PRIu32 " hits, %" PRIu32 " stale, %" PRIu32
+           " misses, %" PRIu32 " validations\n", stats.hits, stats.stale,
+           stats.misses, stats.validations);
+    printf("proxy: hit rate %u%%\n",
+           lookups ? (unsigned)(stats.hits * 100 / lookups) : 0);
+    puts("DONE");
+    return 0;
+}
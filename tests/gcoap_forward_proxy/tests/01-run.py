@@ -0,0 +1,29 @@
+#!/usr/bin/env python3
+
+# Copyright (C) 2020 Freie Universität Berlin
+#
+# This file is subject to the terms and conditions of the GNU Lesser
+# General Public License v2.1. See the file LICENSE in the top level
+# directory for more details.
+
+import sys
+from testrunner import run
+
+
+def testfunc(child):
+    child.expect(r"proxy: (\d+) requests, (\d+) responses\r\n")
+    assert int(child.match.group(1)) == int(child.match.group(2))
+    child.expect(r"proxy: origin server: (\d+) requests, (\d+) validated\r\n")
+    forwarded = int(child.match.group(1))
+    child.expect(r"proxy: cache: (\d+) hits, (\d+) stale, (\d+) misses, "
+                 r"(\d+) validations\r\n")
+    stale = int(child.match.group(2))
+    misses = int(child.match.group(3))
+    # only requests not served from the cache reach the origin server
+    assert forwarded == stale + misses
+    child.expect(r"proxy: hit rate \d+%\r\n")
+    child.expect_exact("DONE")
+
+
+if __name__ == "__main__":
+    sys.exit(run(testfunc))
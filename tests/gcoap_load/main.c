@@ -0,0 +1,137 @@
+/*
+ * Copyright (C) 2020 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     tests
+ * @{
+ *
+ * @file
+ * @brief       Load test for many concurrent gcoap requests
+ *
+ * Each instance serves the `/load` resource. The `load` shell command sends
+ * confirmable requests for it to another instance, without waiting for the
+ * responses, so that up to CONFIG_GCOAP_REQ_WAITING_MAX requests are open at
+ * the same time.
+ *
+ * @}
+ */
+
+#include <inttypes.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "msg.h"
+#include "net/gcoap.h"
+#include "net/sock/util.h"
+#include "shell.h"
+#include "xtimer.h"
+
+#define MAIN_QUEUE_SIZE     (8U)
+/* Requests sent before yielding, so the server can keep up */
+#define LOAD_BURST          (16U)
+/* Time to wait for all responses */
+#define LOAD_WAIT_US        (60U * US_PER_SEC)
+
+static msg_t _main_msg_queue[MAIN_QUEUE_SIZE];
+static atomic_uint _resps;
+static atomic_uint _timeouts;
+
+static ssize_t _load_handler(coap_pkt_t *pdu, uint8_t *buf, size_t len,
+                             void *ctx)
+{
+    (void)ctx;
+    return coap_reply_simple(pdu, COAP_CODE_CONTENT, buf, len,
+                             COAP_FORMAT_TEXT, (uint8_t *)"ok", 2);
+}
+
+static const coap_resource_t _resources[] = {
+    { "/load", COAP_GET, _load_handler, NULL },
+};
+
+static gcoap_listener_t _listener = {
+    &_resources[0],
+    ARRAY_SIZE(_resources),
+    NULL,
+    NULL
+};
+
+static void _resp_handler(const gcoap_request_memo_t *memo, coap_pkt_t *pdu,
+                          const sock_udp_ep_t *remote)
+{
+    (void)pdu;
+    (void)remote;
+    if (memo->state == GCOAP_MEMO_RESP) {
+        atomic_fetch_add(&_resps, 1);
+    }
+    else {
+        atomic_fetch_add(&_timeouts, 1);
+    }
+}
+
+static int _load_cmd(int argc, char **argv)
+{
+    uint8_t buf[CONFIG_GCOAP_PDU_BUF_SIZE];
+    sock_udp_ep_t remote;
+    coap_pkt_t pdu;
+    unsigned count, sent = 0;
+    uint32_t start;
+
+    if (argc < 3) {
+        printf("usage: %s <[addr]:port> <count>\n", argv[0]);
+        return 1;
+    }
+    if (sock_udp_str2ep(&remote, argv[1]) < 0) {
+        puts("load: invalid address");
+        return 1;
+    }
+    if (remote.port == 0) {
+        remote.port = CONFIG_GCOAP_PORT;
+    }
+    count = atoi(argv[2]);
+    atomic_store(&_resps, 0);
+    atomic_store(&_timeouts, 0);
+
+    start = xtimer_now_usec();
+    for (unsigned i = 0; i < count; i++) {
+        gcoap_req_init(&pdu, buf, sizeof(buf), COAP_METHOD_GET, "/load");
+        coap_hdr_set_type(pdu.hdr, COAP_TYPE_CON);
+        size_t len = coap_opt_finish(&pdu, COAP_OPT_FINISH_NONE);
+        if (gcoap_req_send(buf, len, &remote, _resp_handler, NULL) > 0) {
+            sent++;
+        }
+        if ((i % LOAD_BURST) == (LOAD_BURST - 1)) {
+            xtimer_usleep(US_PER_MS);
+        }
+    }
+    printf("load: %u requests sent, %u open\n", sent, gcoap_op_state());
+
+    while ((atomic_load(&_resps) + atomic_load(&_timeouts) < sent) &&
+           (xtimer_now_usec() - start < LOAD_WAIT_US)) {
+        xtimer_usleep(10 * US_PER_MS);
+    }
+    printf("load: %u responses, %u timeouts in %" PRIu32 " ms\n",
+           atomic_load(&_resps), atomic_load(&_timeouts),
+           (uint32_t)((xtimer_now_usec() - start) / US_PER_MS));
+    return 0;
+}
+
+static const shell_command_t _commands[] = {
+    { "load", "send many concurrent requests", _load_cmd },
+    { NULL, NULL, NULL }
+};
+
+int main(void)
+{
+    msg_init_queue(_main_msg_queue, MAIN_QUEUE_SIZE);
+    gcoap_register_listener(&_listener);
+
+    char line_buf[SHELL_DEFAULT_BUFSIZE];
+    shell_run(_commands, line_buf, SHELL_DEFAULT_BUFSIZE);
+    return 0;
+}
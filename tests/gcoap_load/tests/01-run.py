@@ -0,0 +1,50 @@
+#!/usr/bin/env python3
+
+# Copyright (C) 2020 Freie Universität Berlin
+#
+# This file is subject to the terms and conditions of the GNU Lesser
+# General Public License v2.1. See the file LICENSE in the top level
+# directory for more details.
+
+# Starts two native instances on tap0 and tap1 (see dist/tools/tapsetup) and
+# lets one send LOAD_REQS concurrent confirmable requests to the other.
+
+import os
+import sys
+import time
+
+import pexpect
+
+MAKE = os.environ.get('MAKE', 'make')
+LOAD_REQS = int(os.environ.get('LOAD_REQS', 500))
+
+
+def spawn(tap):
+    env = os.environ.copy()
+    env['PORT'] = tap
+    child = pexpect.spawnu(MAKE, ["term"], env=env, timeout=10,
+                           logfile=sys.stdout)
+    child.sendline("ifconfig")
+    child.expect(r"inet6 addr:\s+(fe80:[0-9a-f:]+)\s+scope: link")
+    return child, child.match.group(1)
+
+
+def main():
+    server, server_ip = spawn(os.environ.get('TAP_SERVER', 'tap1'))
+    client, _ = spawn(os.environ.get('TAP_CLIENT', 'tap0'))
+    # wait for duplicate address detection to finish
+    time.sleep(3)
+
+    client.sendline("load [{}]:5683 {}".format(server_ip, LOAD_REQS))
+    client.expect_exact("load: {} requests sent".format(LOAD_REQS))
+    client.expect(r"load: {} responses, 0 timeouts in \d+ ms"
+                  .format(LOAD_REQS), timeout=90)
+
+    client.close()
+    server.close()
+    print("SUCCESS")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
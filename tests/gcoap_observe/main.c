@@ -0,0 +1,296 @@
+/*
+ * Copyright (C) 2020 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     tests
+ * @{
+ *
+ * @file
+ * @brief       Observe notifications of gcoap to many observers
+ *
+ * OBS_CLIENTS observers, each on its own UDP port of the loopback interface,
+ * register for the /value resource of gcoap. Their tokens have all lengths up
+ * to GCOAP_TOKENLEN_MAX. The value changes OBS_UPDATES times, every
+ * OBS_PERIOD ms, while gcoap sends at most one notification every
+ * CONFIG_GCOAP_OBS_MIN_INTERVAL ms. Each observer must end up with the last
+ * value. Then half of the observers cancel their registration.
+ *
+ * @}
+ */
+
+#include <inttypes.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "event.h"
+#include "net/gcoap.h"
+#include "net/ipv6/addr.h"
+#include "net/sock/async/event.h"
+#include "test_utils/expect.h"
+#include "thread.h"
+#include "xtimer.h"
+
+#define CLIENT_PORT         (CONFIG_GCOAP_PORT + 1)
+/* Time to wait for the messages of a step */
+#define OBS_WAIT_US         (10U * US_PER_SEC)
+
+typedef struct {
+    sock_udp_t sock;
+    atomic_uint value;                  /* Last value received */
+    atomic_uint notifications;          /* Notifications received */
+    atomic_bool registered;             /* Registration confirmed */
+    atomic_bool cancelled;              /* Cancellation confirmed */
+} _observer_t;
+
+static char _client_stack[THREAD_STACKSIZE_DEFAULT];
+static _observer_t _observers[OBS_CLIENTS];
+static sock_udp_ep_t _server = { .family = AF_INET6, .port = CONFIG_GCOAP_PORT };
+static event_queue_t _queue;
+static atomic_bool _ready;
+static atomic_uint _errors;
+static atomic_uint _value;
+
+static ssize_t _value_handler(coap_pkt_t *pdu, uint8_t *buf, size_t len,
+                              void *ctx);
+
+static const coap_resource_t _resources[] = {
+    { "/value", COAP_GET, _value_handler, NULL },
+};
+
+static gcoap_listener_t _listener = {
+    &_resources[0],
+    ARRAY_SIZE(_resources),
+    NULL,
+    NULL
+};
+
+static size_t _write_value(coap_pkt_t *pdu)
+{
+    return snprintf((char *)pdu->payload, pdu->payload_len, "%u",
+                    atomic_load(&_value));
+}
+
+static ssize_t _value_handler(coap_pkt_t *pdu, uint8_t *buf, size_t len,
+                              void *ctx)
+{
+    (void)ctx;
+    gcoap_resp_init(pdu, buf, len, COAP_CODE_CONTENT);
+    coap_opt_add_format(pdu, COAP_FORMAT_TEXT);
+    size_t resp_len = coap_opt_finish(pdu, COAP_OPT_FINISH_PAYLOAD);
+    return resp_len + _write_value(pdu);
+}
+
+/* Token of an observer, of length i modulo (GCOAP_TOKENLEN_MAX + 1) */
+static unsigned _token(unsigned i, uint8_t *token)
+{
+    unsigned len = i % (GCOAP_TOKENLEN_MAX + 1);
+
+    for (unsigned k = 0; k < len; k++) {
+        token[k] = i + k;
+    }
+    return len;
+}
+
+static void _on_msg(sock_udp_t *sock, sock_async_flags_t type, void *arg)
+{
+    _observer_t *observer = arg;
+    uint8_t token[GCOAP_TOKENLEN_MAX];
+    unsigned token_len = _token(observer - _observers, token);
+    uint8_t buf[64];
+    ssize_t res;
+
+    if (!(type & SOCK_ASYNC_MSG_RECV)) {
+        return;
+    }
+    while ((res = sock_udp_recv(sock, buf, sizeof(buf) - 1, 0, NULL)) > 0) {
+        coap_pkt_t pdu;
+        if ((coap_parse(&pdu, buf, res) < 0)
+                || (coap_get_code_raw(&pdu) != COAP_CODE_CONTENT)
+                || (coap_get_token_len(&pdu) != token_len)
+                || (token_len && memcmp(pdu.token, token, token_len))) {
+            atomic_fetch_add(&_errors, 1);
+            continue;
+        }
+        if (!coap_has_observe(&pdu)) {
+            atomic_store(&observer->cancelled, true);
+            continue;
+        }
+        if (coap_get_type(&pdu) == COAP_TYPE_ACK) {
+            atomic_store(&observer->registered, true);
+        }
+        else {
+            atomic_fetch_add(&observer->notifications, 1);
+        }
+        pdu.payload[pdu.payload_len] = '\0';
+        atomic_store(&observer->value, strtoul((char *)pdu.payload, NULL, 10));
+    }
+}
+
+static void *_client(void *arg)
+{
+    (void)arg;
+    event_queue_init(&_queue);
+    for (unsigned i = 0; i < OBS_CLIENTS; i++) {
+        sock_udp_ep_t local = { .family = AF_INET6, .port = CLIENT_PORT + i };
+        expect(sock_udp_create(&_observers[i].sock, &local, NULL, 0) == 0);
+        sock_udp_event_init(&_observers[i].sock, &_queue, _on_msg,
+                            &_observers[i]);
+    }
+    atomic_store(&_ready, true);
+    event_loop(&_queue);
+    return NULL;
+}
+
+/* Sends a GET request for /value with an Observe option from an observer */
+static void _request(unsigned i, uint32_t observe)
+{
+    uint8_t token[GCOAP_TOKENLEN_MAX];
+    uint8_t buf[32];
+    coap_pkt_t pdu;
+
+    ssize_t len = coap_build_hdr((coap_hdr_t *)buf, COAP_TYPE_CON, token,
+                                 _token(i, token), COAP_METHOD_GET, i);
+    coap_pkt_init(&pdu, buf, sizeof(buf), len);
+    coap_opt_add_uint(&pdu, COAP_OPT_OBSERVE, observe);
+    coap_opt_add_uri_path(&pdu, "/value");
+    len = coap_opt_finish(&pdu, COAP_OPT_FINISH_NONE);
+    expect(sock_udp_send(&_observers[i].sock, buf, len, &_server) == len);
+}
+
+/* Sends a notification with the current value, returns the time it took */
+static uint32_t _notify(void)
+{
+    uint8_t buf[CONFIG_GCOAP_PDU_BUF_SIZE];
+    coap_pkt_t pdu;
+
+    expect(gcoap_obs_init(&pdu, buf, sizeof(buf), &_resources[0])
+           == GCOAP_OBS_INIT_OK);
+    coap_opt_add_format(&pdu, COAP_FORMAT_TEXT);
+    size_t len = coap_opt_finish(&pdu, COAP_OPT_FINISH_PAYLOAD);
+    len += _write_value(&pdu);
+
+    uint32_t time = xtimer_now_usec();
+    expect(gcoap_obs_send(buf, len, &_resources[0]) == len);
+    return xtimer_now_usec() - time;
+}
+
+/* Number of observers that confirmed their registration */
+static unsigned _registered(void)
+{
+    unsigned count = 0;
+
+    for (unsigned i = 0; i < OBS_CLIENTS; i++) {
+        count += atomic_load(&_observers[i].registered);
+    }
+    return count;
+}
+
+/* Number of observers that confirmed their cancellation */
+static unsigned _cancelled(void)
+{
+    unsigned count = 0;
+
+    for (unsigned i = 0; i < OBS_CLIENTS; i++) {
+        count += atomic_load(&_observers[i].cancelled);
+    }
+    return count;
+}
+
+/* Number of observers registered that received the current value */
+static unsigned _current(void)
+{
+    unsigned count = 0;
+
+    for (unsigned i = 0; i < OBS_CLIENTS; i++) {
+        if (!atomic_load(&_observers[i].cancelled)
+                && (atomic_load(&_observers[i].value) == atomic_load(&_value))) {
+            count++;
+        }
+    }
+    return count;
+}
+
+/* Waits until count() returns n, returns false on timeout */
+static bool _wait(unsigned (*count)(void), unsigned n)
+{
+    uint32_t start = xtimer_now_usec();
+
+    while (count() < n) {
+        if (xtimer_now_usec() - start > OBS_WAIT_US) {
+            return false;
+        }
+        xtimer_usleep(10 * US_PER_MS);
+    }
+    return true;
+}
+
+int main(void)
+{
+    gcoap_stats_t stats;
+
+    memcpy(_server.addr.ipv6, &ipv6_addr_loopback, sizeof(_server.addr.ipv6));
+    gcoap_register_listener(&_listener);
+    thread_create(_client_stack, sizeof(_client_stack),
+                  THREAD_PRIORITY_MAIN - 1, THREAD_CREATE_STACKTEST,
+                  _client, NULL, "observers");
+    while (!atomic_load(&_ready)) {
+        xtimer_usleep(10 * US_PER_MS);
+    }
+
+    for (unsigned i = 0; i < OBS_CLIENTS; i++) {
+        _request(i, COAP_OBS_REGISTER);
+    }
+    expect(_wait(_registered, OBS_CLIENTS));
+    printf("observe: %u observers registered\n", _registered());
+
+    /* the first notification is sent at once */
+    atomic_store(&_value, 1);
+    uint32_t time = _notify();
+    expect(_wait(_current, OBS_CLIENTS));
+    printf("observe: notification to %u observers sent in %" PRIu32 " us\n",
+           OBS_CLIENTS, time);
+
+    for (unsigned u = 0; u < OBS_UPDATES; u++) {
+        atomic_fetch_add(&_value, 1);
+        _notify();
+        xtimer_usleep(OBS_PERIOD * US_PER_MS);
+    }
+    expect(_wait(_current, OBS_CLIENTS));
+    unsigned max = 0;
+    for (unsigned i = 0; i < OBS_CLIENTS; i++) {
+        unsigned notifications = atomic_load(&_observers[i].notifications) - 1;
+        max = (notifications > max) ? notifications : max;
+    }
+    expect(max <= OBS_UPDATES);
+    gcoap_get_stats(&stats);
+    printf("observe: %u updates, at most %u notifications per observer, "
+           "%" PRIu32 " conflated\n", OBS_UPDATES, max, stats.conflated);
+
+    for (unsigned i = 0; i < OBS_CLIENTS; i += 2) {
+        _request(i, COAP_OBS_DEREGISTER);
+    }
+    expect(_wait(_cancelled, (OBS_CLIENTS + 1) / 2));
+    atomic_fetch_add(&_value, 1);
+    _notify();
+    expect(_wait(_current, OBS_CLIENTS / 2));
+    /* cancelled observers do not get the notification */
+    xtimer_usleep(2 * CONFIG_GCOAP_OBS_MIN_INTERVAL * US_PER_MS);
+    for (unsigned i = 0; i < OBS_CLIENTS; i += 2) {
+        expect(atomic_load(&_observers[i].value) != atomic_load(&_value));
+    }
+    printf("observe: %u observers left after cancellation\n", _current());
+
+    gcoap_get_stats(&stats);
+    printf("observe: %" PRIu32 " notifications sent, %u errors\n",
+           stats.notifications, atomic_load(&_errors));
+    expect(atomic_load(&_errors) == 0);
+    puts("DONE");
+    return 0;
+}
@@ -0,0 +1,30 @@
+#!/usr/bin/env python3
+
+# Copyright (C) 2020 Freie Universität Berlin
+#
+# This file is subject to the terms and conditions of the GNU Lesser
+# General Public License v2.1. See the file LICENSE in the top level
+# directory for more details.
+
+import sys
+from testrunner import run
+
+
+def testfunc(child):
+    child.expect(r"observe: (\d+) observers registered\r\n")
+    observers = int(child.match.group(1))
+    child.expect(r"observe: notification to (\d+) observers sent in "
+                 r"\d+ us\r\n")
+    assert int(child.match.group(1)) == observers
+    child.expect(r"observe: (\d+) updates, at most (\d+) notifications per "
+                 r"observer, (\d+) conflated\r\n")
+    updates = int(child.match.group(1))
+    assert int(child.match.group(2)) <= updates
+    child.expect(r"observe: (\d+) observers left after cancellation\r\n")
+    assert int(child.match.group(1)) == observers // 2
+    child.expect(r"observe: (\d+) notifications sent, 0 errors\r\n")
+    child.expect_exact("DONE")
+
+
+if __name__ == "__main__":
+    sys.exit(run(testfunc))
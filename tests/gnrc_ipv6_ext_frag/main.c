@@ -100,6 +100,44 @@ static void tear_down_tests(void)
     gnrc_pktbuf_init();
 }
 
+static void _check_frag_payload(const gnrc_ipv6_ext_frag_limits_t *limits,
+                                unsigned offset, unsigned size)
+{
+    /* payloads of fragments are kept in place until reassembly completes */
+    TEST_ASSERT_NOT_NULL(limits->pkt);
+    TEST_ASSERT_NULL(limits->pkt->next);
+    TEST_ASSERT_EQUAL_INT(size, limits->pkt->size);
+    TEST_ASSERT(memcmp(&_exp_payload[offset], limits->pkt->data, size) == 0);
+}
+
+static gnrc_pktsnip_t *_build_frag(uint32_t id, unsigned offset, unsigned size,
+                                   bool more)
+{
+    gnrc_pktsnip_t *ipv6_snip = gnrc_ipv6_hdr_build(NULL, &_src, &_dst);
+    gnrc_pktsnip_t *pkt;
+    ipv6_hdr_t *ipv6;
+    ipv6_ext_frag_t *frag;
+
+    expect(ipv6_snip != NULL);
+    pkt = gnrc_pktbuf_add(ipv6_snip, NULL, sizeof(ipv6_ext_frag_t) + size,
+                          GNRC_NETTYPE_UNDEF);
+    expect(pkt != NULL);
+    ipv6 = ipv6_snip->data;
+    frag = pkt->data;
+    memset(frag + 1, 0xab, size);
+    ipv6->nh = PROTNUM_IPV6_EXT_FRAG;
+    ipv6->hl = TEST_HL;
+    ipv6->len = byteorder_htons(pkt->size);
+    frag->nh = PROTNUM_UDP;
+    frag->resv = 0U;
+    ipv6_ext_frag_set_offset(frag, offset);
+    if (more) {
+        ipv6_ext_frag_set_more(frag);
+    }
+    frag->id = byteorder_htonl(id);
+    return pkt;
+}
+
 static void test_ipv6_ext_frag_rbuf_get(void)
 {
     static ipv6_hdr_t ipv6 = { .src = { .u8 = TEST_SRC },
@@ -204,10 +242,11 @@ static void test_ipv6_ext_frag_reass_in_order(void)
     TEST_ASSERT_NULL(gnrc_ipv6_ext_frag_reass(pkt));
     TEST_ASSERT_NOT_NULL((rbuf = gnrc_ipv6_ext_frag_rbuf_get(ipv6, TEST_ID)));
     TEST_ASSERT_NOT_NULL(rbuf->pkt);
-    TEST_ASSERT_EQUAL_INT(sizeof(_test_frag1) - sizeof(ipv6_ext_frag_t),
-                          rbuf->pkt->size);
+    TEST_ASSERT_EQUAL_INT(GNRC_NETTYPE_IPV6, rbuf->pkt->type);
     TEST_ASSERT_MESSAGE(ipv6 == rbuf->ipv6, "IPv6 header is not the same");
     TEST_ASSERT_EQUAL_INT(TEST_ID, rbuf->id);
+    TEST_ASSERT_EQUAL_INT(sizeof(_test_frag1) - sizeof(ipv6_ext_frag_t),
+                          rbuf->held);
     TEST_ASSERT(!rbuf->last);
     ptr = (gnrc_ipv6_ext_frag_limits_t *)rbuf->limits.next;
     TEST_ASSERT_NOT_NULL(ptr);
@@ -216,7 +255,8 @@ static void test_ipv6_ext_frag_reass_in_order(void)
     TEST_ASSERT_EQUAL_INT(0, ptr->start);
     TEST_ASSERT_EQUAL_INT(TEST_FRAG2_OFFSET / 8, ptr->end);
     TEST_ASSERT(((clist_node_t *)ptr) == rbuf->limits.next);
-    TEST_ASSERT(memcmp(_exp_payload, rbuf->pkt->data, rbuf->pkt->size) == 0);
+    _check_frag_payload(ptr, TEST_FRAG1_OFFSET,
+                        sizeof(_test_frag1) - sizeof(ipv6_ext_frag_t));
 
     /* prepare 2nd fragment */
     ipv6_snip = gnrc_ipv6_hdr_build(NULL, &_src, &_dst);
@@ -240,7 +280,7 @@ static void test_ipv6_ext_frag_reass_in_order(void)
     TEST_ASSERT_NOT_NULL(rbuf->pkt);
     TEST_ASSERT_EQUAL_INT(sizeof(_test_frag1) + sizeof(_test_frag2) -
                           (2 * sizeof(ipv6_ext_frag_t)),
-                          rbuf->pkt->size);
+                          rbuf->held);
     TEST_ASSERT_EQUAL_INT(TEST_ID, rbuf->id);
     TEST_ASSERT(!rbuf->last);
     ptr = (gnrc_ipv6_ext_frag_limits_t *)rbuf->limits.next;
@@ -249,13 +289,16 @@ static void test_ipv6_ext_frag_reass_in_order(void)
     TEST_ASSERT_NOT_NULL(ptr);
     TEST_ASSERT_EQUAL_INT(0, ptr->start);
     TEST_ASSERT_EQUAL_INT(TEST_FRAG2_OFFSET / 8, ptr->end);
+    _check_frag_payload(ptr, TEST_FRAG1_OFFSET,
+                        sizeof(_test_frag1) - sizeof(ipv6_ext_frag_t));
     TEST_ASSERT_NOT_NULL(ptr->next);
     ptr = ptr->next;
     TEST_ASSERT_NOT_NULL(ptr);
     TEST_ASSERT_EQUAL_INT(TEST_FRAG2_OFFSET / 8, ptr->start);
     TEST_ASSERT_EQUAL_INT(TEST_FRAG3_OFFSET / 8, ptr->end);
     TEST_ASSERT(((clist_node_t *)ptr) == rbuf->limits.next);
-    TEST_ASSERT(memcmp(_exp_payload, rbuf->pkt->data, rbuf->pkt->size) == 0);
+    _check_frag_payload(ptr, TEST_FRAG2_OFFSET,
+                        sizeof(_test_frag2) - sizeof(ipv6_ext_frag_t));
 
     /* prepare 3rd fragment */
     ipv6_snip = gnrc_ipv6_hdr_build(NULL, &_src, &_dst);
@@ -314,7 +357,8 @@ static void test_ipv6_ext_frag_reass_out_of_order(void)
     TEST_ASSERT_NULL(gnrc_ipv6_ext_frag_reass(pkt));
     TEST_ASSERT_NOT_NULL((rbuf = gnrc_ipv6_ext_frag_rbuf_get(ipv6, TEST_ID)));
     TEST_ASSERT_NOT_NULL(rbuf->pkt);
-    TEST_ASSERT_EQUAL_INT(sizeof(_exp_payload), rbuf->pkt->size);
+    TEST_ASSERT_EQUAL_INT(GNRC_NETTYPE_IPV6, rbuf->pkt->type);
+    TEST_ASSERT_EQUAL_INT(sizeof(_exp_payload), rbuf->pkt_len);
     TEST_ASSERT_EQUAL_INT(TEST_ID, rbuf->id);
     TEST_ASSERT(rbuf->last);
     ptr = (gnrc_ipv6_ext_frag_limits_t *)rbuf->limits.next;
@@ -324,9 +368,8 @@ static void test_ipv6_ext_frag_reass_out_of_order(void)
     TEST_ASSERT_EQUAL_INT(TEST_FRAG3_OFFSET / 8, ptr->start);
     TEST_ASSERT_EQUAL_INT(sizeof(_exp_payload) / 8, ptr->end);
     TEST_ASSERT(((clist_node_t *)ptr) == rbuf->limits.next);
-    TEST_ASSERT(memcmp(&_exp_payload[TEST_FRAG3_OFFSET],
-                       (uint8_t *)rbuf->pkt->data + TEST_FRAG3_OFFSET,
-                       rbuf->pkt->size - TEST_FRAG3_OFFSET) == 0);
+    _check_frag_payload(ptr, TEST_FRAG3_OFFSET,
+                        sizeof(_exp_payload) - TEST_FRAG3_OFFSET);
 
     /* prepare 2nd fragment */
     ipv6_snip = gnrc_ipv6_hdr_build(NULL, &_src, &_dst);
@@ -348,7 +391,8 @@ static void test_ipv6_ext_frag_reass_out_of_order(void)
     /* receive 2nd fragment */
     TEST_ASSERT_NULL(gnrc_ipv6_ext_frag_reass(pkt));
     TEST_ASSERT_NOT_NULL(rbuf->pkt);
-    TEST_ASSERT_EQUAL_INT(sizeof(_exp_payload), rbuf->pkt->size);
+    TEST_ASSERT_EQUAL_INT(sizeof(_exp_payload) - TEST_FRAG2_OFFSET,
+                          rbuf->held);
     TEST_ASSERT(rbuf->last);
     ptr = (gnrc_ipv6_ext_frag_limits_t *)rbuf->limits.next;
     TEST_ASSERT_NOT_NULL(ptr);
@@ -356,15 +400,16 @@ static void test_ipv6_ext_frag_reass_out_of_order(void)
     TEST_ASSERT_NOT_NULL(ptr);
     TEST_ASSERT_EQUAL_INT(TEST_FRAG2_OFFSET / 8, ptr->start);
     TEST_ASSERT_EQUAL_INT(TEST_FRAG3_OFFSET / 8, ptr->end);
+    _check_frag_payload(ptr, TEST_FRAG2_OFFSET,
+                        TEST_FRAG3_OFFSET - TEST_FRAG2_OFFSET);
     ptr = ptr->next;
     TEST_ASSERT_NOT_NULL(ptr);
     TEST_ASSERT_EQUAL_INT(TEST_FRAG3_OFFSET / 8, ptr->start);
     TEST_ASSERT_EQUAL_INT(sizeof(_exp_payload) / 8, ptr->end);
     TEST_ASSERT_NOT_NULL(ptr->next);
     TEST_ASSERT(((clist_node_t *)ptr) == rbuf->limits.next);
-    TEST_ASSERT(memcmp(&_exp_payload[TEST_FRAG2_OFFSET],
-                       (uint8_t *)rbuf->pkt->data + TEST_FRAG2_OFFSET,
-                       rbuf->pkt->size - TEST_FRAG2_OFFSET) == 0);
+    _check_frag_payload(ptr, TEST_FRAG3_OFFSET,
+                        sizeof(_exp_payload) - TEST_FRAG3_OFFSET);
 
     /* prepare 1st fragment */
     ipv6_snip = gnrc_ipv6_hdr_build(NULL, &_src, &_dst);
@@ -427,7 +472,7 @@ static void test_ipv6_ext_frag_reass_out_of_order_rbuf_full(void)
     TEST_ASSERT_NOT_NULL((rbuf = gnrc_ipv6_ext_frag_rbuf_get(ipv6,
                                                              foreign_id)));
     TEST_ASSERT_NOT_NULL(rbuf->pkt);
-    TEST_ASSERT_EQUAL_INT(sizeof(_exp_payload), rbuf->pkt->size);
+    TEST_ASSERT_EQUAL_INT(sizeof(_exp_payload), rbuf->pkt_len);
     TEST_ASSERT_EQUAL_INT(foreign_id, rbuf->id);
     TEST_ASSERT(rbuf->last);
     ptr = (gnrc_ipv6_ext_frag_limits_t *)rbuf->limits.next;
@@ -437,9 +482,8 @@ static void test_ipv6_ext_frag_reass_out_of_order_rbuf_full(void)
     TEST_ASSERT_EQUAL_INT(TEST_FRAG3_OFFSET / 8, ptr->start);
     TEST_ASSERT_EQUAL_INT(sizeof(_exp_payload) / 8, ptr->end);
     TEST_ASSERT(((clist_node_t *)ptr) == rbuf->limits.next);
-    TEST_ASSERT(memcmp(&_exp_payload[TEST_FRAG3_OFFSET],
-                       (uint8_t *)rbuf->pkt->data + TEST_FRAG3_OFFSET,
-                       rbuf->pkt->size - TEST_FRAG3_OFFSET) == 0);
+    _check_frag_payload(ptr, TEST_FRAG3_OFFSET,
+                        sizeof(_exp_payload) - TEST_FRAG3_OFFSET);
 
     /* redo test_ipv6_ext_frag_reass_one_frag but now rbuf is full and oldest
      * entry should be cycled out */
@@ -480,6 +524,59 @@ static void test_ipv6_ext_frag_reass_one_frag(void)
     gnrc_pktbuf_is_empty();
 }
 
+static void test_ipv6_ext_frag_reass_overlap(void)
+{
+    TEST_ASSERT_NULL(gnrc_ipv6_ext_frag_reass(
+            _build_frag(TEST_ID, TEST_FRAG1_OFFSET, TEST_FRAG2_OFFSET, true)
+        ));
+    /* overlaps with the end of the first fragment */
+    TEST_ASSERT_NULL(gnrc_ipv6_ext_frag_reass(
+            _build_frag(TEST_ID, TEST_FRAG2_OFFSET - 8,
+                        TEST_FRAG3_OFFSET - TEST_FRAG2_OFFSET, true)
+        ));
+    /* reassembly of the datagram was abandoned */
+    TEST_ASSERT(gnrc_pktbuf_is_sane());
+    TEST_ASSERT(gnrc_pktbuf_is_empty());
+}
+
+static void test_ipv6_ext_frag_reass_src_max(void)
+{
+    static ipv6_hdr_t ipv6 = { .src = { .u8 = TEST_SRC },
+                               .dst = { .u8 = TEST_DST } };
+    /* two fragments of this size fit the limit of a source, three do not */
+    const unsigned size = (CONFIG_GNRC_IPV6_EXT_FRAG_RBUF_SRC_MAX / 2) & ~0x7U;
+    gnrc_ipv6_ext_frag_rbuf_t *rbuf;
+    gnrc_pktsnip_t *pkt;
+
+    if (CONFIG_GNRC_IPV6_EXT_FRAG_RBUF_SRC_MAX == 0) {
+        return;
+    }
+    TEST_ASSERT_NULL(gnrc_ipv6_ext_frag_reass(
+            _build_frag(TEST_ID, 0, size, true)
+        ));
+    TEST_ASSERT_NULL(gnrc_ipv6_ext_frag_reass(
+            _build_frag(TEST_ID, size, size, true)
+        ));
+    TEST_ASSERT_NOT_NULL((rbuf = gnrc_ipv6_ext_frag_rbuf_get(&ipv6, TEST_ID)));
+    TEST_ASSERT_EQUAL_INT(2 * size, rbuf->held);
+    TEST_ASSERT_EQUAL_INT(2, clist_count(&rbuf->limits));
+    /* third fragment exceeds the limit and is dropped */
+    TEST_ASSERT_NULL(gnrc_ipv6_ext_frag_reass(
+            _build_frag(TEST_ID, 2 * size, size, false)
+        ));
+    TEST_ASSERT_EQUAL_INT(2 * size, rbuf->held);
+    TEST_ASSERT_EQUAL_INT(2, clist_count(&rbuf->limits));
+    TEST_ASSERT(!rbuf->last);
+    /* an atomic fragment does not use the reassembly buffer and is not
+     * refused */
+    TEST_ASSERT_NOT_NULL((pkt = gnrc_ipv6_ext_frag_reass(
+            _build_frag(TEST_ID + 1, 0, size, false)
+        )));
+    TEST_ASSERT_EQUAL_INT(size, pkt->size);
+    TEST_ASSERT_EQUAL_INT(2 * size, rbuf->held);
+    gnrc_pktbuf_release(pkt);
+}
+
 static void run_unittests(void)
 {
     EMB_UNIT_TESTFIXTURES(fixtures) {
@@ -491,6 +588,8 @@ static void run_unittests(void)
         new_TestFixture(test_ipv6_ext_frag_reass_out_of_order),
         new_TestFixture(test_ipv6_ext_frag_reass_out_of_order_rbuf_full),
         new_TestFixture(test_ipv6_ext_frag_reass_one_frag),
+        new_TestFixture(test_ipv6_ext_frag_reass_overlap),
+        new_TestFixture(test_ipv6_ext_frag_reass_src_max),
     };
 
     EMB_UNIT_TESTCALLER(ipv6_ext_frag_tests, NULL, tear_down_tests, fixtures);
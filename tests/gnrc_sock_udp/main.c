@@ -21,7 +21,9 @@
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <string.h>
 
+#include "kernel_defines.h"
 #include "net/sock/udp.h"
 #include "test_utils/expect.h"
 #include "xtimer.h"
@@ -447,6 +449,37 @@ static void test_sock_udp_recv_buf__success(void)
     assert(_check_net());
 }
 
+static void test_sock_udp_recv_mmsg__success(void)
+{
+    static const ipv6_addr_t src_addr = { .u8 = _TEST_ADDR_REMOTE };
+    static const ipv6_addr_t dst_addr = { .u8 = _TEST_ADDR_LOCAL };
+    static const sock_udp_ep_t local = { .family = AF_INET6,
+                                         .port = _TEST_PORT_LOCAL };
+    sock_udp_mmsg_t msgs[4];
+
+    expect(0 == sock_udp_create(&_sock, &local, NULL, SOCK_FLAGS_REUSE_EP));
+    expect(_inject_packet(&src_addr, &dst_addr, _TEST_PORT_REMOTE,
+                          _TEST_PORT_LOCAL, "ABCD", sizeof("ABCD"),
+                          _TEST_NETIF));
+    expect(_inject_packet(&src_addr, &dst_addr, _TEST_PORT_REMOTE + 1,
+                          _TEST_PORT_LOCAL, "EFG", sizeof("EFG"),
+                          _TEST_NETIF));
+    expect(2 == sock_udp_recv_mmsg(&_sock, msgs, ARRAY_SIZE(msgs),
+                                   SOCK_NO_TIMEOUT));
+    expect(sizeof("ABCD") == msgs[0].len);
+    expect(memcmp("ABCD", msgs[0].data, sizeof("ABCD")) == 0);
+    expect(_TEST_PORT_REMOTE == msgs[0].remote.port);
+    expect(memcmp(&msgs[0].remote.addr, &src_addr, sizeof(src_addr)) == 0);
+    expect(sizeof("EFG") == msgs[1].len);
+    expect(memcmp("EFG", msgs[1].data, sizeof("EFG")) == 0);
+    expect(_TEST_PORT_REMOTE + 1 == msgs[1].remote.port);
+    sock_udp_mmsg_release(&_sock, msgs, 2);
+    expect(msgs[0].buf_ctx == NULL);
+    expect(msgs[1].buf_ctx == NULL);
+    expect(-EAGAIN == sock_udp_recv_mmsg(&_sock, msgs, ARRAY_SIZE(msgs), 0));
+    expect(_check_net());
+}
+
 static void test_sock_udp_send__EAFNOSUPPORT(void)
 {
     static const sock_udp_ep_t remote = { .addr = { .ipv6 = _TEST_ADDR_REMOTE },
@@ -608,6 +641,49 @@ static void test_sock_udp_send__socketed_other_remote(void)
     expect(_check_net());
 }
 
+static void test_sock_udp_send_mmsg__socketed(void)
+{
+    static const ipv6_addr_t src_addr = { .u8 = _TEST_ADDR_LOCAL };
+    static const ipv6_addr_t dst_addr = { .u8 = _TEST_ADDR_REMOTE };
+    static const sock_udp_ep_t local = { .addr = { .ipv6 = _TEST_ADDR_LOCAL },
+                                         .family = AF_INET6,
+                                         .netif = _TEST_NETIF,
+                                         .port = _TEST_PORT_LOCAL };
+    static const sock_udp_ep_t remote = { .addr = { .ipv6 = _TEST_ADDR_REMOTE },
+                                          .family = AF_INET6,
+                                          .port = _TEST_PORT_REMOTE };
+    sock_udp_mmsg_t msgs[] = {
+        /* remote of sock */
+        { .data = "ABCD", .len = sizeof("ABCD") },
+        { .data = "EFG", .len = sizeof("EFG"), .remote = remote },
+    };
+
+    msgs[1].remote.port = _TEST_PORT_REMOTE + 1;
+    expect(0 == sock_udp_create(&_sock, &local, &remote, SOCK_FLAGS_REUSE_EP));
+    expect(2 == sock_udp_send_mmsg(&_sock, msgs, ARRAY_SIZE(msgs)));
+    expect(_check_packet(&src_addr, &dst_addr, _TEST_PORT_LOCAL,
+                         _TEST_PORT_REMOTE, "ABCD", sizeof("ABCD"),
+                         _TEST_NETIF, false));
+    expect(_check_packet(&src_addr, &dst_addr, _TEST_PORT_LOCAL,
+                         _TEST_PORT_REMOTE + 1, "EFG", sizeof("EFG"),
+                         _TEST_NETIF, false));
+    xtimer_usleep(1000);    /* let GNRC stack finish */
+    expect(_check_net());
+}
+
+static void test_sock_udp_send_mmsg__ENOTCONN(void)
+{
+    static const sock_udp_ep_t local = { .family = AF_INET6,
+                                         .port = _TEST_PORT_LOCAL };
+    const sock_udp_mmsg_t msgs[] = {
+        { .data = "ABCD", .len = sizeof("ABCD") },
+    };
+
+    expect(0 == sock_udp_create(&_sock, &local, NULL, SOCK_FLAGS_REUSE_EP));
+    expect(-ENOTCONN == sock_udp_send_mmsg(&_sock, msgs, ARRAY_SIZE(msgs)));
+    expect(_check_net());
+}
+
 static void test_sock_udp_send__unsocketed_no_local_no_netif(void)
 {
     static const ipv6_addr_t dst_addr = { .u8 = _TEST_ADDR_REMOTE };
@@ -751,6 +827,7 @@ int main(void)
     CALL(test_sock_udp_recv__with_timeout());
     CALL(test_sock_udp_recv__non_blocking());
     CALL(test_sock_udp_recv_buf__success());
+    CALL(test_sock_udp_recv_mmsg__success());
     _prepare_send_checks();
     CALL(test_sock_udp_send__EAFNOSUPPORT());
     CALL(test_sock_udp_send__EINVAL_addr());
@@ -762,6 +839,8 @@ int main(void)
     CALL(test_sock_udp_send__socketed_no_local());
     CALL(test_sock_udp_send__socketed());
     CALL(test_sock_udp_send__socketed_other_remote());
+    CALL(test_sock_udp_send_mmsg__socketed());
+    CALL(test_sock_udp_send_mmsg__ENOTCONN());
     CALL(test_sock_udp_send__unsocketed_no_local_no_netif());
     CALL(test_sock_udp_send__unsocketed_no_netif());
     CALL(test_sock_udp_send__unsocketed_no_local());
@@ -0,0 +1,396 @@
+/*
+ * Copyright (C) 2020 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     tests
+ * @{
+ *
+ * @file
+ * @brief       kvstore module test
+ *
+ * @}
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "embUnit.h"
+
+#include "kvstore.h"
+#include "mtd.h"
+#include "test_utils/mtd_ram.h"
+
+/* RAM-based mtd behaving like NOR flash */
+#define SECTOR_COUNT        8
+#define PAGE_PER_SECTOR     4
+#define PAGE_SIZE           64
+#define SECTOR_SIZE         (PAGE_PER_SECTOR * PAGE_SIZE)
+#define MEMORY_SIZE         (SECTOR_SIZE * SECTOR_COUNT)
+
+#define ENTRIES             32
+
+static uint8_t _dummy_memory[MEMORY_SIZE];
+static test_utils_mtd_ram_t _ram = TEST_UTILS_MTD_RAM_INIT(
+    &test_utils_mtd_ram_driver, _dummy_memory, SECTOR_COUNT, PAGE_PER_SECTOR,
+    PAGE_SIZE, true);
+
+static kvstore_sector_t _sectors[SECTOR_COUNT];
+static kvstore_entry_t _entries[ENTRIES];
+static kvstore_t _kvs = KVSTORE_INIT(&_ram.mtd, 0, _sectors, _entries);
+
+static uint8_t _txn_buf[128];
+
+static void _set(const char *key, uint32_t value)
+{
+    TEST_ASSERT_EQUAL_INT(0, kvstore_set(&_kvs, key, &value, sizeof(value)));
+}
+
+/* returns UINT32_MAX if the key has no value of 4 bytes */
+static uint32_t _get(const char *key)
+{
+    uint32_t value = UINT32_MAX;
+
+    if (kvstore_get(&_kvs, key, &value, sizeof(value)) != sizeof(value)) {
+        return UINT32_MAX;
+    }
+    return value;
+}
+
+static void _count_cb(const char *key, size_t len, void *arg)
+{
+    (void)key;
+    (void)len;
+    (*(unsigned *)arg)++;
+}
+
+static void setup(void)
+{
+    _ram.ops_left = -1;
+    _ram.reprogrammed = false;
+    memset(_dummy_memory, 0xff, sizeof(_dummy_memory));
+    memset(_sectors, 0, sizeof(_sectors));
+    TEST_ASSERT_EQUAL_INT(0, kvstore_init(&_kvs));
+}
+
+static void test_kvstore_set_get(void)
+{
+    char buf[16];
+
+    TEST_ASSERT_EQUAL_INT(-ENOENT, kvstore_get(&_kvs, "a", buf, sizeof(buf)));
+
+    TEST_ASSERT_EQUAL_INT(0, kvstore_set(&_kvs, "name", "riot", 4));
+    TEST_ASSERT_EQUAL_INT(4, kvstore_get(&_kvs, "name", buf, sizeof(buf)));
+    TEST_ASSERT_EQUAL_INT(0, memcmp(buf, "riot", 4));
+
+    TEST_ASSERT_EQUAL_INT(0, kvstore_set(&_kvs, "name", "native", 6));
+    TEST_ASSERT_EQUAL_INT(6, kvstore_get(&_kvs, "name", buf, sizeof(buf)));
+    TEST_ASSERT_EQUAL_INT(0, memcmp(buf, "native", 6));
+    TEST_ASSERT_EQUAL_INT(-ENOBUFS, kvstore_get(&_kvs, "name", buf, 5));
+
+    /* empty values are values as well */
+    TEST_ASSERT_EQUAL_INT(0, kvstore_set(&_kvs, "empty", NULL, 0));
+    TEST_ASSERT_EQUAL_INT(0, kvstore_get(&_kvs, "empty", buf, sizeof(buf)));
+
+    TEST_ASSERT_EQUAL_INT(-EINVAL,
+                          kvstore_set(&_kvs, "a key that is longer than allowed",
+                                      "", 0));
+}
+
+static void test_kvstore_delete(void)
+{
+    unsigned count = 0;
+
+    _set("a", 1);
+    _set("b", 2);
+    TEST_ASSERT_EQUAL_INT(0, kvstore_delete(&_kvs, "a"));
+    TEST_ASSERT_EQUAL_INT(-ENOENT, kvstore_get(&_kvs, "a", &count,
+                                               sizeof(count)));
+    TEST_ASSERT_EQUAL_INT(-ENOENT, kvstore_delete(&_kvs, "a"));
+    TEST_ASSERT_EQUAL_INT(-ENOENT, kvstore_delete(&_kvs, "c"));
+
+    TEST_ASSERT_EQUAL_INT(1, kvstore_foreach(&_kvs, _count_cb, &count));
+    TEST_ASSERT_EQUAL_INT(1, count);
+
+    /* deletions persist */
+    TEST_ASSERT_EQUAL_INT(0, kvstore_init(&_kvs));
+    TEST_ASSERT_EQUAL_INT(-ENOENT, kvstore_get(&_kvs, "a", &count,
+                                               sizeof(count)));
+    TEST_ASSERT_EQUAL_INT(2, _get("b"));
+}
+
+static void test_kvstore_rebuild(void)
+{
+    char key[8];
+
+    /* fills several sectors, the full ones get a summary */
+    for (unsigned i = 0; i < 20; i++) {
+        snprintf(key, sizeof(key), "key%u", i);
+        _set(key, i);
+    }
+    for (unsigned i = 0; i < 20; i += 2) {
+        snprintf(key, sizeof(key), "key%u", i);
+        _set(key, 100 + i);
+    }
+    TEST_ASSERT(_kvs.sectors[0].state != _kvs.sectors[_kvs.active].state);
+
+    memset(_entries, 0, sizeof(_entries));
+    TEST_ASSERT_EQUAL_INT(0, kvstore_init(&_kvs));
+    for (unsigned i = 0; i < 20; i++) {
+        snprintf(key, sizeof(key), "key%u", i);
+        TEST_ASSERT_EQUAL_INT((i % 2) ? i : 100 + i, _get(key));
+    }
+
+    /* appending continues in the same sector */
+    uint32_t active = _kvs.active;
+    _set("new", 1);
+    TEST_ASSERT_EQUAL_INT(active, _kvs.active);
+    TEST_ASSERT_EQUAL_INT(0, kvstore_init(&_kvs));
+    TEST_ASSERT_EQUAL_INT(1, _get("new"));
+}
+
+static void test_kvstore_txn(void)
+{
+    kvstore_txn_t txn;
+    uint32_t value = 1;
+
+    _set("x", 0);
+    _set("y", 0);
+    kvstore_txn_init(&txn, &_kvs, _txn_buf, sizeof(_txn_buf));
+    TEST_ASSERT_EQUAL_INT(0, kvstore_txn_set(&txn, "x", &value, sizeof(value)));
+    TEST_ASSERT_EQUAL_INT(0, kvstore_txn_set(&txn, "z", &value, sizeof(value)));
+    TEST_ASSERT_EQUAL_INT(0, kvstore_txn_delete(&txn, "y"));
+    /* nothing changes before the commit */
+    TEST_ASSERT_EQUAL_INT(0, _get("x"));
+    TEST_ASSERT_EQUAL_INT(0, kvstore_txn_commit(&txn));
+    TEST_ASSERT_EQUAL_INT(0, txn.len);
+
+    TEST_ASSERT_EQUAL_INT(1, _get("x"));
+    TEST_ASSERT_EQUAL_INT(1, _get("z"));
+    TEST_ASSERT_EQUAL_INT(-ENOENT, kvstore_get(&_kvs, "y", &value,
+                                               sizeof(value)));
+    TEST_ASSERT_EQUAL_INT(0, kvstore_init(&_kvs));
+    TEST_ASSERT_EQUAL_INT(1, _get("x"));
+    TEST_ASSERT_EQUAL_INT(1, _get("z"));
+
+    /* the buffer is too small */
+    kvstore_txn_init(&txn, &_kvs, _txn_buf, 8);
+    TEST_ASSERT_EQUAL_INT(-ENOBUFS, kvstore_txn_set(&txn, "x", &value, 4));
+}
+
+static void test_kvstore_txn_torn(void)
+{
+    kvstore_txn_t txn;
+    uint32_t value = 1;
+
+    _set("x", 0);
+    kvstore_txn_init(&txn, &_kvs, _txn_buf, sizeof(_txn_buf));
+    TEST_ASSERT_EQUAL_INT(0, kvstore_txn_set(&txn, "x", &value, sizeof(value)));
+    TEST_ASSERT_EQUAL_INT(0, kvstore_txn_set(&txn, "y", &value, sizeof(value)));
+    TEST_ASSERT_EQUAL_INT(0, kvstore_txn_commit(&txn));
+
+    /* the record committing the transaction was not written */
+    memset(&_dummy_memory[_kvs.active * SECTOR_SIZE + _kvs.pos - 12], 0xff,
+           12);
+    TEST_ASSERT_EQUAL_INT(0, kvstore_init(&_kvs));
+    TEST_ASSERT_EQUAL_INT(0, _get("x"));
+    TEST_ASSERT_EQUAL_INT(-ENOENT, kvstore_get(&_kvs, "y", &value,
+                                               sizeof(value)));
+
+    /* a record was not written completely, its value ends 4 bytes before
+     * the padding */
+    _set("x", 2);
+    memset(&_dummy_memory[_kvs.active * SECTOR_SIZE + _kvs.pos - 8], 0xff, 5);
+    TEST_ASSERT_EQUAL_INT(0, kvstore_init(&_kvs));
+    TEST_ASSERT_EQUAL_INT(0, _get("x"));
+
+    /* the next transaction is applied */
+    kvstore_txn_init(&txn, &_kvs, _txn_buf, sizeof(_txn_buf));
+    TEST_ASSERT_EQUAL_INT(0, kvstore_txn_set(&txn, "y", &value, sizeof(value)));
+    TEST_ASSERT_EQUAL_INT(0, kvstore_txn_commit(&txn));
+    TEST_ASSERT_EQUAL_INT(0, kvstore_init(&_kvs));
+    TEST_ASSERT_EQUAL_INT(1, _get("y"));
+}
+
+static void test_kvstore_compaction(void)
+{
+    char key[8];
+
+    for (unsigned i = 0; i < 10; i++) {
+        snprintf(key, sizeof(key), "fix%u", i);
+        _set(key, i);
+    }
+    /* many times the capacity of the device */
+    for (unsigned i = 0; i < 1000; i++) {
+        snprintf(key, sizeof(key), "var%u", i % 4);
+        _set(key, i);
+    }
+    TEST_ASSERT(_kvs.stats.compactions > 0);
+
+    TEST_ASSERT_EQUAL_INT(0, kvstore_init(&_kvs));
+    for (unsigned i = 0; i < 10; i++) {
+        snprintf(key, sizeof(key), "fix%u", i);
+        TEST_ASSERT_EQUAL_INT(i, _get(key));
+    }
+    for (unsigned i = 0; i < 4; i++) {
+        snprintf(key, sizeof(key), "var%u", i);
+        TEST_ASSERT_EQUAL_INT(996 + i, _get(key));
+    }
+}
+
+static void test_kvstore_wear(void)
+{
+    char key[8];
+    uint32_t min = UINT32_MAX;
+    uint32_t max = 0;
+
+    /* data that is never updated fills most sectors */
+    for (unsigned i = 0; i < 24; i++) {
+        snprintf(key, sizeof(key), "fix%u", i);
+        _set(key, i);
+    }
+    for (unsigned i = 0; i < 2000; i++) {
+        _set("var", i);
+    }
+    for (unsigned i = 0; i < SECTOR_COUNT; i++) {
+        if (_sectors[i].erase_count < min) {
+            min = _sectors[i].erase_count;
+        }
+        if (_sectors[i].erase_count > max) {
+            max = _sectors[i].erase_count;
+        }
+    }
+    TEST_ASSERT(max - min <= CONFIG_KVSTORE_WEAR_THRESHOLD + 1);
+
+    TEST_ASSERT_EQUAL_INT(0, kvstore_init(&_kvs));
+    for (unsigned i = 0; i < 24; i++) {
+        snprintf(key, sizeof(key), "fix%u", i);
+        TEST_ASSERT_EQUAL_INT(i, _get(key));
+    }
+    TEST_ASSERT_EQUAL_INT(1999, _get("var"));
+}
+
+static void test_kvstore_limits(void)
+{
+    char key[8];
+
+    /* "k32728" and "k261234" have the same hash */
+    _set("k32728", 1);
+    TEST_ASSERT_EQUAL_INT(-EEXIST, kvstore_set(&_kvs, "k261234", "", 0));
+    TEST_ASSERT_EQUAL_INT(-ENOENT, kvstore_get(&_kvs, "k261234", key,
+                                               sizeof(key)));
+    TEST_ASSERT_EQUAL_INT(1, _get("k32728"));
+
+    /* one entry of the index stays unused */
+    for (unsigned i = 1; i < ENTRIES - 1; i++) {
+        snprintf(key, sizeof(key), "key%u", i);
+        _set(key, i);
+    }
+    TEST_ASSERT_EQUAL_INT(-ENOMEM, kvstore_set(&_kvs, "more", "", 0));
+    _set("key1", 2);
+}
+
+static void test_kvstore_garbage(void)
+{
+    unsigned count = 0;
+
+    memset(_dummy_memory, 0x5a, sizeof(_dummy_memory));
+    TEST_ASSERT_EQUAL_INT(0, kvstore_init(&_kvs));
+    TEST_ASSERT_EQUAL_INT(0, kvstore_foreach(&_kvs, _count_cb, &count));
+
+    _set("a", 1);
+    TEST_ASSERT_EQUAL_INT(0, kvstore_init(&_kvs));
+    TEST_ASSERT_EQUAL_INT(1, _get("a"));
+
+    TEST_ASSERT_EQUAL_INT(0, kvstore_format(&_kvs));
+    TEST_ASSERT_EQUAL_INT(0, kvstore_foreach(&_kvs, _count_cb, &count));
+    TEST_ASSERT_EQUAL_INT(0, kvstore_init(&_kvs));
+    TEST_ASSERT_EQUAL_INT(0, kvstore_foreach(&_kvs, _count_cb, &count));
+}
+
+static void test_kvstore_power_loss(void)
+{
+    char key[8];
+
+    /* the power is lost at every write or erase of the first few
+     * compactions, the store must recover without programming flash twice */
+    for (int cut = 1; cut < 300; cut++) {
+        uint32_t values[4];
+        unsigned i;
+
+        memset(values, 0xff, sizeof(values));
+
+        setup();
+        for (i = 0; i < 10; i++) {
+            snprintf(key, sizeof(key), "fix%u", i);
+            _set(key, i);
+        }
+        _ram.ops_left = cut;
+        for (i = 0; i < 1000; i++) {
+            uint32_t value = i;
+            snprintf(key, sizeof(key), "var%u", i % 4);
+            if (kvstore_set(&_kvs, key, &value, sizeof(value)) != 0) {
+                break;
+            }
+            values[i % 4] = i;
+        }
+        TEST_ASSERT(i < 1000);
+
+        _ram.ops_left = -1;
+        TEST_ASSERT_EQUAL_INT(0, kvstore_init(&_kvs));
+        for (unsigned k = 0; k < 10; k++) {
+            snprintf(key, sizeof(key), "fix%u", k);
+            TEST_ASSERT_EQUAL_INT(k, _get(key));
+        }
+        /* the interrupted update may have made it */
+        for (unsigned k = 0; k < 4; k++) {
+            snprintf(key, sizeof(key), "var%u", k);
+            uint32_t value = _get(key);
+            TEST_ASSERT((value == values[k]) ||
+                        ((k == i % 4) && (value == i)));
+        }
+
+        /* the store is usable again */
+        for (unsigned j = 0; j < 100; j++) {
+            _set("var0", j);
+        }
+        TEST_ASSERT_EQUAL_INT(0, kvstore_init(&_kvs));
+        TEST_ASSERT_EQUAL_INT(99, _get("var0"));
+        TEST_ASSERT(!_ram.reprogrammed);
+    }
+}
+
+Test *tests_kvstore_tests(void)
+{
+    EMB_UNIT_TESTFIXTURES(fixtures) {
+        new_TestFixture(test_kvstore_set_get),
+        new_TestFixture(test_kvstore_delete),
+        new_TestFixture(test_kvstore_rebuild),
+        new_TestFixture(test_kvstore_txn),
+        new_TestFixture(test_kvstore_txn_torn),
+        new_TestFixture(test_kvstore_compaction),
+        new_TestFixture(test_kvstore_wear),
+        new_TestFixture(test_kvstore_limits),
+        new_TestFixture(test_kvstore_garbage),
+        new_TestFixture(test_kvstore_power_loss),
+    };
+
+    EMB_UNIT_TESTCALLER(kvstore_tests, setup, NULL, fixtures);
+
+    return (Test *)&kvstore_tests;
+}
+
+int main(void)
+{
+    TESTS_START();
+    TESTS_RUN(tests_kvstore_tests());
+    TESTS_END();
+    return 0;
+}
@@ -0,0 +1,245 @@
+/*
+ * Copyright (C) 2020 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     tests
+ * @{
+ *
+ * @file
+ * @brief       mtd_async module test
+ *
+ * The worker thread runs with a lower priority than main, so all requests of
+ * a test are queued before the first one is executed.
+ *
+ * @}
+ */
+
+#include <stdint.h>
+#include <errno.h>
+#include <string.h>
+
+#include "embUnit.h"
+
+#include "mtd.h"
+#include "mtd_async.h"
+#include "mutex.h"
+#include "test_utils/mtd_ram.h"
+#include "thread.h"
+
+/* RAM-based mtd that is busy for a while after starting an operation */
+#define SECTOR_COUNT        8
+#define PAGE_PER_SECTOR     4
+#define PAGE_SIZE           64
+#define SECTOR_SIZE         (PAGE_PER_SECTOR * PAGE_SIZE)
+#define MEMORY_SIZE         (SECTOR_SIZE * SECTOR_COUNT)
+
+/* number of busy polls after an operation was started */
+#define BUSY_POLLS          3
+
+#define REQ_NUMOF           8
+
+static uint8_t _dummy_memory[MEMORY_SIZE];
+static unsigned _busy_polls;
+
+static int _write_start(mtd_dev_t *dev, const void *buff, uint32_t addr,
+                        uint32_t size)
+{
+    int res = test_utils_mtd_ram_write(dev, buff, addr, size);
+
+    _busy_polls = BUSY_POLLS;
+    return res;
+}
+
+static int _erase_sector_start(mtd_dev_t *dev, uint32_t addr)
+{
+    int res = test_utils_mtd_ram_erase(dev, addr, SECTOR_SIZE);
+
+    _busy_polls = BUSY_POLLS;
+    return res;
+}
+
+static int _busy(mtd_dev_t *dev)
+{
+    (void)dev;
+
+    if (_busy_polls > 0) {
+        _busy_polls--;
+        return 1;
+    }
+    return 0;
+}
+
+static const mtd_desc_t driver = {
+    .init = test_utils_mtd_ram_init,
+    .read = test_utils_mtd_ram_read,
+    .write = test_utils_mtd_ram_write,
+    .erase = test_utils_mtd_ram_erase,
+    .write_start = _write_start,
+    .erase_sector_start = _erase_sector_start,
+    .busy = _busy,
+    .flags = MTD_DRIVER_FLAG_READ_WHILE_BUSY,
+};
+
+static test_utils_mtd_ram_t _ram = TEST_UTILS_MTD_RAM_INIT(
+    &driver, _dummy_memory, SECTOR_COUNT, PAGE_PER_SECTOR, PAGE_SIZE, false);
+
+static mtd_async_t _async;
+static uint8_t _staging[PAGE_SIZE];
+static char _stack[THREAD_STACKSIZE_DEFAULT];
+
+static mtd_async_req_t _reqs[REQ_NUMOF];
+static uint8_t _bufs[REQ_NUMOF][PAGE_SIZE];
+static int _results[REQ_NUMOF];
+static mtd_async_req_t *_order[REQ_NUMOF];
+static unsigned _completed;
+static unsigned _expected;
+static mutex_t _done = MUTEX_INIT_LOCKED;
+
+static void _cb(mtd_async_req_t *req, int res)
+{
+    _results[req - _reqs] = res;
+    _order[_completed++] = req;
+    if (_completed == _expected) {
+        mutex_unlock(&_done);
+    }
+}
+
+static void _wait_for(unsigned num)
+{
+    _expected = num;
+    mutex_lock(&_done);
+    TEST_ASSERT_EQUAL_INT(num, _completed);
+}
+
+static void setup(void)
+{
+    memset(_dummy_memory, 0xff, sizeof(_dummy_memory));
+    memset(_results, 0x7f, sizeof(_results));
+    memset(&_async.stats, 0, sizeof(_async.stats));
+    _completed = 0;
+    _ram.writes = 0;
+}
+
+static void test_mtd_async_write_read(void)
+{
+    memset(_bufs[0], 0xaa, PAGE_SIZE);
+    mtd_async_write(&_async, &_reqs[0], _bufs[0], PAGE_SIZE, PAGE_SIZE, _cb,
+                    NULL);
+    mtd_async_read(&_async, &_reqs[1], _bufs[1], PAGE_SIZE, PAGE_SIZE, _cb,
+                   NULL);
+    _wait_for(2);
+
+    TEST_ASSERT(_order[0] == &_reqs[0]);
+    TEST_ASSERT(_order[1] == &_reqs[1]);
+    TEST_ASSERT_EQUAL_INT(0, _results[0]);
+    TEST_ASSERT_EQUAL_INT(0, _results[1]);
+    TEST_ASSERT_EQUAL_INT(0, memcmp(_bufs[0], _bufs[1], PAGE_SIZE));
+    TEST_ASSERT_EQUAL_INT(2, _async.stats.submitted);
+}
+
+static void test_mtd_async_write_merge(void)
+{
+    const unsigned chunk = PAGE_SIZE / 4;
+
+    /* four writes continuing each other within one page */
+    for (unsigned i = 0; i < 4; i++) {
+        memset(_bufs[i], i, chunk);
+        mtd_async_write(&_async, &_reqs[i], _bufs[i], i * chunk, chunk, _cb,
+                        NULL);
+    }
+    /* does not continue the page */
+    memset(_bufs[4], 4, chunk);
+    mtd_async_write(&_async, &_reqs[4], _bufs[4], PAGE_SIZE, chunk, _cb, NULL);
+    _wait_for(5);
+
+    TEST_ASSERT_EQUAL_INT(2, _ram.writes);
+    TEST_ASSERT_EQUAL_INT(3, _async.stats.merged);
+    for (unsigned i = 0; i < 5; i++) {
+        TEST_ASSERT(_order[i] == &_reqs[i]);
+        TEST_ASSERT_EQUAL_INT(0, _results[i]);
+    }
+    for (unsigned i = 0; i < 4; i++) {
+        TEST_ASSERT_EQUAL_INT(i, _dummy_memory[i * chunk]);
+        TEST_ASSERT_EQUAL_INT(i, _dummy_memory[((i + 1) * chunk) - 1]);
+    }
+    TEST_ASSERT_EQUAL_INT(4, _dummy_memory[PAGE_SIZE]);
+}
+
+static void test_mtd_async_write_error(void)
+{
+    /* spans a page boundary, so it is not merged with the first write */
+    mtd_async_write(&_async, &_reqs[0], _bufs[0], 0, PAGE_SIZE / 2, _cb, NULL);
+    mtd_async_write(&_async, &_reqs[1], _bufs[1], PAGE_SIZE / 2, PAGE_SIZE,
+                    _cb, NULL);
+    _wait_for(2);
+
+    TEST_ASSERT_EQUAL_INT(0, _results[0]);
+    TEST_ASSERT_EQUAL_INT(-EOVERFLOW, _results[1]);
+    TEST_ASSERT_EQUAL_INT(0, _async.stats.merged);
+}
+
+static void test_mtd_async_erase_read(void)
+{
+    memset(_dummy_memory, 0, sizeof(_dummy_memory));
+
+    mtd_async_erase(&_async, &_reqs[0], 0, 2 * SECTOR_SIZE, _cb, NULL);
+    /* outside of the erased sectors, served while erasing */
+    mtd_async_read(&_async, &_reqs[1], _bufs[1], 3 * SECTOR_SIZE, PAGE_SIZE,
+                   _cb, NULL);
+    /* inside of the erased sectors, must see the erased data */
+    mtd_async_read(&_async, &_reqs[2], _bufs[2], SECTOR_SIZE, PAGE_SIZE,
+                   _cb, NULL);
+    _wait_for(3);
+
+    TEST_ASSERT(_order[0] == &_reqs[1]);
+    TEST_ASSERT(_order[1] == &_reqs[0]);
+    TEST_ASSERT(_order[2] == &_reqs[2]);
+    TEST_ASSERT_EQUAL_INT(1, _async.stats.reads_while_erasing);
+    for (unsigned i = 0; i < 3; i++) {
+        TEST_ASSERT_EQUAL_INT(0, _results[i]);
+    }
+    TEST_ASSERT_EQUAL_INT(0x00, _bufs[1][0]);
+    TEST_ASSERT_EQUAL_INT(0xff, _bufs[2][0]);
+    TEST_ASSERT_EQUAL_INT(0xff, _dummy_memory[(2 * SECTOR_SIZE) - 1]);
+    TEST_ASSERT_EQUAL_INT(0x00, _dummy_memory[2 * SECTOR_SIZE]);
+}
+
+static void test_mtd_async_erase_unaligned(void)
+{
+    mtd_async_erase(&_async, &_reqs[0], PAGE_SIZE, SECTOR_SIZE, _cb, NULL);
+    _wait_for(1);
+
+    TEST_ASSERT_EQUAL_INT(-EOVERFLOW, _results[0]);
+}
+
+Test *tests_mtd_async_tests(void)
+{
+    EMB_UNIT_TESTFIXTURES(fixtures) {
+        new_TestFixture(test_mtd_async_write_read),
+        new_TestFixture(test_mtd_async_write_merge),
+        new_TestFixture(test_mtd_async_write_error),
+        new_TestFixture(test_mtd_async_erase_read),
+        new_TestFixture(test_mtd_async_erase_unaligned),
+    };
+
+    EMB_UNIT_TESTCALLER(mtd_async_tests, setup, NULL, fixtures);
+
+    return (Test *)&mtd_async_tests;
+}
+
+int main(void)
+{
+    mtd_init(&_ram.mtd);
+    mtd_async_init(&_async, &_ram.mtd, _staging, sizeof(_staging), _stack,
+                   sizeof(_stack), THREAD_PRIORITY_MAIN + 1, "mtd_async");
+
+    TESTS_START();
+    TESTS_RUN(tests_mtd_async_tests());
+    TESTS_END();
+    return 0;
+}
@@ -0,0 +1,218 @@
+/*
+ * Copyright (C) 2020 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     tests
+ * @{
+ *
+ * @file
+ * @brief       mtd_cache module test
+ *
+ * @}
+ */
+
+#include <stdint.h>
+#include <errno.h>
+#include <string.h>
+
+#include "embUnit.h"
+
+#include "mtd.h"
+#include "mtd_cache.h"
+#include "test_utils/mtd_ram.h"
+
+/* RAM-based mtd with a log of the first writes */
+#define SECTOR_COUNT        8
+#define PAGE_PER_SECTOR     4
+#define PAGE_SIZE           64
+#define SECTOR_SIZE         (PAGE_PER_SECTOR * PAGE_SIZE)
+#define MEMORY_SIZE         (SECTOR_SIZE * SECTOR_COUNT)
+
+#define CACHE_PAGES         2
+
+static uint8_t _dummy_memory[MEMORY_SIZE];
+static uint32_t _write_addrs[4];
+static uint32_t _write_sizes[4];
+
+static int _write(mtd_dev_t *dev, const void *buff, uint32_t addr,
+                  uint32_t size)
+{
+    unsigned writes = ((test_utils_mtd_ram_t *)dev)->writes;
+
+    if (writes < ARRAY_SIZE(_write_addrs)) {
+        _write_addrs[writes] = addr;
+        _write_sizes[writes] = size;
+    }
+    return test_utils_mtd_ram_write(dev, buff, addr, size);
+}
+
+static const mtd_desc_t driver = {
+    .init = test_utils_mtd_ram_init,
+    .read = test_utils_mtd_ram_read,
+    .write = _write,
+    .erase = test_utils_mtd_ram_erase,
+};
+
+static test_utils_mtd_ram_t _ram = TEST_UTILS_MTD_RAM_INIT(
+    &driver, _dummy_memory, SECTOR_COUNT, PAGE_PER_SECTOR, PAGE_SIZE, false);
+
+static mtd_cache_entry_t _entries[CACHE_PAGES];
+static uint8_t _cache_buf[CACHE_PAGES * PAGE_SIZE];
+static mtd_cache_t _cache = MTD_CACHE_INIT(&_ram.mtd, _entries, _cache_buf);
+static mtd_dev_t *_dev = &_cache.mtd;
+
+static uint8_t _buffer[2 * PAGE_SIZE];
+
+static void setup(void)
+{
+    mtd_erase(_dev, 0, MEMORY_SIZE);
+    memset(&_cache.stats, 0, sizeof(_cache.stats));
+    _ram.reads = 0;
+    _ram.writes = 0;
+}
+
+static void test_mtd_cache_init(void)
+{
+    TEST_ASSERT_EQUAL_INT(0, mtd_init(_dev));
+    TEST_ASSERT_EQUAL_INT(SECTOR_COUNT, _dev->sector_count);
+    TEST_ASSERT_EQUAL_INT(PAGE_PER_SECTOR, _dev->pages_per_sector);
+    TEST_ASSERT_EQUAL_INT(PAGE_SIZE, _dev->page_size);
+}
+
+static void test_mtd_cache_read_hit(void)
+{
+    memset(_dummy_memory + PAGE_SIZE, 0xaa, PAGE_SIZE);
+
+    TEST_ASSERT_EQUAL_INT(0, mtd_read(_dev, _buffer, PAGE_SIZE, 16));
+    TEST_ASSERT_EQUAL_INT(0, mtd_read(_dev, _buffer + 16, PAGE_SIZE + 16, 16));
+    TEST_ASSERT_EQUAL_INT(1, _ram.reads);
+    TEST_ASSERT_EQUAL_INT(1, _cache.stats.misses);
+    TEST_ASSERT_EQUAL_INT(1, _cache.stats.hits);
+    TEST_ASSERT_EQUAL_INT(0xaa, _buffer[0]);
+    TEST_ASSERT_EQUAL_INT(0xaa, _buffer[31]);
+
+    /* spans two pages */
+    TEST_ASSERT_EQUAL_INT(0, mtd_read(_dev, _buffer, PAGE_SIZE / 2, PAGE_SIZE));
+    TEST_ASSERT_EQUAL_INT(2, _ram.reads);
+    TEST_ASSERT_EQUAL_INT(0xff, _buffer[0]);
+    TEST_ASSERT_EQUAL_INT(0xaa, _buffer[PAGE_SIZE - 1]);
+}
+
+static void test_mtd_cache_write_coalesce(void)
+{
+    memset(_buffer, 0x55, sizeof(_buffer));
+
+    for (unsigned i = 0; i < 4; i++) {
+        TEST_ASSERT_EQUAL_INT(0, mtd_write(_dev, _buffer, i * 16, 16));
+    }
+    /* nothing is written before the flush */
+    TEST_ASSERT_EQUAL_INT(0, _ram.writes);
+    TEST_ASSERT_EQUAL_INT(0xff, _dummy_memory[0]);
+
+    TEST_ASSERT_EQUAL_INT(0, mtd_flush(_dev));
+    TEST_ASSERT_EQUAL_INT(1, _ram.writes);
+    TEST_ASSERT_EQUAL_INT(0, _write_addrs[0]);
+    TEST_ASSERT_EQUAL_INT(PAGE_SIZE, _write_sizes[0]);
+    TEST_ASSERT_EQUAL_INT(0x55, _dummy_memory[PAGE_SIZE - 1]);
+    TEST_ASSERT_EQUAL_INT(1, _cache.stats.writebacks);
+
+    /* clean pages are not written again */
+    TEST_ASSERT_EQUAL_INT(0, mtd_flush(_dev));
+    TEST_ASSERT_EQUAL_INT(1, _ram.writes);
+}
+
+static void test_mtd_cache_write_partial(void)
+{
+    memset(_buffer, 0x55, sizeof(_buffer));
+
+    TEST_ASSERT_EQUAL_INT(0, mtd_write(_dev, _buffer, PAGE_SIZE + 8, 8));
+    TEST_ASSERT_EQUAL_INT(0, mtd_write(_dev, _buffer, PAGE_SIZE + 24, 8));
+    TEST_ASSERT_EQUAL_INT(0, mtd_flush(_dev));
+    TEST_ASSERT_EQUAL_INT(1, _ram.writes);
+    TEST_ASSERT_EQUAL_INT(PAGE_SIZE + 8, _write_addrs[0]);
+    TEST_ASSERT_EQUAL_INT(24, _write_sizes[0]);
+    TEST_ASSERT_EQUAL_INT(0xff, _dummy_memory[PAGE_SIZE + 16]);
+    TEST_ASSERT_EQUAL_INT(0x55, _dummy_memory[PAGE_SIZE + 31]);
+}
+
+static void test_mtd_cache_lru(void)
+{
+    memset(_buffer, 0x55, sizeof(_buffer));
+
+    /* page 0 dirty, page 1 clean */
+    TEST_ASSERT_EQUAL_INT(0, mtd_write(_dev, _buffer, 0, PAGE_SIZE));
+    TEST_ASSERT_EQUAL_INT(0, mtd_read(_dev, _buffer, PAGE_SIZE, 1));
+    /* page 1 is least recently used now */
+    TEST_ASSERT_EQUAL_INT(0, mtd_read(_dev, _buffer, 0, 1));
+    TEST_ASSERT_EQUAL_INT(0, mtd_read(_dev, _buffer, 2 * PAGE_SIZE, 1));
+    TEST_ASSERT_EQUAL_INT(1, _cache.stats.evictions);
+    TEST_ASSERT_EQUAL_INT(0, _ram.writes);
+
+    /* page 0 is evicted and written back */
+    TEST_ASSERT_EQUAL_INT(0, mtd_read(_dev, _buffer, 3 * PAGE_SIZE, 1));
+    TEST_ASSERT_EQUAL_INT(2, _cache.stats.evictions);
+    TEST_ASSERT_EQUAL_INT(1, _ram.writes);
+    TEST_ASSERT_EQUAL_INT(0x55, _dummy_memory[0]);
+
+    /* page 1 was evicted */
+    _ram.reads = 0;
+    TEST_ASSERT_EQUAL_INT(0, mtd_read(_dev, _buffer, PAGE_SIZE, 1));
+    TEST_ASSERT_EQUAL_INT(1, _ram.reads);
+}
+
+static void test_mtd_cache_flush_order(void)
+{
+    memset(_buffer, 0x55, sizeof(_buffer));
+
+    TEST_ASSERT_EQUAL_INT(0, mtd_write(_dev, _buffer, 3 * PAGE_SIZE, 8));
+    TEST_ASSERT_EQUAL_INT(0, mtd_write(_dev, _buffer, PAGE_SIZE, 8));
+    TEST_ASSERT_EQUAL_INT(0, mtd_flush(_dev));
+    TEST_ASSERT_EQUAL_INT(2, _ram.writes);
+    TEST_ASSERT_EQUAL_INT(PAGE_SIZE, _write_addrs[0]);
+    TEST_ASSERT_EQUAL_INT(3 * PAGE_SIZE, _write_addrs[1]);
+}
+
+static void test_mtd_cache_erase(void)
+{
+    memset(_buffer, 0x55, sizeof(_buffer));
+
+    TEST_ASSERT_EQUAL_INT(0, mtd_write(_dev, _buffer, 0, PAGE_SIZE));
+    TEST_ASSERT_EQUAL_INT(0, mtd_erase(_dev, 0, SECTOR_SIZE));
+    /* the pending write was dropped */
+    TEST_ASSERT_EQUAL_INT(0, mtd_flush(_dev));
+    TEST_ASSERT_EQUAL_INT(0, _ram.writes);
+    TEST_ASSERT_EQUAL_INT(0, mtd_read(_dev, _buffer, 0, PAGE_SIZE));
+    TEST_ASSERT_EQUAL_INT(0xff, _buffer[0]);
+}
+
+Test *tests_mtd_cache_tests(void)
+{
+    EMB_UNIT_TESTFIXTURES(fixtures) {
+        new_TestFixture(test_mtd_cache_init),
+        new_TestFixture(test_mtd_cache_read_hit),
+        new_TestFixture(test_mtd_cache_write_coalesce),
+        new_TestFixture(test_mtd_cache_write_partial),
+        new_TestFixture(test_mtd_cache_lru),
+        new_TestFixture(test_mtd_cache_flush_order),
+        new_TestFixture(test_mtd_cache_erase),
+    };
+
+    EMB_UNIT_TESTCALLER(mtd_cache_tests, setup, NULL, fixtures);
+
+    return (Test *)&mtd_cache_tests;
+}
+
+int main(void)
+{
+    mtd_init(_dev);
+
+    TESTS_START();
+    TESTS_RUN(tests_mtd_cache_tests());
+    TESTS_END();
+    return 0;
+}
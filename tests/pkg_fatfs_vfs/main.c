@@ -43,10 +43,12 @@
 #define FNAME2 "NEWFILE.TXT"
 #define FNAME_RNMD  "RENAMED.TXT"
 #define FNAME_NXIST "NOFILE.TXT"
+#define FNAME_RWV "VECTOR.TXT"
 #define FULL_FNAME1 (MNT_PATH "/" FNAME1)
 #define FULL_FNAME2 (MNT_PATH "/" FNAME2)
 #define FULL_FNAME_RNMD  (MNT_PATH "/" FNAME_RNMD)
 #define FULL_FNAME_NXIST (MNT_PATH "/" FNAME_NXIST)
+#define FULL_FNAME_RWV (MNT_PATH "/" FNAME_RWV)
 #define DIR_NAME "SOMEDIR"
 
 static const char test_txt[]  = "the test file content 123 abc";
@@ -191,6 +193,42 @@ static void test_rw(void)
     print_test_result("test_rw__umount", vfs_umount(&_test_vfs_mount) == 0);
 }
 
+static void test_rwv(void)
+{
+    char hdr[4];
+    char buf[sizeof(test_txt)];
+    int fd;
+    ssize_t n;
+
+    print_test_result("test_rwv__mount", vfs_mount(&_test_vfs_mount) == 0);
+
+    fd = vfs_open(FULL_FNAME_RWV, O_WRONLY | O_CREAT, 0);
+    print_test_result("test_rwv__open_wo", fd >= 0);
+
+    struct iovec iov[] = {
+        { .iov_base = (void *)test_txt, .iov_len = sizeof(hdr) },
+        { .iov_base = (void *)&test_txt[sizeof(hdr)],
+          .iov_len = sizeof(test_txt) - sizeof(hdr) },
+    };
+    n = vfs_writev(fd, iov, ARRAY_SIZE(iov));
+    print_test_result("test_rwv__writev", n == sizeof(test_txt));
+    print_test_result("test_rwv__close_wo", vfs_close(fd) == 0);
+
+    fd = vfs_open(FULL_FNAME_RWV, O_RDONLY, 0);
+    print_test_result("test_rwv__open_ro", fd >= 0);
+
+    iov[0] = (struct iovec){ .iov_base = hdr, .iov_len = sizeof(hdr) };
+    iov[1] = (struct iovec){ .iov_base = buf, .iov_len = sizeof(buf) };
+    n = vfs_readv(fd, iov, ARRAY_SIZE(iov));
+    print_test_result("test_rwv__readv", (n == sizeof(test_txt)) &&
+                      (memcmp(hdr, test_txt, sizeof(hdr)) == 0) &&
+                      (memcmp(buf, &test_txt[sizeof(hdr)],
+                              sizeof(test_txt) - sizeof(hdr)) == 0));
+    print_test_result("test_rwv__close_ro", vfs_close(fd) == 0);
+    print_test_result("test_rwv__unlink", vfs_unlink(FULL_FNAME_RWV) == 0);
+    print_test_result("test_rwv__umount", vfs_umount(&_test_vfs_mount) == 0);
+}
+
 static void test_dir(void)
 {
     vfs_DIR dir;
@@ -415,6 +453,7 @@ int main(void)
     test_mount();
     test_open();
     test_rw();
+    test_rwv();
     test_dir();
     test_rename();
     test_unlink();
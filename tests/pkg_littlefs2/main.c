@@ -219,6 +219,40 @@ static void tests_littlefs_write(void)
     TEST_ASSERT_EQUAL_INT(0, res);
 }
 
+static void tests_littlefs_readv_writev(void)
+{
+    const char hdr[] = "HDR:";
+    const char payload[] = "PAYLOAD";
+    char r_hdr[sizeof(hdr)];
+    char r_payload[2 * sizeof(payload)];
+
+    int res;
+    int fd = vfs_open("/test-littlefs/test.txt", O_CREAT | O_RDWR, 0);
+    TEST_ASSERT(fd >= 0);
+
+    struct iovec iov[] = {
+        { .iov_base = (void *)hdr, .iov_len = sizeof(hdr) },
+        { .iov_base = (void *)payload, .iov_len = sizeof(payload) },
+    };
+    res = vfs_writev(fd, iov, 2);
+    TEST_ASSERT_EQUAL_INT(sizeof(hdr) + sizeof(payload), res);
+
+    res = vfs_lseek(fd, 0, SEEK_SET);
+    TEST_ASSERT_EQUAL_INT(0, res);
+
+    /* reading stops at the end of the file */
+    iov[0] = (struct iovec){ .iov_base = r_hdr, .iov_len = sizeof(r_hdr) };
+    iov[1] = (struct iovec){ .iov_base = r_payload,
+                             .iov_len = sizeof(r_payload) };
+    res = vfs_readv(fd, iov, 2);
+    TEST_ASSERT_EQUAL_INT(sizeof(hdr) + sizeof(payload), res);
+    TEST_ASSERT_EQUAL_STRING(&hdr[0], &r_hdr[0]);
+    TEST_ASSERT_EQUAL_STRING(&payload[0], &r_payload[0]);
+
+    res = vfs_close(fd);
+    TEST_ASSERT_EQUAL_INT(0, res);
+}
+
 static void tests_littlefs_unlink(void)
 {
     const char buf[] = "TESTSTRING";
@@ -415,6 +449,7 @@ Test *tests_littlefs(void)
         new_TestFixture(tests_littlefs_mount_umount),
         new_TestFixture(tests_littlefs_open_close),
         new_TestFixture(tests_littlefs_write),
+        new_TestFixture(tests_littlefs_readv_writev),
         new_TestFixture(tests_littlefs_unlink),
         new_TestFixture(tests_littlefs_readdir),
         new_TestFixture(tests_littlefs_rename),
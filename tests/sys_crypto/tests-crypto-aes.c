@@ -86,6 +86,52 @@ static void test_crypto_aes_decrypt(void)
                                      AES_BLOCK_SIZE), "wrong plaintext");
 }
 
+static void test_crypto_aes_ct_encrypt(void)
+{
+    cipher_context_t ctx;
+    int err;
+    uint8_t data[AES_BLOCK_SIZE];
+
+    err = aes_ct_init(&ctx, TEST_0_KEY, sizeof(TEST_0_KEY));
+    TEST_ASSERT_EQUAL_INT(1, err);
+
+    err = aes_ct_encrypt(&ctx, TEST_0_INP, data);
+    TEST_ASSERT_EQUAL_INT(1, err);
+    TEST_ASSERT_MESSAGE(1 == compare(TEST_0_ENC, data,
+                                     AES_BLOCK_SIZE), "wrong ciphertext");
+
+    err = aes_ct_init(&ctx, TEST_1_KEY, sizeof(TEST_1_KEY));
+    TEST_ASSERT_EQUAL_INT(1, err);
+
+    err = aes_ct_encrypt(&ctx, TEST_1_INP, data);
+    TEST_ASSERT_EQUAL_INT(1, err);
+    TEST_ASSERT_MESSAGE(1 == compare(TEST_1_ENC, data,
+                                     AES_BLOCK_SIZE), "wrong ciphertext");
+}
+
+static void test_crypto_aes_ct_decrypt(void)
+{
+    cipher_context_t ctx;
+    int err;
+    uint8_t data[AES_BLOCK_SIZE];
+
+    err = aes_ct_init(&ctx, TEST_0_KEY, sizeof(TEST_0_KEY));
+    TEST_ASSERT_EQUAL_INT(1, err);
+
+    err = aes_ct_decrypt(&ctx, TEST_0_ENC, data);
+    TEST_ASSERT_EQUAL_INT(1, err);
+    TEST_ASSERT_MESSAGE(1 == compare(TEST_0_INP, data,
+                                     AES_BLOCK_SIZE), "wrong plaintext");
+
+    err = aes_ct_init(&ctx, TEST_1_KEY, sizeof(TEST_1_KEY));
+    TEST_ASSERT_EQUAL_INT(1, err);
+
+    err = aes_ct_decrypt(&ctx, TEST_1_ENC, data);
+    TEST_ASSERT_EQUAL_INT(1, err);
+    TEST_ASSERT_MESSAGE(1 == compare(TEST_1_INP, data,
+                                     AES_BLOCK_SIZE), "wrong plaintext");
+}
+
 static void test_crypto_aes_init_key_length(void)
 {
     cipher_context_t ctx;
@@ -112,6 +158,9 @@ static void test_crypto_aes_init_key_length(void)
 
     err = aes_init(&ctx, unsupported_key_3, sizeof(unsupported_key_3));
     TEST_ASSERT_EQUAL_INT(CIPHER_ERR_INVALID_KEY_SIZE, err);
+
+    err = aes_ct_init(&ctx, unsupported_key_2, sizeof(unsupported_key_2));
+    TEST_ASSERT_EQUAL_INT(CIPHER_ERR_INVALID_KEY_SIZE, err);
 }
 
 Test *tests_crypto_aes_tests(void)
@@ -119,6 +168,8 @@ Test *tests_crypto_aes_tests(void)
     EMB_UNIT_TESTFIXTURES(fixtures) {
         new_TestFixture(test_crypto_aes_encrypt),
         new_TestFixture(test_crypto_aes_decrypt),
+        new_TestFixture(test_crypto_aes_ct_encrypt),
+        new_TestFixture(test_crypto_aes_ct_decrypt),
         new_TestFixture(test_crypto_aes_init_key_length),
     };
 
@@ -76,10 +76,95 @@ static void test_crypto_chacha20poly1305_1(void)
     _test_chacha20poly1305(key_1, nonce_1, msg_1, sizeof(msg_1), aad_1, sizeof(aad_1));
 }
 
+static void test_crypto_chacha20poly1305_inplace(void)
+{
+    size_t len;
+
+    memcpy(ebuf, msg_1, sizeof(msg_1));
+    chacha20poly1305_encrypt(ebuf, ebuf, sizeof(msg_1), aad_1, sizeof(aad_1),
+                             key_1, nonce_1);
+    TEST_ASSERT_EQUAL_INT(0, memcmp(ebuf, ciphertext_1, sizeof(ciphertext_1)));
+    TEST_ASSERT_EQUAL_INT(1, chacha20poly1305_decrypt(ebuf, sizeof(ciphertext_1),
+                                                      ebuf, &len, aad_1,
+                                                      sizeof(aad_1), key_1,
+                                                      nonce_1));
+    TEST_ASSERT_EQUAL_INT(sizeof(msg_1), len);
+    TEST_ASSERT_EQUAL_INT(0, memcmp(ebuf, msg_1, sizeof(msg_1)));
+}
+
+static void test_crypto_chacha20poly1305_iolist(void)
+{
+    uint8_t tag[CHACHA20POLY1305_TAG_BYTES];
+
+    memcpy(pbuf, msg_1, sizeof(msg_1));
+    /* pieces not aligned to the key stream blocks */
+    iolist_t iol[3] = {
+        { .iol_next = &iol[1], .iol_base = pbuf, .iol_len = 5 },
+        { .iol_next = &iol[2], .iol_base = pbuf + 5, .iol_len = 70 },
+        { .iol_next = NULL, .iol_base = pbuf + 75,
+          .iol_len = sizeof(msg_1) - 75 },
+    };
+
+    chacha20poly1305_encrypt_iol(iol, tag, aad_1, sizeof(aad_1), key_1,
+                                 nonce_1);
+    TEST_ASSERT_EQUAL_INT(0, memcmp(pbuf, ciphertext_1, sizeof(msg_1)));
+    TEST_ASSERT_EQUAL_INT(0, memcmp(tag, ciphertext_1 + sizeof(msg_1),
+                                    sizeof(tag)));
+
+    /* a wrong tag must leave the ciphertext untouched */
+    tag[0] ^= 1;
+    TEST_ASSERT_EQUAL_INT(0, chacha20poly1305_decrypt_iol(iol, tag, aad_1,
+                                                          sizeof(aad_1), key_1,
+                                                          nonce_1));
+    TEST_ASSERT_EQUAL_INT(0, memcmp(pbuf, ciphertext_1, sizeof(msg_1)));
+
+    tag[0] ^= 1;
+    TEST_ASSERT_EQUAL_INT(1, chacha20poly1305_decrypt_iol(iol, tag, aad_1,
+                                                          sizeof(aad_1), key_1,
+                                                          nonce_1));
+    TEST_ASSERT_EQUAL_INT(0, memcmp(pbuf, msg_1, sizeof(msg_1)));
+}
+
+static void test_crypto_chacha20poly1305_long(void)
+{
+    /* longer than the key stream generated at once, compare the contiguous
+     * and the iolist path */
+    const size_t msglen = sizeof(pbuf) - CHACHA20POLY1305_TAG_BYTES - 3;
+    uint8_t tag[CHACHA20POLY1305_TAG_BYTES];
+    size_t len;
+
+    for (size_t i = 0; i < msglen; i++) {
+        pbuf[i] = i;
+    }
+    chacha20poly1305_encrypt(ebuf, pbuf, msglen, aad_1, sizeof(aad_1),
+                             key_1, nonce_1);
+
+    iolist_t iol[3] = {
+        { .iol_next = &iol[1], .iol_base = pbuf, .iol_len = 63 },
+        { .iol_next = &iol[2], .iol_base = pbuf + 63, .iol_len = 300 },
+        { .iol_next = NULL, .iol_base = pbuf + 363, .iol_len = msglen - 363 },
+    };
+    chacha20poly1305_encrypt_iol(iol, tag, aad_1, sizeof(aad_1), key_1,
+                                 nonce_1);
+    TEST_ASSERT_EQUAL_INT(0, memcmp(pbuf, ebuf, msglen));
+    TEST_ASSERT_EQUAL_INT(0, memcmp(tag, ebuf + msglen, sizeof(tag)));
+
+    TEST_ASSERT_EQUAL_INT(1, chacha20poly1305_decrypt(ebuf,
+                                msglen + CHACHA20POLY1305_TAG_BYTES, pbuf,
+                                &len, aad_1, sizeof(aad_1), key_1, nonce_1));
+    TEST_ASSERT_EQUAL_INT(msglen, len);
+    for (size_t i = 0; i < msglen; i++) {
+        TEST_ASSERT_EQUAL_INT((uint8_t)i, pbuf[i]);
+    }
+}
+
 Test *tests_crypto_chacha20poly1305_tests(void)
 {
     EMB_UNIT_TESTFIXTURES(fixtures) {
         new_TestFixture(test_crypto_chacha20poly1305_1),
+        new_TestFixture(test_crypto_chacha20poly1305_inplace),
+        new_TestFixture(test_crypto_chacha20poly1305_iolist),
+        new_TestFixture(test_crypto_chacha20poly1305_long),
     };
     EMB_UNIT_TESTCALLER(crypto_chacha20poly1305_tests, NULL, NULL, fixtures);
     return (Test *) &crypto_chacha20poly1305_tests;
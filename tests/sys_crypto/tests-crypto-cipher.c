@@ -60,6 +60,64 @@ static void test_crypto_cipher_aes_decrypt(void)
     TEST_ASSERT_MESSAGE(1 == cmp, "wrong plaintext");
 }
 
+static void _test_blocks(cipher_id_t id)
+{
+    cipher_t cipher;
+    int err;
+    uint8_t input[3 * 16], output[3 * 16], data[3 * 16];
+
+    /* three blocks, so that the constant-time cipher also runs a single
+     * block after a pair */
+    for (unsigned i = 0; i < sizeof(input); i++) {
+        input[i] = i * 7;
+    }
+
+    err = cipher_init(&cipher, id, TEST_KEY, 16);
+    TEST_ASSERT_EQUAL_INT(1, err);
+
+    err = cipher_encrypt_blocks(&cipher, input, output, 3);
+    TEST_ASSERT_EQUAL_INT(1, err);
+    for (unsigned i = 0; i < 3; i++) {
+        err = cipher_encrypt(&cipher, input + 16 * i, data);
+        TEST_ASSERT_EQUAL_INT(1, err);
+        TEST_ASSERT_MESSAGE(1 == compare(data, output + 16 * i, 16),
+                            "wrong ciphertext");
+    }
+
+    /* decrypt in place */
+    err = cipher_decrypt_blocks(&cipher, output, output, 3);
+    TEST_ASSERT_EQUAL_INT(1, err);
+    TEST_ASSERT_MESSAGE(1 == compare(input, output, sizeof(input)),
+                        "wrong plaintext");
+}
+
+static void test_crypto_cipher_aes_blocks(void)
+{
+    _test_blocks(CIPHER_AES_128);
+}
+
+static void test_crypto_cipher_aes_ct(void)
+{
+    cipher_t cipher;
+    int err, cmp;
+    uint8_t data[16] = { 0 };
+
+    err = cipher_init(&cipher, CIPHER_AES_128_CT, TEST_KEY, 16);
+    TEST_ASSERT_EQUAL_INT(1, err);
+
+    err = cipher_encrypt(&cipher, TEST_INP, data);
+    TEST_ASSERT_EQUAL_INT(1, err);
+    cmp = compare(TEST_ENC_AES, data, 16);
+    TEST_ASSERT_MESSAGE(1 == cmp, "wrong ciphertext");
+
+    err = cipher_decrypt(&cipher, TEST_ENC_AES, data);
+    TEST_ASSERT_EQUAL_INT(1, err);
+    cmp = compare(TEST_INP, data, 16);
+    TEST_ASSERT_MESSAGE(1 == cmp, "wrong plaintext");
+
+    _test_blocks(CIPHER_AES_128_CT);
+}
+
 static void test_crypto_cipher_init_aes_key_length(void)
 {
     cipher_t cipher;
@@ -99,6 +157,8 @@ Test *tests_crypto_cipher_tests(void)
     EMB_UNIT_TESTFIXTURES(fixtures) {
         new_TestFixture(test_crypto_cipher_aes_encrypt),
         new_TestFixture(test_crypto_cipher_aes_decrypt),
+        new_TestFixture(test_crypto_cipher_aes_blocks),
+        new_TestFixture(test_crypto_cipher_aes_ct),
         new_TestFixture(test_crypto_cipher_init_aes_key_length),
     };
 
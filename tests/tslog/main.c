@@ -0,0 +1,296 @@
+/*
+ * Copyright (C) 2020 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     tests
+ * @{
+ *
+ * @file
+ * @brief       tslog module test
+ *
+ * @}
+ */
+
+#include <stdint.h>
+#include <errno.h>
+#include <string.h>
+
+#include "embUnit.h"
+
+#include "mtd.h"
+#include "test_utils/mtd_ram.h"
+#include "tslog.h"
+
+/* RAM-based mtd behaving like NOR flash */
+#define SECTOR_COUNT        8
+#define PAGE_PER_SECTOR     4
+#define PAGE_SIZE           64
+#define SECTOR_SIZE         (PAGE_PER_SECTOR * PAGE_SIZE)
+#define MEMORY_SIZE         (SECTOR_SIZE * SECTOR_COUNT)
+
+/* records of a batch of 64 bytes with 4 byte data */
+#define PER_BATCH           ((64 - TSLOG_BATCH_HDR_SIZE) / 8)
+#define PER_SECTOR          (PER_BATCH * SECTOR_SIZE / 64)
+
+static uint8_t _dummy_memory[MEMORY_SIZE];
+static test_utils_mtd_ram_t _ram = TEST_UTILS_MTD_RAM_INIT(
+    &test_utils_mtd_ram_driver, _dummy_memory, SECTOR_COUNT, PAGE_PER_SECTOR,
+    PAGE_SIZE, true);
+
+static uint32_t _index[SECTOR_COUNT];
+static tslog_t _log = {
+    .mtd = &_ram.mtd,
+    .first_sector = 0,
+    .sector_count = SECTOR_COUNT,
+    .record_size = sizeof(uint32_t),
+    .index = _index,
+};
+
+typedef struct {
+    unsigned count;
+    uint32_t first;
+    uint32_t last;
+    int ordered;
+    int valid;
+} _result_t;
+
+static int _cb(uint32_t timestamp, const void *data, void *arg)
+{
+    _result_t *res = arg;
+    uint32_t value;
+
+    memcpy(&value, data, sizeof(value));
+    if (res->count == 0) {
+        res->first = timestamp;
+    }
+    else if (timestamp < res->last) {
+        res->ordered = 0;
+    }
+    /* the data of the records is derived from the time stamp */
+    if (value != ~timestamp) {
+        res->valid = 0;
+    }
+    res->last = timestamp;
+    res->count++;
+    return 0;
+}
+
+static int _query(uint32_t start, uint32_t end, _result_t *res)
+{
+    memset(res, 0, sizeof(*res));
+    res->ordered = 1;
+    res->valid = 1;
+    return tslog_query(&_log, start, end, _cb, res);
+}
+
+static void _append(uint32_t first, unsigned count)
+{
+    for (uint32_t ts = first; ts < first + count; ts++) {
+        uint32_t value = ~ts;
+        TEST_ASSERT_EQUAL_INT(0, tslog_append(&_log, ts, &value));
+    }
+}
+
+static void setup(void)
+{
+    memset(_dummy_memory, 0xff, sizeof(_dummy_memory));
+    TEST_ASSERT_EQUAL_INT(0, tslog_init(&_log));
+    _ram.writes = 0;
+    _ram.erases = 0;
+}
+
+static void test_tslog_empty(void)
+{
+    _result_t res;
+
+    TEST_ASSERT_EQUAL_INT(0, _query(0, UINT32_MAX, &res));
+    TEST_ASSERT_EQUAL_INT(0, tslog_flush(&_log));
+    TEST_ASSERT_EQUAL_INT(0, _ram.writes);
+}
+
+static void test_tslog_batching(void)
+{
+    _result_t res;
+
+    _append(100, PER_BATCH - 1);
+    TEST_ASSERT_EQUAL_INT(0, _ram.writes);
+    /* records not yet written are found as well */
+    TEST_ASSERT_EQUAL_INT(PER_BATCH - 1, _query(0, UINT32_MAX, &res));
+
+    /* the full batch is written at once */
+    _append(100 + PER_BATCH - 1, 1);
+    TEST_ASSERT_EQUAL_INT(1, _ram.writes);
+    TEST_ASSERT_EQUAL_INT(1, _ram.erases);
+    TEST_ASSERT_EQUAL_INT(1, _log.stats.batches);
+
+    _append(100 + PER_BATCH, 2);
+    TEST_ASSERT_EQUAL_INT(0, tslog_flush(&_log));
+    TEST_ASSERT_EQUAL_INT(2, _ram.writes);
+    TEST_ASSERT_EQUAL_INT(PER_BATCH + 2, _query(0, UINT32_MAX, &res));
+    TEST_ASSERT(res.ordered && res.valid);
+
+    /* time stamps must not decrease */
+    uint32_t value = 0;
+    TEST_ASSERT_EQUAL_INT(-EINVAL, tslog_append(&_log, 99, &value));
+}
+
+static void test_tslog_query_range(void)
+{
+    _result_t res;
+
+    _append(1000, 3 * PER_SECTOR + 5);
+
+    TEST_ASSERT_EQUAL_INT(11, _query(1010, 1020, &res));
+    TEST_ASSERT_EQUAL_INT(1010, res.first);
+    TEST_ASSERT_EQUAL_INT(1020, res.last);
+
+    /* spans sectors and the pending batch */
+    TEST_ASSERT_EQUAL_INT(PER_SECTOR + 5,
+                          _query(1000 + 2 * PER_SECTOR, UINT32_MAX, &res));
+    TEST_ASSERT(res.ordered && res.valid);
+
+    TEST_ASSERT_EQUAL_INT(0, _query(0, 999, &res));
+    TEST_ASSERT_EQUAL_INT(0, _query(2000, 3000, &res));
+}
+
+static void _append_same(uint32_t ts, unsigned count)
+{
+    uint32_t value = ~ts;
+
+    for (unsigned i = 0; i < count; i++) {
+        TEST_ASSERT_EQUAL_INT(0, tslog_append(&_log, ts, &value));
+    }
+}
+
+static void test_tslog_query_same_timestamp(void)
+{
+    _result_t res;
+
+    /* records with the same time stamp start in the middle of a sector and
+     * fill the next sectors */
+    _append_same(1, PER_SECTOR / 2);
+    _append_same(10, 2 * PER_SECTOR + PER_BATCH);
+    TEST_ASSERT_EQUAL_INT(0, tslog_flush(&_log));
+
+    TEST_ASSERT_EQUAL_INT(2 * PER_SECTOR + PER_BATCH, _query(10, 10, &res));
+    TEST_ASSERT(res.valid);
+    TEST_ASSERT_EQUAL_INT(2 * PER_SECTOR + PER_BATCH, _query(2, 10, &res));
+    TEST_ASSERT_EQUAL_INT(PER_SECTOR / 2, _query(1, 1, &res));
+    TEST_ASSERT_EQUAL_INT(0, _query(11, UINT32_MAX, &res));
+}
+
+static void test_tslog_recover(void)
+{
+    _result_t res;
+
+    _append(0, 2 * PER_SECTOR + PER_BATCH + 3);
+    TEST_ASSERT_EQUAL_INT(0, tslog_flush(&_log));
+
+    TEST_ASSERT_EQUAL_INT(0, tslog_init(&_log));
+    TEST_ASSERT_EQUAL_INT(2 * PER_SECTOR + PER_BATCH + 3,
+                          _query(0, UINT32_MAX, &res));
+    TEST_ASSERT(res.ordered && res.valid);
+
+    /* the newest time stamp is restored */
+    uint32_t value = 0;
+    TEST_ASSERT_EQUAL_INT(-EINVAL, tslog_append(&_log, 0, &value));
+
+    /* appending continues after the recovered records */
+    _append(2 * PER_SECTOR + PER_BATCH + 3, PER_BATCH);
+    TEST_ASSERT_EQUAL_INT(0, tslog_flush(&_log));
+    TEST_ASSERT_EQUAL_INT(0, tslog_init(&_log));
+    TEST_ASSERT_EQUAL_INT(2 * PER_SECTOR + 2 * PER_BATCH + 3,
+                          _query(0, UINT32_MAX, &res));
+    TEST_ASSERT(res.ordered && res.valid);
+}
+
+static void test_tslog_power_fail(void)
+{
+    _result_t res;
+
+    _append(0, PER_SECTOR + 2 * PER_BATCH);
+
+    /* the last batch was not written completely */
+    memset(&_dummy_memory[SECTOR_SIZE + 64 + 32], 0xff, 32);
+
+    TEST_ASSERT_EQUAL_INT(0, tslog_init(&_log));
+    TEST_ASSERT_EQUAL_INT(PER_SECTOR + PER_BATCH, _query(0, UINT32_MAX, &res));
+    TEST_ASSERT(res.ordered && res.valid);
+
+    /* the damaged slot is skipped */
+    _append(PER_SECTOR + 2 * PER_BATCH, PER_BATCH);
+    TEST_ASSERT_EQUAL_INT(PER_SECTOR + 2 * PER_BATCH,
+                          _query(0, UINT32_MAX, &res));
+    TEST_ASSERT_EQUAL_INT(0, tslog_init(&_log));
+    TEST_ASSERT_EQUAL_INT(PER_SECTOR + 2 * PER_BATCH,
+                          _query(0, UINT32_MAX, &res));
+    TEST_ASSERT(res.ordered && res.valid);
+}
+
+static void test_tslog_wrap(void)
+{
+    _result_t res;
+
+    /* two rounds over the device and one more batch */
+    _append(0, 2 * SECTOR_COUNT * PER_SECTOR + PER_BATCH);
+    TEST_ASSERT_EQUAL_INT(2 * SECTOR_COUNT + 1, _ram.erases);
+
+    /* the oldest sector was erased to make room for the last batch */
+    TEST_ASSERT_EQUAL_INT((SECTOR_COUNT - 1) * PER_SECTOR + PER_BATCH,
+                          _query(0, UINT32_MAX, &res));
+    TEST_ASSERT_EQUAL_INT((SECTOR_COUNT + 1) * PER_SECTOR, res.first);
+    TEST_ASSERT(res.ordered && res.valid);
+
+    TEST_ASSERT_EQUAL_INT(0, tslog_init(&_log));
+    TEST_ASSERT_EQUAL_INT((SECTOR_COUNT - 1) * PER_SECTOR + PER_BATCH,
+                          _query(0, UINT32_MAX, &res));
+    TEST_ASSERT_EQUAL_INT((SECTOR_COUNT + 1) * PER_SECTOR, res.first);
+    TEST_ASSERT(res.ordered && res.valid);
+}
+
+static void test_tslog_garbage(void)
+{
+    _result_t res;
+
+    memset(_dummy_memory, 0x5a, sizeof(_dummy_memory));
+    TEST_ASSERT_EQUAL_INT(0, tslog_init(&_log));
+    TEST_ASSERT_EQUAL_INT(0, _query(0, UINT32_MAX, &res));
+
+    _append(0, PER_BATCH);
+    TEST_ASSERT_EQUAL_INT(PER_BATCH, _query(0, UINT32_MAX, &res));
+    TEST_ASSERT(res.ordered && res.valid);
+
+    TEST_ASSERT_EQUAL_INT(0, tslog_format(&_log));
+    TEST_ASSERT_EQUAL_INT(0, _query(0, UINT32_MAX, &res));
+}
+
+Test *tests_tslog_tests(void)
+{
+    EMB_UNIT_TESTFIXTURES(fixtures) {
+        new_TestFixture(test_tslog_empty),
+        new_TestFixture(test_tslog_batching),
+        new_TestFixture(test_tslog_query_range),
+        new_TestFixture(test_tslog_query_same_timestamp),
+        new_TestFixture(test_tslog_recover),
+        new_TestFixture(test_tslog_power_fail),
+        new_TestFixture(test_tslog_wrap),
+        new_TestFixture(test_tslog_garbage),
+    };
+
+    EMB_UNIT_TESTCALLER(tslog_tests, setup, NULL, fixtures);
+
+    return (Test *)&tslog_tests;
+}
+
+int main(void)
+{
+    TESTS_START();
+    TESTS_RUN(tests_tslog_tests());
+    TESTS_END();
+    return 0;
+}
@@ -0,0 +1,391 @@
+/*
+ * Copyright (C) 2020 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup tests
+ * @{
+ *
+ * @file
+ */
+#include <stdint.h>
+
+#include "embUnit/embUnit.h"
+
+#include "net/gnrc/ipv6/hdr.h"
+#include "net/gnrc/netif/fq.h"
+#include "net/gnrc/netif/hdr.h"
+#include "net/gnrc/pktbuf.h"
+#include "net/icmpv6.h"
+#include "net/protnum.h"
+#include "test_utils/expect.h"
+#include "xtimer.h"
+
+#include "tests-gnrc_netif_fq.h"
+
+#define TEST_PAYLOAD_LEN    (100U)
+#define TEST_SRC            { { 0x20, 0x01, 0x0d, 0xb8, 0x00, 0x00, 0x00, 0x00, \
+                                0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01 } }
+#define TEST_DST            { { 0x20, 0x01, 0x0d, 0xb8, 0x00, 0x00, 0x00, 0x01, \
+                                0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 } }
+/* DSCP CS6 in the traffic class field, which RIOT orders as ECN and DSCP
+ * (see ipv6_hdr_get_tc_dscp()) */
+#define TEST_TC_CS6         (0x30)
+#define TEST_L2ADDR_LEN     (8U)
+/* IPHC with elided addresses, hop limit 64 and inline next header ICMPv6 */
+#define TEST_IPHC_ICMPV6    { 0x7a, 0x33, PROTNUM_ICMPV6 }
+/* IPHC with elided addresses, hop limit 64 and DSCP CS6, followed by a UDP
+ * NHC header */
+#define TEST_IPHC_CS6       { 0x76, 0x33, 0x30, 0xf0, 0x16, 0x33, 0x16, 0x33, \
+                              0x00, 0x00 }
+/* IPHC with elided addresses and hop limit 64, followed by a UDP NHC
+ * header */
+#define TEST_IPHC_UDP       { 0x7e, 0x33, 0xf0, 0x16, 0x33, 0x16, 0x33, \
+                              0x00, 0x00 }
+/* first and subsequent fragment of a datagram of 300 bytes with tag 0x1234,
+ * the first one carrying an ICMPv6 IPHC header */
+#define TEST_FRAG_1         { 0xc1, 0x2c, 0x12, 0x34, 0x7a, 0x33, PROTNUM_ICMPV6 }
+#define TEST_FRAG_N         { 0xe1, 0x2c, 0x12, 0x34, 0x0c }
+
+static gnrc_netif_fq_t _fq;
+static uint8_t _dst_bulk;
+static uint8_t _dst_other;
+
+/* type is the first byte of the payload, i.e. the ICMPv6 type for nh
+ * PROTNUM_ICMPV6 */
+static gnrc_pktsnip_t *_build_pkt(uint8_t dst_byte, uint8_t nh, uint8_t tc,
+                                  uint8_t type)
+{
+    uint8_t payload[TEST_PAYLOAD_LEN] = { type };
+    ipv6_addr_t src = TEST_SRC;
+    ipv6_addr_t dst = TEST_DST;
+    gnrc_pktsnip_t *pkt;
+
+    dst.u8[sizeof(dst) - 1] = dst_byte;
+    pkt = gnrc_pktbuf_add(NULL, payload, sizeof(payload), GNRC_NETTYPE_UNDEF);
+    expect(pkt != NULL);
+    pkt = gnrc_ipv6_hdr_build(pkt, &src, &dst);
+    expect(pkt != NULL);
+    ((ipv6_hdr_t *)pkt->data)->nh = nh;
+    ipv6_hdr_set_tc(pkt->data, tc);
+    return pkt;
+}
+
+static gnrc_pktsnip_t *_build_bulk(void)
+{
+    return _build_pkt(_dst_bulk, PROTNUM_UDP, 0, 0);
+}
+
+static gnrc_pktsnip_t *_build_other(void)
+{
+    return _build_pkt(_dst_other, PROTNUM_UDP, 0, 0);
+}
+
+static gnrc_pktsnip_t *_build_ctrl(void)
+{
+    return _build_pkt(_dst_bulk, PROTNUM_ICMPV6, 0, ICMPV6_NBR_SOL);
+}
+
+static gnrc_pktsnip_t *_build_echo(void)
+{
+    return _build_pkt(_dst_bulk, PROTNUM_ICMPV6, 0, ICMPV6_ECHO_REQ);
+}
+
+/* Builds a frame as handed to a 6LoWPAN interface, i.e. after IPHC, type is
+ * the first byte of the payload */
+static gnrc_pktsnip_t *_build_sixlowpan(const uint8_t *hdr, size_t hdr_len,
+                                        uint8_t l2_dst_byte, uint8_t type)
+{
+    uint8_t payload[TEST_PAYLOAD_LEN] = { type };
+    uint8_t l2_dst[TEST_L2ADDR_LEN] = { 0 };
+    gnrc_pktsnip_t *pkt, *netif;
+
+    l2_dst[TEST_L2ADDR_LEN - 1] = l2_dst_byte;
+    pkt = gnrc_pktbuf_add(NULL, payload, sizeof(payload), GNRC_NETTYPE_UNDEF);
+    expect(pkt != NULL);
+    pkt = gnrc_pktbuf_add(pkt, hdr, hdr_len, GNRC_NETTYPE_SIXLOWPAN);
+    expect(pkt != NULL);
+    netif = gnrc_netif_hdr_build(NULL, 0, l2_dst, sizeof(l2_dst));
+    expect(netif != NULL);
+    netif->next = pkt;
+    return netif;
+}
+
+static gnrc_pktsnip_t *_build_sixlowpan_udp(uint8_t l2_dst_byte)
+{
+    static const uint8_t iphc[] = TEST_IPHC_UDP;
+
+    return _build_sixlowpan(iphc, sizeof(iphc), l2_dst_byte, 0);
+}
+
+static gnrc_pktsnip_t *_build_sixlowpan_ctrl(void)
+{
+    static const uint8_t iphc[] = TEST_IPHC_ICMPV6;
+
+    return _build_sixlowpan(iphc, sizeof(iphc), 1, ICMPV6_RPL_CTRL);
+}
+
+static void set_up(void)
+{
+    gnrc_pktsnip_t *bulk, *other;
+
+    gnrc_pktbuf_init();
+    gnrc_netif_fq_init(&_fq);
+    /* find two destinations that are assigned to different flows */
+    _dst_bulk = 1;
+    bulk = _build_bulk();
+    for (_dst_other = 2; _dst_other < UINT8_MAX; _dst_other++) {
+        other = _build_other();
+        if (gnrc_netif_fq_classify(other) != gnrc_netif_fq_classify(bulk)) {
+            gnrc_pktbuf_release(other);
+            break;
+        }
+        gnrc_pktbuf_release(other);
+    }
+    gnrc_pktbuf_release(bulk);
+}
+
+static void tear_down(void)
+{
+    gnrc_netif_fq_flush(&_fq);
+    TEST_ASSERT(gnrc_pktbuf_is_empty());
+}
+
+static void test_fq_classify(void)
+{
+    gnrc_pktsnip_t *pkt;
+
+    pkt = _build_ctrl();
+    TEST_ASSERT_EQUAL_INT(GNRC_NETIF_FQ_FLOW_CTRL,
+                          gnrc_netif_fq_classify(pkt));
+    gnrc_pktbuf_release(pkt);
+    pkt = _build_pkt(_dst_bulk, PROTNUM_UDP, TEST_TC_CS6, 0);
+    TEST_ASSERT_EQUAL_INT(GNRC_NETIF_FQ_FLOW_CTRL,
+                          gnrc_netif_fq_classify(pkt));
+    gnrc_pktbuf_release(pkt);
+    /* other ICMPv6 messages are fair-queued */
+    pkt = _build_echo();
+    TEST_ASSERT(gnrc_netif_fq_classify(pkt) != GNRC_NETIF_FQ_FLOW_CTRL);
+    TEST_ASSERT(gnrc_netif_fq_classify(pkt) < CONFIG_GNRC_NETIF_FQ_FLOWS_NUMOF);
+    gnrc_pktbuf_release(pkt);
+    pkt = _build_bulk();
+    TEST_ASSERT(gnrc_netif_fq_classify(pkt) != GNRC_NETIF_FQ_FLOW_CTRL);
+    TEST_ASSERT(gnrc_netif_fq_classify(pkt) < CONFIG_GNRC_NETIF_FQ_FLOWS_NUMOF);
+    gnrc_pktbuf_release(pkt);
+    pkt = gnrc_pktbuf_add(NULL, NULL, TEST_PAYLOAD_LEN, GNRC_NETTYPE_UNDEF);
+    TEST_ASSERT_NOT_NULL(pkt);
+    TEST_ASSERT(gnrc_netif_fq_classify(pkt) != GNRC_NETIF_FQ_FLOW_CTRL);
+    gnrc_pktbuf_release(pkt);
+}
+
+static void test_fq_classify__sixlowpan(void)
+{
+    static const uint8_t icmpv6[] = TEST_IPHC_ICMPV6;
+    static const uint8_t cs6[] = TEST_IPHC_CS6;
+    static const uint8_t frag_1[] = TEST_FRAG_1;
+    static const uint8_t frag_n[] = TEST_FRAG_N;
+    gnrc_pktsnip_t *pkt, *other = NULL;
+    unsigned flow;
+
+    pkt = _build_sixlowpan_ctrl();
+    TEST_ASSERT_EQUAL_INT(GNRC_NETIF_FQ_FLOW_CTRL,
+                          gnrc_netif_fq_classify(pkt));
+    gnrc_pktbuf_release(pkt);
+    pkt = _build_sixlowpan(icmpv6, sizeof(icmpv6), 1, ICMPV6_ECHO_REQ);
+    TEST_ASSERT(gnrc_netif_fq_classify(pkt) != GNRC_NETIF_FQ_FLOW_CTRL);
+    gnrc_pktbuf_release(pkt);
+    pkt = _build_sixlowpan(cs6, sizeof(cs6), 1, 0);
+    TEST_ASSERT_EQUAL_INT(GNRC_NETIF_FQ_FLOW_CTRL,
+                          gnrc_netif_fq_classify(pkt));
+    gnrc_pktbuf_release(pkt);
+    pkt = _build_sixlowpan_udp(1);
+    flow = gnrc_netif_fq_classify(pkt);
+    TEST_ASSERT(flow != GNRC_NETIF_FQ_FLOW_CTRL);
+    TEST_ASSERT(flow < CONFIG_GNRC_NETIF_FQ_FLOWS_NUMOF);
+    gnrc_pktbuf_release(pkt);
+    /* elided addresses are told apart by link-layer destination */
+    for (unsigned l2_dst = 2; l2_dst < UINT8_MAX; l2_dst++) {
+        pkt = _build_sixlowpan_udp(l2_dst);
+        if (gnrc_netif_fq_classify(pkt) != flow) {
+            other = pkt;
+            break;
+        }
+        gnrc_pktbuf_release(pkt);
+    }
+    TEST_ASSERT_NOT_NULL(other);
+    TEST_ASSERT(gnrc_netif_fq_classify(other) != GNRC_NETIF_FQ_FLOW_CTRL);
+    gnrc_pktbuf_release(other);
+    /* fragments of a datagram share a flow */
+    pkt = _build_sixlowpan(frag_1, sizeof(frag_1), 1, 0);
+    flow = gnrc_netif_fq_classify(pkt);
+    gnrc_pktbuf_release(pkt);
+    pkt = _build_sixlowpan(frag_n, sizeof(frag_n), 1, 0);
+    TEST_ASSERT_EQUAL_INT(flow, gnrc_netif_fq_classify(pkt));
+    TEST_ASSERT(flow != GNRC_NETIF_FQ_FLOW_CTRL);
+    gnrc_pktbuf_release(pkt);
+}
+
+static void test_fq_dequeue__empty(void)
+{
+    TEST_ASSERT(gnrc_netif_fq_empty(&_fq));
+    TEST_ASSERT_NULL(gnrc_netif_fq_dequeue(&_fq));
+}
+
+static void test_fq_dequeue__fifo_per_flow(void)
+{
+    gnrc_pktsnip_t *pkts[CONFIG_GNRC_NETIF_FQ_SIZE];
+
+    for (unsigned i = 0; i < CONFIG_GNRC_NETIF_FQ_SIZE; i++) {
+        pkts[i] = _build_bulk();
+        gnrc_netif_fq_enqueue(&_fq, pkts[i]);
+    }
+    for (unsigned i = 0; i < CONFIG_GNRC_NETIF_FQ_SIZE; i++) {
+        gnrc_pktsnip_t *pkt = gnrc_netif_fq_dequeue(&_fq);
+
+        TEST_ASSERT(pkt == pkts[i]);
+        gnrc_pktbuf_release(pkt);
+    }
+    TEST_ASSERT(gnrc_netif_fq_empty(&_fq));
+    TEST_ASSERT_EQUAL_INT(CONFIG_GNRC_NETIF_FQ_SIZE, _fq.stats.enqueued);
+    TEST_ASSERT_EQUAL_INT(0, _fq.stats.dropped);
+}
+
+/* a bulk flow that fills the queue must not delay other flows for more than
+ * one round */
+static void test_fq_dequeue__no_head_of_line_blocking(void)
+{
+    gnrc_pktsnip_t *ctrl, *other;
+    unsigned pos_ctrl = 0, pos_other = 0;
+
+    for (unsigned i = 0; i < (CONFIG_GNRC_NETIF_FQ_SIZE - 2); i++) {
+        gnrc_netif_fq_enqueue(&_fq, _build_bulk());
+    }
+    other = _build_other();
+    gnrc_netif_fq_enqueue(&_fq, other);
+    ctrl = _build_ctrl();
+    gnrc_netif_fq_enqueue(&_fq, ctrl);
+    for (unsigned i = 1; !gnrc_netif_fq_empty(&_fq); i++) {
+        gnrc_pktsnip_t *pkt = gnrc_netif_fq_dequeue(&_fq);
+
+        if (pkt == ctrl) {
+            pos_ctrl = i;
+        }
+        else if (pkt == other) {
+            pos_other = i;
+        }
+        gnrc_pktbuf_release(pkt);
+    }
+    TEST_ASSERT_EQUAL_INT(1, pos_ctrl);
+    TEST_ASSERT(pos_other > 0);
+    TEST_ASSERT(pos_other <= 3);
+}
+
+/* an echo request flood must not starve other flows */
+static void test_fq_dequeue__echo_flood(void)
+{
+    gnrc_pktsnip_t *echo, *other = NULL;
+    unsigned flow, pos_other = 0;
+
+    echo = _build_echo();
+    flow = gnrc_netif_fq_classify(echo);
+    gnrc_netif_fq_enqueue(&_fq, echo);
+    for (unsigned i = 1; i < (CONFIG_GNRC_NETIF_FQ_SIZE - 1); i++) {
+        gnrc_netif_fq_enqueue(&_fq, _build_echo());
+    }
+    /* find a destination that is assigned to another flow */
+    for (uint8_t dst = 2; dst < UINT8_MAX; dst++) {
+        other = _build_pkt(dst, PROTNUM_UDP, 0, 0);
+        if (gnrc_netif_fq_classify(other) != flow) {
+            break;
+        }
+        gnrc_pktbuf_release(other);
+        other = NULL;
+    }
+    TEST_ASSERT_NOT_NULL(other);
+    gnrc_netif_fq_enqueue(&_fq, other);
+    for (unsigned i = 1; !gnrc_netif_fq_empty(&_fq); i++) {
+        gnrc_pktsnip_t *pkt = gnrc_netif_fq_dequeue(&_fq);
+
+        if (pkt == other) {
+            pos_other = i;
+        }
+        gnrc_pktbuf_release(pkt);
+    }
+    TEST_ASSERT(pos_other > 0);
+    TEST_ASSERT(pos_other <= 3);
+}
+
+static void test_fq_dequeue__sixlowpan_ctrl_first(void)
+{
+    gnrc_pktsnip_t *ctrl, *pkt;
+
+    for (unsigned i = 0; i < (CONFIG_GNRC_NETIF_FQ_SIZE - 1); i++) {
+        gnrc_netif_fq_enqueue(&_fq, _build_sixlowpan_udp(1));
+    }
+    ctrl = _build_sixlowpan_ctrl();
+    gnrc_netif_fq_enqueue(&_fq, ctrl);
+    pkt = gnrc_netif_fq_dequeue(&_fq);
+    TEST_ASSERT(pkt == ctrl);
+    gnrc_pktbuf_release(pkt);
+}
+
+static void test_fq_enqueue__full(void)
+{
+    gnrc_pktsnip_t *first = NULL, *other;
+    bool other_found = false;
+
+    for (unsigned i = 0; i < CONFIG_GNRC_NETIF_FQ_SIZE; i++) {
+        gnrc_pktsnip_t *pkt = _build_bulk();
+
+        if (first == NULL) {
+            first = pkt;
+        }
+        gnrc_netif_fq_enqueue(&_fq, pkt);
+    }
+    /* take a reference so we can check if the oldest packet was dropped */
+    gnrc_pktbuf_hold(first, 1);
+    other = _build_other();
+    gnrc_netif_fq_enqueue(&_fq, other);
+    TEST_ASSERT_EQUAL_INT(1, _fq.stats.dropped);
+    TEST_ASSERT_EQUAL_INT(CONFIG_GNRC_NETIF_FQ_SIZE, _fq.len);
+    while (!gnrc_netif_fq_empty(&_fq)) {
+        gnrc_pktsnip_t *pkt = gnrc_netif_fq_dequeue(&_fq);
+
+        TEST_ASSERT(pkt != first);
+        if (pkt == other) {
+            other_found = true;
+        }
+        gnrc_pktbuf_release(pkt);
+    }
+    TEST_ASSERT(other_found);
+    gnrc_pktbuf_release(first);
+}
+
+static Test *tests_gnrc_netif_fq_tests(void)
+{
+    EMB_UNIT_TESTFIXTURES(fixtures) {
+        new_TestFixture(test_fq_classify),
+        new_TestFixture(test_fq_classify__sixlowpan),
+        new_TestFixture(test_fq_dequeue__empty),
+        new_TestFixture(test_fq_dequeue__fifo_per_flow),
+        new_TestFixture(test_fq_dequeue__no_head_of_line_blocking),
+        new_TestFixture(test_fq_dequeue__echo_flood),
+        new_TestFixture(test_fq_dequeue__sixlowpan_ctrl_first),
+        new_TestFixture(test_fq_enqueue__full),
+    };
+
+    EMB_UNIT_TESTCALLER(fq_tests, set_up, tear_down, fixtures);
+
+    return (Test *)&fq_tests;
+}
+
+void tests_gnrc_netif_fq(void)
+{
+    xtimer_init();
+    TESTS_RUN(tests_gnrc_netif_fq_tests());
+}
+/** @} */
@@ -28,6 +28,7 @@
 #include <stdlib.h>
 
 #include "embUnit/embUnit.h"
+#include "kernel_defines.h"
 
 #include "hashes/sha256.h"
 
@@ -266,6 +267,61 @@ static void test_hashes_sha256_hash_sequence_abc_long(void)
     TEST_ASSERT(calc_and_compare_hash_wrapper(teststring, h_fips_multiblock));
 }
 
+static void test_hashes_sha256_update_multi(void)
+{
+    static const char *teststrings[] = {
+        "1234567890_1",
+        "0123456789abcde-0123456789abcde-0123456789abcde-0123456789abcde-",
+        "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq",
+        "Franz jagt im komplett verwahrlosten Taxi quer durch Bayern",
+        "",
+    };
+    static const unsigned char *expected[] = {
+        h01, hdigits_letters, h_fips_multiblock, hpangramm, hempty,
+    };
+    static unsigned char block[150];
+    static unsigned char hash[SHA256_DIGEST_LENGTH];
+    static unsigned char expected_long[SHA256_DIGEST_LENGTH];
+    sha256_context_t sha256[ARRAY_SIZE(teststrings)];
+    sha256_context_t *ctx[ARRAY_SIZE(teststrings)];
+    const void *data[ARRAY_SIZE(teststrings)];
+
+    /* messages of different length, one at a time */
+    for (unsigned i = 0; i < ARRAY_SIZE(teststrings); i++) {
+        ctx[i] = &sha256[i];
+        sha256_init(ctx[i]);
+        sha256_update_multi(&ctx[i], (const void **)&teststrings[i],
+                            strlen(teststrings[i]), 1);
+        sha256_final(ctx[i], hash);
+        TEST_ASSERT_EQUAL_INT(0, memcmp(expected[i], hash, sizeof(hash)));
+    }
+
+    /* more messages than lanes, fed in chunks that are not a multiple of
+     * the block size, with two contexts at a different offset than the
+     * others, so lanes run both in lock-step and one by one */
+    memset(block, 'a', sizeof(block));
+    sha256_init(&sha256[0]);
+    for (unsigned i = 0; i < 3; i++) {
+        sha256_update(&sha256[0], block, sizeof(block));
+    }
+    sha256_final(&sha256[0], expected_long);
+
+    for (unsigned i = 0; i < ARRAY_SIZE(teststrings); i++) {
+        sha256_init(ctx[i]);
+        data[i] = block;
+    }
+    sha256_update(ctx[0], block, 7);
+    sha256_update(ctx[1], block, 7);
+    sha256_update_multi(ctx, data, sizeof(block), ARRAY_SIZE(teststrings));
+    sha256_update_multi(ctx, data, sizeof(block), ARRAY_SIZE(teststrings));
+    sha256_update_multi(ctx, data, sizeof(block) - 7, ARRAY_SIZE(teststrings));
+    sha256_update_multi(&ctx[2], data, 7, ARRAY_SIZE(teststrings) - 2);
+    for (unsigned i = 0; i < ARRAY_SIZE(teststrings); i++) {
+        sha256_final(ctx[i], hash);
+        TEST_ASSERT_EQUAL_INT(0, memcmp(expected_long, hash, sizeof(hash)));
+    }
+}
+
 Test *tests_hashes_sha256_tests(void)
 {
     EMB_UNIT_TESTFIXTURES(fixtures) {
@@ -284,6 +340,7 @@ Test *tests_hashes_sha256_tests(void)
 
         new_TestFixture(test_hashes_sha256_hash_sequence_abc),
         new_TestFixture(test_hashes_sha256_hash_sequence_abc_long),
+        new_TestFixture(test_hashes_sha256_update_multi),
     };
 
     EMB_UNIT_TESTCALLER(hashes_sha256_tests, NULL, NULL,
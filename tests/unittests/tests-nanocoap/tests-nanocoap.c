@@ -12,6 +12,7 @@
  * @file
  */
 #include <errno.h>
+#include <inttypes.h>
 #include <stdint.h>
 #include <stdbool.h>
 #include <string.h>
@@ -23,6 +24,7 @@
 
 #include "unittests-constants.h"
 #include "tests-nanocoap.h"
+#include "xtimer.h"
 
 
 #define _BUF_SIZE (128U)
@@ -836,6 +838,169 @@ static void test_nanocoap__token_length_over_limit(void)
     TEST_ASSERT_EQUAL_INT(-EBADMSG, res);
 }
 
+/*
+ * Helper for option index tests below.
+ * GET request for /sensors/temp?a=1&b=2 with Observe, Accept, Block2 and
+ * Size1, an option number above 31.
+ */
+static int _build_index_req(uint8_t *buf, size_t len)
+{
+    coap_pkt_t pkt;
+    coap_block1_t block = { .blknum = 3, .szx = 2 };
+
+    size_t hdr_len = coap_build_hdr((coap_hdr_t *)buf, COAP_TYPE_CON, NULL, 0,
+                                    COAP_METHOD_GET, 0x1234);
+    coap_pkt_init(&pkt, buf, len, hdr_len);
+
+    coap_opt_add_uint(&pkt, COAP_OPT_OBSERVE, 0);
+    coap_opt_add_string(&pkt, COAP_OPT_URI_PATH, "/sensors/temp", '/');
+    coap_opt_add_uri_query(&pkt, "a", "1");
+    coap_opt_add_uri_query(&pkt, "b", "2");
+    coap_opt_add_uint(&pkt, COAP_OPT_ACCEPT, COAP_FORMAT_JSON);
+    coap_opt_add_block2_control(&pkt, &block);
+    coap_opt_add_uint(&pkt, COAP_OPT_SIZE1, 1000);
+
+    return coap_opt_finish(&pkt, COAP_OPT_FINISH_NONE);
+}
+
+/*
+ * Verifies the option index built by coap_parse(): an entry per option number
+ * and lookup of present and absent options below and above 32.
+ */
+static void test_nanocoap__option_index(void)
+{
+    uint8_t buf[_BUF_SIZE];
+    coap_pkt_t pkt;
+    uint32_t value;
+    char query[32];
+    coap_block1_t block;
+
+    int len = _build_index_req(buf, sizeof(buf));
+    TEST_ASSERT_EQUAL_INT(0, coap_parse(&pkt, buf, len));
+    TEST_ASSERT_EQUAL_INT(6, pkt.options_len);
+
+    TEST_ASSERT_EQUAL_INT(0, coap_opt_get_uint(&pkt, COAP_OPT_OBSERVE, &value));
+    TEST_ASSERT_EQUAL_INT(0, value);
+    TEST_ASSERT_EQUAL_INT(0, coap_opt_get_uint(&pkt, COAP_OPT_ACCEPT, &value));
+    TEST_ASSERT_EQUAL_INT(COAP_FORMAT_JSON, value);
+    TEST_ASSERT_EQUAL_INT(0, coap_opt_get_uint(&pkt, COAP_OPT_SIZE1, &value));
+    TEST_ASSERT_EQUAL_INT(1000, value);
+    TEST_ASSERT_EQUAL_INT(1, coap_get_block2(&pkt, &block));
+    TEST_ASSERT_EQUAL_INT(3, block.blknum);
+    TEST_ASSERT_EQUAL_INT(2, block.szx);
+
+    TEST_ASSERT_EQUAL_INT(-ENOENT, coap_opt_get_uint(&pkt,
+                                                     COAP_OPT_CONTENT_FORMAT,
+                                                     &value));
+    TEST_ASSERT_EQUAL_INT(-ENOENT, coap_opt_get_uint(&pkt, COAP_OPT_PROXY_URI,
+                                                     &value));
+    TEST_ASSERT_EQUAL_INT(0, coap_get_block1(&pkt, &block));
+
+    /* repeated options are read from the first one */
+    TEST_ASSERT_EQUAL_INT(sizeof("&a=1&b=2"),
+                          coap_opt_get_string(&pkt, COAP_OPT_URI_QUERY,
+                                              (uint8_t *)query, sizeof(query),
+                                              '&'));
+    TEST_ASSERT_EQUAL_STRING("&a=1&b=2", query);
+}
+
+/*
+ * Verifies that coap_match_path_pkt() sorts like coap_match_path() on the
+ * string of coap_get_uri_path().
+ */
+static void test_nanocoap__match_path_pkt(void)
+{
+    static const char *paths[] = {
+        "/", "/sensors", "/sensors/", "/sensors/temp", "/sensors/temp/x",
+        "/sensors/tem", "/sensors/tempx", "/sensors/hum", "/time",
+    };
+    static const coap_method_flags_t methods[] = {
+        COAP_GET, COAP_GET | COAP_MATCH_SUBTREE,
+    };
+    uint8_t buf[_BUF_SIZE];
+    uint8_t uri[CONFIG_NANOCOAP_URI_MAX];
+    coap_pkt_t pkt;
+
+    for (unsigned i = 0; i < ARRAY_SIZE(paths); i++) {
+        size_t hdr_len = coap_build_hdr((coap_hdr_t *)buf, COAP_TYPE_NON, NULL,
+                                        0, COAP_METHOD_GET, i);
+        coap_pkt_init(&pkt, buf, sizeof(buf), hdr_len);
+        if (strcmp(paths[i], "/") != 0) {
+            coap_opt_add_string(&pkt, COAP_OPT_URI_PATH, paths[i], '/');
+        }
+        coap_parse(&pkt, buf, coap_opt_finish(&pkt, COAP_OPT_FINISH_NONE));
+        coap_get_uri_path(&pkt, uri);
+
+        for (unsigned j = 0; j < ARRAY_SIZE(paths); j++) {
+            for (unsigned k = 0; k < ARRAY_SIZE(methods); k++) {
+                coap_resource_t resource = { paths[j], methods[k], NULL, NULL };
+                int exp = coap_match_path(&resource, uri);
+                int res = coap_match_path_pkt(&resource, &pkt);
+                TEST_ASSERT((exp < 0) == (res < 0));
+                TEST_ASSERT((exp > 0) == (res > 0));
+            }
+        }
+    }
+}
+
+static ssize_t _dispatch_handler(coap_pkt_t *pkt, uint8_t *buf, size_t len,
+                                 void *context)
+{
+    uint8_t query[CONFIG_NANOCOAP_URI_MAX];
+    uint32_t accept, observe;
+    coap_block1_t block;
+
+    /* a typical handler reads a few options */
+    coap_get_uri_query(pkt, query);
+    coap_opt_get_uint(pkt, COAP_OPT_ACCEPT, &accept);
+    coap_opt_get_uint(pkt, COAP_OPT_OBSERVE, &observe);
+    coap_get_block2(pkt, &block);
+    (*(unsigned *)context)++;
+    return coap_reply_simple(pkt, COAP_CODE_CONTENT, buf, len,
+                             COAP_FORMAT_TEXT, (uint8_t *)"20", 2);
+}
+
+/*
+ * Measures parsing a request and dispatching it to a handler that reads a
+ * few options.
+ */
+static void test_nanocoap__parse_dispatch(void)
+{
+    const unsigned runs = 1000;
+    unsigned temp = 0, other = 0;
+    const coap_resource_t resources[] = {
+        { "/actuators/led", COAP_PUT, _dispatch_handler, &other },
+        { "/config", COAP_GET, _dispatch_handler, &other },
+        { "/riot/board", COAP_GET, _dispatch_handler, &other },
+        { "/riot/value", COAP_GET, _dispatch_handler, &other },
+        { "/sensors/hum", COAP_GET, _dispatch_handler, &other },
+        { "/sensors/temp", COAP_GET, _dispatch_handler, &temp },
+        { "/time", COAP_GET, _dispatch_handler, &other },
+    };
+    uint8_t req[_BUF_SIZE];
+    uint8_t buf[_BUF_SIZE];
+    uint8_t resp[_BUF_SIZE];
+    coap_pkt_t pkt;
+    ssize_t res = 0;
+
+    int len = _build_index_req(req, sizeof(req));
+
+    uint32_t time = xtimer_now_usec();
+    for (unsigned i = 0; i < runs; i++) {
+        memcpy(buf, req, len);
+        coap_parse(&pkt, buf, len);
+        res = coap_tree_handler(&pkt, resp, sizeof(resp), resources,
+                                ARRAY_SIZE(resources));
+    }
+    time = xtimer_now_usec() - time;
+    printf("\nnanocoap: parse and dispatch: %" PRIu32 " ns per request\n",
+           (uint32_t)((uint64_t)time * 1000 / runs));
+
+    TEST_ASSERT(res > 0);
+    TEST_ASSERT_EQUAL_INT(runs, temp);
+    TEST_ASSERT_EQUAL_INT(0, other);
+}
+
 Test *tests_nanocoap_tests(void)
 {
     EMB_UNIT_TESTFIXTURES(fixtures) {
@@ -863,6 +1028,9 @@ Test *tests_nanocoap_tests(void)
         new_TestFixture(test_nanocoap__add_path_unterminated_string),
         new_TestFixture(test_nanocoap__add_get_proxy_uri),
         new_TestFixture(test_nanocoap__token_length_over_limit),
+        new_TestFixture(test_nanocoap__option_index),
+        new_TestFixture(test_nanocoap__match_path_pkt),
+        new_TestFixture(test_nanocoap__parse_dispatch),
     };
 
     EMB_UNIT_TESTCALLER(nanocoap_tests, NULL, NULL, fixtures);
@@ -23,6 +23,7 @@
 
 #include "embUnit/embUnit.h"
 
+#include "kernel_defines.h"
 #include "vfs.h"
 
 #include "tests-vfs.h"
@@ -98,6 +99,51 @@ static void test_vfs_bind(void)
     TEST_ASSERT_EQUAL_INT(0, res);
 }
 
+static void test_vfs_bind__readv_writev(void)
+{
+    uint8_t buf[_VFS_TEST_BIND_BUFSIZE];
+    char strbuf[2 * _VFS_TEST_BIND_BUFSIZE];
+    int fd = vfs_bind(VFS_ANY_FD, O_RDWR, &_test_bind_ops, &buf[0]);
+    TEST_ASSERT(fd >= 0);
+    if (fd < 0) {
+        return;
+    }
+
+    /* the driver has no writev, every buffer is written on its own */
+    struct iovec iov[] = {
+        { .iov_base = (void *)&str_data[0], .iov_len = 4 },
+        { .iov_base = NULL, .iov_len = 0 },
+        { .iov_base = (void *)&str_data[4], .iov_len = 4 },
+    };
+    int ncalls = _mock_write_calls;
+    ssize_t nbytes = vfs_writev(fd, iov, ARRAY_SIZE(iov));
+    TEST_ASSERT_EQUAL_INT(ncalls + 2, _mock_write_calls);
+    TEST_ASSERT_EQUAL_INT(8, nbytes);
+    /* the mock file starts over on every call */
+    TEST_ASSERT_EQUAL_INT(0, memcmp(&str_data[4], &buf[0], 4));
+
+    /* a short read ends the transfer */
+    memset(buf, 'x', sizeof(buf));
+    memset(strbuf, 0, sizeof(strbuf));
+    iov[0] = (struct iovec){ .iov_base = strbuf, .iov_len = 2 };
+    iov[1] = (struct iovec){ .iov_base = NULL, .iov_len = 0 };
+    iov[2] = (struct iovec){ .iov_base = &strbuf[2],
+                             .iov_len = sizeof(strbuf) - 2 };
+    ncalls = _mock_read_calls;
+    nbytes = vfs_readv(fd, iov, ARRAY_SIZE(iov));
+    TEST_ASSERT_EQUAL_INT(ncalls + 2, _mock_read_calls);
+    TEST_ASSERT_EQUAL_INT(2 + _VFS_TEST_BIND_BUFSIZE, nbytes);
+    TEST_ASSERT_EQUAL_INT('x', strbuf[2 + _VFS_TEST_BIND_BUFSIZE - 1]);
+    TEST_ASSERT_EQUAL_INT(0, strbuf[2 + _VFS_TEST_BIND_BUFSIZE]);
+
+    TEST_ASSERT_EQUAL_INT(-EINVAL, vfs_writev(fd, iov, -1));
+    TEST_ASSERT_EQUAL_INT(-EFAULT, vfs_readv(fd, NULL, 1));
+    TEST_ASSERT_EQUAL_INT(0, vfs_readv(fd, iov, 0));
+
+    int res = vfs_close(fd);
+    TEST_ASSERT_EQUAL_INT(0, res);
+}
+
 static void test_vfs_bind__leak_fds(void)
 {
     /* This test was added after a bug was discovered in the _allocate_fd code to
@@ -128,6 +174,7 @@ Test *tests_vfs_bind_tests(void)
 {
     EMB_UNIT_TESTFIXTURES(fixtures) {
         new_TestFixture(test_vfs_bind),
+        new_TestFixture(test_vfs_bind__readv_writev),
         new_TestFixture(test_vfs_bind__leak_fds),
         new_TestFixture(test_vfs_bind__allocate_invalid_fd),
     };
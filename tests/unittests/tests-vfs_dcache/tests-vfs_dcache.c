@@ -0,0 +1,157 @@
+/*
+ * Copyright (C) 2020 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @{
+ *
+ * @file
+ * @brief       Unittests for the path lookup cache of the VFS
+ */
+#include <errno.h>
+#include <stdint.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+
+#include "embUnit/embUnit.h"
+
+#include "kernel_defines.h"
+#include "vfs.h"
+#include "fs/constfs.h"
+
+#include "tests-vfs_dcache.h"
+
+static const uint8_t bin_data[] = {
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+    0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F,
+};
+static const uint8_t str_data[] = "This is a test file";
+
+static const constfs_file_t _files[] = {
+    {
+        .path = "/test.txt",
+        .data = str_data,
+        .size = sizeof(str_data),
+    },
+    {
+        .path = "/data.bin",
+        .data = bin_data,
+        .size = sizeof(bin_data),
+    },
+};
+
+static const constfs_t fs_data = {
+    .files = _files,
+    .nfiles = ARRAY_SIZE(_files),
+};
+
+static const constfs_file_t _other_files[] = {
+    {
+        .path = "/test.txt",
+        .data = bin_data,
+        .size = sizeof(bin_data),
+    },
+};
+
+static const constfs_t other_fs_data = {
+    .files = _other_files,
+    .nfiles = ARRAY_SIZE(_other_files),
+};
+
+static vfs_mount_t _test_vfs_mount = {
+    .mount_point = "/test",
+    .fs = &constfs_file_system,
+    .private_data = (void *)&fs_data,
+};
+
+static vfs_mount_t _test_vfs_mount_other = {
+    .mount_point = "/test",
+    .fs = &constfs_file_system,
+    .private_data = (void *)&other_fs_data,
+};
+
+static void set_up(void)
+{
+    vfs_dcache_clear();
+}
+
+static void test_vfs_dcache__hit(void)
+{
+    vfs_dcache_stats_t before, after;
+    struct stat st;
+    int res;
+
+    res = vfs_mount(&_test_vfs_mount);
+    TEST_ASSERT_EQUAL_INT(0, res);
+
+    vfs_dcache_stats(&before);
+    int fd = vfs_open("/test/data.bin", O_RDONLY, 0);
+    TEST_ASSERT(fd >= 0);
+    res = vfs_close(fd);
+    TEST_ASSERT_EQUAL_INT(0, res);
+    res = vfs_stat("/test/data.bin", &st);
+    TEST_ASSERT_EQUAL_INT(0, res);
+    TEST_ASSERT_EQUAL_INT(sizeof(bin_data), st.st_size);
+    TEST_ASSERT_EQUAL_INT(1, st.st_ino);
+    vfs_dcache_stats(&after);
+    TEST_ASSERT_EQUAL_INT(before.misses + 1, after.misses);
+    TEST_ASSERT_EQUAL_INT(before.hits + 1, after.hits);
+
+    /* the cached handle may not be used for write access */
+    fd = vfs_open("/test/data.bin", O_RDWR, 0);
+    TEST_ASSERT(fd == -EROFS);
+
+    res = vfs_umount(&_test_vfs_mount);
+    TEST_ASSERT_EQUAL_INT(0, res);
+}
+
+static void test_vfs_dcache__remount(void)
+{
+    struct stat st;
+    int res;
+
+    res = vfs_mount(&_test_vfs_mount);
+    TEST_ASSERT_EQUAL_INT(0, res);
+    res = vfs_stat("/test/test.txt", &st);
+    TEST_ASSERT_EQUAL_INT(0, res);
+    TEST_ASSERT_EQUAL_INT(sizeof(str_data), st.st_size);
+    res = vfs_stat("/test/data.bin", &st);
+    TEST_ASSERT_EQUAL_INT(0, res);
+
+    /* a different file system mounted at the same place must not see the
+     * handles of the first one */
+    res = vfs_umount(&_test_vfs_mount);
+    TEST_ASSERT_EQUAL_INT(0, res);
+    res = vfs_mount(&_test_vfs_mount_other);
+    TEST_ASSERT_EQUAL_INT(0, res);
+    res = vfs_stat("/test/test.txt", &st);
+    TEST_ASSERT_EQUAL_INT(0, res);
+    TEST_ASSERT_EQUAL_INT(sizeof(bin_data), st.st_size);
+    res = vfs_stat("/test/data.bin", &st);
+    TEST_ASSERT_EQUAL_INT(-ENOENT, res);
+
+    res = vfs_umount(&_test_vfs_mount_other);
+    TEST_ASSERT_EQUAL_INT(0, res);
+}
+
+static Test *tests_vfs_dcache_tests(void)
+{
+    EMB_UNIT_TESTFIXTURES(fixtures) {
+        new_TestFixture(test_vfs_dcache__hit),
+        new_TestFixture(test_vfs_dcache__remount),
+    };
+
+    EMB_UNIT_TESTCALLER(vfs_dcache_tests, set_up, NULL, fixtures);
+
+    return (Test *)&vfs_dcache_tests;
+}
+
+void tests_vfs_dcache(void)
+{
+    TESTS_RUN(tests_vfs_dcache_tests());
+}
+/** @} */